@@ -18,6 +18,8 @@
 #include "Adafruit_BMP085.h"
 
 Adafruit_BMP085::Adafruit_BMP085() {
+  conversionTime = 0;
+  lastB5 = 0;
 }
 
 
@@ -69,9 +71,39 @@ int32_t Adafruit_BMP085::computeB5(int32_t UT) {
   return X1 + X2;
 }
 
-uint16_t Adafruit_BMP085::readRawTemperature(void) {
+uint8_t Adafruit_BMP085::startConversion(uint8_t ms) {
+  conversionStart = millis();
+  conversionTime = ms;
+  return ms;
+}
+
+uint8_t Adafruit_BMP085::startTemperature(void) {
   write8(BMP085_CONTROL, BMP085_READTEMPCMD);
-  delay(5);
+  return startConversion(5);
+}
+
+uint8_t Adafruit_BMP085::startPressure(void) {
+  static const uint8_t waitTime[4] = { 5, 8, 14, 26 };
+
+  write8(BMP085_CONTROL, BMP085_READPRESSURECMD + (oversampling << 6));
+  return startConversion(waitTime[oversampling]);
+}
+
+boolean Adafruit_BMP085::isReady(void) {
+  return (uint32_t)(millis() - conversionStart) >= conversionTime;
+}
+
+int16_t Adafruit_BMP085::getTemperature(void) {
+  lastB5 = computeB5(read16(BMP085_TEMPDATA));
+  return (lastB5+8) >> 4;
+}
+
+int32_t Adafruit_BMP085::getPressure(void) {
+  return computePressure(lastB5, readPressureResult());
+}
+
+uint16_t Adafruit_BMP085::readRawTemperature(void) {
+  delay(startTemperature());
 #if BMP085_DEBUG == 1
   Serial.print("Raw temp: "); Serial.println(read16(BMP085_TEMPDATA));
 #endif
@@ -79,18 +111,12 @@ uint16_t Adafruit_BMP085::readRawTemperature(void) {
 }
 
 uint32_t Adafruit_BMP085::readRawPressure(void) {
-  uint32_t raw;
-
-  write8(BMP085_CONTROL, BMP085_READPRESSURECMD + (oversampling << 6));
+  delay(startPressure());
+  return readPressureResult();
+}
 
-  if (oversampling == BMP085_ULTRALOWPOWER) 
-    delay(5);
-  else if (oversampling == BMP085_STANDARD) 
-    delay(8);
-  else if (oversampling == BMP085_HIGHRES) 
-    delay(14);
-  else 
-    delay(26);
+uint32_t Adafruit_BMP085::readPressureResult(void) {
+  uint32_t raw;
 
   raw = read16(BMP085_PRESSUREDATA);
 
@@ -114,8 +140,7 @@ uint32_t Adafruit_BMP085::readRawPressure(void) {
 
 
 int32_t Adafruit_BMP085::readPressure(void) {
-  int32_t UT, UP, B3, B5, B6, X1, X2, X3, p;
-  uint32_t B4, B7;
+  int32_t UT, UP;
 
   UT = readRawTemperature();
   UP = readRawPressure();
@@ -137,11 +162,14 @@ int32_t Adafruit_BMP085::readPressure(void) {
   oversampling = 0;
 #endif
 
-  B5 = computeB5(UT);
+  return computePressure(computeB5(UT), UP);
+}
+
+int32_t Adafruit_BMP085::computePressure(int32_t B5, int32_t UP) {
+  int32_t B3, B6, X1, X2, X3, p;
+  uint32_t B4, B7;
 
 #if BMP085_DEBUG == 1
-  Serial.print("X1 = "); Serial.println(X1);
-  Serial.print("X2 = "); Serial.println(X2);
   Serial.print("B5 = "); Serial.println(B5);
 #endif
 
@@ -195,8 +223,7 @@ int32_t Adafruit_BMP085::readPressure(void) {
 }
 
 int32_t Adafruit_BMP085::readSealevelPressure(float altitude_meters) {
-  float pressure = readPressure();
-  return (int32_t)(pressure / pow(1.0-altitude_meters/44330, 5.255));
+  return sealevel(readPressure(), altitude_meters * 100);
 }
 
 float Adafruit_BMP085::readTemperature(void) {
@@ -222,13 +249,61 @@ float Adafruit_BMP085::readTemperature(void) {
 }
 
 float Adafruit_BMP085::readAltitude(float sealevelPressure) {
-  float altitude;
+  return altitude(readPressure(), sealevelPressure) / 100.0;
+}
 
-  float pressure = readPressure();
+/*********************************************************************/
+
+// The barometric formula altitude = 44330 * (1 - (p/p0)^0.1903) without
+// pow(): a table of the altitude in 0.5m for pressure ratios p/p0 from
+// 0.25 to 1.25 in steps of 1/64, interpolated linearly. The error is
+// below 1m around sea level and about 3m at 10km.
+
+#define ALTITUDE_RATIO_MIN   4096  // 0.25 in 1/16384
+#define ALTITUDE_RATIO_MAX  20480  // 1.25 in 1/16384
+#define ALTITUDE_RATIO_STEP 256    // 1/64 in 1/16384
+
+static const int16_t altitudeTable[65] PROGMEM = {
+   20558,  19768,  19015,  18294,  17604,  16941,  16304,  15689,
+   15096,  14522,  13966,  13428,  12906,  12398,  11904,  11424,
+   10956,  10500,  10054,   9620,   9195,   8779,   8373,   7975,
+    7585,   7204,   6829,   6462,   6102,   5748,   5400,   5059,
+    4723,   4393,   4069,   3749,   3435,   3125,   2821,   2520,
+    2224,   1933,   1645,   1362,   1082,    806,    534,    265,
+       0,   -262,   -521,   -776,  -1029,  -1278,  -1525,  -1769,
+   -2010,  -2248,  -2484,  -2717,  -2947,  -3175,  -3401,  -3625,
+   -3846
+};
+
+static int32_t altitudeAt(uint8_t i) {
+  return (int16_t)pgm_read_word(&altitudeTable[i]) * 50L;  // in cm
+}
 
-  altitude = 44330 * (1.0 - pow(pressure /sealevelPressure,0.1903));
+int32_t Adafruit_BMP085::altitude(int32_t pressure, int32_t sealevelPressure) {
+  int32_t ratio, a0, a1;
+  uint8_t i;
+
+  // pressure ratio in 1/16384, a pressure below 131072 Pa fits in 32 bits
+  ratio = (pressure << 14) / sealevelPressure;
+  ratio = constrain(ratio, ALTITUDE_RATIO_MIN, ALTITUDE_RATIO_MAX - 1) - ALTITUDE_RATIO_MIN;
+  i = ratio / ALTITUDE_RATIO_STEP;
+  a0 = altitudeAt(i);
+  a1 = altitudeAt(i+1);
+  return a0 + (a1 - a0) * (ratio % ALTITUDE_RATIO_STEP) / ALTITUDE_RATIO_STEP;
+}
 
-  return altitude;
+int32_t Adafruit_BMP085::sealevel(int32_t pressure, int32_t altitude_cm) {
+  int32_t ratio, a0, a1;
+  uint8_t i = 0;
+
+  // the table falls with the ratio, find the step containing altitude_cm
+  altitude_cm = constrain(altitude_cm, altitudeAt(64) + 1, altitudeAt(0));
+  while (altitudeAt(i+1) >= altitude_cm) i++;
+  a0 = altitudeAt(i);
+  a1 = altitudeAt(i+1);
+  ratio = ALTITUDE_RATIO_MIN + i * ALTITUDE_RATIO_STEP +
+    (a0 - altitude_cm) * ALTITUDE_RATIO_STEP / (a0 - a1);
+  return (pressure << 14) / ratio;
 }
 
 
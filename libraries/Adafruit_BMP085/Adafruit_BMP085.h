@@ -62,14 +62,33 @@ class Adafruit_BMP085 {
   float readAltitude(float sealevelPressure = 101325); // std atmosphere
   uint16_t readRawTemperature(void);
   uint32_t readRawPressure(void);
+
+  // Split-phase reading: start a conversion, wait until isReady() (or
+  // sleep for the returned number of ms) and then get the result.
+  // getPressure() is compensated with the last getTemperature() result.
+  uint8_t startTemperature(void);
+  uint8_t startPressure(void);
+  boolean isReady(void);
+  int16_t getTemperature(void);  // in 0.1 *C
+  int32_t getPressure(void);     // in Pa
+
+  // integer barometric formula, altitude in cm and pressures in Pa
+  static int32_t altitude(int32_t pressure, int32_t sealevelPressure = 101325);
+  static int32_t sealevel(int32_t pressure, int32_t altitude_cm);
   
  private:
   int32_t computeB5(int32_t UT);
+  int32_t computePressure(int32_t B5, int32_t UP);
+  uint32_t readPressureResult(void);
+  uint8_t startConversion(uint8_t ms);
   uint8_t read8(uint8_t addr);
   uint16_t read16(uint8_t addr);
   void write8(uint8_t addr, uint8_t data);
 
   uint8_t oversampling;
+  uint8_t conversionTime;
+  uint32_t conversionStart;
+  int32_t lastB5;
 
   int16_t ac1, ac2, ac3, b1, b2, mb, mc, md;
   uint16_t ac4, ac5, ac6;
@@ -40,6 +40,17 @@ Adafruit_FONA::Adafruit_FONA(int8_t rst)
   mySerial = 0;
   httpsredirect = false;
   useragent = F("FONA");
+  httpkeep = false;
+  httpopen = false;
+  httpcontent = 0;
+
+  asynchead = 0;
+  asynccount = 0;
+  asyncactive = false;
+  asynclinelen = 0;
+  asyncrawactive = false;
+  urchandler = 0;
+  httpdone = 0;
 }
 
 uint8_t Adafruit_FONA::type(void) {
@@ -1068,6 +1079,10 @@ boolean Adafruit_FONA::enableGPSNMEA(uint8_t i) {
 boolean Adafruit_FONA::enableGPRS(boolean onoff) {
 
   if (onoff) {
+    // in session mode an open bearer is reused as it is
+    if (httpkeep && bearerOpen())
+      return true;
+
     // disconnect all sockets
     sendCheckReply(F("AT+CIPSHUT"), F("SHUT OK"), 5000);
 
@@ -1102,6 +1117,9 @@ boolean Adafruit_FONA::enableGPRS(boolean onoff) {
     if (! sendCheckReply(F("AT+SAPBR=1,1"), F("OK"), 10000))
       return false;
   } else {
+    // the HTTP context does not survive the bearer
+    httpopen = false;
+
     // disconnect all sockets
     if (! sendCheckReply(F("AT+CIPSHUT"), F("SHUT OK"), 5000))
       return false;
@@ -1518,7 +1536,7 @@ boolean Adafruit_FONA_3G::HTTP_GET_start(char *ipaddr, char *path, uint16_t port
 */
 
 void Adafruit_FONA::HTTP_GET_end(void) {
-  HTTP_term();
+  HTTP_done();
 }
 
 boolean Adafruit_FONA::HTTP_POST_start(char *url,
@@ -1528,9 +1546,8 @@ boolean Adafruit_FONA::HTTP_POST_start(char *url,
   if (! HTTP_setup(url))
     return false;
 
-  if (! HTTP_para(F("CONTENT"), contenttype)) {
+  if (! HTTP_content(contenttype))
     return false;
-  }
 
   // HTTP POST data
   if (! HTTP_data(postdatalen, 10000))
@@ -1554,6 +1571,48 @@ boolean Adafruit_FONA::HTTP_POST_start(char *url,
 }
 
 void Adafruit_FONA::HTTP_POST_end(void) {
+  HTTP_done();
+}
+
+boolean Adafruit_FONA::HTTP_POST_batch(char *url,
+              const __FlashStringHelper *contenttype,
+              const char * const *items, uint8_t count, char separator,
+              uint16_t *status, uint16_t *datalen) {
+  uint32_t size = 0;
+  for (uint8_t i = 0; i < count; i++)
+    size += strlen(items[i]) + 1;
+
+  if (! HTTP_setup(url))
+    return false;
+
+  if (! HTTP_content(contenttype))
+    return false;
+
+  // HTTP POST data, written item by item, no buffer for the whole body
+  if (! HTTP_data(size, 10000))
+    return false;
+  for (uint8_t i = 0; i < count; i++) {
+    mySerial->print(items[i]);
+    mySerial->write(separator);
+  }
+  if (! expectReply(F("OK")))
+    return false;
+
+  // HTTP POST
+  if (! HTTP_action(FONA_HTTP_POST, status, datalen))
+    return false;
+
+  return true;
+}
+
+void Adafruit_FONA::HTTP_session(boolean onoff) {
+  httpkeep = onoff;
+  if (!onoff)
+    HTTP_session_end();
+}
+
+void Adafruit_FONA::HTTP_session_end(void) {
+  httpopen = false;
   HTTP_term();
 }
 
@@ -1568,6 +1627,15 @@ void Adafruit_FONA::setHTTPSRedirect(boolean onoff) {
 /********* HTTP HELPERS ****************************************/
 
 boolean Adafruit_FONA::HTTP_setup(char *url) {
+  // An open session only needs the new URL
+  if (httpkeep && httpopen) {
+    if (HTTP_para(F("URL"), url))
+      return true;
+    // context got lost (modem reset, bearer dropped), set it up again
+  }
+  httpopen = false;
+  httpcontent = 0;
+
   // Handle any pending
   HTTP_term();
 
@@ -1590,9 +1658,308 @@ boolean Adafruit_FONA::HTTP_setup(char *url) {
       return false;
   }
 
+  httpopen = true;
+  return true;
+}
+
+boolean Adafruit_FONA::HTTP_content(const __FlashStringHelper *contenttype) {
+  if (httpopen && httpcontent == contenttype)
+    return true;
+  if (! HTTP_para(F("CONTENT"), contenttype)) {
+    httpcontent = 0;
+    return false;
+  }
+  httpcontent = contenttype;
+  return true;
+}
+
+// End of a request, the context stays open in session mode
+void Adafruit_FONA::HTTP_done(void) {
+  if (!httpkeep) {
+    httpopen = false;
+    HTTP_term();
+  }
+}
+
+boolean Adafruit_FONA::bearerOpen(void) {
+  uint16_t state;
+  // +SAPBR: <cid>,<status>,"<ip>", status 1 is connected
+  if (! sendParseReply(F("AT+SAPBR=2,1"), F("+SAPBR: "), &state, ',', 1))
+    return false;
+  return state == 1;
+}
+
+/********* NON-BLOCKING COMMANDS *******************************/
+
+// Lines the modem sends on its own, they may show up between a command
+// and its final result.
+static const char urc0[] PROGMEM = "RING";
+static const char urc1[] PROGMEM = "+CMTI:";
+static const char urc2[] PROGMEM = "+CLIP:";
+static const char urc3[] PROGMEM = "NO CARRIER";
+static const char urc4[] PROGMEM = "+CMT:";
+static const char urc5[] PROGMEM = "+CPIN:";
+static const char urc6[] PROGMEM = "Call Ready";
+static const char urc7[] PROGMEM = "SMS Ready";
+static const char urc8[] PROGMEM = "+PDP: DEACT";
+static const char urc9[] PROGMEM = "+HTTPACTION:";
+static const char * const urcprefixes[] PROGMEM = {
+  urc0, urc1, urc2, urc3, urc4, urc5, urc6, urc7, urc8, urc9
+};
+
+boolean Adafruit_FONA::queueCommand(const __FlashStringHelper *send,
+                                    FONACommandCallback done, uint16_t timeout) {
+  if (!asyncQueue(send, done, timeout))
+    return false;
+  asyncStart();
+  return true;
+}
+
+boolean Adafruit_FONA::queueCommand(const __FlashStringHelper *prefix, int32_t suffix,
+                                    FONACommandCallback done, uint16_t timeout) {
+  AsyncCommand *c = asyncQueue(prefix, done, timeout);
+  if (!c)
+    return false;
+  c->suffix[0] = suffix;
+  c->suffixes = 1;
+  asyncStart();
+  return true;
+}
+
+void Adafruit_FONA::setURCHandler(FONAURCCallback handler) {
+  urchandler = handler;
+}
+
+boolean Adafruit_FONA::commandsPending(void) {
+  return asynccount || httpdone;
+}
+
+boolean Adafruit_FONA::HTTP_action_async(uint8_t method, FONAHTTPCallback done,
+                                         int32_t timeout) {
+  if (httpdone || !queueCommand(F("AT+HTTPACTION="), method, httpActionSent))
+    return false;
+
+  // the response arrives as +HTTPACTION some seconds after the OK
+  httpdone = done;
+  httpstarted = millis();
+  httptimeout = timeout;
+  return true;
+}
+
+boolean Adafruit_FONA::HTTP_data_async(Stream &source, uint32_t size,
+                                       FONACommandCallback done, uint16_t maxTime) {
+  // the modem gives up after maxTime, so do we, a bit later
+  AsyncCommand *c = asyncQueue(F("AT+HTTPDATA="), done, maxTime > 64535 ? 65535 : maxTime + 1000);
+  if (!c)
+    return false;
+  c->suffix[0] = size;
+  c->suffix[1] = maxTime;
+  c->suffixes = 2;
+  c->source = &source;
+  asyncStart();
   return true;
 }
 
+boolean Adafruit_FONA::HTTP_read_async(uint32_t start, uint16_t len, Print &sink,
+                                       FONACommandCallback done, uint16_t timeout) {
+  AsyncCommand *c = asyncQueue(F("AT+HTTPREAD="), done, timeout);
+  if (!c)
+    return false;
+  c->suffix[0] = start;
+  c->suffix[1] = len;
+  c->suffixes = 2;
+  c->sink = &sink;
+  asyncStart();
+  return true;
+}
+
+// Moves body bytes between the modem and the active command's stream,
+// a slice at a time so poll() returns quickly.
+void Adafruit_FONA::asyncRaw(void) {
+  AsyncCommand *c = &asyncqueue[asynchead];
+  uint8_t n = 0;
+
+  if (c->source) {
+    while (asyncraw && n < FONA_ASYNC_SLICE_SIZE && c->source->available()) {
+      mySerial->write(c->source->read());
+      asyncraw--;
+      n++;
+    }
+  } else {
+    while (asyncraw && n < FONA_ASYNC_SLICE_SIZE && mySerial->available()) {
+      c->sink->write(mySerial->read());
+      asyncraw--;
+      n++;
+    }
+  }
+  if (!asyncraw)
+    asyncrawactive = false;  // back to lines, OK follows
+}
+
+boolean Adafruit_FONA::poll(void) {
+  if (asyncrawactive)
+    asyncRaw();
+
+  while (!asyncrawactive && mySerial->available()) {
+    char c = mySerial->read();
+    if (c == '\r') continue;
+    if (c == '\n') {
+      if (asynclinelen) {
+        asyncline[asynclinelen] = 0;
+        asyncLine();
+        asynclinelen = 0;
+      }
+      continue;
+    }
+    // overlong lines are cut, the rest is dropped
+    if (asynclinelen < FONA_ASYNC_LINE_SIZE - 1)
+      asyncline[asynclinelen++] = c;
+  }
+
+  if (asyncactive && millis() - asyncsent > asyncqueue[asynchead].timeout)
+    asyncFinish(FONA_ASYNC_TIMEOUT);
+
+  if (httpdone && (int32_t)(millis() - httpstarted) > httptimeout)
+    httpFinish(0, 0);
+
+  return commandsPending();
+}
+
+// Appends a command to the queue, the caller fills in the extras and calls asyncStart()
+Adafruit_FONA::AsyncCommand *Adafruit_FONA::asyncQueue(const __FlashStringHelper *send,
+                                                       FONACommandCallback done, uint16_t timeout) {
+  if (asynccount >= FONA_ASYNC_QUEUE_SIZE)
+    return 0;
+
+  AsyncCommand *c = &asyncqueue[(asynchead + asynccount) % FONA_ASYNC_QUEUE_SIZE];
+  c->send = send;
+  c->suffixes = 0;
+  c->timeout = timeout;
+  c->done = done;
+  c->source = 0;
+  c->sink = 0;
+  asynccount++;
+  return c;
+}
+
+void Adafruit_FONA::asyncStart(void) {
+  if (!asyncactive)
+    asyncSendNext();
+}
+
+void Adafruit_FONA::asyncSendNext(void) {
+  if (!asynccount)
+    return;
+
+  AsyncCommand *c = &asyncqueue[asynchead];
+#ifdef ADAFRUIT_FONA_DEBUG
+  Serial.print(F("\t---> ")); Serial.print(c->send);
+  for (uint8_t i = 0; i < c->suffixes; i++) {
+    if (i) Serial.print(',');
+    Serial.print(c->suffix[i]);
+  }
+  Serial.println();
+#endif
+  asyncinfo[0] = 0;
+  asyncactive = true;
+  asyncsent = millis();
+  mySerial->print(c->send);
+  for (uint8_t i = 0; i < c->suffixes; i++) {
+    if (i) mySerial->print(',');
+    mySerial->print(c->suffix[i]);
+  }
+  mySerial->println();
+}
+
+void Adafruit_FONA::asyncFinish(uint8_t result) {
+  FONACommandCallback done = asyncqueue[asynchead].done;
+
+  asyncactive = false;
+  asyncrawactive = false;
+  asynchead = (asynchead + 1) % FONA_ASYNC_QUEUE_SIZE;
+  asynccount--;
+  // the callback runs first, sending the next command clears asyncinfo
+  if (done == httpActionSent) {
+    // AT+HTTPACTION rejected, there will be no +HTTPACTION
+    if (result != FONA_ASYNC_OK)
+      httpFinish(0, 0);
+  } else if (done) {
+    done(result, asyncinfo);
+  }
+  // a command queued by the callback has been sent by asyncStart() already
+  if (!asyncactive)
+    asyncSendNext();
+}
+
+void Adafruit_FONA::httpFinish(uint16_t status, uint16_t datalen) {
+  FONAHTTPCallback done = httpdone;
+  httpdone = 0;
+  if (done)
+    done(status, datalen);
+}
+
+// Marks the AT+HTTPACTION entry in the queue, completion is handled by asyncFinish()
+void Adafruit_FONA::httpActionSent(uint8_t result, const char *line) {
+  (void)result;
+  (void)line;
+}
+
+boolean Adafruit_FONA::isURC(const char *line) {
+  for (uint8_t i = 0; i < sizeof(urcprefixes) / sizeof(urcprefixes[0]); i++) {
+    const char *prefix = (const char *)pgm_read_word(&urcprefixes[i]);
+    if (strncmp_P(line, prefix, strlen_P(prefix)) == 0)
+      return true;
+  }
+  return false;
+}
+
+void Adafruit_FONA::asyncLine(void) {
+#ifdef ADAFRUIT_FONA_DEBUG
+  Serial.print(F("\t<--- ")); Serial.println(asyncline);
+#endif
+  if (httpdone && strncmp_P(asyncline, (prog_char*)F("+HTTPACTION:"), 12) == 0) {
+    // +HTTPACTION: <method>,<status>,<datalen>
+    uint16_t status = 0, datalen = 0;
+    char *p = strchr(asyncline, ',');
+    if (p) {
+      status = atoi(++p);
+      p = strchr(p, ',');
+      if (p) datalen = atoi(++p);
+    }
+    httpFinish(status, datalen);
+    return;
+  }
+  if (!asyncactive || isURC(asyncline)) {
+    // nobody asked for it
+    if (urchandler)
+      urchandler(asyncline);
+    return;
+  }
+  AsyncCommand *c = &asyncqueue[asynchead];
+  if (c->source && strcmp_P(asyncline, (prog_char*)F("DOWNLOAD")) == 0) {
+    asyncraw = c->suffix[0];
+    asyncrawactive = asyncraw > 0;
+    return;
+  }
+  if (c->sink && strncmp_P(asyncline, (prog_char*)F("+HTTPREAD:"), 10) == 0) {
+    // +HTTPREAD: <len>, then len raw bytes
+    asyncraw = atol(asyncline + 10);
+    asyncrawactive = asyncraw > 0;
+    return;
+  }
+  if (strcmp_P(asyncline, (prog_char*)F("OK")) == 0) {
+    asyncFinish(FONA_ASYNC_OK);
+  } else if (strcmp_P(asyncline, (prog_char*)F("ERROR")) == 0 ||
+             strncmp_P(asyncline, (prog_char*)F("+CME ERROR"), 10) == 0 ||
+             strncmp_P(asyncline, (prog_char*)F("+CMS ERROR"), 10) == 0) {
+    strcpy(asyncinfo, asyncline);
+    asyncFinish(FONA_ASYNC_ERROR);
+  } else {
+    // information response, the last one is passed to the callback
+    strcpy(asyncinfo, asyncline);
+  }
+}
+
 /********* HELPERS *********************************************/
 
 boolean Adafruit_FONA::expectReply(const __FlashStringHelper *reply,
@@ -62,6 +62,30 @@
 #define FONA_HTTP_POST  1
 #define FONA_HTTP_HEAD  2
 
+// Non-blocking command engine, see queueCommand() and poll()
+#ifndef FONA_ASYNC_QUEUE_SIZE
+#define FONA_ASYNC_QUEUE_SIZE 4
+#endif
+#ifndef FONA_ASYNC_LINE_SIZE
+#define FONA_ASYNC_LINE_SIZE 80
+#endif
+// bytes moved per poll() while streaming an HTTP body
+#ifndef FONA_ASYNC_SLICE_SIZE
+#define FONA_ASYNC_SLICE_SIZE 64
+#endif
+
+#define FONA_ASYNC_OK      0
+#define FONA_ASYNC_ERROR   1
+#define FONA_ASYNC_TIMEOUT 2
+
+// result is one of FONA_ASYNC_*, line is the last information response
+// line of the command (empty if there was none)
+typedef void (*FONACommandCallback)(uint8_t result, const char *line);
+// unsolicited result code, e.g. "RING" or "+CMTI: \"SM\",3"
+typedef void (*FONAURCCallback)(const char *line);
+// status is 0 if the request failed or timed out
+typedef void (*FONAHTTPCallback)(uint16_t status, uint16_t datalen);
+
 class Adafruit_FONA : public Stream {
  public:
   Adafruit_FONA(int8_t r);
@@ -167,6 +191,15 @@ class Adafruit_FONA : public Stream {
   void HTTP_POST_end(void);
   void setUserAgent(const __FlashStringHelper *useragent);
 
+  // HTTP sessions: keep the bearer and the HTTP context between requests,
+  // so a request only sets the URL. HTTP_session_end() closes the context.
+  void HTTP_session(boolean onoff);
+  void HTTP_session_end(void);
+  // POST count items in one request body, each followed by separator
+  boolean HTTP_POST_batch(char *url, const __FlashStringHelper *contenttype,
+                          const char * const *items, uint8_t count, char separator,
+                          uint16_t *status, uint16_t *datalen);
+
   // HTTPS
   void setHTTPSRedirect(boolean onoff);
 
@@ -180,6 +213,20 @@ class Adafruit_FONA : public Stream {
   boolean callerIdNotification(boolean enable, uint8_t interrupt = 0);
   boolean incomingCallNumber(char* phonenum);
 
+  // Non-blocking AT commands. Commands are queued and sent back to back by
+  // poll(), which must be called from loop(). Completion is reported to
+  // the callback, unsolicited result codes go to the URC handler.
+  boolean queueCommand(const __FlashStringHelper *send, FONACommandCallback done = 0, uint16_t timeout = FONA_DEFAULT_TIMEOUT_MS);
+  boolean queueCommand(const __FlashStringHelper *prefix, int32_t suffix, FONACommandCallback done = 0, uint16_t timeout = FONA_DEFAULT_TIMEOUT_MS);
+  void setURCHandler(FONAURCCallback handler);
+  boolean poll(void);
+  boolean commandsPending(void);
+  boolean HTTP_action_async(uint8_t method, FONAHTTPCallback done, int32_t timeout = 10000);
+  // Stream size bytes of request body from source (AT+HTTPDATA), a slice per poll()
+  boolean HTTP_data_async(Stream &source, uint32_t size, FONACommandCallback done = 0, uint16_t maxTime = 10000);
+  // Pass len bytes of the response from offset start to sink (AT+HTTPREAD=start,len)
+  boolean HTTP_read_async(uint32_t start, uint16_t len, Print &sink, FONACommandCallback done = 0, uint16_t timeout = 5000);
+
   // Helper functions to verify responses.
   boolean expectReply(const __FlashStringHelper *reply, uint16_t timeout = 10000);
   boolean sendCheckReply(char *send, char *reply, uint16_t timeout = FONA_DEFAULT_TIMEOUT_MS);
@@ -196,9 +243,15 @@ class Adafruit_FONA : public Stream {
   const __FlashStringHelper *apnpassword;
   boolean httpsredirect;
   const __FlashStringHelper *useragent;
+  boolean httpkeep;           // HTTP_session() mode
+  boolean httpopen;           // HTTPINIT done and static parameters set
+  const __FlashStringHelper *httpcontent;  // CONTENT set in the open context
 
   // HTTP helpers
   boolean HTTP_setup(char *url);
+  boolean HTTP_content(const __FlashStringHelper *contenttype);
+  void HTTP_done(void);
+  boolean bearerOpen(void);
 
   void flushInput();
   uint16_t readRaw(uint16_t b);
@@ -230,6 +283,40 @@ class Adafruit_FONA : public Stream {
   static boolean _incomingCall;
   static void onIncomingCall();
 
+  // Non-blocking command engine
+  struct AsyncCommand {
+    const __FlashStringHelper *send;
+    int32_t suffix[2];
+    uint8_t suffixes;         // number of comma separated numbers after send
+    uint16_t timeout;
+    FONACommandCallback done;
+    Stream *source;           // HTTPDATA body, sent after DOWNLOAD
+    Print *sink;              // HTTPREAD body, received after +HTTPREAD
+  };
+  AsyncCommand asyncqueue[FONA_ASYNC_QUEUE_SIZE];
+  uint8_t asynchead, asynccount;
+  boolean asyncactive;        // command sent, waiting for OK or ERROR
+  uint32_t asyncsent;         // millis() when the active command was sent
+  char asyncline[FONA_ASYNC_LINE_SIZE];
+  uint8_t asynclinelen;
+  char asyncinfo[FONA_ASYNC_LINE_SIZE];
+  FONAURCCallback urchandler;
+  uint32_t asyncraw;          // body bytes left to stream to or from the modem
+  boolean asyncrawactive;
+  FONAHTTPCallback httpdone;  // waiting for +HTTPACTION
+  uint32_t httpstarted;
+  int32_t httptimeout;
+
+  AsyncCommand *asyncQueue(const __FlashStringHelper *send, FONACommandCallback done, uint16_t timeout);
+  void asyncStart(void);
+  void asyncRaw(void);
+  void asyncSendNext(void);
+  void asyncLine(void);
+  void asyncFinish(uint8_t result);
+  void httpFinish(uint16_t status, uint16_t datalen);
+  static void httpActionSent(uint8_t result, const char *line);
+  boolean isURC(const char *line);
+
   Stream *mySerial;
 };
 
@@ -35,7 +35,8 @@
 
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) :
    numLEDs(n), numBytes(n * 3), pin(p), brightness(0),
-   pixels(NULL), type(t), endTime(0)
+   pixels(NULL), front(NULL), type(t), blockBytes(0), lut(NULL), dither(0),
+   endTime(0), framePeriod(0), frameTime(0)
 #ifdef __AVR__
   ,port(portOutputRegister(digitalPinToPort(p))),
    pinMask(digitalPinToBitMask(p))
@@ -62,6 +63,8 @@ Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) :
 
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
   if(pixels) free(pixels);
+  if(front)  free(front);
+  if(lut)    free(lut);
   pinMode(pin, INPUT);
 }
 
@@ -95,14 +98,52 @@ void Adafruit_NeoPixel::show(void) {
   // state, computes 'pin high' and 'pin low' values, and writes these back
   // to the PORT register as needed.
 
-  noInterrupts(); // Need 100% focus on instruction timing
+  // With setMaxBlock() the data goes out in blocks of whole pixels and
+  // pending interrupts are serviced between blocks, while the line idles
+  // low.  An LED only latches after 50+ microseconds of low, so any
+  // handler that runs in a gap has to finish well inside that time.
+  uint8_t  *p    = pixels;
+  uint16_t  left = numBytes, n;
+
+  if(lut) {
+    // Gamma mode: pixels[] holds the colors as set, the whole frame is run
+    // through the LUT into the front buffer before anything is issued, as
+    // converting between blocks would stretch the gaps past the latch
+    // time.  The fraction the LUT carries is added up over successive
+    // frames by offsetting every byte with a different, per-frame rotating
+    // amount.
+    uint8_t *q, d = dither;
+    for(q = front; q < &front[numBytes]; d += 0x9F)
+      *q++ = (lut[*p++] + d) >> 8;
+    dither += 0x9F;
+    p = front;
+  } else if(front) {
+    // Double buffered: issue a snapshot, so code that draws during the
+    // interrupt gaps can't tear the frame that is going out.
+    memcpy(front, pixels, numBytes);
+    p = front;
+  }
+
+  while(left) {
+    n = (blockBytes && (left > blockBytes)) ? blockBytes : left;
+    noInterrupts(); // Need 100% focus on instruction timing
+    showBlock(p, n);
+    interrupts();
+    p    += n;
+    left -= n;
+  }
+  endTime = micros(); // Save EOD time for latch on next call
+}
+
+// Issue len bytes from data, interrupts have to be disabled already
+void Adafruit_NeoPixel::showBlock(uint8_t *data, uint16_t len) {
 
 #ifdef __AVR__
 
   volatile uint16_t
-    i   = numBytes; // Loop counter
+    i   = len;      // Loop counter
   volatile uint8_t
-   *ptr = pixels,   // Pointer to next byte
+   *ptr = data,     // Pointer to next byte
     b   = *ptr++,   // Current byte value
     hi,             // PORT w/output bit set high
     lo;             // PORT w/output bit set low
@@ -685,8 +726,8 @@ void Adafruit_NeoPixel::show(void) {
 #define CYCLES_400_T1H  (F_CPU /  833333)
 #define CYCLES_400      (F_CPU /  400000)
 
-  uint8_t          *p   = pixels,
-                   *end = p + numBytes, pix, mask;
+  uint8_t          *p   = data,
+                   *end = p + len, pix, mask;
   volatile uint8_t *set = portSetRegister(pin),
                    *clr = portClearRegister(pin);
   uint32_t          cyc;
@@ -741,11 +782,11 @@ void Adafruit_NeoPixel::show(void) {
 #elif defined(__MKL26Z64__) // Teensy-LC
 
 #if F_CPU == 48000000
-  uint8_t          *p   = pixels,
+  uint8_t          *p   = data,
 		   pix, count, dly,
                    bitmask = digitalPinToBitMask(pin);
   volatile uint8_t *reg = portSetRegister(pin);
-  uint32_t         num = numBytes;
+  uint32_t         num = len;
   asm volatile(
 	"L%=_begin:"				"\n\t"
 	"ldrb	%[pix], [%[p], #0]"		"\n\t"
@@ -853,8 +894,8 @@ void Adafruit_NeoPixel::show(void) {
   portClear = &(port->PIO_CODR);            // starting timer to minimize
   timeValue = &(TC1->TC_CHANNEL[0].TC_CV);  // the initial 'while'.
   timeReset = &(TC1->TC_CHANNEL[0].TC_CCR);
-  p         =  pixels;
-  end       =  p + numBytes;
+  p         =  data;
+  end       =  p + len;
   pix       = *p++;
   mask      = 0x80;
 
@@ -891,9 +932,113 @@ void Adafruit_NeoPixel::show(void) {
 #endif // end Arduino Due
 
 #endif // end Architecture select
+}
 
-  interrupts();
-  endTime = micros(); // Save EOD time for latch on next call
+// Send at most n pixels with interrupts disabled, 0 sends the whole
+// strip in one go (the default).  Blocks keep interrupt latency down on
+// long strips at the cost of slightly longer show() times.
+void Adafruit_NeoPixel::setMaxBlock(uint16_t n) {
+  blockBytes = (n > 21845) ? 0 : n * 3;
+}
+
+// 16-bit (8.8 fixed point) gamma 2.8 curve for setGamma()
+static const uint16_t PROGMEM gamma16[] = {
+      0,     0,     0,     0,     1,     1,     2,     3,
+      4,     6,     8,    10,    13,    16,    19,    23,
+     28,    33,    39,    45,    52,    60,    68,    78,
+     87,    98,   109,   121,   134,   148,   163,   179,
+    195,   213,   232,   251,   272,   293,   316,   340,
+    365,   391,   418,   447,   477,   508,   540,   573,
+    608,   644,   682,   721,   761,   802,   846,   890,
+    936,   984,  1033,  1084,  1136,  1190,  1245,  1302,
+   1361,  1421,  1483,  1547,  1612,  1680,  1749,  1820,
+   1892,  1967,  2043,  2121,  2202,  2284,  2368,  2454,
+   2542,  2632,  2724,  2818,  2914,  3012,  3112,  3215,
+   3319,  3426,  3535,  3646,  3759,  3875,  3992,  4112,
+   4235,  4359,  4486,  4616,  4748,  4882,  5018,  5157,
+   5299,  5442,  5589,  5738,  5889,  6043,  6200,  6359,
+   6520,  6685,  6852,  7021,  7194,  7369,  7546,  7727,
+   7910,  8096,  8285,  8476,  8671,  8868,  9068,  9271,
+   9477,  9685,  9897, 10112, 10329, 10550, 10774, 11000,
+  11230, 11463, 11698, 11937, 12179, 12425, 12673, 12924,
+  13179, 13437, 13698, 13962, 14230, 14501, 14775, 15052,
+  15333, 15617, 15905, 16196, 16490, 16788, 17089, 17393,
+  17701, 18013, 18328, 18646, 18968, 19294, 19623, 19956,
+  20292, 20632, 20976, 21323, 21674, 22029, 22387, 22750,
+  23115, 23485, 23859, 24236, 24617, 25002, 25390, 25783,
+  26179, 26580, 26984, 27392, 27804, 28220, 28640, 29064,
+  29492, 29925, 30361, 30801, 31245, 31694, 32146, 32603,
+  33064, 33529, 33998, 34471, 34949, 35431, 35917, 36407,
+  36902, 37400, 37904, 38411, 38923, 39439, 39960, 40485,
+  41015, 41548, 42087, 42630, 43177, 43729, 44285, 44846,
+  45411, 45981, 46556, 47135, 47718, 48307, 48900, 49497,
+  50100, 50707, 51318, 51935, 52556, 53182, 53812, 54448,
+  55088, 55733, 56383, 57038, 57698, 58362, 59032, 59706,
+  60385, 61070, 61759, 62453, 63152, 63856, 64566, 65280
+};
+
+// Compensate for the eye's non-linear response and keep colors at full
+// precision: pixels[] then stores colors exactly as set, and gamma plus
+// brightness are applied through a 256-entry table (512 bytes of RAM)
+// when show() converts the frame, with temporal dithering of the fraction.
+// The converted frame goes to the buffer of setDoubleBuffer(), which is
+// allocated here if needed (another numPixels() * 3 bytes) and kept when
+// gamma is turned off again.  Existing pixel data is taken as-is, so set
+// this before drawing.  Returns false if the table or buffer could not be
+// allocated.
+bool Adafruit_NeoPixel::setGamma(bool on) {
+  if(!on) {
+    if(lut) free(lut);
+    lut = NULL;
+    return true;
+  }
+  if(!setDoubleBuffer(true))
+    return false;
+  if(!lut && !(lut = (uint16_t *)malloc(256 * sizeof(uint16_t))))
+    return false;
+  updateLut();
+  return true;
+}
+
+void Adafruit_NeoPixel::updateLut(void) {
+  uint16_t scale = brightness ? brightness - 1 : 256;
+  for(uint16_t i=0; i<256; i++)
+    lut[i] = ((uint32_t)pgm_read_word(&gamma16[i]) * scale) >> 8;
+}
+
+// Keep a second pixel buffer: drawing always goes to pixels[] (and
+// getPixels()), while show() issues a snapshot taken at the moment it was
+// called, which matters once setMaxBlock() lets interrupt handlers run
+// during show().  Costs another numPixels() * 3 bytes of RAM.  Returns false if
+// the buffer could not be allocated, or turning it off while setGamma() is on.
+bool Adafruit_NeoPixel::setDoubleBuffer(bool on) {
+  if(!on) {
+    if(lut) return false; // gamma mode needs the buffer
+    if(front) free(front);
+    front = NULL;
+    return true;
+  }
+  if(!front && !(front = (uint8_t *)malloc(numBytes)))
+    return false;
+  return true;
+}
+
+// Frame pacing for animations: frameDue() returns true once per frame at
+// the given rate, without blocking, so the sketch can keep servicing the
+// radio in between.  A frame that is late by more than a whole period
+// restarts the schedule instead of bursting to catch up.  0 = always due.
+void Adafruit_NeoPixel::setFrameRate(uint8_t fps) {
+  framePeriod = fps ? 1000000UL / fps : 0;
+  frameTime   = micros();
+}
+
+bool Adafruit_NeoPixel::frameDue(void) {
+  uint32_t now = micros();
+  if(!framePeriod) return true;
+  if((int32_t)(now - frameTime) < 0) return false;
+  frameTime += framePeriod;
+  if((int32_t)(now - frameTime) >= 0) frameTime = now + framePeriod;
+  return true;
 }
 
 // Set the output pin number
@@ -912,7 +1057,7 @@ void Adafruit_NeoPixel::setPin(uint8_t p) {
 void Adafruit_NeoPixel::setPixelColor(
  uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
   if(n < numLEDs) {
-    if(brightness) { // See notes in setBrightness()
+    if(brightness && !lut) { // See notes in setBrightness()
       r = (r * brightness) >> 8;
       g = (g * brightness) >> 8;
       b = (b * brightness) >> 8;
@@ -931,7 +1076,7 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
       r = (uint8_t)(c >> 16),
       g = (uint8_t)(c >>  8),
       b = (uint8_t)c;
-    if(brightness) { // See notes in setBrightness()
+    if(brightness && !lut) { // See notes in setBrightness()
       r = (r * brightness) >> 8;
       g = (g * brightness) >> 8;
       b = (b * brightness) >> 8;
@@ -961,7 +1106,7 @@ uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
                 (uint32_t)p[bOffset];
   // Adjust this back up to the true color, as setting a pixel color will
   // scale it back down again.
-  if(brightness) { // See notes in setBrightness()
+  if(brightness && !lut) { // See notes in setBrightness()
     //Cast the color to a byte array
     uint8_t * c_ptr =reinterpret_cast<uint8_t*>(&c);
     c_ptr[0] = (c_ptr[0] << 8)/brightness;
@@ -1002,6 +1147,11 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
   // (color values are interpreted literally; no scaling), 1 = min
   // brightness (off), 255 = just below max brightness.
   uint8_t newBrightness = b + 1;
+  if(lut) { // Gamma mode scales in the table, pixel data stays untouched
+    brightness = newBrightness;
+    updateLut();
+    return;
+  }
   if(newBrightness != brightness) { // Compare against prior value
     // Brightness has changed -- re-scale existing data in RAM
     uint8_t  c,
@@ -1027,3 +1177,141 @@ uint8_t Adafruit_NeoPixel::getBrightness(void) const {
 void Adafruit_NeoPixel::clear() {
   memset(pixels, 0, numBytes);
 }
+
+// The bulk functions below work on pixels first..first+count-1, count 0
+// meaning up to the end, and leave pixels beyond the strip alone.  Colors
+// are put in wire order and scaled to the brightness once per call, not
+// once per pixel as setPixelColor() does.
+
+// Number of pixels of a range that are on the strip
+uint16_t Adafruit_NeoPixel::clip(uint16_t first, uint16_t count) const {
+  if(first >= numLEDs) return 0;
+  if(!count || count > numLEDs - first) count = numLEDs - first;
+  return count;
+}
+
+// Packed RGB color to the 3 bytes stored for a pixel
+void Adafruit_NeoPixel::wireColor(uint32_t c, uint8_t *w) const {
+  uint8_t
+    r = (uint8_t)(c >> 16),
+    g = (uint8_t)(c >>  8),
+    b = (uint8_t)c;
+  if(brightness && !lut) { // See notes in setBrightness()
+    r = (r * brightness) >> 8;
+    g = (g * brightness) >> 8;
+    b = (b * brightness) >> 8;
+  }
+  w[rOffset] = r;
+  w[gOffset] = g;
+  w[bOffset] = b;
+}
+
+// Set a range of pixels to one color
+void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
+  count = clip(first, count);
+  if(!count) return;
+  uint8_t w[3], *p = &pixels[first * 3];
+  wireColor(c, w);
+  if(w[0] == w[1] && w[1] == w[2]) {
+    memset(p, w[0], count * 3);
+    return;
+  }
+  while(count--) {
+    *p++ = w[0];
+    *p++ = w[1];
+    *p++ = w[2];
+  }
+}
+
+// Blend a range of pixels linearly from c1 (first pixel) to c2 (last).
+// The channels step in 16.16 fixed point, no multiply or divide per pixel.
+void Adafruit_NeoPixel::fillGradient(
+ uint32_t c1, uint32_t c2, uint16_t first, uint16_t count) {
+  count = clip(first, count);
+  if(!count) return;
+  uint8_t w1[3], w2[3], *p = &pixels[first * 3];
+  wireColor(c1, w1);
+  wireColor(c2, w2);
+  int32_t acc[3], step[3];
+  for(uint8_t i=0; i<3; i++) {
+    acc[i]  = ((int32_t)w1[i] << 16) + 0x8000; // Round to nearest
+    step[i] = count > 1 ?
+      (((int32_t)w2[i] - w1[i]) << 16) / (count - 1) : 0;
+  }
+  while(count--) {
+    *p++ = acc[0] >> 16; acc[0] += step[0];
+    *p++ = acc[1] >> 16; acc[1] += step[1];
+    *p++ = acc[2] >> 16; acc[2] += step[2];
+  }
+}
+
+// Copy count pixels starting at 'from' to 'to', the ranges may overlap
+void Adafruit_NeoPixel::copyRange(uint16_t to, uint16_t from, uint16_t count) {
+  if(!count) return;
+  count = min(clip(to, count), clip(from, count));
+  memmove(&pixels[to * 3], &pixels[from * 3], count * 3);
+}
+
+// Move all pixels n places up (n > 0) or down (n < 0) the strip, the
+// pixels that become free are cleared
+void Adafruit_NeoPixel::shift(int16_t n) {
+  uint16_t d = n < 0 ? -n : n;
+  if(d >= numLEDs) {
+    clear();
+    return;
+  }
+  if(n > 0) {
+    memmove(&pixels[d * 3], pixels, (numLEDs - d) * 3);
+    memset(pixels, 0, d * 3);
+  } else if(n < 0) {
+    memmove(pixels, &pixels[d * 3], (numLEDs - d) * 3);
+    memset(&pixels[(numLEDs - d) * 3], 0, d * 3);
+  }
+}
+
+// Reverse the order of a range of pixels (in bounds)
+void Adafruit_NeoPixel::reverse(uint16_t first, uint16_t count) {
+  uint8_t *a = &pixels[first * 3], *b = &pixels[(first + count - 1) * 3], t;
+  while(a < b) {
+    t = a[0]; a[0] = b[0]; b[0] = t;
+    t = a[1]; a[1] = b[1]; b[1] = t;
+    t = a[2]; a[2] = b[2]; b[2] = t;
+    a += 3;
+    b -= 3;
+  }
+}
+
+// Like shift(), but the pixels pushed off one end come back in at the
+// other, e.g. to run a rainbow along the strip without redrawing it.
+// Done by three reversals, so no extra RAM is needed.
+void Adafruit_NeoPixel::rotate(int16_t n) {
+  if(numLEDs < 2) return;
+  int32_t d = n % (int32_t)numLEDs;
+  if(d < 0) d += numLEDs;
+  if(!d) return;
+  reverse(0, numLEDs);
+  reverse(0, d);
+  reverse(d, numLEDs - d);
+}
+
+// Convert hue (0-65535 is one turn of the color wheel, starting at red),
+// saturation and value into a packed 32-bit RGB color, integer math only.
+uint32_t Adafruit_NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
+  uint32_t h6     = (uint32_t)hue * 6;
+  uint8_t  sector = h6 >> 16,         // 0-5
+           frac   = (h6 >> 8) & 0xFF; // Position within the sector
+  uint16_t s1     = sat + 1,          // So that (x * s1) >> 8 is x at sat 255
+           v1     = val + 1;
+  uint8_t
+    p = (v1 * (255 - ((255 * s1) >> 8))) >> 8,
+    q = (v1 * (255 - ((frac * s1) >> 8))) >> 8,
+    t = (v1 * (255 - (((255 - frac) * s1) >> 8))) >> 8;
+  switch(sector) {
+    case 0:  return Color(val, t, p);
+    case 1:  return Color(q, val, p);
+    case 2:  return Color(p, val, t);
+    case 3:  return Color(p, q, val);
+    case 4:  return Color(t, p, val);
+    default: return Color(val, p, q);
+  }
+}
@@ -56,14 +56,26 @@ class Adafruit_NeoPixel {
     setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b),
     setPixelColor(uint16_t n, uint32_t c),
     setBrightness(uint8_t),
+    setMaxBlock(uint16_t n),
+    setFrameRate(uint8_t fps),
+    fill(uint32_t c, uint16_t first=0, uint16_t count=0),
+    fillGradient(uint32_t c1, uint32_t c2, uint16_t first=0, uint16_t count=0),
+    copyRange(uint16_t to, uint16_t from, uint16_t count),
+    shift(int16_t n),
+    rotate(int16_t n),
     clear();
+  bool
+    setGamma(bool on),
+    setDoubleBuffer(bool on),
+    frameDue(void);
   uint8_t
    *getPixels(void) const,
     getBrightness(void) const;
   uint16_t
     numPixels(void) const;
   static uint32_t
-    Color(uint8_t r, uint8_t g, uint8_t b);
+    Color(uint8_t r, uint8_t g, uint8_t b),
+    ColorHSV(uint16_t hue, uint8_t sat=255, uint8_t val=255);
   uint32_t
     getPixelColor(uint16_t n) const;
   inline bool
@@ -78,13 +90,21 @@ class Adafruit_NeoPixel {
     pin,           // Output pin number
     brightness,
    *pixels,        // Holds LED color values (3 bytes each)
+   *front,         // Frame being shown when double buffered, else NULL
     rOffset,       // Index of red byte within each 3-byte pixel
     gOffset,       // Index of green byte
     bOffset;       // Index of blue byte
   const uint8_t
     type;          // Pixel flags (400 vs 800 KHz, RGB vs GRB color)
+  uint16_t
+    blockBytes,    // Max bytes sent with interrupts off, 0 = all at once
+   *lut;           // Gamma+brightness table (8.8 fixed point) or NULL
+  uint8_t
+    dither;        // Temporal dithering phase, advances every show()
   uint32_t
-    endTime;       // Latch timing reference
+    endTime,       // Latch timing reference
+    framePeriod,   // Microseconds per frame for frameDue(), 0 = off
+    frameTime;     // When the next frame is due
 #ifdef __AVR__
   const volatile uint8_t
     *port;         // Output PORT register
@@ -92,6 +112,14 @@ class Adafruit_NeoPixel {
     pinMask;       // Output PORT bitmask
 #endif
 
+  void
+    showBlock(uint8_t *data, uint16_t len),
+    updateLut(void),
+    wireColor(uint32_t c, uint8_t *w) const,
+    reverse(uint16_t first, uint16_t count);
+  uint16_t
+    clip(uint16_t first, uint16_t count) const;
+
 };
 
 #endif // ADAFRUIT_NEOPIXEL_H
@@ -16,6 +16,8 @@ Written by Christopher Laws, March, 2013.
 
 
 BH1750::BH1750() {
+  _startTime = 0;
+  _waitTime = 0;
 }
 
 void BH1750::begin(uint8_t mode) {
@@ -49,6 +51,29 @@ void BH1750::configure(uint8_t mode) {
 }
 
 
+void BH1750::start(uint8_t mode) {
+
+  // maximum measurement times from the datasheet
+  switch (mode) {
+    case BH1750_CONTINUOUS_LOW_RES_MODE:
+    case BH1750_ONE_TIME_LOW_RES_MODE:
+      _waitTime = 24;
+      break;
+    default:
+      _waitTime = 180;
+      break;
+  }
+  write8(mode);
+  _startTime = millis();
+}
+
+
+bool BH1750::isReady(void) {
+
+  return (millis() - _startTime) >= _waitTime;
+}
+
+
 uint16_t BH1750::readLightLevel(void) {
 
   uint16_t level;
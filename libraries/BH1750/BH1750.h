@@ -64,9 +64,17 @@ class BH1750 {
   void configure(uint8_t mode);
   uint16_t readLightLevel(void);
 
+  // Split-phase reading: start() sends a one time measurement command and
+  // returns at once, readLightLevel() once isReady() is true.
+  void start(uint8_t mode = BH1750_ONE_TIME_HIGH_RES_MODE);
+  bool isReady(void);
+
  private:
   void write8(uint8_t data);
 
+  unsigned long _startTime;
+  uint8_t _waitTime;
+
 };
 
 #endif
\ No newline at end of file
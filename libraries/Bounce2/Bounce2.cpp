@@ -82,3 +82,118 @@ uint8_t Bounce::read()
 	return debouncedState;
 }
 
+
+
+BounceBank::BounceBank() {
+	groupCount = 0;
+	interval(10);
+}
+
+bool BounceBank::attach(uint8_t pin) {
+	uint8_t i;
+	uint8_t bit;
+#ifdef __AVR__
+	volatile uint8_t *input = portInputRegister(digitalPinToPort(pin));
+	bit = digitalPinToBitMask(pin);
+	for (i = 0; i < groupCount && groups[i].input != input; i++);
+#else
+	// without port access every 8 pins make a group
+	for (i = 0; i < groupCount && groups[i].mask == 0xFF; i++);
+	bit = 1 << __builtin_popcount(i < groupCount ? groups[i].mask : 0);
+#endif
+	if (i == groupCount) {
+		if (groupCount == BOUNCE_BANK_GROUPS) return false;
+		groupCount++;
+		groups[i].mask = 0;
+		groups[i].state = 0;
+		groups[i].count0 = groups[i].count1 = 0xFF;
+		groups[i].changes = 0;
+#ifdef __AVR__
+		groups[i].input = input;
+#endif
+	}
+#ifndef __AVR__
+	groups[i].pins[__builtin_ctz(bit)] = pin;
+#endif
+	groups[i].mask |= bit;
+	groups[i].state = (groups[i].state & ~bit) | (sample(groups[i]) & bit);
+	previous_millis = millis();
+	return true;
+}
+
+void BounceBank::interval(unsigned long interval_millis)
+{
+	// the counters need 4 samples in a row
+	sample_millis = interval_millis >= 4 ? interval_millis / 4 : 1;
+}
+
+uint8_t BounceBank::sample(group_t &group)
+{
+#ifdef __AVR__
+	return *group.input & group.mask;
+#else
+	uint8_t value = 0;
+	for (uint8_t b = 0; b < 8; b++) {
+		if ((group.mask & (1 << b)) && digitalRead(group.pins[b])) value |= 1 << b;
+	}
+	return value;
+#endif
+}
+
+bool BounceBank::update()
+{
+	uint8_t any = 0;
+	unsigned long now = millis();
+	if (now - previous_millis < sample_millis) {
+		for (uint8_t i = 0; i < groupCount; i++) groups[i].changes = 0;
+		return false;
+	}
+	// keep the sample rate, but after a long loop don't catch up in a burst
+	previous_millis = now - previous_millis < 2 * sample_millis ? previous_millis + sample_millis : now;
+	for (uint8_t i = 0; i < groupCount; i++) {
+		group_t &g = groups[i];
+		// bits that differ from the debounced state count down, the others reset
+		uint8_t delta = (sample(g) ^ g.state) & g.mask;
+		g.count0 = ~(g.count0 & delta);
+		g.count1 = g.count0 ^ (g.count1 & delta);
+		// pins whose counter rolled over changed state
+		delta &= g.count0 & g.count1;
+		g.state ^= delta;
+		g.changes = delta;
+		any |= delta;
+	}
+	return any;
+}
+
+bool BounceBank::find(uint8_t pin, uint8_t &index, uint8_t &bit)
+{
+#ifdef __AVR__
+	volatile uint8_t *input = portInputRegister(digitalPinToPort(pin));
+	bit = digitalPinToBitMask(pin);
+	for (index = 0; index < groupCount; index++) {
+		if (groups[index].input == input) return groups[index].mask & bit;
+	}
+#else
+	for (index = 0; index < groupCount; index++) {
+		for (uint8_t b = 0; b < 8; b++) {
+			bit = 1 << b;
+			if ((groups[index].mask & bit) && groups[index].pins[b] == pin) return true;
+		}
+	}
+#endif
+	return false;
+}
+
+uint8_t BounceBank::read(uint8_t pin)
+{
+	uint8_t index, bit;
+	if (!find(pin, index, bit)) return 0;
+	return (groups[index].state & bit) ? HIGH : LOW;
+}
+
+bool BounceBank::changed(uint8_t pin)
+{
+	uint8_t index, bit;
+	if (!find(pin, index, bit)) return false;
+	return groups[index].changes & bit;
+}
@@ -59,6 +59,53 @@ protected:
   uint8_t stateChanged;
 };
 
+// Number of 8 pin groups a BounceBank can hold (on AVR one group is one port)
+#ifndef BOUNCE_BANK_GROUPS
+#define BOUNCE_BANK_GROUPS 4
+#endif
+
+// Debounces many pins at once: reads whole ports and runs 2 bit vertical
+// counters, 8 pins per byte. A pin changes state after 4 equal samples
+// taken interval/4 apart.
+class BounceBank
+{
+
+public:
+  // Create an empty bank
+  BounceBank();
+  // Adds a pin (and also sets its initial state)
+  // Returns false if the bank is full
+  bool attach(uint8_t pin);
+	// Sets the debounce interval
+  void interval(unsigned long interval_millis);
+	// Samples all pins if a sample is due
+	// Returns true if the state of any pin changed
+  bool update();
+	// Returns the updated pin state
+  uint8_t read(uint8_t pin);
+	// Returns true if the pin changed state in the last update()
+  bool changed(uint8_t pin);
+
+protected:
+  struct group_t {
+#ifdef __AVR__
+    volatile uint8_t *input;
+#else
+    uint8_t pins[8];
+#endif
+    uint8_t mask;        // attached pins
+    uint8_t state;       // debounced states
+    uint8_t count0;      // vertical counter, low bits
+    uint8_t count1;      // vertical counter, high bits
+    uint8_t changes;     // pins that changed in the last update()
+  };
+  group_t groups[BOUNCE_BANK_GROUPS];
+  uint8_t groupCount;
+  unsigned long previous_millis, sample_millis;
+  uint8_t sample(group_t &group);
+  bool find(uint8_t pin, uint8_t &index, uint8_t &bit);
+};
+
 #endif
 
 
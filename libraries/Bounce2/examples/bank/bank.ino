@@ -0,0 +1,32 @@
+#include <Bounce2.h>
+
+// Debounce a keypad of 8 buttons on pins 2 to 9 with one BounceBank
+// and report every press and release
+
+#define FIRST_PIN 2
+#define BUTTONS 8
+
+// Instantiate a BounceBank object
+BounceBank buttons = BounceBank();
+
+void setup() {
+  Serial.begin(9600);
+  for (int pin = FIRST_PIN; pin < FIRST_PIN + BUTTONS; pin++) {
+    // Setup the button with an internal pull-up
+    pinMode(pin, INPUT_PULLUP);
+    buttons.attach(pin);
+  }
+  buttons.interval(20);
+}
+
+void loop() {
+  // One update() samples all pins
+  if ( buttons.update() ) {
+    for (int pin = FIRST_PIN; pin < FIRST_PIN + BUTTONS; pin++) {
+      if ( buttons.changed(pin) ) {
+        Serial.print(pin);
+        Serial.println(buttons.read(pin) == LOW ? " pressed" : " released");
+      }
+    }
+  }
+}
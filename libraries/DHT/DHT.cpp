@@ -24,14 +24,64 @@
    2013-06-10: Initial version
    2013-06-12: Refactored code
    2013-07-01: Add a resetTimer method
+   Add interrupt driven startRead/isReady
  ******************************************************************/
 
 #include "DHT.h"
 
+#ifndef digitalPinToInterrupt
+  #define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+#endif
+
+// Sensors waiting for an edge, one per external interrupt
+
+static DHT *isrSensor[DHT_MAX_INTERRUPTS];
+
+static void isr0() { isrSensor[0]->captureEdge(); }
+#if DHT_MAX_INTERRUPTS > 1
+static void isr1() { isrSensor[1]->captureEdge(); }
+#endif
+#if DHT_MAX_INTERRUPTS > 2
+static void isr2() { isrSensor[2]->captureEdge(); }
+#endif
+#if DHT_MAX_INTERRUPTS > 3
+static void isr3() { isrSensor[3]->captureEdge(); }
+#endif
+#if DHT_MAX_INTERRUPTS > 4
+static void isr4() { isrSensor[4]->captureEdge(); }
+#endif
+#if DHT_MAX_INTERRUPTS > 5
+static void isr5() { isrSensor[5]->captureEdge(); }
+#endif
+
+static void (* const isrHandler[DHT_MAX_INTERRUPTS])() = {
+  isr0,
+#if DHT_MAX_INTERRUPTS > 1
+  isr1,
+#endif
+#if DHT_MAX_INTERRUPTS > 2
+  isr2,
+#endif
+#if DHT_MAX_INTERRUPTS > 3
+  isr3,
+#endif
+#if DHT_MAX_INTERRUPTS > 4
+  isr4,
+#endif
+#if DHT_MAX_INTERRUPTS > 5
+  isr5,
+#endif
+};
+
 void DHT::setup(uint8_t pin, DHT_MODEL_t model)
 {
   DHT::pin = pin;
+#if defined(__AVR__)
+  pinInput = portInputRegister(digitalPinToPort(pin));
+  pinBit = digitalPinToBitMask(pin);
+#endif
   DHT::model = model;
+  DHT::state = STATE_IDLE;
   DHT::resetTimer(); // Make sure we do read the sensor in the next readSensor()
 
   if ( model == AUTO_DETECT) {
@@ -157,7 +207,7 @@ void DHT::readSensor()
         return;
       }
     }
-    while ( digitalRead(pin) == (i & 1) ? HIGH : LOW );
+    while ( readPin() == (i & 1) );
 
     if ( i >= 0 && (i & 1) ) {
       // Now we are being fed our 40 bits
@@ -180,9 +230,14 @@ void DHT::readSensor()
     }
   }
 
+  decode(rawHumidity, rawTemperature, data);
+}
+
+void DHT::decode(word rawHumidity, word rawTemperature, byte checksum)
+{
   // Verify checksum
 
-  if ( (byte)(((byte)rawHumidity) + (rawHumidity >> 8) + ((byte)rawTemperature) + (rawTemperature >> 8)) != data ) {
+  if ( (byte)(((byte)rawHumidity) + (rawHumidity >> 8) + ((byte)rawTemperature) + (rawTemperature >> 8)) != checksum ) {
     error = ERROR_CHECKSUM;
     return;
   }
@@ -204,3 +259,118 @@ void DHT::readSensor()
 
   error = ERROR_NONE;
 }
+
+bool DHT::startRead(DHT_CALLBACK_t callback)
+{
+  int8_t irq = digitalPinToInterrupt(pin);
+  if ( irq < 0 || irq >= DHT_MAX_INTERRUPTS || state != STATE_IDLE ) {
+    return false;
+  }
+
+  // Same sample rate limits as readSensor()
+  unsigned long startTime = millis();
+  if ( (unsigned long)(startTime - lastReadTime) < (model == DHT11 ? 999L : 1999L) ) {
+    return false;
+  }
+  lastReadTime = startTime;
+
+  temperature = NAN;
+  humidity = NAN;
+  DHT::callback = callback;
+
+  digitalWrite(pin, LOW); // Send start signal
+  pinMode(pin, OUTPUT);
+  if ( model == DHT11 ) {
+    // The 18 msec start signal is ended by isReady()
+    state = STATE_STARTING;
+  }
+  else {
+    delayMicroseconds(800);
+    releaseBus();
+  }
+  return true;
+}
+
+void DHT::releaseBus()
+{
+  int8_t irq = digitalPinToInterrupt(pin);
+
+  edges = 0;
+  captureTime = millis();
+  state = STATE_CAPTURING;
+  isrSensor[irq] = this;
+
+  pinMode(pin, INPUT);
+  digitalWrite(pin, HIGH); // Switch bus to receive data
+  attachInterrupt(irq, isrHandler[irq], FALLING);
+}
+
+// We're going to see 42 falling edges: the sensor pulling the bus low
+// to start its response, the end of the 80 usecs high start bit, and the
+// end of each of the 40 bits. A bit takes about 78 usecs for a zero and
+// 120 for a one.
+
+void DHT::captureEdge()
+{
+  unsigned long now = micros();
+  unsigned int age = now - lastEdge;
+  lastEdge = now;
+
+  // The start signal may leave a pending interrupt, which shows up as an
+  // edge right before the real response. The response itself takes 160 usecs.
+  if ( edges == 1 && age < 120 ) {
+    return;
+  }
+
+  if ( edges >= 2 ) {
+    uint8_t i = (edges - 2) >> 3;
+    frame[i] <<= 1;
+    if ( age > 100 ) {
+      frame[i] |= 1; // we got a one
+    }
+  }
+
+  if ( ++edges == 42 ) {
+    detachInterrupt(digitalPinToInterrupt(pin));
+    state = STATE_CAPTURED;
+    if ( callback ) {
+      callback(this);
+    }
+  }
+}
+
+bool DHT::isReady()
+{
+  switch ( state ) {
+    case STATE_STARTING:
+      if ( (unsigned long)(millis() - lastReadTime) >= 18 ) {
+        releaseBus();
+      }
+      return false;
+
+    case STATE_CAPTURING:
+      // A complete frame takes less than 5 msecs
+      if ( (unsigned long)(millis() - captureTime) < 10 ) {
+        return false;
+      }
+      noInterrupts();
+      if ( state == STATE_CAPTURING ) {
+        detachInterrupt(digitalPinToInterrupt(pin));
+        state = STATE_IDLE;
+        error = ERROR_TIMEOUT;
+      }
+      interrupts();
+      if ( state == STATE_IDLE ) {
+        return true;
+      }
+      // Captured after all, fall through
+
+    case STATE_CAPTURED:
+      state = STATE_IDLE;
+      decode((frame[0] << 8) | frame[1], (frame[2] << 8) | frame[3], frame[4]);
+      return true;
+
+    default:
+      return true;
+  }
+}
@@ -24,6 +24,7 @@
    2013-06-10: Initial version
    2013-06-12: Refactored code
    2013-07-01: Add a resetTimer method
+   Add interrupt driven startRead/isReady
  ******************************************************************/
 
 #ifndef dht_h
@@ -35,6 +36,11 @@
   #include <Arduino.h>
 #endif
 
+// Number of external interrupts that can be used by startRead()
+#ifndef DHT_MAX_INTERRUPTS
+  #define DHT_MAX_INTERRUPTS 6
+#endif
+
 class DHT
 {
 public:
@@ -55,9 +61,20 @@ public:
   }
   DHT_ERROR_t;
 
+  typedef void (*DHT_CALLBACK_t)(DHT *sender);
+
   void setup(uint8_t pin, DHT_MODEL_t model=AUTO_DETECT);
   void resetTimer();
 
+  // Interrupt driven reading: startRead() sends the start signal and
+  // returns, the response is captured by an external interrupt on the
+  // data pin. Keep calling isReady() until it returns true, then
+  // getTemperature() and getHumidity() return the captured values
+  // until the sampling period is over. The callback is called from the
+  // interrupt when the last bit has arrived.
+  bool startRead(DHT_CALLBACK_t callback=NULL);
+  bool isReady();
+
   float getTemperature();
   float getHumidity();
 
@@ -79,8 +96,12 @@ public:
   static float toFahrenheit(float fromCelcius) { return 1.8 * fromCelcius + 32.0; };
   static float toCelsius(float fromFahrenheit) { return (fromFahrenheit - 32.0) / 1.8; };
 
+  // Called by the interrupt handler on every falling edge
+  void captureEdge();
+
 protected:
   void readSensor();
+  void decode(word rawHumidity, word rawTemperature, byte checksum);
 
   float temperature;
   float humidity;
@@ -88,9 +109,36 @@ protected:
   uint8_t pin;
 
 private:
+  void releaseBus();
+
+  // The bit loop polls the pin for up to 90 usecs per edge, digitalRead()
+  // would eat a good part of the time resolution.
+#if defined(__AVR__)
+  volatile uint8_t *pinInput;
+  uint8_t pinBit;
+  bool readPin() { return *pinInput & pinBit; }
+#else
+  bool readPin() { return digitalRead(pin); }
+#endif
+
   DHT_MODEL_t model;
   DHT_ERROR_t error;
   unsigned long lastReadTime;
+
+  typedef enum {
+    STATE_IDLE,
+    STATE_STARTING,
+    STATE_CAPTURING,
+    STATE_CAPTURED
+  }
+  DHT_STATE_t;
+
+  volatile DHT_STATE_t state;
+  volatile uint8_t edges;
+  volatile uint8_t frame[5];
+  unsigned long lastEdge;
+  unsigned long captureTime;
+  DHT_CALLBACK_t callback;
 };
 
 #endif /*dht_h*/
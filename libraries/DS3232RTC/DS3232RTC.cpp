@@ -64,6 +64,14 @@
 #define i2cWrite Wire.send
 #endif
 
+#if RTC_GET_CACHE
+//get() cache, see get()
+static time_t cacheTime;                //time of the last bus read
+static unsigned long cacheMillis;       //millis() of the last bus read
+static unsigned long cacheTickAfter;    //millis() of the last read before the second ticked to cacheTime
+static boolean cacheSynced;             //cacheTickAfter is known
+#endif
+
 /*----------------------------------------------------------------------*
  * Constructor.                                                         *
  *----------------------------------------------------------------------*/
@@ -76,13 +84,35 @@ DS3232RTC::DS3232RTC()
  * Read the current time from the RTC and return it as a time_t value.  *
  * Returns a zero value if an I2C error occurred (e.g. RTC              *
  * not present).                                                        *
+ * With RTC_GET_CACHE, once two reads have seen the seconds tick over,  *
+ * the time is known not to change for the next second, and calls      *
+ * within that second are answered without going to the bus.           *
  *----------------------------------------------------------------------*/
 time_t DS3232RTC::get()
 {
     tmElements_t tm;
+#if RTC_GET_CACHE
+    time_t t;
+    unsigned long ms = millis();
     
+    if ( cacheSynced && ms - cacheTickAfter < 1000 - RTC_GET_CACHE_MARGIN ) return cacheTime;
+    if ( read(tm) ) {
+        cacheSynced = false;
+        return 0;
+    }
+    t = makeTime(tm);
+    if ( t != cacheTime ) {
+        //the tick fell between the previous read and this one
+        cacheSynced = ( t == cacheTime + 1 && cacheMillis );
+        cacheTickAfter = cacheMillis;
+    }
+    cacheTime = t;
+    cacheMillis = ms ? ms : 1;          //zero means no previous read
+    return t;
+#else
     if ( read(tm) ) return 0;
-    return( makeTime(tm) );
+    return makeTime(tm);
+#endif
 }
 
 /*----------------------------------------------------------------------*
@@ -133,6 +163,10 @@ byte DS3232RTC::write(tmElements_t &tm)
     i2cWrite(dec2bcd(tm.Day));
     i2cWrite(dec2bcd(tm.Month));
     i2cWrite(dec2bcd(tmYearToY2k(tm.Year))); 
+#if RTC_GET_CACHE
+    cacheSynced = false;
+    cacheMillis = 0;
+#endif
     return i2cEndTransmission();
 }
 
@@ -190,6 +224,48 @@ byte DS3232RTC::readRTC(byte addr)
     return b;
 }
 
+/*----------------------------------------------------------------------*
+ * Write multiple bytes to the battery-backed SRAM (DS3232 only), in    *
+ * as few transfers as the Wire buffer allows. offset is relative to    *
+ * the SRAM start (0 - 235). Returns the I2C status (zero if            *
+ * successful), 1 without any transfer if the range exceeds the SRAM.   *
+ *----------------------------------------------------------------------*/
+byte DS3232RTC::writeSRAM(byte offset, byte *values, byte nBytes)
+{
+    byte n, e;
+
+    if ( (uint16_t)offset + nBytes > SRAM_SIZE ) return 1;
+    while (nBytes) {
+        n = nBytes < RTC_WRITE_CHUNK ? nBytes : RTC_WRITE_CHUNK;
+        if ( (e = writeRTC(SRAM_START_ADDR + offset, values, n)) ) return e;
+        offset += n;
+        values += n;
+        nBytes -= n;
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------*
+ * Read multiple bytes from the battery-backed SRAM (DS3232 only), in   *
+ * as few transfers as the Wire buffer allows. offset is relative to    *
+ * the SRAM start (0 - 235). Returns the I2C status (zero if            *
+ * successful), 1 without any transfer if the range exceeds the SRAM.   *
+ *----------------------------------------------------------------------*/
+byte DS3232RTC::readSRAM(byte offset, byte *values, byte nBytes)
+{
+    byte n, e;
+
+    if ( (uint16_t)offset + nBytes > SRAM_SIZE ) return 1;
+    while (nBytes) {
+        n = nBytes < RTC_READ_CHUNK ? nBytes : RTC_READ_CHUNK;
+        if ( (e = readRTC(SRAM_START_ADDR + offset, values, n)) ) return e;
+        offset += n;
+        values += n;
+        nBytes -= n;
+    }
+    return 0;
+}
+
 /*----------------------------------------------------------------------*
  * Set an alarm time. Sets the alarm registers only.  To cause the      *
  * INT pin to be asserted on alarm match, use alarmInterrupt().         *
@@ -200,7 +276,7 @@ byte DS3232RTC::readRTC(byte addr)
  *----------------------------------------------------------------------*/
 void DS3232RTC::setAlarm(ALARM_TYPES_t alarmType, byte seconds, byte minutes, byte hours, byte daydate)
 {
-    uint8_t addr;
+    uint8_t regs[4];
     
     seconds = dec2bcd(seconds);
     minutes = dec2bcd(minutes);
@@ -212,16 +288,16 @@ void DS3232RTC::setAlarm(ALARM_TYPES_t alarmType, byte seconds, byte minutes, by
     if (alarmType & 0x10) hours |= _BV(DYDT);
     if (alarmType & 0x08) daydate |= _BV(A1M4);
     
+    regs[0] = seconds;
+    regs[1] = minutes;
+    regs[2] = hours;
+    regs[3] = daydate;
     if ( !(alarmType & 0x80) ) {    //alarm 1
-        addr = ALM1_SECONDS;
-        writeRTC(addr++, seconds);
+        writeRTC(ALM1_SECONDS, regs, 4);
     }
-    else {
-        addr = ALM2_MINUTES;
+    else {                          //alarm 2 has no seconds register
+        writeRTC(ALM2_MINUTES, regs + 1, 3);
     }
-    writeRTC(addr++, minutes);
-    writeRTC(addr++, hours);
-    writeRTC(addr++, daydate);
 }
 
 /*----------------------------------------------------------------------*
@@ -306,14 +382,10 @@ boolean DS3232RTC::oscStopped(void)
  *----------------------------------------------------------------------*/
 int DS3232RTC::temperature(void)
 {
-    union int16_byte {
-        int i;
-        byte b[2];
-    } rtcTemp;
+    byte b[2];
     
-    rtcTemp.b[0] = readRTC(TEMP_LSB);
-    rtcTemp.b[1] = readRTC(TEMP_MSB);
-    return rtcTemp.i >> 6;
+    readRTC(TEMP_MSB, b, 2);        //MSB and LSB in one transfer, so they belong together
+    return (int16_t)(b[0] << 8 | b[1]) >> 6;
 }
 
 /*----------------------------------------------------------------------*
@@ -333,3 +405,126 @@ uint8_t __attribute__ ((noinline)) DS3232RTC::bcd2dec(uint8_t n)
 }
 
 DS3232RTC RTC = DS3232RTC();            //instantiate an RTC object
+
+/*----------------------------------------------------------------------*
+ * Alarm queue constructor. The queue starts out empty.                 *
+ *----------------------------------------------------------------------*/
+DS3232AlarmQueue::DS3232AlarmQueue()
+{
+    for (byte i = 0; i < RTC_EVENT_QUEUE_SIZE; i++) _events[i].callback = 0;
+}
+
+/*----------------------------------------------------------------------*
+ * Queue an event at time when, repeating every period seconds (zero    *
+ * for a one-shot event). Returns the event id that is passed to the    *
+ * callback, or -1 if the queue is full. Call service() afterwards to   *
+ * program the alarms.                                                  *
+ *----------------------------------------------------------------------*/
+int8_t DS3232AlarmQueue::add(time_t when, time_t period, rtcEventCallback_t callback)
+{
+    for (byte i = 0; i < RTC_EVENT_QUEUE_SIZE; i++) {
+        if (!_events[i].callback) {
+            _events[i].when = when;
+            _events[i].period = period;
+            _events[i].callback = callback;
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*----------------------------------------------------------------------*
+ * Removes an event from the queue.                                     *
+ *----------------------------------------------------------------------*/
+void DS3232AlarmQueue::remove(byte id)
+{
+    if (id < RTC_EVENT_QUEUE_SIZE) _events[id].callback = 0;
+}
+
+/*----------------------------------------------------------------------*
+ * Returns the time of the next event, or zero if the queue is empty.   *
+ *----------------------------------------------------------------------*/
+time_t DS3232AlarmQueue::next(void)
+{
+    int8_t i = earliest();
+    return i < 0 ? 0 : _events[i].when;
+}
+
+/*----------------------------------------------------------------------*
+ * Runs the callbacks of all events that are due, moves repeating       *
+ * events on by their period and arms the RTC for the next event. Call  *
+ * it after every wake-up from the INT pin (and once after adding       *
+ * events). On return the alarms are armed for an event that is still   *
+ * in the future, so it is safe to sleep on a LOW level of the INT pin. *
+ * Returns the number of callbacks that ran.                            *
+ *----------------------------------------------------------------------*/
+byte DS3232AlarmQueue::service(void)
+{
+    byte fired = 0;
+    int8_t i;
+    time_t t;
+
+    RTC.alarm(ALARM_1);                 //acknowledge, releases the INT pin
+    RTC.alarm(ALARM_2);
+    for (;;) {
+        t = RTC.get();
+        i = earliest();
+        if (i < 0) {                    //nothing queued, no alarms
+            RTC.alarmInterrupt(ALARM_1, false);
+            RTC.alarmInterrupt(ALARM_2, false);
+            return fired;
+        }
+        if (_events[i].when > t) {
+            arm(_events[i].when);
+            if (RTC.get() < _events[i].when) return fired;
+            continue;                   //the second ticked over while arming
+        }
+        rtcEventCallback_t callback = _events[i].callback;
+        if (_events[i].period) {
+            do {                        //skip any periods that were missed
+                _events[i].when += _events[i].period;
+            } while (_events[i].when <= t);
+        }
+        else {
+            _events[i].callback = 0;
+        }
+        callback(i);
+        fired++;
+    }
+}
+
+/*----------------------------------------------------------------------*
+ * Index of the queued event that is due first, -1 if there is none.    *
+ *----------------------------------------------------------------------*/
+int8_t DS3232AlarmQueue::earliest(void)
+{
+    int8_t first = -1;
+
+    for (byte i = 0; i < RTC_EVENT_QUEUE_SIZE; i++) {
+        if (_events[i].callback && (first < 0 || _events[i].when < _events[first].when)) first = i;
+    }
+    return first;
+}
+
+/*----------------------------------------------------------------------*
+ * Arms Alarm 1 for the exact second of the event and Alarm 2 for the   *
+ * start of the following minute. Alarm 2 is a backstop: a node that    *
+ * misses Alarm 1 (e.g. it was still busy when the alarm matched) wakes *
+ * up a minute later instead of sleeping forever. Alarms match on the   *
+ * date of the month, so events more than a month away cause an early,  *
+ * harmless wake-up that only re-arms the alarms.                       *
+ *----------------------------------------------------------------------*/
+void DS3232AlarmQueue::arm(time_t when)
+{
+    tmElements_t tm;
+
+    RTC.squareWave(SQWAVE_NONE);        //INT pin signals alarms
+    breakTime(when, tm);
+    RTC.setAlarm(ALM1_MATCH_DATE, tm.Second, tm.Minute, tm.Hour, tm.Day);
+    breakTime(when - tm.Second + SECS_PER_MIN, tm);
+    RTC.setAlarm(ALM2_MATCH_DATE, 0, tm.Minute, tm.Hour, tm.Day);
+    RTC.alarm(ALARM_1);
+    RTC.alarm(ALARM_2);
+    RTC.alarmInterrupt(ALARM_1, true);
+    RTC.alarmInterrupt(ALARM_2, true);
+}
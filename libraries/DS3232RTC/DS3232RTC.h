@@ -71,6 +71,22 @@
 #define SRAM_START_ADDR 0x14    //first SRAM address
 #define SRAM_SIZE 236           //number of bytes of SRAM
 
+//Wire transfers are limited by the Wire buffer, one byte of a write is the register address
+#define RTC_READ_CHUNK 32
+#define RTC_WRITE_CHUNK 31
+
+//With RTC_GET_CACHE set to 1, get() reads the RTC only when a second may
+//have passed, judged by millis(). millis() stops while the MCU sleeps, so
+//leave it off on sleeping nodes, get() would return the time before sleep.
+#ifndef RTC_GET_CACHE
+#define RTC_GET_CACHE 0
+#endif
+
+//margin (ms) of the get() cache for the tolerance of the MCU clock
+#ifndef RTC_GET_CACHE_MARGIN
+#define RTC_GET_CACHE_MARGIN 10
+#endif
+
 //Alarm mask bits
 #define A1M1 7
 #define A1M2 7
@@ -127,6 +143,13 @@ enum ALARM_TYPES_t {
 #define CENTURY 7                  //Century bit in Month register
 #define DYDT 6                     //Day/Date flag bit in alarm Day/Date registers
 
+//Alarm queue
+#ifndef RTC_EVENT_QUEUE_SIZE
+#define RTC_EVENT_QUEUE_SIZE 4     //number of events a DS3232AlarmQueue can hold
+#endif
+
+typedef void (*rtcEventCallback_t)(byte id);
+
 class DS3232RTC
 {
     public:
@@ -139,6 +162,8 @@ class DS3232RTC
         byte writeRTC(byte addr, byte value);
         byte readRTC(byte addr, byte *values, byte nBytes);
         byte readRTC(byte addr);
+        byte writeSRAM(byte offset, byte *values, byte nBytes);
+        byte readSRAM(byte offset, byte *values, byte nBytes);
         void setAlarm(ALARM_TYPES_t alarmType, byte seconds, byte minutes, byte hours, byte daydate);
         void setAlarm(ALARM_TYPES_t alarmType, byte minutes, byte hours, byte daydate);
         void alarmInterrupt(byte alarmNumber, boolean alarmEnabled);
@@ -154,4 +179,27 @@ class DS3232RTC
 
 extern DS3232RTC RTC;
 
+//Programs the RTC alarms for the earliest of a few queued events, so the
+//MCU can sleep on the INT pin between them. INT is a level shared by both
+//alarms, sleep on LOW, an alarm that is already pending gives no edge.
+class DS3232AlarmQueue
+{
+    public:
+        DS3232AlarmQueue();
+        int8_t add(time_t when, time_t period, rtcEventCallback_t callback);
+        void remove(byte id);
+        time_t next(void);
+        byte service(void);
+
+    private:
+        struct event_t {
+            time_t when;
+            time_t period;
+            rtcEventCallback_t callback;
+        };
+        event_t _events[RTC_EVENT_QUEUE_SIZE];
+        int8_t earliest(void);
+        void arm(time_t when);
+};
+
 #endif
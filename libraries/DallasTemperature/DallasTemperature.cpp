@@ -24,10 +24,21 @@ DallasTemperature::DallasTemperature(OneWire* _oneWire)
 {
     _wire = _oneWire;
     devices = 0;
+    _deviceTable = NULL;
     parasite = false;
     bitResolution = 9;
     waitForConversion = true;
     checkForConversion = true;
+    _scanAddress = NULL;
+    _scanTemp = NULL;
+    _scanCount = 0;
+    _scanPending = false;
+    _timeSource = millis;
+}
+
+DallasTemperature::~DallasTemperature()
+{
+    free(_deviceTable);
 }
 
 // initialise the bus
@@ -35,24 +46,67 @@ void DallasTemperature::begin(void)
 {
     DeviceAddress deviceAddress;
 
-    _wire->reset_search();
-    devices = 0; // Reset the number of devices when we enumerate wire devices
+    refreshDevices();
 
-    while (_wire->search(deviceAddress))
+    for (uint8_t i = 0; i < devices; i++)
     {
-        if (validAddress(deviceAddress))
+        if (getAddress(deviceAddress, i))
         {
             if (!parasite && readPowerSupply(deviceAddress)) parasite = true;
 
-            ScratchPad scratchPad;
+            bitResolution = max(bitResolution, getResolution(deviceAddress));
+        }
+    }
+}
 
-            readScratchPad(deviceAddress, scratchPad);
+// initialise the bus from a device table saved earlier, e.g. in EEPROM
+// every stored address is checked by reading the scratchpad of the device,
+// which also gives its resolution; if one does not answer, the table is
+// empty or cannot be allocated, the bus is searched as by begin()
+// devices added since the table was saved are only found by refreshDevices()
+bool DallasTemperature::begin(const DeviceAddress* stored, uint8_t count)
+{
+    uint8_t resolution = bitResolution;
+    bool valid = count > 0 && _wire->reset();
 
-            bitResolution = max(bitResolution, getResolution(deviceAddress));
+    for (uint8_t i = 0; valid && i < count; i++)
+    {
+        ScratchPad scratchPad;
+        valid = validAddress(stored[i]) && isConnected(stored[i], scratchPad);
+        if (valid) resolution = max(resolution, scratchPadResolution(stored[i], scratchPad));
+    }
 
-            devices++;
-        }
+    if (valid)
+    {
+        free(_deviceTable);
+        _deviceTable = (DeviceAddress*)malloc(count * sizeof(DeviceAddress));
+        valid = _deviceTable != NULL;
+    }
+    if (!valid)
+    {
+        begin();
+        return false;
     }
+
+    memcpy(_deviceTable, stored, count * sizeof(DeviceAddress));
+    devices = count;
+    bitResolution = resolution;
+
+    // one query for the whole bus, any parasite powered device pulls it low
+    _wire->reset();
+    _wire->skip();
+    _wire->write(READPOWERSUPPLY);
+    parasite = (_wire->read_bit() == 0);
+    _wire->reset();
+    return true;
+}
+
+// copies the device table, devices beyond it are searched for by getAddress()
+uint8_t DallasTemperature::getDeviceTable(DeviceAddress* table, uint8_t size)
+{
+    uint8_t count = 0;
+    while (count < devices && count < size && getAddress(table[count], count)) count++;
+    return count;
 }
 
 // returns the number of devices found on the bus
@@ -61,6 +115,46 @@ uint8_t DallasTemperature::getDeviceCount(void)
     return devices;
 }
 
+// searches the bus again and rebuilds the device table
+// the devices are counted first so the table is allocated in one piece;
+// if there is not enough memory getAddress() searches the bus as before
+uint8_t DallasTemperature::refreshDevices(void)
+{
+    DeviceAddress deviceAddress;
+    uint8_t count = 0;
+
+    _wire->reset_search();
+    while (_wire->search(deviceAddress))
+    {
+        if (validAddress(deviceAddress)) count++;
+    }
+
+    free(_deviceTable);
+    _deviceTable = NULL;
+    devices = count; // Reset the number of devices when we enumerate wire devices
+    if (count == 0) return 0;
+
+    _deviceTable = (DeviceAddress*)malloc(count * sizeof(DeviceAddress));
+    if (_deviceTable == NULL) return devices;
+
+    devices = 0;
+    _wire->reset_search();
+    while (devices < count && _wire->search(_deviceTable[devices]))
+    {
+        if (validAddress(_deviceTable[devices])) devices++;
+    }
+    return devices;
+}
+
+// rebuilds the device table if the presence pulse no longer matches it
+bool DallasTemperature::checkDevices(void)
+{
+    bool present = _wire->reset();
+    if (present == (devices > 0)) return false;
+    refreshDevices();
+    return true;
+}
+
 // returns true if address is valid
 bool DallasTemperature::validAddress(const uint8_t* deviceAddress)
 {
@@ -69,8 +163,16 @@ bool DallasTemperature::validAddress(const uint8_t* deviceAddress)
 
 // finds an address at a given index on the bus
 // returns true if the device was found
+// devices in the device table are returned without touching the bus,
+// any other index is searched for on the bus
 bool DallasTemperature::getAddress(uint8_t* deviceAddress, uint8_t index)
 {
+    if (_deviceTable != NULL && index < devices)
+    {
+        memcpy(deviceAddress, _deviceTable[index], sizeof(DeviceAddress));
+        return true;
+    }
+
     uint8_t depth = 0;
 
     _wire->reset_search();
@@ -259,22 +361,29 @@ uint8_t DallasTemperature::getResolution(const uint8_t* deviceAddress)
     if (deviceAddress[0] == DS18S20MODEL) return 12;
 
     ScratchPad scratchPad;
-    if (isConnected(deviceAddress, scratchPad))
+    if (isConnected(deviceAddress, scratchPad)) return scratchPadResolution(deviceAddress, scratchPad);
+    return 0;
+}
+
+// returns the resolution set in the scratchpad of a device, 0 if unknown
+uint8_t DallasTemperature::scratchPadResolution(const uint8_t* deviceAddress, const uint8_t* scratchPad)
+{
+    // DS1820 and DS18S20 have no resolution configuration register
+    if (deviceAddress[0] == DS18S20MODEL) return 12;
+
+    switch (scratchPad[CONFIGURATION])
     {
-        switch (scratchPad[CONFIGURATION])
-        {
-        case TEMP_12_BIT:
-            return 12;
+    case TEMP_12_BIT:
+        return 12;
 
-        case TEMP_11_BIT:
-            return 11;
+    case TEMP_11_BIT:
+        return 11;
 
-        case TEMP_10_BIT:
-            return 10;
+    case TEMP_10_BIT:
+        return 10;
 
-        case TEMP_9_BIT:
-            return 9;
-        }
+    case TEMP_9_BIT:
+        return 9;
     }
     return 0;
 }
@@ -391,6 +500,223 @@ bool DallasTemperature::requestTemperaturesByIndex(uint8_t deviceIndex)
     return requestTemperaturesByAddress(deviceAddress);
 }
 
+// Bus scan
+//
+// requestTemperatures() followed by getTempC() for every device blocks for
+// the whole conversion time and then searches for / addresses each device
+// again. The bus scan keeps the addresses in a table supplied by the caller,
+// lets the caller do other things (or sleep) during the conversion and then
+// reads all scratchpads in a single pass, checking only the CRC.
+//
+//   DeviceAddress addr[24];
+//   int16_t temp[24];
+//   sensors.setScanTable(addr, temp, 24);
+//   sensors.setTimeSource(nodeMillis);  // MySensors, millis() stops in sleep()
+//   sensors.startScan();
+//   sleep(sensors.scanMillisLeft());     // or poll isScanComplete()
+//   sensors.readScan();
+//   float t = sensors.getScanTempC(0);
+
+// sets the tables used by the bus scan and fills the address table with
+// the devices found on the bus, returns the number of devices stored
+// the addresses are copied from the device table when it is available
+uint8_t DallasTemperature::setScanTable(DeviceAddress* deviceAddress, int16_t* temperature, uint8_t size)
+{
+    _scanAddress = deviceAddress;
+    _scanTemp = temperature;
+    _scanCount = 0;
+    _scanPending = false;
+
+    if (_deviceTable != NULL)
+    {
+        while (_scanCount < size && _scanCount < devices)
+        {
+            memcpy(_scanAddress[_scanCount], _deviceTable[_scanCount], sizeof(DeviceAddress));
+            _scanTemp[_scanCount++] = DEVICE_DISCONNECTED_RAW;
+        }
+        return _scanCount;
+    }
+
+    _wire->reset_search();
+    while (_scanCount < size && _wire->search(_scanAddress[_scanCount]))
+    {
+        if (validAddress(_scanAddress[_scanCount]))
+        {
+            _scanTemp[_scanCount] = DEVICE_DISCONNECTED_RAW;
+            _scanCount++;
+        }
+    }
+    return _scanCount;
+}
+
+// sends command for all devices on the bus to perform a temperature
+// conversion and returns immediately, regardless of waitForConversion
+void DallasTemperature::startScan(void)
+{
+    _wire->reset();
+    _wire->skip();
+    _wire->write(STARTCONVO, parasite);
+    _scanStart = _timeSource();
+    _scanPending = true;
+}
+
+// returns true if the conversion started by startScan() has completed
+// Externally powered devices hold the bus low during read slots while they
+// are converting, so the bus is polled when checkForConversion is set; this
+// only works if the bus has not been used since startScan(). In parasite
+// mode the bus must not be touched and only the time is checked.
+bool DallasTemperature::isScanComplete(void)
+{
+    if (!_scanPending) return true;
+    if (scanMillisLeft() == 0 || (checkForConversion && !parasite && _wire->read_bit()))
+        _scanPending = false;
+    return !_scanPending;
+}
+
+// returns number of milliseconds until the scan can be read, 0 if ready
+uint16_t DallasTemperature::scanMillisLeft(void)
+{
+    if (!_scanPending) return 0;
+    unsigned long elapsed = _timeSource() - _scanStart;
+    unsigned long delms = millisToWaitForConversion(bitResolution);
+    return (elapsed >= delms) ? 0 : delms - elapsed;
+}
+
+// millis() stops while the MCU is powered down, so a node that sleeps for
+// scanMillisLeft() would never see the conversion time pass without a
+// clock that counts the time spent asleep
+void DallasTemperature::setTimeSource(unsigned long (*source)(void))
+{
+    _timeSource = source;
+}
+
+// reads all devices in the scan table in one pass, returns the number
+// of valid readings or 0 if the conversion has not completed yet
+// entries whose scratchpad fails the CRC are set to DEVICE_DISCONNECTED_RAW
+uint8_t DallasTemperature::readScan(void)
+{
+    if (!isScanComplete()) return 0;
+
+    uint8_t valid = 0;
+    ScratchPad scratchPad;
+    for (uint8_t i = 0; i < _scanCount; i++)
+    {
+        _wire->reset();
+        _wire->select(_scanAddress[i]);
+        _wire->write(READSCRATCH);
+        // the CRC over the scratchpad including its CRC byte is 0
+        if (_wire->read_bytes_crc8(scratchPad, sizeof(ScratchPad)) == 0)
+        {
+            _scanTemp[i] = calculateTemperature(_scanAddress[i], scratchPad);
+            valid++;
+        }
+        else _scanTemp[i] = DEVICE_DISCONNECTED_RAW;
+    }
+    _wire->reset();
+    return valid;
+}
+
+// returns raw temperature of a scan table entry (1/128 degrees C)
+// or DEVICE_DISCONNECTED_RAW if the entry is invalid
+int16_t DallasTemperature::getScanTemp(uint8_t index)
+{
+    if (index >= _scanCount) return DEVICE_DISCONNECTED_RAW;
+    return _scanTemp[index];
+}
+
+// returns temperature of a scan table entry in degrees C
+// or DEVICE_DISCONNECTED_C if the entry is invalid
+float DallasTemperature::getScanTempC(uint8_t index)
+{
+    return rawToCelsius(getScanTemp(index));
+}
+
+// Bus group
+//
+// With sensors spread over several buses every requestTemperatures() waits
+// for its own conversion. The group starts the conversion (Skip ROM +
+// Convert T) on all buses back to back, so they convert at the same time,
+// then waits once for the longest resolution and reads all buses.
+//
+//   DallasTemperature* buses[] = { &sensors1, &sensors2, &sensors3 };
+//   DallasTemperatureGroup group(buses, 3);
+//   group.scan();                        // uses the scan table of each bus
+//   float t = sensors2.getScanTempC(0);
+
+DallasTemperatureGroup::DallasTemperatureGroup(DallasTemperature** buses, uint8_t count)
+{
+    _buses = buses;
+    _busCount = count;
+}
+
+uint8_t DallasTemperatureGroup::getBusCount(void)
+{
+    return _busCount;
+}
+
+DallasTemperature* DallasTemperatureGroup::getBus(uint8_t index)
+{
+    if (index >= _busCount) return NULL;
+    return _buses[index];
+}
+
+// the buses may be read with getTempC() et al afterwards, regardless of
+// their waitForConversion flag
+void DallasTemperatureGroup::requestTemperatures(void)
+{
+    startScan();
+    while (!isScanComplete());
+}
+
+void DallasTemperatureGroup::startScan(void)
+{
+    for (uint8_t i = 0; i < _busCount; i++)
+        _buses[i]->startScan();
+}
+
+// each bus is checked as in DallasTemperature::isScanComplete(), so
+// externally powered buses may finish before their resolution time
+bool DallasTemperatureGroup::isScanComplete(void)
+{
+    bool complete = true;
+    for (uint8_t i = 0; i < _busCount; i++)
+        if (!_buses[i]->isScanComplete()) complete = false;
+    return complete;
+}
+
+uint16_t DallasTemperatureGroup::scanMillisLeft(void)
+{
+    uint16_t left = 0;
+    for (uint8_t i = 0; i < _busCount; i++)
+    {
+        uint16_t busLeft = _buses[i]->scanMillisLeft();
+        if (busLeft > left) left = busLeft;
+    }
+    return left;
+}
+
+void DallasTemperatureGroup::setTimeSource(unsigned long (*source)(void))
+{
+    for (uint8_t i = 0; i < _busCount; i++)
+        _buses[i]->setTimeSource(source);
+}
+
+uint8_t DallasTemperatureGroup::readScan(void)
+{
+    if (!isScanComplete()) return 0;
+
+    uint8_t valid = 0;
+    for (uint8_t i = 0; i < _busCount; i++)
+        valid += _buses[i]->readScan();
+    return valid;
+}
+
+uint8_t DallasTemperatureGroup::scan(void)
+{
+    requestTemperatures();
+    return readScan();
+}
+
 // Fetch temperature for device index
 float DallasTemperature::getTempCByIndex(uint8_t deviceIndex)
 {
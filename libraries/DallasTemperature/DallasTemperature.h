@@ -65,12 +65,32 @@ class DallasTemperature
   public:
 
   DallasTemperature(OneWire*);
+  ~DallasTemperature();
 
   // initialise bus
   void begin(void);
 
+  // initialise bus from a device table saved earlier (see getDeviceTable()),
+  // searches the bus only if a stored device does not answer,
+  // returns true if the stored table was taken
+  bool begin(const DeviceAddress*, uint8_t);
+
+  // copies up to the given number of entries of the device table,
+  // e.g. to save them for begin(const DeviceAddress*, uint8_t),
+  // returns the number of addresses copied
+  uint8_t getDeviceTable(DeviceAddress*, uint8_t);
+
   // returns the number of devices found on the bus
   uint8_t getDeviceCount(void);
+
+  // searches the bus again and rebuilds the device table,
+  // returns the number of devices found
+  uint8_t refreshDevices(void);
+
+  // rebuilds the device table if the presence pulse shows that devices
+  // appeared on an empty bus or that the bus became empty,
+  // returns true if the table was rebuilt
+  bool checkDevices(void);
   
   // returns true if address is valid
   bool validAddress(const uint8_t*);
@@ -135,10 +155,10 @@ class DallasTemperature
   // returns temperature in degrees F
   float getTempF(const uint8_t*);
 
-  // Get temperature for device index (slow)
+  // Get temperature for device index
   float getTempCByIndex(uint8_t);
   
-  // Get temperature for device index (slow)
+  // Get temperature for device index
   float getTempFByIndex(uint8_t);
   
   // returns true if the bus requires parasite power
@@ -146,6 +166,34 @@ class DallasTemperature
   
   bool isConversionAvailable(const uint8_t*);
 
+  // sets the tables used by the bus scan and fills the address table with
+  // the devices found on the bus, returns the number of devices stored
+  uint8_t setScanTable(DeviceAddress*, int16_t*, uint8_t);
+
+  // sends command for all devices on the bus to perform a temperature
+  // conversion and returns immediately
+  void startScan(void);
+
+  // returns true if the conversion started by startScan() has completed
+  bool isScanComplete(void);
+
+  // returns number of milliseconds until the scan can be read, 0 if ready
+  uint16_t scanMillisLeft(void);
+
+  // sets the clock startScan() and scanMillisLeft() use instead of millis(),
+  // e.g. MySensors nodeMillis() which keeps counting while the node sleeps
+  void setTimeSource(unsigned long (*)(void));
+
+  // reads all devices in the scan table in one pass, returns the number
+  // of valid readings or 0 if the conversion has not completed yet
+  uint8_t readScan(void);
+
+  // returns raw temperature of a scan table entry (1/128 degrees C)
+  int16_t getScanTemp(uint8_t);
+
+  // returns temperature of a scan table entry in degrees C
+  float getScanTempC(uint8_t);
+
   #if REQUIRESALARMS
   
   typedef void AlarmHandler(const uint8_t*);
@@ -229,10 +277,27 @@ class DallasTemperature
   
   // count of devices on the bus
   uint8_t devices;
+
+  // addresses of the devices found by refreshDevices(), used by
+  // getAddress() and the other by-index functions
+  DeviceAddress* _deviceTable;
   
   // Take a pointer to one wire instance
   OneWire* _wire;
 
+  // tables used by the bus scan, provided by setScanTable()
+  DeviceAddress* _scanAddress;
+  int16_t* _scanTemp;
+  uint8_t _scanCount;
+
+  // true while a conversion started by startScan() is running
+  bool _scanPending;
+  unsigned long _scanStart;
+  unsigned long (*_timeSource)(void);
+
+  // returns the resolution in the scratchpad of a device, 0 if unknown
+  static uint8_t scratchPadResolution(const uint8_t*, const uint8_t*);
+
   // reads scratchpad and returns the raw temperature
   int16_t calculateTemperature(const uint8_t*, uint8_t*);
   
@@ -250,5 +315,50 @@ class DallasTemperature
 
   #endif
   
+};
+
+// Converts on several buses at once: the conversion is started on every
+// bus back to back and the wait is paid once, for the slowest bus
+class DallasTemperatureGroup
+{
+  public:
+
+  DallasTemperatureGroup(DallasTemperature**, uint8_t);
+
+  // returns the number of buses in the group
+  uint8_t getBusCount(void);
+
+  // returns a bus of the group, NULL if the index is out of range
+  DallasTemperature* getBus(uint8_t);
+
+  // sends command for all devices on all buses to perform a temperature
+  // conversion and blocks until the slowest bus has completed
+  void requestTemperatures(void);
+
+  // sends command for all devices on all buses to perform a temperature
+  // conversion and returns immediately
+  void startScan(void);
+
+  // returns true if the conversions on all buses have completed
+  bool isScanComplete(void);
+
+  // returns number of milliseconds until all buses can be read, 0 if ready
+  uint16_t scanMillisLeft(void);
+
+  // sets the clock of all buses, see DallasTemperature::setTimeSource()
+  void setTimeSource(unsigned long (*)(void));
+
+  // reads the scan tables of all buses, returns the number of valid
+  // readings or 0 if the conversion has not completed yet
+  uint8_t readScan(void);
+
+  // requestTemperatures() followed by readScan()
+  uint8_t scan(void);
+
+  private:
+
+  DallasTemperature** _buses;
+  uint8_t _busCount;
+
 };
 #endif
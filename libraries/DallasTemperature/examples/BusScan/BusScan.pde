@@ -0,0 +1,56 @@
+//
+// Sample of reading many sensors with the asynchronous bus scan
+//
+#include <OneWire.h>
+#include <DallasTemperature.h>
+
+// Data wire is plugged into port 2 on the Arduino
+#define ONE_WIRE_BUS 2
+#define MAX_SENSORS 24
+
+// Setup a oneWire instance to communicate with any OneWire devices (not just Maxim/Dallas temperature ICs)
+OneWire oneWire(ONE_WIRE_BUS);
+
+// Pass our oneWire reference to Dallas Temperature. 
+DallasTemperature sensors(&oneWire);
+
+// addresses and readings of the sensors, filled by the library
+DeviceAddress sensorAddress[MAX_SENSORS];
+int16_t sensorTemp[MAX_SENSORS];
+uint8_t numSensors = 0;
+
+void setup(void)
+{
+  Serial.begin(9600);
+  Serial.println("Dallas Temperature Control Library - Bus Scan Demo");
+
+  sensors.begin();
+  // search the bus once, the addresses are kept in sensorAddress
+  numSensors = sensors.setScanTable(sensorAddress, sensorTemp, MAX_SENSORS);
+  Serial.print("Found ");
+  Serial.print(numSensors);
+  Serial.println(" sensors");
+
+  // start the first conversion
+  sensors.startScan();
+}
+
+void loop(void)
+{
+  // we can do useful things (or sleep for sensors.scanMillisLeft(), with
+  // sensors.setTimeSource(nodeMillis) on a MySensors node) here
+  if (!sensors.isScanComplete()) return;
+
+  // read all sensors in one pass
+  sensors.readScan();
+  for (uint8_t i = 0; i < numSensors; i++)
+  {
+    Serial.print("Sensor ");
+    Serial.print(i);
+    Serial.print(": ");
+    Serial.println(sensors.getScanTempC(i));
+  }
+
+  // immediately start the next conversion
+  sensors.startScan();
+}
@@ -0,0 +1,67 @@
+//
+// Sample of reading sensors on several buses with one conversion wait
+//
+#include <OneWire.h>
+#include <DallasTemperature.h>
+
+// Data wires of the buses are plugged into port 2 to 5 on the Arduino
+#define BUSES 4
+#define MAX_SENSORS 8
+
+OneWire oneWire[BUSES] = { OneWire(2), OneWire(3), OneWire(4), OneWire(5) };
+
+DallasTemperature sensors[BUSES] = {
+  DallasTemperature(&oneWire[0]), DallasTemperature(&oneWire[1]),
+  DallasTemperature(&oneWire[2]), DallasTemperature(&oneWire[3])
+};
+
+DallasTemperature* buses[BUSES] = { &sensors[0], &sensors[1], &sensors[2], &sensors[3] };
+
+// converts on all buses at the same time
+DallasTemperatureGroup group(buses, BUSES);
+
+// addresses and readings of the sensors, filled by the library
+DeviceAddress sensorAddress[BUSES][MAX_SENSORS];
+int16_t sensorTemp[BUSES][MAX_SENSORS];
+uint8_t numSensors[BUSES];
+
+void setup(void)
+{
+  Serial.begin(9600);
+  Serial.println("Dallas Temperature Control Library - Multiple Buses Demo");
+
+  for (uint8_t bus = 0; bus < BUSES; bus++)
+  {
+    sensors[bus].begin();
+    numSensors[bus] = sensors[bus].setScanTable(sensorAddress[bus], sensorTemp[bus], MAX_SENSORS);
+    Serial.print("Bus ");
+    Serial.print(bus);
+    Serial.print(": ");
+    Serial.print(numSensors[bus]);
+    Serial.println(" sensors");
+  }
+}
+
+void loop(void)
+{
+  // one conversion wait for all buses, then read them all
+  unsigned long start = millis();
+  group.scan();
+  Serial.print("All buses read in ");
+  Serial.print(millis() - start);
+  Serial.println(" ms");
+
+  for (uint8_t bus = 0; bus < BUSES; bus++)
+  {
+    for (uint8_t i = 0; i < numSensors[bus]; i++)
+    {
+      Serial.print("Bus ");
+      Serial.print(bus);
+      Serial.print(" sensor ");
+      Serial.print(i);
+      Serial.print(": ");
+      Serial.println(sensors[bus].getScanTempC(i));
+    }
+  }
+  delay(1000);
+}
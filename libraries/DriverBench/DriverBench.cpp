@@ -0,0 +1,147 @@
+#include "DriverBench.h"
+
+#ifdef DRIVER_BENCH_PROBE
+
+#if defined(__AVR__)
+// Timer0 overflows every 64 * 256 cycles, the compare match follows it
+#define DRIVER_BENCH_PROBE_US (16384000UL / (F_CPU / 1000))
+#else
+#define DRIVER_BENCH_PROBE_US 1000
+#endif
+
+static volatile bool _probeOn = false;
+static volatile unsigned long _probeLast;
+// worst lateness of the probe since the last begin()
+static volatile unsigned long _probeLate;
+
+static inline void probeTick(void) {
+  unsigned long now = micros();
+  unsigned long gap = now - _probeLast;
+  _probeLast = now;
+  if (gap > DRIVER_BENCH_PROBE_US && gap - DRIVER_BENCH_PROBE_US > _probeLate) {
+    _probeLate = gap - DRIVER_BENCH_PROBE_US;
+  }
+}
+
+#if defined(__AVR__)
+ISR(TIMER0_COMPA_vect) {
+  probeTick();
+}
+#else
+// called by the SysTick handler of the core, 0 lets it go on with the tick
+extern "C" int sysTickHook(void) {
+  if (_probeOn) probeTick();
+  return 0;
+}
+#endif
+
+#endif
+
+DriverBench::DriverBench() {
+  clear();
+}
+
+void DriverBench::startProbe(void) {
+#ifdef DRIVER_BENCH_PROBE
+  noInterrupts();
+  _probeLast = micros();
+  _probeLate = 0;
+  _probeOn = true;
+#if defined(__AVR__)
+  // OCR0A stays as it is, analogWrite() on its pin keeps working
+  TIFR0 = _BV(OCF0A);
+  TIMSK0 |= _BV(OCIE0A);
+#endif
+  interrupts();
+#endif
+}
+
+void DriverBench::stopProbe(void) {
+#ifdef DRIVER_BENCH_PROBE
+#if defined(__AVR__)
+  TIMSK0 &= ~_BV(OCIE0A);
+#endif
+  _probeOn = false;
+#endif
+}
+
+void DriverBench::begin(void) {
+#ifdef DRIVER_BENCH_PROBE
+  noInterrupts();
+  _probeLate = 0;
+  interrupts();
+#endif
+  _start = micros();
+}
+
+void DriverBench::end(void) {
+  uint32_t time = micros() - _start;
+#ifdef DRIVER_BENCH_PROBE
+  noInterrupts();
+  uint32_t late = _probeLate;
+  interrupts();
+  if (late > _irqOff) _irqOff = late;
+#endif
+
+  // keep a uniform sample of all calls for the percentiles
+  if (_calls < DRIVER_BENCH_SAMPLES) {
+    _samples[_calls] = time;
+  } else {
+    uint32_t i = random(_calls + 1);
+    if (i < DRIVER_BENCH_SAMPLES) _samples[i] = time;
+  }
+  _calls++;
+  _sum += time;
+  if (time > _worst) _worst = time;
+}
+
+void DriverBench::clear(void) {
+  _calls = 0;
+  _sum = 0;
+  _worst = 0;
+  _irqOff = 0;
+}
+
+uint32_t DriverBench::mean(void) {
+  return _calls ? _sum / _calls : 0;
+}
+
+// nearest rank of the kept samples, reorders them
+uint32_t DriverBench::percentile(uint8_t p) {
+  uint16_t n = _calls < DRIVER_BENCH_SAMPLES ? _calls : DRIVER_BENCH_SAMPLES;
+  if (n == 0) return 0;
+  uint16_t rank = ((uint32_t)p * n + 99) / 100;
+  if (rank == 0) rank = 1;
+
+  // partial selection sort from the top, p99 needs few passes
+  for (uint16_t i = n - 1; i >= rank - 1; i--) {
+    uint16_t top = 0;
+    for (uint16_t j = 1; j <= i; j++) {
+      if (_samples[j] > _samples[top]) top = j;
+    }
+    uint32_t t = _samples[top];
+    _samples[top] = _samples[i];
+    _samples[i] = t;
+    if (i == 0) break;
+  }
+  return _samples[rank - 1];
+}
+
+void DriverBench::report(Print &out, const __FlashStringHelper *name) {
+  out.print(name);
+  out.print(F(": calls="));
+  out.print(_calls);
+  out.print(F(" mean="));
+  out.print(mean());
+  out.print(F("us p99="));
+  out.print(percentile(99));
+  out.print(F("us worst="));
+  out.print(_worst);
+#ifdef DRIVER_BENCH_PROBE
+  out.print(F("us irqoff="));
+  out.print(_irqOff);
+  out.println(F("us"));
+#else
+  out.println(F("us irqoff=-"));
+#endif
+}
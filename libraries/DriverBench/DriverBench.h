@@ -0,0 +1,80 @@
+/*
+
+Blocking time of driver calls.
+
+BENCH_CALL(bench, call) times a call with micros() and adds it to the
+statistics of a DriverBench: number of calls, mean, p99 and worst time.
+report() prints them in one line, so runs of different versions of a
+driver can be compared.
+
+startProbe() also measures how long interrupts were disabled during the
+calls. A periodic interrupt (the Timer0 compare match on AVR, next to the
+millis() tick, the SysTick on SAM and SAMD) notes how late it runs, the
+worst lateness during a call is its interrupt disabled time. The probe
+runs about once per ms, a shorter disabled stretch is only seen if it
+spans a probe interrupt, over many calls that catches the longest ones.
+Other interrupts in the sketch add to it, a few us of it is the probe
+itself and the resolution of micros(). Not available on other targets.
+
+Only one call can be timed at a time.
+
+*/
+
+#ifndef DriverBench_h
+#define DriverBench_h
+
+#if (ARDUINO >= 100)
+#include <Arduino.h>
+#else
+#include <WProgram.h>
+#endif
+
+// calls a DriverBench keeps for the p99, the others count in mean and worst
+#ifndef DRIVER_BENCH_SAMPLES
+#if defined(__AVR__)
+#define DRIVER_BENCH_SAMPLES 64
+#else
+#define DRIVER_BENCH_SAMPLES 512
+#endif
+#endif
+
+#if defined(__AVR__) || defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_SAM)
+#define DRIVER_BENCH_PROBE
+#endif
+
+#define BENCH_CALL(bench, call) do { (bench).begin(); call; (bench).end(); } while (0)
+
+class DriverBench {
+ public:
+  DriverBench();
+
+  // start and stop measuring the interrupt disabled time
+  static void startProbe(void);
+  static void stopProbe(void);
+
+  // around the timed call, see BENCH_CALL()
+  void begin(void);
+  void end(void);
+
+  void clear(void);
+
+  uint32_t calls(void) { return _calls; }
+  // in us
+  uint32_t mean(void);
+  uint32_t worst(void) { return _worst; }
+  uint32_t percentile(uint8_t p);
+  uint32_t irqOff(void) { return _irqOff; }
+
+  // prints "name: calls=.. mean=..us p99=..us worst=..us irqoff=..us"
+  void report(Print &out, const __FlashStringHelper *name);
+
+ private:
+  uint32_t _samples[DRIVER_BENCH_SAMPLES];
+  uint32_t _calls;
+  uint64_t _sum;
+  uint32_t _worst;
+  uint32_t _irqOff;
+  unsigned long _start;
+};
+
+#endif
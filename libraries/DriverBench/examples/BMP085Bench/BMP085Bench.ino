@@ -0,0 +1,30 @@
+/*
+  Blocking time of Adafruit_BMP085: readTemperature() and readPressure(),
+  which measures the temperature first, at the resolution of begin().
+*/
+
+#include <Wire.h>
+#include <Adafruit_BMP085.h>
+#include <DriverBench.h>
+
+#define RUNS 50
+
+Adafruit_BMP085 bmp;
+
+DriverBench temperature;
+DriverBench pressure;
+
+void setup() {
+  Serial.begin(115200);
+  bmp.begin(BMP085_ULTRAHIGHRES);
+  DriverBench::startProbe();
+}
+
+void loop() {
+  for (int i = 0; i < RUNS; i++) {
+    BENCH_CALL(temperature, bmp.readTemperature());
+    BENCH_CALL(pressure, bmp.readPressure());
+  }
+  temperature.report(Serial, F("Adafruit_BMP085::readTemperature"));
+  pressure.report(Serial, F("Adafruit_BMP085::readPressure"));
+}
@@ -0,0 +1,37 @@
+/*
+  Blocking time of a DHT reading: getTemperature() reads the sensor
+  (DHT::readSensor()), startRead() only sends the start signal and the
+  response is captured by the interrupt.
+*/
+
+#include <DHT.h>
+#include <DriverBench.h>
+
+#define DHT_DATA_PIN 3
+#define RUNS 10
+
+DHT dht;
+
+DriverBench readSensor;
+DriverBench startRead;
+
+void setup() {
+  Serial.begin(115200);
+  dht.setup(DHT_DATA_PIN);
+  DriverBench::startProbe();
+}
+
+void loop() {
+  for (int i = 0; i < RUNS; i++) {
+    delay(dht.getMinimumSamplingPeriod());
+    dht.resetTimer();
+    BENCH_CALL(readSensor, dht.getTemperature());
+
+    delay(dht.getMinimumSamplingPeriod());
+    dht.resetTimer();
+    BENCH_CALL(startRead, dht.startRead());
+    while (!dht.isReady());
+  }
+  readSensor.report(Serial, F("DHT::readSensor"));
+  startRead.report(Serial, F("DHT::startRead"));
+}
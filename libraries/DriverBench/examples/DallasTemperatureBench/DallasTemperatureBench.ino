@@ -0,0 +1,37 @@
+/*
+  Blocking time of DallasTemperature: requestTemperatures() waiting for
+  the conversion, then reading one sensor by index and by address.
+*/
+
+#include <OneWire.h>
+#include <DallasTemperature.h>
+#include <DriverBench.h>
+
+#define ONE_WIRE_BUS 3
+#define RUNS 20
+
+OneWire oneWire(ONE_WIRE_BUS);
+DallasTemperature sensors(&oneWire);
+DeviceAddress address;
+
+DriverBench request;
+DriverBench byIndex;
+DriverBench byAddress;
+
+void setup() {
+  Serial.begin(115200);
+  sensors.begin();
+  sensors.getAddress(address, 0);
+  DriverBench::startProbe();
+}
+
+void loop() {
+  for (int i = 0; i < RUNS; i++) {
+    BENCH_CALL(request, sensors.requestTemperatures());
+    BENCH_CALL(byIndex, sensors.getTempCByIndex(0));
+    BENCH_CALL(byAddress, sensors.getTempC(address));
+  }
+  request.report(Serial, F("DallasTemperature::requestTemperatures"));
+  byIndex.report(Serial, F("DallasTemperature::getTempCByIndex"));
+  byAddress.report(Serial, F("DallasTemperature::getTempC"));
+}
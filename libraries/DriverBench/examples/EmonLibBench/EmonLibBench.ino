@@ -0,0 +1,30 @@
+/*
+  Blocking time of EnergyMonitor::calcVI() over 20 half wavelengths and
+  of calcIrms() over 1480 samples.
+*/
+
+#include <EmonLib.h>
+#include <DriverBench.h>
+
+#define RUNS 20
+
+EnergyMonitor emon;
+
+DriverBench calcVI;
+DriverBench calcIrms;
+
+void setup() {
+  Serial.begin(115200);
+  emon.voltage(2, 234.26, 1.7);
+  emon.current(1, 111.1);
+  DriverBench::startProbe();
+}
+
+void loop() {
+  for (int i = 0; i < RUNS; i++) {
+    BENCH_CALL(calcVI, emon.calcVI(20, 2000));
+    BENCH_CALL(calcIrms, emon.calcIrms(1480));
+  }
+  calcVI.report(Serial, F("EnergyMonitor::calcVI"));
+  calcIrms.report(Serial, F("EnergyMonitor::calcIrms"));
+}
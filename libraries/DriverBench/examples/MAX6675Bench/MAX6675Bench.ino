@@ -0,0 +1,32 @@
+/*
+  Blocking time of MAX6675::read_temp(). Forced reads access the chip
+  every time, the others only once per conversion.
+*/
+
+#include <MAX6675.h>
+#include <DriverBench.h>
+
+#define CS_PIN 10
+#define SO_PIN 12
+#define SCK_PIN 13
+#define RUNS 50
+
+MAX6675 thermocouple(CS_PIN, SO_PIN, SCK_PIN, 1);
+
+DriverBench forced;
+DriverBench cached;
+
+void setup() {
+  Serial.begin(115200);
+  DriverBench::startProbe();
+}
+
+void loop() {
+  for (int i = 0; i < RUNS; i++) {
+    delay(MAX6675_CONVERSION_TIME);
+    BENCH_CALL(forced, thermocouple.read_temp(true));
+    BENCH_CALL(cached, thermocouple.read_temp());
+  }
+  forced.report(Serial, F("MAX6675::read_temp(true)"));
+  cached.report(Serial, F("MAX6675::read_temp"));
+}
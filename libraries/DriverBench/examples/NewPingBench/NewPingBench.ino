@@ -0,0 +1,32 @@
+/*
+  Blocking time of NewPing: one ping() and ping_median() over 5 pings,
+  which waits PING_MEDIAN_DELAY ms between them.
+*/
+
+#include <NewPing.h>
+#include <DriverBench.h>
+
+#define TRIGGER_PIN 12
+#define ECHO_PIN 11
+#define MAX_DISTANCE 200
+#define RUNS 20
+
+NewPing sonar(TRIGGER_PIN, ECHO_PIN, MAX_DISTANCE);
+
+DriverBench ping;
+DriverBench median;
+
+void setup() {
+  Serial.begin(115200);
+  DriverBench::startProbe();
+}
+
+void loop() {
+  for (int i = 0; i < RUNS; i++) {
+    BENCH_CALL(ping, sonar.ping());
+    delay(PING_MEDIAN_DELAY);
+    BENCH_CALL(median, sonar.ping_median(5));
+  }
+  ping.report(Serial, F("NewPing::ping"));
+  median.report(Serial, F("NewPing::ping_median(5)"));
+}
@@ -0,0 +1,35 @@
+/*
+  Blocking time of UTouch: dataAvailable() and read(), touch the panel
+  while it runs. Pins as in the UTouch examples for an Arduino Mega.
+*/
+
+#include <UTouch.h>
+#include <DriverBench.h>
+
+#define RUNS 200
+
+UTouch touch(6, 5, 4, 3, 2);
+
+DriverBench touchAvailable;
+DriverBench touchRead;
+
+void setup() {
+  Serial.begin(115200);
+  touch.InitTouch();
+  touch.setPrecision(PREC_MEDIUM);
+  DriverBench::startProbe();
+}
+
+void loop() {
+  uint16_t n = 0;
+  while (n < RUNS) {
+    bool touched;
+    BENCH_CALL(touchAvailable, touched = touch.dataAvailable());
+    if (touched) {
+      BENCH_CALL(touchRead, touch.read());
+      n++;
+    }
+  }
+  touchAvailable.report(Serial, F("UTouch::dataAvailable"));
+  touchRead.report(Serial, F("UTouch::read"));
+}
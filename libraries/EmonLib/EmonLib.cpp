@@ -67,6 +67,10 @@ void EnergyMonitor::calcVI(int crossings, int timeout)
 	int SUPPLYVOLTAGE = readVcc();
    #endif
 
+   #if EMONLIB_FIXED_POINT
+  fixPhaseCal = PHASECAL * 256;
+   #endif
+
   int crossCount = 0;                             //Used to measure number of times threshold is crossed.
   int numberOfSamples = 0;                        //This is now incremented  
 
@@ -93,11 +97,13 @@ void EnergyMonitor::calcVI(int crossings, int timeout)
   {
     numberOfSamples++;                            //Count number of times looped.
 
+   #if !EMONLIB_FIXED_POINT
     lastSampleV=sampleV;                          //Used for digital high pass filter
     lastSampleI=sampleI;                          //Used for digital high pass filter
     
     lastFilteredV = filteredV;                    //Used for offset removal
     lastFilteredI = filteredI;                    //Used for offset removal   
+   #endif
     
     //-----------------------------------------------------------------------------
     // A) Read in raw voltage and current samples
@@ -105,6 +111,14 @@ void EnergyMonitor::calcVI(int crossings, int timeout)
     sampleV = analogRead(inPinV);                 //Read in raw voltage signal
     sampleI = analogRead(inPinI);                 //Read in raw current signal
 
+   #if EMONLIB_FIXED_POINT
+    //-----------------------------------------------------------------------------
+    // B) to F) in fixed point
+    //-----------------------------------------------------------------------------
+    fixSampleV(sampleV);
+    fixSampleI(sampleI);
+    fixAccumulate(true);
+   #else
     //-----------------------------------------------------------------------------
     // B) Apply digital high pass filters to remove 2.5V DC offset (centered on 0V).
     //-----------------------------------------------------------------------------
@@ -133,6 +147,7 @@ void EnergyMonitor::calcVI(int crossings, int timeout)
     //-----------------------------------------------------------------------------   
     instP = phaseShiftedV * filteredI;          //Instantaneous Power
     sumP +=instP;                               //Sum  
+   #endif
     
     //-----------------------------------------------------------------------------
     // G) Find the number of times the voltage has crossed the initial voltage
@@ -153,6 +168,9 @@ void EnergyMonitor::calcVI(int crossings, int timeout)
   //Calculation of the root of the mean of the voltage and current squared (rms)
   //Calibration coeficients applied. 
   
+   #if EMONLIB_FIXED_POINT
+  fixResults(SUPPLYVOLTAGE, numberOfSamples, true);
+   #else
   double V_RATIO = VCAL *((SUPPLYVOLTAGE/1000.0) / (ADC_COUNTS));
   Vrms = V_RATIO * sqrt(sumV / numberOfSamples); 
   
@@ -168,6 +186,7 @@ void EnergyMonitor::calcVI(int crossings, int timeout)
   sumV = 0;
   sumI = 0;
   sumP = 0;
+   #endif
 //--------------------------------------------------------------------------------------       
 }
 
@@ -184,6 +203,10 @@ double EnergyMonitor::calcIrms(int NUMBER_OF_SAMPLES)
   
   for (int n = 0; n < NUMBER_OF_SAMPLES; n++)
   {
+   #if EMONLIB_FIXED_POINT
+    fixSampleI(analogRead(inPinI));
+    fixAccumulate(false);
+   #else
     lastSampleI = sampleI;
     sampleI = analogRead(inPinI);
     lastFilteredI = filteredI;
@@ -194,13 +217,18 @@ double EnergyMonitor::calcIrms(int NUMBER_OF_SAMPLES)
     sqI = filteredI * filteredI;
     // 2) sum 
     sumI += sqI;
+   #endif
   }
 
+   #if EMONLIB_FIXED_POINT
+  fixResults(SUPPLYVOLTAGE, NUMBER_OF_SAMPLES, false);
+   #else
   double I_RATIO = ICAL *((SUPPLYVOLTAGE/1000.0) / (ADC_COUNTS));
   Irms = I_RATIO * sqrt(sumI / NUMBER_OF_SAMPLES); 
 
   //Reset accumulators
   sumI = 0;
+   #endif
 //--------------------------------------------------------------------------------------       
  
   return Irms;
@@ -257,3 +285,346 @@ long EnergyMonitor::readVcc() {
  #endif
 }
 
+
+#if EMONLIB_USE_ISR || EMONLIB_FIXED_POINT || EMONLIB_MULTI_CHANNEL
+//--------------------------------------------------------------------------------------
+// Fixed point sample processing, same steps as the floating point code in calcVI():
+// the 0.996 high pass filter becomes a 1/256 decay of a Q16 value and the sums are
+// taken over the Q4 parts, with the scaling undone in fixResults().
+//--------------------------------------------------------------------------------------
+inline void EnergyMonitor::fixSampleV(int sample)
+{
+  fixLastV = fixFilteredV >> 12;
+  fixFilteredV += (long)(sample - fixLastSampleV) << 16;
+  fixFilteredV -= fixFilteredV >> 8;
+  fixLastSampleV = sample;
+}
+
+inline void EnergyMonitor::fixSampleI(int sample)
+{
+  fixFilteredI += (long)(sample - fixLastSampleI) << 16;
+  fixFilteredI -= fixFilteredI >> 8;
+  fixLastSampleI = sample;
+}
+
+inline void EnergyMonitor::fixAccumulate(boolean withVoltage)
+{
+  int filtI = fixFilteredI >> 12;
+  fixSumI += (long)filtI * filtI;
+  if (!withVoltage) return;
+
+  int filtV = fixFilteredV >> 12;
+  fixSumV += (long)filtV * filtV;
+  long shiftedV = fixLastV + (((long)fixPhaseCal * (filtV - fixLastV)) >> 8);
+  fixSumP += shiftedV * filtI;
+}
+
+void EnergyMonitor::fixResults(int supplyVoltage, int numberOfSamples, boolean withVoltage)
+{
+  int n = numberOfSamples ? numberOfSamples : 1;
+
+  double I_RATIO = ICAL *((supplyVoltage/1000.0) / (ADC_COUNTS));
+  Irms = I_RATIO * sqrt((double)fixSumI / n) / 16;
+
+  if (withVoltage)
+  {
+    double V_RATIO = VCAL *((supplyVoltage/1000.0) / (ADC_COUNTS));
+    Vrms = V_RATIO * sqrt((double)fixSumV / n) / 16;
+
+    realPower = V_RATIO * I_RATIO * ((double)fixSumP / n) / 256;
+    apparentPower = Vrms * Irms;
+    powerFactor = realPower / apparentPower;
+  }
+
+  //Reset accumulators
+  fixSumV = 0;
+  fixSumI = 0;
+  fixSumP = 0;
+}
+#endif
+
+#if EMONLIB_USE_ISR
+//--------------------------------------------------------------------------------------
+// Interrupt driven sampling
+// The ADC runs in free-running mode. When an interrupt reports a conversion the next
+// one has already been started with the current mux setting, so the interrupt sets
+// the channel of the conversion after next: for calcVI() that is the channel of the
+// sample just read.
+//--------------------------------------------------------------------------------------
+#define ISR_IDLE    0
+#define ISR_WAIT    1                            //waiting for the voltage to be close to 'zero'
+#define ISR_SAMPLE  2                            //inside the sample window
+#define ISR_DONE    3                            //window complete, results not computed yet
+
+static EnergyMonitor *adcOwner = 0;
+
+static void setADCChannel(int pin)
+{
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+  if (pin >= 54) pin -= 54;                      //allow for channel or pin numbers
+#elif defined(__AVR_ATmega32U4__)
+  if (pin >= 18) pin -= 18;
+#else
+  if (pin >= 14) pin -= 14;
+#endif
+#if defined(analogPinToChannel)
+  pin = analogPinToChannel(pin);
+#endif
+#if defined(MUX5)
+  ADCSRB = (ADCSRB & ~_BV(MUX5)) | (((pin >> 3) & 0x01) << MUX5);
+#endif
+  ADMUX = _BV(REFS0) | (pin & 0x07);            //AVcc reference, as assumed by readVcc()
+}
+
+static void stopADC()
+{
+  ADCSRA &= ~(_BV(ADATE) | _BV(ADIE));
+}
+
+ISR(ADC_vect)
+{
+  int sample = ADCL;
+  sample |= ADCH<<8;
+  if (adcOwner) adcOwner->adcInterrupt(sample);
+}
+
+void EnergyMonitor::startADC()
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  adcOwner = this;
+  isrConversion = 0;
+  setADCChannel(isrTarget ? inPinI : inPinV);
+  ADCSRB &= ~(_BV(ADTS2) | _BV(ADTS1) | _BV(ADTS0));   //free running
+  ADCSRA |= _BV(ADATE) | _BV(ADIE) | _BV(ADIF) | _BV(ADSC);
+  setADCChannel(inPinI);                         //taken by the second conversion
+  SREG = oldSREG;
+}
+
+void EnergyMonitor::beginWindow(int _startV)
+{
+  isrStartV = _startV;
+  isrLastVCross = false;
+  isrCrossCount = 0;
+  isrSamples = 0;
+  fixSumV = 0;
+  fixSumI = 0;
+  fixSumP = 0;
+  isrStart = millis();
+  isrState = ISR_SAMPLE;
+}
+
+boolean EnergyMonitor::startVI(int crossings, int timeout)
+{
+  if (adcOwner && adcOwner != this && (adcOwner->isrState == ISR_WAIT || adcOwner->isrState == ISR_SAMPLE)) return false;
+  stopSampling();
+
+   #if defined emonTxV3
+  isrSupplyVoltage = 3300;
+   #else
+  isrSupplyVoltage = readVcc();
+   #endif
+
+  isrCrossings = crossings;
+  isrTimeout = timeout;
+  isrTarget = 0;
+  fixPhaseCal = PHASECAL * 256;
+  isrStart = millis();
+  isrState = ISR_WAIT;
+  startADC();
+  return true;
+}
+
+boolean EnergyMonitor::startIrms(int NUMBER_OF_SAMPLES)
+{
+  if (adcOwner && adcOwner != this && (adcOwner->isrState == ISR_WAIT || adcOwner->isrState == ISR_SAMPLE)) return false;
+  stopSampling();
+
+   #if defined emonTxV3
+  isrSupplyVoltage = 3300;
+   #else
+  isrSupplyVoltage = readVcc();
+   #endif
+
+  isrTarget = NUMBER_OF_SAMPLES;
+  beginWindow(0);
+  startADC();
+  return true;
+}
+
+void EnergyMonitor::stopSampling()
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  if (adcOwner == this) stopADC();
+  isrState = ISR_IDLE;
+  SREG = oldSREG;
+}
+
+//--------------------------------------------------------------------------------------
+// Per-sample work of calcVI()/calcIrms(). The filters keep running while waiting for
+// the start of the window so they are settled when it opens.
+//--------------------------------------------------------------------------------------
+void EnergyMonitor::adcInterrupt(int sample)
+{
+  boolean isCurrent = isrTarget || (isrConversion & 1);
+  if (!isrTarget) setADCChannel(isCurrent ? inPinI : inPinV);
+  isrConversion++;
+
+  if (!isCurrent)
+  {
+    fixSampleV(sample);
+
+    if (isrState == ISR_WAIT)
+    {
+      if ((sample >= (ADC_COUNTS/2+50)) || (sample <= (ADC_COUNTS/2-50))) return;
+      beginWindow(sample);
+    }
+    if (isrState != ISR_SAMPLE) return;
+
+    boolean cross = sample > isrStartV;
+    if (cross != isrLastVCross) isrCrossCount++;
+    isrLastVCross = cross;
+  }
+  else
+  {
+    fixSampleI(sample);
+
+    if (isrState != ISR_SAMPLE) return;
+
+    fixAccumulate(!isrTarget);
+    isrSamples++;
+
+    if (isrTarget ? (isrSamples >= isrTarget) : (isrCrossCount >= isrCrossings))
+    {
+      stopADC();
+      isrState = ISR_DONE;
+    }
+  }
+}
+
+boolean EnergyMonitor::isSampleDone()
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  if (!isrTarget && isrState != ISR_DONE && (millis() - isrStart) >= (unsigned long)isrTimeout)
+  {
+    if (isrState == ISR_WAIT) beginWindow(fixLastSampleV);   //no 'zero' found, start anyway like calcVI()
+    else if (isrState == ISR_SAMPLE)
+    {
+      stopADC();
+      isrState = ISR_DONE;
+    }
+  }
+  uint8_t state = isrState;
+  SREG = oldSREG;
+
+  if (state != ISR_DONE) return false;
+  fixResults(isrSupplyVoltage, isrSamples, !isrTarget);
+  isrState = ISR_IDLE;
+  return true;
+}
+#endif
+
+#if EMONLIB_MULTI_CHANNEL
+//--------------------------------------------------------------------------------------
+// Multi-channel measurements
+//--------------------------------------------------------------------------------------
+EnergyMonitorMulti::EnergyMonitorMulti()
+{
+  channelCount = 0;
+}
+
+boolean EnergyMonitorMulti::add(EnergyMonitor &channel)
+{
+  if (channelCount >= EMONLIB_MAX_CHANNELS) return false;
+  channels[channelCount++] = &channel;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Same as EnergyMonitor::calcVI() with one voltage and all current samples per loop
+//--------------------------------------------------------------------------------------
+void EnergyMonitorMulti::calcVI(int crossings, int timeout)
+{
+  if (channelCount == 0) return;
+  int inPinV = channels[0]->inPinV;
+
+   #if defined emonTxV3
+	int SUPPLYVOLTAGE=3300;
+   #else 
+	int SUPPLYVOLTAGE = channels[0]->readVcc();
+   #endif
+
+  for (int c = 0; c < channelCount; c++) channels[c]->fixPhaseCal = channels[c]->PHASECAL * 256;
+
+  int crossCount = 0;
+  int numberOfSamples = 0;
+
+  //-------------------------------------------------------------------------------------------------------------------------
+  // 1) Waits for the waveform to be close to 'zero' (500 adc) part in sin curve.
+  //-------------------------------------------------------------------------------------------------------------------------
+  int startV;
+  unsigned long start = millis();
+
+  while (true)
+  {
+     startV = analogRead(inPinV);
+     if ((startV < (ADC_COUNTS/2+50)) && (startV > (ADC_COUNTS/2-50))) break;
+     if ((millis()-start)>timeout) break;
+  }
+
+  //-------------------------------------------------------------------------------------------------------------------------
+  // 2) Main measurment loop
+  //-------------------------------------------------------------------------------------------------------------------------
+  boolean lastVCross, checkVCross = false;
+  start = millis();
+
+  while ((crossCount < crossings) && ((millis()-start)<timeout))
+  {
+    numberOfSamples++;
+
+    int sampleV = analogRead(inPinV);
+    for (int c = 0; c < channelCount; c++)
+    {
+      EnergyMonitor *channel = channels[c];
+      channel->fixSampleV(sampleV);
+      channel->fixSampleI(analogRead(channel->inPinI));
+      channel->fixAccumulate(true);
+    }
+
+    lastVCross = checkVCross;
+    checkVCross = sampleV > startV;
+    if (numberOfSamples==1) lastVCross = checkVCross;
+    if (lastVCross != checkVCross) crossCount++;
+  }
+
+  //-------------------------------------------------------------------------------------------------------------------------
+  // 3) Post loop calculations
+  //-------------------------------------------------------------------------------------------------------------------------
+  for (int c = 0; c < channelCount; c++) channels[c]->fixResults(SUPPLYVOLTAGE, numberOfSamples, true);
+}
+
+void EnergyMonitorMulti::calcIrms(int NUMBER_OF_SAMPLES)
+{
+  if (channelCount == 0) return;
+
+   #if defined emonTxV3
+	int SUPPLYVOLTAGE=3300;
+   #else 
+	int SUPPLYVOLTAGE = channels[0]->readVcc();
+   #endif
+
+  for (int n = 0; n < NUMBER_OF_SAMPLES; n++)
+  {
+    for (int c = 0; c < channelCount; c++)
+    {
+      EnergyMonitor *channel = channels[c];
+      channel->fixSampleI(analogRead(channel->inPinI));
+      channel->fixAccumulate(false);
+    }
+  }
+
+  for (int c = 0; c < channelCount; c++) channels[c]->fixResults(SUPPLYVOLTAGE, NUMBER_OF_SAMPLES, false);
+}
+#endif
@@ -31,6 +31,28 @@
 
 #define ADC_COUNTS  (1<<ADC_BITS)
 
+// Set to 1 for interrupt driven sampling (startVI/startIrms) on ATmega
+// boards. It takes over ADC_vect, so it is off by default.
+#ifndef EMONLIB_USE_ISR
+#define EMONLIB_USE_ISR 0
+#endif
+#if EMONLIB_USE_ISR && !(defined(__AVR_ATmega168__) || defined(__AVR_ATmega328__) || defined (__AVR_ATmega328P__) || defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__))
+#undef EMONLIB_USE_ISR
+#define EMONLIB_USE_ISR 0
+#endif
+
+// Set to 1 to run calcVI() and calcIrms() in fixed point, which keeps up a
+// much higher sample rate on AVR than the software floating point.
+#ifndef EMONLIB_FIXED_POINT
+#define EMONLIB_FIXED_POINT 0
+#endif
+
+// Set to 1 for EnergyMonitorMulti, which measures several circuits in one
+// sample window with the fixed point code.
+#ifndef EMONLIB_MULTI_CHANNEL
+#define EMONLIB_MULTI_CHANNEL 0
+#endif
+
 
 class EnergyMonitor
 {
@@ -47,6 +69,22 @@ class EnergyMonitor
     void serialprint();
 
     long readVcc();
+
+#if EMONLIB_USE_ISR
+    // Same measurements as calcVI()/calcIrms(), but the ADC runs free and
+    // its interrupt filters and sums the samples in fixed point. Start a
+    // window, then poll isSampleDone() which returns true (and sets the
+    // value variables) once the window is complete.
+    // Only one instance can sample at a time, analogRead() must not be
+    // used until the window is done.
+    boolean startVI(int crossings, int timeout);
+    boolean startIrms(int NUMBER_OF_SAMPLES);
+    boolean isSampleDone();
+    void stopSampling();
+
+    void adcInterrupt(int sample);   // called from the ADC interrupt
+#endif
+
     //Useful value variables
     double realPower,
        apparentPower,
@@ -55,6 +93,9 @@ class EnergyMonitor
        Irms;
 
   private:
+#if EMONLIB_MULTI_CHANNEL
+    friend class EnergyMonitorMulti;
+#endif
 
     //Set Voltage and current input pins
     int inPinV;
@@ -83,7 +124,69 @@ class EnergyMonitor
 	boolean lastVCross, checkVCross;                  //Used to measure number of times threshold is crossed.
 	int crossCount;                                   // ''
 
+#if EMONLIB_USE_ISR || EMONLIB_FIXED_POINT || EMONLIB_MULTI_CHANNEL
+    //--------------------------------------------------------------------------------------
+    // Fixed point version of the above: filtered values are Q16, the squares and products
+    // are summed from Q4 values. Also used by EnergyMonitorMulti
+    //--------------------------------------------------------------------------------------
+	int fixLastSampleV, fixLastSampleI;
+	long fixFilteredV, fixFilteredI;
+	int fixLastV;                                     //Last filtered voltage (Q4) for the phase calibration
+	int fixPhaseCal;                                  //PHASECAL in Q8
+	int64_t fixSumV, fixSumI, fixSumP;
+
+	void fixSampleV(int sample);
+	void fixSampleI(int sample);
+	void fixAccumulate(boolean withVoltage);
+	void fixResults(int supplyVoltage, int numberOfSamples, boolean withVoltage);
+#endif
+
+#if EMONLIB_USE_ISR
+    //--------------------------------------------------------------------------------------
+    // State of the interrupt driven sampling
+    //--------------------------------------------------------------------------------------
+	volatile uint8_t isrState;
+	uint8_t isrConversion;                            //Counts conversions to track the free-running mux
+	int isrCrossings, isrTimeout, isrTarget;
+	int isrSupplyVoltage;
+	unsigned long isrStart;
+	int isrStartV;
+	int isrSamples, isrCrossCount;
+	boolean isrLastVCross;
+
+	void beginWindow(int _startV);
+	void startADC();
+#endif
+
 
 };
 
+#if EMONLIB_MULTI_CHANNEL
+#ifndef EMONLIB_MAX_CHANNELS
+#define EMONLIB_MAX_CHANNELS 6
+#endif
+
+//--------------------------------------------------------------------------------------
+// Measures several circuits in one sample window: the voltage (pin of the first
+// channel) and the currents of all channels are read round robin, each channel gets
+// its results in its own realPower, Irms, ... variables.
+// The current of channel n is read n conversions after the voltage, that delay has
+// to be taken into its PHASECAL.
+//--------------------------------------------------------------------------------------
+class EnergyMonitorMulti
+{
+  public:
+    EnergyMonitorMulti();
+
+    boolean add(EnergyMonitor &channel);    //voltage() and current() already set up
+
+    void calcVI(int crossings, int timeout);
+    void calcIrms(int NUMBER_OF_SAMPLES);   //NUMBER_OF_SAMPLES per channel
+
+  private:
+    EnergyMonitor *channels[EMONLIB_MAX_CHANNELS];
+    int channelCount;
+};
+#endif
+
 #endif
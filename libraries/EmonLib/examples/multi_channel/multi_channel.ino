@@ -0,0 +1,30 @@
+// EmonLibrary examples openenergymonitor.org, Licence GNU GPL V3
+// Needs EMONLIB_MULTI_CHANNEL set to 1 in EmonLib.h
+
+#include "EmonLib.h"             // Include Emon Library
+EnergyMonitor ct1, ct2, ct3;     // One instance per circuit
+EnergyMonitorMulti emon;         // Measures them together
+
+void setup()
+{  
+  Serial.begin(9600);
+  
+  ct1.voltage(2, 234.26, 1.7);   // Voltage: input pin, calibration, phase_shift
+  ct1.current(1, 111.1);         // Current: input pin, calibration.
+  ct2.voltage(2, 234.26, 2.0);   // Read one conversion later than ct1, phase_shift calibrated accordingly
+  ct2.current(3, 111.1);
+  ct3.voltage(2, 234.26, 2.3);
+  ct3.current(4, 111.1);
+
+  emon.add(ct1);
+  emon.add(ct2);
+  emon.add(ct3);
+}
+
+void loop()
+{
+  emon.calcVI(20,2000);          // All circuits in one window. No.of half wavelengths (crossings), time-out
+  ct1.serialprint();
+  ct2.serialprint();
+  ct3.serialprint();
+}
@@ -0,0 +1,26 @@
+// EmonLibrary examples openenergymonitor.org, Licence GNU GPL V3
+// Needs EMONLIB_USE_ISR set to 1 in EmonLib.h
+
+#include "EmonLib.h"             // Include Emon Library
+EnergyMonitor emon1;             // Create an instance
+
+void setup()
+{  
+  Serial.begin(9600);
+  
+  emon1.voltage(2, 234.26, 1.7);  // Voltage: input pin, calibration, phase_shift
+  emon1.current(1, 111.1);       // Current: input pin, calibration.
+
+  emon1.startVI(20,2000);        // Start sampling in the background. No.of half wavelengths (crossings), time-out
+}
+
+void loop()
+{
+  if (emon1.isSampleDone())      // Sample window complete, all variables are set
+  {
+    emon1.serialprint();         // Print out all variables (realpower, apparent power, Vrms, Irms, power factor)
+    emon1.startVI(20,2000);      // Start the next window
+  }
+
+  // The loop is free for other work while the ADC interrupt collects the samples
+}
@@ -40,7 +40,9 @@
 
 #include "utility/direct_pin_read.h"
 
-#if defined(ENCODER_USE_INTERRUPTS) || !defined(ENCODER_DO_NOT_USE_INTERRUPTS)
+#if defined(ENCODER_USE_TIMER_SAMPLING)
+#define ENCODER_ARGLIST_SIZE 0
+#elif defined(ENCODER_USE_INTERRUPTS) || !defined(ENCODER_DO_NOT_USE_INTERRUPTS)
 #define ENCODER_USE_INTERRUPTS
 #define ENCODER_ARGLIST_SIZE CORE_NUM_INTERRUPT
 #include "utility/interrupt_pins.h"
@@ -66,6 +68,10 @@ typedef struct {
 	int32_t                position;
 } Encoder_internal_state_t;
 
+#ifdef ENCODER_USE_TIMER_SAMPLING
+#include "utility/timer_sampling.h"
+#endif
+
 class Encoder
 {
 public:
@@ -92,7 +98,9 @@ public:
 		if (DIRECT_PIN_READ(encoder.pin1_register, encoder.pin1_bitmask)) s |= 1;
 		if (DIRECT_PIN_READ(encoder.pin2_register, encoder.pin2_bitmask)) s |= 2;
 		encoder.state = s;
-#ifdef ENCODER_USE_INTERRUPTS
+#if defined(ENCODER_USE_TIMER_SAMPLING)
+		sampled = encoder_sampler_add(&encoder);
+#elif defined(ENCODER_USE_INTERRUPTS)
 		interrupts_in_use = attach_interrupt(pin1, &encoder);
 		interrupts_in_use += attach_interrupt(pin2, &encoder);
 #endif
@@ -117,6 +125,20 @@ public:
 		encoder.position = p;
 		interrupts();
 	}
+#elif defined(ENCODER_USE_TIMER_SAMPLING)
+	inline int32_t read() {
+		encoder_sampler_start();
+		noInterrupts();
+		if (!sampled) update(&encoder);
+		int32_t ret = encoder.position;
+		interrupts();
+		return ret;
+	}
+	inline void write(int32_t p) {
+		noInterrupts();
+		encoder.position = p;
+		interrupts();
+	}
 #else
 	inline int32_t read() {
 		update(&encoder);
@@ -128,7 +150,9 @@ public:
 #endif
 private:
 	Encoder_internal_state_t encoder;
-#ifdef ENCODER_USE_INTERRUPTS
+#if defined(ENCODER_USE_TIMER_SAMPLING)
+	uint8_t sampled;
+#elif defined(ENCODER_USE_INTERRUPTS)
 	uint8_t interrupts_in_use;
 #endif
 public:
@@ -939,4 +963,33 @@ ISR(INT7_vect) { Encoder::update(Encoder::interruptArgs[SCRAMBLE_INT_ORDER(7)]);
 #endif // ENCODER_OPTIMIZE_INTERRUPTS
 
 
+#if defined(__SAM3X8E__)
+// Hardware quadrature decoder of the Due's timer TC0, counting pin 2 (A)
+// and pin 13 (B).  Needs no interrupts or CPU time at any edge rate.
+class EncoderQDEC
+{
+public:
+	EncoderQDEC() {
+		pmc_enable_periph_clk(ID_TC0);
+		PIO_Configure(g_APinDescription[2].pPort, PIO_PERIPH_B,
+			g_APinDescription[2].ulPin, PIO_PULLUP);
+		PIO_Configure(g_APinDescription[13].pPort, PIO_PERIPH_B,
+			g_APinDescription[13].ulPin, PIO_PULLUP);
+		TC0->TC_CHANNEL[0].TC_CMR = TC_CMR_TCCLKS_XC0;
+		// edges of both phases are counted, 4 counts per cycle as Encoder
+		TC0->TC_BMR = TC_BMR_QDEN | TC_BMR_POSEN;
+		TC0->TC_CHANNEL[0].TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+		offset = 0;
+	}
+	inline int32_t read() {
+		return (int32_t)TC0->TC_CHANNEL[0].TC_CV + offset;
+	}
+	inline void write(int32_t p) {
+		offset = p - (int32_t)TC0->TC_CHANNEL[0].TC_CV;
+	}
+private:
+	int32_t offset;
+};
+#endif
+
 #endif
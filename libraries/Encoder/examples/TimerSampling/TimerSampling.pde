@@ -0,0 +1,42 @@
+/* Encoder Library - TimerSampling Example
+ * http://www.pjrc.com/teensy/td_libs_Encoder.html
+ *
+ * This example code is in the public domain.
+ */
+
+// If you define ENCODER_USE_TIMER_SAMPLING *before* including Encoder,
+// a Timer2 interrupt samples all encoders at ENCODER_SAMPLE_RATE (40 kHz
+// unless defined otherwise) instead of using pin interrupts.  Every pin
+// can be used, and the CPU time stays the same however fast the shafts
+// turn, as long as no encoder produces more edges per second than the
+// sample rate.  tone() and PWM on the Timer2 pins can not be used.
+#define ENCODER_USE_TIMER_SAMPLING
+#include <Encoder.h>
+
+// Change these pin numbers to the pins connected to your encoders.
+Encoder conveyor(4, 5);
+Encoder feeder(6, 7);
+Encoder stacker(8, 9);
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println("Timer Sampled Encoder Test:");
+}
+
+long lastConveyor, lastFeeder, lastStacker;
+
+void loop() {
+  long c = conveyor.read();
+  long f = feeder.read();
+  long s = stacker.read();
+  if (c != lastConveyor || f != lastFeeder || s != lastStacker) {
+    Serial.print(c);
+    Serial.print('\t');
+    Serial.print(f);
+    Serial.print('\t');
+    Serial.println(s);
+    lastConveyor = c;
+    lastFeeder = f;
+    lastStacker = s;
+  }
+}
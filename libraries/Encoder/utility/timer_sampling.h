@@ -0,0 +1,111 @@
+#ifndef timer_sampling_h_
+#define timer_sampling_h_
+
+// Timer sampled decoding, enabled with ENCODER_USE_TIMER_SAMPLING.  A
+// timer interrupt reads every input port in use once per tick and
+// updates all encoders from those values, so the CPU time is fixed by
+// the sample rate instead of the edge rate, any pins can be used and a
+// burst of edges on one encoder cannot delay the others.  The sample
+// rate must be at least the highest edge rate of any one encoder.
+
+#if defined(__AVR__)
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#ifndef ENCODER_SAMPLE_RATE
+#define ENCODER_SAMPLE_RATE	40000
+#endif
+#ifndef ENCODER_MAX_SAMPLED
+#define ENCODER_MAX_SAMPLED	8
+#endif
+
+// Timer2 in CTC mode, clock / 8.  Timer2 is also used by tone() and
+// for PWM on pins 3 and 11 (9 and 10 on Mega), these can not be used.
+#define ENCODER_TIMER_TOP	(F_CPU / 8 / ENCODER_SAMPLE_RATE - 1)
+#if ENCODER_TIMER_TOP > 255 || ENCODER_TIMER_TOP < 1
+#error "ENCODER_SAMPLE_RATE out of range for Timer2"
+#endif
+
+typedef struct {
+	Encoder_internal_state_t * state;
+	uint8_t                    port1;	// index into encoder_sampled_ports
+	uint8_t                    port2;
+} Encoder_sampled_t;
+
+static Encoder_sampled_t encoder_sampled[ENCODER_MAX_SAMPLED];
+static volatile IO_REG_TYPE * encoder_sampled_ports[ENCODER_MAX_SAMPLED * 2];
+static uint8_t encoder_sampled_count = 0;
+static uint8_t encoder_sampled_port_count = 0;
+
+// position change for (new pin2, new pin1, old pin2, old pin1)
+static const int8_t encoder_sampled_step[16] = {
+	0, 1, -1, 2, -1, 0, -2, 1, 1, -2, 0, -1, 2, -1, 1, 0
+};
+
+static uint8_t encoder_sampled_port(volatile IO_REG_TYPE *reg)
+{
+	uint8_t i;
+
+	for (i = 0; i < encoder_sampled_port_count; i++) {
+		if (encoder_sampled_ports[i] == reg) return i;
+	}
+	encoder_sampled_ports[i] = reg;
+	encoder_sampled_port_count++;
+	return i;
+}
+
+// Arduino's init() sets Timer2 up for PWM after the constructors of
+// global objects have run, so this is checked again on every read().
+static inline void encoder_sampler_start(void)
+{
+	if (TCCR2A == _BV(WGM21) && (TIMSK2 & _BV(OCIE2A))) return;
+	uint8_t sreg = SREG;
+	cli();
+	TCCR2A = _BV(WGM21);
+	TCCR2B = _BV(CS21);
+	OCR2A = ENCODER_TIMER_TOP;
+	TCNT2 = 0;
+	TIMSK2 |= _BV(OCIE2A);
+	SREG = sreg;
+}
+
+static uint8_t encoder_sampler_add(Encoder_internal_state_t *state)
+{
+	if (encoder_sampled_count >= ENCODER_MAX_SAMPLED) return 0;
+	uint8_t sreg = SREG;
+	cli();
+	Encoder_sampled_t *e = &encoder_sampled[encoder_sampled_count];
+	e->state = state;
+	e->port1 = encoder_sampled_port(state->pin1_register);
+	e->port2 = encoder_sampled_port(state->pin2_register);
+	encoder_sampled_count++;
+	SREG = sreg;
+	encoder_sampler_start();
+	return 1;
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+	IO_REG_TYPE in[ENCODER_MAX_SAMPLED * 2];
+	uint8_t i;
+
+	for (i = 0; i < encoder_sampled_port_count; i++) {
+		in[i] = *encoder_sampled_ports[i];
+	}
+	for (i = 0; i < encoder_sampled_count; i++) {
+		Encoder_internal_state_t *arg = encoder_sampled[i].state;
+		uint8_t s = arg->state & 3;
+		if (in[encoder_sampled[i].port1] & arg->pin1_bitmask) s |= 4;
+		if (in[encoder_sampled[i].port2] & arg->pin2_bitmask) s |= 8;
+		arg->state = (s >> 2);
+		int8_t step = encoder_sampled_step[s];
+		if (step) arg->position += step;
+	}
+}
+
+#else
+#error "ENCODER_USE_TIMER_SAMPLING is only supported on AVR"
+#endif
+
+#endif
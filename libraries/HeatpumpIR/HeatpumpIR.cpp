@@ -9,6 +9,29 @@ void HeatpumpIR::send(IRSender&, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, ui
 {
 }
 
+// Send the command from the cache if the cache was last filled with the
+// same model and command, otherwise build the frame into the cache first.
+// Models that send more than one frame per command are sent uncached.
+void HeatpumpIR::sendCached(IRSender& IR, HeatpumpIRFrame& cache, uint8_t powerModeCmd, uint8_t operatingModeCmd, uint8_t fanSpeedCmd, uint8_t temperatureCmd, uint8_t swingVCmd, uint8_t swingHCmd)
+{
+  uint8_t command[6] = { powerModeCmd, operatingModeCmd, fanSpeedCmd, temperatureCmd, swingVCmd, swingHCmd };
+
+  if (cache.model != this || memcmp(cache.command, command, sizeof(command)) != 0)
+  {
+    IR.capture(&cache.frame);
+    send(IR, powerModeCmd, operatingModeCmd, fanSpeedCmd, temperatureCmd, swingVCmd, swingHCmd);
+    IR.capture(NULL);
+
+    cache.model = this;
+    memcpy(cache.command, command, sizeof(command));
+  }
+
+  if (!IR.sendFrame(cache.frame))
+  {
+    send(IR, powerModeCmd, operatingModeCmd, fanSpeedCmd, temperatureCmd, swingVCmd, swingHCmd);
+  }
+}
+
 // Heatpump model and info getters
 const char PROGMEM* HeatpumpIR::model()
 {
@@ -52,6 +52,18 @@
 #define HDIR_RIGHT  6
 
 
+class HeatpumpIR;
+
+// A frame cache for HeatpumpIR::sendCached(). Set frame.data and frame.size
+// to the storage for the frame, a byte holds two marks or spaces. A new
+// cache must start zeroed, e.g. as a global or static variable.
+struct HeatpumpIRFrame
+{
+  IRFrame frame;
+  HeatpumpIR *model;  // The model and the command the frame was built for
+  uint8_t command[6];
+};
+
 class HeatpumpIR
 {
   protected:
@@ -61,6 +73,7 @@ class HeatpumpIR
 
   public:
     virtual void send(IRSender& IR, uint8_t powerModeCmd, uint8_t operatingModeCmd, uint8_t fanSpeedCmd, uint8_t temperatureCmd, uint8_t swingVCmd, uint8_t swingHCmd);
+    void sendCached(IRSender& IR, HeatpumpIRFrame& cache, uint8_t powerModeCmd, uint8_t operatingModeCmd, uint8_t fanSpeedCmd, uint8_t temperatureCmd, uint8_t swingVCmd, uint8_t swingHCmd);
     const char PROGMEM* model();
     const char PROGMEM* info();
 };
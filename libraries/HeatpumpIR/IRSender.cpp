@@ -6,9 +6,65 @@
 //
 // For PWM on Arduino, see http://playground.arduino.cc/Main/TimerPWMCheatsheet
 
+#ifdef IRSENDER_ASYNC
+// Playback states
+#define IRSENDER_IDLE    0 // Nothing queued
+#define IRSENDER_FILLING 1 // Frame is being queued, the timer is not playing yet
+#define IRSENDER_PLAYING 2 // The timer is playing while the frame is queued
+#define IRSENDER_ENDING  3 // The whole frame is queued
+
+uint8_t *IRSender::_ring;
+uint16_t IRSender::_ringSize;
+volatile uint16_t IRSender::_head;
+volatile uint16_t IRSender::_tail;
+volatile uint16_t IRSender::_remain;
+volatile uint8_t IRSender::_state = IRSENDER_IDLE;
+volatile uint8_t *IRSender::_tccr;
+uint8_t IRSender::_com;
+uint8_t IRSender::_timer;
+uint8_t IRSender::_khz;
+uint16_t IRSender::_ticks[IRSENDER_LENGTHS];
+uint8_t IRSender::_nticks;
+bool IRSender::_sync = true;
+#endif
+
+// Convert a length in microseconds into carrier periods
+static uint16_t toTicks(unsigned int length, uint8_t khz)
+{
+  return ((uint32_t)length * khz + 500) / 1000;
+}
+
+// Find 'ticks' in a length table, adding it if it is not there yet.
+// Returns IRSENDER_LENGTHS if the table is full.
+static uint8_t lengthIndex(uint16_t *table, uint8_t &count, uint16_t ticks)
+{
+  uint8_t i;
+
+  for (i = 0; i < count && table[i] != ticks; i++)
+    ;
+
+  if (i == count && count < IRSENDER_LENGTHS)
+  {
+    table[count++] = ticks;
+  }
+  return i;
+}
+
+// Store a 4-bit length index at the given mark/space position
+static void putSymbol(uint8_t *data, uint16_t pos, uint8_t index)
+{
+  uint8_t *b = &data[pos >> 1];
+  *b = (pos & 1) ? (*b & 0x0F) | (index << 4) : (*b & 0xF0) | index;
+}
+
 IRSender::IRSender(uint8_t pin)
 {
   _pin = pin;
+  _capture = NULL;
+#ifdef IRSENDER_ASYNC
+  _buffer = NULL;
+  _size = 0;
+#endif
 }
 
 // Set the PWM frequency. The selected pin determines which timer to use
@@ -17,6 +73,22 @@ void IRSender::setFrequency(int frequency)
   uint8_t pwmval8 = F_CPU / 2000 / (frequency);
   uint16_t pwmval16 = F_CPU / 2000 / (frequency);
 
+  if (_capture)
+  {
+    // Only single frames can be captured, the models sending several
+    // frames have delays between them
+    _captureBad |= (_captureLen != 0);
+    _capture->khz = frequency;
+    return;
+  }
+
+#ifdef IRSENDER_ASYNC
+  // Let the previous frame finish before the timer is reprogrammed
+  while (busy())
+    ;
+  _state = IRSENDER_IDLE;
+#endif
+
   pinMode(_pin, OUTPUT);
   digitalWrite(_pin, LOW); // When not sending PWM, we want it low
 
@@ -70,6 +142,417 @@ void IRSender::setFrequency(int frequency)
       break;
 #endif
   }
+
+#ifdef IRSENDER_ASYNC
+  // The PWM output of the pin, the same mapping as in mark() and space()
+  _timer = 0;
+  switch (_pin)
+  {
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+    case 9:  _tccr = &TCCR2A; _com = _BV(COM2B1); _timer = 2; break;
+    case 10: _tccr = &TCCR2A; _com = _BV(COM2A1); _timer = 2; break;
+    case 11: _tccr = &TCCR1A; _com = _BV(COM1A1); _timer = 1; break;
+    case 12: _tccr = &TCCR1A; _com = _BV(COM1B1); _timer = 1; break;
+    case 44: _tccr = &TCCR5A; _com = _BV(COM5C1); _timer = 5; break;
+    case 45: _tccr = &TCCR5A; _com = _BV(COM5B1); _timer = 5; break;
+    case 46: _tccr = &TCCR5A; _com = _BV(COM5A1); _timer = 5; break;
+#else
+    case 3:  _tccr = &TCCR2A; _com = _BV(COM2B1); _timer = 2; break;
+    case 9:  _tccr = &TCCR1A; _com = _BV(COM1A1); _timer = 1; break;
+    case 10: _tccr = &TCCR1A; _com = _BV(COM1B1); _timer = 1; break;
+    case 11: _tccr = &TCCR2A; _com = _BV(COM2A1); _timer = 2; break;
+#endif
+  }
+
+  // Without a buffer the frame is sent the blocking way
+  _sync = (_buffer == NULL || _timer == 0);
+  if (!_sync)
+  {
+    _ring = _buffer;
+    _ringSize = _size * 2;
+    _head = 0;
+    _tail = 0;
+    _nticks = 0;
+    _khz = frequency;
+    _state = IRSENDER_FILLING;
+  }
+#endif
+}
+
+#ifdef IRSENDER_ASYNC
+// Give the sender a buffer for interrupt driven sending. Each byte holds
+// two marks or spaces, so 'size' bytes hold a frame of 'size' bits, plus
+// the headers. The heatpump 'send' methods return as soon as the frame has
+// been queued, or when only the last 'size' bytes are left to send for
+// frames that don't fit.
+void IRSender::setBuffer(uint8_t *buffer, uint16_t size)
+{
+  while (busy())
+    ;
+  _buffer = size > 0 ? buffer : NULL;
+  _size = size;
+}
+
+// True while a frame is still being sent
+bool IRSender::busy()
+{
+  return _state == IRSENDER_PLAYING || _state == IRSENDER_ENDING;
+}
+
+// Queue a mark or space. The lengths are stored as the number of carrier
+// periods in a table of at most 16 different lengths, and the buffer holds
+// 4-bit indexes into that table. Returns false if the symbol has to be sent
+// the blocking way.
+bool IRSender::queue(unsigned int length, bool isMark)
+{
+  if (_sync || _state == IRSENDER_IDLE)
+  {
+    return false;
+  }
+
+  uint8_t i = lengthIndex(_ticks, _nticks, toTicks(length, _khz));
+
+  if (i == IRSENDER_LENGTHS)
+  {
+    // Too many different lengths, send the rest of the frame blocking
+    start(true);
+    while (busy())
+      ;
+    _sync = true;
+    return false;
+  }
+
+  // Marks take the even and spaces the odd positions, an empty symbol
+  // goes in between if two of the same kind follow each other
+  if (((_head & 1) == 0) != isMark)
+  {
+    queue(0, !isMark);
+  }
+
+  uint16_t next = (_head + 1 == _ringSize) ? 0 : _head + 1;
+  uint16_t tail;
+
+  do
+  {
+    uint8_t sreg = SREG;
+    cli();
+    tail = _tail;
+    SREG = sreg;
+
+    // Buffer full, start sending to make room
+    if (next == tail && _state == IRSENDER_FILLING)
+    {
+      start(false);
+    }
+  } while (next == tail);
+
+  putSymbol(_ring, _head, i);
+
+  uint8_t sreg = SREG;
+  cli();
+  _head = next;
+  SREG = sreg;
+
+  return true;
+}
+
+// Start the playback, or only mark the frame complete if already playing
+void IRSender::start(bool ending)
+{
+  if (_state == IRSENDER_FILLING)
+  {
+    _remain = 0;
+    _state = ending ? IRSENDER_ENDING : IRSENDER_PLAYING;
+
+    switch (_timer)
+    {
+      case 1:
+        TIFR1 = _BV(TOV1);
+        TIMSK1 |= _BV(TOIE1);
+        break;
+      case 2:
+        TIFR2 = _BV(TOV2);
+        TIMSK2 |= _BV(TOIE2);
+        break;
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+      case 5:
+        TIFR5 = _BV(TOV5);
+        TIMSK5 |= _BV(TOIE5);
+        break;
+#endif
+    }
+  }
+  else if (ending)
+  {
+    _state = IRSENDER_ENDING;
+  }
+}
+
+// Called once per carrier period from the timer overflow interrupt
+void IRSender::tick()
+{
+  if (_remain != 0 && --_remain != 0)
+  {
+    return;
+  }
+
+  while (_tail != _head)
+  {
+    uint8_t b = _ring[_tail >> 1];
+
+    if (_tail & 1)
+    {
+      *_tccr &= ~_com; // space
+      b >>= 4;
+    }
+    else
+    {
+      *_tccr |= _com;  // mark
+      b &= 0x0F;
+    }
+
+    _tail = (_tail + 1 == _ringSize) ? 0 : _tail + 1;
+    _remain = _ticks[b];
+    if (_remain != 0)
+    {
+      return;
+    }
+  }
+
+  // Everything played; if the frame is not complete yet, keep the output
+  // as it is until the next symbol has been queued
+  if (_state == IRSENDER_ENDING)
+  {
+    *_tccr &= ~_com;
+
+    switch (_timer)
+    {
+      case 1:
+        TIMSK1 &= ~_BV(TOIE1);
+        break;
+      case 2:
+        TIMSK2 &= ~_BV(TOIE2);
+        break;
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+      case 5:
+        TIMSK5 &= ~_BV(TOIE5);
+        break;
+#endif
+    }
+    _state = IRSENDER_IDLE;
+  }
+}
+
+// The PWM timers run in phase correct mode, and overflow once per carrier period
+ISR(TIMER1_OVF_vect)
+{
+  IRSender::tick();
+}
+
+ISR(TIMER2_OVF_vect)
+{
+  IRSender::tick();
+}
+
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+ISR(TIMER5_OVF_vect)
+{
+  IRSender::tick();
+}
+#endif
+#endif
+
+// Record the next frame into 'frame' instead of sending it, until
+// capture(NULL) is called. The frame is valid (length != 0) if it was a
+// single frame that fit into the frame's data and length table.
+void IRSender::capture(IRFrame *frame)
+{
+  _capture = frame;
+  _captureLen = 0;
+  _captureBad = false;
+
+  if (frame)
+  {
+    frame->length = 0;
+    frame->khz = 0;
+    frame->nticks = 0;
+  }
+}
+
+// Add a mark or space to the frame being captured
+void IRSender::record(unsigned int length, bool isMark)
+{
+  if (_capture->length != 0 || _capture->khz == 0)
+  {
+    _captureBad = true; // Symbols after the end or before setFrequency()
+  }
+  if (_captureBad)
+  {
+    _capture->length = 0;
+    return;
+  }
+
+  // All the heatpump frames end with space(0), it is not stored
+  if (!isMark && length == 0)
+  {
+    _capture->length = _captureLen;
+    return;
+  }
+
+  uint16_t ticks = toTicks(length, _capture->khz);
+  uint16_t pos = _captureLen;
+
+  if (((pos & 1) == 0) != isMark)
+  {
+    if (pos == 0)
+    {
+      // A frame starting with a space, the first mark is empty
+      uint8_t i = lengthIndex(_capture->ticks, _capture->nticks, 0);
+
+      if (i == IRSENDER_LENGTHS || _capture->size == 0)
+      {
+        _captureBad = true;
+        return;
+      }
+      putSymbol(_capture->data, pos++, i);
+    }
+    else
+    {
+      // Two marks or two spaces in a row are one longer mark or space
+      uint8_t b = _capture->data[--pos >> 1];
+      ticks += _capture->ticks[(pos & 1) ? b >> 4 : b & 0x0F];
+    }
+  }
+
+  uint8_t i = lengthIndex(_capture->ticks, _capture->nticks, ticks);
+
+  if (i == IRSENDER_LENGTHS || pos == _capture->size * 2)
+  {
+    _captureBad = true;
+    return;
+  }
+
+  putSymbol(_capture->data, pos++, i);
+  _captureLen = pos;
+}
+
+// Send a captured frame, without encoding it again. Returns false if the
+// frame is not valid.
+bool IRSender::sendFrame(const IRFrame &frame)
+{
+  if (frame.length == 0)
+  {
+    return false;
+  }
+
+  setFrequency(frame.khz);
+
+  // Only a frame starting with a space has an empty symbol, the first mark.
+  // The final space(0) is not stored, it is sent separately.
+  bool isMark = true;
+  unsigned long length = 0;
+
+  for (uint16_t pos = 0; pos < frame.length; pos++)
+  {
+    uint8_t b = frame.data[pos >> 1];
+    uint16_t ticks = frame.ticks[(pos & 1) ? b >> 4 : b & 0x0F];
+
+    if (ticks == 0)
+    {
+      continue;
+    }
+
+    if (((pos & 1) == 0) != isMark)
+    {
+      if (isMark)
+        mark(length);
+      else
+        space(length);
+      isMark = !isMark;
+      length = 0;
+    }
+    length += (uint32_t)ticks * 1000 / frame.khz;
+  }
+
+  if (isMark)
+    mark(length);
+  else
+    space(length);
+  space(0);
+
+  return true;
+}
+
+// Send captured frames on several senders at the same time, e.g. to control
+// several heatpumps from one node in the time of a single frame. The same
+// frame can be given for several senders. At most IRSENDER_CHANNELS senders,
+// all the frames of senders sharing a timer must use the same carrier
+// frequency. This always blocks until all the frames have been sent.
+void IRSender::sendFrames(IRSender *senders[], const IRFrame *frames[], uint8_t count)
+{
+  uint16_t pos[IRSENDER_CHANNELS];
+  unsigned long next[IRSENDER_CHANNELS]; // Time of the next symbol, since 'start'
+  uint8_t active = 0;
+
+  if (count > IRSENDER_CHANNELS)
+  {
+    count = IRSENDER_CHANNELS;
+  }
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    pos[i] = 0;
+    next[i] = 0;
+    if (frames[i]->length != 0)
+    {
+      senders[i]->setFrequency(frames[i]->khz);
+      active++;
+    }
+  }
+
+  unsigned long start = micros();
+
+  while (active)
+  {
+    // Start the next symbol on each sender whose previous symbol has ended
+    unsigned long now = micros() - start;
+    unsigned long wait = 0xFFFFFFFF;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+      const IRFrame &frame = *frames[i];
+
+      while (pos[i] < frame.length && next[i] <= now)
+      {
+        uint8_t b = frame.data[pos[i] >> 1];
+        uint16_t ticks = frame.ticks[(pos[i] & 1) ? b >> 4 : b & 0x0F];
+
+        if (ticks != 0)
+        {
+          if (pos[i] & 1)
+            senders[i]->pwmOff();
+          else
+            senders[i]->pwmOn();
+        }
+        next[i] += (uint32_t)ticks * 1000 / frame.khz;
+
+        if (++pos[i] == frame.length)
+        {
+          senders[i]->pwmOff();
+          active--;
+        }
+      }
+
+      if (pos[i] < frame.length && next[i] - now < wait)
+      {
+        wait = next[i] - now;
+      }
+    }
+
+    // Wait for the earliest symbol end
+    while (active && micros() - start < now + wait)
+      ;
+  }
 }
 
 // Send a uint8_t (8 bits) over IR
@@ -107,6 +590,59 @@ uint8_t IRSender::bitReverse(uint8_t x)
 
 // Send an IR 'mark' symbol, i.e. transmitter ON
 void IRSender::mark(int markLength)
+{
+  if (_capture)
+  {
+    record(markLength, true);
+    return;
+  }
+
+#ifdef IRSENDER_ASYNC
+  if (queue(markLength, true))
+  {
+    return;
+  }
+#endif
+
+  pwmOn();
+  delayMicroseconds(markLength);
+}
+
+// Send an IR 'space' symbol, i.e. transmitter OFF
+void IRSender::space(int spaceLength)
+{
+  if (_capture)
+  {
+    record(spaceLength, false);
+    return;
+  }
+
+#ifdef IRSENDER_ASYNC
+  // All the heatpump frames end with space(0)
+  if (queue(spaceLength, false))
+  {
+    if (spaceLength == 0)
+    {
+      start(true);
+    }
+    return;
+  }
+#endif
+
+  pwmOff();
+
+  // Mitsubishi heatpump uses > 16383us spaces, and delayMicroseconds only works up to 2^14 - 1 us
+  // Use the less accurate milliseconds delay for longer delays
+
+  if (spaceLength < 16383) {
+    delayMicroseconds(spaceLength);
+  } else {
+    delay(spaceLength/1000);
+  }
+}
+
+// Switch the PWM output of the pin on
+void IRSender::pwmOn()
 {
   switch (_pin)
   {
@@ -148,13 +684,11 @@ void IRSender::mark(int markLength)
       (TCCR2A |= _BV(COM2A1)); // Enable pin 11 PWM output
       break;
 #endif
-    }
-
-  delayMicroseconds(markLength);
+  }
 }
 
-// Send an IR 'space' symbol, i.e. transmitter OFF
-void IRSender::space(int spaceLength)
+// Switch the PWM output of the pin off
+void IRSender::pwmOff()
 {
   switch (_pin)
   {
@@ -193,14 +727,5 @@ void IRSender::space(int spaceLength)
       (TCCR2A &= ~(_BV(COM2A1))); // Disable pin 11 PWM output
       break;
 #endif
-}
-
-  // Mitsubishi heatpump uses > 16383us spaces, and delayMicroseconds only works up to 2^14 - 1 us
-  // Use the less accurate milliseconds delay for longer delays
-
-  if (spaceLength < 16383) {
-    delayMicroseconds(spaceLength);
-  } else {
-    delay(spaceLength/1000);
   }
 }
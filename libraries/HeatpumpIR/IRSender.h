@@ -6,6 +6,30 @@
 
 #include <Arduino.h>
 
+// Uncomment to play the frames back from the PWM timer overflow interrupt,
+// see IRSender::setBuffer(). This takes the TIMER1_OVF and TIMER2_OVF vectors
+// (and TIMER5_OVF on the Mega) for the library.
+//#define IRSENDER_ASYNC
+
+// Maximum number of different mark and space lengths in a frame
+#define IRSENDER_LENGTHS 16
+
+// Maximum number of senders for IRSender::sendFrames()
+#define IRSENDER_CHANNELS 8
+
+// An encoded frame, see IRSender::capture(). Each mark and space is a 4-bit
+// index into the length table, two per byte. The marks are at the even and
+// the spaces at the odd positions.
+struct IRFrame
+{
+  uint8_t *data;                      // Storage for the indexes, set by the user
+  uint16_t size;                      // Size of 'data' in bytes
+  uint16_t length;                    // Number of marks and spaces, 0 if not valid
+  uint8_t khz;                        // Carrier frequency
+  uint8_t nticks;                     // Entries used in 'ticks'
+  uint16_t ticks[IRSENDER_LENGTHS];   // Lengths in carrier periods
+};
+
 class IRSender
 {
   public:
@@ -15,9 +39,46 @@ class IRSender
     uint8_t bitReverse(uint8_t x);
     void space(int spaceLength);
     void mark(int markLength);
+    void capture(IRFrame *frame);
+    bool sendFrame(const IRFrame &frame);
+    static void sendFrames(IRSender *senders[], const IRFrame *frames[], uint8_t count);
+#ifdef IRSENDER_ASYNC
+    void setBuffer(uint8_t *buffer, uint16_t size);
+    bool busy();
+    static void tick();
+#endif
 
   private:
     uint8_t _pin;
+    void record(unsigned int length, bool isMark);
+    void pwmOn();
+    void pwmOff();
+
+    IRFrame *_capture;
+    uint16_t _captureLen;
+    bool _captureBad;
+#ifdef IRSENDER_ASYNC
+    bool queue(unsigned int length, bool isMark);
+    void start(bool ending);
+
+    uint8_t *_buffer;
+    uint16_t _size;
+
+    // Playback state, shared with the timer interrupt
+    static uint8_t *_ring;
+    static uint16_t _ringSize;
+    static volatile uint16_t _head;
+    static volatile uint16_t _tail;
+    static volatile uint16_t _remain;
+    static volatile uint8_t _state;
+    static volatile uint8_t *_tccr;
+    static uint8_t _com;
+    static uint8_t _timer;
+    static uint8_t _khz;
+    static uint16_t _ticks[IRSENDER_LENGTHS];
+    static uint8_t _nticks;
+    static bool _sync;
+#endif
 };
 
 #endif
@@ -0,0 +1,72 @@
+// Host benchmark for the HeatpumpIR encoders.
+//
+// For one command per model this prints:
+//  - the CPU time of send() without the delays, i.e. the time the encoder
+//    computes between the marks and spaces (measured on the host, so only
+//    for comparison between versions and between the models)
+//  - the airtime of the frames and the pause time between them
+//  - the number of marks and spaces and the number of different lengths,
+//    which tell whether and in how many bytes the command fits into an
+//    IRFrame (at most IRSENDER_LENGTHS lengths, two symbols per byte)
+//
+// An optional argument sets the number of rounds (default 20000).
+
+#include "HeatpumpIR.h"
+#include "PanasonicCKPHeatpumpIR.h"
+#include "PanasonicHeatpumpIR.h"
+#include "CarrierHeatpumpIR.h"
+#include "MideaHeatpumpIR.h"
+#include "FujitsuHeatpumpIR.h"
+#include "MitsubishiHeatpumpIR.h"
+#include "SamsungHeatpumpIR.h"
+#include "SharpHeatpumpIR.h"
+#include "DaikinHeatpumpIR.h"
+#include "HisenseHeatpumpIR.h"
+#include "IRTrace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char **argv) {
+    long rounds = argc > 1 ? atol(argv[1]) : 20000;
+
+    HeatpumpIR *heatpumps[] = {
+        new PanasonicCKPHeatpumpIR(), new PanasonicDKEHeatpumpIR(), new PanasonicJKEHeatpumpIR(),
+        new PanasonicNKEHeatpumpIR(), new CarrierHeatpumpIR(), new MideaHeatpumpIR(),
+        new FujitsuHeatpumpIR(), new MitsubishiFDHeatpumpIR(), new MitsubishiFEHeatpumpIR(),
+        new SamsungHeatpumpIR(), new SharpHeatpumpIR(), new DaikinHeatpumpIR(), new HisenseHeatpumpIR()
+    };
+    IRSender irSender(3);
+
+    printf("%-15s %10s %10s %10s %8s %8s %11s\n", "model", "encode ns", "air ms", "pause ms", "symbols", "lengths", "frame bytes");
+    for (size_t h = 0; h < sizeof(heatpumps) / sizeof(heatpumps[0]); h++) {
+        HeatpumpIR *heatpump = heatpumps[h];
+
+        uint64_t start = nowNs();
+        for (long i = 0; i < rounds; i++) {
+            irTraceReset();
+            heatpump->send(irSender, POWER_ON, MODE_HEAT, FAN_AUTO, 22, VDIR_AUTO, HDIR_AUTO);
+        }
+        uint64_t elapsed = nowNs() - start;
+
+        // the time of the long spaces between the frames of the command
+        unsigned long pauses = 0;
+        for (unsigned int i = 1; i < irTraceLength(); i += 2) {
+            if (irTraceSymbol(i) >= 5000) {
+                pauses += irTraceSymbol(i);
+            }
+        }
+        unsigned long airtime = irTraceAirtime();
+
+        printf("%-15s %10lu %10.1f %10.1f %8u %8u %11u\n", heatpump->model(),
+               (unsigned long)(elapsed / rounds), (airtime - pauses) / 1000.0, pauses / 1000.0,
+               irTraceLength(), irTraceLengths(), (irTraceLength() + 1) / 2);
+    }
+    return 0;
+}
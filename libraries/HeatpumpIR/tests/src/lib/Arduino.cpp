@@ -0,0 +1,171 @@
+#include "Arduino.h"
+#include "IRTrace.h"
+
+#include <map>
+#include <sstream>
+#include <vector>
+
+uint8_t TCCR1A, TCCR1B, TCCR2A, TCCR2B, OCR2A, OCR2B;
+uint16_t ICR1, OCR1A, OCR1B;
+
+HardwareSerial Serial;
+
+static std::vector<unsigned long> symbols;
+static unsigned long now;
+
+static bool outputOn() {
+    return (TCCR1A & (_BV(COM1A1) | _BV(COM1B1))) || (TCCR2A & (_BV(COM2A1) | _BV(COM2B1)));
+}
+
+static void record(unsigned long us) {
+    now += us;
+    bool isMark = outputOn();
+    if (us == 0) {
+        return;
+    }
+    // marks at the even positions, a frame starting with a space gets an empty mark
+    if (symbols.size() % 2 == (isMark ? 1u : 0u)) {
+        if (symbols.empty()) {
+            symbols.push_back(0);
+        } else {
+            symbols.back() += us;
+            return;
+        }
+    }
+    symbols.push_back(us);
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+
+void delay(unsigned long ms) {
+    record(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    record(us);
+}
+
+unsigned long micros(void) {
+    // IRSender::sendFrames() polls the clock, let it move
+    return ++now;
+}
+
+void irTraceReset() {
+    symbols.clear();
+    TCCR1A = TCCR2A = 0;
+}
+
+unsigned int irTraceLength() {
+    return symbols.size();
+}
+
+unsigned long irTraceSymbol(unsigned int i) {
+    return symbols[i];
+}
+
+unsigned int irTraceLengths() {
+    std::map<unsigned long, int> lengths;
+    for (size_t i = 0; i < symbols.size(); i++) {
+        lengths[symbols[i]]++;
+    }
+    return lengths.size();
+}
+
+unsigned int irTraceKhz() {
+    // setFrequency() sets ICR1 and OCR2A to F_CPU / 2000 / khz
+    unsigned int top = ICR1 ? ICR1 : OCR2A;
+    return top ? F_CPU / 2000 / top : 0;
+}
+
+unsigned long irTraceAirtime() {
+    // up to the end of the last mark, a trailing space is not on the air
+    size_t end = symbols.size() - (symbols.size() % 2 == 0 && !symbols.empty());
+    unsigned long airtime = 0;
+    for (size_t i = 0; i < end; i++) {
+        airtime += symbols[i];
+    }
+    return airtime;
+}
+
+// The most common value at the even (marks) or odd (spaces) positions,
+// spaces only after 'mark'
+static unsigned long mostCommon(bool marks, unsigned long mark, unsigned long except) {
+    std::map<unsigned long, int> count;
+    for (size_t i = marks ? 0 : 1; i < symbols.size(); i += 2) {
+        if (!marks && symbols[i - 1] != mark) {
+            continue;
+        }
+        if (symbols[i] != except) {
+            count[symbols[i]]++;
+        }
+    }
+    unsigned long best = 0;
+    int bestCount = 0;
+    for (std::map<unsigned long, int>::iterator it = count.begin(); it != count.end(); it++) {
+        if (it->second > bestCount) {
+            best = it->first;
+            bestCount = it->second;
+        }
+    }
+    return best;
+}
+
+// Bits collected so far as hex bytes and the rest as "b<bits>"
+static std::string bitToken(const std::vector<bool> &bits) {
+    std::ostringstream token;
+    const char *hex = "0123456789abcdef";
+    size_t i = 0;
+    for (; i + 8 <= bits.size(); i += 8) {
+        uint8_t value = 0;
+        for (int b = 0; b < 8; b++) {
+            value |= bits[i + b] << b;
+        }
+        token << hex[value >> 4] << hex[value & 0x0F];
+    }
+    if (i < bits.size()) {
+        token << (i ? " b" : "b");
+        for (; i < bits.size(); i++) {
+            token << (bits[i] ? '1' : '0');
+        }
+    }
+    return token.str();
+}
+
+std::string irTraceDecode() {
+    unsigned long bitMark = mostCommon(true, 0, 0);
+    unsigned long zero = mostCommon(false, bitMark, 0);
+    unsigned long one = mostCommon(false, bitMark, zero);
+    if (one && one < zero) {
+        unsigned long t = one;
+        one = zero;
+        zero = t;
+    }
+
+    std::ostringstream out;
+    std::vector<bool> bits;
+    const char *separator = "";
+
+    for (size_t i = 0; i < symbols.size(); i += 2) {
+        unsigned long mark = symbols[i];
+        unsigned long space = i + 1 < symbols.size() ? symbols[i + 1] : 0;
+        if (mark == bitMark && space && (space == zero || space == one)) {
+            bits.push_back(space == one);
+            continue;
+        }
+        if (!bits.empty()) {
+            out << separator << bitToken(bits);
+            bits.clear();
+            separator = " ";
+        }
+        out << separator << 'm' << mark;
+        if (space) {
+            out << " s" << space;
+        }
+        separator = " ";
+    }
+    if (!bits.empty()) {
+        out << separator << bitToken(bits);
+    }
+    return out.str();
+}
@@ -0,0 +1,62 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// Host stand-in for the parts of the Arduino AVR core HeatpumpIR uses. The
+// PWM registers are plain variables and the delays do not wait, they hand
+// the time and the state of the IR output to IRTrace instead.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define F_CPU 16000000UL
+
+#define PROGMEM
+#define pgm_read_byte(x) (*(const uint8_t *)(x))
+#define pgm_read_byte_near(x) pgm_read_byte(x)
+#define memcpy_P memcpy
+
+#define _BV(bit) (1 << (bit))
+
+#define LOW    0
+#define HIGH   1
+#define INPUT  0
+#define OUTPUT 1
+
+// Timer 1 and 2 of the ATmega328P, bit positions as in <avr/io.h>
+extern uint8_t TCCR1A, TCCR1B, TCCR2A, TCCR2B, OCR2A, OCR2B;
+extern uint16_t ICR1, OCR1A, OCR1B;
+
+#define CS10   0
+#define WGM13  4
+#define WGM11  1
+#define COM1B1 5
+#define COM1A1 7
+#define CS20   0
+#define WGM20  0
+#define WGM22  3
+#define COM2B1 5
+#define COM2A1 7
+
+#define F(x) (x)
+
+// Serial output is dropped
+class HardwareSerial {
+  public:
+    void begin(unsigned long) {}
+    void print(const char *) {}
+    void println(const char *) {}
+};
+
+extern HardwareSerial Serial;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long micros(void);
+
+#endif // Arduino_h
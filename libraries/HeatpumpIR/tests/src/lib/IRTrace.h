@@ -0,0 +1,36 @@
+#ifndef IRTrace_h
+#define IRTrace_h
+
+#include <stdint.h>
+#include <string>
+
+// Records what an IRSender on pin 3, 9, 10 or 11 puts on the air. Each delay
+// of the host Arduino.h becomes a mark if the PWM output of one of the pins
+// is on, otherwise a space. Consecutive symbols of the same kind are merged,
+// as they are on the air.
+
+void irTraceReset();
+
+// Number of marks and spaces recorded since irTraceReset()
+unsigned int irTraceLength();
+
+// Mark or space at 'i', in microseconds, marks at the even positions
+unsigned long irTraceSymbol(unsigned int i);
+
+// Number of different mark and space lengths
+unsigned int irTraceLengths();
+
+// Carrier frequency of the last setFrequency() in kHz
+unsigned int irTraceKhz();
+
+// Time on the air in microseconds, up to the end of the last mark
+unsigned long irTraceAirtime();
+
+// The trace decoded as pulse distance code: the most common mark with the
+// two most common spaces after it are the bits (LSB first, as
+// IRSender::sendIRbyte() sends them), the bytes are printed in hex. Any other
+// mark or space is printed as "m<us>" or "s<us>", incomplete bytes as
+// "b<bits>". E.g. "m3500 s1750 0220e004 m435 s10000 ..."
+std::string irTraceDecode();
+
+#endif
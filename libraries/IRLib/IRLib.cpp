@@ -402,15 +402,67 @@ bool IRdecodeBase::decodeGeneric(unsigned char Raw_Count, unsigned int Head_Mark
  * protocols you don't use.
  * Note: Don't forget to call IRrecvBase::resume(); after decoding is complete.
  */
+/*
+ * Rather than handing the frame to every decoder in turn, IRdecode::decode looks at
+ * the number of samples and the header mark once and only calls the decoders whose
+ * protocol could possibly match. Each row of the table below is a necessary condition
+ * for its decoder: the allowed range of rawlen and the allowed range of the first mark.
+ * When a row matches, the full decoder is still called to do the real work so the
+ * results are exactly the same as calling them one after the other. Rows are kept in
+ * the original trial order and a protocol is never tried twice. A mark range of
+ * 0 to 0xffff means the protocol does its own custom header checks.
+ * To add your own protocol, add a row here and a case to the switch in decode().
+ */
+#ifdef IRLIB_USE_PERCENT
+#define MATCH_LOW(e) PERCENT_LOW(e)
+#define MATCH_HIGH(e) PERCENT_HIGH(e)
+#else
+#define MATCH_LOW(e) ((e)-DEFAULT_ABS_TOLERANCE)
+#define MATCH_HIGH(e) ((e)+DEFAULT_ABS_TOLERANCE)
+#endif
+#define MIN_RC5_SAMPLES 11
+#define MIN_RC6_SAMPLES 1
+
+typedef struct {
+  IRTYPES type;
+  unsigned char rawlen_min, rawlen_max;
+  unsigned int mark_low, mark_high;
+} IRdecodeCandidate;
+
+static const IRdecodeCandidate IRdecodeCandidates[] PROGMEM = {
+  {NEC,           4,                 4,      0,                       0xffff},//repeat
+  {NEC,           68,                68,     MATCH_LOW(564*16),       MATCH_HIGH(564*16)},
+  {SONY,          2*8+2,             2*20+2, MATCH_LOW(600*4),        MATCH_HIGH(600*4)},
+  {RC5,           MIN_RC5_SAMPLES+2, 255,    MATCH_LOW(RC5_T1),       MATCH_HIGH(3*RC5_T1)},
+  {RC6,           MIN_RC6_SAMPLES,   255,    MATCH_LOW(RC6_HDR_MARK), MATCH_HIGH(RC6_HDR_MARK)},
+  {PANASONIC_OLD, 48,                48,     MATCH_LOW(833*4),        MATCH_HIGH(833*4)},
+  {NECX,          68,                68,     MATCH_LOW(564*8),        MATCH_HIGH(564*8)},
+  {JVC,           36,                36,     MATCH_LOW(525*16),       MATCH_HIGH(525*16)},
+  {JVC,           34,                34,     MATCH_LOW(525),          MATCH_HIGH(525)}//repeat
+//{ADDITIONAL,    min, max, mark_low, mark_high},//add additional protocols here
+};
+
 bool IRdecode::decode(void) {
-  if (IRdecodeNEC::decode()) return true;
-  if (IRdecodeSony::decode()) return true;
-  if (IRdecodeRC5::decode()) return true;
-  if (IRdecodeRC6::decode()) return true;
-  if (IRdecodePanasonic_Old::decode()) return true;
-  if (IRdecodeNECx::decode()) return true;
-  if (IRdecodeJVC::decode()) return true;
-//if (IRdecodeADDITIONAL::decode()) return true;//add additional protocols here
+  unsigned int head= (rawlen>1)? rawbuf[1]: 0;
+  unsigned int tried= 0;
+  IRdecodeCandidate c;
+  for(unsigned char i=0; i<sizeof(IRdecodeCandidates)/sizeof(IRdecodeCandidate); i++) {
+    memcpy_P(&c, &IRdecodeCandidates[i], sizeof(c));
+    if(rawlen<c.rawlen_min || rawlen>c.rawlen_max) continue;
+    if(head<c.mark_low || head>c.mark_high) continue;
+    if(tried & (1<<c.type)) continue;
+    tried |= (1<<c.type);
+    switch(c.type) {
+      case NEC:           if (IRdecodeNEC::decode()) return true; break;
+      case SONY:          if (IRdecodeSony::decode()) return true; break;
+      case RC5:           if (IRdecodeRC5::decode()) return true; break;
+      case RC6:           if (IRdecodeRC6::decode()) return true; break;
+      case PANASONIC_OLD: if (IRdecodePanasonic_Old::decode()) return true; break;
+      case NECX:          if (IRdecodeNECx::decode()) return true; break;
+      case JVC:           if (IRdecodeJVC::decode()) return true; break;
+    //case ADDITIONAL:    if (IRdecodeADDITIONAL::decode()) return true; break;
+    }
+  }
 //Deliberately did not add hash code decoding. If you get decode_type==UNKNOWN and
 // you want to know a hash code you can call IRhash::decode() yourself.
 // BTW This is another reason we separated IRrecv from IRdecode.
@@ -561,9 +613,6 @@ IRdecodeRC::RCLevel IRdecodeRC::getRClevel(unsigned char *used, const unsigned i
   return val;   
 }
 
-#define MIN_RC5_SAMPLES 11
-#define MIN_RC6_SAMPLES 1
-
 bool IRdecodeRC5::decode(void) {
   IRLIB_ATTEMPT_MESSAGE(F("RC5"));
   if (rawlen < MIN_RC5_SAMPLES + 2) return RAW_COUNT_ERROR;
@@ -900,6 +949,8 @@ void do_Blink(void) {
  * The original IRrecv which uses 50s timer driven interrupts to sample input pin.
  */
 void IRrecv::resume() {
+  // with a ring buffer the capture never stops
+  if (irparams.ringbuf) return;
   // initialize state machine variables
   irparams.rcvstate = STATE_IDLE;
   IRrecvBase::resume();
@@ -915,7 +966,44 @@ void IRrecv::enableIRIn(void) {
   sei();
 }
 
+/*
+ * Normally the ISR stops after each frame until resume() is called, and frames arriving
+ * while the sketch decodes are lost. With a ring buffer the ISR keeps capturing and
+ * queues each completed frame in the buffer, GetResults then returns them oldest first.
+ * Each frame takes its number of entries plus one; frames that don't fit in the free
+ * space of the buffer are dropped. Frames longer than RAWBUF are cut at RAWBUF entries
+ * like without the ring buffer. The decoders still decode from their own rawbuf, which
+ * by default is irparams.rawbuf; that is no longer written by the ISR.
+ */
+void IRrecv::UseRingBuf(unsigned int *buf, unsigned int size) {
+  cli();
+  irparams.ringbuf = buf;
+  irparams.ringsize = size;
+  irparams.ringhead = irparams.ringtail = 0;
+  irparams.rawlen = 0;
+  irparams.rcvstate = STATE_IDLE;
+  sei();
+}
+
 bool IRrecv::GetResults(IRdecodeBase *decoder) {
+  if (irparams.ringbuf) {
+    cli();
+    unsigned int head = irparams.ringhead;
+    sei();
+    unsigned int pos = irparams.ringtail;
+    if (pos == head) return false;
+    decoder->Reset();
+    decoder->rawlen = irparams.ringbuf[pos];
+    for(unsigned char i=0; i<decoder->rawlen; i++) {
+      if (++pos == irparams.ringsize) pos = 0;
+      decoder->rawbuf[i]=irparams.ringbuf[pos]*USECPERTICK + ( (i % 2)? -Mark_Excess:Mark_Excess);
+    }
+    if (++pos == irparams.ringsize) pos = 0;
+    cli();
+    irparams.ringtail = pos;
+    sei();
+    return true;
+  }
   if (irparams.rcvstate != STATE_STOP) return false;
   IRrecvBase::GetResults(decoder,USECPERTICK);
   return true;
@@ -923,6 +1011,49 @@ bool IRrecv::GetResults(IRdecodeBase *decoder) {
 
 #define _GAP 5000 // Minimum map between transmissions
 #define GAP_TICKS (_GAP/USECPERTICK)
+
+/*
+ * Helpers for the ISR below which record either into irparams.rawbuf or, if
+ * IRrecv::UseRingBuf was called, into the ring of frames.
+ */
+static inline void IRrecv_ring_put(unsigned int value) {
+  unsigned int next = irparams.ringwrite + 1;
+  if (next == irparams.ringsize) next = 0;
+  if (next == irparams.ringtail) irparams.ringfull = true;
+  if (!irparams.ringfull) {
+    irparams.ringbuf[irparams.ringwrite] = value;
+    irparams.ringwrite = next;
+  }
+}
+static inline void IRrecv_start_frame(void) {
+  irparams.rawlen = 0;
+  if (irparams.ringbuf) {
+    // reserve the entry for the frame length
+    irparams.ringfull = false;
+    irparams.ringwrite = irparams.ringhead;
+    IRrecv_ring_put(0);
+  }
+}
+static inline void IRrecv_store(void) {
+  if (irparams.ringbuf) {
+    IRrecv_ring_put(irparams.timer);
+    irparams.rawlen++;
+  } 
+  else {
+    irparams.rawbuf[irparams.rawlen++] = irparams.timer;
+  }
+}
+static inline void IRrecv_end_frame(void) {
+  if (irparams.ringbuf) {
+    // publish the frame, unless it was dropped
+    if (!irparams.ringfull) {
+      irparams.ringbuf[irparams.ringhead] = irparams.rawlen;
+      irparams.ringhead = irparams.ringwrite;
+    }
+    irparams.rawlen = 0;
+  }
+  irparams.rcvstate = STATE_STOP;
+}
 /*
  * This interrupt service routine is only used by IRrecv and may or may not be used by other
  * extensions of the IRrecBase. It is timer driven interrupt code to collect raw data.
@@ -939,7 +1070,7 @@ ISR(TIMER_INTR_NAME)
   irparams.timer++; // One more 50us tick
   if (irparams.rawlen >= RAWBUF) {
     // Buffer overflow
-    irparams.rcvstate = STATE_STOP;
+    IRrecv_end_frame();
   }
   switch(irparams.rcvstate) {
   case STATE_IDLE: // In the middle of a gap
@@ -950,8 +1081,8 @@ ISR(TIMER_INTR_NAME)
       } 
       else {
         // gap just ended, record duration and start recording transmission
-        irparams.rawlen = 0;
-        irparams.rawbuf[irparams.rawlen++] = irparams.timer;
+        IRrecv_start_frame();
+        IRrecv_store();
         irparams.timer = 0;
         irparams.rcvstate = STATE_MARK;
       }
@@ -959,14 +1090,14 @@ ISR(TIMER_INTR_NAME)
     break;
   case STATE_MARK: // timing MARK
     if (irdata == IR_SPACE) {   // MARK ended, record time
-      irparams.rawbuf[irparams.rawlen++] = irparams.timer;
+      IRrecv_store();
       irparams.timer = 0;
       irparams.rcvstate = STATE_SPACE;
     }
     break;
   case STATE_SPACE: // timing SPACE
     if (irdata == IR_MARK) { // SPACE just ended, record it
-      irparams.rawbuf[irparams.rawlen++] = irparams.timer;
+      IRrecv_store();
       irparams.timer = 0;
       irparams.rcvstate = STATE_MARK;
     } 
@@ -976,7 +1107,7 @@ ISR(TIMER_INTR_NAME)
         // Mark current code as ready for processing
         // Switch to STOP
         // Don't reset timer; keep counting space width
-        irparams.rcvstate = STATE_STOP;
+        IRrecv_end_frame();
       } 
     }
     break;
@@ -984,6 +1115,10 @@ ISR(TIMER_INTR_NAME)
     if (irdata == IR_MARK) { // reset gap timer
       irparams.timer = 0;
     }
+    else if (irparams.ringbuf && irparams.timer > GAP_TICKS) {
+      // with a ring buffer go on with the next frame by itself
+      irparams.rcvstate = STATE_IDLE;
+    }
     break;
   default:
     // what of STATE_UNKNOWN and STATE_RUNNING?
@@ -992,6 +1127,80 @@ ISR(TIMER_INTR_NAME)
   do_Blink();
 }
 
+#ifdef IR_ICP_PIN
+/*
+ * IRrecvICP timestamps edges with the input capture unit of timer 1, see IRLib.h.
+ * The timer runs freely with prescale 8. Each capture toggles the edge to look for next
+ * and moves the compare match to _ICP_GAP after the edge; if that fires, no edge came
+ * for the gap and the sequence is complete. Durations are recorded in microseconds.
+ * Only the capture interrupt is enabled while waiting for a sequence.
+ */
+#define _ICP_GAP 10000 // Gap in microseconds ending a sequence, same as IRrecvPCI
+#define ICP_GAP_TICKS ((unsigned int)(_ICP_GAP * CLKSPERUSEC))
+
+IRrecvICP::IRrecvICP(void):IRrecvBase(IR_ICP_PIN) {
+}
+
+void IRrecvICP::enableIRIn(void) {
+  cli();
+  TCCR1A = 0;
+  TCCR1B = _BV(ICNC1) | _BV(CS11); // noise canceler, prescale 8, falling edge
+  TCCR1C = 0;
+  sei();
+  IRrecvBase::enableIRIn();
+}
+
+void IRrecvICP::resume(void) {
+  cli();
+  IRrecvBase::resume();
+  irparams.rcvstate = STATE_IDLE;
+  // IR receivers are active low, so a sequence starts with a falling edge
+  TCCR1B &= ~_BV(ICES1);
+  TIFR1 = _BV(ICF1) | _BV(OCF1A);
+  TIMSK1 = _BV(ICIE1);
+  sei();
+}
+
+bool IRrecvICP::GetResults(IRdecodeBase *decoder) {
+  if (irparams.rcvstate != STATE_STOP) return false;
+  IRrecvBase::GetResults(decoder);
+  return true;
+}
+
+static inline void IRrecvICP_stop(void) {
+  TIMSK1 = 0;
+  irparams.rcvstate = STATE_STOP;
+}
+
+ISR(TIMER1_CAPT_vect)
+{
+  unsigned int capture = ICR1;
+  // look for the opposite edge next, changing the edge may set the capture flag
+  TCCR1B ^= _BV(ICES1);
+  OCR1A = capture + ICP_GAP_TICKS;
+  TIFR1 = _BV(ICF1) | _BV(OCF1A);
+  if (irparams.rcvstate == STATE_IDLE) {
+    // first mark, the length of the gap before it is not measured
+    irparams.rawbuf[0] = 0;
+    irparams.rawlen = 1;
+    irparams.rcvstate = STATE_RUNNING;
+    TIMSK1 = _BV(ICIE1) | _BV(OCIE1A);
+  }
+  else {
+    irparams.rawbuf[irparams.rawlen++] = (unsigned int)(capture - (unsigned int)irparams.timer) / CLKSPERUSEC;
+    if (irparams.rawlen >= RAWBUF) IRrecvICP_stop();
+  }
+  irparams.timer = capture;
+  do_Blink();
+}
+
+// no edge for _ICP_GAP, the sequence is complete
+ISR(TIMER1_COMPA_vect)
+{
+  IRrecvICP_stop();
+}
+#endif
+
 /*
  * The hardware specific portions of IRsendBase
  */
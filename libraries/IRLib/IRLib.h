@@ -271,6 +271,7 @@ public:
   bool GetResults(IRdecodeBase *decoder);
   void enableIRIn(void);
   void resume(void);
+  void UseRingBuf(unsigned int *buf, unsigned int size);//capture into a ring of frames, see IRLib.cpp
 };
 /* This receiver uses no interrupts or timers. Other interrupt driven receivers
  * allow you to do other things and call GetResults at your leisure to see if perhaps
@@ -309,6 +310,24 @@ private:
   unsigned char intrnum;
 };
 
+/* This receiver uses the input capture unit of timer 1. The hardware latches the timer
+ * value at every edge of the input, so edges are timestamped to 0.5s at 16 MHz no matter
+ * when the interrupt gets to run, and no interrupts occur while nothing is received.
+ * The end of a sequence is detected with a compare match 10ms after the last edge, so
+ * unlike IRrecvPCI it stops by itself. It only works on the input capture pin, pin 8 on
+ * Uno type boards and pin 4 on Leonardo. It takes timer 1 away from anything else,
+ * e.g. the Servo library, so it has to be enabled with IRLIB_USE_ICP in IRLibTimer.h, and
+ * is not available if IRLibTimer.h selects timer 1 for sending.
+ */
+class IRrecvICP: public IRrecvBase
+{
+public:
+  IRrecvICP(void);
+  bool GetResults(IRdecodeBase *decoder);
+  void enableIRIn(void);
+  void resume(void);
+};
+
 
 //Do the actual blinking off and on
 //This is not part of IRrecvBase because it may need to be inside an ISR
@@ -48,6 +48,14 @@ typedef struct {
   unsigned long timer;     // state timer, counts 50uS ticks.(and other uses)
   unsigned int rawbuf[RAWBUF]; // raw data
   unsigned char rawlen;         // counter of entries in rawbuf
+  // Optional ring of completed frames, see IRrecv::UseRingBuf. Each frame is
+  // stored as its number of entries followed by the entries.
+  unsigned int *ringbuf;        // NULL unless a ring buffer is used
+  unsigned int ringsize;        // entries in ringbuf
+  unsigned int ringhead;        // end of the completed frames
+  unsigned int ringtail;        // start of the oldest frame not yet read
+  unsigned int ringwrite;       // write position of the frame being captured
+  bool ringfull;                // frame being captured does not fit, it is dropped
 } 
 irparams_t;
 extern volatile irparams_t irparams;
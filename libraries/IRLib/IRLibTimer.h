@@ -87,6 +87,20 @@
   #define IR_USE_TIMER2     // tx = pin 3
 #endif
 
+// IRrecvICP receives with the input capture unit of timer 1. It claims the timer 1 capture and
+// compare interrupts, which conflicts with Servo, PulseTrain and other timer 1 users, so it has
+// to be enabled here. Not available when timer 1 is used for sending.
+//#define IRLIB_USE_ICP
+
+// Input capture pin of timer 1 used by IRrecvICP
+#if defined(IRLIB_USE_ICP) && !defined(IR_USE_TIMER1)
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__)
+  #define IR_ICP_PIN 8      // ICP1 = PB0
+#elif defined(__AVR_ATmega32U4__) && !defined(CORE_TEENSY)
+  #define IR_ICP_PIN 4      // ICP1 = PD4 on Leonardo
+#endif
+#endif
+
 
 
 
@@ -16,6 +16,19 @@ void InterruptChainLink::init(InterruptCallback callbackIn, InterruptChainLink *
 InterruptChainLink *InterruptChain::chain[MAX_INTERRUPTS] = {NULL};
 byte InterruptChain::mode[MAX_INTERRUPTS] = {CHANGE};
 
+byte InterruptChain::deferred = 0;
+#ifdef __AVR__
+volatile uint8_t *InterruptChain::levelReg[MAX_INTERRUPTS];
+uint8_t InterruptChain::levelMask[MAX_INTERRUPTS];
+#else
+byte InterruptChain::levelPin[MAX_INTERRUPTS];
+#endif
+volatile InterruptChainEvent InterruptChain::queue[INTERRUPTCHAIN_QUEUE_SIZE];
+volatile byte InterruptChain::queueHead = 0;
+volatile byte InterruptChain::queueTail = 0;
+volatile byte InterruptChain::overrunCount = 0;
+InterruptChainEvent InterruptChain::currentEvent;
+
 void InterruptChain::setMode(byte interruptNr, byte modeIn) {     
     mode[interruptNr] = modeIn;
 }
@@ -59,6 +72,10 @@ void InterruptChain::disable(byte interruptNr) {
 }
 
 void InterruptChain::processInterrupt0() {
+	if (deferred & (1 << 0)) {
+		queueEdge(0);
+		return;
+	}
 	InterruptChainLink *current = chain[0];
 	while(current) {
 		(current->callback)();
@@ -67,6 +84,10 @@ void InterruptChain::processInterrupt0() {
 }
 
 void InterruptChain::processInterrupt1() {     
+	if (deferred & (1 << 1)) {
+		queueEdge(1);
+		return;
+	}
     InterruptChainLink *current = chain[1];
 	while(current) {
 		(current->callback)();
@@ -75,6 +96,10 @@ void InterruptChain::processInterrupt1() {
 }
 
 void InterruptChain::processInterrupt2() {     
+	if (deferred & (1 << 2)) {
+		queueEdge(2);
+		return;
+	}
     InterruptChainLink *current = chain[2];
 	while(current) {
 		(current->callback)();
@@ -83,6 +108,10 @@ void InterruptChain::processInterrupt2() {
 }
 
 void InterruptChain::processInterrupt3() {     
+	if (deferred & (1 << 3)) {
+		queueEdge(3);
+		return;
+	}
     InterruptChainLink *current = chain[3];
 	while(current) {
 		(current->callback)();
@@ -91,6 +120,10 @@ void InterruptChain::processInterrupt3() {
 }
 
 void InterruptChain::processInterrupt4() {     
+	if (deferred & (1 << 4)) {
+		queueEdge(4);
+		return;
+	}
     InterruptChainLink *current = chain[4];
 	while(current) {
 		(current->callback)();
@@ -99,9 +132,89 @@ void InterruptChain::processInterrupt4() {
 }
 
 void InterruptChain::processInterrupt5() {     
+	if (deferred & (1 << 5)) {
+		queueEdge(5);
+		return;
+	}
     InterruptChainLink *current = chain[5];
 	while(current) {
 		(current->callback)();
 		current = current->next;
 	}
 }
+
+void InterruptChain::setDeferred(byte interruptNr, byte pin) {
+#ifdef __AVR__
+	levelReg[interruptNr] = portInputRegister(digitalPinToPort(pin));
+	levelMask[interruptNr] = digitalPinToBitMask(pin);
+#else
+	levelPin[interruptNr] = pin;
+#endif
+	noInterrupts();
+	deferred |= (1 << interruptNr);
+	interrupts();
+}
+
+void InterruptChain::setImmediate(byte interruptNr) {
+	noInterrupts();
+	deferred &= ~(1 << interruptNr);
+	interrupts();
+}
+
+void InterruptChain::queueEdge(byte interruptNr) {
+	unsigned long time = micros();
+	byte next = (queueHead + 1) & (INTERRUPTCHAIN_QUEUE_SIZE - 1);
+
+	if (next == queueTail) {
+		if (overrunCount < 255) {
+			overrunCount++;
+		}
+		return;
+	}
+
+	volatile InterruptChainEvent *event = &queue[queueHead];
+	event->interruptNr = interruptNr;
+#ifdef __AVR__
+	event->level = (*levelReg[interruptNr] & levelMask[interruptNr]) ? HIGH : LOW;
+#else
+	event->level = digitalRead(levelPin[interruptNr]);
+#endif
+	event->time = time;
+	queueHead = next; // Publish the event only after it is complete
+}
+
+void InterruptChain::runChain(byte interruptNr) {
+	InterruptChainLink *current = chain[interruptNr];
+	while(current) {
+		(current->callback)();
+		current = current->next;
+	}
+}
+
+boolean InterruptChain::dispatch() {
+	boolean dispatched = false;
+
+	while (queueTail != queueHead) {
+		volatile InterruptChainEvent *event = &queue[queueTail];
+		currentEvent.interruptNr = event->interruptNr;
+		currentEvent.level = event->level;
+		currentEvent.time = event->time;
+		queueTail = (queueTail + 1) & (INTERRUPTCHAIN_QUEUE_SIZE - 1);
+
+		runChain(currentEvent.interruptNr);
+		dispatched = true;
+	}
+	return dispatched;
+}
+
+unsigned long InterruptChain::eventTime() {
+	return currentEvent.time;
+}
+
+byte InterruptChain::eventLevel() {
+	return currentEvent.level;
+}
+
+byte InterruptChain::overruns() {
+	return overrunCount;
+}
@@ -14,8 +14,20 @@
 // Arduino Mega has 6 interrupts. For smaller Arduinos and / or to save a few bytes memory you can lower it to 2 or even 1. Don't go higher than 6 tho.
 #define MAX_INTERRUPTS 6
 
+// Number of edges the deferred mode can hold until dispatch() is called. Must be a power of 2.
+#define INTERRUPTCHAIN_QUEUE_SIZE 16
+
 typedef void (*InterruptCallback)();
 
+/**
+ * An edge recorded in deferred mode.
+ */
+struct InterruptChainEvent {
+	byte interruptNr;
+	byte level;					// HIGH or LOW, read right after the edge
+	unsigned long time;			// micros() of the edge
+};
+
 /**
  * For internal use
  */
@@ -69,11 +81,64 @@ class InterruptChain {
 		 * @param modeIn LOW, CHANGE, RISING or FALLING
 		 */
 		static void setMode(byte interruptNr, byte modeIn);
+
+		/**
+		 * Switch given interrupt to deferred mode. The interrupt then only stores the time
+		 * and level of the edge in a queue, which takes the same short time however many
+		 * callbacks are chained. The callbacks are called later from dispatch(), where
+		 * eventTime() and eventLevel() tell when the edge happened and what the level was.
+		 *
+		 * @param interruptNr Interrupt to defer
+		 * @param pin The pin of this interrupt, to read the level from
+		 */
+		static void setDeferred(byte interruptNr, byte pin);
+
+		/**
+		 * Switch given interrupt back to calling the callbacks from the interrupt.
+		 */
+		static void setImmediate(byte interruptNr);
+
+		/**
+		 * Calls the callbacks for all queued edges, oldest first. Call this often from loop().
+		 *
+		 * @return true if at least one edge was dispatched
+		 */
+		static boolean dispatch();
+
+		/**
+		 * Time (micros()) and level of the edge being dispatched. Only valid within a
+		 * callback called from dispatch().
+		 */
+		static unsigned long eventTime();
+		static byte eventLevel();
+
+		/**
+		 * Number of edges lost because the queue was full (saturates at 255). A non-zero
+		 * value means dispatch() isn't called often enough, or the queue is too small.
+		 */
+		static byte overruns();
 	
 	private:
 		static InterruptChainLink *chain[MAX_INTERRUPTS];
 		static byte mode[MAX_INTERRUPTS];
 
+		static byte deferred;		// bit n set: interrupt n is deferred
+#ifdef __AVR__
+		static volatile uint8_t *levelReg[MAX_INTERRUPTS];
+		static uint8_t levelMask[MAX_INTERRUPTS];
+#else
+		static byte levelPin[MAX_INTERRUPTS];
+#endif
+		static volatile InterruptChainEvent queue[INTERRUPTCHAIN_QUEUE_SIZE];
+		static volatile byte queueHead;		// written by the interrupt only
+		static volatile byte queueTail;		// written by dispatch() only
+		static volatile byte overrunCount;
+		static InterruptChainEvent currentEvent;
+
+		static void queueEdge(byte interruptNr);
+
+		static void runChain(byte interruptNr);
+
 		static void processInterrupt0();
 
 		static void processInterrupt1();
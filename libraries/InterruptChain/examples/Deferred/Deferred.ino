@@ -0,0 +1,106 @@
+/**
+ * Demo of deferred interrupt handling, with all 433MHz decoders sharing one receiver:
+ * KaKu (RemoteSwitch), new KaKu (NewRemoteSwitch), thermo/hygro sensors (RemoteSensor)
+ * and Oregon V2 and V3 sensors (Oregon).
+ *
+ * In deferred mode the interrupt only records the time of each edge. The decoders run
+ * from loop() through InterruptChain::dispatch(), using the recorded times, so they can't
+ * disturb each other's timing and the interrupt itself stays short. A frame is only lost
+ * if loop() falls behind by more than INTERRUPTCHAIN_QUEUE_SIZE edges, see overruns().
+ *
+ * Hardware setup for this example:
+ *  - Connect the data output of a 433MHz receiver to digital pin 2.
+ */
+
+#include <InterruptChain.h>
+#include <RemoteReceiver.h>
+#include <NewRemoteReceiver.h>
+#include <SensorReceiver.h>
+#include <EEPROM.h>
+#include <Oregon.h>
+
+OregonDecoderV3 orscV3;
+
+void remoteEdge() {
+  RemoteReceiver::handleEdge(InterruptChain::eventTime());
+}
+
+void newRemoteEdge() {
+  NewRemoteReceiver::handleEdge(InterruptChain::eventTime());
+}
+
+void sensorEdge() {
+  SensorReceiver::handleEdge(InterruptChain::eventTime());
+}
+
+void showOregon(const char *version, DecodeOOK &decoder) {
+  byte length;
+  const byte *data = decoder.getData(length);
+  Serial.print(version);
+  for (byte i = 0; i < length; i++) {
+    Serial.print(data[i] >> 4, HEX);
+    Serial.print(data[i] & 0x0F, HEX);
+  }
+  Serial.println();
+  decoder.resetDecoder();
+}
+
+void oregonEdge() {
+  unsigned long time = InterruptChain::eventTime();
+  if (orscV2.nextEdge(time)) {
+    showOregon("Oregon V2 ", orscV2);
+  }
+  if (orscV3.nextEdge(time)) {
+    showOregon("Oregon V3 ", orscV3);
+  }
+}
+
+void showOldCode(unsigned long receivedCode, unsigned int period) {
+  Serial.print("Old remote ");
+  Serial.print(receivedCode);
+  Serial.print(", period ");
+  Serial.println(period);
+}
+
+void showCode(NewRemoteCode receivedCode) {
+  Serial.print("Remote ");
+  Serial.print(receivedCode.address);
+  Serial.print(" unit ");
+  Serial.println(receivedCode.unit);
+}
+
+void showTempHumi(byte *data) {
+  int temp;
+  byte channel, randomId, humidity;
+  SensorReceiver::decodeThermoHygro(data, channel, randomId, temp, humidity);
+  Serial.print("Sensor channel ");
+  Serial.print(channel);
+  Serial.print(": ");
+  Serial.print(temp / 10.0);
+  Serial.print(" C, ");
+  Serial.print(humidity);
+  Serial.println("%");
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  // Interrupt -1: the decoders don't attach to the interrupt themselves.
+  RemoteReceiver::init(-1, 2, showOldCode);
+  NewRemoteReceiver::init(-1, 2, showCode);
+  SensorReceiver::init(-1, showTempHumi);
+
+  InterruptChain::setDeferred(0, 2);
+  InterruptChain::addInterruptCallback(0, remoteEdge);
+  InterruptChain::addInterruptCallback(0, newRemoteEdge);
+  InterruptChain::addInterruptCallback(0, sensorEdge);
+  InterruptChain::addInterruptCallback(0, oregonEdge);
+}
+
+void loop() {
+  InterruptChain::dispatch();
+
+  if (InterruptChain::overruns()) {
+    Serial.println("Edges lost, call dispatch() more often");
+  }
+}
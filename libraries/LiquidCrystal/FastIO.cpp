@@ -156,6 +156,50 @@ void fio_shiftOut (fio_register dataRegister, fio_bit dataBit,
 }
 
 
+bool fio_spiInit(fio_register dataRegister, fio_bit dataBit, 
+                 fio_register clockRegister, fio_bit clockBit)
+{
+#if defined(__AVR__) && defined(SPCR)
+   if (dataRegister != portOutputRegister(digitalPinToPort(MOSI)) ||
+       dataBit != digitalPinToBitMask(MOSI) ||
+       clockRegister != portOutputRegister(digitalPinToPort(SCK)) ||
+       clockBit != digitalPinToBitMask(SCK))
+   {
+      return false;
+   }
+   // an SS input pulled low would switch the SPI to slave mode
+   pinMode(SS, OUTPUT);
+   return true;
+#else
+   (void)dataRegister;
+   (void)dataBit;
+   (void)clockRegister;
+   (void)clockBit;
+   return false;
+#endif
+}
+
+void fio_spiShiftOut(uint8_t value)
+{
+#if defined(__AVR__) && defined(SPCR)
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+      uint8_t spcr = SPCR;
+      uint8_t spsr = SPSR;
+      
+      SPCR = _BV(SPE) | _BV(MSTR);  // MSB first, mode 0
+      SPSR = _BV(SPI2X);            // F_CPU/2
+      SPDR = value;
+      while (!(SPSR & _BV(SPIF)));
+      
+      SPCR = spcr;
+      SPSR = spsr;
+   }
+#else
+   (void)value;
+#endif
+}
+
 void fio_shiftOut(fio_register dataRegister, fio_bit dataBit, 
                   fio_register clockRegister, fio_bit clockBit)
 {
@@ -183,6 +183,30 @@ void fio_shiftOut( fio_register dataRegister, fio_bit dataBit, fio_register cloc
  */
 void fio_shiftOut(fio_register dataRegister, fio_bit dataBit, fio_register clockRegister, fio_bit clockBit);
 
+/*!
+ @function
+ @abstract prepares shift out with the hardware SPI
+ @discussion checks that the data and clock pins are the MOSI and SCK pins
+ of the hardware SPI and makes SS an output so the SPI stays in master mode.
+ Only AVRs are supported, everywhere else this function returns false.
+ @param dataRegister[in] Register of data pin
+ @param dataBit[in] Bit of data pin
+ @param clockRegister[in] Register of clock pin
+ @param clockBit[in] Bit of clock pin
+ @result true if fio_spiShiftOut() can be used for these pins
+ */
+bool fio_spiInit(fio_register dataRegister, fio_bit dataBit, fio_register clockRegister, fio_bit clockBit);
+
+/*!
+ @method
+ @abstract hardware SPI shift out
+ @discussion shifts out a byte MSB first at F_CPU/2 in SPI mode 0, the same
+ waveform as fio_shiftOut() with MSBFIRST. The SPI settings of other devices
+ on the bus are restored afterwards. Needs a successful fio_spiInit().
+ @param value[in] value to shift out
+ */
+void fio_spiShiftOut(uint8_t value);
+
 /*!
  * @method
  * @abstract one wire shift out
@@ -35,6 +35,13 @@
 #include <../Wire/Wire.h>
 #include "I2CIO.h"
 
+// Largest burst that fits the Wire transmit buffer
+#ifdef BUFFER_LENGTH
+#define I2CIO_BURST_MAX BUFFER_LENGTH
+#else
+#define I2CIO_BURST_MAX 32
+#endif
+
 // CLASS VARIABLES
 // ---------------------------------------------------------------------------
 
@@ -47,6 +54,9 @@ I2CIO::I2CIO ( )
    _dirMask     = 0xFF;    // mark all as INPUTs
    _shadow      = 0x0;     // no values set
    _initialised = false;
+   _burst       = 0;
+   _burstLen    = 0;
+   _burstStatus = 0;
 }
 
 // PUBLIC METHODS
@@ -136,6 +146,27 @@ int I2CIO::write ( uint8_t value )
       // Only write HIGH the values of the ports that have been initialised as
       // outputs updating the output shadow of the device
       _shadow = ( value & ~(_dirMask) );
+      
+      if ( _burst )
+      {
+         // Start a new transmission when the Wire buffer is full
+         if ( _burstLen == I2CIO_BURST_MAX )
+         {
+            if ( Wire.endTransmission () != 0 )
+            {
+               _burstStatus = -1;
+            }
+            Wire.beginTransmission ( _i2cAddr );
+            _burstLen = 0;
+         }
+#if (ARDUINO <  100)
+         Wire.send ( _shadow );
+#else
+         Wire.write ( _shadow );
+#endif
+         _burstLen++;
+         return ( _burstStatus == 0 );
+      }
    
       Wire.beginTransmission ( _i2cAddr );
 #if (ARDUINO <  100)
@@ -193,6 +224,34 @@ int I2CIO::digitalWrite ( uint8_t pin, uint8_t level )
    return ( status );
 }
 
+//
+// beginBurst
+void I2CIO::beginBurst ( void )
+{
+   if ( _initialised && _burst++ == 0 )
+   {
+      Wire.beginTransmission ( _i2cAddr );
+      _burstLen    = 0;
+      _burstStatus = 0;
+   }
+}
+
+//
+// endBurst
+int I2CIO::endBurst ( void )
+{
+   if ( _burst == 0 || --_burst != 0 )
+   {
+      return ( _burstStatus == 0 );
+   }
+   
+   if ( Wire.endTransmission () != 0 )
+   {
+      _burstStatus = -1;
+   }
+   return ( _burstStatus == 0 );
+}
+
 //
 // PRIVATE METHODS
 // ---------------------------------------------------------------------------
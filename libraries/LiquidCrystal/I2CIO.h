@@ -135,6 +135,28 @@ public:
     */   
    int digitalWrite ( uint8_t pin, uint8_t level );
    
+   /*!
+    @method
+    @abstract   Start a burst of writes.
+    @discussion Until the matching endBurst, write and digitalWrite append
+    their value to a single I2C transmission instead of opening one each.
+    The PCF8574 latches every byte of a transmission on its outputs, so the
+    pins change in the same order as before, only without the start, address
+    and stop overhead per byte. Bursts can be nested, the transmission is
+    only closed by the outermost endBurst. Long bursts are split when the
+    Wire buffer is full.
+    */
+   void beginBurst ( void );
+   
+   /*!
+    @method
+    @abstract   End a burst of writes.
+    @discussion Sends the values collected since beginBurst.
+    
+    @result     1 on success, 0 otherwise.
+    */
+   int endBurst ( void );
+   
    
    
 private:
@@ -142,6 +164,9 @@ private:
    uint8_t _dirMask;     // Direction mask
    uint8_t _i2cAddr;     // I2C address
    bool    _initialised; // Initialised object
+   uint8_t _burst;       // Nesting level of beginBurst
+   uint8_t _burstLen;    // Bytes queued in the current transmission
+   int     _burstStatus; // endTransmission status of a split burst
    
 };
 
@@ -33,6 +33,7 @@
 // @author F. Malpartida - fmalpartida@gmail.com
 // ---------------------------------------------------------------------------
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
 
@@ -49,7 +50,10 @@
 // Constructor
 LCD::LCD () 
 {
-   
+   _shadow   = NULL;
+   _addr     = 0;
+   _addrSync = false;
+   _busyTime = 0;
 }
 
 // PUBLIC METHODS
@@ -76,6 +80,8 @@ LCD::LCD ()
 //
 void LCD::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) 
 {
+   setShadow ( false );           // the geometry may change, see setShadow
+   
    if (lines > 1) 
    {
       _displayfunction |= LCD_2LINE;
@@ -166,36 +172,70 @@ void LCD::begin(uint8_t cols, uint8_t lines, uint8_t dotsize)
 void LCD::clear()
 {
    command(LCD_CLEARDISPLAY);             // clear display, set cursor position to zero
-   delayMicroseconds(HOME_CLEAR_EXEC);    // this command is time consuming
+   setBusy(HOME_CLEAR_EXEC);              // this command is time consuming
+   
+   if ( _shadow != NULL )
+   {
+      memset ( _shadow, ' ', _cols * _numlines );
+   }
+   _addr     = 0;
+   _addrSync = true;
 }
 
 void LCD::home()
 {
    command(LCD_RETURNHOME);             // set cursor position to zero
-   delayMicroseconds(HOME_CLEAR_EXEC);  // This command is time consuming
+   setBusy(HOME_CLEAR_EXEC);            // This command is time consuming
+   _addr     = 0;
+   _addrSync = true;
 }
 
 void LCD::setCursor(uint8_t col, uint8_t row)
 {
-   const byte row_offsetsDef[]   = { 0x00, 0x40, 0x14, 0x54 }; // For regular LCDs
-   const byte row_offsetsLarge[] = { 0x00, 0x40, 0x10, 0x50 }; // For 16x4 LCDs
+   _addr     = ddramAddr ( col, row );
+   _addrSync = false;
    
-   if ( row >= _numlines ) 
+   // With the shadow buffer the command is deferred until a character
+   // actually has to be sent, unless the cursor is visible.
+   if ( _shadow == NULL || (_displaycontrol & (LCD_CURSORON | LCD_BLINKON)) )
    {
-      row = _numlines-1;    // rows start at 0
+      syncAddr ();
    }
-   
-   // 16x4 LCDs have special memory map layout
-   // ----------------------------------------
-   if ( _cols == 16 && _numlines == 4 )
+}
+
+bool LCD::busy ( void )
+{
+   if ( _busyTime != 0 && ( micros() - _busyStart ) > _busyTime )
    {
-      command(LCD_SETDDRAMADDR | (col + row_offsetsLarge[row]));
+      _busyTime = 0;
    }
-   else 
+   return ( _busyTime != 0 );
+}
+
+bool LCD::setShadow ( bool on )
+{
+   if ( !on )
    {
-      command(LCD_SETDDRAMADDR | (col + row_offsetsDef[row]));
+      free ( _shadow );
+      _shadow = NULL;
+      return false;
    }
    
+   if ( _shadow == NULL )
+   {
+      if ( _cols == 0 || _numlines == 0 )
+      {
+         return false;            // begin has not been called
+      }
+      _shadow = (uint8_t *)malloc ( _cols * _numlines );
+      if ( _shadow == NULL )
+      {
+         return false;
+      }
+   }
+   
+   clear ();                      // bring the LCD and the shadow in sync
+   return true;
 }
 
 // Turn the display on/off
@@ -219,6 +259,7 @@ void LCD::noCursor()
 }
 void LCD::cursor() 
 {
+   syncAddr ();
    _displaycontrol |= LCD_CURSORON;
    command(LCD_DISPLAYCONTROL | _displaycontrol);
 }
@@ -232,6 +273,7 @@ void LCD::noBlink()
 
 void LCD::blink() 
 {
+   syncAddr ();
    _displaycontrol |= LCD_BLINKON;
    command(LCD_DISPLAYCONTROL | _displaycontrol);
 }
@@ -264,12 +306,16 @@ void LCD::rightToLeft(void)
 // This method moves the cursor one space to the right
 void LCD::moveCursorRight(void)
 {
+   syncAddr ();
+   stepAddr ( true );
    command(LCD_CURSORSHIFT | LCD_CURSORMOVE | LCD_MOVERIGHT);
 }
 
 // This method moves the cursor one space to the left
 void LCD::moveCursorLeft(void)
 {
+   syncAddr ();
+   stepAddr ( false );
    command(LCD_CURSORSHIFT | LCD_CURSORMOVE | LCD_MOVELEFT);
 }
 
@@ -298,9 +344,11 @@ void LCD::createChar(uint8_t location, uint8_t charmap[])
    
    for (uint8_t i = 0; i < 8; i++)
    {
-      write(charmap[i]);      // call the virtual write method
+      waitReady();
+      send(charmap[i], DATA); // CGRAM data, must not go through the shadow
       delayMicroseconds(40);
    }
+   _addrSync = false;         // the address counter now points to CGRAM
 }
 
 #ifdef __AVR__
@@ -313,9 +361,11 @@ void LCD::createChar(uint8_t location, const unsigned char charmap[])
    
    for (uint8_t i = 0; i < 8; i++)
    {
-      write(pgm_read_byte_near(charmap++));
+      waitReady();
+      send(pgm_read_byte_near(charmap++), DATA);
       delayMicroseconds(40);
    }
+   _addrSync = false;
 }
 #endif // __AVR__
 
@@ -353,18 +403,143 @@ void LCD::off ( void )
 // ---------------------------------------------------------------------------
 void LCD::command(uint8_t value) 
 {
+   waitReady();
    send(value, COMMAND);
 }
 
 #if (ARDUINO <  100)
 void LCD::write(uint8_t value)
 {
-   send(value, DATA);
+   putChar(value);
 }
 #else
 size_t LCD::write(uint8_t value) 
 {
-   send(value, DATA);
+   putChar(value);
    return 1;             // assume OK
 }
 #endif
+
+// PROTECTED METHODS
+// ---------------------------------------------------------------------------
+void LCD::setBusy ( uint16_t uSec )
+{
+   _busyStart = micros();
+   _busyTime  = uSec;
+}
+
+// PRIVATE METHODS
+// ---------------------------------------------------------------------------
+void LCD::waitReady ( void )
+{
+   // Strictly greater, micros() has a 4us resolution on 16MHz AVRs
+   while ( _busyTime != 0 && ( micros() - _busyStart ) <= _busyTime )
+   {
+   }
+   _busyTime = 0;
+}
+
+uint8_t LCD::ddramAddr ( uint8_t col, uint8_t row )
+{
+   const byte row_offsetsDef[]   = { 0x00, 0x40, 0x14, 0x54 }; // For regular LCDs
+   const byte row_offsetsLarge[] = { 0x00, 0x40, 0x10, 0x50 }; // For 16x4 LCDs
+   
+   if ( row >= _numlines ) 
+   {
+      row = _numlines-1;    // rows start at 0
+   }
+   
+   // 16x4 LCDs have special memory map layout
+   // ----------------------------------------
+   if ( _cols == 16 && _numlines == 4 )
+   {
+      return col + row_offsetsLarge[row];
+   }
+   else 
+   {
+      return col + row_offsetsDef[row];
+   }
+}
+
+int LCD::shadowIndex ( uint8_t addr )
+{
+   for ( uint8_t row = 0; row < _numlines; row++ )
+   {
+      uint8_t first = ddramAddr ( 0, row );
+      
+      if ( addr >= first && addr < first + _cols )
+      {
+         return row * _cols + ( addr - first );
+      }
+   }
+   return -1;
+}
+
+void LCD::stepAddr ( bool right )
+{
+   // 2 line mode has two 40 character lines at 0x00 and 0x40, 1 line mode a
+   // single 80 character line. The address counter wraps between them.
+   if ( _displayfunction & LCD_2LINE )
+   {
+      if ( right )
+      {
+         _addr = ( _addr == 0x27 ) ? 0x40 : ( _addr == 0x67 ) ? 0x00 : _addr + 1;
+      }
+      else
+      {
+         _addr = ( _addr == 0x40 ) ? 0x27 : ( _addr == 0x00 ) ? 0x67 : _addr - 1;
+      }
+   }
+   else
+   {
+      if ( right )
+      {
+         _addr = ( _addr >= 0x4F ) ? 0x00 : _addr + 1;
+      }
+      else
+      {
+         _addr = ( _addr == 0x00 ) ? 0x4F : _addr - 1;
+      }
+   }
+}
+
+void LCD::syncAddr ( void )
+{
+   if ( !_addrSync )
+   {
+      command(LCD_SETDDRAMADDR | _addr);
+      _addrSync = true;
+   }
+}
+
+void LCD::putChar ( uint8_t value )
+{
+   waitReady ();
+   if ( _shadow == NULL )
+   {
+      send(value, DATA);
+      return;
+   }
+   
+   int  cell  = shadowIndex ( _addr );
+   bool right = _displaymode & LCD_ENTRYLEFT;
+   
+   // Skip characters the LCD already shows. A visible cursor and autoscroll
+   // depend on every character being written, so those are always sent.
+   if ( cell >= 0 && _shadow[cell] == value &&
+        !(_displaycontrol & (LCD_CURSORON | LCD_BLINKON)) &&
+        !(_displaymode & LCD_ENTRYSHIFTINCREMENT) )
+   {
+      stepAddr ( right );
+      _addrSync = false;
+      return;
+   }
+   
+   syncAddr ();
+   send(value, DATA);
+   if ( cell >= 0 )
+   {
+      _shadow[cell] = value;
+   }
+   stepAddr ( right );
+}
@@ -434,6 +434,38 @@ public:
     */
    void setCursor(uint8_t col, uint8_t row);
    
+   /*!
+    @function
+    @abstract   Enable or disable the shadow buffer.
+    @discussion Keeps a copy of the display contents in RAM so that write()
+    only sends characters that differ from what the LCD already shows.
+    Consecutive changed characters are sent as one run after a single cursor
+    positioning command, unchanged characters cost nothing on the bus. This
+    is most useful on slow backends (I2C, shift registers) when a whole
+    screen is repainted periodically.
+    
+    Enabling the shadow buffer clears the LCD. It has to be called after begin
+    and begin will release it again. While the cursor is shown, blinking or
+    autoscroll is enabled every character is still sent.
+    
+    @param      on[in] true to enable the shadow buffer, false to release it.
+    @result     true if the shadow buffer is active.
+    */
+   bool setShadow ( bool on );
+   
+   /*!
+    @function
+    @abstract   Check if the LCD is still executing the last command.
+    @discussion clear, home and the backends do not wait for the LCD after
+    sending, they record how long the command takes and the next access
+    waits for whatever is left of that time. Code that runs in between
+    overlaps with the LCD execution time. busy can be polled from loop to
+    skip a display update instead of blocking on it.
+    
+    @result     true if the next access to the LCD would have to wait.
+    */
+   bool busy ( void );
+      
    /*!
     @function
     @abstract   Switch-on the LCD backlight.
@@ -539,7 +571,64 @@ protected:
    uint8_t _cols;             // Number of columns in the LCD
    t_backlighPol _polarity;   // Backlight polarity
    
+   /*!
+    @function
+    @abstract   Mark the LCD busy for a given time.
+    @discussion Backends call this after sending instead of delaying, the
+    next command or data write will wait until the time has elapsed.
+    
+    @param      uSec[in] execution time of what was just sent in microseconds.
+    */
+   void setBusy ( uint16_t uSec );
+   
 private:
+   unsigned long _busyStart;  // micros() when the last command was sent
+   uint16_t _busyTime;        // Execution time of the last command, 0 if done
+   
+   /*!
+    @function
+    @abstract   Wait until the last command has been executed.
+    */
+   void waitReady ( void );
+   
+   uint8_t *_shadow;          // Copy of the display contents, NULL if disabled
+   uint8_t _addr;             // DDRAM address the next character goes to
+   bool    _addrSync;         // LCD address counter is at _addr
+   
+   /*!
+    @function
+    @abstract   DDRAM address of a display position.
+    */
+   uint8_t ddramAddr ( uint8_t col, uint8_t row );
+   
+   /*!
+    @function
+    @abstract   Index of a DDRAM address in the shadow buffer.
+    @result     -1 if the address is not visible on the display.
+    */
+   int shadowIndex ( uint8_t addr );
+   
+   /*!
+    @function
+    @abstract   Advance _addr the way the LCD address counter does.
+    @param      right[in] true if the address increments.
+    */
+   void stepAddr ( bool right );
+   
+   /*!
+    @function
+    @abstract   Send any deferred cursor position to the LCD.
+    */
+   void syncAddr ( void );
+   
+   /*!
+    @function
+    @abstract   Write a character through the shadow buffer.
+    @discussion Sends value to the LCD unless the shadow buffer shows that
+    the LCD already displays it at the current address.
+    */
+   void putChar ( uint8_t value );
+   
    /*!
     @function
     @abstract   Send a command to the LCD.
@@ -147,7 +147,9 @@ void LiquidCrystal::send(uint8_t value, uint8_t mode)
    {
       writeNbits ( value, 4 );
    }
-   waitUsec ( EXEC_TIME ); // wait for the command to execute by the LCD
+#ifndef FAST_MODE
+   setBusy ( EXEC_TIME );  // the LCD executes the command until the next access
+#endif
 }
 
 //
@@ -185,6 +185,33 @@ void LiquidCrystal_I2C::setBacklight( uint8_t value )
    }
 }
 
+//
+// write
+#if (ARDUINO <  100)
+void LiquidCrystal_I2C::write(const uint8_t *buffer, size_t size)
+{
+   _i2cio.beginBurst ();
+   while ( size-- )
+   {
+      LCD::write ( *buffer++ );
+   }
+   _i2cio.endBurst ();
+}
+#else
+size_t LiquidCrystal_I2C::write(const uint8_t *buffer, size_t size)
+{
+   size_t n = 0;
+   
+   _i2cio.beginBurst ();
+   while ( size-- )
+   {
+      n += LCD::write ( *buffer++ );
+   }
+   _i2cio.endBurst ();
+   return n;
+}
+#endif
+
 
 // PRIVATE METHODS
 // ---------------------------------------------------------------------------
@@ -243,6 +270,8 @@ void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode)
    // longer that what is needed both for toggling and enable pin an to execute
    // the command.
    
+   // Both nibbles and their enable pulses go out in one I2C transmission
+   _i2cio.beginBurst ();
    if ( mode == FOUR_BITS )
    {
       write4bits( (value & 0x0F), COMMAND );
@@ -252,6 +281,7 @@ void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode)
       write4bits( (value >> 4), mode );
       write4bits( (value & 0x0F), mode);
    }
+   _i2cio.endBurst ();
 }
 
 //
@@ -144,6 +144,23 @@ public:
     */
    void setBacklight ( uint8_t value );
    
+   /*!
+    @function
+    @abstract   Writes a buffer to the LCD.
+    @discussion All the IO expander updates needed for the buffer are sent
+    in one I2C burst rather than one transmission per enable edge. All the
+    Print class string methods end up calling this method.
+    
+    @param      buffer[in] characters to write.
+    @param      size[in] number of characters.
+    */
+#if (ARDUINO <  100)
+   virtual void write(const uint8_t *buffer, size_t size);
+#else
+   virtual size_t write(const uint8_t *buffer, size_t size);
+#endif
+   using LCD::write;
+   
 private:
    
    /*!
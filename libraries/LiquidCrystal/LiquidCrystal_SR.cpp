@@ -114,6 +114,7 @@ void LiquidCrystal_SR::init(uint8_t srdata, uint8_t srclock, uint8_t enable,
    (void)font;
    // Initialise private variables
    _two_wire = 0;
+   _spi = 0;
    
    _srDataRegister = fio_pinToOutputRegister(srdata);
    _srDataBit = fio_pinToBit(srdata);
@@ -142,12 +143,19 @@ void LiquidCrystal_SR::init(uint8_t srdata, uint8_t srclock, uint8_t enable,
 // shiftIt
 void LiquidCrystal_SR::shiftIt(uint8_t val)
 {
-   if (_two_wire)
+   if (_spi)
    {
-      // Clear to get Enable LOW
-      fio_shiftOut(_srDataRegister, _srDataBit, _srClockRegister, _srClockBit);
+      fio_spiShiftOut(val);
+   }
+   else
+   {
+      if (_two_wire)
+      {
+         // Clear to get Enable LOW
+         fio_shiftOut(_srDataRegister, _srDataBit, _srClockRegister, _srClockBit);
+      }
+      fio_shiftOut(_srDataRegister, _srDataBit, _srClockRegister, _srClockBit, val, MSBFIRST);
    }
-   fio_shiftOut(_srDataRegister, _srDataBit, _srClockRegister, _srClockBit, val, MSBFIRST);
    
    // LCD ENABLE PULSE
    //
@@ -189,16 +197,27 @@ void LiquidCrystal_SR::send(uint8_t value, uint8_t mode)
     * even on AVRs because the shiftout is shorter than the LCD command execution time.
     */
 #if (F_CPU <= 16000000)
-   if(_two_wire)
-   	delayMicroseconds ( 10 );
+   if(_spi)
+   	setBusy ( 37 ); // the SPI takes no time at all
+   else if(_two_wire)
+   	setBusy ( 10 );
    else
-   	delayMicroseconds ( 17 ); // 3 wire mode is faster so it must delay longer
+   	setBusy ( 17 ); // 3 wire mode is faster so it must delay longer
 #else
-   delayMicroseconds ( 37 );      // commands & data writes need > 37us to complete
+   setBusy ( 37 );      // commands & data writes need > 37us to complete
 #endif
 
 }
 
+//
+// useHardwareSPI
+bool LiquidCrystal_SR::useHardwareSPI ( bool on )
+{
+   _spi = on && !_two_wire && fio_spiInit(_srDataRegister, _srDataBit,
+                                          _srClockRegister, _srClockBit);
+   return _spi;
+}
+
 //
 // setBacklightPin
 void LiquidCrystal_SR::setBacklightPin ( uint8_t pin, t_backlighPol pol )
@@ -144,6 +144,19 @@ public:
     */
    void setBacklight ( uint8_t mode );
    
+   /*!
+    @function
+    @abstract   Shifts out with the hardware SPI.
+    @discussion When the data and clock pins are the MOSI and SCK pins of the
+    hardware SPI, the shift register is loaded by the SPI at F_CPU/2 instead
+    of the bit banged fio_shiftOut(). Only supported on AVRs and in three
+    wire mode, as two wire mode strobes the enable line with the data pin.
+    
+    @param      on[in] true to use the hardware SPI, false to bit bang.
+    @result     true if the hardware SPI is used.
+    */
+   bool useHardwareSPI ( bool on = true );
+   
 private:
    
    /*!
@@ -162,6 +175,7 @@ private:
    
    uint8_t _enable_pin;  // Enable Pin
    uint8_t _two_wire;    // two wire mode
+   uint8_t _spi;         // shift register loaded by the hardware SPI
    
    fio_register _srDataRegister; // Serial Data pin
    fio_bit _srDataBit;
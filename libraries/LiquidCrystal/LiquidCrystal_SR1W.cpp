@@ -229,7 +229,7 @@ void LiquidCrystal_SR1W::send(uint8_t value, uint8_t mode)
 	// Make sure we wait at least 40 uS between bytes.
 	unsigned int totalDelay = numDelays * SR1W_DELAY_US;
 	if (totalDelay < 40)
-		delayMicroseconds(40 - totalDelay);
+		setBusy(40 - totalDelay);
 }
 
 //
@@ -108,9 +108,9 @@ void LiquidCrystal_SR2W::send(uint8_t value, uint8_t mode)
 	 * even on slower AVRs.
 	 */
 #if (F_CPU <= 16000000)
-	delayMicroseconds ( 10 );      // commands & data writes need > 37us to complete
+	setBusy ( 10 );      // commands & data writes need > 37us to complete
 #else
-	delayMicroseconds ( 37 );      // commands & data writes need > 37us to complete
+	setBusy ( 37 );      // commands & data writes need > 37us to complete
 #endif
 }
 
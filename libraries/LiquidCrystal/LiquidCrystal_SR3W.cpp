@@ -170,16 +170,27 @@ void LiquidCrystal_SR3W::send(uint8_t value, uint8_t mode)
 
 
 #if (F_CPU <= 16000000)
+   if ( _spi )
+   {
+      setBusy ( 37 );   // the SPI is faster than the LCD
+      return;
+   }
    // No need to use the delay routines on AVR since the time taken to write
    // on AVR with SR pin mapping even with fio is longer than LCD command execution.
    waitUsec(37); //goes away on AVRs
 #else
-   delayMicroseconds ( 37 );      // commands & data writes need > 37us to complete
+   setBusy ( 37 );      // commands & data writes need > 37us to complete
 #endif
 
 }
 
 
+bool LiquidCrystal_SR3W::useHardwareSPI ( bool on )
+{
+   _spi = on && fio_spiInit(_data_reg, _data, _clk_reg, _clk);
+   return _spi;
+}
+
 void LiquidCrystal_SR3W::setBacklightPin ( uint8_t value, t_backlighPol pol = POSITIVE )
 {
    _backlightPinMask = ( 1 << value );
@@ -228,6 +239,7 @@ int LiquidCrystal_SR3W::init(uint8_t data, uint8_t clk, uint8_t strobe,
    _backlightPinMask = 0;
    _backlightStsMask = LCD_NOBACKLIGHT;
    _polarity = POSITIVE;
+   _spi = 0;
    
    _En = ( 1 << En );
    _Rw = ( 1 << Rw );
@@ -272,7 +284,14 @@ void LiquidCrystal_SR3W::write4bits(uint8_t value, uint8_t mode)
 void LiquidCrystal_SR3W::loadSR(uint8_t value) 
 {
    // Load the shift register with information
-   fio_shiftOut(_data_reg, _data, _clk_reg, _clk, value, MSBFIRST);
+   if ( _spi )
+   {
+      fio_spiShiftOut(value);
+   }
+   else
+   {
+      fio_shiftOut(_data_reg, _data, _clk_reg, _clk, value, MSBFIRST);
+   }
    
    // Strobe the data into the latch
    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
@@ -153,6 +153,18 @@ public:
     */
    void setBacklight ( uint8_t value );
    
+   /*!
+    @function
+    @abstract   Shifts out with the hardware SPI.
+    @discussion When the data and clock pins are the MOSI and SCK pins of the
+    hardware SPI, the shift register is loaded by the SPI at F_CPU/2 instead
+    of the bit banged fio_shiftOut(). Only supported on AVRs.
+    
+    @param      on[in] true to use the hardware SPI, false to bit bang.
+    @result     true if the hardware SPI is used.
+    */
+   bool useHardwareSPI ( bool on = true );
+   
 private:
    
    /*!
@@ -195,6 +207,7 @@ private:
    uint8_t      _data_pins[4];     // LCD data lines
    uint8_t      _backlightPinMask; // Backlight IO pin mask
    uint8_t      _backlightStsMask; // Backlight status mask
+   uint8_t      _spi;              // SR loaded by the hardware SPI
    
 };
 
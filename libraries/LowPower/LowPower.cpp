@@ -28,8 +28,15 @@
 #include <avr/wdt.h>
 #include <avr/power.h>
 #include <avr/interrupt.h>
+#include <Arduino.h>
 #include "LowPower.h"
 
+// Shortest watchdog period (nominally 16.384 ms) in us as measured by 
+// calibrate(), period n of period_t is this times 2^n
+static unsigned long wdtPeriodUs = 16384;
+static volatile bool wdtFired = false;
+#define WDT_CALIBRATION_PERIODS	4
+
 // Only Pico Power devices can change BOD settings through software
 #if defined __AVR_ATmega328P__
 #ifndef sleep_bod_disable
@@ -840,6 +847,194 @@ void	LowPowerClass::powerExtStandby(period_t period, adc_t adc, bod_t bod,
 	#endif
 }
 
+/*******************************************************************************
+* Name: calibrate
+* Description: Measures the watchdog period against the system clock. The 
+*			         watchdog runs off an RC oscillator that is only about 10% 
+*			         accurate and drifts with supply voltage and temperature, call
+*			         this every now and then (takes about 70 ms awake) so that 
+*			         powerDownFor() sleeps for the requested time.
+*
+*******************************************************************************/
+void	LowPowerClass::calibrate(void)
+{
+	unsigned long start, total = 0;
+	
+	for (unsigned char i = 0; i < WDT_CALIBRATION_PERIODS; i++)
+	{
+		wdtFired = false;
+		cli();
+		wdt_enable(SLEEP_15Ms);
+		WDTCSR |= (1 << WDIE);
+		start = micros();
+		sei();
+		while (!wdtFired);
+		total += micros() - start;
+	}
+	wdtPeriodUs = total / WDT_CALIBRATION_PERIODS;
+}
+
+/*******************************************************************************
+* Name: powerDownFor
+* Description: Power down for ms milliseconds in as few watchdog periods as 
+*			         possible, using the period lengths measured by calibrate(). 
+*			         Stops early when woken by another interrupt. A rest that is
+*			         shorter than the shortest period is not slept.
+*
+* Argument  	Description
+* =========  	===========
+* 1. ms     	Duration of the sleep in milliseconds.
+*
+* 2. adc		ADC module disable control, see powerDown().
+*
+* 3. bod		Brown Out Detector (BOD) module disable control, see powerDown().
+*
+* Returns the time actually slept in milliseconds.
+*
+*******************************************************************************/
+unsigned long	LowPowerClass::powerDownFor(unsigned long ms, adc_t adc, bod_t bod)
+{
+	unsigned long slept = 0, periodMs;
+	unsigned int sleptUs = 0;
+	
+	// The periods double, so after the longest one each shorter period is 
+	// needed at most once which gives the fewest wake-ups
+	for (signed char period = SLEEP_8S; period >= SLEEP_15Ms; period--)
+	{
+		periodMs = (wdtPeriodUs << period) / 1000;
+		while (slept < ms && ms - slept >= periodMs)
+		{
+			wdtFired = false;
+			powerDown((period_t)period, adc, bod);
+			if (!wdtFired) return slept;	// woken by another interrupt
+			sleptUs += (wdtPeriodUs << period) % 1000;
+			slept += periodMs + sleptUs / 1000;
+			sleptUs %= 1000;
+		}
+	}
+	return slept;
+}
+
+#if defined AS2
+// Timer 2 clocked by a 32.768 kHz crystal on TOSC1/TOSC2, see powerSaveFor()
+#define TIMER2_ASYNC_BUSY	((1 << TCN2UB) | (1 << OCR2AUB) | (1 << OCR2BUB) | \
+							 (1 << TCR2AUB) | (1 << TCR2BUB))
+extern volatile unsigned long timer0_millis;	// Arduino core, millis() counter
+static volatile bool timer2Fired = false;
+
+/*******************************************************************************
+* Name: timer2AsyncSleep
+* Description: Power save for ticks (1 - 256) of Timer 2 with clock select cs.
+*			         The timer wakes the MCU with a compare match B, so Timer 2 
+*			         compare A and overflow stay free for other libraries. 
+*			         Returns the number of timer ticks that passed, fewer if 
+*			         another interrupt woke the MCU up.
+*
+*******************************************************************************/
+static unsigned int timer2AsyncSleep(unsigned char cs, unsigned int ticks, 
+										 adc_t adc, bod_t bod)
+{
+	unsigned int passed;
+	
+	GTCCR |= (1 << PSRASY);	// restart the prescaler, the first tick is a whole one
+	TCNT2 = 0;
+	OCR2B = ticks - 1;			// the flag is set one tick after the match
+	TCCR2B = cs;
+	while (ASSR & TIMER2_ASYNC_BUSY);
+	TIFR2 = (1 << OCF2B);
+	timer2Fired = false;
+	TIMSK2 |= (1 << OCIE2B);
+	LowPower.powerSave(SLEEP_FOREVER, adc, bod, TIMER2_ON);
+	TIMSK2 &= ~(1 << OCIE2B);
+	// TCNT2 reads correctly only after the next TOSC1 edge, a write lets us wait
+	// for it. It also has to pass before the next power save.
+	OCR2B = ticks - 1;
+	while (ASSR & TIMER2_ASYNC_BUSY);
+	passed = timer2Fired ? ticks : TCNT2;
+	TCCR2B = 0;
+	while (ASSR & TIMER2_ASYNC_BUSY);
+	return passed;
+}
+
+/*******************************************************************************
+* Name: powerSaveFor
+* Description: Power save for ms milliseconds, timed by Timer 2 running off a 
+*			         32.768 kHz crystal on TOSC1/TOSC2 (the MCU itself then runs 
+*			         on its internal RC oscillator). Far fewer wake-ups than the
+*			         watchdog: one per 8 s, plus two to time the rest to 1 ms. 
+*			         Stops early when woken by another interrupt. millis() is 
+*			         moved on by the time slept. Timer 2 is taken over, PWM on 
+*			         its pins and tone() are not available. After power-up the 
+*			         crystal needs up to a second to start.
+*
+* Argument  	Description
+* =========  	===========
+* 1. ms     	Duration of the sleep in milliseconds.
+*
+* 2. adc		ADC module disable control, see powerDown().
+*
+* 3. bod		Brown Out Detector (BOD) module disable control, see powerDown().
+*
+* Returns the time actually slept in milliseconds.
+*
+*******************************************************************************/
+unsigned long	LowPowerClass::powerSaveFor(unsigned long ms, adc_t adc, bod_t bod)
+{
+	unsigned long slept = 0, frac = 0, cycles;
+	unsigned int ticks, passed;
+	unsigned char cs, shift;
+	
+	if (!(ASSR & (1 << AS2)))
+	{
+		TIMSK2 = 0;
+		ASSR = (1 << AS2);		// switching the clock may corrupt the Timer 2 registers
+		TCCR2A = 0;
+		TCCR2B = 0;
+		TCNT2 = 0;
+		while (ASSR & TIMER2_ASYNC_BUSY);
+		TIFR2 = (1 << OCF2B) | (1 << OCF2A) | (1 << TOV2);
+	}
+	
+	while (slept < ms)
+	{
+		// 1024 prescaler, 31.25 ms ticks, up to 8 s, then 32 prescaler, 0.98 ms ticks
+		cycles = ms - slept >= 8000 ? 262144UL : ((ms - slept) << 15) / 1000;
+		if (cycles >= 1024)
+		{
+			cs = (1 << CS22) | (1 << CS21) | (1 << CS20);
+			shift = 10;
+		}
+		else if (cycles >= 32)
+		{
+			cs = (1 << CS21) | (1 << CS20);
+			shift = 5;
+		}
+		else break;
+		ticks = cycles >> shift;
+		passed = timer2AsyncSleep(cs, ticks, adc, bod);
+		// count in 1/4096 ms, one crystal cycle is 125/4096 ms
+		frac += ((unsigned long)passed << shift) * 125;
+		slept += frac >> 12;
+		frac &= 4095;
+		if (passed < ticks) break;	// woken by another interrupt
+	}
+	cli();
+	timer0_millis += slept;
+	sei();
+	return slept;
+}
+
+/*******************************************************************************
+* Name: ISR (TIMER2_COMPB_vect)
+* Description: Timer 2 compare match B, the wake-up of powerSaveFor().
+*
+*******************************************************************************/
+ISR (TIMER2_COMPB_vect)
+{
+	timer2Fired = true;
+}
+#endif
+
 /*******************************************************************************
 * Name: ISR (WDT_vect)
 * Description: Watchdog Timer interrupt service routine. This routine is 
@@ -851,6 +1046,7 @@ ISR (WDT_vect)
 {
 	// WDIE & WDIF is cleared in hardware upon entering this ISR
 	wdt_disable();
+	wdtFired = true;
 }
 
 LowPowerClass LowPower;
\ No newline at end of file
@@ -131,6 +131,11 @@ class LowPowerClass
 		void	powerSave(period_t period, adc_t adc, bod_t bod, timer2_t timer2);
 		void	powerStandby(period_t period, adc_t adc, bod_t bod);
 		void	powerExtStandby(period_t period, adc_t adc, bod_t bod, timer2_t timer2);
+		void	calibrate(void);
+		unsigned long	powerDownFor(unsigned long ms, adc_t adc, bod_t bod);
+		#if defined AS2
+			unsigned long	powerSaveFor(unsigned long ms, adc_t adc, bod_t bod);
+		#endif
 };
 
 extern LowPowerClass LowPower;
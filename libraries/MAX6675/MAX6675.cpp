@@ -6,79 +6,94 @@
 */
 
 #include <MAX6675.h>
+#include <SPI.h>
 
-MAX6675::MAX6675(uint8_t CS_pin, uint8_t SO_pin, uint8_t SCK_pin, uint8_t units)
+static boolean spi_started = false;
+
+static void init_pins(uint8_t CS_pin, uint8_t SO_pin, uint8_t SCK_pin)
 {
     pinMode(CS_pin, OUTPUT);
-    pinMode(SO_pin, INPUT);
-    pinMode(SCK_pin, OUTPUT);
-
     digitalWrite(CS_pin, HIGH);
 
+    if (SO_pin != MAX6675_HARDWARE_SPI) {
+        pinMode(SO_pin, INPUT);
+        pinMode(SCK_pin, OUTPUT);
+        digitalWrite(SCK_pin, LOW);
+    }
+}
+
+MAX6675::MAX6675(uint8_t CS_pin, uint8_t SO_pin, uint8_t SCK_pin, uint8_t units)
+{
+    init_pins(CS_pin, SO_pin, SCK_pin);
+
     _CS_pin = CS_pin;
     _SO_pin = SO_pin;
     _SCK_pin = SCK_pin;
     _units = units;
+    _valid = false;
+    _lastRead = millis();   // converting since power up
 }
 
-float MAX6675::read_temp()
+MAX6675::MAX6675(uint8_t CS_pin, uint8_t units)
 {
-    uint16_t value = 0;
-    uint8_t error_tc = 0;
-    float temp = 0.0;
+    init_pins(CS_pin, MAX6675_HARDWARE_SPI, MAX6675_HARDWARE_SPI);
 
-    /*
-      Initiate a temperature conversion. According to MAX's tech notes FAQ's
-      for the chip, Line going high initiates a conversion, which means, we
-      need to clock the chip low to high to initiate the conversion, then wait
-      for the conversion to be complete before trying to read the data from
-      the chip.
-    */
-    digitalWrite(_CS_pin,LOW);
-    delay(2);
-    digitalWrite(_CS_pin,HIGH);
-    delay(220);
+    _CS_pin = CS_pin;
+    _SO_pin = MAX6675_HARDWARE_SPI;
+    _SCK_pin = MAX6675_HARDWARE_SPI;
+    _units = units;
+    _valid = false;
+    _lastRead = millis();
+}
 
-    /* Read the chip and return the raw temperature value */
+uint16_t MAX6675::read_frame(uint8_t CS_pin, uint8_t SO_pin, uint8_t SCK_pin)
+{
+    uint16_t frame = 0;
 
     /*
-      Bring CS pin low to allow us to read the data from
-      the conversion process
-    */
-    digitalWrite(_CS_pin,LOW);
-
-    /* Cycle the clock for dummy bit 15 */
-    digitalWrite(_SCK_pin,HIGH);
-    delay(1);
-    digitalWrite(_SCK_pin,LOW);
-
-     /*
-      Read bits 14-3 from MAX6675 for the Temp. Loop for each bit reading
-      the value and storing the final value in 'temp'
+      The chip converts continuously while CS is high. Bringing CS low stops
+      the conversion and puts bit 15 of the last result on SO, the following
+      bits come out on each falling edge of SCK. CS going high again starts
+      the next conversion.
     */
-    for (int i=11; i>=0; i--) {
-        digitalWrite(_SCK_pin,HIGH);
-        value += digitalRead(_SO_pin) << i;
-        digitalWrite(_SCK_pin,LOW);
+    if (SO_pin == MAX6675_HARDWARE_SPI) {
+        if (!spi_started) {
+            SPI.begin();
+            spi_started = true;
+        }
+#ifdef SPI_HAS_TRANSACTION
+        SPI.beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
+#else
+        SPI.setDataMode(SPI_MODE0);
+        SPI.setBitOrder(MSBFIRST);
+        SPI.setClockDivider(SPI_CLOCK_DIV4);
+#endif
+        digitalWrite(CS_pin, LOW);
+        frame = SPI.transfer(0) << 8;
+        frame |= SPI.transfer(0);
+        digitalWrite(CS_pin, HIGH);
+#ifdef SPI_HAS_TRANSACTION
+        SPI.endTransaction();
+#endif
+    } else {
+        /* digitalWrite() is slower than the 4.3MHz the chip allows, no delays needed */
+        digitalWrite(CS_pin, LOW);
+        for (int i=15; i>=0; i--) {
+            digitalWrite(SCK_pin, HIGH);
+            frame |= (uint16_t)digitalRead(SO_pin) << i;
+            digitalWrite(SCK_pin, LOW);
+        }
+        digitalWrite(CS_pin, HIGH);
     }
 
-    /* Read the TC Input inp to check for TC Errors */
-    digitalWrite(_SCK_pin,HIGH);
-    error_tc = digitalRead(_SO_pin);
-    digitalWrite(_SCK_pin,LOW);
-
-    /*
-      Read the last two bits from the chip, faliure to do so will result
-      in erratic readings from the chip.
-    */
-    for (int i=1; i>=0; i--) {
-        digitalWrite(_SCK_pin,HIGH);
-        delay(1);
-        digitalWrite(_SCK_pin,LOW);
-    }
+    return frame;
+}
 
-    // Disable Device
-    digitalWrite(_CS_pin, HIGH);
+float MAX6675::convert(uint16_t frame, uint8_t units, uint8_t CS_pin)
+{
+    /* Bit 15 is a dummy bit, bits 14-3 are the temperature, bit 2 is set if the TC input is open */
+    uint16_t value = (frame >> 3) & 0x0FFF;
+    float temp = 0.0;
 
     /*
       Keep in mind that the temp that was just read is on the digital scale
@@ -92,18 +107,88 @@ float MAX6675::read_temp()
       1 = temp in deg C
       0 = raw chip value 0-4095
     */
-    if(_units == 2) {
+    if(units == 2) {
         temp = (value*0.25) * 9.0/5.0 + 32.0;
-    } else if(_units == 1) {
+    } else if(units == 1) {
         temp = (value*0.25);
     } else {
         temp = value;
     }
 
     /* Output negative of CS_pin if there is a TC error, otherwise return 'temp' */
-    if(error_tc != 0) {
-        return -_CS_pin;
+    if(frame & 0x04) {
+        return -CS_pin;
     } else {
         return temp;
     }
 }
+
+float MAX6675::read_temp(boolean force)
+{
+    if (!_valid) {
+        /* Wait for the first conversion after power up */
+        while (millis() - _lastRead < MAX6675_CONVERSION_TIME);
+    }
+
+    if (force || !_valid || millis() - _lastRead >= MAX6675_CONVERSION_TIME) {
+        _frame = read_frame(_CS_pin, _SO_pin, _SCK_pin);
+        _lastRead = millis();
+        _valid = true;
+    }
+
+    return convert(_frame, _units, _CS_pin);
+}
+
+MAX6675Scanner::MAX6675Scanner(const uint8_t *CS_pins, uint8_t count, uint8_t SO_pin, uint8_t SCK_pin, uint8_t units)
+{
+    _CS_pins = CS_pins;
+    _count = min(count, (uint8_t)MAX6675_SCANNER_MAX);
+    _SO_pin = SO_pin;
+    _SCK_pin = SCK_pin;
+    _units = units;
+    init();
+}
+
+MAX6675Scanner::MAX6675Scanner(const uint8_t *CS_pins, uint8_t count, uint8_t units)
+{
+    _CS_pins = CS_pins;
+    _count = min(count, (uint8_t)MAX6675_SCANNER_MAX);
+    _SO_pin = MAX6675_HARDWARE_SPI;
+    _SCK_pin = MAX6675_HARDWARE_SPI;
+    _units = units;
+    init();
+}
+
+void MAX6675Scanner::init()
+{
+    for (uint8_t i = 0; i < _count; i++) {
+        init_pins(_CS_pins[i], _SO_pin, _SCK_pin);
+    }
+    _valid = false;
+    _lastRead = millis();
+}
+
+boolean MAX6675Scanner::update(boolean force)
+{
+    if (!force && millis() - _lastRead < MAX6675_CONVERSION_TIME) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < _count; i++) {
+        _frames[i] = MAX6675::read_frame(_CS_pins[i], _SO_pin, _SCK_pin);
+    }
+    _lastRead = millis();
+    _valid = true;
+    return true;
+}
+
+float MAX6675Scanner::read_temp(uint8_t index)
+{
+    if (!_valid) {
+        /* Wait for the first conversion after power up */
+        while (millis() - _lastRead < MAX6675_CONVERSION_TIME);
+    }
+    update();
+
+    return MAX6675::convert(_frames[index], _units, _CS_pins[index]);
+}
@@ -14,17 +14,75 @@
 #include "WProgram.h"
 #endif
 
+/* SO_pin and SCK_pin value for the hardware SPI bus (MISO and SCK) */
+#define MAX6675_HARDWARE_SPI    0xFF
+
+/* Max duration of a conversion in ms. The chip converts continuously while CS is high. */
+#define MAX6675_CONVERSION_TIME 220
+
+/* Max number of chips of a MAX6675Scanner */
+#define MAX6675_SCANNER_MAX     8
+
 class MAX6675
 {
   public:
     MAX6675(uint8_t CS_pin, uint8_t SO_pin, uint8_t SCK_pin, uint8_t units);
-    float read_temp();
+    /* Chip on the hardware SPI bus */
+    MAX6675(uint8_t CS_pin, uint8_t units);
+    /*
+      Returns the last conversion of the chip. Within MAX6675_CONVERSION_TIME
+      of the previous read the chip has no new value, the previous one is
+      returned without accessing the chip. The first read waits for the first
+      conversion. Use force after sleeping, when millis() did not run.
+    */
+    float read_temp(boolean force = false);
+
+    /* Reads the 16 bit frame of the chip at CS_pin */
+    static uint16_t read_frame(uint8_t CS_pin, uint8_t SO_pin, uint8_t SCK_pin);
+    /* Temperature in units of a frame, or -CS_pin if the thermocouple is open */
+    static float convert(uint16_t frame, uint8_t units, uint8_t CS_pin);
   private:
     uint8_t _CS_pin;
     uint8_t _SO_pin;
     uint8_t _SCK_pin;
     uint8_t _units;
-    uint8_t chip_read(uint8_t CS_pin, uint8_t &error_tc);
+    uint16_t _frame;
+    boolean _valid;
+    unsigned long _lastRead;
+};
+
+/*
+  Reads several MAX6675 which share SCK and SO, each with its own CS pin.
+  All chips convert at the same time, so one sweep reads them all at once.
+*/
+class MAX6675Scanner
+{
+  public:
+    /* CS_pins must stay valid, count at most MAX6675_SCANNER_MAX */
+    MAX6675Scanner(const uint8_t *CS_pins, uint8_t count, uint8_t SO_pin, uint8_t SCK_pin, uint8_t units);
+    /* Chips on the hardware SPI bus */
+    MAX6675Scanner(const uint8_t *CS_pins, uint8_t count, uint8_t units);
+    /*
+      Reads all chips if their conversions are done, see MAX6675::read_temp().
+      Returns true when new values were read.
+    */
+    boolean update(boolean force = false);
+    /* Temperature of chip index from the last sweep, as MAX6675::read_temp() */
+    float read_temp(uint8_t index);
+    uint8_t count() {
+      return _count;
+    }
+  private:
+    const uint8_t *_CS_pins;
+    uint8_t _count;
+    uint8_t _SO_pin;
+    uint8_t _SCK_pin;
+    uint8_t _units;
+    uint16_t _frames[MAX6675_SCANNER_MAX];
+    boolean _valid;
+    unsigned long _lastRead;
+
+    void init();
 };
 
 #endif
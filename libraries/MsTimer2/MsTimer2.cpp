@@ -4,6 +4,7 @@
   
   History:
 
+	V0.7 added every()/cancel(), several callbacks on a MSTIMER2_TICK_US tick (Timer2 CPUs only)
   	05Apr2015 TRL V0.6a added support for ATmega1284P
   	29/Dec/11 - V0.6 added support for ATmega32u4, AT90USB646, AT90USB1286 (paul@pjrc.com)
 		some improvements added by Bill Perry
@@ -40,6 +41,50 @@ void (*MsTimer2::func)();
 volatile unsigned long MsTimer2::count;
 volatile char MsTimer2::overflowing;
 volatile unsigned int MsTimer2::tcnt2;
+volatile char MsTimer2::ticking;
+
+#if defined (__AVR_ATmega168__) || defined (__AVR_ATmega48__) || defined (__AVR_ATmega88__) || defined (__AVR_ATmega328P__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega1284P__) || defined(__AVR_ATmega2560__) || defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB1286__)
+#define MSTIMER2_HAS_TICK
+// Timer2 counts to OCR2A and overflows every MSTIMER2_TICK_US
+#if F_CPU >= 4000000UL
+#define MSTIMER2_TICK_PRESCALER 8
+#else
+#define MSTIMER2_TICK_PRESCALER 1
+#endif
+#define MSTIMER2_TICK_COUNTS ((F_CPU / MSTIMER2_TICK_PRESCALER / 1000UL) * MSTIMER2_TICK_US / 1000UL)
+#if MSTIMER2_TICK_COUNTS > 256 || MSTIMER2_TICK_COUNTS < 16
+#error MSTIMER2_TICK_US does not fit Timer2 at this clock
+#endif
+
+namespace MsTimer2 {
+	static volatile unsigned long ticks;
+	static unsigned long period[MSTIMER2_MAX_CALLBACKS];
+	static unsigned long deadline[MSTIMER2_MAX_CALLBACKS];
+	static void (*funcs[MSTIMER2_MAX_CALLBACKS])();
+	// Registered ids, soonest deadline first, so a tick only looks at order[0]
+	static int8_t order[MSTIMER2_MAX_CALLBACKS];
+	static int8_t queued;
+
+	static void insert(int8_t id) {
+		int8_t n = queued++;
+		for (; n > 0 && (long)(deadline[order[n - 1]] - deadline[id]) > 0; n--)
+			order[n] = order[n - 1];
+		order[n] = id;
+	}
+
+	static bool unlink(int8_t id) {
+		int8_t n = 0;
+		while (n < queued && order[n] != id)
+			n++;
+		if (n == queued)
+			return false;
+		queued--;
+		for (; n < queued; n++)
+			order[n] = order[n + 1];
+		return true;
+	}
+}
+#endif
 
 void MsTimer2::set(unsigned long ms, void (*f)()) {
 	float prescaler = 0.0;
@@ -149,6 +194,7 @@ void MsTimer2::set(unsigned long ms, void (*f)()) {
 void MsTimer2::start() {
 	count = 0;
 	overflowing = 0;
+	ticking = 0;
 #if defined (__AVR_ATmega168__) || defined (__AVR_ATmega48__) || defined (__AVR_ATmega88__) || defined (__AVR_ATmega328P__) || defined (__AVR_ATmega1280__) || defined(__AVR_ATmega1284P__) || defined(__AVR_ATmega2560__) || defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB1286__)
 	TCNT2 = tcnt2;
 	TIMSK2 |= (1<<TOIE2);
@@ -177,6 +223,83 @@ void MsTimer2::stop() {
 #endif
 }
 
+/// Call f every us microseconds (rounded to MSTIMER2_TICK_US, at least one tick) from the Timer2 interrupt.
+/// Returns the id for cancel(), -1 if all MSTIMER2_MAX_CALLBACKS are taken or the CPU has no Timer2.
+int8_t MsTimer2::every(unsigned long us, void (*f)()) {
+#ifdef MSTIMER2_HAS_TICK
+	unsigned long p = (us + MSTIMER2_TICK_US / 2) / MSTIMER2_TICK_US;
+	uint8_t oldSREG = SREG;
+	cli();
+	if (!ticking) {
+		// callbacks left from before start() took Timer2 are gone
+		for (int8_t i = 0; i < MSTIMER2_MAX_CALLBACKS; i++)
+			funcs[i] = 0;
+		// fast PWM with TOP = OCR2A, no output, overflow interrupt at TOP
+		TIMSK2 = 0;
+		ASSR &= ~(1<<AS2);
+		TCCR2A = (1<<WGM21) | (1<<WGM20);
+#if MSTIMER2_TICK_PRESCALER == 8
+		TCCR2B = (1<<WGM22) | (1<<CS21);
+#else
+		TCCR2B = (1<<WGM22) | (1<<CS20);
+#endif
+		OCR2A = MSTIMER2_TICK_COUNTS - 1;
+		TCNT2 = 0;
+		ticks = 0;
+		queued = 0;
+		ticking = 1;
+		TIFR2 = (1<<TOV2);
+		TIMSK2 = (1<<TOIE2);
+	}
+	int8_t id = 0;
+	while (id < MSTIMER2_MAX_CALLBACKS && funcs[id])
+		id++;
+	if (id == MSTIMER2_MAX_CALLBACKS) {
+		SREG = oldSREG;
+		return -1;
+	}
+	funcs[id] = f;
+	period[id] = p ? p : 1;
+	deadline[id] = ticks + period[id];
+	insert(id);
+	SREG = oldSREG;
+	return id;
+#else
+	return -1;
+#endif
+}
+
+/// Stop a callback of every(), Timer2 stops with the last one
+void MsTimer2::cancel(int8_t id) {
+#ifdef MSTIMER2_HAS_TICK
+	if (id < 0 || id >= MSTIMER2_MAX_CALLBACKS)
+		return;
+	uint8_t oldSREG = SREG;
+	cli();
+	unlink(id);
+	funcs[id] = 0;
+	if (ticking && !queued) {
+		TIMSK2 &= ~(1<<TOIE2);
+		ticking = 0;
+	}
+	SREG = oldSREG;
+#endif
+}
+
+void MsTimer2::_tick() {
+#ifdef MSTIMER2_HAS_TICK
+	unsigned long now = ++ticks;
+	while (queued && (long)(now - deadline[order[0]]) >= 0) {
+		int8_t id = order[0];
+		unlink(id);
+		// back in the list before the call, so the callback may cancel itself
+		deadline[id] += period[id];
+		insert(id);
+		(*funcs[id])();
+	}
+#endif
+}
+
 void MsTimer2::_overflow() {
 	count += 1;
 	
@@ -194,6 +317,12 @@ ISR(TIMER4_OVF_vect) {
 #else
 ISR(TIMER2_OVF_vect) {
 #endif
+#ifdef MSTIMER2_HAS_TICK
+	if (MsTimer2::ticking) {
+		MsTimer2::_tick();
+		return;
+	}
+#endif
 #if defined (__AVR_ATmega168__) || defined (__AVR_ATmega48__) || defined (__AVR_ATmega88__) || defined (__AVR_ATmega328P__) || defined (__AVR_ATmega1280__) || defined(__AVR_ATmega1284P__) || defined(__AVR_ATmega2560__) || defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB1286__)
 	TCNT2 = MsTimer2::tcnt2;
 #elif defined (__AVR_ATmega128__)
@@ -7,6 +7,14 @@
 #error MsTimer2 library only works on AVR architecture
 #endif
 
+// Tick of the callbacks registered with every(), in microseconds
+#ifndef MSTIMER2_TICK_US
+#define MSTIMER2_TICK_US 100
+#endif
+#ifndef MSTIMER2_MAX_CALLBACKS
+#define MSTIMER2_MAX_CALLBACKS 4
+#endif
+
 namespace MsTimer2 {
 	extern unsigned long msecs;
 	extern void (*func)();
@@ -18,6 +26,13 @@ namespace MsTimer2 {
 	void start();
 	void stop();
 	void _overflow();
+
+	// Several callbacks with their own period on one MSTIMER2_TICK_US tick.
+	// Takes over Timer2 from set()/start(), the other way round as well.
+	extern volatile char ticking;
+	int8_t every(unsigned long us, void (*f)());
+	void cancel(int8_t id);
+	void _tick();
 }
 
 #endif
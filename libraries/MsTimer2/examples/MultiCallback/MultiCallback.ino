@@ -0,0 +1,51 @@
+/*
+  Several callbacks with their own period on one Timer2 tick of
+  MSTIMER2_TICK_US (100us). The LED flashes every half second while
+  pin 8 toggles every 300us, e.g. to drive a buzzer.
+*/
+#include <MsTimer2.h>
+
+#if defined(ARDUINO) && ARDUINO >= 100
+const int led_pin = LED_BUILTIN;	// 1.0 built in LED pin var
+#else
+const int led_pin = 13;			// default to pin 13
+#endif
+const int buzzer_pin = 8;
+int8_t buzzer;
+
+void flash()
+{
+  static boolean output = HIGH;
+
+  digitalWrite(led_pin, output);
+  output = !output;
+}
+
+void buzz()
+{
+  static boolean output = HIGH;
+
+  digitalWrite(buzzer_pin, output);
+  output = !output;
+}
+
+void setup()
+{
+  pinMode(led_pin, OUTPUT);
+  pinMode(buzzer_pin, OUTPUT);
+
+  MsTimer2::every(500000UL, flash); // 500ms period
+  buzzer = MsTimer2::every(300, buzz); // 300us period
+}
+
+void loop()
+{
+  // one second of buzzing, one second of silence
+  delay(1000);
+  if (buzzer >= 0) {
+    MsTimer2::cancel(buzzer);
+    buzzer = -1;
+  } else {
+    buzzer = MsTimer2::every(300, buzz);
+  }
+}
@@ -100,6 +100,227 @@
 // Enables repeater functionality (relays messages from other nodes)
 // #define MY_REPEATER_FEATURE
 
+/**
+ * @def MY_PARENT_DISCOVERY_TIMEOUT
+ * @brief Max time in milliseconds a node listens for parent responses after sending I_FIND_PARENT.
+ *
+ * The search ends earlier when the gateway answered directly or when no better parent showed up
+ * for @ref MY_PARENT_RESPONSE_SLOT milliseconds.
+ */
+#ifndef MY_PARENT_DISCOVERY_TIMEOUT
+#define MY_PARENT_DISCOVERY_TIMEOUT 2000
+#endif
+
+/**
+ * @def MY_PARENT_DISCOVERY_BACKOFF_MIN
+ * @brief Time in milliseconds before repeating an unsuccessful parent search.
+ *
+ * Doubled (with random jitter) after each further failure, up to @ref MY_PARENT_DISCOVERY_BACKOFF_MAX.
+ */
+#ifndef MY_PARENT_DISCOVERY_BACKOFF_MIN
+#define MY_PARENT_DISCOVERY_BACKOFF_MIN 2000
+#endif
+
+/**
+ * @def MY_PARENT_DISCOVERY_BACKOFF_MAX
+ * @brief Upper limit in milliseconds for the parent search backoff.
+ */
+#ifndef MY_PARENT_DISCOVERY_BACKOFF_MAX
+#define MY_PARENT_DISCOVERY_BACKOFF_MAX (5*60*1000ul)
+#endif
+
+/**
+ * @def MY_PARENT_RESPONSE_SLOT
+ * @brief Length in milliseconds of one response slot used by repeaters answering I_FIND_PARENT.
+ *
+ * A repeater answers in the slot given by its distance to the gateway (at a random time within
+ * the slot), so closer parents are heard first.
+ */
+#ifndef MY_PARENT_RESPONSE_SLOT
+#define MY_PARENT_RESPONSE_SLOT 100
+#endif
+
+/**
+ * @def MY_PARENT_RESPONSE_MAX_SLOTS
+ * @brief Distances beyond this share the last response slot.
+ */
+#ifndef MY_PARENT_RESPONSE_MAX_SLOTS
+#define MY_PARENT_RESPONSE_MAX_SLOTS 15
+#endif
+
+// Repeaters answer I_FIND_PARENT on the broadcast pipe and skip their own answer when they
+// overheard an equal or better repeater answering the same node. Answers are not acked then.
+//#define MY_PARENT_RESPONSE_SUPPRESSION
+
+// Selects the parent by link quality instead of hop count alone. ACK success rates of recent
+// transmissions (and the RSSI on RFM69) are turned into an expected number of transmissions (ETX).
+//#define MY_LINK_QUALITY_FEATURE
+
+/**
+ * @def MY_LINK_QUALITY_NEIGHBORS
+ * @brief Number of neighbors whose link quality is tracked by @ref MY_LINK_QUALITY_FEATURE (2 bytes RAM each).
+ */
+#ifndef MY_LINK_QUALITY_NEIGHBORS
+#define MY_LINK_QUALITY_NEIGHBORS 4
+#endif
+
+/**
+ * @def MY_LINK_QUALITY_MAX_ETX
+ * @brief Look for a new parent when the link to the current one needs more transmissions per frame than this.
+ */
+#ifndef MY_LINK_QUALITY_MAX_ETX
+#define MY_LINK_QUALITY_MAX_ETX 3
+#endif
+
+/**
+ * @def MY_LINK_QUALITY_RSSI_WEAK
+ * @brief Parent responses received below this RSSI (dBm) count as one extra hop.
+ */
+#ifndef MY_LINK_QUALITY_RSSI_WEAK
+#define MY_LINK_QUALITY_RSSI_WEAK -90
+#endif
+
+// Remembers the other parents that answered the last search. When the parent fails the node
+// switches to the best of them right away and asks around for better parents in the background,
+// a full search only runs when none is left.
+//#define MY_PARENT_FAILOVER_FEATURE
+
+/**
+ * @def MY_PARENT_CANDIDATES
+ * @brief Number of parents remembered by @ref MY_PARENT_FAILOVER_FEATURE (2 bytes RAM each, 4 with @ref MY_LINK_QUALITY_FEATURE).
+ */
+#ifndef MY_PARENT_CANDIDATES
+#define MY_PARENT_CANDIDATES 3
+#endif
+
+/**
+ * @def MY_TRANSPORT_ATC_NODES
+ * @brief Number of destinations whose transmit power is tracked by @ref MY_RF24_ATC or @ref MY_RFM69_ATC (3 bytes RAM each).
+ */
+#ifndef MY_TRANSPORT_ATC_NODES
+#define MY_TRANSPORT_ATC_NODES 4
+#endif
+
+// Keeps the routing table (or the most recently used part of it) in RAM. Routing lookups
+// no longer hit EEPROM for every forwarded message and changed routes are written back lazily.
+//#define MY_RAM_ROUTING_TABLE_FEATURE
+
+/**
+ * @def MY_RAM_ROUTING_TABLE_SIZE
+ * @brief Number of routes kept in RAM when @ref MY_RAM_ROUTING_TABLE_FEATURE is enabled.
+ *
+ * A size of 256 mirrors the complete routing table. Smaller sizes keep the least recently
+ * used routes only (costs 3 bytes RAM per entry).
+ */
+#ifndef MY_RAM_ROUTING_TABLE_SIZE
+	#if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_SAMD)
+		#define MY_RAM_ROUTING_TABLE_SIZE 256
+	#else
+		#define MY_RAM_ROUTING_TABLE_SIZE 16
+	#endif
+#endif
+
+/**
+ * @def MY_RAM_ROUTING_TABLE_SAVE_INTERVAL_MS
+ * @brief Interval in milliseconds for writing changed routes from RAM back to EEPROM.
+ */
+#ifndef MY_RAM_ROUTING_TABLE_SAVE_INTERVAL_MS
+#define MY_RAM_ROUTING_TABLE_SAVE_INTERVAL_MS (10*60*1000ul)
+#endif
+
+// Enables the outgoing message queue. Messages passed to sendAsync() are buffered and
+// transmitted in the background by process(), similar values for the same child are coalesced.
+//#define MY_TRANSPORT_TX_QUEUE_FEATURE
+
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_SIZE
+ * @brief Number of messages that can be buffered by @ref MY_TRANSPORT_TX_QUEUE_FEATURE.
+ */
+#ifndef MY_TRANSPORT_TX_QUEUE_SIZE
+#define MY_TRANSPORT_TX_QUEUE_SIZE 4
+#endif
+
+/**
+ * @def MY_PRIORITY_HIGH_RETRIES
+ * @brief How many more times a failed PRIORITY_HIGH message is sent (each with the radio's own retries).
+ */
+#ifndef MY_PRIORITY_HIGH_RETRIES
+#define MY_PRIORITY_HIGH_RETRIES 3
+#endif
+
+/**
+ * @def MY_PRIORITY_HIGH_RETRY_DELAY
+ * @brief Milliseconds to wait (and process()) between those sends.
+ */
+#ifndef MY_PRIORITY_HIGH_RETRY_DELAY
+#define MY_PRIORITY_HIGH_RETRY_DELAY 20
+#endif
+
+// The gateway drops a message that repeats one from the same sender within MY_DEDUP_WINDOW_MS:
+// a node whose radio missed the hardware ACK sends it again. Repeated app-level ACK requests
+// are answered once more from the cache, further copies are ignored.
+//#define MY_DEDUP_FEATURE
+
+/**
+ * @def MY_DEDUP_SIZE
+ * @brief Number of recent messages remembered by @ref MY_DEDUP_FEATURE (6 bytes RAM each).
+ */
+#ifndef MY_DEDUP_SIZE
+#define MY_DEDUP_SIZE 8
+#endif
+
+/**
+ * @def MY_DEDUP_WINDOW_MS
+ * @brief Identical messages from a sender closer together than this are treated as one (max 65535).
+ */
+#ifndef MY_DEDUP_WINDOW_MS
+#define MY_DEDUP_WINDOW_MS 300
+#endif
+
+// Repeaters and gateways keep messages for child nodes that could not be delivered (the node was
+// sleeping) and resend them as soon as any message from that node arrives, e.g. the heartbeat
+// of smartSleep(). With all parents running it, MY_SMART_SLEEP_WAIT_DURATION can be cut to a few
+// 10 ms. Signed messages are not kept, their nonce would have expired by then.
+//#define MY_MAILBOX_FEATURE
+
+/**
+ * @def MY_MAILBOX_SIZE
+ * @brief Number of messages kept by @ref MY_MAILBOX_FEATURE for all children together (32 bytes RAM each).
+ *
+ * When full, the oldest message is dropped. A newer value for the same child sensor and type
+ * replaces the one waiting.
+ */
+#ifndef MY_MAILBOX_SIZE
+#define MY_MAILBOX_SIZE 4
+#endif
+
+// Collects child presentations without description made in presentation() into compact frames
+// of up to 11 children. The gateway (this library version or later) expands them for the controller.
+//#define MY_PRESENTATION_BATCH_FEATURE
+
+// Skips waiting for the controller configuration at startup when a configuration from an
+// earlier start is stored in EEPROM. A new configuration is still requested and picked up later.
+//#define MY_FAST_BOOT_FEATURE
+
+// Lets sendAggregated() pack several values of this node into one frame (3 bytes overhead per
+// value instead of a full header). The gateway (this library version or later) expands them.
+//#define MY_AGGREGATION_FEATURE
+
+// Keeps the last value sent with sendIfChanged() for each child so unchanged values are not sent again.
+//#define MY_REPORTING_FEATURE
+
+/**
+ * @def MY_REPORTING_CHILDREN
+ * @brief Number of child/type pairs tracked by @ref MY_REPORTING_FEATURE (10 bytes RAM each).
+ */
+#ifndef MY_REPORTING_CHILDREN
+#define MY_REPORTING_CHILDREN 8
+#endif
+
+// Counts sent, failed, received and forwarded messages and measures the time spent in transportSend(),
+// signing and process() (about 30 bytes RAM). The controller fetches them with I_STATS, see getStats().
+//#define MY_STATS_FEATURE
+
 /**
  * @def MY_SMART_SLEEP_WAIT_DURATION
  * @brief The wait period before going to sleep when using smartSleep-functions.
@@ -111,6 +332,107 @@
 #define MY_SMART_SLEEP_WAIT_DURATION 500
 #endif
 
+/**
+ * @def MY_SLEEP_CALIBRATION_INTERVAL
+ * @brief Sleep time (ms) after which the watchdog period is measured again (AVR).
+ *
+ * The watchdog runs off an RC oscillator that is only about 10% accurate and drifts
+ * with voltage and temperature. Before the first timed sleep, and again after this
+ * much time spent sleeping, its period is measured against the system clock (about
+ * 80ms awake). Timed sleeps then pick their watchdog periods by the measured length
+ * and count the time slept accurately. Set to 0 to use the nominal periods.
+ */
+#ifndef MY_SLEEP_CALIBRATION_INTERVAL
+#define MY_SLEEP_CALIBRATION_INTERVAL 3600000UL
+#endif
+
+/**
+ * @def MY_SLEEP_TIMER2_ASYNC
+ * @brief Time sleep() with Timer2 and a 32.768kHz crystal on TOSC1/TOSC2 (ATmega328P).
+ *
+ * The node sleeps in power-save mode and wakes once per 8s instead of in watchdog periods,
+ * the rest is timed to 1ms. Sleep time is crystal accurate, also when a pin interrupt ends
+ * the sleep early. The MCU has to run on its internal oscillator (the crystal takes the
+ * XTAL pins). Timer2 runs asynchronously from the crystal with its own prescaler for the
+ * whole program, so it is not available to the sketch: no PWM on its pins, no tone(), and
+ * libraries that use Timer2 (e.g. NewPing timer functions, MsTimer2, IRremote) do not work.
+ */
+//#define MY_SLEEP_TIMER2_ASYNC
+
+// Keeps the controller time on the node, see nodeTime(). I_TIME responses set it, the drift of the
+// local clock (nodeMillis()) between them is measured and compensated and the node requests the
+// time again by itself, as rarely as MY_TIME_MAX_ERROR allows.
+//#define MY_LOCAL_CLOCK_FEATURE
+
+/**
+ * @def MY_TIME_MAX_ERROR
+ * @brief Seconds nodeTime() may be off before the next sync (@ref MY_LOCAL_CLOCK_FEATURE).
+ *
+ * The controller sends whole seconds, so this should be 2 or more.
+ */
+#ifndef MY_TIME_MAX_ERROR
+#define MY_TIME_MAX_ERROR 2
+#endif
+
+/**
+ * @def MY_TIME_SYNC_MIN
+ * @brief Shortest time (s) between time syncs (@ref MY_LOCAL_CLOCK_FEATURE), also the one after the first sync.
+ */
+#ifndef MY_TIME_SYNC_MIN
+#define MY_TIME_SYNC_MIN 300
+#endif
+
+/**
+ * @def MY_TIME_SYNC_MAX
+ * @brief Longest time (s) between time syncs (@ref MY_LOCAL_CLOCK_FEATURE).
+ */
+#ifndef MY_TIME_SYNC_MAX
+#define MY_TIME_SYNC_MAX 86400
+#endif
+
+/**
+ * @def MY_TIME_SYNC_RETRY
+ * @brief Seconds after which an unanswered time request is sent again (@ref MY_LOCAL_CLOCK_FEATURE).
+ */
+#ifndef MY_TIME_SYNC_RETRY
+#define MY_TIME_SYNC_RETRY 60
+#endif
+
+/**
+ * @def MY_CONFIG_COMMIT_IDLE
+ * @brief ESP8266: ms without config writes after which they are committed to flash.
+ *
+ * The ESP8266 keeps the config (EEPROM) in a RAM mirror of one flash sector, a commit erases
+ * and rewrites the whole sector. Writes are therefore collected and committed from process()
+ * once no write happened for this long, at the latest MY_CONFIG_COMMIT_TIMEOUT ms after the
+ * first one, and always before a reboot. Changes of the last seconds before a power loss are lost.
+ */
+#ifndef MY_CONFIG_COMMIT_IDLE
+#define MY_CONFIG_COMMIT_IDLE 2000
+#endif
+
+/**
+ * @def MY_CONFIG_COMMIT_TIMEOUT
+ * @brief ESP8266: ms after the first pending config write when it is committed regardless.
+ */
+#ifndef MY_CONFIG_COMMIT_TIMEOUT
+#define MY_CONFIG_COMMIT_TIMEOUT 30000
+#endif
+
+/**
+ * @def MY_CONFIG_LOG_STORE
+ * @brief ESP8266: keep the config in a log-structured store instead of the EEPROM library.
+ *
+ * Every config write appends a small record (4 bytes header plus the changed bytes) to a flash
+ * sector, reads come from a RAM mirror. Only when the sector is full it is compacted into a
+ * second sector, so a sector is erased once per some hundred routing updates instead of for each
+ * of them. The write that fills the sector does the compaction, including the erase (tens of
+ * ms), all others only program their record. Uses two sectors starting at MY_CONFIG_LOG_SECTOR,
+ * by default the EEPROM sector and the last SPIFFS sector (do not use SPIFFS up to its end).
+ * The existing EEPROM config is taken over on the first start.
+ */
+//#define MY_CONFIG_LOG_STORE
+
 /**********************************
 *  Over the air firmware updates
 ***********************************/
@@ -137,11 +459,68 @@
 #define MY_OTA_FLASH_JDECID 0x1F65
 #endif
 
+/**
+ * @def MY_OTA_WINDOW_SIZE
+ * @brief Number of firmware block requests kept outstanding during OTA updates (1-16).
+ *
+ * 1 is stop-and-wait. Larger windows keep the route to the controller busy and accept blocks
+ * out of order, which speeds up updates over several hops considerably.
+ */
+#ifndef MY_OTA_WINDOW_SIZE
+#define MY_OTA_WINDOW_SIZE 1
+#endif
+
+/**
+ * @def MY_OTA_COMPRESSION_FEATURE
+ * @brief Accept compressed and delta firmware images.
+ *
+ * The controller flags such an image by setting bit 15 of the block count in the firmware config
+ * response. Blocks are then fetched in order and decompressed straight into flash, delta copies
+ * read from the running firmware (AVR only). Needs a controller that builds these images.
+ */
+//#define MY_OTA_COMPRESSION_FEATURE
+
+/**
+ * @def MY_OTA_BROADCAST_FEATURE
+ * @brief Take part in firmware updates the controller sends to many nodes at once.
+ *
+ * The controller flags such a session by setting bit 14 of the block count in the firmware config
+ * response it sends to each node, waits a moment for the nodes to erase their flash and then sends
+ * every block once to BROADCAST_ADDRESS. Repeaters pass the stream on. A bitmap of the blocks
+ * received is kept in external flash after the image, the missing ones are requested from the
+ * controller as usual when the stream has been silent for MY_OTA_BROADCAST_TIMEOUT ms.
+ * Not used for compressed images, they are always fetched in order. Requires @ref MY_OTA_FIRMWARE_FEATURE.
+ */
+//#define MY_OTA_BROADCAST_FEATURE
+
+/**
+ * @def MY_OTA_BROADCAST_TIMEOUT
+ * @brief Milliseconds without a broadcast firmware block before missing blocks are requested.
+ */
+#ifndef MY_OTA_BROADCAST_TIMEOUT
+#define MY_OTA_BROADCAST_TIMEOUT 3000
+#endif
+
 
 /**********************************
 *  Gateway config
 ***********************************/
 
+/**
+ * @def MY_GATEWAY_BINARY_PROTOCOL
+ * @brief Talk to the controller in binary frames instead of the text protocol.
+ *
+ * Each message goes to the controller as on air (7 header bytes and the payload, in its binary
+ * payload type) followed by a crc16 (polynomial 0xA001, initial value 0xFFFF, little endian).
+ * The frame is COBS encoded and ends with a zero byte, so the receiver can find the next frame
+ * after a corrupted one. This applies to the serial and Ethernet gateways. The MQTT gateway
+ * publishes the raw message to MY_MQTT_PUBLISH_TOPIC_PREFIX/bin and takes commands from
+ * MY_MQTT_SUBSCRIBE_TOPIC_PREFIX/bin. Messages from the controller use the same format; the
+ * gateway fills in sender, last and version. This needs a controller that speaks the format,
+ * and saves the text conversion of every message.
+ */
+//#define MY_GATEWAY_BINARY_PROTOCOL
+
 /**
  * @def MY_GATEWAY_MAX_RECEIVE_LENGTH
  * @brief Max buffersize needed for messages coming from controller.
@@ -158,12 +537,146 @@
 #define MY_GATEWAY_MAX_SEND_LENGTH 120
 #endif
 
+/**
+ * @def MY_GATEWAY_SERIAL_TX_BUFFER
+ * @brief Size of the queue for messages to the controller of a serial gateway (0, the default,
+ * prints them directly).
+ *
+ * gatewayTransportSend() only queues the message, process() passes it on as far as the serial device
+ * takes it without blocking. A burst of radio messages no longer stalls the radio while the 64 byte
+ * hardware serial buffer is full. When a message does not fit, gatewayTransportSend() waits until the
+ * queue is written out, so nothing is lost; these waits are counted, see gatewayTransportOverflows().
+ * Size it for the longest burst sent in one go (e.g. a presentation) to avoid them. Serial devices
+ * without availableForWrite() are written blocking. On native USB (32u4, SAMD) bytes are collected
+ * into full packets.
+ */
+#ifndef MY_GATEWAY_SERIAL_TX_BUFFER
+#define MY_GATEWAY_SERIAL_TX_BUFFER 0
+#endif
+
 /**
  * @def MY_GATEWAY_MAX_CLIENTS
  * @brief Max number of parallel clients (sever mode).
+ *
+ * The W5100 has 4 sockets, one of which is used by the server, so up to 3 clients are possible there.
  */
 #ifndef MY_GATEWAY_MAX_CLIENTS
-#define MY_GATEWAY_MAX_CLIENTS 1
+	#if defined(MY_GATEWAY_ESP8266)
+		#define MY_GATEWAY_MAX_CLIENTS 3
+	#else
+		#define MY_GATEWAY_MAX_CLIENTS 1
+	#endif
+#endif
+
+/**
+ * @def MY_GATEWAY_TX_BUFFER_SIZE
+ * @brief Size of the outgoing buffer of the Ethernet gateway in server mode, 0 disables batching.
+ *
+ * Messages to the controller are collected here and written as one TCP segment. ESP8266 keeps one
+ * buffer per client, so a slow client only delays itself.
+ */
+#ifndef MY_GATEWAY_TX_BUFFER_SIZE
+	#if defined(MY_GATEWAY_ESP8266)
+		#define MY_GATEWAY_TX_BUFFER_SIZE 512
+	#else
+		#define MY_GATEWAY_TX_BUFFER_SIZE 0
+	#endif
+#endif
+
+/**
+ * @def MY_GATEWAY_TX_FLUSH_INTERVAL
+ * @brief Max time in milliseconds a message waits in the outgoing buffer for others to join the batch.
+ */
+#ifndef MY_GATEWAY_TX_FLUSH_INTERVAL
+#define MY_GATEWAY_TX_FLUSH_INTERVAL 10
+#endif
+
+/**
+ * @def MY_GATEWAY_CLIENT_WRITE_TIMEOUT
+ * @brief Max time in milliseconds a single write to an ESP8266 client may block.
+ */
+#ifndef MY_GATEWAY_CLIENT_WRITE_TIMEOUT
+#define MY_GATEWAY_CLIENT_WRITE_TIMEOUT 20
+#endif
+
+/**
+ * @def MY_GATEWAY_CLIENT_STALL_TIMEOUT
+ * @brief An ESP8266 client that has not accepted any data for this many milliseconds is disconnected.
+ */
+#ifndef MY_GATEWAY_CLIENT_STALL_TIMEOUT
+#define MY_GATEWAY_CLIENT_STALL_TIMEOUT 5000
+#endif
+
+// ESP8266 gateway in server mode: serve the clients from the lwIP TCP callbacks instead of polling
+// every client on each process() pass. Complete messages are queued as they arrive and outgoing data
+// is handed to lwIP whenever the send window opens (one MY_GATEWAY_TX_BUFFER_SIZE buffer per client).
+//#define MY_GATEWAY_ESP8266_ASYNC
+
+/**
+ * @def MY_GATEWAY_RX_QUEUE_SIZE
+ * @brief Messages from the controller queued by @ref MY_GATEWAY_ESP8266_ASYNC until process() handles them.
+ *
+ * When the queue is full further data stays unacknowledged in lwIP, the client then waits for the
+ * TCP window to open.
+ */
+#ifndef MY_GATEWAY_RX_QUEUE_SIZE
+#define MY_GATEWAY_RX_QUEUE_SIZE 8
+#endif
+
+/**
+ * @def MY_MQTT_PUBLISH_QOS
+ * @brief QoS of the messages the MQTT gateway publishes, 0 or 1.
+ *
+ * At QoS 1 a message stays queued until the broker acknowledges it and is sent again after a
+ * reconnect, see @ref MY_MQTT_MAX_INFLIGHT.
+ */
+#ifndef MY_MQTT_PUBLISH_QOS
+	#if defined(MY_GATEWAY_ESP8266)
+		#define MY_MQTT_PUBLISH_QOS 1
+	#else
+		#define MY_MQTT_PUBLISH_QOS 0
+	#endif
+#endif
+
+/**
+ * @def MY_MQTT_MAX_INFLIGHT
+ * @brief Number of QoS 1 messages that can wait for the broker's acknowledge at the same time.
+ *
+ * Each one keeps a copy of its MQTT packet (128 bytes of RAM). When all are taken, new messages are
+ * dropped until an acknowledge arrives.
+ */
+#ifndef MY_MQTT_MAX_INFLIGHT
+#define MY_MQTT_MAX_INFLIGHT 4
+#endif
+
+/**
+ * @def MY_MQTT_SPOOL_SIZE
+ * @brief Number of messages the MQTT gateway keeps while the broker is unreachable, 0 disables the spool.
+ *
+ * When the spool is full the oldest message is dropped. Each message takes sizeof(MyMessage) bytes of RAM.
+ */
+#ifndef MY_MQTT_SPOOL_SIZE
+	#if defined(MY_GATEWAY_ESP8266)
+		#define MY_MQTT_SPOOL_SIZE 32
+	#else
+		#define MY_MQTT_SPOOL_SIZE 0
+	#endif
+#endif
+
+/**
+ * @def MY_MQTT_SPOOL_DRAIN_BURST
+ * @brief Max number of spooled messages published per @ref MY_MQTT_SPOOL_DRAIN_INTERVAL after a reconnect.
+ */
+#ifndef MY_MQTT_SPOOL_DRAIN_BURST
+#define MY_MQTT_SPOOL_DRAIN_BURST 4
+#endif
+
+/**
+ * @def MY_MQTT_SPOOL_DRAIN_INTERVAL
+ * @brief Time in milliseconds between two bursts of spooled messages.
+ */
+#ifndef MY_MQTT_SPOOL_DRAIN_INTERVAL
+#define MY_MQTT_SPOOL_DRAIN_INTERVAL 100
 #endif
 
 
@@ -184,6 +697,11 @@
 
 //#define MY_WITH_LEDS_BLINKING_INVERSE
 
+// Blink the LEDs from the Timer0 compare match A interrupt (AVR) instead of process(), so they
+// keep their timing while the sketch blocks. This takes ISR(TIMER0_COMPA_vect), sketches or
+// libraries that define that vector themselves will not link with it.
+//#define MY_LEDS_TIMER0
+
 // The following defines can be used to set the port pin, that the LED is connected to
 // If one of the following is defined here, or in the sketch, MY_LEDS_BLINKING_FEATURE will be
 // enabled by default. (Replace x with the pin number you have the LED on)
@@ -275,6 +793,42 @@
 #define MY_VERIFICATION_TIMEOUT_MS 5000
 #endif
 
+/**
+ * @def MY_SIGNING_NONCE_POOL_FEATURE
+ * @brief Enable to hand out nonces ahead of time and skip the nonce request when signing.
+ *
+ * A verifying node using @ref MY_SIGNING_SOFT sends a fresh single-use nonce back to the sender
+ * after each successfully verified message. The sender keeps it (for up to @ref MY_SIGNING_NONCE_POOL_SIZE
+ * peers) and signs its next message to that peer right away, without the @ref I_NONCE_REQUEST round trip.
+ * Without a pooled nonce signing falls back to requesting one.<br>
+ * Sleeping nodes have to listen shortly after sending (e.g. smartSleep()) to receive the nonce, and
+ * a timed sleep counts towards its age. Sleep without timeout drops all pooled nonces.
+ */
+//#define MY_SIGNING_NONCE_POOL_FEATURE
+
+/**
+ * @def MY_SIGNING_NONCE_POOL_SIZE
+ * @brief Number of peers to keep pre-pushed nonces for (on each side).
+ */
+#ifndef MY_SIGNING_NONCE_POOL_SIZE
+	#if defined(ARDUINO_ARCH_AVR)
+		#define MY_SIGNING_NONCE_POOL_SIZE 2
+	#else
+		#define MY_SIGNING_NONCE_POOL_SIZE 8
+	#endif
+#endif
+
+/**
+ * @def MY_SIGNING_NONCE_POOL_TIMEOUT_MS
+ * @brief Lifetime of a pre-pushed nonce, enforced by the verifying node.
+ *
+ * Must be the same on both nodes of a sign-verify pair. The sender stops using a nonce
+ * @ref MY_VERIFICATION_TIMEOUT_MS before this to leave time for delivery.
+ */
+#ifndef MY_SIGNING_NONCE_POOL_TIMEOUT_MS
+#define MY_SIGNING_NONCE_POOL_TIMEOUT_MS 600000ul
+#endif
+
 /**
  * @def MY_SIGNING_NODE_WHITELISTING
  * @brief Enable to turn on whitelisting
@@ -300,6 +854,18 @@
 #define MY_SIGNING_ATSHA204_PIN 17
 #endif
 
+/**
+ * @def MY_SIGNING_ATSHA204_SERIAL
+ * @brief Drive the ATSHA204 through a hardware serial port instead of bit banging
+ *
+ * Uses the UART mode of the single-wire interface: TX and RX of the port are both connected
+ * to SDA of the ATSHA204 (TX through a schottky diode, cathode towards TX, and SDA pulled up).
+ * Every bit becomes one character at 230400 baud so interrupts stay enabled during a transfer.
+ * The port can not be used for anything else and the MCU clock has to reach 230400 baud with
+ * little error (16MHz with U2X, 8MHz is too far off). MY_SIGNING_ATSHA204_PIN is not used.
+ */
+//#define MY_SIGNING_ATSHA204_SERIAL Serial1
+
 /**
  * @def MY_SIGNING_SOFT_RANDOMSEED_PIN
  * @brief Pin used for random generation in soft signing
@@ -330,6 +896,14 @@
 #define MY_RS485_MAX_MESSAGE_LENGTH 40
 #endif
 
+/**
+ * @def MY_RS485_IDLE_CHARS
+ * @brief Character times the bus has to be quiet before a node starts sending (plus a random backoff of up to 8).
+ */
+#ifndef MY_RS485_IDLE_CHARS
+#define MY_RS485_IDLE_CHARS 3
+#endif
+
 /**********************************
 *  NRF24L01P Driver Defaults
 ***********************************/
@@ -385,6 +959,33 @@
 #define MY_RF24_PA_LEVEL RF24_PA_MAX
 #endif
 
+/**
+ * @def MY_RF24_ATC
+ * @brief Enables automatic transmit power control.
+ *
+ * The PA level towards each recently used destination is lowered step by step while frames
+ * get through without retransmissions and raised again when retransmissions show up. A frame
+ * lost at a lowered level is repeated at @ref MY_RF24_PA_LEVEL. Broadcasts and ACKs always go
+ * out at @ref MY_RF24_PA_LEVEL.
+ */
+//#define MY_RF24_ATC
+
+/**
+ * @def MY_RF24_ATC_QUIET
+ * @brief Frames without retransmission before @ref MY_RF24_ATC lowers the PA level towards a destination.
+ */
+#ifndef MY_RF24_ATC_QUIET
+#define MY_RF24_ATC_QUIET 8
+#endif
+
+/**
+ * @def MY_RF24_ATC_RETRIES
+ * @brief @ref MY_RF24_ATC raises the PA level when a frame needed more retransmissions than this.
+ */
+#ifndef MY_RF24_ATC_RETRIES
+#define MY_RF24_ATC_RETRIES 2
+#endif
+
 /**
  * @def MY_RF24_CHANNEL
  * @brief RF channel for the sensor net, 0-125.
@@ -403,6 +1004,70 @@
 #define MY_RF24_CHANNEL	76
 #endif
 
+/**
+ * @def MY_RF24_CHANNEL_SCAN
+ * @brief Lets the network move away from a busy channel.
+ *
+ * An I_CHANNEL message from the controller to the gateway with an empty payload makes it survey
+ * the channels @ref MY_RF24_SCAN_FIRST to @ref MY_RF24_SCAN_LAST with the received power detector
+ * of the nRF24 and pick the quietest one (the neighbours count in, Wi-Fi takes up 20 channels),
+ * with a channel as payload that one is taken. The gateway answers with the channel and
+ * broadcasts it, repeaters pass it on and all nodes switch @ref MY_RF24_CHANNEL_DELAY ms after
+ * hearing it. The channel is kept in EEPROM, @ref MY_RF24_CHANNEL is only the starting one.
+ * Nodes that missed the move do not find a parent any more. After @ref MY_RF24_CHANNEL_HOP_AFTER ms
+ * without one they go through the channels of the survey range, every other parent search still
+ * goes to the stored channel so a short outage of the parent does not move them away.
+ */
+//#define MY_RF24_CHANNEL_SCAN
+
+/**
+ * @def MY_RF24_SCAN_FIRST
+ * @brief First channel surveyed by @ref MY_RF24_CHANNEL_SCAN.
+ */
+#ifndef MY_RF24_SCAN_FIRST
+#define MY_RF24_SCAN_FIRST 0
+#endif
+
+/**
+ * @def MY_RF24_SCAN_LAST
+ * @brief Last channel surveyed by @ref MY_RF24_CHANNEL_SCAN, the default keeps within 2400 - 2483,5 Mhz.
+ */
+#ifndef MY_RF24_SCAN_LAST
+#define MY_RF24_SCAN_LAST 83
+#endif
+
+/**
+ * @def MY_RF24_SCAN_SAMPLES
+ * @brief Samples per channel taken by the survey of @ref MY_RF24_CHANNEL_SCAN (up to 255, about 0.3ms each).
+ */
+#ifndef MY_RF24_SCAN_SAMPLES
+#define MY_RF24_SCAN_SAMPLES 100
+#endif
+
+/**
+ * @def MY_RF24_CHANNEL_DELAY
+ * @brief Time (ms) from hearing of a channel move (@ref MY_RF24_CHANNEL_SCAN) to switching over.
+ */
+#ifndef MY_RF24_CHANNEL_DELAY
+#define MY_RF24_CHANNEL_DELAY 2000
+#endif
+
+/**
+ * @def MY_RF24_CHANNEL_HOP_AFTER
+ * @brief Time (ms) without a parent before a node looks for the network on other channels (@ref MY_RF24_CHANNEL_SCAN).
+ */
+#ifndef MY_RF24_CHANNEL_HOP_AFTER
+#define MY_RF24_CHANNEL_HOP_AFTER (30*60*1000ul)
+#endif
+
+/**
+ * @def MY_RF24_CHANNEL_ANNOUNCE
+ * @brief How often gateway and repeaters broadcast a channel move (@ref MY_RF24_CHANNEL_SCAN), broadcasts are not acknowledged.
+ */
+#ifndef MY_RF24_CHANNEL_ANNOUNCE
+#define MY_RF24_CHANNEL_ANNOUNCE 3
+#endif
+
 /**
  * @def MY_RF24_DATARATE
  * @brief RF24 datarate (RF24_250KBPS for 250kbs, RF24_1MBPS for 1Mbps or RF24_2MBPS for 2Mbps).
@@ -439,6 +1104,28 @@
  */
 #define MY_RF24_SANITY_CHECK
 
+/**
+ * @def MY_RF24_IRQ_PIN
+ * @brief Enables interrupt driven reception when the nRF24 IRQ line is connected to this pin.
+ *
+ * Received frames are moved from the radio into a RAM buffer (see @ref MY_RF24_RX_BUFFER_SIZE)
+ * by the interrupt handler, so the 3-level hardware FIFO does not overflow during long
+ * operations in the sketch. Requires hardware SPI and an interrupt capable pin.
+ */
+//#define MY_RF24_IRQ_PIN 2
+
+/**
+ * @def MY_RF24_RX_BUFFER_SIZE
+ * @brief Number of received frames buffered in RAM when @ref MY_RF24_IRQ_PIN is used.
+ */
+#ifndef MY_RF24_RX_BUFFER_SIZE
+	#if defined(ARDUINO_ARCH_AVR)
+		#define MY_RF24_RX_BUFFER_SIZE 4
+	#else
+		#define MY_RF24_RX_BUFFER_SIZE 16
+	#endif
+#endif
+
 // Enable SOFTSPI for NRF24L01, useful for the W5100 Ethernet module
 //#define MY_SOFTSPI
 
@@ -535,6 +1222,69 @@
 // Enables RFM69 encryption (all nodes and gateway must have this enabled, and all must be personalized with the same AES key)
 //#define MY_RFM69_ENABLE_ENCRYPTION
 
+/**
+ * @def MY_RFM69_ATC
+ * @brief Enables automatic transmit power control.
+ *
+ * The RSSI of the ACKs (always sent at full power) tells how well the destination hears us.
+ * The power level towards each recently used destination is lowered until that estimate gets
+ * close to @ref MY_RFM69_ATC_TARGET_RSSI. A frame lost at a lowered level is repeated at full
+ * power. Broadcasts always go out at full power.
+ */
+//#define MY_RFM69_ATC
+
+/**
+ * @def MY_RFM69_ATC_TARGET_RSSI
+ * @brief RSSI (dBm) at the destination that @ref MY_RFM69_ATC aims for.
+ */
+#ifndef MY_RFM69_ATC_TARGET_RSSI
+#define MY_RFM69_ATC_TARGET_RSSI -80
+#endif
+
+/**
+ * @def MY_RFM69_DUTY_CYCLE
+ * @brief Keeps the airtime within a duty cycle limit (e.g. 1% in most EU 868MHz sub-bands).
+ *
+ * The airtime of every frame (retries and ACKs included) is computed from the bit rate and
+ * summed over a sliding window of @ref MY_RFM69_DUTY_CYCLE_WINDOW_MS. Sending fails instead
+ * of exceeding the budget. Firmware blocks (C_STREAM) stop at @ref MY_RFM69_DUTY_CYCLE_BULK
+ * percent of the budget, other messages at @ref MY_RFM69_DUTY_CYCLE_NORMAL percent, the rest
+ * is kept for internal messages, ACKs and messages sent with an ACK request (alarms).
+ */
+//#define MY_RFM69_DUTY_CYCLE
+
+/**
+ * @def MY_RFM69_DUTY_CYCLE_PERMILLE
+ * @brief Allowed airtime of @ref MY_RFM69_DUTY_CYCLE in 1/1000 of the window.
+ */
+#ifndef MY_RFM69_DUTY_CYCLE_PERMILLE
+#define MY_RFM69_DUTY_CYCLE_PERMILLE 10
+#endif
+
+/**
+ * @def MY_RFM69_DUTY_CYCLE_WINDOW_MS
+ * @brief Observation window of @ref MY_RFM69_DUTY_CYCLE, one hour like ETSI EN 300 220.
+ */
+#ifndef MY_RFM69_DUTY_CYCLE_WINDOW_MS
+#define MY_RFM69_DUTY_CYCLE_WINDOW_MS (60*60*1000ul)
+#endif
+
+/**
+ * @def MY_RFM69_DUTY_CYCLE_BULK
+ * @brief Percentage of the airtime budget OTA firmware transfers may use up to.
+ */
+#ifndef MY_RFM69_DUTY_CYCLE_BULK
+#define MY_RFM69_DUTY_CYCLE_BULK 50
+#endif
+
+/**
+ * @def MY_RFM69_DUTY_CYCLE_NORMAL
+ * @brief Percentage of the airtime budget ordinary messages (e.g. periodic values) may use up to.
+ */
+#ifndef MY_RFM69_DUTY_CYCLE_NORMAL
+#define MY_RFM69_DUTY_CYCLE_NORMAL 80
+#endif
+
 /**************************************
 * Ethernet Gateway Transport  Defaults
 ***************************************/
@@ -580,6 +1330,32 @@
 // If MY_CONTROLLER_IP_ADDRESS is left un-defined, gateway acts as server allowing incoming connections.
 //#define MY_CONTROLLER_IP_ADDRESS 192, 168, 178, 254
 
+/**
+ * @def MY_GATEWAY_CONTROLLER_RECONNECT_MIN
+ * @brief Delay in milliseconds before retrying after the first failed connect to the controller (TCP client mode).
+ *
+ * The delay doubles with every failed attempt up to @ref MY_GATEWAY_CONTROLLER_RECONNECT_MAX.
+ */
+#ifndef MY_GATEWAY_CONTROLLER_RECONNECT_MIN
+#define MY_GATEWAY_CONTROLLER_RECONNECT_MIN 1000
+#endif
+
+/**
+ * @def MY_GATEWAY_CONTROLLER_RECONNECT_MAX
+ * @brief Max delay in milliseconds between connect attempts to the controller.
+ */
+#ifndef MY_GATEWAY_CONTROLLER_RECONNECT_MAX
+#define MY_GATEWAY_CONTROLLER_RECONNECT_MAX 60000
+#endif
+
+/**
+ * @def MY_GATEWAY_CONTROLLER_KEEPALIVE
+ * @brief Send a heartbeat to the controller if the connection was idle this many milliseconds, 0 disables.
+ */
+#ifndef MY_GATEWAY_CONTROLLER_KEEPALIVE
+#define MY_GATEWAY_CONTROLLER_KEEPALIVE 0
+#endif
+
 /**
  * @defgroup MyLockgrp MyNodeLock
  * @ingroup internals
@@ -53,7 +53,7 @@
 #endif
 
 // Enable radio "feature" if one of the radio types was enabled
-#if defined(MY_RADIO_NRF24) || defined(MY_RADIO_RFM69) || defined(MY_RS485)
+#if defined(MY_RADIO_NRF24) || defined(MY_RADIO_RFM69) || defined(MY_RS485) || defined(MY_RADIO_SIM)
 	#define MY_RADIO_FEATURE
 #endif
 
@@ -193,15 +193,29 @@
 		#error You must define a unique MY_MQTT_CLIENT_ID for this MQTT client
 	#endif
 
+	#if MY_MQTT_PUBLISH_QOS > 0
+		#define MQTT_MAX_INFLIGHT MY_MQTT_MAX_INFLIGHT
+	#else
+		#define MQTT_MAX_INFLIGHT 0
+	#endif
 	#include "drivers/pubsubclient/src/PubSubClient.cpp"
 	#include "core/MyGatewayTransport.cpp"
+	#if defined(MY_GATEWAY_BINARY_PROTOCOL)
+		#include "core/MyProtocolBinary.cpp"
+	#else
+		#include "core/MyProtocolMySensors.cpp"
+	#endif
 	#include "core/MyGatewayTransportMQTTClient.cpp"
 #elif defined(MY_GATEWAY_FEATURE)
 	// GATEWAY - COMMON FUNCTIONS
 	#include "core/MyGatewayTransport.cpp"
 
-	// We currently only support one protocol at the moment, enable it.
-	#include "core/MyProtocolMySensors.cpp"
+	// Text protocol by default, binary frames on request
+	#if defined(MY_GATEWAY_BINARY_PROTOCOL)
+		#include "core/MyProtocolBinary.cpp"
+	#else
+		#include "core/MyProtocolMySensors.cpp"
+	#endif
 
 	// GATEWAY - CONFIGURATION
 	#if defined(MY_RADIO_FEATURE)
@@ -214,7 +228,13 @@
 	#if !defined(MY_PORT)
 		#error You must define MY_PORT (controller or gatway port to open)
 	#endif
-	#if defined(MY_GATEWAY_ESP8266)
+	#if defined(MY_GATEWAY_ESP8266) && defined(MY_GATEWAY_ESP8266_ASYNC)
+		// GATEWAY - ESP8266, event driven on the lwIP TCP callbacks
+		#if defined(MY_USE_UDP) || defined(MY_CONTROLLER_IP_ADDRESS)
+			#error MY_GATEWAY_ESP8266_ASYNC only supports TCP server mode
+		#endif
+		#include "core/MyGatewayTransportESP8266Async.cpp"
+	#elif defined(MY_GATEWAY_ESP8266)
 		// GATEWAY - ESP8266
 		#include "core/MyGatewayTransportEthernet.cpp"
 	#elif defined(MY_GATEWAY_W5100)
@@ -234,7 +254,7 @@
 
 
 // RADIO
-#if defined(MY_RADIO_NRF24) || defined(MY_RADIO_RFM69) || defined(MY_RS485)
+#if defined(MY_RADIO_FEATURE)
 	// SOFTSPI
 	#ifdef MY_SOFTSPI
 		#if defined(ARDUINO_ARCH_ESP8266)
@@ -244,6 +264,9 @@
 	#endif
 
 	// FLASH
+	#if defined(MY_OTA_BROADCAST_FEATURE) && !defined(MY_OTA_FIRMWARE_FEATURE)
+		#error MY_OTA_BROADCAST_FEATURE requires MY_OTA_FIRMWARE_FEATURE
+	#endif
 	#ifdef MY_OTA_FIRMWARE_FEATURE
 		#include "drivers/SPIFlash/SPIFlash.cpp"
 		#include "core/MyOTAFirmwareUpdate.cpp"
@@ -264,6 +287,8 @@
 	#elif defined(MY_RADIO_RFM69)
 		#include "drivers/RFM69/RFM69.cpp"
 		#include "core/MyTransportRFM69.cpp"
+	#elif defined(MY_RADIO_SIM)
+		// Host simulation, the transport functions are provided by tests/sim
 	#endif
 #endif
 
@@ -275,6 +300,10 @@
 	#undef MY_SIGNING_FEATURE
 #endif
 
+#if !defined(MY_RADIO_NRF24)
+	#undef MY_RF24_CHANNEL_SCAN
+#endif
+
 #if !defined(MY_GATEWAY_FEATURE)
 	#undef MY_INCLUSION_MODE_FEATURE
 	#undef MY_INCLUSION_BUTTON_FEATURE
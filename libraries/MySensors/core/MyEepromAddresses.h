@@ -40,5 +40,7 @@
 #define EEPROM_RF_ENCRYPTION_AES_KEY_ADDRESS (EEPROM_SIGNING_SOFT_SERIAL_ADDRESS+9) // This is set with SecurityPersonalizer.ino
 #define EEPROM_NODE_LOCK_COUNTER (EEPROM_RF_ENCRYPTION_AES_KEY_ADDRESS+16)
 #define EEPROM_LOCAL_CONFIG_ADDRESS (EEPROM_NODE_LOCK_COUNTER+1) // First free address for sketch static configuration
+#define EEPROM_FIRMWARE_RESUME_ADDRESS (EEPROM_LOCAL_CONFIG_ADDRESS+256) // Progress of an interrupted OTA download (after the 256 bytes of sketch configuration)
+#define EEPROM_RF24_CHANNEL_ADDRESS (EEPROM_FIRMWARE_RESUME_ADDRESS+12) // Channel the network moved to (MY_RF24_CHANNEL_SCAN), 0xFF = MY_RF24_CHANNEL
 
 #endif
@@ -49,4 +49,16 @@ bool gatewayTransportAvailable();
  */
 MyMessage& gatewayTransportReceive();
 
+#if defined(MY_GATEWAY_SERIAL) && MY_GATEWAY_SERIAL_TX_BUFFER > 0
+/*
+ * Write all messages queued for the controller, blocks until the serial device took them
+ */
+void gatewayTransportFlush();
+
+/*
+ * Number of messages to the controller that had to wait because the queue was full, see @ref MY_GATEWAY_SERIAL_TX_BUFFER
+ */
+uint16_t gatewayTransportOverflows();
+#endif
+
 #endif /* MyGatewayTransportEthernet_h */
@@ -0,0 +1,314 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2015 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// ESP8266 gateway in server mode on the lwIP raw TCP API (@ref MY_GATEWAY_ESP8266_ASYNC).
+// lwIP calls back when a client connects, sends data, gets acks or goes away. Received data is
+// parsed in the callback into a queue of complete messages, gatewayTransportAvailable() only
+// picks them up. Outgoing messages are copied into a buffer per client which the sent callback
+// passes on to lwIP as the send window opens.
+// The callbacks run from the system task between two loop passes (while the sketch yields),
+// never in the middle of the code below, so the shared state needs no locking.
+
+#include "MyGatewayTransport.h"
+
+extern "C" {
+	#include "lwip/tcp.h"
+}
+
+#if MY_GATEWAY_TX_BUFFER_SIZE == 0
+	#error MY_GATEWAY_ESP8266_ASYNC needs MY_GATEWAY_TX_BUFFER_SIZE > 0
+#endif
+
+#if defined(MY_IP_ADDRESS)
+	IPAddress _ethernetGatewayIP(MY_IP_ADDRESS);
+	IPAddress gateway(MY_IP_GATEWAY_ADDRESS);
+	IPAddress subnet(MY_IP_SUBNET_ADDRESS);
+#endif
+uint16_t _ethernetGatewayPort = MY_PORT;
+MyMessage _ethernetMsg;
+
+typedef struct
+{
+  struct tcp_pcb *pcb;     // NULL if the slot is free
+  ProtocolParser parser;
+  MyMessage msg;           // Message currently parsed
+  struct pbuf *rx;         // Received data not parsed yet (the receive queue was full)
+  uint16_t rxOffset;       // Bytes of rx already parsed
+  uint8_t tx[MY_GATEWAY_TX_BUFFER_SIZE];
+  uint16_t txLen;
+  unsigned long txProgress; // Last time lwIP took data, for MY_GATEWAY_CLIENT_STALL_TIMEOUT
+  bool greet;              // Connected, I_GATEWAY_READY and presentation still to send
+} tcpClient;
+
+static struct tcp_pcb *_tcpListen;
+static tcpClient _tcpClients[MY_GATEWAY_MAX_CLIENTS];
+
+// Complete messages from all clients in the order they arrived
+static MyMessage _tcpRxQueue[MY_GATEWAY_RX_QUEUE_SIZE];
+static uint8_t _tcpRxHead = 0;
+static uint8_t _tcpRxCount = 0;
+
+
+// Releases the slot, the pcb is already gone or closed by the caller
+static void _tcpFree(uint8_t i) {
+	tcpClient &c = _tcpClients[i];
+	if (c.rx) {
+		pbuf_free(c.rx);
+		c.rx = NULL;
+	}
+	c.pcb = NULL;
+	c.txLen = 0;
+	c.greet = false;
+}
+
+// Returns ERR_ABRT if the pcb had to be aborted (to be returned from a callback)
+static err_t _tcpClose(uint8_t i) {
+	struct tcp_pcb *pcb = _tcpClients[i].pcb;
+	tcp_arg(pcb, NULL);
+	tcp_recv(pcb, NULL);
+	tcp_sent(pcb, NULL);
+	tcp_err(pcb, NULL);
+	_tcpFree(i);
+	if (tcp_close(pcb) != ERR_OK) {
+		tcp_abort(pcb);
+		return ERR_ABRT;
+	}
+	return ERR_OK;
+}
+
+// Parses received data into the queue while it has room. Data is acknowledged to lwIP only
+// once parsed, so a full queue closes the receive window of the client instead of losing data.
+static void _tcpParse(uint8_t i) {
+	tcpClient &c = _tcpClients[i];
+	while (c.rx && _tcpRxCount < MY_GATEWAY_RX_QUEUE_SIZE) {
+		char inChar = pbuf_get_at(c.rx, c.rxOffset++);
+		if (c.rxOffset == c.rx->tot_len) {
+			tcp_recved(c.pcb, c.rx->tot_len);
+			pbuf_free(c.rx);
+			c.rx = NULL;
+			c.rxOffset = 0;
+		}
+		#if !defined(MY_GATEWAY_BINARY_PROTOCOL)
+			// Carriage return also completes a command
+			if (inChar == '\r') {
+				inChar = '\n';
+			}
+		#endif
+		if (protocolParseChar(c.parser, c.msg, inChar)) {
+			uint8_t tail = _tcpRxHead + _tcpRxCount;
+			if (tail >= MY_GATEWAY_RX_QUEUE_SIZE) {
+				tail -= MY_GATEWAY_RX_QUEUE_SIZE;
+			}
+			_tcpRxQueue[tail] = c.msg;
+			_tcpRxCount++;
+		}
+	}
+}
+
+// Passes buffered data on to lwIP as far as its send buffer takes it
+static void _tcpPush(uint8_t i) {
+	tcpClient &c = _tcpClients[i];
+	if (!c.pcb || !c.txLen) {
+		return;
+	}
+	uint16_t len = min((uint16_t)tcp_sndbuf(c.pcb), c.txLen);
+	if (!len || tcp_write(c.pcb, c.tx, len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+		// lwIP is out of buffers, tried again on the next sent callback or
+		// gatewayTransportAvailable() (no callback comes with nothing in flight)
+		return;
+	}
+	tcp_output(c.pcb);
+	c.txLen -= len;
+	memmove(c.tx, c.tx + len, c.txLen);
+	c.txProgress = hwMillis();
+}
+
+static err_t _tcpOnRecv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err) {
+	uint8_t i = (uintptr_t)arg;
+	(void)pcb;
+	if (!p) {
+		// closed by the client
+		return _tcpClose(i);
+	}
+	if (err != ERR_OK) {
+		pbuf_free(p);
+		return err;
+	}
+	tcpClient &c = _tcpClients[i];
+	if (c.rx) {
+		pbuf_cat(c.rx, p);
+	} else {
+		c.rx = p;
+	}
+	_tcpParse(i);
+	return ERR_OK;
+}
+
+static err_t _tcpOnSent(void *arg, struct tcp_pcb *pcb, u16_t len) {
+	uint8_t i = (uintptr_t)arg;
+	(void)pcb;
+	(void)len;
+	_tcpClients[i].txProgress = hwMillis();
+	_tcpPush(i);
+	return ERR_OK;
+}
+
+static void _tcpOnError(void *arg, err_t err) {
+	// lwIP has freed the pcb already (reset by the client or aborted)
+	(void)err;
+	_tcpFree((uintptr_t)arg);
+}
+
+static err_t _tcpOnAccept(void *arg, struct tcp_pcb *pcb, err_t err) {
+	(void)arg;
+	tcp_accepted(_tcpListen);
+	if (err != ERR_OK || !pcb) {
+		return ERR_VAL;
+	}
+	uint8_t i = 0;
+	while (i < MY_GATEWAY_MAX_CLIENTS && _tcpClients[i].pcb) {
+		i++;
+	}
+	if (i == MY_GATEWAY_MAX_CLIENTS) {
+		// no free slot, reject
+		tcp_abort(pcb);
+		return ERR_ABRT;
+	}
+	tcpClient &c = _tcpClients[i];
+	c.pcb = pcb;
+	c.rx = NULL;
+	c.rxOffset = 0;
+	c.txLen = 0;
+	c.greet = true;
+	protocolParserReset(c.parser);
+	tcp_arg(pcb, (void *)(uintptr_t)i);
+	tcp_recv(pcb, _tcpOnRecv);
+	tcp_sent(pcb, _tcpOnSent);
+	tcp_err(pcb, _tcpOnError);
+	return ERR_OK;
+}
+
+
+bool gatewayTransportInit() {
+	#if defined(MY_ESP8266_SSID)
+		// Turn off access point
+		WiFi.mode (WIFI_STA);
+		#if defined(MY_ESP8266_HOSTNAME)
+			WiFi.hostname(MY_ESP8266_HOSTNAME);
+		#endif
+		(void)WiFi.begin(MY_ESP8266_SSID, MY_ESP8266_PASSWORD);
+		#ifdef MY_IP_ADDRESS
+			WiFi.config(_ethernetGatewayIP, gateway, subnet);
+		#endif
+		while (WiFi.status() != WL_CONNECTED)
+		{
+			delay(500);
+			MY_SERIALDEVICE.print(".");
+			yield();
+		}
+		MY_SERIALDEVICE.print(F("IP: "));
+		MY_SERIALDEVICE.println(WiFi.localIP());
+	#endif
+
+	struct tcp_pcb *pcb = tcp_new();
+	if (!pcb) {
+		return false;
+	}
+	if (tcp_bind(pcb, IP_ADDR_ANY, _ethernetGatewayPort) != ERR_OK) {
+		tcp_close(pcb);
+		return false;
+	}
+	_tcpListen = tcp_listen(pcb);
+	if (!_tcpListen) {
+		tcp_close(pcb);
+		return false;
+	}
+	tcp_accept(_tcpListen, _tcpOnAccept);
+	return true;
+}
+
+bool gatewayTransportSend(MyMessage &message)
+{
+	bool ret = true;
+	size_t length;
+	char *_ethernetMsg = protocolFormat(message, &length);
+
+	for (uint8_t i = 0; i < MY_GATEWAY_MAX_CLIENTS; i++) {
+		tcpClient &c = _tcpClients[i];
+		if (!c.pcb) {
+			continue;
+		}
+		if (c.txLen + length > sizeof(c.tx)) {
+			_tcpPush(i);
+			if (c.txLen + length > sizeof(c.tx)) {
+				debug(PSTR("Client %d: TX buffer full\n"), i);
+				ret = false;
+				continue;
+			}
+		}
+		if (!c.txLen) {
+			c.txProgress = hwMillis();
+		}
+		memcpy(c.tx + c.txLen, _ethernetMsg, length);
+		c.txLen += length;
+		_tcpPush(i);
+	}
+	return ret;
+}
+
+bool gatewayTransportAvailable()
+{
+	for (uint8_t i = 0; i < MY_GATEWAY_MAX_CLIENTS; i++) {
+		tcpClient &c = _tcpClients[i];
+		if (c.greet) {
+			c.greet = false;
+			debug(PSTR("Client %d connected\n"), i);
+			gatewayTransportSend(buildGw(_msg, I_GATEWAY_READY).set("Gateway startup complete."));
+			if (presentation)
+				presentation();
+		}
+		// retry data lwIP had no buffers for
+		_tcpPush(i);
+		if (c.pcb && c.txLen && hwMillis() - c.txProgress > MY_GATEWAY_CLIENT_STALL_TIMEOUT) {
+			// client does not keep up, drop it instead of stalling the radio network
+			debug(PSTR("Client %d stalled, dropped\n"), i);
+			tcp_abort(c.pcb);
+			// the error callback has freed the slot
+			continue;
+		}
+		// room in the queue again for data held back
+		_tcpParse(i);
+	}
+
+	if (!_tcpRxCount) {
+		return false;
+	}
+	_ethernetMsg = _tcpRxQueue[_tcpRxHead];
+	if (++_tcpRxHead == MY_GATEWAY_RX_QUEUE_SIZE) {
+		_tcpRxHead = 0;
+	}
+	_tcpRxCount--;
+	return true;
+}
+
+MyMessage& gatewayTransportReceive()
+{
+	// Return the last parsed message
+	return _ethernetMsg;
+}
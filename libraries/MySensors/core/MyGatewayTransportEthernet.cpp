@@ -34,11 +34,20 @@ MyMessage _ethernetMsg;
 
 // gatewayTransportSend(buildGw(_msg, I_GATEWAY_READY).set("Gateway startup complete."));
 
+#if defined(MY_USE_UDP)
 typedef struct
 {
   char string[MY_GATEWAY_MAX_RECEIVE_LENGTH];
   uint8_t idx;
 } inputBuffer;
+#else
+// Incoming TCP data is parsed as it arrives, each client has its own partially parsed message
+typedef struct
+{
+  ProtocolParser parser;
+  MyMessage msg;
+} inputBuffer;
+#endif
 
 #if defined(MY_GATEWAY_ESP8266)
 	// Some re-defines to make code more readable below
@@ -50,25 +59,51 @@ typedef struct
 		IPAddress gateway(MY_IP_GATEWAY_ADDRESS);
 		IPAddress subnet(MY_IP_SUBNET_ADDRESS);
 	#endif
-	static bool clientsConnected[MY_GATEWAY_MAX_CLIENTS];
 #endif
 
 #if defined(MY_USE_UDP)
 	EthernetUDP _ethernetServer;
+	static inputBuffer inputString;
 #else
 	EthernetServer _ethernetServer(_ethernetGatewayPort);
+	static inputBuffer inputString[MY_GATEWAY_MAX_CLIENTS];
 #endif
 
-
+static EthernetClient clients[MY_GATEWAY_MAX_CLIENTS];
 #if defined(MY_GATEWAY_ESP8266)
-	static EthernetClient clients[MY_GATEWAY_MAX_CLIENTS];
-	static inputBuffer inputString[MY_GATEWAY_MAX_CLIENTS];
-#else
-	static EthernetClient client = EthernetClient();
-	static inputBuffer inputString;
+	static bool clientsConnected[MY_GATEWAY_MAX_CLIENTS];
+#endif
+
+#if (MY_GATEWAY_TX_BUFFER_SIZE > 0) && !defined(MY_USE_UDP) && !defined(MY_CONTROLLER_IP_ADDRESS)
+	#define MY_GATEWAY_TX_BATCHING
+	// Outgoing messages are collected and written in one go, giving one TCP segment per batch
+	typedef struct
+	{
+	  uint8_t data[MY_GATEWAY_TX_BUFFER_SIZE];
+	  uint16_t len;
+	  unsigned long lastProgress;
+	} outputBuffer;
+	#if defined(MY_GATEWAY_ESP8266)
+		// One buffer per client, a slow client falls behind on its own and is dropped when it stalls
+		#define OUTPUT_BUFFERS MY_GATEWAY_MAX_CLIENTS
+	#else
+		// W5100/ENC: the server writes to all connected sockets at once
+		#define OUTPUT_BUFFERS 1
+	#endif
+	static outputBuffer outputString[OUTPUT_BUFFERS];
+	static unsigned long _outputFlushTime;
 #endif
 
 
+#if defined(MY_CONTROLLER_IP_ADDRESS) && !defined(MY_USE_UDP)
+	// Gateway keeps one connection to the controller open and reconnects with backoff if it drops
+	static EthernetClient _ethernetControllerClient;
+	static inputBuffer _controllerInput;
+	static unsigned long _controllerRetryTime;
+	static unsigned long _controllerBackoff;
+	static unsigned long _controllerLastWrite;
+#endif
+
 #ifndef MY_IP_ADDRESS
 	void gatewayTransportRenewIP();
 #endif
@@ -146,32 +181,174 @@ bool gatewayTransportInit() {
 	return true;
 }
 
+#if defined(MY_GATEWAY_TX_BATCHING)
+	// Write as much of the buffer as the connection accepts, returns false if data is left over
+	bool _flushOutput(uint8_t i) {
+		outputBuffer &out = outputString[i];
+		if (!out.len) {
+			return true;
+		}
+		#if defined(MY_GATEWAY_ESP8266)
+			if (!clients[i].connected()) {
+				out.len = 0;
+				return true;
+			}
+			size_t written = clients[i].write(out.data, out.len);
+		#else
+			// the server writes to all connected sockets and blocks until done
+			_ethernetServer.write(out.data, out.len);
+			size_t written = out.len;
+		#endif
+		if (written) {
+			out.len -= written;
+			memmove(out.data, out.data + written, out.len);
+			out.lastProgress = hwMillis();
+		}
+		#if defined(MY_GATEWAY_ESP8266)
+			if (out.len && hwMillis() - out.lastProgress > MY_GATEWAY_CLIENT_STALL_TIMEOUT) {
+				// client does not keep up, drop it instead of stalling the radio network
+				debug(PSTR("Client %d stalled, dropped\n"), i);
+				clients[i].stop();
+				out.len = 0;
+				return true;
+			}
+		#endif
+		return !out.len;
+	}
+
+	bool _queueOutput(uint8_t i, const uint8_t *data, size_t length) {
+		outputBuffer &out = outputString[i];
+		if (out.len + length > sizeof(out.data)) {
+			// make room by writing what we have so far
+			_flushOutput(i);
+			if (out.len + length > sizeof(out.data)) {
+				debug(PSTR("Client %d: TX buffer full\n"), i);
+				return false;
+			}
+		}
+		if (!out.len) {
+			out.lastProgress = hwMillis();
+			if (!_outputFlushTime) {
+				_outputFlushTime = out.lastProgress | 1;
+			}
+		}
+		memcpy(out.data + out.len, data, length);
+		out.len += length;
+		return true;
+	}
+
+	void _processOutput() {
+		// give more messages a chance to join the batch before writing it
+		if (!_outputFlushTime || hwMillis() - _outputFlushTime < MY_GATEWAY_TX_FLUSH_INTERVAL) {
+			return;
+		}
+		bool pending = false;
+		for (uint8_t i = 0; i < OUTPUT_BUFFERS; i++) {
+			pending |= !_flushOutput(i);
+		}
+		_outputFlushTime = pending ? (hwMillis() | 1) : 0;
+	}
+#endif
+
+
+#if defined(MY_CONTROLLER_IP_ADDRESS) && !defined(MY_USE_UDP)
+	bool _controllerConnect() {
+		if (_ethernetControllerClient.connected()) {
+			return true;
+		}
+		if (_controllerBackoff && hwMillis() - _controllerRetryTime < _controllerBackoff) {
+			// still backing off after a failed attempt
+			return false;
+		}
+		_ethernetControllerClient.stop();
+		#if defined(MY_CONTROLLER_URL_ADDRESS)
+			bool connected = _ethernetControllerClient.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT);
+		#else
+			bool connected = _ethernetControllerClient.connect(_ethernetControllerIP, MY_PORT);
+		#endif
+		if (connected) {
+			debug(PSTR("Eth: controller connected\n"));
+			#if defined(MY_GATEWAY_ESP8266)
+				// messages are written in one piece, do not hold them back
+				_ethernetControllerClient.setNoDelay(true);
+			#endif
+			protocolParserReset(_controllerInput.parser);
+			_controllerBackoff = 0;
+			_controllerLastWrite = hwMillis();
+			return true;
+		}
+		_controllerRetryTime = hwMillis();
+		_controllerBackoff = _controllerBackoff ? min(_controllerBackoff * 2, (unsigned long)MY_GATEWAY_CONTROLLER_RECONNECT_MAX) : MY_GATEWAY_CONTROLLER_RECONNECT_MIN;
+		debug(PSTR("Eth: controller connect failed, retry in %lu ms\n"), _controllerBackoff);
+		return false;
+	}
+
+	bool _controllerProcess() {
+		if (!_controllerConnect()) {
+			return false;
+		}
+		#if MY_GATEWAY_CONTROLLER_KEEPALIVE > 0
+			if (hwMillis() - _controllerLastWrite > MY_GATEWAY_CONTROLLER_KEEPALIVE) {
+				// idle connection, send a heartbeat to detect a dead link and keep NAT/firewall state
+				_w5100_spi_en(false);
+				gatewayTransportSend(buildGw(_msg, I_HEARTBEAT_RESPONSE).set((uint32_t)hwMillis()));
+				_w5100_spi_en(true);
+			}
+		#endif
+		// the controller may send commands over the same connection
+		while (_ethernetControllerClient.connected() && _ethernetControllerClient.available()) {
+			char inChar = _ethernetControllerClient.read();
+			#if !defined(MY_GATEWAY_BINARY_PROTOCOL)
+				// Carriage return also completes a command
+				if (inChar == '\r') {
+					inChar = '\n';
+				}
+			#endif
+			if (protocolParseChar(_controllerInput.parser, _controllerInput.msg, inChar)) {
+				_ethernetMsg = _controllerInput.msg;
+				return true;
+			}
+		}
+		return false;
+	}
+#endif
+
 bool gatewayTransportSend(MyMessage &message)
 {
 	bool ret = true;
-	char *_ethernetMsg = protocolFormat(message);
+	size_t length;
+	char *_ethernetMsg = protocolFormat(message, &length);
 
 	_w5100_spi_en(true);
 	#if defined(MY_CONTROLLER_IP_ADDRESS)
 		#if defined(MY_USE_UDP)
 			_ethernetServer.beginPacket(_ethernetControllerIP, MY_PORT);
-			_ethernetServer.write(_ethernetMsg, strlen(_ethernetMsg));
+			_ethernetServer.write((uint8_t*)_ethernetMsg, length);
 			// returns 1 if the packet was sent successfully
 			ret = _ethernetServer.endPacket();
 		#else
-			EthernetClient client;
-			#if defined(MY_CONTROLLER_URL_ADDRESS)
-	                	if (client.connected() || client.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT)) {
-	        	#else
-	                	if (client.connected() || client.connect(_ethernetControllerIP, MY_PORT)) {
-	        	#endif
-	                	client.write(_ethernetMsg, strlen(_ethernetMsg));
-	                }
-	                else {
-	                	// connecting to the server failed!
-	                	ret = false;
-	                }
+			if (!_controllerConnect()) {
+				// connecting to the server failed!
+				ret = false;
+			} else if (_ethernetControllerClient.write((uint8_t*)_ethernetMsg, length) != length) {
+				debug(PSTR("Eth: controller write failed\n"));
+				_ethernetControllerClient.stop();
+				ret = false;
+			} else {
+				_controllerLastWrite = hwMillis();
+			}
 		#endif
+	#elif defined(MY_GATEWAY_TX_BATCHING)
+		// Queue message for connected clients, buffers are written by gatewayTransportAvailable()
+		for (uint8_t i = 0; i < OUTPUT_BUFFERS; i++)
+		{
+			#if defined(MY_GATEWAY_ESP8266)
+				if (!clients[i] || !clients[i].connected())
+					continue;
+			#endif
+			if (!_queueOutput(i, (uint8_t*)_ethernetMsg, length))
+				ret = false;
+		}
 	#else
 		// Send message to connected clients
 		#if defined(MY_GATEWAY_ESP8266)
@@ -179,11 +356,11 @@ bool gatewayTransportSend(MyMessage &message)
 			{
 				if (clients[i] && clients[i].connected())
 				{
-					clients[i].write((uint8_t*)_ethernetMsg, strlen(_ethernetMsg));
+					clients[i].write((uint8_t*)_ethernetMsg, length);
 				}
 			}
 		#else
-			_ethernetServer.write(_ethernetMsg);
+			_ethernetServer.write((uint8_t*)_ethernetMsg, length);
 		#endif
 	#endif
 	_w5100_spi_en(false);
@@ -191,61 +368,22 @@ bool gatewayTransportSend(MyMessage &message)
 
 }
 
-
-#if defined(MY_GATEWAY_ESP8266)
+#if defined(MY_USE_UDP)
+	// UDP datagrams are parsed as a whole
+#else
 	bool _readFromClient(uint8_t i) {
 		while (clients[i].connected() && clients[i].available()) {
 			char inChar = clients[i].read();
-			if (inputString[i].idx < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
-				// if newline then command is complete
-				if (inChar == '\n' || inChar == '\r') {
-					// Add string terminator and prepare for the next message
-					inputString[i].string[inputString[i].idx] = 0;
-					debug(PSTR("Client %d: %s\n"), i, inputString[i].string);
-					inputString[i].idx = 0;
-					if (protocolParse(_ethernetMsg, inputString[i].string)) {
-						return true;
-					}
-
-				} else {
-					// add it to the inputString:
-					inputString[i].string[inputString[i].idx++] = inChar;
-				}
-			} else {
-				// Incoming message too long. Throw away
-				debug(PSTR("Client %d: Message too long\n"), i);
-				inputString[i].idx = 0;
-				// Finished with this client's message. Next loop() we'll see if there's more to read.
-				break;
-			}
-		}
-		return false;
-	}
-#else
-	bool _readFromClient() {
-		while (client.connected() && client.available()) {
-			char inChar = client.read();
-			if (inputString.idx < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
-				// if newline then command is complete
-				if (inChar == '\n' || inChar == '\r') {
-					// Add string terminator and prepare for the next message
-					inputString.string[inputString.idx] = 0;
-					debug(PSTR("Eth: %s\n"), inputString.string);
-					inputString.idx = 0;
-					if (protocolParse(_ethernetMsg, inputString.string)) {
-						return true;
-					}
-
-				} else {
-					// add it to the inputString:
-					inputString.string[inputString.idx++] = inChar;
+			#if !defined(MY_GATEWAY_BINARY_PROTOCOL)
+				// Carriage return also completes a command
+				if (inChar == '\r') {
+					inChar = '\n';
 				}
-			} else {
-				// Incoming message too long. Throw away
-				debug(PSTR("Eth: Message too long\n"));
-				inputString.idx = 0;
-				// Finished with this client's message. Next loop() we'll see if there's more to read.
-				break;
+			#endif
+			if (protocolParseChar(inputString[i].parser, inputString[i].msg, inChar)) {
+				debug(PSTR("Client %d: message received\n"), i);
+				_ethernetMsg = inputString[i].msg;
+				return true;
 			}
 		}
 		return false;
@@ -256,29 +394,33 @@ bool gatewayTransportSend(MyMessage &message)
 bool gatewayTransportAvailable()
 {
 	_w5100_spi_en(true);
-	#if !defined(MY_IP_ADDRESS) && defined(MY_GATEWAY_W5100)
+	#if !defined(MY_IP_ADDRESS) && (defined(MY_GATEWAY_W5100) || defined(MY_GATEWAY_ENC28J60))
 		// renew IP address using DHCP
 		gatewayTransportRenewIP();
 	#endif
 
+	#if defined(MY_GATEWAY_TX_BATCHING)
+		_processOutput();
+	#endif
+
+	#if defined(MY_CONTROLLER_IP_ADDRESS) && !defined(MY_USE_UDP)
+		if (_controllerProcess()) {
+			_w5100_spi_en(false);
+			return true;
+		}
+	#endif
+
 	#ifdef MY_USE_UDP
 
 		int packet_size = _ethernetServer.parsePacket();
 
 		if (packet_size) {
 			//debug(PSTR("UDP packet available. Size:%d\n"), packet_size);
-			#if defined(MY_GATEWAY_ESP8266)
-				_ethernetServer.read(inputString[0].string, MY_GATEWAY_MAX_RECEIVE_LENGTH);
-				inputString[0].string[packet_size] = 0;
-				debug(PSTR("UDP packet received: %s\n"), inputString[0].string);
-				return protocolParse(_ethernetMsg, inputString[0].string);
-			#else
-				_ethernetServer.read(inputString.string, MY_GATEWAY_MAX_RECEIVE_LENGTH);
-				_w5100_spi_en(false);
-				inputString.string[packet_size] = 0;
-				debug(PSTR("UDP packet received: %s\n"), inputString.string);
-				return protocolParse(_ethernetMsg, inputString.string);
-			#endif
+			_ethernetServer.read(inputString.string, MY_GATEWAY_MAX_RECEIVE_LENGTH);
+			_w5100_spi_en(false);
+			inputString.string[packet_size] = 0;
+			debug(PSTR("UDP packet received: %s\n"), inputString.string);
+			return protocolParse(_ethernetMsg, inputString.string);
 		}
 	#else
 		#if defined(MY_GATEWAY_ESP8266)
@@ -294,7 +436,12 @@ bool gatewayTransportAvailable()
 					//check if there are any new clients
 					if (_ethernetServer.hasClient()) {
 						clients[i] = _ethernetServer.available();
-						inputString[i].idx = 0;
+						protocolParserReset(inputString[i].parser);
+						#if defined(MY_GATEWAY_TX_BATCHING)
+							outputString[i].len = 0;
+							// bound the time a single write may block the loop
+							clients[i].setTimeout(MY_GATEWAY_CLIENT_WRITE_TIMEOUT);
+						#endif
 						debug(PSTR("Client %d connected\n"), i);
 						_w5100_spi_en(false);
 						gatewayTransportSend(buildGw(_msg, I_GATEWAY_READY).set("Gateway startup complete."));
@@ -313,40 +460,51 @@ bool gatewayTransportAvailable()
 				EthernetClient c = _ethernetServer.available();
 				c.stop();
 			}
-				// Loop over clients connect and read available data
-			for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
-				if (_readFromClient(i)) {
-					_w5100_spi_en(false);
-					return true;
-				}
-			}
 		#else
-			// W5100/ENC module does not have hasClient-method. We can only serve one client at the time.
+			// W5100/ENC module does not have hasClient-method. A client is seen as soon as it sends data,
+			// it then gets a free slot or replaces the first client if all slots are taken.
 			EthernetClient newclient = _ethernetServer.available();
-			// if a new client connects make sure to dispose any previous existing sockets
 			if (newclient) {
-				if (client != newclient) {
-					client.stop();
-					client = newclient;
+				uint8_t slot = MY_GATEWAY_MAX_CLIENTS;
+				for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
+					if (clients[i] == newclient) {
+						slot = i;
+						break;
+					}
+					if (slot == MY_GATEWAY_MAX_CLIENTS && !clients[i]) {
+						slot = i;
+					}
+				}
+				if (slot == MY_GATEWAY_MAX_CLIENTS) {
+					slot = 0;
+				}
+				if (clients[slot] != newclient) {
+					// make sure to dispose any previous existing socket
+					clients[slot].stop();
+					clients[slot] = newclient;
+					protocolParserReset(inputString[slot].parser);
 					debug(PSTR("Eth: connect\n"));
 					_w5100_spi_en(false);
 					gatewayTransportSend(buildGw(_msg, I_GATEWAY_READY).set("Gateway startup complete."));
 					if (presentation)
 						presentation();
+					_w5100_spi_en(true);
 				}
 			}
-			if (client) {
-				if (!client.connected()) {
+			for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
+				if (clients[i] && !clients[i].connected()) {
 					debug(PSTR("Eth: disconnect\n"));
-					client.stop();
-				} else {
-					if (_readFromClient()) {
-						_w5100_spi_en(false);
-						return true;
-					}
+					clients[i].stop();
 				}
 			}
 		#endif
+		// Loop over clients connect and read available data
+		for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
+			if (_readFromClient(i)) {
+				_w5100_spi_en(false);
+				return true;
+			}
+		}
 	#endif
 	_w5100_spi_en(false);
 	return false;
@@ -369,18 +527,25 @@ void gatewayTransportRenewIP()
 	 3 - rebinf failed
 	 4 - rebind success
 	 */
-	static unsigned long next_time = hwMillis() + MY_IP_RENEWAL_INTERVAL;
-	unsigned long now = hwMillis();
-
-	// http://playground.arduino.cc/Code/TimingRollover
-	if ((long)(now - next_time) < 0)
-		return;
-	if (Ethernet.maintain() & ~(0x06)) {
-		debug(PSTR("IP was not renewed correctly\n"));
-		/* Error occured -> IP was not renewed */
-		return;
-	}
-	_w5100_spi_en(false);
-	next_time = now + MY_IP_RENEWAL_INTERVAL;
+	#if defined(MY_GATEWAY_ENC28J60)
+		// UIPEthernet advances renew/rebind by one step per call and never waits for the server
+		if (Ethernet.maintain() & ~(0x06)) {
+			debug(PSTR("IP was not renewed correctly\n"));
+		}
+	#else
+		static unsigned long next_time = hwMillis() + MY_IP_RENEWAL_INTERVAL;
+		unsigned long now = hwMillis();
+
+		// http://playground.arduino.cc/Code/TimingRollover
+		if ((long)(now - next_time) < 0)
+			return;
+		if (Ethernet.maintain() & ~(0x06)) {
+			debug(PSTR("IP was not renewed correctly\n"));
+			/* Error occured -> IP was not renewed */
+			return;
+		}
+		_w5100_spi_en(false);
+		next_time = now + MY_IP_RENEWAL_INTERVAL;
+	#endif
 }
 #endif /* IP_ADDRESS_DHCP */
@@ -24,8 +24,9 @@
 #include "MyMessage.h"
 
 // Topic structure: MY_MQTT_PUBLISH_TOPIC_PREFIX/NODE-ID/SENSOR-ID/CMD-TYPE/ACK-FLAG/SUB-TYPE
-
-uint8_t protocolH2i(char c);
+// With MY_GATEWAY_BINARY_PROTOCOL all messages go to MY_MQTT_PUBLISH_TOPIC_PREFIX/bin and
+// come from MY_MQTT_SUBSCRIBE_TOPIC_PREFIX/bin, the payload is the raw message (header and
+// payload as sent over the air). MQTT delivers whole, checked packets, so there is no framing.
 
 
 #if defined MY_CONTROLLER_IP_ADDRESS
@@ -50,90 +51,166 @@ EthernetClient _ethClient;
 PubSubClient _client(_ethClient);
 bool _connecting = true;
 bool _available = false;
-char _convBuffer[MAX_PAYLOAD*2+1];
-char _fmtBuffer[MY_GATEWAY_MAX_SEND_LENGTH];
 MyMessage _mqttMsg;
 
 
 
-bool gatewayTransportSend(MyMessage &message) {
-	if (!_client.connected())
+#if defined(MY_GATEWAY_BINARY_PROTOCOL)
+static bool mqttPublish(MyMessage &message) {
+	return _client.publish(MY_MQTT_PUBLISH_TOPIC_PREFIX "/bin", (const uint8_t *)&message,
+		HEADER_SIZE + mGetLength(message), false, MY_MQTT_PUBLISH_QOS);
+}
+#else
+// Writes value in decimal followed by separator, returns the position after it
+static char *mqttWriteField(char *pos, uint8_t value, char separator) {
+	if (value >= 100) {
+		*pos++ = '0' + value / 100;
+		value %= 100;
+		*pos++ = '0' + value / 10;
+	} else if (value >= 10) {
+		*pos++ = '0' + value / 10;
+	}
+	*pos++ = '0' + value % 10;
+	*pos++ = separator;
+	return pos;
+}
+
+// Reads a decimal topic level and the separator behind it (or the end of the topic),
+// returns NULL if the level is malformed
+static const char *mqttReadField(const char *pos, uint8_t &value, char separator) {
+	if (*pos < '0' || *pos > '9') {
+		return NULL;
+	}
+	value = 0;
+	while (*pos >= '0' && *pos <= '9') {
+		value = value * 10 + (*pos++ - '0');
+	}
+	if (*pos != separator) {
+		return NULL;
+	}
+	return separator ? pos + 1 : pos;
+}
+
+static bool mqttPublish(MyMessage &message) {
+	// The prefix length is known at compile time, the five levels need at most 20 characters
+	const uint8_t prefixLength = sizeof(MY_MQTT_PUBLISH_TOPIC_PREFIX) - 1;
+	if (prefixLength + 21 > MY_GATEWAY_MAX_SEND_LENGTH)
 		return false;
-	snprintf_P(_fmtBuffer, MY_GATEWAY_MAX_SEND_LENGTH, PSTR(MY_MQTT_PUBLISH_TOPIC_PREFIX "/%d/%d/%d/%d/%d"), message.sender, message.sensor, mGetCommand(message), mGetAck(message), message.type);
+	memcpy_P(_fmtBuffer, PSTR(MY_MQTT_PUBLISH_TOPIC_PREFIX "/"), prefixLength + 1);
+	char *pos = _fmtBuffer + prefixLength + 1;
+	pos = mqttWriteField(pos, message.sender, '/');
+	pos = mqttWriteField(pos, message.sensor, '/');
+	pos = mqttWriteField(pos, mGetCommand(message), '/');
+	pos = mqttWriteField(pos, mGetAck(message), '/');
+	pos = mqttWriteField(pos, message.type, 0);
 	debug(PSTR("Sending message on topic: %s\n"), _fmtBuffer);
-	return _client.publish(_fmtBuffer, message.getString(_convBuffer));
+	const char *payload = message.getString(_convBuffer);
+	return _client.publish(_fmtBuffer, (const uint8_t *)payload, strlen(payload), false, MY_MQTT_PUBLISH_QOS);
+}
+#endif
+
+#if MY_MQTT_SPOOL_SIZE > 0
+// Messages waiting for the broker, oldest at _mqttSpoolHead
+MyMessage _mqttSpool[MY_MQTT_SPOOL_SIZE];
+uint8_t _mqttSpoolHead = 0;
+uint8_t _mqttSpoolCount = 0;
+unsigned long _mqttSpoolLastDrain = 0;
+
+static void mqttSpoolAdd(MyMessage &message) {
+	if (_mqttSpoolCount == MY_MQTT_SPOOL_SIZE) {
+		// Full, the oldest reading makes room
+		debug(PSTR("MQTT spool full\n"));
+		_mqttSpoolHead = (_mqttSpoolHead + 1) % MY_MQTT_SPOOL_SIZE;
+		_mqttSpoolCount--;
+	}
+	_mqttSpool[(_mqttSpoolHead + _mqttSpoolCount) % MY_MQTT_SPOOL_SIZE] = message;
+	_mqttSpoolCount++;
 }
 
+static void mqttSpoolDrain() {
+	if (_mqttSpoolCount == 0 || hwMillis() - _mqttSpoolLastDrain < MY_MQTT_SPOOL_DRAIN_INTERVAL)
+		return;
+	_mqttSpoolLastDrain = hwMillis();
+	for (uint8_t n = 0; n < MY_MQTT_SPOOL_DRAIN_BURST && _mqttSpoolCount; n++) {
+		if (!mqttPublish(_mqttSpool[_mqttSpoolHead])) {
+			// Try again with the next burst
+			return;
+		}
+		_mqttSpoolHead = (_mqttSpoolHead + 1) % MY_MQTT_SPOOL_SIZE;
+		_mqttSpoolCount--;
+	}
+}
+#endif
 
+bool gatewayTransportSend(MyMessage &message) {
+	#if MY_MQTT_SPOOL_SIZE > 0
+		// Spooled messages go first to keep the order
+		if (_client.connected() && _mqttSpoolCount == 0 && mqttPublish(message))
+			return true;
+		mqttSpoolAdd(message);
+		return true;
+	#else
+		if (!_client.connected())
+			return false;
+		return mqttPublish(message);
+	#endif
+}
 
+
+
+#if defined(MY_GATEWAY_BINARY_PROTOCOL)
+void incomingMQTT(char* topic, byte* payload,
+                        unsigned int length)
+{
+	if (strcmp_P(topic, PSTR(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "/bin")) != 0 || length > HEADER_SIZE + MAX_PAYLOAD) {
+		return;
+	}
+	memcpy(&_mqttMsg, payload, length);
+	if (protocolRawEnd(_mqttMsg, length)) {
+		_available = true;
+	}
+}
+#else
 void incomingMQTT(char* topic, byte* payload,
                         unsigned int length)
 {
 	debug(PSTR("Message arrived on topic: %s\n"), topic);
-	char *str, *p;
-	uint8_t i = 0;
-	uint8_t bvalue[MAX_PAYLOAD];
-	uint8_t blen = 0;
-	uint8_t command = 0;
-	for (str = strtok_r(topic, "/", &p); str && i <= 5;
-			str = strtok_r(NULL, "/", &p)) {
-		switch (i) {
-			case 0: {
-				// Topic prefix
-				if (strcmp(str, MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) != 0) {
-					// Message not for us or malformed!
-					return;
-				}
-				break;
-			}
-			case 1: {
-				// Node id
-				_mqttMsg.destination = atoi(str);
-				break;
-			}
-			case 2: {
-				// Sensor id
-				_mqttMsg.sensor = atoi(str);
-				break;
-			}
-			case 3: {
-				// Command type
-				command = atoi(str);
-				mSetCommand(_mqttMsg, command);
-				break;
-			}
-			case 4: {
-				// Ack flag
-				mSetRequestAck(_mqttMsg, atoi(str)?1:0);
-				break;
-			}
-			case 5: {
-				// Sub type
-				_mqttMsg.type = atoi(str);
-				// Add payload
-				if (command == C_STREAM) {
-					blen = 0;
-					uint8_t val;
-					while (*payload) {
-						val = protocolH2i(*payload++) << 4;
-						val += protocolH2i(*payload++);
-						bvalue[blen] = val;
-						blen++;
-					}
-					_mqttMsg.set(bvalue, blen);
-				} else {
-					char* ca;
-					ca = (char *) payload;
-					ca += length;
-					*ca = '\0';
-					_mqttMsg.set((const char*) payload);
-				}
-				_available = true;
-			}
+	const uint8_t prefixLength = sizeof(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) - 1;
+	if (strncmp_P(topic, PSTR(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "/"), prefixLength + 1) != 0) {
+		// Message not for us or malformed!
+		return;
+	}
+	// NODE-ID/SENSOR-ID/CMD-TYPE/ACK-FLAG/SUB-TYPE in one forward scan
+	uint8_t command, ack;
+	const char *pos = topic + prefixLength + 1;
+	if (!(pos = mqttReadField(pos, _mqttMsg.destination, '/')) ||
+	        !(pos = mqttReadField(pos, _mqttMsg.sensor, '/')) ||
+	        !(pos = mqttReadField(pos, command, '/')) ||
+	        !(pos = mqttReadField(pos, ack, '/')) ||
+	        !(pos = mqttReadField(pos, _mqttMsg.type, 0))) {
+		return;
+	}
+	mSetCommand(_mqttMsg, command);
+	// The header is complete, the serial protocol parser finishes the message
+	ProtocolParser parser;
+	protocolParserReset(parser);
+	parser.field = 5;
+	parser.ack = ack;
+	// Add payload
+	if (command == C_STREAM) {
+		for (unsigned int i = 0; i < length; i++) {
+			(void)protocolParseChar(parser, _mqttMsg, (char)payload[i]);
 		}
-		i++;
+	} else {
+		// Payload is taken as is (may contain separators)
+		parser.length = min(length, MAX_PAYLOAD);
+		memcpy(_mqttMsg.data, payload, parser.length);
+	}
+	if (protocolParseEnd(parser, _mqttMsg)) {
+		_available = true;
 	}
 }
+#endif
 
 
 bool reconnectMQTT() {
@@ -148,7 +225,11 @@ bool reconnectMQTT() {
 		// Once connected, publish an announcement...
 		//_client.publish("outTopic","hello world");
 		// ... and resubscribe
-		_client.subscribe(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "/+/+/+/+/+");
+		#if defined(MY_GATEWAY_BINARY_PROTOCOL)
+			_client.subscribe(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "/bin");
+		#else
+			_client.subscribe(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "/+/+/+/+/+");
+		#endif
 		return true;
 	}
 	return false;
@@ -219,6 +300,9 @@ bool gatewayTransportAvailable() {
 		return false;
 	}
 	_client.loop();
+	#if MY_MQTT_SPOOL_SIZE > 0
+		mqttSpoolDrain();
+	#endif
 	return _available;
 }
 
@@ -227,15 +311,3 @@ MyMessage & gatewayTransportReceive() {
 	_available = false;
 	return _mqttMsg;
 }
-
-
-uint8_t protocolH2i(char c) {
-	uint8_t i = 0;
-	if (c <= '9')
-		i += c - '0';
-	else if (c >= 'a')
-		i += c - 'a' + 10;
-	else
-		i += c - 'A' + 10;
-	return i;
-}
@@ -25,43 +25,159 @@
 #include "MyProtocol.h"
 
 
-char _serialInputString[MY_GATEWAY_MAX_RECEIVE_LENGTH];    // A buffer for incoming commands from serial interface
-int _serialInputPos;
+ProtocolParser _serialParser;
 MyMessage _serialMsg;
 
 
+#if MY_GATEWAY_SERIAL_TX_BUFFER > 0
+// Messages to the controller are queued here and drained from process() as far as the
+// serial device takes them without blocking
+static uint8_t _serialTx[MY_GATEWAY_SERIAL_TX_BUFFER];
+static uint16_t _serialTxHead = 0;   // Index of the next byte to send
+static uint16_t _serialTxLength = 0; // Number of bytes queued
+static uint16_t _serialTxOverflows = 0;
+// availableForWrite() is only trusted once it returned > 0, devices that do not implement
+// it (SoftwareSerial, the Print default) always return 0 and are written blocking
+static bool _serialTxRoom = false;
+
+#if defined(USBCON) || defined(ARDUINO_ARCH_SAMD)
+	// Native USB: every write goes out in its own packet, so bytes are collected until a
+	// packet is full or the oldest of them waited MY_SERIAL_TX_USB_DELAY ms
+	#define MY_SERIAL_TX_USB_PACKET 64
+	#define MY_SERIAL_TX_USB_DELAY 2
+	static unsigned long _serialTxSince;
+#endif
+
+// Appends a message behind the queued bytes, it is only queued by commit() if it fit completely
+class SerialTxPrint : public Print {
+public:
+	SerialTxPrint() : _length(_serialTxLength), _full(false) {}
+	size_t write(uint8_t c) {
+		if (_length == MY_GATEWAY_SERIAL_TX_BUFFER) {
+			_full = true;
+			return 0;
+		}
+		uint16_t pos = _serialTxHead + _length;
+		if (pos >= MY_GATEWAY_SERIAL_TX_BUFFER) {
+			pos -= MY_GATEWAY_SERIAL_TX_BUFFER;
+		}
+		_serialTx[pos] = c;
+		_length++;
+		return 1;
+	}
+	using Print::write;
+	bool commit() {
+		if (_full) {
+			return false;
+		}
+		#if defined(MY_SERIAL_TX_USB_PACKET)
+			if (!_serialTxLength) {
+				_serialTxSince = hwMillis();
+			}
+		#endif
+		_serialTxLength = _length;
+		return true;
+	}
+private:
+	uint16_t _length;
+	bool _full;
+};
+
+// Writes queued bytes, without wait only as many as the serial device buffers
+static void _serialTxDrain(bool wait) {
+	#if defined(MY_SERIAL_TX_USB_PACKET)
+		if (!wait && _serialTxLength < MY_SERIAL_TX_USB_PACKET && hwMillis() - _serialTxSince < MY_SERIAL_TX_USB_DELAY) {
+			return;
+		}
+	#endif
+	while (_serialTxLength) {
+		// contiguous part up to the end of the ring
+		uint16_t len = MY_GATEWAY_SERIAL_TX_BUFFER - _serialTxHead;
+		if (len > _serialTxLength) {
+			len = _serialTxLength;
+		}
+		if (!wait) {
+			int room = MY_SERIALDEVICE.availableForWrite();
+			if (room > 0) {
+				_serialTxRoom = true;
+				if (len > (uint16_t)room) {
+					len = room;
+				}
+			} else if (_serialTxRoom) {
+				return;
+			}
+		}
+		len = MY_SERIALDEVICE.write(&_serialTx[_serialTxHead], len);
+		if (!len) {
+			return;
+		}
+		_serialTxHead += len;
+		if (_serialTxHead == MY_GATEWAY_SERIAL_TX_BUFFER) {
+			_serialTxHead = 0;
+		}
+		_serialTxLength -= len;
+	}
+	#if defined(MY_SERIAL_TX_USB_PACKET)
+		_serialTxSince = hwMillis();
+	#endif
+}
+
+void gatewayTransportFlush() {
+	_serialTxDrain(true);
+}
+
+uint16_t gatewayTransportOverflows() {
+	return _serialTxOverflows;
+}
+
 bool gatewayTransportSend(MyMessage &message) {
-	MY_SERIALDEVICE.print(protocolFormat(message));
+	SerialTxPrint out;
+	(void)protocolFormat(message, out);
+	if (!out.commit()) {
+		// Make room with what the serial device takes right now and try again
+		_serialTxDrain(false);
+		SerialTxPrint retry;
+		(void)protocolFormat(message, retry);
+		if (!retry.commit()) {
+			// Still full (e.g. a presentation or an expanded batch sent in a loop): wait for
+			// the serial device rather than losing the message
+			if (_serialTxOverflows < 0xFFFF) {
+				_serialTxOverflows++;
+			}
+			_serialTxDrain(true);
+			SerialTxPrint last;
+			(void)protocolFormat(message, last);
+			if (!last.commit()) {
+				// longer than the whole queue
+				(void)protocolFormat(message, MY_SERIALDEVICE);
+			}
+		}
+	}
+	return true;
+}
+#else
+bool gatewayTransportSend(MyMessage &message) {
+	(void)protocolFormat(message, MY_SERIALDEVICE);
 	// Serial print is always successful
 	return true;
 }
+#endif
 
 bool gatewayTransportInit() {
+	protocolParserReset(_serialParser);
 	gatewayTransportSend(buildGw(_msg, I_GATEWAY_READY).set("Gateway startup complete."));
 	return true;
 }
 
 
 bool gatewayTransportAvailable() {
+	#if MY_GATEWAY_SERIAL_TX_BUFFER > 0
+		_serialTxDrain(false);
+	#endif
 	while (MY_SERIALDEVICE.available()) {
-		// get the new byte:
-		char inChar = (char) MY_SERIALDEVICE.read();
-		// if the incoming character is a newline, set a flag
-		// so the main loop can do something about it:
-		if (_serialInputPos < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
-			if (inChar == '\n') {
-				_serialInputString[_serialInputPos] = 0;
-				bool ok = protocolParse(_serialMsg, _serialInputString);
-				_serialInputPos = 0;
-				return ok;
-			} else {
-				// add it to the inputString:
-				_serialInputString[_serialInputPos] = inChar;
-				_serialInputPos++;
-			}
-		} else {
-			// Incoming message too long. Throw away
-			_serialInputPos = 0;
+		// Parse incoming characters as they arrive, a newline completes the message
+		if (protocolParseChar(_serialParser, _serialMsg, (char) MY_SERIALDEVICE.read())) {
+			return true;
 		}
 	}
 	return false;
@@ -35,6 +35,10 @@
 #define hwWatchdogReset() wdt_reset()
 #define hwReboot() wdt_enable(WDTO_15MS); while (1)
 #define hwMillis() millis()
+#define hwMicros() micros()
+unsigned long hwSleepTime(); // ms spent in timed sleep, not counted by hwMillis()
+void hwConfigFlush(bool force); // commit deferred config writes (called from _process(), force before sleep)
+void hwIdle(); // light sleep until the next interrupt (radio, serial, system tick), used by wait()
 
 void hwReadConfigBlock(void* buf, void* adr, size_t length);
 void hwWriteConfigBlock(void* buf, void* adr, size_t length);
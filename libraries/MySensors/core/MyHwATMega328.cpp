@@ -32,10 +32,13 @@ void wakeUp2()	 //place to send the second interrupts
 	pinIntTrigger = 2;
 }
 
+static volatile bool _hwWdtFired = false;
+
 // Watchdog Timer interrupt service routine. This routine is required
 // to allow automatic WDIF and WDIE bit clearance in hardware.
 ISR (WDT_vect)
 {
+	_hwWdtFired = true;
 }
 
 void hwPowerDown(period_t period) {
@@ -75,23 +78,192 @@ void hwPowerDown(period_t period) {
 	ADCSRA |= (1 << ADEN);
 }
 
-void hwInternalSleep(unsigned long ms) {
+// Time spent powered down by timed sleeps, millis() does not advance meanwhile
+static unsigned long _hwSleepTime = 0;
+// Fraction of a ms slept that is not in _hwSleepTime yet (us)
+static uint16_t _hwSleepTimeUs = 0;
+
+// Length of the shortest watchdog period (nominally 16.384ms) in us, measured by
+// hwWatchdogCalibrate(). Period n of period_t is this shifted left n times.
+static unsigned long _hwWdtPeriodUs = 16384;
+// _hwSleepTime at which the period is measured again
+static unsigned long _hwWdtCalibrateAt = 0;
+
+// Shortest periods timed by hwWatchdogCalibrate(), 4 keep the result within 0.1%
+#define WDT_CALIBRATION_PERIODS 4
+
+void hwWatchdogCalibrate() {
+	uint8_t WDTsave = WDTCSR;
+	// interrupt only mode, shortest period
+	cli();
+	wdt_reset();
+	WDTCSR |= (1 << WDCE) | (1 << WDE);
+	WDTCSR = (1 << WDIE);
+	sei();
+	// the first interrupt aligns to a period boundary
+	_hwWdtFired = false;
+	while (!_hwWdtFired);
+	unsigned long start = micros();
+	for (uint8_t i = 0; i < WDT_CALIBRATION_PERIODS; i++) {
+		_hwWdtFired = false;
+		while (!_hwWdtFired);
+	}
+	_hwWdtPeriodUs = (micros() - start) / WDT_CALIBRATION_PERIODS;
+	// restore previous WDT settings
+	cli();
+	wdt_reset();
+	WDTCSR |= (1 << WDCE) | (1 << WDE);
+	WDTCSR = WDTsave;
+	sei();
+	_hwWdtCalibrateAt = _hwSleepTime + MY_SLEEP_CALIBRATION_INTERVAL;
+}
+
+#if defined(MY_SLEEP_TIMER2_ASYNC)
+
+#define TIMER2_ASYNC_BUSY ((1 << TCN2UB) | (1 << OCR2AUB) | (1 << OCR2BUB) | (1 << TCR2AUB) | (1 << TCR2BUB))
+static volatile bool _hwTimer2Fired = false;
+// Fraction of a ms slept that is not in _hwSleepTime yet (1/4096 ms, a crystal cycle is 125 of them)
+static uint16_t _hwSleepTimeFrac = 0;
+
+ISR (TIMER2_COMPB_vect)
+{
+	_hwTimer2Fired = true;
+}
+
+// Power save for ticks (1 - 256) of Timer2 with clock select cs, returns the ticks that passed
+static uint16_t hwTimer2Sleep(uint8_t cs, uint16_t ticks) {
+	GTCCR |= (1 << PSRASY); // restart the prescaler, the first tick is a whole one
+	TCNT2 = 0;
+	OCR2B = ticks - 1; // the flag is set one tick after the match
+	TCCR2B = cs;
+	while (ASSR & TIMER2_ASYNC_BUSY);
+	TIFR2 = (1 << OCF2B);
+	_hwTimer2Fired = false;
+	TIMSK2 |= (1 << OCIE2B);
+	// disable ADC for power saving
+	ADCSRA &= ~(1 << ADEN);
+	uint8_t WDTsave = WDTCSR;
+	wdt_disable();
+	set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+	cli();
+	sleep_enable();
+#if defined __AVR_ATmega328P__
+	sleep_bod_disable();
+#endif
+	sei();
+	// sleep until Timer2 or ext. interrupt
+	sleep_cpu();
+	sleep_disable();
+	// restore previous WDT settings
+	cli();
+	wdt_reset();
+	WDTCSR |= (1 << WDCE) | (1 << WDE);
+	WDTCSR = WDTsave;
+	sei();
+	ADCSRA |= (1 << ADEN);
+	TIMSK2 &= ~(1 << OCIE2B);
+	// TCNT2 reads correctly only after the next TOSC1 edge, a write waits for it.
+	// It also has to pass before the next power save.
+	OCR2B = ticks - 1;
+	while (ASSR & TIMER2_ASYNC_BUSY);
+	uint16_t passed = _hwTimer2Fired ? ticks : TCNT2;
+	TCCR2B = 0;
+	while (ASSR & TIMER2_ASYNC_BUSY);
+	return passed;
+}
+
+unsigned long hwInternalSleep(unsigned long ms) {
+	unsigned long slept = 0;
+	if (!(ASSR & (1 << AS2))) {
+		TIMSK2 = 0;
+		// switching the clock may corrupt the Timer2 registers
+		ASSR = (1 << AS2);
+		TCCR2A = 0;
+		TCCR2B = 0;
+		TCNT2 = 0;
+		while (ASSR & TIMER2_ASYNC_BUSY);
+		TIFR2 = (1 << OCF2B) | (1 << OCF2A) | (1 << TOV2);
+	}
+	// Let serial prints finish (debug, log etc)
+  #ifndef MY_DISABLED_SERIAL
+	  MY_SERIALDEVICE.flush();
+  #endif
+	// reset interrupt trigger var
+	pinIntTrigger = 0;
+	while (slept < ms) {
+		// 1024 prescaler (31.25ms ticks, up to 8s), the rest with 32 prescaler (0.98ms ticks)
+		unsigned long cycles = ms - slept >= 8000 ? 262144UL : ((ms - slept) << 15) / 1000;
+		uint8_t cs, shift;
+		if (cycles >= 1024) {
+			cs = (1 << CS22) | (1 << CS21) | (1 << CS20);
+			shift = 10;
+		} else if (cycles >= 32) {
+			cs = (1 << CS21) | (1 << CS20);
+			shift = 5;
+		} else {
+			break;
+		}
+		uint16_t ticks = cycles >> shift;
+		uint16_t passed = hwTimer2Sleep(cs, ticks);
+		// unlike the watchdog, the part of a period cut short by a pin interrupt is known
+		unsigned long frac = ((unsigned long)passed << shift) * 125 + _hwSleepTimeFrac;
+		_hwSleepTime += frac >> 12;
+		slept += frac >> 12;
+		_hwSleepTimeFrac = frac & 4095;
+		// other interrupts (e.g. pin change) only cost a wake-up
+		if (pinIntTrigger) break;
+	}
+	return slept;
+}
+
+#else
+
+// Power down for one watchdog period. Only periods that ran out are added to
+// _hwSleepTime, how much of a period cut short by a pin interrupt passed is unknown.
+static unsigned long hwSleepPeriod(uint8_t period) {
+	hwPowerDown((period_t)period);
+	if (pinIntTrigger) return 0;
+	unsigned long us = (_hwWdtPeriodUs << period) + _hwSleepTimeUs;
+	_hwSleepTime += us / 1000;
+	_hwSleepTimeUs = us % 1000;
+	return us / 1000;
+}
+
+unsigned long hwInternalSleep(unsigned long ms) {
+	unsigned long slept = 0;
+	#if MY_SLEEP_CALIBRATION_INTERVAL > 0
+		if ((long)(_hwSleepTime - _hwWdtCalibrateAt) >= 0) {
+			hwWatchdogCalibrate();
+		}
+	#endif
 	// Let serial prints finish (debug, log etc)
   #ifndef MY_DISABLED_SERIAL
 	  MY_SERIALDEVICE.flush();
   #endif
 	// reset interrupt trigger var
 	pinIntTrigger = 0;
-	while (!pinIntTrigger && ms >= 8000) { hwPowerDown(SLEEP_8S); ms -= 8000; }
-	if (!pinIntTrigger && ms >= 4000)    { hwPowerDown(SLEEP_4S); ms -= 4000; }
-	if (!pinIntTrigger && ms >= 2000)    { hwPowerDown(SLEEP_2S); ms -= 2000; }
-	if (!pinIntTrigger && ms >= 1000)    { hwPowerDown(SLEEP_1S); ms -= 1000; }
-	if (!pinIntTrigger && ms >= 500)     { hwPowerDown(SLEEP_500MS); ms -= 500; }
-	if (!pinIntTrigger && ms >= 250)     { hwPowerDown(SLEEP_250MS); ms -= 250; }
-	if (!pinIntTrigger && ms >= 125)     { hwPowerDown(SLEEP_120MS); ms -= 120; }
-	if (!pinIntTrigger && ms >= 64)      { hwPowerDown(SLEEP_60MS); ms -= 60; }
-	if (!pinIntTrigger && ms >= 32)      { hwPowerDown(SLEEP_30MS); ms -= 30; }
-	if (!pinIntTrigger && ms >= 16)      { hwPowerDown(SLEEP_15MS); ms -= 15; }
+	// Longest periods first, the periods double so each shorter one is needed at most
+	// once, which gives the fewest wake-ups. A rest shorter than a period is not slept.
+	for (int8_t period = SLEEP_8S; period >= SLEEP_15MS && !pinIntTrigger; period--) {
+		unsigned long periodMs = (_hwWdtPeriodUs << period) / 1000;
+		while (!pinIntTrigger && slept < ms && ms - slept >= periodMs) {
+			slept += hwSleepPeriod(period);
+		}
+	}
+	return slept;
+}
+
+#endif
+
+void hwIdle() {
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sleep_cpu();
+	sleep_disable();
+}
+
+unsigned long hwSleepTime() {
+	return _hwSleepTime;
 }
 
 int8_t hwSleep(unsigned long ms) {
@@ -189,8 +361,16 @@ uint16_t hwFreeMem() {
 
 
 #ifdef MY_DEBUG
+#if defined(MY_GATEWAY_SERIAL) && MY_GATEWAY_SERIAL_TX_BUFFER > 0
+	extern void gatewayTransportFlush();
+#endif
+
 void hwDebugPrint(const char *fmt, ... ) {
 	char fmtBuffer[300];
+	#if defined(MY_GATEWAY_SERIAL) && MY_GATEWAY_SERIAL_TX_BUFFER > 0
+		// Queued messages go out first, so the lines to the controller do not mix
+		gatewayTransportFlush();
+	#endif
 	#ifdef MY_GATEWAY_FEATURE
 		// prepend debug message to be handled correctly by controller (C_INTERNAL, I_LOG_MESSAGE)
 		snprintf_P(fmtBuffer, 299, PSTR("0;255;%d;0;%d;"), C_INTERNAL, I_LOG_MESSAGE);
@@ -61,7 +61,9 @@ do { 																\
 #define hwWatchdogReset() wdt_reset()
 #define hwReboot() wdt_enable(WDTO_15MS); while (1)
 #define hwMillis() millis()
+#define hwMicros() micros()
 #define hwReadConfig(__pos) (eeprom_read_byte((uint8_t*)(__pos)))
+#define hwConfigFlush(__force) // EEPROM writes are immediate
 
 #ifndef eeprom_update_byte
 	#define hwWriteConfig(loc, val) if((uint8_t)(val) != eeprom_read_byte((uint8_t*)(loc))) { eeprom_write_byte((uint8_t*)(loc), (val)); }
@@ -71,7 +73,8 @@ do { 																\
 
 //
 #define hwReadConfigBlock(__buf, __pos, __length) (eeprom_read_block((__buf), (void*)(__pos), (__length)))
-#define hwWriteConfigBlock(__pos, __buf, __length) (eeprom_write_block((void*)(__pos), (void*)__buf, (__length)))
+// Only rewrites bytes that changed (each written byte costs ~3.3ms and wears the cell)
+#define hwWriteConfigBlock(__pos, __buf, __length) (eeprom_update_block((void*)(__pos), (void*)__buf, (__length)))
 
 
 
@@ -90,6 +93,14 @@ enum period_t
 	SLEEP_FOREVER
 };
 
-void hwInternalSleep(unsigned long ms);
+// Returns the time actually slept in ms
+unsigned long hwInternalSleep(unsigned long ms);
+// Milliseconds spent in timed sleep since start-up (calibrated watchdog periods)
+unsigned long hwSleepTime();
+// Idle mode until the next interrupt. Timer0 (millis) keeps running and wakes
+// the CPU at least every 1ms, radio IRQ and serial RX wake it right away.
+void hwIdle();
+// Measures the watchdog period against the system clock
+void hwWatchdogCalibrate();
 
 #endif
@@ -40,6 +40,202 @@ ISR (WDT_vect)
 }
 */
 
+#if defined(MY_CONFIG_LOG_STORE)
+
+extern "C" {
+#include "spi_flash.h"
+}
+extern "C" uint32_t _SPIFFS_end;
+
+// Log-structured config store. Two flash sectors take turns, the one with the newer header is
+// active. After its header word, a sector holds records: a header word (address, length, check)
+// followed by the data, padded to whole words. Replaying the records rebuilds the RAM mirror,
+// which serves all reads. Writes append a record for the changed bytes. When the sector is full
+// the mirror is written to the other sector as a snapshot and that one becomes active.
+#define CONFIG_LOG_SIZE 1024 // bytes of config, like the ATMega328 EEPROM
+#define CONFIG_LOG_MAGIC 0xC0F6
+#define CONFIG_LOG_CHUNK 128 // data bytes per snapshot record
+#define CONFIG_LOG_MAX_RECORD 256
+#ifndef MY_CONFIG_LOG_SECTOR
+	// the EEPROM sector and the one before it (last SPIFFS sector)
+	#define MY_CONFIG_LOG_SECTOR ((((uint32_t)&_SPIFFS_end - 0x40200000) / SPI_FLASH_SEC_SIZE) - 1)
+#endif
+
+static uint8_t _configMirror[CONFIG_LOG_SIZE];
+static uint8_t _configSector;  // active sector, 0 or 1
+static uint16_t _configSeq;    // generation of the active sector
+static uint32_t _configEnd;    // offset of the next record in the active sector
+
+static uint32_t configLogAddress(uint8_t sector, uint32_t offs)
+{
+  return (MY_CONFIG_LOG_SECTOR + sector) * SPI_FLASH_SEC_SIZE + offs;
+}
+
+static uint8_t configLogCheck(uint32_t header, const uint8_t* data, uint16_t length)
+{
+  // rotate and xor, never 0xFF for an erased header
+  uint8_t check = 0x5A ^ header ^ (header >> 8) ^ (header >> 16);
+  while (length--)
+  {
+    check = ((check << 1) | (check >> 7)) ^ *data++;
+  }
+  return check == 0xFF ? 0 : check;
+}
+
+// Appends a record, false if it does not fit into the active sector
+static bool configLogAppend(uint16_t adr, const uint8_t* data, uint16_t length)
+{
+  uint32_t buf[1 + CONFIG_LOG_MAX_RECORD / 4];
+  uint32_t size = 4 + ((length + 3) & ~3);
+  if (_configEnd + size > SPI_FLASH_SEC_SIZE)
+  {
+    return false;
+  }
+  memset(buf, 0xFF, size);
+  memcpy(&buf[1], data, length);
+  buf[0] = adr | ((uint32_t)(length - 1) << 16);
+  buf[0] |= (uint32_t)configLogCheck(buf[0], data, length) << 24;
+  noInterrupts();
+  spi_flash_write(configLogAddress(_configSector, _configEnd), buf, size);
+  interrupts();
+  _configEnd += size;
+  return true;
+}
+
+// Writes the mirror to the other sector and makes it the active one
+static void configLogCompact()
+{
+  _configSector ^= 1;
+  _configEnd = 4;
+  noInterrupts();
+  spi_flash_erase_sector(MY_CONFIG_LOG_SECTOR + _configSector);
+  interrupts();
+  for (uint16_t adr = 0; adr < CONFIG_LOG_SIZE; adr += CONFIG_LOG_CHUNK)
+  {
+    // erased config needs no record
+    for (uint16_t i = 0; i < CONFIG_LOG_CHUNK; i++)
+    {
+      if (_configMirror[adr + i] != 0xFF)
+      {
+        configLogAppend(adr, &_configMirror[adr], CONFIG_LOG_CHUNK);
+        break;
+      }
+    }
+  }
+  // header last, a compaction cut short leaves the other sector active
+  uint32_t header = CONFIG_LOG_MAGIC | ((uint32_t)++_configSeq << 16);
+  noInterrupts();
+  spi_flash_write(configLogAddress(_configSector, 0), &header, 4);
+  interrupts();
+}
+
+// Replays the active sector, false if it ends in a damaged record
+static bool configLogReplay()
+{
+  uint32_t buf[CONFIG_LOG_MAX_RECORD / 4];
+  _configEnd = 4;
+  while (_configEnd + 4 <= SPI_FLASH_SEC_SIZE)
+  {
+    uint32_t header;
+    spi_flash_read(configLogAddress(_configSector, _configEnd), &header, 4);
+    if (header == 0xFFFFFFFF)
+    {
+      return true;
+    }
+    uint16_t adr = header & 0xFFFF;
+    uint16_t length = ((header >> 16) & 0xFF) + 1;
+    uint32_t size = (length + 3) & ~3;
+    if (adr + length > CONFIG_LOG_SIZE || _configEnd + 4 + size > SPI_FLASH_SEC_SIZE)
+    {
+      return false;
+    }
+    spi_flash_read(configLogAddress(_configSector, _configEnd + 4), buf, size);
+    if (configLogCheck(header & 0xFFFFFF, (uint8_t*)buf, length) != header >> 24)
+    {
+      return false;
+    }
+    memcpy(&_configMirror[adr], buf, length);
+    _configEnd += 4 + size;
+  }
+  return true;
+}
+
+static void hwInitConfigBlock()
+{
+  static bool initDone = false;
+  if (initDone)
+  {
+    return;
+  }
+  initDone = true;
+  uint32_t header[2];
+  spi_flash_read(configLogAddress(0, 0), &header[0], 4);
+  spi_flash_read(configLogAddress(1, 0), &header[1], 4);
+  bool valid0 = (header[0] & 0xFFFF) == CONFIG_LOG_MAGIC;
+  bool valid1 = (header[1] & 0xFFFF) == CONFIG_LOG_MAGIC;
+  memset(_configMirror, 0xFF, CONFIG_LOG_SIZE);
+  if (!valid0 && !valid1)
+  {
+    // first start, take over the config of the EEPROM library (start of the second sector)
+    spi_flash_read(configLogAddress(1, 0), (uint32_t*)_configMirror, CONFIG_LOG_SIZE);
+    _configSector = 1;
+    _configSeq = 0;
+    configLogCompact();
+    return;
+  }
+  _configSector = !valid0 || (valid1 && (int16_t)((header[1] >> 16) - (header[0] >> 16)) > 0);
+  _configSeq = header[_configSector] >> 16;
+  if (!configLogReplay())
+  {
+    // a write was cut short, continue on a clean sector
+    configLogCompact();
+  }
+}
+
+void hwReadConfigBlock(void* buf, void* adr, size_t length)
+{
+  hwInitConfigBlock();
+  memcpy(buf, &_configMirror[reinterpret_cast<int>(adr)], length);
+}
+
+void hwWriteConfigBlock(void* buf, void* adr, size_t length)
+{
+  hwInitConfigBlock();
+  uint8_t* src = static_cast<uint8_t*>(buf);
+  unsigned int offs = reinterpret_cast<int>(adr);
+  unsigned int end = offs + length;
+  // one record for the changed part of every CONFIG_LOG_MAX_RECORD bytes
+  while (offs < end)
+  {
+    unsigned int chunkEnd = min(offs + CONFIG_LOG_MAX_RECORD, end);
+    int first = -1;
+    unsigned int last = 0;
+    for (unsigned int i = offs; i < chunkEnd; i++, src++)
+    {
+      if (_configMirror[i] != *src)
+      {
+        _configMirror[i] = *src;
+        if (first < 0) first = i;
+        last = i;
+      }
+    }
+    if (first >= 0 && !configLogAppend(first, &_configMirror[first], last - first + 1))
+    {
+      // sector full, the snapshot includes this change
+      configLogCompact();
+    }
+    offs = chunkEnd;
+  }
+}
+
+void hwConfigFlush(bool force)
+{
+  // records are written right away
+  (void)force;
+}
+
+#else
+
 static void hwInitConfigBlock( size_t length = 1024 /*ATMega328 has 1024 bytes*/ )
 {
   static bool initDone = false;
@@ -61,18 +257,53 @@ void hwReadConfigBlock(void* buf, void* adr, size_t length)
   }
 }
 
+// EEPROM is a RAM mirror of one flash sector and a commit erases and rewrites the whole
+// sector (~30ms). Writes only change the mirror, hwConfigFlush() commits them once in a while.
+static bool _hwConfigDirty = false;
+static unsigned long _hwConfigDirtySince; // first write since the last commit
+static unsigned long _hwConfigWrittenAt;  // last write
+
 void hwWriteConfigBlock(void* buf, void* adr, size_t length)
 {
   hwInitConfigBlock();
   uint8_t* src = static_cast<uint8_t*>(buf);
   int offs = reinterpret_cast<int>(adr);
+  // only bytes that actually change make the mirror dirty
   while (length-- > 0)
   {
-    EEPROM.write(offs++, *src++);
+    if (EEPROM.read(offs) != *src)
+    {
+      EEPROM.write(offs, *src);
+      _hwConfigWrittenAt = millis();
+      if (!_hwConfigDirty)
+      {
+        _hwConfigDirty = true;
+        _hwConfigDirtySince = _hwConfigWrittenAt;
+      }
+    }
+    offs++;
+    src++;
   }
-  EEPROM.commit();
 }
 
+void hwConfigFlush(bool force)
+{
+  if (!_hwConfigDirty)
+  {
+    return;
+  }
+  unsigned long now = millis();
+  // wait for a burst of writes (e.g. routing table updates) to end, but not forever
+  if (force || now - _hwConfigWrittenAt >= MY_CONFIG_COMMIT_IDLE ||
+      now - _hwConfigDirtySince >= MY_CONFIG_COMMIT_TIMEOUT)
+  {
+    EEPROM.commit();
+    _hwConfigDirty = false;
+  }
+}
+
+#endif
+
 uint8_t hwReadConfig(int adr)
 {
   uint8_t value;
@@ -91,7 +322,7 @@ void hwWriteConfig(int adr, uint8_t value)
 
 
 int8_t hwSleep(unsigned long ms) {
-	// TODO: Not supported!
+	// TODO: Not supported! A sleep implementation has to hwConfigFlush(true) first.
 	(void)ms;
 	return -2;
 }
@@ -131,8 +362,16 @@ uint16_t hwFreeMem() {
 }
 
 #ifdef MY_DEBUG
+#if defined(MY_GATEWAY_SERIAL) && MY_GATEWAY_SERIAL_TX_BUFFER > 0
+	extern void gatewayTransportFlush();
+#endif
+
 void hwDebugPrint(const char *fmt, ... ) {
 	char fmtBuffer[300];
+	#if defined(MY_GATEWAY_SERIAL) && MY_GATEWAY_SERIAL_TX_BUFFER > 0
+		// Queued messages go out first, so the lines to the controller do not mix
+		gatewayTransportFlush();
+	#endif
 	#ifdef MY_GATEWAY_FEATURE
 		// prepend debug message to be handled correctly by controller (C_INTERNAL, I_LOG_MESSAGE)
 		snprintf_P(fmtBuffer, 299, PSTR("0;255;%d;0;%d;"), C_INTERNAL, I_LOG_MESSAGE);
@@ -36,13 +36,19 @@
 #define hwDigitalWrite(__pin, __value) (digitalWrite(__pin, __value))
 #define hwInit() MY_SERIALDEVICE.begin(MY_BAUD_RATE); MY_SERIALDEVICE.setDebugOutput(true)
 #define hwWatchdogReset() wdt_reset()
-#define hwReboot() wdt_enable(WDTO_15MS); while (1)
+#define hwReboot() hwConfigFlush(true); wdt_enable(WDTO_15MS); while (1)
 #define hwMillis() millis()
+#define hwMicros() micros()
+#define hwSleepTime() (0UL) // sleep not supported, millis() is all there is
+#define hwIdle() yield() // let the WiFi stack run, it sleeps the modem when it can
 
 void hwReadConfigBlock(void* buf, void* adr, size_t length);
 void hwWriteConfigBlock(void* buf, void* adr, size_t length);
 void hwWriteConfig(int adr, uint8_t value);
 uint8_t hwReadConfig(int adr);
+// Config writes only change the RAM mirror, this commits them to flash once they have settled
+// (MY_CONFIG_COMMIT_IDLE/MY_CONFIG_COMMIT_TIMEOUT) or right away if force is set
+void hwConfigFlush(bool force);
 
 
 #endif // #ifdef ARDUINO_ARCH_ESP8266
@@ -42,43 +42,83 @@ ISR (WDT_vect)
 
 
 
-void i2c_eeprom_write_byte(unsigned int eeaddress, byte data ) {
-  int rdata = data;
+// Writes up to one page, must not cross a page boundary
+void i2c_eeprom_write_page(unsigned int eeaddress, const byte* data, byte length) {
   Wire.beginTransmission(I2C_EEP_ADDRESS);
   Wire.write((int)(eeaddress >> 8)); // MSB
   Wire.write((int)(eeaddress & 0xFF)); // LSB
-  Wire.write(rdata);
+  Wire.write(data, length);
   Wire.endTransmission();
+  // Acknowledge polling, the EEPROM does not respond until the write cycle (max 5ms) is done
+  unsigned long enter = millis();
+  do {
+    Wire.beginTransmission(I2C_EEP_ADDRESS);
+  } while (Wire.endTransmission() != 0 && millis() - enter < 10);
+}
+
+void i2c_eeprom_read_block(unsigned int eeaddress, byte* data, size_t length) {
+  while (length) {
+    // Stay within the Wire buffer
+    byte chunk = length > 32 ? 32 : length;
+    Wire.beginTransmission(I2C_EEP_ADDRESS);
+    Wire.write((int)(eeaddress >> 8)); // MSB
+    Wire.write((int)(eeaddress & 0xFF)); // LSB
+    Wire.endTransmission();
+    Wire.requestFrom(I2C_EEP_ADDRESS, chunk);
+    for (byte i = 0; i < chunk; i++) {
+      *data++ = Wire.available() ? Wire.read() : 0xFF;
+    }
+    eeaddress += chunk;
+    length -= chunk;
+  }
 }
 
-byte i2c_eeprom_read_byte(unsigned int eeaddress ) {
-  byte rdata = 0xFF;
-  Wire.beginTransmission(I2C_EEP_ADDRESS);
-  Wire.write((int)(eeaddress >> 8)); // MSB
-  Wire.write((int)(eeaddress & 0xFF)); // LSB
-  Wire.endTransmission();
-  Wire.requestFrom(I2C_EEP_ADDRESS,1);
-  if (Wire.available()) rdata = Wire.read();
-  return rdata;
+// configBlock is a RAM mirror of the EEPROM, loaded on first access
+static void hwInitConfigBlock() {
+  static bool initDone = false;
+  if (!initDone) {
+    i2c_eeprom_read_block(0, configBlock, sizeof(configBlock));
+    initDone = true;
+  }
 }
 
 void hwReadConfigBlock(void* buf, void* adr, size_t length)
 {
+  hwInitConfigBlock();
   uint8_t* dst = static_cast<uint8_t*>(buf);
   int offs = reinterpret_cast<int>(adr);
   while (length-- > 0)
   {
-    *dst++ = i2c_eeprom_read_byte(offs++); 
+    *dst++ = configBlock[offs++];
   }
 }
 
 void hwWriteConfigBlock(void* buf, void* adr, size_t length)
 {
+  hwInitConfigBlock();
   uint8_t* src = static_cast<uint8_t*>(buf);
-  int offs = reinterpret_cast<int>(adr);
-  while (length-- > 0)
+  unsigned int offs = reinterpret_cast<int>(adr);
+  unsigned int end = offs + length;
+  // Update the mirror and write the changed part of every touched page in one go
+  while (offs < end)
   {
-     i2c_eeprom_write_byte(offs++, *src++);
+    unsigned int pageEnd = min((offs / I2C_EEP_PAGE_SIZE + 1) * I2C_EEP_PAGE_SIZE, end);
+    int first = -1;
+    unsigned int last = 0;
+    for (unsigned int i = offs; i < pageEnd; i++, src++)
+    {
+      if (configBlock[i] != *src)
+      {
+        configBlock[i] = *src;
+        if (first < 0) first = i;
+        last = i;
+      }
+    }
+    if (first >= 0)
+    {
+      i2c_eeprom_write_page(first, &configBlock[first], last - first + 1);
+    }
+    offs = pageEnd;
   }
 }
 
@@ -154,9 +194,17 @@ uint16_t hwFreeMem() {
 }
 
 #ifdef MY_DEBUG
+#if defined(MY_GATEWAY_SERIAL) && MY_GATEWAY_SERIAL_TX_BUFFER > 0
+	extern void gatewayTransportFlush();
+#endif
+
 void hwDebugPrint(const char *fmt, ... ) {
   if (MY_SERIALDEVICE) {
 	char fmtBuffer[300];
+	#if defined(MY_GATEWAY_SERIAL) && MY_GATEWAY_SERIAL_TX_BUFFER > 0
+		// Queued messages go out first, so the lines to the controller do not mix
+		gatewayTransportFlush();
+	#endif
 	#ifdef MY_GATEWAY_FEATURE
 		// prepend debug message to be handled correctly by controller (C_INTERNAL, I_LOG_MESSAGE)
 		snprintf(fmtBuffer, 299, PSTR("0;255;%d;0;%d;"), C_INTERNAL, I_LOG_MESSAGE);
@@ -29,6 +29,8 @@
 
 #include <avr/dtostrf.h>
 #define I2C_EEP_ADDRESS 0x50
+// Page size of 24C32/24C64, larger parts (e.g. 24LC256) have bigger pages and work as well
+#define I2C_EEP_PAGE_SIZE 32
 
 #define min(a,b) ((a)<(b)?(a):(b))
 #define max(a,b) ((a)>(b)?(a):(b))
@@ -43,11 +45,15 @@ void hwInit();
 void hwWatchdogReset();
 void hwReboot();
 #define hwMillis() millis()
+#define hwMicros() micros()
+#define hwSleepTime() (0UL) // sleep not supported, millis() is all there is
+#define hwIdle() __WFI() // SysTick wakes the core every 1ms
 
 void hwReadConfigBlock(void* buf, void* adr, size_t length);
 void hwWriteConfigBlock(void* buf, void* adr, size_t length);
 void hwWriteConfig(int adr, uint8_t value);
 uint8_t hwReadConfig(int adr);
+#define hwConfigFlush(__force) // writes go straight to the EEPROM
 
 #define MY_SERIALDEVICE SerialUSB
 
@@ -19,12 +19,18 @@
 
 #include "MyLeds.h"
 
-// these variables don't need to be volatile, since we are not using interrupts
-uint8_t _countRx;
-uint8_t _countTx;
-uint8_t _countErr;
+// Blink cycles left per LED, 255 = idle. Counted down by the Timer0 interrupt on AVR.
+volatile uint8_t _countRx;
+volatile uint8_t _countTx;
+volatile uint8_t _countErr;
 unsigned long _blink_next_time;
 
+#if defined(MY_LEDS_TIMER0)
+	#define ledsRun() (TIMSK0 |= _BV(OCIE0A))
+#else
+	#define ledsRun()
+#endif
+
 inline void ledsInit() {
 	// Setup led pins
 	pinMode(MY_DEFAULT_RX_LED_PIN, OUTPUT);
@@ -40,9 +46,14 @@ inline void ledsInit() {
 	_countRx = 0;
 	_countTx = 0;
 	_countErr = 0;
+	ledsRun();
 }
 
+#if defined(MY_LEDS_TIMER0)
+static inline void ledsUpdate() {
+#else
 inline void ledsProcess() {
+#endif
 	// Just return if it is not the time...
 	// http://playground.arduino.cc/Code/TimingRollover
 	if ((long)(hwMillis() - _blink_next_time) < 0)
@@ -85,15 +96,25 @@ inline void ledsProcess() {
 		--_countErr;
 }
 
+#if defined(MY_LEDS_TIMER0)
+ISR(TIMER0_COMPA_vect) {
+	ledsUpdate();
+	if (_countRx == 255 && _countTx == 255 && _countErr == 255) {
+		// all off, no more interrupts until the next blink
+		TIMSK0 &= ~_BV(OCIE0A);
+	}
+}
+#endif
+
 void ledsBlinkRx(uint8_t cnt) {
-  if(_countRx == 255) { _countRx = cnt; }
+  if(_countRx == 255) { _countRx = cnt; ledsRun(); }
 }
 
 void ledsBlinkTx(uint8_t cnt) {
-  if(_countTx == 255) { _countTx = cnt; }
+  if(_countTx == 255) { _countTx = cnt; ledsRun(); }
 }
 
 void ledsBlinkErr(uint8_t cnt) {
-  if(_countErr == 255) { _countErr = cnt; }
+  if(_countErr == 255) { _countErr = cnt; ledsRun(); }
 }
 
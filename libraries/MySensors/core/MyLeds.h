@@ -42,7 +42,17 @@
 	void ledsBlinkRx(uint8_t cnt);
 	void ledsBlinkTx(uint8_t cnt);
 	void ledsBlinkErr(uint8_t cnt);
-	void ledsProcess(); // do the actual blinking
+
+	#if defined(MY_LEDS_TIMER0) && !(defined(__AVR__) && defined(TIMSK0) && defined(OCIE0A))
+		#undef MY_LEDS_TIMER0
+	#endif
+	#if defined(MY_LEDS_TIMER0)
+		// Blinking runs in the Timer0 compare A interrupt (the millis() timer, once per ms and only
+		// while a LED is blinking), nothing left to do in process(). OCR0A keeps working for PWM.
+		#define ledsProcess()
+	#else
+		void ledsProcess(); // do the actual blinking
+	#endif
 
 #else
 	// Remove led functions if feature is disabled
@@ -83,26 +83,234 @@ char* MyMessage::getStream(char *buffer) const {
 	}
 }
 
+// Writes value in decimal, returns the end of the digits (not terminated)
+static char* ulongToString(uint32_t value, char *buffer) {
+	char digits[10];
+	uint8_t n = 0;
+	if (value <= 0xFFFF) {
+		// 16 bit divisions are a lot cheaper on 8 bit MCUs
+		uint16_t v = value;
+		do {
+			digits[n++] = '0' + (v % 10);
+			v /= 10;
+		} while (v);
+	} else {
+		do {
+			digits[n++] = '0' + (value % 10);
+			value /= 10;
+		} while (value);
+	}
+	while (n) {
+		*buffer++ = digits[--n];
+	}
+	return buffer;
+}
+
+static char* longToString(int32_t value, char *buffer) {
+	if (value < 0) {
+		*buffer++ = '-';
+		return ulongToString(-(uint32_t)value, buffer);
+	}
+	return ulongToString(value, buffer);
+}
+
+// Fixed point replacement for dtostrf(value, 0, decimals), without the printf machinery.
+// Rounds half away from zero. Only the integer part of values of 2^32 and above is
+// approximated, float has no more than 7 significant digits there anyway.
+static char* floatToString(float value, uint8_t decimals, char *buffer) {
+	if (value != value) {
+		memcpy(buffer, "nan", 3);
+		return buffer + 3;
+	}
+	if (value < 0) {
+		*buffer++ = '-';
+		value = -value;
+	}
+	if (value > 3.4028235e38f) {
+		memcpy(buffer, "inf", 3);
+		return buffer + 3;
+	}
+	uint32_t scale = 1;
+	for (uint8_t i = 0; i < decimals; i++) {
+		scale *= 10;
+	}
+	uint32_t whole;
+	uint32_t fraction = 0;
+	uint8_t zeros = 0;
+	if (value >= 4294967296.0f) {
+		// Powers of ten up to 1e10 are exact floats, few divisions keep the rounding error low
+		while (value >= 1e19f) {
+			value /= 1e10f;
+			zeros += 10;
+		}
+		float divisor = 1;
+		while (value >= divisor * 1e9f) {
+			divisor *= 10;
+			zeros++;
+		}
+		whole = value / divisor + 0.5f;
+	} else {
+		whole = value;
+		fraction = (value - whole) * scale + 0.5f;
+		if (fraction >= scale) {
+			whole++;
+			fraction -= scale;
+		}
+	}
+	buffer = ulongToString(whole, buffer);
+	while (zeros--) {
+		*buffer++ = '0';
+	}
+	if (decimals) {
+		*buffer++ = '.';
+		char *end = buffer + decimals;
+		while (end > buffer) {
+			*--end = '0' + (fraction % 10);
+			fraction /= 10;
+		}
+		buffer += decimals;
+	}
+	return buffer;
+}
+
+// IEEE 754 half precision, rounded to nearest. Too large values become inf, too small ones 0.
+static uint16_t floatToHalf(float value) {
+	union { float f; uint32_t u; } v;
+	v.f = value;
+	uint16_t sign = (v.u >> 16) & 0x8000;
+	uint8_t biased = (v.u >> 23) & 0xFF;
+	int16_t exponent = biased - 127 + 15;
+	uint32_t mantissa = v.u & 0x7FFFFF;
+	if (biased == 0xFF) {
+		return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+	}
+	if (exponent >= 31) {
+		return sign | 0x7C00;
+	}
+	if (exponent <= 0) {
+		if (exponent < -10) {
+			return sign;
+		}
+		// Subnormal
+		mantissa |= 0x800000;
+		uint8_t shift = 14 - exponent;
+		uint16_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1) {
+			half++;
+		}
+		return sign | half;
+	}
+	uint16_t half = sign | (exponent << 10) | (mantissa >> 13);
+	// A carry into the exponent still gives the right result
+	if (mantissa & 0x1000) {
+		half++;
+	}
+	return half;
+}
+
+static float halfToFloat(uint16_t half) {
+	union { float f; uint32_t u; } v;
+	uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+	uint8_t exponent = (half >> 10) & 0x1F;
+	uint32_t mantissa = half & 0x3FF;
+	if (exponent == 0x1F) {
+		v.u = sign | 0x7F800000 | (mantissa << 13);
+	} else if (exponent) {
+		v.u = sign | ((uint32_t)(exponent + 112) << 23) | (mantissa << 13);
+	} else if (mantissa) {
+		// Subnormal, normalize
+		exponent = 113;
+		while (!(mantissa & 0x400)) {
+			mantissa <<= 1;
+			exponent--;
+		}
+		v.u = sign | ((uint32_t)exponent << 23) | ((mantissa & 0x3FF) << 13);
+	} else {
+		v.u = sign;
+	}
+	return v.f;
+}
+
+// Decimals that show about the 3 significant digits of a half precision float
+static uint8_t halfDecimals(float value) {
+	if (value < 0) {
+		value = -value;
+	}
+	if (value >= 1 || value == 0) {
+		return value >= 100 || value == 0 ? 0 : value >= 10 ? 1 : 2;
+	}
+	uint8_t decimals = 2;
+	while (value < 1 && decimals < 8) {
+		value *= 10;
+		decimals++;
+	}
+	return decimals;
+}
+
+static float scaledToFloat(int16_t value, uint8_t decimals) {
+	float f = value;
+	while (decimals--) {
+		f /= 10;
+	}
+	return f;
+}
+
+// Exact text of value/10^decimals
+static char* scaledToString(int16_t value, uint8_t decimals, char *buffer) {
+	char digits[10];
+	uint8_t n = 0;
+	uint16_t u = value;
+	if (value < 0) {
+		*buffer++ = '-';
+		u = -value;
+	}
+	decimals = min(decimals, 8);
+	do {
+		digits[n++] = '0' + (u % 10);
+		u /= 10;
+	} while (u || n <= decimals);
+	while (n) {
+		if (n-- == decimals) {
+			*buffer++ = '.';
+		}
+		*buffer++ = digits[n];
+	}
+	return buffer;
+}
+
+// Numeric payload as text, returns the end of the text (not terminated) or NULL for non numeric payloads
+static char* numberToString(const MyMessage &msg, uint8_t payloadType, char *buffer) {
+	switch (payloadType) {
+		case P_BYTE: return ulongToString(msg.bValue, buffer);
+		case P_INT16: return longToString(msg.iValue, buffer);
+		case P_UINT16: return ulongToString(msg.uiValue, buffer);
+		case P_LONG32: return longToString(msg.lValue, buffer);
+		case P_ULONG32: return ulongToString(msg.ulValue, buffer);
+		case P_FLOAT32:
+			if (mGetLength(msg) == 2) {
+				float value = halfToFloat(msg.uiValue);
+				return floatToString(value, halfDecimals(value), buffer);
+			} else if (mGetLength(msg) == 3) {
+				return scaledToString(msg.sValue, msg.sDecimals, buffer);
+			}
+			return floatToString(msg.fValue, min(msg.fPrecision, 8), buffer);
+		default: return NULL;
+	}
+}
+
 char* MyMessage::getString(char *buffer) const {
 	uint8_t payloadType = miGetPayloadType();
 	if (buffer != NULL) {
 		if (payloadType == P_STRING) {
 			strncpy(buffer, data, miGetLength());
 			buffer[miGetLength()] = 0;
-		} else if (payloadType == P_BYTE) {
-			itoa(bValue, buffer, 10);
-		} else if (payloadType == P_INT16) {
-			itoa(iValue, buffer, 10);
-		} else if (payloadType == P_UINT16) {
-			utoa(uiValue, buffer, 10);
-		} else if (payloadType == P_LONG32) {
-			ltoa(lValue, buffer, 10);
-		} else if (payloadType == P_ULONG32) {
-			ultoa(ulValue, buffer, 10);
-		} else if (payloadType == P_FLOAT32) {
-			dtostrf(fValue,2,min(fPrecision, 8),buffer);
 		} else if (payloadType == P_CUSTOM) {
 			return getCustomString(buffer);
+		} else {
+			char *end = numberToString(*this, payloadType, buffer);
+			if (end != NULL) {
+				*end = 0;
+			}
 		}
 		return buffer;
 	} else {
@@ -110,6 +318,31 @@ char* MyMessage::getString(char *buffer) const {
 	}
 }
 
+size_t MyMessage::printString(Print &out) const {
+	uint8_t payloadType = miGetPayloadType();
+	uint8_t length = miGetLength();
+	size_t n = 0;
+	if (payloadType == P_STRING) {
+		// Up to the terminator, like getString()
+		uint8_t i = 0;
+		while (i < length && data[i]) i++;
+		n = out.write((const uint8_t *)data, i);
+	} else if (payloadType == P_CUSTOM) {
+		for (uint8_t i = 0; i < length; i++) {
+			n += out.write(i2h(data[i] >> 4));
+			n += out.write(i2h(data[i]));
+		}
+	} else {
+		// Same size as the getString() buffer, the largest floats have 39 integer digits
+		char text[MAX_PAYLOAD * 2 + 1];
+		char *end = numberToString(*this, payloadType, text);
+		if (end != NULL) {
+			n = out.write((const uint8_t *)text, end - text);
+		}
+	}
+	return n;
+}
+
 bool MyMessage::getBool() const {
 	return getByte();
 }
@@ -127,6 +360,11 @@ uint8_t MyMessage::getByte() const {
 
 float MyMessage::getFloat() const {
 	if (miGetPayloadType() == P_FLOAT32) {
+		if (miGetLength() == 2) {
+			return halfToFloat(uiValue);
+		} else if (miGetLength() == 3) {
+			return scaledToFloat(sValue, sDecimals);
+		}
 		return fValue;
 	} else if (miGetPayloadType() == P_STRING) {
 		return atof(data);
@@ -233,6 +471,30 @@ MyMessage& MyMessage::set(float value, uint8_t decimals) {
 	return *this;
 }
 
+MyMessage& MyMessage::setHalf(float value) {
+	miSetLength(2);
+	miSetPayloadType(P_FLOAT32);
+	uiValue = floatToHalf(value);
+	return *this;
+}
+
+MyMessage& MyMessage::setScaled(float value, uint8_t decimals) {
+	float scaled = value;
+	for (uint8_t i = 0; i < decimals; i++) {
+		scaled *= 10;
+	}
+	scaled += scaled < 0 ? -0.5f : 0.5f;
+	// The negated comparisons also catch nan
+	if (!(scaled >= -32768.5f && scaled < 32767.5f)) {
+		return set(value, decimals);
+	}
+	miSetLength(3);
+	miSetPayloadType(P_FLOAT32);
+	sValue = (int16_t)scaled;
+	sDecimals = decimals;
+	return *this;
+}
+
 MyMessage& MyMessage::set(uint32_t value) {
 	miSetPayloadType(P_ULONG32);
 	miSetLength(4);
@@ -195,7 +195,11 @@ typedef enum {
 	I_PONG,					 //!< in return to ping, sent back to sender, payload incremental hop counter
 	I_REGISTER_REQUEST,		 //!< register request to GW
 	I_REGISTER_RESPONSE,	 //!< register response from GW
-	I_DEBUG					 //!< debug message
+	I_DEBUG,				 //!< debug message
+	I_PRESENTATION_BATCH,	 //!< several presentations, payload is pairs of child id and sensor type
+	I_AGGREGATE,			 //!< several C_SET values, payload is tuples of child id, value type, payload type/length and value
+	I_STATS,				 //!< node statistics (MY_STATS_FEATURE), request payload empty or "C" to clear, response is a NodeStats
+	I_CHANNEL				 //!< RF channel (MY_RF24_CHANNEL_SCAN), to the gateway empty to survey or with the channel to move to, broadcast by the gateway to move the network
 	
 } mysensor_internal;
 
@@ -219,7 +223,7 @@ typedef enum {
 	P_LONG32, 
 	P_ULONG32, 
 	P_CUSTOM, 
-	P_FLOAT32
+	P_FLOAT32 //!< told apart by the length: 5 float and decimals, 2 half precision float, 3 int16 and decimals (value/10^decimals)
 } mysensor_payload;
 
 
@@ -296,6 +300,12 @@ public:
 	char* getStream(char *buffer) const;
 	char* getString(char *buffer) const;
 	const char* getString() const;
+	/**
+	 * Writes the payload as text to out, same format as getString(char*) but without a
+	 * conversion buffer.
+	 * @return Number of characters written
+	 */
+	size_t printString(Print &out) const;
 	void* getCustom() const;
 	bool getBool() const;
 	uint8_t getByte() const;
@@ -320,6 +330,10 @@ public:
 	MyMessage& set(void* payload, uint8_t length);
 	MyMessage& set(const char* value);
 	MyMessage& set(float value, uint8_t decimals);
+	// Compact P_FLOAT32 payloads: a half precision float (about 3 significant digits) or
+	// value*10^decimals as int16 (falls back to set(value, decimals) outside of its range)
+	MyMessage& setHalf(float value);
+	MyMessage& setScaled(float value, uint8_t decimals);
 	MyMessage& set(bool value);
 	MyMessage& set(uint8_t value);
 	MyMessage& set(uint32_t value);
@@ -361,6 +375,10 @@ struct
 			float fValue;
 			uint8_t fPrecision;   // Number of decimals when serializing
 		};
+		struct { // Scaled float messages
+			int16_t sValue;
+			uint8_t sDecimals;    // sValue is the value times 10^sDecimals
+		};
 		struct {  // Presentation messages
 			uint8_t version; 	  // Library version
    		    uint8_t sensorType;   // Sensor type hint for controller, see table above
@@ -25,14 +25,487 @@ bool _fwUpdateOngoing;
 unsigned long _fwLastRequestTime;
 uint16_t _fwBlock;
 uint8_t _fwRetry;
+// Blocks are fetched from the highest index down. Bit i set: block _fwBlock-1-i already received.
+uint16_t _fwReceived;
+// Number of blocks at the top of the window that have been requested
+uint8_t _fwRequested;
+// CRC of the image run backwards from the expected value over the blocks stored so far (they
+// arrive from the end of the image). Reaches the initial value ~0 if all blocks are intact.
+uint16_t _fwCrc;
+// Flash from here to the end of the image is erased (or being erased), sector aligned
+uint32_t _fwErased;
+// The background erase goes on down to here, see firmwareEraseAhead()
+uint32_t _fwEraseTarget;
+// Block that arrived while the flash was busy, stored from the onReady() callback
+ReplyFWBlock _fwPendingBlock;
+bool _fwPending;
+
+// Number of blocks of the image, without the flags
+static inline uint16_t firmwareBlockCount() {
+	return _fc.blocks & FIRMWARE_BLOCK_MASK;
+}
+
+// Flash address of a block, 32 bit so images above 32K work on large flash chips
+static inline uint32_t firmwareBlockAddress(uint16_t block) {
+	return ((uint32_t)block * FIRMWARE_BLOCK_SIZE) + FIRMWARE_START_OFFSET;
+}
+
+// Start erasing 4K sectors down to addr, for a block that is written right away. Each
+// erase waits for the previous flash command, the next flash command waits for the last one.
+static void firmwareEraseTo(uint32_t addr) {
+	if (_fwEraseTarget > addr) {
+		_fwEraseTarget = addr;
+	}
+	while (_fwErased > addr) {
+		_fwErased -= FIRMWARE_ERASE_SECTOR_SIZE;
+		_flash.blockErase4K(_fwErased);
+	}
+}
+
+// Start the next sector of the background erase if the flash is idle, called on every
+// firmwareOTAUpdateRequest() so erases never wait for each other or for a write.
+static void firmwareErasePoll() {
+	if (_fwErased > _fwEraseTarget && _flash.startBlockErase4K(_fwErased - FIRMWARE_ERASE_SECTOR_SIZE)) {
+		_fwErased -= FIRMWARE_ERASE_SECTOR_SIZE;
+	}
+}
+
+// Erase 4K sectors down to addr in the background, one at a time whenever the flash is idle
+static void firmwareEraseAhead(uint32_t addr) {
+	_fwEraseTarget = addr;
+	firmwareErasePoll();
+}
+
+#if defined(MY_OTA_COMPRESSION_FEATURE)
+/*
+ * Compressed images are fetched from block 0 up and decompressed into flash while they arrive.
+ * The stream starts with the size and crc16 of the decompressed image (2 bytes each, little
+ * endian) followed by tokens:
+ * 0x00-0x7F  n+1 literal bytes follow
+ * 0x80-0xBF  copy (n&0x3F)+3 bytes from the new image, 2 byte distance back follows
+ * 0xC0-0xFF  copy (n&0x3F)+3 bytes from the installed firmware (delta), 2 byte address follows
+ * The last block is padded with arbitrary bytes. _fc.crc is the crc16 of the whole stream.
+ */
+#define FW_SIZE_LOW 0
+#define FW_SIZE_HIGH 1
+#define FW_CRC_LOW 2
+#define FW_CRC_HIGH 3
+#define FW_TOKEN 4
+#define FW_LITERAL 5
+#define FW_OFFSET_LOW 6
+#define FW_OFFSET_HIGH 7
+#define FW_DONE 8
+
+bool _fwCompressed;
+uint8_t _fwState;
+uint8_t _fwCount; // literal bytes left or match length
+bool _fwFromInstalled;
+uint16_t _fwOffset; // match distance or address in installed firmware
+uint16_t _fwSize; // size of the decompressed image
+uint16_t _fwImageCrc; // expected crc16 of the decompressed image
+uint16_t _fwOutputCrc;
+uint16_t _fwOutput; // decompressed bytes so far
+uint8_t _fwOutBuffer[FIRMWARE_BLOCK_SIZE]; // last decompressed bytes, not yet in flash
+uint8_t _fwOutBuffered;
+
+static uint16_t firmwareCrcUpdate(uint16_t crc, uint8_t data) {
+	crc ^= data;
+	for (int8_t j = 0; j < 8; ++j) {
+		if (crc & 1)
+			crc = (crc >> 1) ^ 0xA001;
+		else
+			crc = (crc >> 1);
+	}
+	return crc;
+}
+
+// Start erasing 4K sectors up to addr (the decompressed image is written from the start)
+static void firmwareEraseUpTo(uint32_t addr) {
+	while (_fwErased < addr) {
+		_flash.blockErase4K(_fwErased);
+		_fwErased += FIRMWARE_ERASE_SECTOR_SIZE;
+	}
+}
+
+static void firmwareOutputFlush() {
+	if (_fwOutBuffered) {
+		uint32_t address = FIRMWARE_START_OFFSET + (uint32_t)_fwOutput - _fwOutBuffered;
+		// Keep the erase one sector ahead
+		firmwareEraseUpTo(address + _fwOutBuffered + FIRMWARE_ERASE_SECTOR_SIZE);
+		_flash.writeBytes(address, _fwOutBuffer, _fwOutBuffered);
+		_fwOutBuffered = 0;
+	}
+}
+
+static void firmwareOutput(uint8_t data) {
+	_fwOutBuffer[_fwOutBuffered++] = data;
+	_fwOutput++;
+	_fwOutputCrc = firmwareCrcUpdate(_fwOutputCrc, data);
+	if (_fwOutBuffered == FIRMWARE_BLOCK_SIZE || _fwOutput == _fwSize) {
+		firmwareOutputFlush();
+	}
+	if (_fwOutput == _fwSize) {
+		_fwState = FW_DONE;
+	}
+}
+
+static bool firmwareCopy() {
+	if (!_fwFromInstalled && (!_fwOffset || _fwOffset > _fwOutput)) {
+		// Points before the start of the image
+		return false;
+	}
+	for (uint8_t i = 0; i < _fwCount && _fwState != FW_DONE; i++) {
+		uint8_t data;
+		if (_fwFromInstalled) {
+			#if defined(ARDUINO_ARCH_AVR)
+				data = pgm_read_byte((uint16_t)(_fwOffset + i));
+			#else
+				// No delta images without access to the running firmware
+				return false;
+			#endif
+		} else {
+			// Byte by byte, so overlapping copies repeat a pattern
+			uint16_t position = _fwOutput - _fwOffset;
+			uint16_t flushed = _fwOutput - _fwOutBuffered;
+			data = position >= flushed ? _fwOutBuffer[position - flushed] : _flash.readByte(FIRMWARE_START_OFFSET + (uint32_t)position);
+		}
+		firmwareOutput(data);
+	}
+	return true;
+}
+
+static bool firmwareDecompress(const uint8_t *data, uint8_t length) {
+	for (uint8_t i = 0; i < length && _fwState != FW_DONE; i++) {
+		uint8_t b = data[i];
+		switch (_fwState) {
+			case FW_SIZE_LOW:
+				_fwSize = b;
+				_fwState = FW_SIZE_HIGH;
+				break;
+			case FW_SIZE_HIGH:
+				_fwSize |= (uint16_t)b << 8;
+				_fwState = FW_CRC_LOW;
+				break;
+			case FW_CRC_LOW:
+				_fwImageCrc = b;
+				_fwState = FW_CRC_HIGH;
+				break;
+			case FW_CRC_HIGH:
+				_fwImageCrc |= (uint16_t)b << 8;
+				_fwState = _fwSize ? FW_TOKEN : FW_DONE;
+				break;
+			case FW_TOKEN:
+				if (b < 0x80) {
+					_fwCount = b + 1;
+					_fwState = FW_LITERAL;
+				} else {
+					_fwCount = (b & 0x3F) + 3;
+					_fwFromInstalled = b & 0x40;
+					_fwState = FW_OFFSET_LOW;
+				}
+				break;
+			case FW_LITERAL:
+				firmwareOutput(b);
+				if (!--_fwCount && _fwState != FW_DONE) {
+					_fwState = FW_TOKEN;
+				}
+				break;
+			case FW_OFFSET_LOW:
+				_fwOffset = b;
+				_fwState = FW_OFFSET_HIGH;
+				break;
+			case FW_OFFSET_HIGH:
+				_fwOffset |= (uint16_t)b << 8;
+				if (!firmwareCopy()) {
+					return false;
+				}
+				if (_fwState != FW_DONE) {
+					_fwState = FW_TOKEN;
+				}
+				break;
+		}
+	}
+	return true;
+}
+
+static void firmwareCompressedStart() {
+	debug(PSTR("fw compressed\n"));
+	_fwBlock = firmwareBlockCount();
+	_fwCrc = ~0;
+	_fwErased = 0;
+	// erased upwards as the image is decompressed (firmwareEraseUpTo()), not in the background
+	_fwEraseTarget = ~0ul;
+	_fwState = FW_SIZE_LOW;
+	_fwOutput = 0;
+	_fwOutputCrc = ~0;
+	_fwOutBuffered = 0;
+}
+
+static void firmwareCompressedResponse(ReplyFWBlock *firmwareResponse) {
+	uint16_t total = firmwareBlockCount();
+	if (firmwareResponse->type != _fc.type || firmwareResponse->version != _fc.version ||
+		firmwareResponse->block != total - _fwBlock) {
+		debug(PSTR("fw block %d ignored\n"), firmwareResponse->block);
+		return;
+	}
+	debug(PSTR("fw block %d\n"), firmwareResponse->block);
+	for (uint8_t i = 0; i < FIRMWARE_BLOCK_SIZE; i++) {
+		_fwCrc = firmwareCrcUpdate(_fwCrc, firmwareResponse->data[i]);
+	}
+	_fwRequested = 0;
+	if (!firmwareDecompress(firmwareResponse->data, FIRMWARE_BLOCK_SIZE) || (--_fwBlock && _fwState == FW_DONE)) {
+		debug(PSTR("fw decompress fail\n"));
+		_fwUpdateOngoing = false;
+		ledBlinkErr(1);
+		return;
+	}
+	if (!_fwBlock) {
+		_fwUpdateOngoing = false;
+		if (transportIsValidFirmware()) {
+			debug(PSTR("fw checksum ok\n"));
+			uint8_t OTAbuffer[10] = {'F','L','X','I','M','G',':',(uint8_t)(_fwOutput >> 8),(uint8_t)(_fwOutput & 0xff),':'};
+			_flash.writeBytes(0, OTAbuffer, 10);
+			hwWriteConfigBlock((void*)&_fc, (void*)EEPROM_FIRMWARE_TYPE_ADDRESS, sizeof(NodeFirmwareConfig));
+			hwReboot();
+		} else {
+			debug(PSTR("fw checksum fail\n"));
+		}
+	}
+}
+#endif
+
+#if MY_OTA_WINDOW_SIZE < 1 || MY_OTA_WINDOW_SIZE > 16
+	#error MY_OTA_WINDOW_SIZE must be between 1 and 16
+#endif
 
 inline void readFirmwareSettings() {
 	hwReadConfigBlock((void*)&_fc, (void*)EEPROM_FIRMWARE_TYPE_ADDRESS, sizeof(NodeFirmwareConfig));
 }
 
+static void firmwareSaveResumeState() {
+	FirmwareResumeState state;
+	memcpy(&state.config, &_fc, sizeof(NodeFirmwareConfig));
+	state.blocks = _fwBlock;
+	state.crc = _fwCrc;
+	hwWriteConfigBlock((void*)&state, (void*)EEPROM_FIRMWARE_RESUME_ADDRESS, sizeof(FirmwareResumeState));
+}
+
+// Undo the crc16 of one block, reading it back from flash checks what was actually stored
+static void firmwareCrcBlock(uint16_t block) {
+	uint8_t data[FIRMWARE_BLOCK_SIZE];
+	_flash.readBytes(firmwareBlockAddress(block), data, FIRMWARE_BLOCK_SIZE);
+	for (int8_t i = FIRMWARE_BLOCK_SIZE - 1; i >= 0; i--) {
+		for (int8_t j = 0; j < 8; ++j) {
+			if (_fwCrc & 0x8000)
+				_fwCrc = ((_fwCrc ^ 0xA001) << 1) | 1;
+			else
+				_fwCrc = (_fwCrc << 1);
+		}
+		_fwCrc ^= data[i];
+	}
+}
+
+static void firmwareFinish() {
+	// We're finished! Do a checksum and reboot.
+	_fwUpdateOngoing = false;
+	// Nothing left to resume, a failed image has to be downloaded again
+	firmwareSaveResumeState();
+	if (transportIsValidFirmware()) {
+		debug(PSTR("fw checksum ok\n"));
+		// All seems ok, write size and signature to flash (DualOptiboot will pick this up and flash it)
+		uint16_t fwsize = FIRMWARE_BLOCK_SIZE * firmwareBlockCount();
+		uint8_t OTAbuffer[10] = {'F','L','X','I','M','G',':',(uint8_t)(fwsize >> 8),(uint8_t)(fwsize & 0xff),':'};
+		_flash.writeBytes(0, OTAbuffer, 10);
+		// Write the new firmware config to eeprom
+		hwWriteConfigBlock((void*)&_fc, (void*)EEPROM_FIRMWARE_TYPE_ADDRESS, sizeof(NodeFirmwareConfig));
+		hwReboot();
+	} else {
+		debug(PSTR("fw checksum fail\n"));
+	}
+}
+
+#if defined(MY_OTA_BROADCAST_FEATURE)
+/*
+ * The controller sends the firmware config to each node of a broadcast session (unicast, so it
+ * can be signed) and then every block once to BROADCAST_ADDRESS, in any order. A bitmap in the
+ * sector behind the image records the blocks stored so far (bit clear = received, so marking a
+ * block is just programming a byte of the erased sector). When the stream has been silent for
+ * MY_OTA_BROADCAST_TIMEOUT the missing blocks are requested from the controller as usual, from
+ * block 0 up with _fwBlock as the first block that may still be missing.
+ */
+#define FW_BROADCAST_OFF 0
+#define FW_BROADCAST_STREAM 1
+#define FW_BROADCAST_REPAIR 2
+
+uint8_t _fwBroadcast;
+uint32_t _fwMap; // flash address of the bitmap
+
+static bool firmwareBroadcastHave(uint16_t block) {
+	return !(_flash.readByte(_fwMap + block / 8) & (1 << (block % 8)));
+}
+
+static void firmwareBroadcastStart() {
+	debug(PSTR("fw broadcast\n"));
+	_fwBroadcast = FW_BROADCAST_STREAM;
+	_fwMap = (firmwareBlockAddress(firmwareBlockCount()) + FIRMWARE_ERASE_SECTOR_SIZE - 1) & ~(FIRMWARE_ERASE_SECTOR_SIZE - 1ul);
+	// Blocks may come in any order, so the bitmap and the image are erased right away, from
+	// the top down in the background. Blocks arriving for a sector that is not erased yet are
+	// lost and requested in the repair phase, which only starts once the erase is done.
+	_fwErased = _fwMap + FIRMWARE_ERASE_SECTOR_SIZE;
+	firmwareEraseAhead(0);
+	_fwBlock = 0;
+	// Broadcast sessions are not resumed, make sure an older resume state is not used either
+	firmwareSaveResumeState();
+}
+
+static void firmwareBroadcastStore(ReplyFWBlock *firmwareResponse) {
+	uint16_t block = firmwareResponse->block;
+	if (firmwareResponse->type != _fc.type || firmwareResponse->version != _fc.version ||
+		block >= firmwareBlockCount() || firmwareBlockAddress(block) < _fwErased ||
+		firmwareBroadcastHave(block)) {
+		debug(PSTR("fw block %d ignored\n"), block);
+		return;
+	}
+	debug(PSTR("fw block %d\n"), block);
+	_flash.writeBytes(firmwareBlockAddress(block), firmwareResponse->data, FIRMWARE_BLOCK_SIZE);
+	_flash.writeByte(_fwMap + block / 8, ~(1 << (block % 8)));
+	if (_fwRequested) {
+		_fwRequested--;
+	}
+	// Silence (streaming) or a timeout (repair) is measured from the last block
+	_fwRetry = MY_OTA_RETRY+1;
+	_fwLastRequestTime = hwMillis();
+}
+
+static void firmwareBroadcastRequest() {
+	unsigned long enter = hwMillis();
+	if (_fwBroadcast == FW_BROADCAST_STREAM) {
+		if (enter - _fwLastRequestTime < MY_OTA_BROADCAST_TIMEOUT) {
+			return;
+		}
+		debug(PSTR("fw repair\n"));
+		_fwBroadcast = FW_BROADCAST_REPAIR;
+		_fwRequested = 0;
+	} else if (enter - _fwLastRequestTime > MY_OTA_RETRY_DELAY) {
+		if (!_fwRetry) {
+			debug(PSTR("fw upd fail\n"));
+			_fwUpdateOngoing = false;
+			ledBlinkErr(1);
+			return;
+		}
+		_fwRetry--;
+		_fwRequested = 0;
+	} else if (_fwRequested) {
+		// Wait for the requests of this round
+		return;
+	}
+	_fwLastRequestTime = enter;
+	uint16_t blocks = firmwareBlockCount();
+	while (_fwBlock < blocks && firmwareBroadcastHave(_fwBlock)) {
+		_fwBlock++;
+	}
+	if (_fwBlock == blocks) {
+		// Complete, the crc is run backwards from the last block as for unicast downloads
+		_fwCrc = _fc.crc;
+		while (_fwBlock) {
+			firmwareCrcBlock(--_fwBlock);
+		}
+		firmwareFinish();
+		return;
+	}
+	for (uint16_t block = _fwBlock; block < blocks && _fwRequested < MY_OTA_WINDOW_SIZE; block++) {
+		if (!firmwareBroadcastHave(block)) {
+			RequestFWBlock firmwareRequest;
+			firmwareRequest.type = _fc.type;
+			firmwareRequest.version = _fc.version;
+			firmwareRequest.block = block;
+			debug(PSTR("req FW: T=%02X, V=%02X, B=%04X\n"),_fc.type,_fc.version,block);
+			_sendRoute(build(_msgTmp, _nc.nodeId, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_STREAM, ST_FIRMWARE_REQUEST, false).set(&firmwareRequest,sizeof(RequestFWBlock)));
+			_fwRequested++;
+		}
+	}
+}
+#endif
+
+static void firmwareStoreBlock(ReplyFWBlock *firmwareResponse) {
+	#if defined(MY_OTA_COMPRESSION_FEATURE)
+		if (_fwCompressed) {
+			firmwareCompressedResponse(firmwareResponse);
+			_fwRetry = MY_OTA_RETRY+1;
+			_fwLastRequestTime = hwMillis();
+			return;
+		}
+	#endif
+	#if defined(MY_OTA_BROADCAST_FEATURE)
+		if (_fwBroadcast) {
+			firmwareBroadcastStore(firmwareResponse);
+			return;
+		}
+	#endif
+	uint16_t block = firmwareResponse->block;
+	if (firmwareResponse->type != _fc.type || firmwareResponse->version != _fc.version ||
+		block >= _fwBlock || _fwBlock - 1 - block >= MY_OTA_WINDOW_SIZE ||
+		(_fwReceived & (1 << (_fwBlock - 1 - block)))) {
+		// Duplicate or outside of window (late reply to an earlier request)
+		debug(PSTR("fw block %d ignored\n"), block);
+		return;
+	}
+	// Save block to flash
+	debug(PSTR("fw block %d\n"), block);
+	// write to flash, programming continues while we receive
+	uint32_t address = firmwareBlockAddress(block);
+	firmwareEraseTo(address);
+	_flash.writeBytes(address, firmwareResponse->data, FIRMWARE_BLOCK_SIZE);
+	_fwReceived |= 1 << (_fwBlock - 1 - block);
+	// Slide the window over all blocks received in order
+	while (_fwBlock && (_fwReceived & 1)) {
+		_fwReceived >>= 1;
+		_fwBlock--;
+		if (_fwRequested) {
+			_fwRequested--;
+		}
+		firmwareCrcBlock(_fwBlock);
+		if (_fwBlock && !(_fwBlock % FIRMWARE_RESUME_INTERVAL)) {
+			firmwareSaveResumeState();
+		}
+	}
+	// Keep the erase one sector ahead of the blocks coming in. It starts once the write is
+	// done, new requests are held back until it is (see firmwareOTAUpdateRequest()).
+	firmwareEraseAhead(address > FIRMWARE_ERASE_SECTOR_SIZE ? address - FIRMWARE_ERASE_SECTOR_SIZE : 0);
+	if (!_fwBlock) {
+		firmwareFinish();
+	}
+	// reset flags, new slots of the window are requested right away
+	_fwRetry = MY_OTA_RETRY+1;
+	_fwLastRequestTime = hwMillis();
+}
+
+// onReady() callback for a block that arrived while the flash was busy
+static void firmwareStorePending() {
+	_fwPending = false;
+	if (_fwUpdateOngoing) {
+		firmwareStoreBlock(&_fwPendingBlock);
+	}
+}
+
 inline void firmwareOTAUpdateRequest() {
+	if (!_fwUpdateOngoing) {
+		return;
+	}
+	_flash.poll();
+	firmwareErasePoll();
+	if (_flash.busy()) {
+		// Erasing, replies would only pile up
+		return;
+	}
+	#if defined(MY_OTA_BROADCAST_FEATURE)
+		if (_fwBroadcast) {
+			firmwareBroadcastRequest();
+			return;
+		}
+	#endif
 	unsigned long enter = hwMillis();
-	if (_fwUpdateOngoing && (enter - _fwLastRequestTime > MY_OTA_RETRY_DELAY)) {
+	if (enter - _fwLastRequestTime > MY_OTA_RETRY_DELAY) {
 		if (!_fwRetry) {
 			debug(PSTR("fw upd fail\n"));
 			// Give up. We have requested MY_OTA_RETRY times without any packet in return.
@@ -42,13 +515,33 @@ inline void firmwareOTAUpdateRequest() {
 		}
 		_fwRetry--;
 		_fwLastRequestTime = enter;
-		// Time to (re-)request firmware block from controller
-		RequestFWBlock firmwareRequest;
-		firmwareRequest.type = _fc.type;
-		firmwareRequest.version = _fc.version;
-		firmwareRequest.block = (_fwBlock - 1);
-		debug(PSTR("req FW: T=%02X, V=%02X, B=%04X\n"),_fc.type,_fc.version,_fwBlock - 1);
-		_sendRoute(build(_msgTmp, _nc.nodeId, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_STREAM, ST_FIRMWARE_REQUEST, false).set(&firmwareRequest,sizeof(RequestFWBlock)));
+		// Re-request everything missing in the window
+		_fwRequested = 0;
+	}
+	// Keep up to MY_OTA_WINDOW_SIZE block requests outstanding
+	uint8_t window = min(MY_OTA_WINDOW_SIZE, _fwBlock);
+	#if defined(MY_OTA_COMPRESSION_FEATURE)
+		if (_fwCompressed) {
+			// The decompressor needs the blocks in order
+			window = 1;
+		}
+	#endif
+	while (_fwRequested < window) {
+		if (!(_fwReceived & (1 << _fwRequested))) {
+			// Time to (re-)request firmware block from controller
+			RequestFWBlock firmwareRequest;
+			firmwareRequest.type = _fc.type;
+			firmwareRequest.version = _fc.version;
+			firmwareRequest.block = (_fwBlock - 1 - _fwRequested);
+			#if defined(MY_OTA_COMPRESSION_FEATURE)
+				if (_fwCompressed) {
+					firmwareRequest.block = firmwareBlockCount() - _fwBlock;
+				}
+			#endif
+			debug(PSTR("req FW: T=%02X, V=%02X, B=%04X\n"),_fc.type,_fc.version,firmwareRequest.block);
+			_sendRoute(build(_msgTmp, _nc.nodeId, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_STREAM, ST_FIRMWARE_REQUEST, false).set(&firmwareRequest,sizeof(RequestFWBlock)));
+		}
+		_fwRequested++;
 	}
 }
 
@@ -65,49 +558,78 @@ inline bool firmwareOTAUpdateProcess() {
 				debug(PSTR("flash init fail\n"));
 				_fwUpdateOngoing = false;
 			} else {
-				// erase lower 32K -> max flash size for ATMEGA328
-				_flash.blockErase32K(0);
-				// wait until flash erased
-				while ( _flash.busy() );
-				_fwBlock = _fc.blocks;
+				#if defined(MY_OTA_COMPRESSION_FEATURE)
+					_fwCompressed = _fc.blocks & FIRMWARE_COMPRESSED;
+				#endif
+				FirmwareResumeState state;
+				hwReadConfigBlock((void*)&state, (void*)EEPROM_FIRMWARE_RESUME_ADDRESS, sizeof(FirmwareResumeState));
+				#if defined(MY_OTA_BROADCAST_FEATURE)
+					_fwBroadcast = FW_BROADCAST_OFF;
+				#endif
+				#if defined(MY_OTA_COMPRESSION_FEATURE)
+				if (_fwCompressed) {
+					// Compressed downloads always start from the beginning
+					firmwareCompressedStart();
+				} else
+				#endif
+				#if defined(MY_OTA_BROADCAST_FEATURE)
+				if (_fc.blocks & FIRMWARE_BROADCAST) {
+					firmwareBroadcastStart();
+				} else
+				#endif
+				if (!memcmp(&state.config, &_fc, sizeof(NodeFirmwareConfig)) && state.blocks && state.blocks <= firmwareBlockCount()) {
+					// Same image as the interrupted download, continue after the last saved block
+					debug(PSTR("fw resume %d\n"), state.blocks);
+					_fwBlock = state.blocks;
+					_fwCrc = state.crc;
+					// The sector holding the last saved block was erased before, blocks written
+					// to it since are simply programmed again with the same data
+					_fwErased = firmwareBlockAddress(_fwBlock) & ~(FIRMWARE_ERASE_SECTOR_SIZE - 1ul);
+					_fwEraseTarget = _fwErased;
+				} else {
+					// Erase lazily, starting with the sector of the first (highest) block. The
+					// first request goes out while the erase is running.
+					_fwBlock = firmwareBlockCount();
+					_fwCrc = _fc.crc;
+					_fwErased = (firmwareBlockAddress(_fwBlock) + FIRMWARE_ERASE_SECTOR_SIZE - 1) & ~(FIRMWARE_ERASE_SECTOR_SIZE - 1ul);
+					firmwareEraseAhead(firmwareBlockAddress(_fwBlock - 1));
+					// Flash no longer holds what an older resume state describes
+					firmwareSaveResumeState();
+				}
+				_fwReceived = 0;
+				_fwRequested = 0;
+				_fwPending = false;
+				_flash.onReady(NULL);
 				_fwUpdateOngoing = true;
 				// reset flags
 				_fwRetry = MY_OTA_RETRY+1;
 				_fwLastRequestTime = 0;
+				#if defined(MY_OTA_BROADCAST_FEATURE)
+					if (_fwBroadcast) {
+						// Give the stream MY_OTA_BROADCAST_TIMEOUT to start
+						_fwLastRequestTime = hwMillis();
+					}
+				#endif
 			}
 			return true;
 		}
 		debug(PSTR("fw update skipped\n"));
 	} else if (_msg.type == ST_FIRMWARE_RESPONSE) {
 		if (_fwUpdateOngoing) {
-			// Save block to flash
-			debug(PSTR("fw block %d\n"), _fwBlock);
 			// extract FW block
 			ReplyFWBlock *firmwareResponse = (ReplyFWBlock *)_msg.data;
-			// write to flash
-			_flash.writeBytes( ((_fwBlock - 1) * FIRMWARE_BLOCK_SIZE) + FIRMWARE_START_OFFSET, firmwareResponse->data, FIRMWARE_BLOCK_SIZE);
-			// wait until flash written
-			while ( _flash.busy() );
-			_fwBlock--;
-			if (!_fwBlock) {
-				// We're finished! Do a checksum and reboot.
-				_fwUpdateOngoing = false;
-				if (transportIsValidFirmware()) {
-					debug(PSTR("fw checksum ok\n"));
-					// All seems ok, write size and signature to flash (DualOptiboot will pick this up and flash it)
-					uint16_t fwsize = FIRMWARE_BLOCK_SIZE * _fc.blocks;
-					uint8_t OTAbuffer[10] = {'F','L','X','I','M','G',':',(uint8_t)(fwsize >> 8),(uint8_t)(fwsize & 0xff),':'};
-					_flash.writeBytes(0, OTAbuffer, 10);
-					// Write the new firmware config to eeprom
-					hwWriteConfigBlock((void*)&_fc, (void*)EEPROM_FIRMWARE_TYPE_ADDRESS, sizeof(NodeFirmwareConfig));
-					hwReboot();
+			if (_flash.busy()) {
+				// Keep one block until the flash is done, later ones are requested again
+				if (!_fwPending) {
+					memcpy(&_fwPendingBlock, firmwareResponse, sizeof(ReplyFWBlock));
+					_fwPending = true;
+					_flash.onReady(firmwareStorePending);
 				} else {
-					debug(PSTR("fw checksum fail\n"));
+					debug(PSTR("fw block %d dropped\n"), firmwareResponse->block);
 				}
+				return true;
 			}
-			// reset flags
-			_fwRetry = MY_OTA_RETRY+1;
-			_fwLastRequestTime = 0;
+			firmwareStoreBlock(firmwareResponse);
 		} else {
 			debug(PSTR("No fw update ongoing\n"));
 		}
@@ -128,18 +650,13 @@ inline void presentBootloaderInformation(){
 	_fwUpdateOngoing = false;
 	_sendRoute(build(_msgTmp, _nc.nodeId, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_STREAM, ST_FIRMWARE_CONFIG_REQUEST, false));	
 }
-// do a crc16 on the whole received firmware
+// crc16 of the received firmware, built up block by block
 inline bool transportIsValidFirmware() {
-	// init crc
-	uint16_t crc = ~0;
-	for (uint16_t i = 0; i < _fc.blocks * FIRMWARE_BLOCK_SIZE; ++i) {
-		crc ^= _flash.readByte(i + FIRMWARE_START_OFFSET);
-	    for (int8_t j = 0; j < 8; ++j) {
-	        if (crc & 1)
-	            crc = (crc >> 1) ^ 0xA001;
-	        else
-	            crc = (crc >> 1);
-	    }
-	}
-	return crc == _fc.crc;
+	#if defined(MY_OTA_COMPRESSION_FEATURE)
+		if (_fwCompressed) {
+			// crc of the stream as sent and of the image it decompressed to
+			return !_fwBlock && _fwCrc == _fc.crc && _fwState == FW_DONE && _fwOutputCrc == _fwImageCrc;
+		}
+	#endif
+	return !_fwBlock && _fwCrc == (uint16_t)~0;
 }
@@ -32,6 +32,16 @@
 #define MY_OTA_RETRY_DELAY 500
 // Start offset for firmware in flash (DualOptiboot wants to keeps a signature first)
 #define FIRMWARE_START_OFFSET 10
+// Flash is erased in sectors of this size while the image comes in
+#define FIRMWARE_ERASE_SECTOR_SIZE 4096ul
+// Set in NodeFirmwareConfig.blocks by the controller for a compressed image (MY_OTA_COMPRESSION_FEATURE)
+#define FIRMWARE_COMPRESSED 0x8000
+// Set in NodeFirmwareConfig.blocks by the controller when it streams the blocks to BROADCAST_ADDRESS (MY_OTA_BROADCAST_FEATURE)
+#define FIRMWARE_BROADCAST 0x4000
+// Bits of NodeFirmwareConfig.blocks holding the number of blocks
+#define FIRMWARE_BLOCK_MASK 0x3FFF
+// Save download progress every this many blocks (one flash page)
+#define FIRMWARE_RESUME_INTERVAL 16
 // Bootloader version
 #define MY_OTA_BOOTLOADER_MAJOR_VERSION 3
 #define MY_OTA_BOOTLOADER_MINOR_VERSION 0
@@ -46,6 +56,13 @@ typedef struct {
 	uint16_t crc; //!< CRC of block data
 } __attribute__((packed)) NodeFirmwareConfig;
 
+/// @brief Progress of a FW download, stored in eeprom to resume after a reset
+typedef struct {
+	NodeFirmwareConfig config; //!< Config of the FW being downloaded
+	uint16_t blocks; //!< Number of blocks still missing (0 = nothing to resume)
+	uint16_t crc; //!< CRC state after the blocks received so far
+} __attribute__((packed)) FirmwareResumeState;
+
 /// @brief FW config request structure
 typedef struct {
 	uint16_t type; //!< Type of config
@@ -90,7 +107,8 @@ bool firmwareOTAUpdateProcess();
 /**
  * @brief Validate uploaded FW CRC
  *
- * This function verifies if uploaded FW CRC is valid
+ * This function verifies if uploaded FW CRC is valid. The CRC is computed while the blocks
+ * arrive, no need to read the image again.
  */
 bool transportIsValidFirmware();
 /**
@@ -23,12 +23,54 @@
 #include "MySensorCore.h"
 
 
+#if defined(MY_GATEWAY_BINARY_PROTOCOL)
+// State of the incremental frame decoder (MyProtocolBinary.cpp)
+typedef struct {
+	uint8_t length;  // Number of bytes decoded so far
+	uint8_t block;   // Data bytes left in the current COBS block
+	bool zero;       // Current block is followed by a zero byte
+	uint8_t tail[2]; // Last two decoded bytes, the crc once the frame ends
+	uint16_t crc;    // crc16 of the bytes before tail
+} ProtocolParser;
+
+// Completes a message received as raw bytes (length bytes of header and payload already in
+// message), returns true if the header matches length
+bool protocolRawEnd(MyMessage &message, uint8_t length);
+#else
+// State of the incremental protocol parser
+typedef struct {
+	uint8_t field;   // Index of the field currently parsed
+	uint8_t value;   // Accumulated value of numeric field
+	uint8_t length;  // Number of payload bytes received
+	uint8_t ack;     // Received ack request flag
+	bool nibble;     // Low nibble of a hex encoded stream byte is expected next
+} ProtocolParser;
+#endif
+
+// Prepare parser for a new message
+void protocolParserReset(ProtocolParser &parser);
+
+// Feed one received character into the parser, message fields are filled in place.
+// Returns true when a newline (a zero in binary mode) completed a valid message.
+bool protocolParseChar(ProtocolParser &parser, MyMessage &message, char c);
+
+// Complete the message currently parsed (e.g. at end of a packet without terminator)
+// returns true if a valid message was parsed
+bool protocolParseEnd(ProtocolParser &parser, MyMessage &message);
+
 // parse(message, inputString)
 // parse a string into a message element
 // returns true if successfully parsed the input string
 bool protocolParse(MyMessage &message, char *inputString);
 
+uint8_t protocolH2i(char c);
+
 // Format MyMessage to the protocol represenataion
-char *protocolFormat(MyMessage &message);
+// (optionally returns the length of the formatted string in length)
+char *protocolFormat(MyMessage &message, size_t *length = NULL);
+
+// Write MyMessage in protocol representation directly to a stream without
+// intermediate buffer, returns the number of bytes written
+size_t protocolFormat(MyMessage &message, Print &out);
 
 #endif
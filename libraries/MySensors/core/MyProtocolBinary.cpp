@@ -0,0 +1,179 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2015 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Binary gateway protocol (MY_GATEWAY_BINARY_PROTOCOL)
+//
+// A frame carries the message as it goes over the air (header and payload) followed by a
+// crc16 (little endian) of these bytes. The frame is COBS encoded, so it contains no zero
+// bytes, and ends with a zero. A receiver that starts in the middle of a frame or sees a
+// corrupted one drops it and picks up at the next zero.
+
+#include "MyConfig.h"
+#include "MyTransport.h"
+#include "MyProtocol.h"
+
+char _fmtBuffer[MY_GATEWAY_MAX_SEND_LENGTH];
+char _convBuffer[MAX_PAYLOAD*2+1];
+
+#define PROTOCOL_FRAME_LENGTH (HEADER_SIZE + MAX_PAYLOAD + 2) // message and crc, before encoding
+
+static uint16_t protocolCrcUpdate(uint16_t crc, uint8_t data) {
+	crc ^= data;
+	for (int8_t j = 0; j < 8; ++j) {
+		if (crc & 1)
+			crc = (crc >> 1) ^ 0xA001;
+		else
+			crc = (crc >> 1);
+	}
+	return crc;
+}
+
+void protocolParserReset(ProtocolParser &parser) {
+	parser.length = 0;
+	parser.block = 0;
+	parser.zero = false;
+	parser.crc = 0xFFFF;
+}
+
+bool protocolRawEnd(MyMessage &message, uint8_t length) {
+	// The payload length in the header has to match what was received
+	if (length < HEADER_SIZE || length - HEADER_SIZE != mGetLength(message)) {
+		return false;
+	}
+	message.sender = GATEWAY_ADDRESS;
+	message.last = GATEWAY_ADDRESS;
+	mSetVersion(message, PROTOCOL_VERSION);
+	mSetAck(message, false);
+	message.data[mGetLength(message)] = 0;
+	return true;
+}
+
+bool protocolParseEnd(ProtocolParser &parser, MyMessage &message) {
+	// The last two decoded bytes are the crc, the ones before were written to message
+	bool ok = parser.block == 0 && parser.length >= HEADER_SIZE + 2 && parser.length <= PROTOCOL_FRAME_LENGTH &&
+		parser.crc == (parser.tail[0] | (uint16_t)parser.tail[1] << 8) &&
+		protocolRawEnd(message, parser.length - 2);
+	protocolParserReset(parser);
+	return ok;
+}
+
+// Next decoded byte of the frame, it goes to the message once it is known not to be part of the crc
+static void protocolParseByte(ProtocolParser &parser, MyMessage &message, uint8_t c) {
+	if (parser.length >= 2) {
+		uint8_t i = parser.length - 2;
+		if (i < HEADER_SIZE + MAX_PAYLOAD) {
+			((uint8_t *)&message)[i] = parser.tail[0];
+		}
+		parser.crc = protocolCrcUpdate(parser.crc, parser.tail[0]);
+		parser.tail[0] = parser.tail[1];
+		parser.tail[1] = c;
+	} else {
+		parser.tail[parser.length] = c;
+	}
+	if (parser.length < 255) {
+		parser.length++;
+	}
+}
+
+bool protocolParseChar(ProtocolParser &parser, MyMessage &message, char c) {
+	uint8_t b = c;
+	if (b == 0) {
+		return protocolParseEnd(parser, message);
+	}
+	if (parser.block == 0) {
+		// COBS code byte: a zero ends the previous block (unless it was a full one), then b-1 data bytes
+		if (parser.zero) {
+			protocolParseByte(parser, message, 0);
+		}
+		parser.block = b - 1;
+		parser.zero = b != 0xFF;
+	} else {
+		protocolParseByte(parser, message, b);
+		parser.block--;
+	}
+	return false;
+}
+
+bool protocolParse(MyMessage &message, char *inputString) {
+	// Encoded frames contain no zero, so the string ends where the frame does
+	ProtocolParser parser;
+	protocolParserReset(parser);
+	while (*inputString) {
+		if (protocolParseChar(parser, message, *inputString++)) {
+			return true;
+		}
+	}
+	return protocolParseEnd(parser, message);
+}
+
+// Print sink filling a char buffer (always null terminated)
+class ProtocolBufferPrint : public Print {
+public:
+	ProtocolBufferPrint(char *buffer, size_t size) : _buffer(buffer), _size(size), _length(0) {
+		_buffer[0] = 0;
+	}
+	virtual size_t write(uint8_t c) {
+		if (_length >= _size - 1) {
+			return 0;
+		}
+		_buffer[_length++] = c;
+		_buffer[_length] = 0;
+		return 1;
+	}
+	size_t length() const {
+		return _length;
+	}
+private:
+	char *_buffer;
+	size_t _size;
+	size_t _length;
+};
+
+size_t protocolFormat(MyMessage &message, Print &out) {
+	uint8_t frame[PROTOCOL_FRAME_LENGTH];
+	uint8_t length = HEADER_SIZE + mGetLength(message);
+	memcpy(frame, &message, length);
+	uint16_t crc = 0xFFFF;
+	for (uint8_t i = 0; i < length; i++) {
+		crc = protocolCrcUpdate(crc, frame[i]);
+	}
+	frame[length++] = crc;
+	frame[length++] = crc >> 8;
+	// A frame is shorter than 254 bytes, so every block but the last ends with a zero
+	size_t n = 0;
+	uint8_t start = 0;
+	while (start <= length) {
+		uint8_t end = start;
+		while (end < length && frame[end]) end++;
+		n += out.write((uint8_t)(end - start + 1));
+		n += out.write(frame + start, end - start);
+		start = end + 1;
+	}
+	n += out.write((uint8_t)0);
+	return n;
+}
+
+char * protocolFormat(MyMessage &message, size_t *length) {
+	ProtocolBufferPrint out(_fmtBuffer, MY_GATEWAY_MAX_SEND_LENGTH);
+	(void)protocolFormat(message, out);
+	if (length != NULL) {
+		*length = out.length();
+	}
+	return _fmtBuffer;
+}
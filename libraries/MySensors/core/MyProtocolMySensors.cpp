@@ -21,82 +21,165 @@
 #include "MyTransport.h"
 #include "MyProtocol.h"
 
-uint8_t protocolH2i(char c);
-
 char _fmtBuffer[MY_GATEWAY_MAX_SEND_LENGTH];
 char _convBuffer[MAX_PAYLOAD*2+1];
 
-bool protocolParse(MyMessage &message, char *inputString) {
-	char *str, *p, *value=NULL;
-	uint8_t bvalue[MAX_PAYLOAD];
-	uint8_t blen = 0;
-	int i = 0;
-	uint8_t command = 0;
-	uint8_t ack = 0;
+void protocolParserReset(ProtocolParser &parser) {
+	parser.field = 0;
+	parser.value = 0;
+	parser.length = 0;
+	parser.ack = 0;
+	parser.nibble = false;
+}
 
-	// Extract command data coming on serial line
-	for (str = strtok_r(inputString, ";", &p); // split using semicolon
-		str && i < 6; // loop while str is not null an max 5 times
-		str = strtok_r(NULL, ";", &p) // get subsequent tokens
-			) {
-		switch (i) {
-			case 0: // Radioid (destination)
-				message.destination = atoi(str);
-				break;
-			case 1: // Childid
-				message.sensor = atoi(str);
-				break;
-			case 2: // Message type
-				command = atoi(str);
-				mSetCommand(message, command);
-				break;
-			case 3: // Should we request ack from destination?
-				ack = atoi(str);
-				break;
-			case 4: // Data type
-				message.type = atoi(str);
-				break;
-			case 5: // Variable value
-				if (command == C_STREAM) {
-					blen = 0;
-					uint8_t val;
-					while (*str) {
-						val = protocolH2i(*str++) << 4;
-						val += protocolH2i(*str++);
-						bvalue[blen] = val;
-						blen++;
-					}
+// Store accumulated value of the numeric header field currently parsed
+static void protocolParserCommitField(ProtocolParser &parser, MyMessage &message) {
+	switch (parser.field) {
+		case 0: // Radioid (destination)
+			message.destination = parser.value;
+			break;
+		case 1: // Childid
+			message.sensor = parser.value;
+			break;
+		case 2: // Message type
+			mSetCommand(message, parser.value);
+			break;
+		case 3: // Should we request ack from destination?
+			parser.ack = parser.value;
+			break;
+		case 4: // Data type
+			message.type = parser.value;
+			break;
+	}
+	parser.value = 0;
+}
+
+bool protocolParseEnd(ProtocolParser &parser, MyMessage &message) {
+	if (parser.field <= 4) {
+		protocolParserCommitField(parser, message);
+	}
+	// Check for invalid input (less than 5 fields)
+	bool ok = parser.field >= 4;
+	if (ok) {
+		message.sender = GATEWAY_ADDRESS;
+		message.last = GATEWAY_ADDRESS;
+		mSetRequestAck(message, parser.ack?1:0);
+		mSetAck(message, false);
+		mSetLength(message, parser.length);
+		mSetPayloadType(message, mGetCommand(message) == C_STREAM ? P_CUSTOM : P_STRING);
+		message.data[parser.length] = 0;
+	}
+	protocolParserReset(parser);
+	return ok;
+}
+
+bool protocolParseChar(ProtocolParser &parser, MyMessage &message, char c) {
+	if (c == '\n') {
+		return protocolParseEnd(parser, message);
+	}
+	if (c == '\r') {
+		// Carriage return is never part of a message
+		return false;
+	}
+	if (parser.field < 5) {
+		// Numeric header fields
+		if (c == ';') {
+			protocolParserCommitField(parser, message);
+			parser.field++;
+		} else if (c >= '0' && c <= '9') {
+			parser.value = parser.value * 10 + (c - '0');
+		}
+	} else if (parser.field == 5) {
+		// Variable value
+		if (c == ';') {
+			// Anything after an additional separator is ignored
+			parser.field++;
+		} else if (mGetCommand(message) == C_STREAM) {
+			if (parser.length < MAX_PAYLOAD) {
+				if (!parser.nibble) {
+					message.data[parser.length] = protocolH2i(c) << 4;
 				} else {
-					value = str;
-					// Remove trailing carriage return and newline character (if it exists)
-					uint8_t lastCharacter = strlen(value)-1;
-					if (value[lastCharacter] == '\r')
-						value[lastCharacter] = 0;
-					if (value[lastCharacter] == '\n')
-						value[lastCharacter] = 0;
+					message.data[parser.length++] += protocolH2i(c);
 				}
-				break;
+				parser.nibble = !parser.nibble;
+			}
+		} else if (parser.length < MAX_PAYLOAD) {
+			message.data[parser.length++] = c;
 		}
-		i++;
 	}
-	//debug(PSTR("Received %d"), i);
-	// Check for invalid input
-	if (i < 5)
-		return false;
+	return false;
+}
 
-	message.sender = GATEWAY_ADDRESS;
-	message.last = GATEWAY_ADDRESS;
-    mSetRequestAck(message, ack?1:0);
-    mSetAck(message, false);
-	if (command == C_STREAM)
-		message.set(bvalue, blen);
-	else
-		message.set(value);
-	return true;
+bool protocolParse(MyMessage &message, char *inputString) {
+	ProtocolParser parser;
+	protocolParserReset(parser);
+	while (*inputString) {
+		if (protocolParseChar(parser, message, *inputString++)) {
+			return true;
+		}
+	}
+	return protocolParseEnd(parser, message);
+}
+
+// Print sink filling a char buffer (always null terminated)
+class ProtocolBufferPrint : public Print {
+public:
+	ProtocolBufferPrint(char *buffer, size_t size) : _buffer(buffer), _size(size), _length(0) {
+		_buffer[0] = 0;
+	}
+	virtual size_t write(uint8_t c) {
+		if (_length >= _size - 1) {
+			return 0;
+		}
+		_buffer[_length++] = c;
+		_buffer[_length] = 0;
+		return 1;
+	}
+	size_t length() const {
+		return _length;
+	}
+private:
+	char *_buffer;
+	size_t _size;
+	size_t _length;
+};
+
+static size_t protocolWriteUInt8(Print &out, uint8_t value) {
+	char digits[3];
+	uint8_t n = 0;
+	do {
+		digits[n++] = '0' + (value % 10);
+		value /= 10;
+	} while (value);
+	size_t written = n;
+	while (n) {
+		out.write(digits[--n]);
+	}
+	return written;
+}
+
+static size_t protocolWriteField(Print &out, uint8_t value) {
+	size_t n = protocolWriteUInt8(out, value);
+	return n + out.write(';');
+}
+
+size_t protocolFormat(MyMessage &message, Print &out) {
+	size_t n = protocolWriteField(out, message.sender);
+	n += protocolWriteField(out, message.sensor);
+	n += protocolWriteField(out, (uint8_t)mGetCommand(message));
+	n += protocolWriteField(out, (uint8_t)mGetAck(message));
+	n += protocolWriteField(out, message.type);
+	n += message.printString(out);
+	n += out.write('\n');
+	return n;
 }
 
-char * protocolFormat(MyMessage &message) {
-	snprintf_P(_fmtBuffer, MY_GATEWAY_MAX_SEND_LENGTH, PSTR("%d;%d;%d;%d;%d;%s\n"), message.sender, message.sensor, (uint8_t)mGetCommand(message), (uint8_t)mGetAck(message), message.type, message.getString(_convBuffer));
+char * protocolFormat(MyMessage &message, size_t *length) {
+	ProtocolBufferPrint out(_fmtBuffer, MY_GATEWAY_MAX_SEND_LENGTH);
+	(void)protocolFormat(message, out);
+	if (length != NULL) {
+		*length = out.length();
+	}
 	return _fmtBuffer;
 }
 
@@ -29,11 +29,152 @@ MyMessage _msgTmp; // Buffer for temporary messages (acks and nonces among other
 #endif
 
 uint32_t _heartbeat = 0;
+#if defined(MY_PRESENTATION_BATCH_FEATURE) && defined(MY_RADIO_FEATURE) && !defined(MY_GATEWAY_FEATURE)
+	#define PRESENTATION_BATCH
+	// Leave room for a signature
+	#define PRESENTATION_BATCH_MAX_LENGTH ((MAX_PAYLOAD-2) & ~1)
+	static bool _presentationBatching = false;
+	static MyMessage _presentationBatch;
+#endif
+#if defined(MY_AGGREGATION_FEATURE) && defined(MY_RADIO_FEATURE) && !defined(MY_GATEWAY_FEATURE)
+	#define AGGREGATION
+	// Leave room for a signature
+	#define AGGREGATE_MAX_LENGTH (MAX_PAYLOAD-2)
+	static MyMessage _aggregate;
+	static void _aggregateFlush();
+#endif
+#if defined(MY_REPORTING_FEATURE)
+	typedef struct {
+		uint8_t sensor;
+		uint8_t type;
+		float value;            // last value sent
+		unsigned long lastSent; // _reportingTime() of last send, 0 = free entry
+	} reporting_entry_t;
+	static reporting_entry_t _reporting[MY_REPORTING_CHILDREN];
+
+	static inline unsigned long _reportingTime() {
+		// never 0 (marks a free entry), includes the time spent in timed sleep
+		return nodeMillis() | 1;
+	}
+#endif
 void (*_timeCallback)(unsigned long); // Callback for requested time messages
 
+#if defined(MY_LOCAL_CLOCK_FEATURE)
+	// A time further off than this is taken as the controller clock being set, not as drift
+	#define CLOCK_MAX_STEP 60
+	// Shortest time (ms) over which the drift is computed, the controller sends whole seconds
+	#define CLOCK_MIN_BASE 600000ul
+
+	static unsigned long _clockTime = 0; // controller time at the last sync, 0 = not synced
+	static unsigned long _clockMs; // nodeMillis() at the last sync
+	static unsigned long _clockBaseTime; // sync the drift is measured from
+	static unsigned long _clockBaseMs;
+	static float _clockRate = 1; // controller ms per local ms
+	static unsigned long _clockInterval = MY_TIME_SYNC_MIN * 1000ul; // ms from a sync to the next request
+	static unsigned long _clockRequested = 0; // nodeMillis() of the outstanding request, 0 = none
+
+	static void _clockSync(unsigned long time) {
+		unsigned long now = nodeMillis();
+		if (!_clockTime) {
+			_clockBaseTime = time;
+			_clockBaseMs = now;
+		} else {
+			long error = time - nodeTime();
+			unsigned long elapsed = now - _clockMs;
+			unsigned long base = now - _clockBaseMs;
+			if (error > CLOCK_MAX_STEP || error < -CLOCK_MAX_STEP || base > 0x7FFFFFFFul) {
+				// Measure anew from here, the rate found so far is kept
+				_clockBaseTime = time;
+				_clockBaseMs = now;
+			} else if (base >= CLOCK_MIN_BASE) {
+				_clockRate = (float)(time - _clockBaseTime) * 1000 / base;
+			}
+			// Stretch the interval while the clock stays within the resolution of the time sent,
+			// otherwise take the one that would have kept the error at MY_TIME_MAX_ERROR
+			unsigned long absError = error < 0 ? -error : error;
+			if (absError <= 1) {
+				_clockInterval *= 2;
+			} else {
+				_clockInterval = elapsed / absError * MY_TIME_MAX_ERROR;
+			}
+			_clockInterval = constrain(_clockInterval, MY_TIME_SYNC_MIN * 1000ul, MY_TIME_SYNC_MAX * 1000ul);
+		}
+		_clockTime = time;
+		_clockMs = now;
+		_clockRequested = 0;
+		debug(PSTR("time=%lu, next sync %lus\n"), time, _clockInterval / 1000);
+	}
+
+	static void _clockProcess() {
+		#if defined(MY_RADIO_FEATURE)
+			if (_nc.nodeId == AUTO) {
+				return;
+			}
+		#endif
+		unsigned long now = nodeMillis();
+		if (_clockRequested ? now - _clockRequested < MY_TIME_SYNC_RETRY * 1000ul :
+			_clockTime && now - _clockMs < _clockInterval) {
+			return;
+		}
+		// never 0 (marks no request)
+		_clockRequested = now | 1;
+		requestTime();
+	}
+
+	unsigned long nodeTime() {
+		if (!_clockTime) {
+			return 0;
+		}
+		return _clockTime + (unsigned long)(((nodeMillis() - _clockMs) * _clockRate + 500) / 1000);
+	}
+#endif
+
+#if defined(MY_STATS_FEATURE)
+	NodeStats _stats;
+	// Parts of a ms not yet counted in the totals
+	static uint16_t _statsSendRest = 0;
+	static uint16_t _statsSignRest = 0;
+
+	static void _statsAddTime(uint32_t &totalMs, uint16_t &restUs, unsigned long elapsedUs) {
+		elapsedUs += restUs;
+		totalMs += elapsedUs / 1000;
+		restUs = elapsedUs % 1000;
+	}
+
+	static inline uint16_t _statsMax(uint16_t current, unsigned long elapsedUs) {
+		return elapsedUs > current ? (elapsedUs > 0xFFFF ? 0xFFFF : elapsedUs) : current;
+	}
+
+	void _statsSendTime(unsigned long startUs) {
+		unsigned long elapsed = hwMicros() - startUs;
+		_statsAddTime(_stats.sendTime, _statsSendRest, elapsed);
+		_stats.sendMax = _statsMax(_stats.sendMax, elapsed);
+	}
+
+	void _statsSignTime(unsigned long startUs) {
+		_statsAddTime(_stats.signTime, _statsSignRest, hwMicros() - startUs);
+	}
+
+	NodeStats getStats() {
+		_stats.freeMem = hwFreeMem();
+		return _stats;
+	}
+
+	void clearStats() {
+		memset(&_stats, 0, sizeof(_stats));
+		_statsSendRest = 0;
+		_statsSignRest = 0;
+	}
+#endif
+
 
 void _process() {
 	hwWatchdogReset();
+	#if defined(MY_STATS_FEATURE)
+		unsigned long processStart = hwMicros();
+	#endif
+	// commit config writes that have settled (flash backed EEPROM)
+	hwConfigFlush(false);
 
 
 	#if defined (MY_LEDS_BLINKING_FEATURE)
@@ -50,8 +191,21 @@ void _process() {
 
 	#if defined(MY_RADIO_FEATURE)
 		transportProcess();
+		#if defined(AGGREGATION)
+			_aggregateFlush();
+		#endif
+		#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+			transportQueueProcess();
+		#endif
+	#endif
+
+	#if defined(MY_LOCAL_CLOCK_FEATURE)
+		_clockProcess();
+	#endif
+
+	#if defined(MY_STATS_FEATURE)
+		_stats.processMax = _statsMax(_stats.processMax, hwMicros() - processStart);
 	#endif
-	
 }
 
 #if defined(MY_RADIO_FEATURE)
@@ -190,8 +344,7 @@ void _begin() {
 	#if defined(MY_RADIO_FEATURE)
 		transportPresentNode();
 	#endif
-	if (presentation)
-		presentation();
+	_presentation();
 
 	debug(PSTR("Init complete, id=%d, parent=%d, distance=%d\n"), _nc.nodeId, _nc.parentNodeId, _nc.distance);
 }
@@ -212,7 +365,7 @@ ControllerConfig getConfig() {
 }
 
 
-boolean _sendRoute(MyMessage &message) {
+boolean _sendRoute(MyMessage &message, uint8_t priority) {
 	// increment heartbeat counter
 	_heartbeat++;
 	#if defined(MY_CORE_ONLY)
@@ -227,17 +380,124 @@ boolean _sendRoute(MyMessage &message) {
 		}
 	#endif
 	#if defined(MY_RADIO_FEATURE)
-		return transportSendRoute(message);
+		bool ok = transportSendRoute(message);
+		for (uint8_t i = 0; !ok && priority == PRIORITY_HIGH && i < MY_PRIORITY_HIGH_RETRIES; i++) {
+			// the radio retries within a few ms, give the link a moment before the next round
+			wait(MY_PRIORITY_HIGH_RETRY_DELAY);
+			ok = transportSendRoute(message);
+		}
+		return ok;
 	#else
+		(void)priority;
 		return false;
 	#endif
 }
 
-bool send(MyMessage &message, bool enableAck) {
+bool send(MyMessage &message, bool enableAck, uint8_t priority) {
 	message.sender = _nc.nodeId;
 	mSetCommand(message,C_SET);
     mSetRequestAck(message,enableAck);
-	return _sendRoute(message);
+	return _sendRoute(message, priority);
+}
+
+bool sendAsync(MyMessage &message, bool enableAck, uint8_t priority) {
+	#if defined(MY_RADIO_FEATURE) && defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+		message.sender = _nc.nodeId;
+		mSetCommand(message,C_SET);
+		mSetRequestAck(message,enableAck);
+		#if defined(MY_GATEWAY_FEATURE)
+			if (message.destination == _nc.nodeId) {
+				// Local gateway sensor, no radio involved
+				return _sendRoute(message, priority);
+			}
+		#endif
+		return transportQueueSend(message, priority);
+	#else
+		return send(message, enableAck, priority);
+	#endif
+}
+
+#if defined(AGGREGATION)
+static void _aggregateFlush() {
+	// Sending may process() (e.g. parent search), do not send the frame twice
+	static bool flushing = false;
+	if (mGetLength(_aggregate) && !flushing) {
+		flushing = true;
+		_sendRoute(_aggregate);
+		mSetLength(_aggregate, 0);
+		flushing = false;
+	}
+}
+#endif
+
+bool sendAggregated(MyMessage &message) {
+	#if defined(AGGREGATION)
+		uint8_t valueLength = mGetLength(message);
+		if (message.destination == GATEWAY_ADDRESS && valueLength <= AGGREGATE_MAX_LENGTH - 3) {
+			uint8_t length = mGetLength(_aggregate);
+			if (length + 3 + valueLength > AGGREGATE_MAX_LENGTH) {
+				_aggregateFlush();
+				length = 0;
+			}
+			if (!length) {
+				build(_aggregate, _nc.nodeId, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_AGGREGATE, false);
+				mSetPayloadType(_aggregate, P_CUSTOM);
+			}
+			// Tuple of child id, value type, payload type (3 bits) and length (5 bits), value
+			_aggregate.data[length] = message.sensor;
+			_aggregate.data[length+1] = message.type;
+			_aggregate.data[length+2] = mGetPayloadType(message) | (valueLength << 3);
+			memcpy(&_aggregate.data[length+3], message.data, valueLength);
+			mSetLength(_aggregate, length + 3 + valueLength);
+			return true;
+		}
+	#endif
+	return send(message);
+}
+
+bool sendIfChanged(MyMessage &message, float value, uint8_t decimals, float deadband, unsigned long maxInterval, bool enableAck) {
+	#if defined(MY_REPORTING_FEATURE)
+		unsigned long now = _reportingTime();
+		reporting_entry_t *entry = NULL;
+		reporting_entry_t *oldest = &_reporting[0];
+		for (uint8_t i = 0; i < MY_REPORTING_CHILDREN; i++) {
+			reporting_entry_t *e = &_reporting[i];
+			if (e->lastSent && e->sensor == message.sensor && e->type == message.type) {
+				entry = e;
+				break;
+			}
+			if (!e->lastSent || (oldest->lastSent && now - e->lastSent > now - oldest->lastSent)) {
+				oldest = e;
+			}
+		}
+		if (entry) {
+			float change = value - entry->value;
+			if (change < 0) {
+				change = -change;
+			}
+			if (change <= deadband && (!maxInterval || now - entry->lastSent < maxInterval)) {
+				// Nothing worth reporting
+				return true;
+			}
+		} else {
+			// First report for this child, take over the least recently reported entry
+			entry = oldest;
+			entry->lastSent = 0;
+		}
+		if (!send(message.set(value, decimals), enableAck)) {
+			// Keep the last reported value, retry next time
+			return false;
+		}
+		entry->sensor = message.sensor;
+		entry->type = message.type;
+		entry->value = value;
+		entry->lastSent = now;
+		return true;
+	#else
+		(void)deadband;
+		(void)maxInterval;
+		return send(message.set(value, decimals), enableAck);
+	#endif
 }
 
 void sendBatteryLevel(uint8_t value, bool enableAck) {
@@ -249,7 +509,48 @@ void sendHeartbeat(void) {
 
 }
 
+#if defined(PRESENTATION_BATCH)
+static void _presentationBatchFlush() {
+	if (mGetLength(_presentationBatch)) {
+		_sendRoute(_presentationBatch);
+		mSetLength(_presentationBatch, 0);
+	}
+}
+#endif
+
+void _presentation() {
+	if (!presentation)
+		return;
+	#if defined(PRESENTATION_BATCH)
+		build(_presentationBatch, _nc.nodeId, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_PRESENTATION_BATCH, false);
+		mSetPayloadType(_presentationBatch, P_CUSTOM);
+		mSetLength(_presentationBatch, 0);
+		_presentationBatching = true;
+	#endif
+	presentation();
+	#if defined(PRESENTATION_BATCH)
+		_presentationBatchFlush();
+		_presentationBatching = false;
+	#endif
+}
+
 void present(uint8_t childSensorId, uint8_t sensorType, const char *description, bool enableAck) {
+	#if defined(PRESENTATION_BATCH)
+		if (_presentationBatching) {
+			if (childSensorId != NODE_SENSOR_ID && !enableAck && (description == NULL || !*description)) {
+				uint8_t length = mGetLength(_presentationBatch);
+				_presentationBatch.data[length] = childSensorId;
+				_presentationBatch.data[length+1] = sensorType;
+				mSetLength(_presentationBatch, length+2);
+				if (length+2 >= PRESENTATION_BATCH_MAX_LENGTH) {
+					_presentationBatchFlush();
+				}
+				return;
+			}
+			// Keep presentation order
+			_presentationBatchFlush();
+		}
+	#endif
 	_sendRoute(build(_msg, _nc.nodeId, GATEWAY_ADDRESS, childSensorId, C_PRESENTATION, sensorType, enableAck).set(childSensorId==NODE_SENSOR_ID?LIBRARY_VERSION:description));
 }
 
@@ -278,6 +579,9 @@ void _processInternalMessages() {
 	#if !defined(MY_DISABLE_REMOTE_RESET)
 		if (type == I_REBOOT) {
 			// Requires MySensors or other bootloader with watchdogs enabled
+			#if defined(MY_REPEATER_FEATURE)
+				transportSaveRoutingTable();
+			#endif
 			hwReboot();
 		} else
 	#endif
@@ -297,12 +601,34 @@ void _processInternalMessages() {
 			#if defined(MY_RADIO_FEATURE)
 				transportPresentNode();
 			#endif
-			if (presentation)
-				presentation();
+			_presentation();
 		}
 	} else if (type == I_HEARTBEAT) {
 		sendHeartbeat();
+	#if defined(MY_STATS_FEATURE)
+	} else if (type == I_STATS) {
+		if (!mGetAck(_msg)) {
+			bool clear = _msg.data[0] == 'C';
+			NodeStats stats = getStats();
+			_sendRoute(build(_msgTmp, _nc.nodeId, _msg.sender, NODE_SENSOR_ID, C_INTERNAL, I_STATS, false).set(&stats, sizeof(stats)));
+			if (clear) {
+				clearStats();
+			}
+		}
+	#endif
+	#if defined(MY_RF24_CHANNEL_SCAN) && defined(MY_GATEWAY_FEATURE)
+	} else if (type == I_CHANNEL) {
+		if (!mGetAck(_msg)) {
+			// Without a channel survey the band for the quietest one
+			uint8_t channel = mGetLength(_msg) ? _msg.getByte() : transportScanChannels();
+			gatewayTransportSend(buildGw(_msgTmp, I_CHANNEL).set(channel));
+			transportMoveChannel(channel);
+		}
+	#endif
 	} else if (type == I_TIME) {
+		#if defined(MY_LOCAL_CLOCK_FEATURE)
+			_clockSync(_msg.getULong());
+		#endif
 		// Deliver time to callback
 		if (receiveTime)
 			receiveTime(_msg.getULong());
@@ -311,10 +637,7 @@ void _processInternalMessages() {
 				if (_msg.data[0] == 'C') {
 					// Clears child relay data for this node
 					debug(PSTR("clear routing table\n"));
-					uint8_t i = 255;
-					do {
-						hwWriteConfig(EEPROM_ROUTES_ADDRESS+i, BROADCAST_ADDRESS);
-					} while (i--);
+					transportClearRoutingTable();
 					// Clear parent node id & distance to gw
 					hwWriteConfig(EEPROM_PARENT_NODE_ID_ADDRESS, AUTO);
 					hwWriteConfig(EEPROM_DISTANCE_ADDRESS, DISTANCE_INVALID);
@@ -329,6 +652,7 @@ void _processInternalMessages() {
 			if(debug_msg == 'R'){
 				#if defined(MY_REPEATER_FEATURE)
 					// routing table
+					transportSaveRoutingTable();
 					for(uint8_t cnt=0; cnt!=255;cnt++){
 						uint8_t route = hwReadConfig(EEPROM_ROUTES_ADDRESS+cnt);
 						if (route!=BROADCAST_ADDRESS){
@@ -368,14 +692,22 @@ uint8_t loadState(uint8_t pos) {
 	return hwReadConfig(EEPROM_LOCAL_CONFIG_ADDRESS+pos);
 }
 
+void saveStateBlock(uint8_t pos, const void *buf, uint8_t length) {
+	hwWriteConfigBlock((void*)buf, (void*)(EEPROM_LOCAL_CONFIG_ADDRESS+pos), length);
+}
+
+void loadStateBlock(uint8_t pos, void *buf, uint8_t length) {
+	hwReadConfigBlock(buf, (void*)(EEPROM_LOCAL_CONFIG_ADDRESS+pos), length);
+}
+
 
+// Between two _process() calls the CPU idles until the next interrupt, the
+// millis tick bounds that to about 1ms.
 void wait(unsigned long ms) {
 	unsigned long enter = hwMillis();
 	while (hwMillis() - enter < ms) {
 		_process();
-		#if defined(MY_GATEWAY_ESP8266)
-			yield();
-		#endif
+		hwIdle();
 	}
 }
 
@@ -385,9 +717,7 @@ void wait(unsigned long ms, uint8_t cmd, uint8_t msgtype) {
 	_msg.type = !msgtype;
 	while ( (hwMillis() - enter < ms) && !(mGetCommand(_msg)==cmd && _msg.type==msgtype) ) {
 		_process();
-		#if defined(MY_GATEWAY_ESP8266)
-			yield();
-		#endif
+		hwIdle();
 	}
 }
 
@@ -406,12 +736,42 @@ int8_t sleep(unsigned long ms) {
 		return -1;
 	#else
 		#if defined(MY_RADIO_FEATURE)
+			#if defined(AGGREGATION)
+				_aggregateFlush();
+			#endif
+			#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+				// Deliver queued messages before radio is powered down
+				transportQueueFlush();
+			#endif
 			transportPowerDown();
 		#endif
+		signerNoncePoolSleep(ms);
+		hwConfigFlush(true);
 		return hwSleep(ms);
 	#endif
 }
 
+unsigned long nodeMillis() {
+	return hwMillis() + hwSleepTime();
+}
+
+int8_t sleepUntilNextTimer(unsigned long ms) {
+	if (ms == 0) {
+		// already due
+		return -1;
+	}
+	unsigned long enter = nodeMillis();
+	int8_t ret = sleep(ms);
+	if (ret == -1) {
+		// timed sleep only works in whole watchdog periods, stay awake for the rest
+		unsigned long slept = nodeMillis() - enter;
+		if (slept < ms) {
+			wait(ms - slept);
+		}
+	}
+	return ret;
+}
+
 int8_t smartSleep(unsigned long ms) {
 	int8_t ret = sleep(ms);
 	// notifiy controller about wake up
@@ -436,8 +796,17 @@ int8_t sleep(uint8_t interrupt, uint8_t mode, unsigned long ms) {
 		return -2;
 	#else
 		#if defined(MY_RADIO_FEATURE)
+			#if defined(AGGREGATION)
+				_aggregateFlush();
+			#endif
+			#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+				// Deliver queued messages before radio is powered down
+				transportQueueFlush();
+			#endif
 			transportPowerDown();
 		#endif
+		signerNoncePoolSleep(ms);
+		hwConfigFlush(true);
 		return hwSleep(interrupt, mode, ms);
 	#endif
 }
@@ -468,8 +837,17 @@ int8_t sleep(uint8_t interrupt1, uint8_t mode1, uint8_t interrupt2, uint8_t mode
 		return -2;
 	#else
 		#if defined(MY_RADIO_FEATURE)
+			#if defined(AGGREGATION)
+				_aggregateFlush();
+			#endif
+			#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+				// Deliver queued messages before radio is powered down
+				transportQueueFlush();
+			#endif
 			transportPowerDown();
 		#endif
+		signerNoncePoolSleep(ms);
+		hwConfigFlush(true);
 		return hwSleep(interrupt1, mode1, interrupt2, mode2, ms);
 	#endif
 }
@@ -495,6 +873,13 @@ void nodeLock(const char* str) {
 		_sendRoute(build(_msg, _nc.nodeId, GATEWAY_ADDRESS, NODE_SENSOR_ID,
 			C_INTERNAL, I_LOCKED, false).set(str));
 		#if defined(MY_RADIO_FEATURE)
+			#if defined(AGGREGATION)
+				_aggregateFlush();
+			#endif
+			#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+				// Deliver queued messages before radio is powered down
+				transportQueueFlush();
+			#endif
 			transportPowerDown();
 		#endif
 		(void)hwSleep((unsigned long)1000*60*30); // Sleep for 30 min before resending LOCKED message
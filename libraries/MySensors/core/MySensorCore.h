@@ -39,6 +39,15 @@
 // Node child is always created/presented when a node is started
 #define NODE_SENSOR_ID 0xFF
 
+/**
+ * @brief Priority of an outgoing message, see send() and sendAsync()
+ */
+typedef enum {
+	PRIORITY_LOW,    //!< Periodic values, dropped first when the send queue is full
+	PRIORITY_NORMAL, //!< Default
+	PRIORITY_HIGH    //!< Alarms, sent ahead of queued messages and retried (@ref MY_PRIORITY_HIGH_RETRIES)
+} message_priority_t;
+
 
 /**
  * @brief Node configuration
@@ -60,6 +69,27 @@ struct ControllerConfig {
 	uint8_t isMetric; //!< Flag indicating if metric or imperial measurements are used
 };
 
+#if defined(MY_STATS_FEATURE)
+/**
+ * @brief Node statistics
+ *
+ * Counted since start-up (or the last clear) by @ref MY_STATS_FEATURE. This is also the payload of
+ * the I_STATS response (little endian, 24 bytes), counters stop at their maximum.
+ */
+struct NodeStats {
+	uint32_t sendTime; //!< Time spent in transportSend() in ms
+	uint32_t signTime; //!< Time spent signing and verifying messages in ms (includes the nonce exchange)
+	uint16_t tx; //!< Frames sent, including forwarded messages and broadcasts
+	uint16_t txFailed; //!< Frames not acked by the next hop
+	uint16_t rx; //!< Frames received, including those passing through
+	uint16_t forwarded; //!< Messages relayed for other nodes
+	uint16_t retries; //!< Radio retransmissions (nRF24 auto retry count, 0 for other transports)
+	uint16_t sendMax; //!< Longest transportSend() in us
+	uint16_t processMax; //!< Longest pass through process() in us
+	uint16_t freeMem; //!< Free RAM (hwFreeMem()) when the statistics were taken
+};
+#endif
+
 
 
 /**
@@ -72,6 +102,18 @@ uint8_t getNodeId();
  */
 uint8_t getParentNodeId();
 
+#if defined(MY_STATS_FEATURE)
+/**
+ * Return the statistics of this node, see @ref NodeStats.
+ */
+NodeStats getStats();
+
+/**
+ * Reset all counters of the node statistics.
+ */
+void clearStats();
+#endif
+
 /**
 * Each node must present all attached sensors before any values can be handled correctly by the controller.
 * It is usually good to present all attached sensors after power-up in setup().
@@ -98,9 +140,54 @@ void sendSketchInfo(const char *name, const char *version, bool ack=false);
 *
 * @param msg Message to send
 * @param ack Set this to true if you want destination node to send ack back to this node. Default is not to request any ack.
+* @param priority PRIORITY_HIGH repeats the send up to @ref MY_PRIORITY_HIGH_RETRIES more times when it fails.
 * @return true Returns true if message reached the first stop on its way to destination.
 */
-bool send(MyMessage &msg, bool ack=false);
+bool send(MyMessage &msg, bool ack=false, uint8_t priority=PRIORITY_NORMAL);
+
+/**
+* Queues a message for sending without waiting for the radio. The queue is drained by process()
+* (i.e. wait() or between loop() calls) and flushed before the node goes to sleep.
+* A queued, not yet sent value for the same child and type is replaced by the new one.
+* PRIORITY_HIGH messages go ahead of all other queued messages, when the queue is full the
+* oldest PRIORITY_LOW message makes room for a more important one.
+* Falls back to send() if @ref MY_TRANSPORT_TX_QUEUE_FEATURE is disabled.
+*
+* @param msg Message to send
+* @param ack Set this to true if you want destination node to send ack back to this node. Default is not to request any ack.
+* @param priority See message_priority_t.
+* @return true Returns true if message could be queued (or was sent, if queue is disabled).
+*/
+bool sendAsync(MyMessage &msg, bool ack=false, uint8_t priority=PRIORITY_NORMAL);
+
+/**
+* Adds a value to the aggregation frame of this node instead of sending it right away. The frame
+* is sent when full, by process() (i.e. wait() or between loop() calls) and before the node goes
+* to sleep. The gateway expands it into one message per value for the controller.
+* Messages to other destinations than the gateway are sent directly (without ack).
+* Falls back to send() if @ref MY_AGGREGATION_FEATURE is disabled.
+*
+* @param msg Message to send
+* @return true Returns true if message was added to the frame (or was sent).
+*/
+bool sendAggregated(MyMessage &msg);
+
+/**
+* Sends a value only if it differs by more than deadband from the value last reported for the
+* same child and value type, or if that report is older than maxInterval. Replaces the usual
+* "compare to last value" logic in sketches. Last values are kept in RAM for
+* @ref MY_REPORTING_CHILDREN children, time spent in timed sleep() counts towards maxInterval.
+* Always sends if @ref MY_REPORTING_FEATURE is disabled.
+*
+* @param msg Message to send, payload is set to value
+* @param value Current value
+* @param decimals Number of decimals when serializing value
+* @param deadband Changes up to this amount are not reported
+* @param maxInterval Report anyway after this many milliseconds (0 = never)
+* @param ack Set this to true if you want destination node to send ack back to this node. Default is not to request any ack.
+* @return true Returns true if the value was not worth reporting or reached the first stop on its way to destination.
+*/
+bool sendIfChanged(MyMessage &msg, float value, uint8_t decimals, float deadband=0, unsigned long maxInterval=0, bool ack=false);
 
 
 /**
@@ -160,9 +247,29 @@ void saveState(uint8_t pos, uint8_t value);
  */
 uint8_t loadState(uint8_t pos);
 
+/**
+ * Save several states at once (in local EEPROM). Only bytes that changed are written,
+ * on ESP8266 the flash sector holding the EEPROM is committed once for the whole block.
+ *
+ * @param pos The position of the first byte (0-255)
+ * @param buf Data to store
+ * @param length Number of bytes to store (pos+length must not exceed 256)
+ */
+void saveStateBlock(uint8_t pos, const void *buf, uint8_t length);
+
+/**
+ * Load several states at once (from local EEPROM).
+ *
+ * @param pos The position of the first byte (0-255)
+ * @param buf Buffer receiving the data
+ * @param length Number of bytes to load (pos+length must not exceed 256)
+ */
+void loadStateBlock(uint8_t pos, void *buf, uint8_t length);
+
 /**
  * Wait for a specified amount of time to pass.  Keeps process()ing.
- * This does not power-down the radio nor the Arduino.
+ * This does not power-down the radio nor the Arduino, but the CPU idles between
+ * process() calls until an interrupt (radio, serial, the 1ms system tick) wakes it.
  * Because this calls process() in a loop, it is a good way to wait
  * in your loop() on a repeater node or sensor that listens to messages.
  * @param ms Number of milliseconds to sleep.
@@ -171,7 +278,8 @@ void wait(unsigned long ms);
 
 /**
  * Wait for a specified amount of time to pass or until specified message received.  Keeps process()ing.
- * This does not power-down the radio nor the Arduino.
+ * This does not power-down the radio nor the Arduino, but the CPU idles between
+ * process() calls until an interrupt (radio, serial, the 1ms system tick) wakes it.
  * Because this calls process() in a loop, it is a good way to wait
  * in your loop() on a repeater node or sensor that listens to messages.
  * @param ms Number of milliseconds to sleep.
@@ -214,6 +322,32 @@ int8_t smartSleep(uint8_t interrupt, uint8_t mode, unsigned long ms=0);
 int8_t sleep(uint8_t interrupt1, uint8_t mode1, uint8_t interrupt2, uint8_t mode2, unsigned long ms=0);
 int8_t smartSleep(uint8_t interrupt1, uint8_t mode1, uint8_t interrupt2, uint8_t mode2, unsigned long ms=0);
 
+/**
+ * Milliseconds since start-up, including the time spent in timed sleep().
+ * millis() stops while the MCU is powered down, this keeps counting, so it can serve
+ * as time source for Timer and SimpleTimer (setTimeSource(nodeMillis)) on sleeping nodes.
+ * On AVR sleep time is counted in watchdog periods measured against the system clock,
+ * see MY_SLEEP_CALIBRATION_INTERVAL.
+ */
+unsigned long nodeMillis();
+
+/**
+ * Sleep until the next Timer/SimpleTimer deadline. Sleeps in watchdog periods and waits
+ * out the remainder that is shorter than one period, so the deadline is met on nodeMillis().
+ * @param ms Milliseconds to the deadline, e.g. Timer::timeToNextEvent() or SimpleTimer::timeToNextTimer()
+ * @return -1 when the deadline is reached (also for ms = 0), -2 if not possible (e.g. ongoing FW update)
+ */
+int8_t sleepUntilNextTimer(unsigned long ms);
+
+#if defined(MY_LOCAL_CLOCK_FEATURE)
+/**
+ * Controller time (seconds, as sent in I_TIME) kept on the node, 0 until the first time response.
+ * It runs on nodeMillis() corrected by the drift measured between syncs, the node requests the
+ * time again when needed. Fits setSyncProvider() of the Time library: setSyncProvider(nodeTime).
+ */
+unsigned long nodeTime();
+#endif
+
 #ifdef MY_NODE_LOCK_FEATURE
 /**
  * @ingroup MyLockgrp
@@ -237,11 +371,22 @@ void _process(void);
 
 void _processInternalMessages();
 
+void _presentation();
+
 void _infiniteLoop();
 
-boolean _sendRoute(MyMessage &message);
+boolean _sendRoute(MyMessage &message, uint8_t priority=PRIORITY_NORMAL);
 
 extern NodeConfig _nc;
+#if defined(MY_STATS_FEATURE)
+	extern NodeStats _stats;
+	// Account the time since startUs (hwMicros()) to transportSend() resp. signing
+	void _statsSendTime(unsigned long startUs);
+	void _statsSignTime(unsigned long startUs);
+	static inline void _statsCount(uint16_t &counter, uint8_t n = 1) {
+		counter = counter > 0xFFFF - n ? 0xFFFF : counter + n;
+	}
+#endif
 extern MyMessage _msg;  // Buffer for incoming messages.
 extern MyMessage _msgTmp;  // Buffer for temporary messages (acks and nonces among others).
 #ifdef MY_DEBUG
@@ -33,19 +33,68 @@
 #if defined(MY_SIGNING_REQUEST_SIGNATURES) && (!defined(MY_SIGNING_ATSHA204) && !defined(MY_SIGNING_SOFT))
 #error You have to pick either MY_SIGNING_ATSHA204 or MY_SIGNING_SOFT in order to require signatures!
 #endif
+#if defined(MY_SIGNING_NONCE_POOL_FEATURE) && !defined(MY_SIGNING_FEATURE)
+#undef MY_SIGNING_NONCE_POOL_FEATURE
+#endif
 #ifdef MY_SIGNING_FEATURE
 uint8_t _doSign[32];      // Bitfield indicating which sensors require signed communication
 uint8_t _doWhitelist[32]; // Bitfield indicating which sensors require serial salted signatures
 MyMessage _msgSign;       // Buffer for message to sign.
 uint8_t _signingNonceStatus;
 
+#ifdef MY_SIGNING_NODE_WHITELISTING
+const whitelist_entry_t _signing_whitelist[] PROGMEM = MY_SIGNING_NODE_WHITELISTING;
+
+bool signerWhitelistFind(uint8_t nodeId, whitelist_entry_t &entry) {
+	static uint8_t sorted = 2; // not checked yet
+	if (sorted == 2) {
+		sorted = 1;
+		for (size_t i = 1; i < NUM_OF(_signing_whitelist); i++) {
+			if (pgm_read_byte(&_signing_whitelist[i].nodeId) <= pgm_read_byte(&_signing_whitelist[i-1].nodeId)) {
+				sorted = 0;
+				break;
+			}
+		}
+	}
+	size_t lo = 0;
+	size_t hi = NUM_OF(_signing_whitelist);
+	while (lo < hi) {
+		size_t j = sorted ? lo + (hi - lo) / 2 : lo;
+		uint8_t id = pgm_read_byte(&_signing_whitelist[j].nodeId);
+		if (id == nodeId) {
+			memcpy_P(&entry, &_signing_whitelist[j], sizeof(whitelist_entry_t));
+			return true;
+		}
+		if (sorted && id > nodeId) {
+			hi = j;
+		} else {
+			lo = j + 1;
+		}
+	}
+	return false;
+}
+#endif
+
 #ifdef MY_NODE_LOCK_FEATURE
 static uint8_t nof_nonce_requests = 0;
 static uint8_t nof_failed_verifications = 0;
 #endif
 
 // Status when waiting for signing nonce in signerProcessInternal
-enum { SIGN_WAITING_FOR_NONCE = 0, SIGN_OK = 1 };
+enum { SIGN_WAITING_FOR_NONCE = 0, SIGN_OK = 1, SIGN_IDLE = 2 };
+
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+// Nonces peers pushed to us ahead of time, used for the next signed message to them
+typedef struct {
+	uint8_t node;
+	unsigned long timestamp;
+	uint8_t nonce[MAX_PAYLOAD];
+} signingReceivedNonce;
+static signingReceivedNonce _signingReceivedNonces[MY_SIGNING_NONCE_POOL_SIZE];
+#define SIGNING_NONCE_POOL_FREE 0xFF
+// Stop using a nonce in time for the message to reach the verifier before it expires there
+#define SIGNING_NONCE_POOL_USABLE_MS (MY_SIGNING_NONCE_POOL_TIMEOUT_MS - MY_VERIFICATION_TIMEOUT_MS)
+#endif
 
 // Macros for manipulating signing requirement table
 #define DO_SIGN(node) (~_doSign[node>>3]&(1<<node%8))
@@ -126,6 +175,95 @@ void signerInit(void) {
 #if defined(MY_SIGNING_ATSHA204)
 	signerAtsha204Init();
 #endif
+	_signingNonceStatus = SIGN_IDLE;
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		_signingReceivedNonces[i].node = SIGNING_NONCE_POOL_FREE;
+	}
+#endif
+#endif
+}
+
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+static void signerNoncePoolPut(MyMessage &msg) {
+	signingReceivedNonce *entry = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		signingReceivedNonce &e = _signingReceivedNonces[i];
+		if (e.node == msg.sender) {
+			// only the latest nonce of a peer is valid
+			entry = &e;
+			break;
+		}
+		if (!entry || (entry->node != SIGNING_NONCE_POOL_FREE &&
+			(e.node == SIGNING_NONCE_POOL_FREE || e.timestamp - entry->timestamp > 0x7FFFFFFFul))) {
+			// remember the first free or else the oldest entry
+			entry = &e;
+		}
+	}
+	entry->node = msg.sender;
+	entry->timestamp = hwMillis();
+	memcpy(entry->nonce, (uint8_t*)msg.getCustom(), MAX_PAYLOAD);
+	SIGN_DEBUG(PSTR("Nonce from %d stored for later use\n"), msg.sender);
+}
+
+// Sign msg with a nonce its destination pushed to us earlier, returns false if there is none
+static bool signerNoncePoolSign(MyMessage &msg) {
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		signingReceivedNonce &e = _signingReceivedNonces[i];
+		if (e.node != msg.destination) {
+			continue;
+		}
+		// nonces are single use
+		e.node = SIGNING_NONCE_POOL_FREE;
+		if (hwMillis() - e.timestamp > SIGNING_NONCE_POOL_USABLE_MS) {
+			return false;
+		}
+		MyMessage nonce;
+		nonce.set(e.nonce, MAX_PAYLOAD);
+		memset(e.nonce, 0xAA, MAX_PAYLOAD);
+#if defined(MY_SIGNING_SOFT)
+		signerAtsha204SoftPutNonce(nonce);
+		bool signedMsg = signerAtsha204SoftSignMsg(msg);
+#endif
+#if defined(MY_SIGNING_ATSHA204)
+		signerAtsha204PutNonce(nonce);
+		bool signedMsg = signerAtsha204SignMsg(msg);
+#endif
+		if (signedMsg) {
+			SIGN_DEBUG(PSTR("Message signed with pooled nonce\n"));
+		}
+		return signedMsg;
+	}
+	return false;
+}
+
+#if defined(MY_SIGNING_SOFT) && defined(MY_SIGNING_REQUEST_SIGNATURES)
+// Hand out the nonce for the next message of a peer right away
+static void signerNoncePoolPush(uint8_t destination) {
+	_msgTmp.sender = destination; // the backend keeps the nonce for the sender of the message
+	_msgTmp.type = I_NONCE_RESPONSE;
+	if (signerAtsha204SoftGetNonce(_msgTmp)) {
+		SIGN_DEBUG(PSTR("Pushing nonce to %d\n"), destination);
+		_sendRoute(build(_msgTmp, _nc.nodeId, destination, NODE_SENSOR_ID,
+			C_INTERNAL, I_NONCE_RESPONSE, false));
+	}
+}
+#endif
+#endif
+
+void signerNoncePoolSleep(unsigned long ms) {
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+	// millis() does not advance during sleep, age the pooled nonces by the (max) time asleep
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		signingReceivedNonce &e = _signingReceivedNonces[i];
+		if (!ms || ms > SIGNING_NONCE_POOL_USABLE_MS) {
+			e.node = SIGNING_NONCE_POOL_FREE;
+		} else {
+			e.timestamp -= ms;
+		}
+	}
+#else
+	(void)ms;
 #endif
 }
 
@@ -251,6 +389,13 @@ bool signerProcessInternal(MyMessage &msg) {
 #endif // MY_GATEWAY_FEATURE
 			return true; // No need to further process I_SIGNING_PRESENTATION
 		} else if (msg.type == I_NONCE_RESPONSE) {
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+			if (_signingNonceStatus != SIGN_WAITING_FOR_NONCE || sender != _msgSign.destination) {
+				// Nobody is waiting for this nonce, it was pushed to us ahead of time
+				signerNoncePoolPut(msg);
+				return true; // No need to further process I_NONCE_RESPONSE
+			}
+#endif
 			// Proceed with signing if nonce has been received
 			SIGN_DEBUG(PSTR("Nonce received from %d. Proceeding with signing...\n"), sender);
 			if (sender != _msgSign.destination) {
@@ -283,6 +428,7 @@ bool signerProcessInternal(MyMessage &msg) {
 	return false;
 }
 
+#if !defined(SIGNING_INLINE)
 bool signerCheckTimer(void) {
 #if defined(MY_SIGNING_SOFT)
 	return signerAtsha204SoftCheckTimer();
@@ -300,6 +446,10 @@ bool signerSignMsg(MyMessage &msg) {
 	if (DO_SIGN(msg.destination) && msg.sender == _nc.nodeId) {
 		if (skipSign(msg)) {
 			return true;
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+		} else if (signerNoncePoolSign(msg)) {
+			return true;
+#endif
 		} else {
 			// Send nonce-request
 			_signingNonceStatus=SIGN_WAITING_FOR_NONCE;
@@ -318,14 +468,17 @@ bool signerSignMsg(MyMessage &msg) {
 			}
 			if (hwMillis() - enter > MY_VERIFICATION_TIMEOUT_MS) {
 				SIGN_DEBUG(PSTR("Timeout waiting for nonce!\n"));
+				_signingNonceStatus = SIGN_IDLE;
 				return false;
 			}
 			if (_signingNonceStatus == SIGN_OK) {
+				_signingNonceStatus = SIGN_IDLE;
 				// process() received a nonce and signerProcessInternal successfully signed the message
 				msg = _msgSign; // Write the signed message back
 				SIGN_DEBUG(PSTR("Message to send has been signed\n"));
 			} else {
 				SIGN_DEBUG(PSTR("Message to send could not be signed!\n"));
+				_signingNonceStatus = SIGN_IDLE;
 				return false;
 			}
 			// After this point, only the 'last' member of the message structure is allowed to be altered if the
@@ -339,7 +492,9 @@ bool signerSignMsg(MyMessage &msg) {
 #endif // MY_SIGNING_FEATURE
 	return true;
 }
+#endif // SIGNING_INLINE
 
+#if !defined(SIGNING_VERIFY_INLINE)
 bool signerVerifyMsg(MyMessage &msg) {
 	bool verificationResult = true;
 	// Before processing message, reject unsigned messages if signing is required and check signature
@@ -367,6 +522,11 @@ bool signerVerifyMsg(MyMessage &msg) {
 			if (!verificationResult) {
 				SIGN_DEBUG(PSTR("Signature verification failed!\n"));
 			}
+#if defined(MY_SIGNING_NONCE_POOL_FEATURE) && defined(MY_SIGNING_SOFT)
+			else {
+				signerNoncePoolPush(msg.sender);
+			}
+#endif
 #if defined(MY_NODE_LOCK_FEATURE)
 			if (verificationResult) {
 				// On successful verification, clear lock counters
@@ -388,6 +548,7 @@ bool signerVerifyMsg(MyMessage &msg) {
 #endif // MY_SIGNING_REQUEST_SIGNATURES
 	return verificationResult;
 }
+#endif // SIGNING_VERIFY_INLINE
 
 static uint8_t sha256_hash[32];
 Sha256Class _soft_sha256;
@@ -398,9 +559,7 @@ void signerSha256Init(void) {
 }
 
 void signerSha256Update(const uint8_t* data, size_t sz) {
-	for (size_t i = 0; i < sz; i++) {
-		_soft_sha256.write(data[i]);
-	}
+	_soft_sha256.write(data, sz);
 }
 
 uint8_t* signerSha256Final(void) {
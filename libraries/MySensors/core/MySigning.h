@@ -330,7 +330,8 @@
  * ...
  * @endcode
  * In this example, there are two nodes in the whitelist; the gateway, and a separate node that communicates directly with this node (with signed
- * messages). You do not need to do anything special for the sending nodes, apart from making sure they support signing.
+ * messages). You do not need to do anything special for the sending nodes, apart from making sure they support signing.<br>
+ * The whitelist is kept in flash. List the entries in ascending node id order, long lists are then searched by bisection.
  *
  * The "soft" backend of course also support whitelisting. Example:
  * @code{.cpp}
@@ -483,6 +484,17 @@ typedef struct {
 	uint8_t nodeId;                   /**< @brief The ID of the node */
 	uint8_t serial[SHA204_SERIAL_SZ]; /**< @brief Node specific serial number */
 } whitelist_entry_t;
+
+/**
+ * @brief Looks up a node in the whitelist (kept in flash).
+ *
+ * Uses a binary search when @ref MY_SIGNING_NODE_WHITELISTING is sorted by node id, a linear scan otherwise.
+ *
+ * @param nodeId The node to look for.
+ * @param entry Receives the whitelist entry of the node.
+ * @returns @c true if the node is whitelisted.
+ */
+bool signerWhitelistFind(uint8_t nodeId, whitelist_entry_t &entry);
 #endif
 
 /** @brief Helper macro to determine the number of elements in a array */
@@ -496,6 +508,16 @@ typedef struct {
 #define CLEAR_WHITELIST(node) (_doWhitelist[node>>3]|=(1<<node%8))
 
 
+// Without signing, signerSignMsg(), signerVerifyMsg() and signerCheckTimer() are constant and
+// inlined below so the per-message send and receive path keeps no call into the signing code.
+// Tested on the backend defines, MY_SIGNING_FEATURE is only derived from them after this header.
+#if !defined(MY_SIGNING_FEATURE) && !defined(MY_SIGNING_ATSHA204) && !defined(MY_SIGNING_SOFT)
+	#define SIGNING_INLINE
+#endif
+#if defined(SIGNING_INLINE) || !defined(MY_SIGNING_REQUEST_SIGNATURES)
+	#define SIGNING_VERIFY_INLINE
+#endif
+
 /**
  * @brief Initializes signing infrastructure and associated backend.
  *
@@ -543,7 +565,22 @@ bool signerProcessInternal(MyMessage &msg);
  *
  * @returns @c true if session is still valid.
  */
+#if defined(SIGNING_INLINE)
+static inline bool signerCheckTimer(void) { return true; }
+#else
 bool signerCheckTimer(void);
+#endif
+
+/**
+ * @brief Account for time spent asleep in the age of pooled nonces.
+ *
+ * Nonces pushed to this node (see @ref MY_SIGNING_NONCE_POOL_FEATURE) are aged by @p ms, or dropped
+ * if @p ms is 0 (sleep without timeout).
+ * \n@b Usage: This function is called before the node enters sleep.
+ *
+ * @param ms The time the node is going to sleep.
+ */
+void signerNoncePoolSleep(unsigned long ms);
 
 /**
  * @brief Get nonce from provided message and store for signing operations.
@@ -576,7 +613,11 @@ bool signerPutNonce(MyMessage &msg);
  * @param msg The message to sign.
  * @returns @c true if successful, else @c false.
 */
+#if defined(SIGNING_INLINE)
+static inline bool signerSignMsg(MyMessage &msg) { (void)msg; return true; }
+#else
 bool signerSignMsg(MyMessage &msg);
+#endif
 
 /**
  * @brief Verifies signature in provided message.
@@ -593,7 +634,11 @@ bool signerSignMsg(MyMessage &msg);
  * @param msg The message to verify.
  * @returns @c true if successful, else @c false.
  */
+#if defined(SIGNING_VERIFY_INLINE)
+static inline bool signerVerifyMsg(MyMessage &msg) { (void)msg; return true; }
+#else
 bool signerVerifyMsg(MyMessage &msg);
+#endif
 
 /**
  * @brief Initialize a hash calculation session.
@@ -39,10 +39,9 @@ uint8_t _signing_temp_message[SHA_MSG_SIZE];
 uint8_t _singning_rx_buffer[SHA204_RSP_SIZE_MAX];
 uint8_t _singning_tx_buffer[SHA204_CMD_SIZE_MAX];
 extern uint8_t _doWhitelist[32];
+uint8_t _signing_serial[SHA204_SERIAL_SZ];
+bool _signing_serial_valid = false;
 
-#ifdef MY_SIGNING_NODE_WHITELISTING
-	const whitelist_entry_t _signing_whitelist[] = MY_SIGNING_NODE_WHITELISTING;
-#endif
 
 static void signerCalculateSignature(MyMessage &msg);
 static uint8_t* signerSha256(const uint8_t* data, size_t sz);
@@ -107,15 +106,19 @@ bool signerAtsha204GetNonce(MyMessage &msg) {
 	// Generate random number for use as nonce
 	// We used a basic whitening technique that takes the first byte of a new random value and builds up a 32-byte random value
 	// This 32-byte random value is then hashed (SHA256) to produce the resulting nonce
+	// All of it runs in one wake period of the device
+	(void)atsha204.sha204c_session_begin();
 	for (int i = 0; i < 32; i++) {
 		if (atsha204.sha204m_execute(SHA204_RANDOM, RANDOM_NO_SEED_UPDATE, 0, 0, NULL,
 											RANDOM_COUNT, _singning_tx_buffer, RANDOM_RSP_SIZE, _singning_rx_buffer) != SHA204_SUCCESS) {
+			atsha204.sha204c_sleep();
 			DEBUG_SIGNING_PRINTBUF(F("Failed to generate nonce"), NULL, 0);
 			return false;
 		}
 		_signing_current_nonce[i] = _singning_rx_buffer[SHA204_BUFFER_POS_DATA];
 	}
 	memcpy(_signing_current_nonce, signerSha256(_signing_current_nonce, 32), MAX_PAYLOAD);
+	atsha204.sha204c_sleep();
 
 	// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
 	memset(&_signing_current_nonce[MAX_PAYLOAD], 0xAA, sizeof(_signing_current_nonce)-MAX_PAYLOAD);
@@ -148,16 +151,22 @@ bool signerAtsha204SignMsg(MyMessage &msg) {
 
 	// Calculate signature of message
 	mSetSigned(msg, 1); // make sure signing flag is set before signature is calculated
+	(void)atsha204.sha204c_session_begin();
 	signerCalculateSignature(msg);
 
 	if (DO_WHITELIST(msg.destination)) {
 		// Salt the signature with the senders nodeId and the unique serial of the ATSHA device
 		memcpy(_signing_current_nonce, &_singning_rx_buffer[SHA204_BUFFER_POS_DATA], 32); // We can reuse the nonce buffer now since it is no longer needed
 		_signing_current_nonce[32] = msg.sender;
-		atsha204.getSerialNumber(&_signing_current_nonce[33]);
+		if (!_signing_serial_valid) {
+			// The serial never changes, it is read until that succeeds once
+			_signing_serial_valid = atsha204.getSerialNumber(_signing_serial) == SHA204_SUCCESS;
+		}
+		memcpy(&_signing_current_nonce[33], _signing_serial, SHA204_SERIAL_SZ);
 		(void)signerSha256(_signing_current_nonce, 32+1+SHA204_SERIAL_SZ); // we can 'void' sha256 because the hash is already put in the correct place
 		DEBUG_SIGNING_PRINTBUF(F("Signature salted with serial"), NULL, 0);
 	}
+	atsha204.sha204c_sleep();
 
 	// Overwrite the first byte in the signature with the signing identifier
 	_singning_rx_buffer[SHA204_BUFFER_POS_DATA] = SIGNING_IDENTIFIER;
@@ -187,25 +196,27 @@ bool signerAtsha204VerifyMsg(MyMessage &msg) {
 		}
 
 		DEBUG_SIGNING_PRINTBUF(F("Signature in message: "), (uint8_t*)&msg.data[mGetLength(msg)], MAX_PAYLOAD-mGetLength(msg));
+		(void)atsha204.sha204c_session_begin();
 		signerCalculateSignature(msg); // Get signature of message
 
 #ifdef MY_SIGNING_NODE_WHITELISTING
 		// Look up the senders nodeId in our whitelist and salt the signature with that data
-		size_t j;
-		for (j=0; j < NUM_OF(_signing_whitelist); j++) {
-			if (_signing_whitelist[j].nodeId == msg.sender) {
-				DEBUG_SIGNING_PRINTBUF(F("Sender found in whitelist"), NULL, 0);
-				memcpy(_signing_current_nonce, &_singning_rx_buffer[SHA204_BUFFER_POS_DATA], 32); // We can reuse the nonce buffer now since it is no longer needed
-				_signing_current_nonce[32] = msg.sender;
-				memcpy(&_signing_current_nonce[33], _signing_whitelist[j].serial, SHA204_SERIAL_SZ);
-				(void)signerSha256(_signing_current_nonce, 32+1+SHA204_SERIAL_SZ); // we can 'void' sha256 because the hash is already put in the correct place
-				break;
-			}
+		whitelist_entry_t whitelisted;
+		bool found = signerWhitelistFind(msg.sender, whitelisted);
+		if (found) {
+			DEBUG_SIGNING_PRINTBUF(F("Sender found in whitelist"), NULL, 0);
+			memcpy(_signing_current_nonce, &_singning_rx_buffer[SHA204_BUFFER_POS_DATA], 32); // We can reuse the nonce buffer now since it is no longer needed
+			_signing_current_nonce[32] = msg.sender;
+			memcpy(&_signing_current_nonce[33], whitelisted.serial, SHA204_SERIAL_SZ);
+			(void)signerSha256(_signing_current_nonce, 32+1+SHA204_SERIAL_SZ); // we can 'void' sha256 because the hash is already put in the correct place
 		}
-		if (j == NUM_OF(_signing_whitelist)) {
+		atsha204.sha204c_sleep();
+		if (!found) {
 			DEBUG_SIGNING_PRINTBUF(F("Sender not found in whitelist, message rejected!"), NULL, 0);
 			return false;
 		}
+#else
+		atsha204.sha204c_sleep();
 #endif
 
 		// Overwrite the first byte in the signature with the signing identifier
@@ -226,6 +237,7 @@ bool signerAtsha204VerifyMsg(MyMessage &msg) {
 }
 
 // Helper to calculate signature of msg (returned in _singning_rx_buffer[SHA204_BUFFER_POS_DATA])
+// The device has to be woken up by the caller and stays awake
 static void signerCalculateSignature(MyMessage &msg) {
 	memset(_signing_temp_message, 0, 32);
 	memcpy(_signing_temp_message, (uint8_t*)&msg.data[1-HEADER_SIZE], MAX_MESSAGE_LENGTH-1-(MAX_PAYLOAD-mGetLength(msg)));
@@ -251,14 +263,12 @@ static void signerCalculateSignature(MyMessage &msg) {
 	(void)atsha204.sha204m_execute(SHA204_HMAC, HMAC_MODE_SOURCE_FLAG_MATCH, 0, 0, NULL,
 									HMAC_COUNT, _singning_tx_buffer, HMAC_RSP_SIZE, _singning_rx_buffer);
 
-	// Put device back to sleep
-	atsha204.sha204c_sleep();
-
 	DEBUG_SIGNING_PRINTBUF(F("HMAC: "), &_singning_rx_buffer[SHA204_BUFFER_POS_DATA], 32);
 }
 
 // Helper to calculate a generic SHA256 digest of provided buffer (only supports one block)
 // The pointer to the hash is returned, but the hash is also stored in _singning_rx_buffer[SHA204_BUFFER_POS_DATA])
+// The device has to be woken up by the caller and stays awake
 static uint8_t* signerSha256(const uint8_t* data, size_t sz) {
 	// Initiate SHA256 calculator
 	(void)atsha204.sha204m_execute(SHA204_SHA, SHA_INIT, 0, 0, NULL,
@@ -274,9 +284,6 @@ static uint8_t* signerSha256(const uint8_t* data, size_t sz) {
 	(void)atsha204.sha204m_execute(SHA204_SHA, SHA_CALC, 0, SHA_MSG_SIZE, _signing_temp_message,
 									SHA_COUNT_LONG, _singning_tx_buffer, SHA_RSP_SIZE_LONG, _singning_rx_buffer);
 
-	// Put device back to sleep
-	atsha204.sha204c_sleep();
-
 	DEBUG_SIGNING_PRINTBUF(F("SHA256: "), &_singning_rx_buffer[SHA204_BUFFER_POS_DATA], 32);
 	return &_singning_rx_buffer[SHA204_BUFFER_POS_DATA];
 }
@@ -40,17 +40,68 @@ unsigned long _signing_timestamp;
 bool _signing_verification_ongoing = false;
 uint8_t _signing_current_nonce[NONCE_NUMIN_SIZE_PASSTHROUGH];
 uint8_t _signing_temp_message[32];
-static uint8_t _signing_hmac_key[32];
+static Sha256HmacKey _signing_hmac_key; // key pads hashed once at init
 uint8_t _signing_hmac[32];
 extern uint8_t _doWhitelist[32];
 
 static uint8_t _signing_node_serial_info[9];
-#ifdef MY_SIGNING_NODE_WHITELISTING
-	const whitelist_entry_t _signing_whitelist[] = MY_SIGNING_NODE_WHITELISTING;
-#endif
 
 static void signerCalculateSignature(MyMessage &msg);
 
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+#define SIGNING_NONCE_FREE 0xFF
+// Nonces handed out to peers, each peer has at most one outstanding nonce
+typedef struct {
+	uint8_t node;
+	bool pushed; // sent ahead of time, lives MY_SIGNING_NONCE_POOL_TIMEOUT_MS instead of MY_VERIFICATION_TIMEOUT_MS
+	unsigned long timestamp;
+	uint8_t nonce[MAX_PAYLOAD];
+} signing_issued_nonce_t;
+static signing_issued_nonce_t _signing_issued_nonces[MY_SIGNING_NONCE_POOL_SIZE];
+
+static void signerIssuedNoncePurge(signing_issued_nonce_t &entry) {
+	memset(entry.nonce, 0xAA, MAX_PAYLOAD);
+	entry.node = SIGNING_NONCE_FREE;
+}
+
+static void signerIssuedNonceStore(uint8_t node, bool pushed) {
+	signing_issued_nonce_t *entry = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		signing_issued_nonce_t &e = _signing_issued_nonces[i];
+		if (e.node == node) {
+			// a new nonce replaces the outstanding one
+			entry = &e;
+			break;
+		}
+		if (!entry || (entry->node != SIGNING_NONCE_FREE &&
+			(e.node == SIGNING_NONCE_FREE || e.timestamp - entry->timestamp > 0x7FFFFFFFul))) {
+			// remember the first free or else the oldest entry
+			entry = &e;
+		}
+	}
+	entry->node = node;
+	entry->pushed = pushed;
+	entry->timestamp = millis();
+	memcpy(entry->nonce, _signing_current_nonce, MAX_PAYLOAD);
+}
+
+static bool signerIssuedNonceTake(uint8_t node) {
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		signing_issued_nonce_t &e = _signing_issued_nonces[i];
+		if (e.node == node) {
+			memcpy(_signing_current_nonce, e.nonce, MAX_PAYLOAD);
+			memset(&_signing_current_nonce[MAX_PAYLOAD], 0xAA, sizeof(_signing_current_nonce)-MAX_PAYLOAD);
+			// single use
+			signerIssuedNoncePurge(e);
+			_signing_verification_ongoing = true;
+			_signing_timestamp = millis();
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
 #ifdef MY_DEBUG_VERBOSE_SIGNING
 static char i2h(uint8_t i)
  {
@@ -93,11 +144,28 @@ void signerAtsha204SoftInit(void) {
 	// initialize pseudo-RNG
 	randomSeed(analogRead(MY_SIGNING_SOFT_RANDOMSEED_PIN));
 	// Set secrets
-	hwReadConfigBlock((void*)_signing_hmac_key, (void*)EEPROM_SIGNING_SOFT_HMAC_KEY_ADDRESS, 32);
+	hwReadConfigBlock((void*)_signing_temp_message, (void*)EEPROM_SIGNING_SOFT_HMAC_KEY_ADDRESS, 32);
+	_signing_sha256.prepareHmacKey(_signing_hmac_key, _signing_temp_message, 32);
+	memset(_signing_temp_message, 0, 32);
 	hwReadConfigBlock((void*)_signing_node_serial_info, (void*)EEPROM_SIGNING_SOFT_SERIAL_ADDRESS, 9);
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		signerIssuedNoncePurge(_signing_issued_nonces[i]);
+	}
+#endif
 }
 
 bool signerAtsha204SoftCheckTimer(void) {
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		signing_issued_nonce_t &e = _signing_issued_nonces[i];
+		if (e.node != SIGNING_NONCE_FREE && millis() - e.timestamp >
+			(e.pushed ? MY_SIGNING_NONCE_POOL_TIMEOUT_MS : MY_VERIFICATION_TIMEOUT_MS)) {
+			DEBUG_SIGNING_PRINTBUF(F("Nonce expired"), NULL, 0);
+			signerIssuedNoncePurge(e);
+		}
+	}
+#endif
 	if (_signing_verification_ongoing) {
 		if (millis() < _signing_timestamp || millis() > _signing_timestamp + MY_VERIFICATION_TIMEOUT_MS) {
 			DEBUG_SIGNING_PRINTBUF(F("Verification timeout"), NULL, 0);
@@ -125,6 +193,10 @@ bool signerAtsha204SoftGetNonce(MyMessage &msg) {
 	// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
 	memset(&_signing_current_nonce[MAX_PAYLOAD], 0xAA, sizeof(_signing_current_nonce)-MAX_PAYLOAD);
 
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+	// Keep the nonce for the peer, msg is either its request or the nonce we push to it unasked
+	signerIssuedNonceStore(msg.sender, msg.type != I_NONCE_REQUEST);
+#endif
 	// Transfer the first part of the nonce to the message
 	msg.set(_signing_current_nonce, MAX_PAYLOAD);
 	_signing_verification_ongoing = true;
@@ -158,9 +230,9 @@ bool signerAtsha204SoftSignMsg(MyMessage &msg) {
 	if (DO_WHITELIST(msg.destination)) {
 		// Salt the signature with the senders nodeId and the (hopefully) unique serial The Creator has provided
 		_signing_sha256.init();
-		for (int i=0; i<32; i++) _signing_sha256.write(_signing_hmac[i]);
+		_signing_sha256.write(_signing_hmac, 32);
 		_signing_sha256.write(msg.sender);
-		for (int i=0; i<SHA204_SERIAL_SZ; i++) _signing_sha256.write(_signing_node_serial_info[i]);
+		_signing_sha256.write(_signing_node_serial_info, SHA204_SERIAL_SZ);
 		memcpy(_signing_hmac, _signing_sha256.result(), 32);
 		DEBUG_SIGNING_PRINTBUF(F("SHA256: "), _signing_hmac, 32);
 		DEBUG_SIGNING_PRINTBUF(F("Signature salted with serial"), NULL, 0);
@@ -177,6 +249,11 @@ bool signerAtsha204SoftSignMsg(MyMessage &msg) {
 }
 
 bool signerAtsha204SoftVerifyMsg(MyMessage &msg) {
+#ifdef MY_SIGNING_NONCE_POOL_FEATURE
+	// Verify against the nonce handed out to this sender
+	_signing_verification_ongoing = false;
+	(void)signerIssuedNonceTake(msg.sender);
+#endif
 	if (!_signing_verification_ongoing) {
 		DEBUG_SIGNING_PRINTBUF(F("No active verification session"), NULL, 0);
 		return false; 
@@ -199,23 +276,18 @@ bool signerAtsha204SoftVerifyMsg(MyMessage &msg) {
 
 #ifdef MY_SIGNING_NODE_WHITELISTING
 		// Look up the senders nodeId in our whitelist and salt the signature with that data
-		size_t j;
-		for (j=0; j < NUM_OF(_signing_whitelist); j++) {
-			if (_signing_whitelist[j].nodeId == msg.sender) {
-				DEBUG_SIGNING_PRINTBUF(F("Sender found in whitelist"), NULL, 0);
-				_signing_sha256.init();
-				for (int i=0; i<32; i++) _signing_sha256.write(_signing_hmac[i]);
-				_signing_sha256.write(msg.sender);
-				for (int i=0; i<SHA204_SERIAL_SZ; i++) _signing_sha256.write(_signing_whitelist[j].serial[i]);
-				memcpy(_signing_hmac, _signing_sha256.result(), 32);
-				DEBUG_SIGNING_PRINTBUF(F("SHA256: "), _signing_hmac, 32);
-				break;
-			}
-		}
-		if (j == NUM_OF(_signing_whitelist)) {
+		whitelist_entry_t whitelisted;
+		if (!signerWhitelistFind(msg.sender, whitelisted)) {
 			DEBUG_SIGNING_PRINTBUF(F("Sender not found in whitelist, message rejected!"), NULL, 0);
 			return false;
 		}
+		DEBUG_SIGNING_PRINTBUF(F("Sender found in whitelist"), NULL, 0);
+		_signing_sha256.init();
+		_signing_sha256.write(_signing_hmac, 32);
+		_signing_sha256.write(msg.sender);
+		_signing_sha256.write(whitelisted.serial, SHA204_SERIAL_SZ);
+		memcpy(_signing_hmac, _signing_sha256.result(), 32);
+		DEBUG_SIGNING_PRINTBUF(F("SHA256: "), _signing_hmac, 32);
 #endif
 
 		// Overwrite the first byte in the signature with the signing identifier
@@ -266,7 +338,7 @@ static void signerCalculateSignature(MyMessage &msg) {
 
 	// Calculate message digest first
 	_signing_sha256.init();
-	for (int i=0; i<32; i++) _signing_sha256.write(_signing_temp_message[i]);
+	_signing_sha256.write(_signing_temp_message, 32);
 	_signing_sha256.write(0x15); // OPCODE
 	_signing_sha256.write(0x02); // param1
 	_signing_sha256.write(0x08); // param2(1)
@@ -275,15 +347,15 @@ static void signerCalculateSignature(MyMessage &msg) {
 	_signing_sha256.write(0x01); // SN[0]
 	_signing_sha256.write(0x23); // SN[1]
 	for (int i=0; i<25; i++) _signing_sha256.write(0x00);
-	for (int i=0; i<32; i++) _signing_sha256.write(_signing_current_nonce[i]);
+	_signing_sha256.write(_signing_current_nonce, 32);
 	// Purge nonce when used
 	memset(_signing_current_nonce, 0xAA, 32);
 	memcpy(_signing_temp_message, _signing_sha256.result(), 32);
 
 	// Feed "message" to HMAC calculator
-	_signing_sha256.initHmac(_signing_hmac_key,32); // Set the key to use
+	_signing_sha256.initHmac(_signing_hmac_key); // Set the key to use
 	for (int i=0; i<32; i++) _signing_sha256.write(0x00); // 32 bytes zeroes
-	for (int i=0; i<32; i++) _signing_sha256.write(_signing_temp_message[i]); // 32 bytes digest
+	_signing_sha256.write(_signing_temp_message, 32); // 32 bytes digest
 	_signing_sha256.write(0x11); // OPCODE
 	_signing_sha256.write(0x04); // Mode
 	_signing_sha256.write(0x00); // SlotID(1)
@@ -27,9 +27,512 @@ static inline bool isValidDistance( const uint8_t distance ) {
 	return distance != DISTANCE_INVALID;
 }
 
+// Jitter source for discovery replies and backoff. Kept apart from random() so the sequence
+// used by the sketch (and the soft signing backend) is left untouched.
+static uint16_t transportRandom(uint16_t max) {
+	static uint16_t state = 0;
+	if (!state) {
+		// nodes rebooting together share their uptime but not their id
+		state = (((uint16_t)_nc.nodeId << 8) | _nc.nodeId) ^ (uint16_t)hwMillis() ^ 0xACE1u;
+		if (!state) state = 0xACE1u;
+	}
+	state ^= state << 7;
+	state ^= state >> 9;
+	state ^= state << 8;
+	return max ? state % max : 0;
+}
+
+#if defined(MY_LINK_QUALITY_FEATURE)
+	// Link costs are expected transmissions (ETX) in 1/16 units, a link without retries costs one hop
+	#define LINK_COST_HOP 16
+	// Success rate of a link where every frame was acked (steady state of the moving average below)
+	#define LINK_SUCCESS_MAX 248
+
+	typedef struct {
+		uint8_t node;
+		uint8_t success; // smoothed ACK success rate, LINK_SUCCESS_MAX = all frames acked
+	} link_quality_t;
+
+	link_quality_t _links[MY_LINK_QUALITY_NEIGHBORS];
+	uint8_t _linksNext = 0;
+	// Cost of the current parent as seen when it was selected
+	uint16_t _parentCost = 0xFFFF;
+
+	static link_quality_t *transportFindLink(uint8_t node) {
+		for (uint8_t i = 0; i < MY_LINK_QUALITY_NEIGHBORS; i++) {
+			if (_links[i].success && _links[i].node == node) {
+				return &_links[i];
+			}
+		}
+		return NULL;
+	}
+
+	void transportUpdateLink(uint8_t node, bool ok) {
+		link_quality_t *link = transportFindLink(node);
+		if (!link) {
+			// Take over the next slot but keep the entry of our parent
+			if (_links[_linksNext].success && _links[_linksNext].node == _nc.parentNodeId) {
+				_linksNext = (_linksNext + 1) % MY_LINK_QUALITY_NEIGHBORS;
+			}
+			link = &_links[_linksNext];
+			_linksNext = (_linksNext + 1) % MY_LINK_QUALITY_NEIGHBORS;
+			link->node = node;
+			link->success = LINK_SUCCESS_MAX;
+		}
+		// Moving average, the newest result weighs 1/8. Never reaches 0 (marks a free slot).
+		link->success = link->success - (link->success >> 3) + (ok ? (LINK_SUCCESS_MAX >> 3) : 0);
+		if (!link->success) {
+			link->success = 1;
+		}
+	}
+
+	uint16_t transportGetLinkCost(uint8_t node) {
+		link_quality_t *link = transportFindLink(node);
+		if (!link) {
+			// Unknown links are assumed to be good until proven otherwise
+			return LINK_COST_HOP;
+		}
+		return (uint16_t)LINK_COST_HOP * LINK_SUCCESS_MAX / link->success;
+	}
+
+	// Cost of reaching the gateway through a parent candidate that is distance hops away (incl. the
+	// hop to the candidate itself) and that we heard with rssi dBm
+	static uint16_t transportParentCost(uint8_t node, uint8_t distance, int16_t rssi) {
+		uint16_t cost = (uint16_t)(distance - 1) * LINK_COST_HOP + transportGetLinkCost(node);
+		if (rssi && rssi < MY_LINK_QUALITY_RSSI_WEAK) {
+			// Marginal signal, count it as an extra hop
+			cost += LINK_COST_HOP;
+		}
+		return cost;
+	}
+#endif
+
+#if defined(MY_PARENT_FAILOVER_FEATURE)
+	// Parents that answered, ranked by cost (MY_LINK_QUALITY_FEATURE) or distance, lower is better
+	typedef struct {
+		uint8_t node;
+		uint8_t distance; // our distance through it, 0 = free slot
+		#if defined(MY_LINK_QUALITY_FEATURE)
+			uint16_t cost;
+		#endif
+	} parent_candidate_t;
+
+	parent_candidate_t _parents[MY_PARENT_CANDIDATES];
+	// Ask for parents in the background after a failover
+	bool _parentRefresh = false;
+
+	#if defined(MY_LINK_QUALITY_FEATURE)
+		#define parentRank(__p) ((__p)->cost)
+	#else
+		#define parentRank(__p) ((__p)->distance)
+	#endif
+
+	static void transportAddParentCandidate(uint8_t node, uint8_t distance, uint16_t cost) {
+		parent_candidate_t *slot = NULL;
+		for (uint8_t i = 0; i < MY_PARENT_CANDIDATES; i++) {
+			parent_candidate_t *p = &_parents[i];
+			if (p->distance && p->node == node) {
+				slot = p;
+				break;
+			}
+			// Otherwise a free slot or the worst candidate
+			if (!slot || (slot->distance && (!p->distance || parentRank(p) > parentRank(slot)))) {
+				slot = p;
+			}
+		}
+		#if defined(MY_LINK_QUALITY_FEATURE)
+			if (slot->distance && slot->node != node && slot->cost <= cost) {
+				return;
+			}
+			slot->cost = cost;
+		#else
+			(void)cost;
+			if (slot->distance && slot->node != node && slot->distance <= distance) {
+				return;
+			}
+		#endif
+		slot->node = node;
+		slot->distance = distance;
+	}
+
+	// Switches to the best remembered parent that is not further from the gateway than the
+	// current one was, so it cannot be one of our own children
+	static bool transportParentFailover() {
+		parent_candidate_t *best = NULL;
+		for (uint8_t i = 0; i < MY_PARENT_CANDIDATES; i++) {
+			parent_candidate_t *p = &_parents[i];
+			if (p->distance && p->node == _nc.parentNodeId) {
+				p->distance = 0;
+			}
+			if (p->distance && isValidDistance(_nc.distance) && p->distance <= _nc.distance + 1 &&
+				(!best || parentRank(p) < parentRank(best))) {
+				best = p;
+			}
+		}
+		if (!best) {
+			return false;
+		}
+		_nc.parentNodeId = best->node;
+		_nc.distance = best->distance;
+		#if defined(MY_LINK_QUALITY_FEATURE)
+			_parentCost = best->cost;
+		#endif
+		hwWriteConfig(EEPROM_PARENT_NODE_ID_ADDRESS, _nc.parentNodeId);
+		hwWriteConfig(EEPROM_DISTANCE_ADDRESS, _nc.distance);
+		debug(PSTR("parent failover=%d, d=%d\n"), _nc.parentNodeId, _nc.distance);
+		_failedTransmissions = 0;
+		_parentRefresh = true;
+		return true;
+	}
+#endif
+
+// The parent seems to be gone or too bad to keep
+static void transportLostParent() {
+	#if defined(MY_PARENT_FAILOVER_FEATURE)
+		if (transportParentFailover()) {
+			return;
+		}
+	#endif
+	transportFindParentNode();
+}
+
+#if defined(MY_RF24_ATC) || defined(MY_RFM69_ATC)
+	// A cleared slot reads as node 0 at full power, the safe default for any node
+	transport_power_t _powers[MY_TRANSPORT_ATC_NODES];
+	uint8_t _powersNext = 0;
+
+	transport_power_t *transportGetPower(uint8_t node) {
+		for (uint8_t i = 0; i < MY_TRANSPORT_ATC_NODES; i++) {
+			if (_powers[i].node == node) {
+				return &_powers[i];
+			}
+		}
+		// Take over the next slot but keep the entry of our parent
+		if (_powers[_powersNext].node == _nc.parentNodeId) {
+			_powersNext = (_powersNext + 1) % MY_TRANSPORT_ATC_NODES;
+		}
+		transport_power_t *power = &_powers[_powersNext];
+		_powersNext = (_powersNext + 1) % MY_TRANSPORT_ATC_NODES;
+		power->node = node;
+		power->reduction = 0;
+		power->quiet = 0;
+		return power;
+	}
+#endif
+
+#if defined(MY_RF24_CHANNEL_SCAN)
+	static uint8_t _channelNext = 0xFF; // channel to move to, 0xFF = none
+	static unsigned long _channelHeard;
+
+	void transportMoveChannel(uint8_t channel) {
+		if (channel > 125 || _channelNext != 0xFF) {
+			return;
+		}
+		#if defined(MY_REPEATER_FEATURE)
+			// Broadcasts are not acknowledged, say it a few times for the nodes below
+			build(_msgTmp, GATEWAY_ADDRESS, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_CHANNEL, false).set(channel);
+			for (uint8_t i = 0; i < MY_RF24_CHANNEL_ANNOUNCE; i++) {
+				transportSendWrite(BROADCAST_ADDRESS, _msgTmp);
+				delay(transportRandom(20));
+			}
+		#endif
+		_channelNext = channel;
+		_channelHeard = hwMillis();
+		debug(PSTR("move to channel=%d\n"), channel);
+	}
+#endif
+
+#if defined(MY_REPEATER_FEATURE)
+	// Delay before answering a parent request. Nodes closer to the gateway answer in earlier slots.
+	static inline uint16_t transportParentResponseDelay() {
+		return min(_nc.distance, MY_PARENT_RESPONSE_MAX_SLOTS) * MY_PARENT_RESPONSE_SLOT + transportRandom(MY_PARENT_RESPONSE_SLOT);
+	}
+	#if defined(MY_PARENT_RESPONSE_SUPPRESSION)
+		uint8_t _parentResponseSeeker = AUTO;
+		bool _parentResponseSuppressed = false;
+	#endif
+#endif
+
+#if defined(MY_GATEWAY_FEATURE) && defined(MY_DEDUP_FEATURE)
+	typedef struct {
+		uint8_t sender;
+		uint8_t answered; // ACK requests of copies answered since the original
+		uint16_t hash;
+		uint16_t time; // low 16 bits of hwMillis()
+	} dedup_entry_t;
+
+	dedup_entry_t _dedup[MY_DEDUP_SIZE];
+	uint8_t _dedupNext = 0;
+
+	// Everything but 'last', which changes when the route does
+	static uint16_t dedupHash(MyMessage &message) {
+		const uint8_t *p = (const uint8_t *)&message.sender;
+		uint8_t len = HEADER_SIZE - 1 + mGetLength(message);
+		uint16_t hash = 0xFFFF;
+		while (len--) {
+			hash = (hash << 5) + hash + *p++;
+		}
+		return hash;
+	}
+
+	// Returns the cache entry if message is a copy of a recent one, else remembers it
+	static dedup_entry_t *dedupCheck(MyMessage &message) {
+		uint16_t hash = dedupHash(message);
+		uint16_t now = (uint16_t)hwMillis();
+		for (uint8_t i = 0; i < MY_DEDUP_SIZE; i++) {
+			dedup_entry_t *entry = &_dedup[i];
+			if (entry->sender == message.sender && entry->hash == hash &&
+				(uint16_t)(now - entry->time) < MY_DEDUP_WINDOW_MS) {
+				return entry;
+			}
+		}
+		dedup_entry_t *entry = &_dedup[_dedupNext];
+		_dedupNext = (_dedupNext + 1) % MY_DEDUP_SIZE;
+		entry->sender = message.sender;
+		entry->hash = hash;
+		entry->time = now;
+		entry->answered = 0;
+		return NULL;
+	}
+#endif
+
+#if defined(MY_RAM_ROUTING_TABLE_FEATURE)
+	unsigned long _routesLastSave = 0;
+	bool _routesDirty = false;
+	#if MY_RAM_ROUTING_TABLE_SIZE >= 256
+		// Complete mirror of the EEPROM routing table
+		uint8_t _routes[256];
+		uint8_t _routesDirtyMask[256/8];
+		bool _routesLoaded = false;
+
+		static void routesLoad() {
+			if (!_routesLoaded) {
+				hwReadConfigBlock((void*)_routes, (void*)EEPROM_ROUTES_ADDRESS, 256);
+				memset(_routesDirtyMask, 0, sizeof(_routesDirtyMask));
+				_routesLoaded = true;
+			}
+		}
+
+		uint8_t transportGetRoute(uint8_t node) {
+			routesLoad();
+			return _routes[node];
+		}
+
+		void transportSetRoute(uint8_t node, uint8_t route) {
+			routesLoad();
+			if (_routes[node] != route) {
+				_routes[node] = route;
+				_routesDirtyMask[node >> 3] |= (1 << (node & 0x07));
+				_routesDirty = true;
+			}
+		}
+
+		void transportSaveRoutingTable() {
+			if (_routesDirty) {
+				uint8_t i = 255;
+				do {
+					if (_routesDirtyMask[i >> 3] & (1 << (i & 0x07))) {
+						hwWriteConfig(EEPROM_ROUTES_ADDRESS+i, _routes[i]);
+					}
+				} while (i--);
+				memset(_routesDirtyMask, 0, sizeof(_routesDirtyMask));
+				_routesDirty = false;
+			}
+			_routesLastSave = hwMillis();
+		}
+
+		void transportClearRoutingTable() {
+			memset(_routes, BROADCAST_ADDRESS, sizeof(_routes));
+			memset(_routesDirtyMask, 0xFF, sizeof(_routesDirtyMask));
+			_routesLoaded = true;
+			_routesDirty = true;
+			transportSaveRoutingTable();
+		}
+	#else
+		// Least recently used subset of the routing table, most recent entry first
+		struct RouteCacheEntry {
+			uint8_t node;
+			uint8_t route;
+			bool dirty;
+		};
+		RouteCacheEntry _routeCache[MY_RAM_ROUTING_TABLE_SIZE];
+		uint8_t _routeCacheCount = 0;
+
+		// Moves entry to the front of the cache (or inserts a new one there, evicting the oldest)
+		static RouteCacheEntry* routeCacheFetch(uint8_t node) {
+			uint8_t i = 0;
+			while (i < _routeCacheCount && _routeCache[i].node != node) i++;
+			RouteCacheEntry entry;
+			if (i < _routeCacheCount) {
+				entry = _routeCache[i];
+			} else {
+				if (_routeCacheCount < MY_RAM_ROUTING_TABLE_SIZE) {
+					i = _routeCacheCount++;
+				} else {
+					i = MY_RAM_ROUTING_TABLE_SIZE-1;
+					if (_routeCache[i].dirty) {
+						hwWriteConfig(EEPROM_ROUTES_ADDRESS+_routeCache[i].node, _routeCache[i].route);
+					}
+				}
+				entry.node = node;
+				entry.route = hwReadConfig(EEPROM_ROUTES_ADDRESS+node);
+				entry.dirty = false;
+			}
+			memmove(&_routeCache[1], &_routeCache[0], i * sizeof(RouteCacheEntry));
+			_routeCache[0] = entry;
+			return &_routeCache[0];
+		}
+
+		uint8_t transportGetRoute(uint8_t node) {
+			return routeCacheFetch(node)->route;
+		}
+
+		void transportSetRoute(uint8_t node, uint8_t route) {
+			RouteCacheEntry* entry = routeCacheFetch(node);
+			if (entry->route != route) {
+				entry->route = route;
+				entry->dirty = true;
+				_routesDirty = true;
+			}
+		}
+
+		void transportSaveRoutingTable() {
+			if (_routesDirty) {
+				for (uint8_t i = 0; i < _routeCacheCount; i++) {
+					if (_routeCache[i].dirty) {
+						hwWriteConfig(EEPROM_ROUTES_ADDRESS+_routeCache[i].node, _routeCache[i].route);
+						_routeCache[i].dirty = false;
+					}
+				}
+				_routesDirty = false;
+			}
+			_routesLastSave = hwMillis();
+		}
+
+		void transportClearRoutingTable() {
+			_routeCacheCount = 0;
+			_routesDirty = false;
+			uint8_t i = 255;
+			do {
+				hwWriteConfig(EEPROM_ROUTES_ADDRESS+i, BROADCAST_ADDRESS);
+			} while (i--);
+			_routesLastSave = hwMillis();
+		}
+	#endif
+#else
+	uint8_t transportGetRoute(uint8_t node) {
+		return hwReadConfig(EEPROM_ROUTES_ADDRESS+node);
+	}
+
+	void transportSetRoute(uint8_t node, uint8_t route) {
+		hwWriteConfig(EEPROM_ROUTES_ADDRESS+node, route);
+	}
+
+	void transportSaveRoutingTable() {
+		// Routes are written to EEPROM directly
+	}
+
+	void transportClearRoutingTable() {
+		uint8_t i = 255;
+		do {
+			hwWriteConfig(EEPROM_ROUTES_ADDRESS+i, BROADCAST_ADDRESS);
+		} while (i--);
+	}
+#endif
+
+// Counts failed sends to the parent and starts looking for a new one when it seems to be gone
+static void transportParentResult(bool ok) {
+	if (!ok) {
+		// Failure when sending to parent node. The parent node might be down and we
+		// need to find another route to gateway.
+		ledBlinkErr(1);
+		_failedTransmissions++;
+		if (_autoFindParent && _failedTransmissions > SEARCH_FAILURES) {
+			transportLostParent();
+		}
+		#if defined(MY_LINK_QUALITY_FEATURE)
+		else if (_autoFindParent && _failedTransmissions > 1 &&
+			transportGetLinkCost(_nc.parentNodeId) > MY_LINK_QUALITY_MAX_ETX * LINK_COST_HOP) {
+			// Link to parent has become marginal, look for a better one
+			transportLostParent();
+		}
+		#endif
+	} else {
+		_failedTransmissions = 0;
+	}
+}
+
+#if defined(MY_REPEATER_FEATURE)
+	// Send downstream to route, the child (or the repeater in front of it)
+	static bool transportSendChild(uint8_t route, MyMessage &message) {
+		#if defined(MY_MAILBOX_FEATURE)
+			bool ok = transportSendWrite(route, message);
+			if (!ok) {
+				// Probably asleep, hand it over when the node is heard from again
+				transportMailboxStore(message);
+			}
+			return ok;
+		#else
+			return transportSendWrite(route, message);
+		#endif
+	}
+
+	// Relays a frame addressed to another node as received: version and signature are the
+	// original sender's, so only the next hop is looked up and 'last' rewritten (by
+	// transportSendWrite()). Skips the checks transportSendRoute() does for our own messages.
+	static void transportForward(MyMessage &message, uint8_t last) {
+		uint8_t dest = message.destination;
+		if (dest != GATEWAY_ADDRESS) {
+			if (dest == BROADCAST_ADDRESS) {
+				if (message.sender == GATEWAY_ADDRESS) {
+					// Id response for a node that has no id yet
+					transportSendWrite(BROADCAST_ADDRESS, message);
+				}
+				return;
+			}
+			uint8_t route = transportGetRoute(dest);
+			if (route > GATEWAY_ADDRESS && route < BROADCAST_ADDRESS) {
+				transportSendChild(route, message);
+				return;
+			}
+			#if defined(MY_GATEWAY_FEATURE)
+				debug(PSTR("Destination %d unknown\n"), dest);
+				return;
+			#endif
+		}
+		if (_nc.parentNodeId == AUTO) {
+			// Nowhere to send it, transportSendRoute() starts the search on our next own message
+			return;
+		}
+		// Towards the gateway, remember where the sender can be reached
+		transportSetRoute(message.sender, last);
+		transportParentResult(transportSendWrite(_nc.parentNodeId, message));
+	}
+#endif
 
 inline void transportProcess() {
 	uint8_t to = 0;
+	#if defined(MY_RAM_ROUTING_TABLE_FEATURE)
+		// Lazy write-back of changed routes
+		if (_routesDirty && hwMillis() - _routesLastSave > MY_RAM_ROUTING_TABLE_SAVE_INTERVAL_MS) {
+			transportSaveRoutingTable();
+		}
+	#endif
+	#if defined(MY_RF24_CHANNEL_SCAN)
+		if (_channelNext != 0xFF && hwMillis() - _channelHeard >= MY_RF24_CHANNEL_DELAY) {
+			transportSetChannel(_channelNext);
+			hwWriteConfig(EEPROM_RF24_CHANNEL_ADDRESS, _channelNext);
+			debug(PSTR("channel=%d\n"), _channelNext);
+			_channelNext = 0xFF;
+		}
+	#endif
+	#if defined(MY_PARENT_FAILOVER_FEATURE)
+		if (_parentRefresh) {
+			// Replies from better parents than the one we switched to are taken as they come in
+			_parentRefresh = false;
+			transportSendWrite(BROADCAST_ADDRESS, build(_msgTmp, _nc.nodeId, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_FIND_PARENT, false).set(""));
+		}
+	#endif
 	if (!transportAvailable(&to))
 	{
 		#ifdef MY_OTA_FIRMWARE_FEATURE
@@ -43,6 +546,9 @@ inline void transportProcess() {
 	uint8_t payloadLength = transportReceive((uint8_t *)&_msg);
 	(void)payloadLength; //until somebody makes use of it
 	ledBlinkRx(1);
+	#if defined(MY_STATS_FEATURE)
+		_statsCount(_stats.rx);
+	#endif
 
 	
 	uint8_t command = mGetCommand(_msg);
@@ -53,7 +559,14 @@ inline void transportProcess() {
 	
 
 	// Reject massages that do not pass verification
-	if (!signerVerifyMsg(_msg)) {
+	#if defined(MY_STATS_FEATURE)
+		unsigned long verifyStart = hwMicros();
+		bool verified = signerVerifyMsg(_msg);
+		_statsSignTime(verifyStart);
+	#else
+		bool verified = signerVerifyMsg(_msg);
+	#endif
+	if (!verified) {
 		debug(PSTR("verify fail\n"));
 		ledBlinkErr(1);
 		return;	
@@ -80,6 +593,11 @@ inline void transportProcess() {
 		return;
 	}
 
+	#if defined(MY_MAILBOX_FEATURE)
+		// The sender is awake right now, deliver what it missed while sleeping
+		transportMailboxFlush(sender);
+	#endif
+
 	if (destination == _nc.nodeId) {
 		// This message is addressed to this node
 		// prevent buffer overflow by limiting max. possible message length (5 bits=31 bytes max) to MAX_PAYLOAD (25 bytes)
@@ -90,7 +608,25 @@ inline void transportProcess() {
 		#if defined(MY_REPEATER_FEATURE)
 			if (_msg.last != _nc.parentNodeId) {
 				// Message is from one of the child nodes. Add it to routing table.
-				hwWriteConfig(EEPROM_ROUTES_ADDRESS+sender, _msg.last);
+				transportSetRoute(sender, _msg.last);
+			}
+		#endif
+
+		#if defined(MY_GATEWAY_FEATURE) && defined(MY_DEDUP_FEATURE)
+			dedup_entry_t *copy = dedupCheck(_msg);
+			if (copy) {
+				// Already handed to the controller. The node may have missed our ACK echo, repeat it once.
+				if (mGetRequestAck(_msg) && !copy->answered) {
+					copy->answered = 1;
+					_msgTmp = _msg;
+					mSetRequestAck(_msgTmp,false);
+					mSetAck(_msgTmp,true);
+					_msgTmp.sender = _nc.nodeId;
+					_msgTmp.destination = sender;
+					_sendRoute(_msgTmp);
+				}
+				debug(PSTR("dup from %d dropped\n"), sender);
+				return;
 			}
 		#endif
 
@@ -119,8 +655,25 @@ inline void transportProcess() {
 					{
 						// Distance to gateway is one more for us w.r.t. parent
 						distance++;
-						if (isValidDistance(distance) && (distance < _nc.distance)) {
+						#if defined(MY_LINK_QUALITY_FEATURE)
+							// Weigh the hop count with the quality of the link to the candidate
+							uint16_t cost = transportParentCost(sender, distance, transportGetReceivingRSSI());
+							bool better = cost < _parentCost;
+						#else
+							bool better = distance < _nc.distance;
+						#endif
+						#if defined(MY_PARENT_FAILOVER_FEATURE)
+							#if defined(MY_LINK_QUALITY_FEATURE)
+								transportAddParentCandidate(sender, distance, cost);
+							#else
+								transportAddParentCandidate(sender, distance, 0);
+							#endif
+						#endif
+						if (isValidDistance(distance) && better) {
 							// Found a neighbor closer to GW than previously found
+							#if defined(MY_LINK_QUALITY_FEATURE)
+								_parentCost = cost;
+							#endif
 							_nc.distance = distance;
 							_nc.parentNodeId = sender;
 							hwWriteConfig(EEPROM_PARENT_NODE_ID_ADDRESS, _nc.parentNodeId);
@@ -130,7 +683,38 @@ inline void transportProcess() {
 					}
 				}
 				return;
-			} else if (sender == GATEWAY_ADDRESS) {
+			}
+			#if defined(MY_GATEWAY_FEATURE)
+			else if (type == I_PRESENTATION_BATCH) {
+				// Expand into one presentation per child for the controller
+				uint8_t length = mGetLength(_msg);
+				for (uint8_t i = 0; i + 1 < length; i += 2) {
+					gatewayTransportSend(build(_msgTmp, sender, GATEWAY_ADDRESS, _msg.data[i],
+						C_PRESENTATION, _msg.data[i+1], false).set(""));
+				}
+				return;
+			}
+			else if (type == I_AGGREGATE) {
+				// Expand into one message per value for the controller
+				uint8_t length = mGetLength(_msg);
+				uint8_t i = 0;
+				while (i + 3 <= length) {
+					uint8_t valueLength = _msg.data[i+2] >> 3;
+					if (i + 3 + valueLength > length) {
+						break;
+					}
+					build(_msgTmp, sender, GATEWAY_ADDRESS, _msg.data[i], C_SET, _msg.data[i+1], false);
+					mSetPayloadType(_msgTmp, _msg.data[i+2] & 0x07);
+					mSetLength(_msgTmp, valueLength);
+					memcpy(_msgTmp.data, &_msg.data[i+3], valueLength);
+					_msgTmp.data[valueLength] = 0;
+					gatewayTransportSend(_msgTmp);
+					i += 3 + valueLength;
+				}
+				return;
+			}
+			#endif
+			else if (sender == GATEWAY_ADDRESS) {
 				if (type == I_ID_RESPONSE) {
 					_nc.nodeId = _msg.getByte();
 					if (_nc.nodeId == AUTO) {
@@ -141,8 +725,7 @@ inline void transportProcess() {
 						
 					}
 					transportPresentNode();
-					if (presentation)
-						presentation();
+					_presentation();
 					// Write id to EEPROM
 					hwWriteConfig(EEPROM_NODE_ID_ADDRESS, _nc.nodeId);
 					debug(PSTR("id=%d\n"), _nc.nodeId);
@@ -173,7 +756,7 @@ inline void transportProcess() {
 				// only process if received from parent
 				debug(PSTR("discovery signal\n"));
 				// random wait to minimize collisions
-				wait(hwMillis() & 0x3ff);
+				wait(transportRandom(1024));
 				_sendRoute(build(_msgTmp, _nc.nodeId, sender, NODE_SENSOR_ID, C_INTERNAL, I_DISCOVER_RESPONSE, false).set(_nc.parentNodeId));
 				// repeat bc signal
 				#if defined(MY_REPEATER_FEATURE)
@@ -183,6 +766,24 @@ inline void transportProcess() {
 				#endif
 				return;
 			}
+			#if defined(MY_RF24_CHANNEL_SCAN)
+			if (type == I_CHANNEL && sender == GATEWAY_ADDRESS && last == _nc.parentNodeId) {
+				// The network moves, copies repeated by the gateway and other repeaters are dropped
+				transportMoveChannel(_msg.getByte());
+				return;
+			}
+			#endif
+		} else if (command == C_STREAM && type == ST_FIRMWARE_RESPONSE && last == _nc.parentNodeId) {
+			// Firmware block streamed to many nodes, only taken from the parent so copies
+			// repeated by other nodes are not seen twice
+			#if defined(MY_REPEATER_FEATURE)
+				// pass it on to the nodes below first, storing it may take a while
+				_sendRoute(_msg);
+			#endif
+			#if defined(MY_OTA_BROADCAST_FEATURE)
+				firmwareOTAUpdateProcess();
+			#endif
+			return;
 		}
 	}
 	#if defined(MY_REPEATER_FEATURE)
@@ -195,15 +796,38 @@ inline void transportProcess() {
 
 					if (_nc.distance != DISTANCE_INVALID) {
 						// Relaying nodes should always answer ping messages
-						// Wait a random delay of 0-2 seconds to minimize collision
-						// between ping ack messages from other relaying nodes
-						wait(hwMillis() & 0x3ff);
-						transportSendWrite(sender, build(_msg, _nc.nodeId, sender, NODE_SENSOR_ID, C_INTERNAL, I_FIND_PARENT_RESPONSE, false).set(_nc.distance));
+						// Wait for our slot to minimize collision between ping ack
+						// messages from other relaying nodes
+						#if defined(MY_PARENT_RESPONSE_SUPPRESSION)
+							_parentResponseSeeker = sender;
+							_parentResponseSuppressed = false;
+							wait(transportParentResponseDelay());
+							_parentResponseSeeker = AUTO;
+							if (_parentResponseSuppressed) {
+								// an equal or better parent already answered
+								return;
+							}
+							// Answer on the broadcast pipe so other repeaters can hear it
+							transportSendWrite(BROADCAST_ADDRESS, build(_msg, _nc.nodeId, sender, NODE_SENSOR_ID, C_INTERNAL, I_FIND_PARENT_RESPONSE, false).set(_nc.distance));
+						#else
+							wait(transportParentResponseDelay());
+							transportSendWrite(sender, build(_msg, _nc.nodeId, sender, NODE_SENSOR_ID, C_INTERNAL, I_FIND_PARENT_RESPONSE, false).set(_nc.distance));
+						#endif
 					}
 				}
+			#if defined(MY_PARENT_RESPONSE_SUPPRESSION)
+			} else if (command == C_INTERNAL && type == I_FIND_PARENT_RESPONSE && to == BROADCAST_ADDRESS) {
+				// Overheard another repeater answering the node we are about to answer
+				if (destination == _parentResponseSeeker && _msg.getByte() <= _nc.distance) {
+					_parentResponseSuppressed = true;
+				}
+			#endif
 			} else if (to == _nc.nodeId) {
 				// We should try to relay this message to another node
-				_sendRoute(_msg);
+				#if defined(MY_STATS_FEATURE)
+					_statsCount(_stats.forwarded);
+				#endif
+				transportForward(_msg, last);
 			}
 		}
 	#endif
@@ -216,7 +840,22 @@ boolean transportSendWrite(uint8_t to, MyMessage &message) {
 	message.last = _nc.nodeId;
 	ledBlinkTx(1);
 
+	#if defined(MY_STATS_FEATURE)
+		unsigned long sendStart = hwMicros();
+	#endif
 	bool ok = transportSend(to, &message, min(MAX_MESSAGE_LENGTH, HEADER_SIZE + length));
+	#if defined(MY_STATS_FEATURE)
+		_statsSendTime(sendStart);
+		_statsCount(_stats.tx);
+		if (!ok && to != BROADCAST_ADDRESS) {
+			_statsCount(_stats.txFailed);
+		}
+	#endif
+	#if defined(MY_LINK_QUALITY_FEATURE)
+		if (to != BROADCAST_ADDRESS) {
+			transportUpdateLink(to, ok);
+		}
+	#endif
 
 	debug(PSTR("send: %d-%d-%d-%d s=%d,c=%d,t=%d,pt=%d,l=%d,sg=%d,st=%s:%s\n"),
 			message.sender,message.last, to, message.destination, message.sensor, mGetCommand(message), message.type,
@@ -248,10 +887,16 @@ boolean transportSendRoute(MyMessage &message) {
 
 	mSetVersion(message, PROTOCOL_VERSION);
 
+	#if defined(MY_STATS_FEATURE)
+		unsigned long signStart = hwMicros();
+	#endif
 	if (!signerSignMsg(message)) {
 		debug(PSTR("sign fail\n"));
 		ledBlinkErr(1);
 	}
+	#if defined(MY_STATS_FEATURE)
+		_statsSignTime(signStart);
+	#endif
 
 	#if !defined(MY_REPEATER_FEATURE)
 
@@ -262,7 +907,7 @@ boolean transportSendRoute(MyMessage &message) {
 		uint8_t dest = message.destination;
 		if (dest == GATEWAY_ADDRESS) {
 			// Store this address in routing table (if repeater)
-			hwWriteConfig(EEPROM_ROUTES_ADDRESS+sender, last);
+			transportSetRoute(sender, last);
 			// If destination is the gateway or if we aren't a repeater, let
 			// our parent take care of the message
 			ok = transportSendWrite(_nc.parentNodeId, message);
@@ -271,7 +916,7 @@ boolean transportSendRoute(MyMessage &message) {
 			uint8_t route;
 			// INTERMEDIATE FIX: make sure corrupted routing table is not interfering with BC - observed several cases -tekka
 			if (dest!=BROADCAST_ADDRESS) {
-				route = hwReadConfig(EEPROM_ROUTES_ADDRESS+dest);
+				route = transportGetRoute(dest);
 			} else route = BROADCAST_ADDRESS;
 			if (route > GATEWAY_ADDRESS && route < BROADCAST_ADDRESS) {
 				// This message should be forwarded to a child node. If we send message
@@ -286,7 +931,7 @@ boolean transportSendRoute(MyMessage &message) {
 				//
 				// Message destination is not gateway and is in routing table for this node.
 				// Send it downstream
-				return transportSendWrite(route, message);
+				return transportSendChild(route, message);
 			} else if (sender == GATEWAY_ADDRESS && dest == BROADCAST_ADDRESS) {
 				// Node has not yet received any id. We need to send it
 				// by doing a broadcast sending,
@@ -313,24 +958,13 @@ boolean transportSendRoute(MyMessage &message) {
 				ok = transportSendWrite(_nc.parentNodeId, message);
 
 				// Add this child to our "routing table" if it not already exist
-				hwWriteConfig(EEPROM_ROUTES_ADDRESS+sender, last);
+				transportSetRoute(sender, last);
 
 			#endif
 		}
 	#endif
 
-	if (!ok) {
-		// Failure when sending to parent node. The parent node might be down and we
-		// need to find another route to gateway.
-		ledBlinkErr(1);
-		_failedTransmissions++;
-		if (_autoFindParent && _failedTransmissions > SEARCH_FAILURES) {
-			transportFindParentNode();
-		}
-	} else {
-		_failedTransmissions = 0;
-	}
-
+	transportParentResult(ok);
 	return ok;
 }
 
@@ -373,6 +1007,10 @@ void transportPresentNode() {
 			// which is picked up in process()
 			_sendRoute(build(_msg, _nc.nodeId, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_CONFIG, false).set(_nc.parentNodeId));
 
+			#if defined(MY_FAST_BOOT_FEATURE)
+				// Configuration of last start is still valid, process() picks up the reply whenever it arrives
+				if (hwReadConfig(EEPROM_CONTROLLER_CONFIG_ADDRESS) == 0xFF)
+			#endif
 			// Wait configuration reply.
 			wait(2000, C_INTERNAL, I_CONFIG);
 		}
@@ -381,15 +1019,34 @@ void transportPresentNode() {
 
 void transportFindParentNode() {
 	static boolean findingParentNode = false;
+	static uint8_t findParentFailures = 0;
+	static unsigned long findParentBackoff = 0;
+	static unsigned long lastFindParent = 0;
+	#if defined(MY_RF24_CHANNEL_SCAN)
+		static unsigned long parentLostSince = 0;
+		static uint8_t hopChannel = 0xFF;
+	#endif
 
 	if (findingParentNode)
 		return;
+	if (findParentFailures && hwMillis() - lastFindParent < findParentBackoff) {
+		// Back off after unsuccessful searches (keeps a whole network from searching in lockstep)
+		return;
+	}
 	findingParentNode = true;
 
 	_failedTransmissions = 0;
 
 	// Set distance to max
 	_nc.distance = 255;
+	#if defined(MY_LINK_QUALITY_FEATURE)
+		_parentCost = 0xFFFF;
+	#endif
+	#if defined(MY_PARENT_FAILOVER_FEATURE)
+		// Collect the candidates afresh
+		memset(_parents, 0, sizeof(_parents));
+		_parentRefresh = false;
+	#endif
 
 	// Send ping message to BROADCAST_ADDRESS (to which all relaying nodes and gateway listens and should reply to)
 	debug(PSTR("find parent\n"));
@@ -398,7 +1055,197 @@ void transportFindParentNode() {
 	// Write msg, but suppress recursive parent search
 	transportSendWrite(BROADCAST_ADDRESS, _msg);
 
-	// Wait for ping response.
-	wait(2000);
+	// Wait for ping responses. Stop when the gateway itself answered or when no better
+	// parent has shown up for one response slot.
+	unsigned long enter = hwMillis();
+	unsigned long lastImprovement = 0;
+	uint8_t bestDistance = DISTANCE_INVALID;
+	uint8_t bestParent = _nc.parentNodeId;
+	while (hwMillis() - enter < MY_PARENT_DISCOVERY_TIMEOUT) {
+		_process();
+		#if defined(MY_GATEWAY_ESP8266)
+			yield();
+		#endif
+		if (_nc.distance != bestDistance || _nc.parentNodeId != bestParent) {
+			bestDistance = _nc.distance;
+			bestParent = _nc.parentNodeId;
+			lastImprovement = hwMillis();
+		}
+		#if defined(MY_LINK_QUALITY_FEATURE)
+			// A direct link to the gateway without retries cannot be beaten
+			bool ideal = _parentCost <= LINK_COST_HOP;
+		#else
+			bool ideal = bestDistance <= 1;
+		#endif
+		if (isValidDistance(bestDistance) &&
+			(ideal || hwMillis() - lastImprovement >= MY_PARENT_RESPONSE_SLOT)) {
+			break;
+		}
+	}
+
+	lastFindParent = hwMillis();
+	if (isValidDistance(_nc.distance)) {
+		findParentFailures = 0;
+		#if defined(MY_RF24_CHANNEL_SCAN)
+			hwWriteConfig(EEPROM_RF24_CHANNEL_ADDRESS, transportGetChannel());
+		#endif
+	} else {
+		#if defined(MY_RF24_CHANNEL_SCAN)
+			if (!findParentFailures) {
+				parentLostSince = lastFindParent;
+			}
+			uint8_t storedChannel = hwReadConfig(EEPROM_RF24_CHANNEL_ADDRESS);
+			if (storedChannel > 125) {
+				storedChannel = MY_RF24_CHANNEL;
+			}
+			if (transportGetChannel() != storedChannel) {
+				// Every other search goes back to the channel the network was last seen on
+				transportSetChannel(storedChannel);
+				debug(PSTR("try channel=%d\n"), storedChannel);
+			} else if (lastFindParent - parentLostSince >= MY_RF24_CHANNEL_HOP_AFTER) {
+				// The network may have moved while we did not listen, look on the next channel
+				do {
+					hopChannel = hopChannel < MY_RF24_SCAN_FIRST || hopChannel >= MY_RF24_SCAN_LAST ? MY_RF24_SCAN_FIRST : hopChannel + 1;
+				} while (hopChannel == storedChannel && MY_RF24_SCAN_FIRST != MY_RF24_SCAN_LAST);
+				transportSetChannel(hopChannel);
+				debug(PSTR("try channel=%d\n"), hopChannel);
+			}
+		#endif
+		// Randomized exponential backoff before the next search
+		if (findParentFailures < 8) {
+			findParentFailures++;
+		}
+		findParentBackoff = min((unsigned long)MY_PARENT_DISCOVERY_BACKOFF_MIN << (findParentFailures - 1), MY_PARENT_DISCOVERY_BACKOFF_MAX);
+		findParentBackoff = findParentBackoff / 2 + (findParentBackoff / 2) * transportRandom(256) / 256;
+		debug(PSTR("no parent, retry in %lu ms\n"), findParentBackoff);
+	}
 	findingParentNode = false;
 }
+
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+MyMessage _txQueue[MY_TRANSPORT_TX_QUEUE_SIZE];
+uint8_t _txQueuePriority[MY_TRANSPORT_TX_QUEUE_SIZE];
+uint8_t _txQueueHead = 0;
+uint8_t _txQueueCount = 0;
+
+#define txQueueSlot(__i) ((_txQueueHead + (__i)) % MY_TRANSPORT_TX_QUEUE_SIZE)
+
+// Removes entry i (counted from the head), later entries move up
+static void txQueueRemove(uint8_t i) {
+	for (_txQueueCount--; i < _txQueueCount; i++) {
+		_txQueue[txQueueSlot(i)] = _txQueue[txQueueSlot(i + 1)];
+		_txQueuePriority[txQueueSlot(i)] = _txQueuePriority[txQueueSlot(i + 1)];
+	}
+}
+
+static inline bool isCoalescable( const MyMessage &a, const MyMessage &b ) {
+	return a.destination == b.destination && a.sensor == b.sensor && a.type == b.type &&
+		mGetCommand(a) == mGetCommand(b) && mGetCommand(a) == C_SET &&
+		!mGetRequestAck(a) && !mGetRequestAck(b);
+}
+
+bool transportQueueSend(MyMessage &message, uint8_t priority) {
+	// A newer value for the same child and type replaces the one still waiting in queue
+	for (uint8_t i = 0; i < _txQueueCount; i++) {
+		MyMessage &queued = _txQueue[txQueueSlot(i)];
+		if (isCoalescable(queued, message)) {
+			if (_txQueuePriority[txQueueSlot(i)] >= priority) {
+				queued = message;
+				return true;
+			}
+			// More urgent now, queue it again at its new place
+			txQueueRemove(i);
+			break;
+		}
+	}
+	if (_txQueueCount == MY_TRANSPORT_TX_QUEUE_SIZE) {
+		// Shed the oldest low priority message for a more important one
+		uint8_t i = 0;
+		while (i < _txQueueCount && _txQueuePriority[txQueueSlot(i)] != PRIORITY_LOW) i++;
+		if (priority == PRIORITY_LOW || i == _txQueueCount) {
+			debug(PSTR("tx queue full\n"));
+			return false;
+		}
+		txQueueRemove(i);
+	}
+	// Behind entries of the same or higher priority, ahead of the rest
+	uint8_t pos = 0;
+	while (pos < _txQueueCount && _txQueuePriority[txQueueSlot(pos)] >= priority) pos++;
+	for (uint8_t i = _txQueueCount; i > pos; i--) {
+		_txQueue[txQueueSlot(i)] = _txQueue[txQueueSlot(i - 1)];
+		_txQueuePriority[txQueueSlot(i)] = _txQueuePriority[txQueueSlot(i - 1)];
+	}
+	_txQueue[txQueueSlot(pos)] = message;
+	_txQueuePriority[txQueueSlot(pos)] = priority;
+	_txQueueCount++;
+	return true;
+}
+
+void transportQueueProcess() {
+	if (_txQueueCount == 0)
+		return;
+	// Copy out before sending, sending may re-enter process() (e.g. parent search)
+	MyMessage message = _txQueue[_txQueueHead];
+	uint8_t priority = _txQueuePriority[_txQueueHead];
+	_txQueueHead = (_txQueueHead + 1) % MY_TRANSPORT_TX_QUEUE_SIZE;
+	_txQueueCount--;
+	(void)_sendRoute(message, priority);
+}
+
+void transportQueueFlush() {
+	while (_txQueueCount) {
+		transportQueueProcess();
+	}
+}
+
+uint8_t transportQueueCount() {
+	return _txQueueCount;
+}
+#endif
+
+#if defined(MY_MAILBOX_FEATURE)
+// Oldest message first
+MyMessage _mailbox[MY_MAILBOX_SIZE];
+uint8_t _mailboxCount = 0;
+
+static void transportMailboxRemove(uint8_t i) {
+	_mailboxCount--;
+	memmove(&_mailbox[i], &_mailbox[i+1], (_mailboxCount - i) * sizeof(MyMessage));
+}
+
+void transportMailboxStore(MyMessage &message) {
+	if (mGetSigned(message) || mGetAck(message) || message.destination == BROADCAST_ADDRESS) {
+		return;
+	}
+	for (uint8_t i = 0; i < _mailboxCount; i++) {
+		MyMessage &kept = _mailbox[i];
+		if (kept.destination == message.destination && kept.sensor == message.sensor &&
+			kept.type == message.type && mGetCommand(kept) == mGetCommand(message) && mGetCommand(kept) == C_SET) {
+			// Only the latest value matters, keep the position of the older one
+			kept = message;
+			return;
+		}
+	}
+	if (_mailboxCount == MY_MAILBOX_SIZE) {
+		debug(PSTR("mailbox full, drop msg for %d\n"), _mailbox[0].destination);
+		transportMailboxRemove(0);
+	}
+	_mailbox[_mailboxCount++] = message;
+}
+
+void transportMailboxFlush(uint8_t node) {
+	uint8_t i = 0;
+	while (i < _mailboxCount) {
+		if (_mailbox[i].destination != node) {
+			i++;
+			continue;
+		}
+		uint8_t route = transportGetRoute(node);
+		if (route > GATEWAY_ADDRESS && route < BROADCAST_ADDRESS && !transportSendWrite(route, _mailbox[i])) {
+			// Gone back to sleep, keep the rest for the next wake-up
+			return;
+		}
+		transportMailboxRemove(i);
+	}
+}
+#endif
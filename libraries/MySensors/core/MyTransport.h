@@ -47,6 +47,46 @@ void transportFindParentNode();
 boolean transportSendRoute(MyMessage &message);
 boolean transportSendWrite(uint8_t to, MyMessage &message);
 
+// Routing table access (goes through the RAM cache if MY_RAM_ROUTING_TABLE_FEATURE is enabled)
+uint8_t transportGetRoute(uint8_t node);
+void transportSetRoute(uint8_t node, uint8_t route);
+void transportClearRoutingTable();
+void transportSaveRoutingTable();
+
+// Link quality estimation (MY_LINK_QUALITY_FEATURE)
+void transportUpdateLink(uint8_t node, bool ok);
+uint16_t transportGetLinkCost(uint8_t node);
+
+// Transmit power per destination (MY_RF24_ATC, MY_RFM69_ATC)
+typedef struct {
+	uint8_t node;
+	uint8_t reduction; // power steps below full power, 0 = full power
+	uint8_t quiet; // frames in a row that got through without retransmission
+} transport_power_t;
+transport_power_t *transportGetPower(uint8_t node);
+
+// Outgoing message queue (MY_TRANSPORT_TX_QUEUE_FEATURE)
+bool transportQueueSend(MyMessage &message, uint8_t priority);
+void transportQueueProcess();
+void transportQueueFlush();
+uint8_t transportQueueCount();
+
+// Messages for sleeping children (MY_MAILBOX_FEATURE)
+void transportMailboxStore(MyMessage &message);
+void transportMailboxFlush(uint8_t node);
+
+// Airtime in us sent within the duty cycle window (MY_RFM69_DUTY_CYCLE)
+uint32_t transportGetAirtime();
+
+#if defined(MY_RF24_CHANNEL_SCAN)
+	// Announces the channel and moves there after MY_RF24_CHANNEL_DELAY ms
+	void transportMoveChannel(uint8_t channel);
+	// Radio driver
+	void transportSetChannel(uint8_t channel);
+	uint8_t transportGetChannel();
+	uint8_t transportScanChannels();
+#endif
+
 // "Interface" functions for radio driver
 bool transportInit();
 void transportSetAddress(uint8_t address);
@@ -54,6 +94,8 @@ uint8_t transportGetAddress();
 bool transportSend(uint8_t to, const void* data, uint8_t len);
 bool transportAvailable(uint8_t *to);
 uint8_t transportReceive(void* data);
+// RSSI in dBm of the last received message, 0 if not supported by the radio
+int16_t transportGetReceivingRSSI();
 void transportPowerDown();
 
 #endif
@@ -29,6 +29,127 @@
 	AES _aes;
 	uint8_t _dataenc[32] = {0};
 	uint8_t _psk[16];
+
+	// CBC with ciphertext stealing, the IV is 0 for every frame. Frames of more than one block keep
+	// their length, shorter ones are padded to one block. The last two blocks go out swapped and
+	// the partial one shortened: C2 first, then as many bytes of C1 as the plain text had in block 2.
+	uint8_t transportEncrypt(uint8_t *buf, uint8_t len) {
+		_aes.set_IV(0);
+		if (len <= N_BLOCK) {
+			memset(buf + len, 0, N_BLOCK - len);
+			_aes.cbc_encrypt(buf, buf, 1);
+			return N_BLOCK;
+		}
+		uint8_t tail = len - N_BLOCK;
+		memset(buf + len, 0, N_BLOCK - tail);
+		_aes.cbc_encrypt(buf, buf, 2);
+		if (tail < N_BLOCK) {
+			uint8_t c1[N_BLOCK];
+			memcpy(c1, buf, N_BLOCK);
+			memcpy(buf, buf + N_BLOCK, N_BLOCK);
+			memcpy(buf + N_BLOCK, c1, tail);
+		}
+		return len;
+	}
+
+	void transportDecrypt(uint8_t *buf, uint8_t len) {
+		_aes.set_IV(0);
+		if (len <= N_BLOCK) {
+			_aes.cbc_decrypt(buf, buf, 1);
+			return;
+		}
+		uint8_t tail = len - N_BLOCK;
+		if (tail == N_BLOCK) {
+			_aes.cbc_decrypt(buf, buf, 2);
+			return;
+		}
+		// D(C2) is C1 xor the zero padded plain text block 2, its end completes C1
+		uint8_t d[N_BLOCK];
+		uint8_t c1[N_BLOCK];
+		_aes.decrypt(buf, d);
+		memcpy(c1, buf + N_BLOCK, tail);
+		memcpy(c1 + tail, d + tail, N_BLOCK - tail);
+		for (uint8_t i = 0; i < tail; i++) {
+			buf[N_BLOCK + i] = d[i] ^ c1[i];
+		}
+		_aes.decrypt(c1, buf);
+	}
+#endif
+
+#if defined(MY_RF24_IRQ_PIN)
+	#if defined(MY_SOFTSPI) || defined(ARDUINO_ARCH_ESP8266)
+		#error MY_RF24_IRQ_PIN requires hardware SPI with transaction support
+	#endif
+	typedef struct {
+		uint8_t to;
+		uint8_t len;
+		uint8_t data[MAX_MESSAGE_LENGTH];
+	} RF24_RxFrame;
+
+	RF24_RxFrame _rxBuffer[MY_RF24_RX_BUFFER_SIZE];
+	volatile uint8_t _rxHead = 0;
+	volatile uint8_t _rxTail = 0;
+	volatile uint8_t _rxCount = 0;
+	// Set if frames were left in the radio FIFO because the RAM buffer was full
+	volatile bool _rxPending = false;
+
+	// Move all frames from radio FIFO to RAM buffer. Called from ISR or with interrupts disabled.
+	void transportRxDrain() {
+		uint8_t to = 0;
+		while (RF24_isDataAvailable(&to)) {
+			if (_rxCount == MY_RF24_RX_BUFFER_SIZE) {
+				_rxPending = true;
+				return;
+			}
+			RF24_RxFrame &frame = _rxBuffer[_rxHead];
+			frame.to = to;
+			frame.len = RF24_readMessage(frame.data);
+			if (frame.len) {
+				_rxHead = (_rxHead + 1) % MY_RF24_RX_BUFFER_SIZE;
+				_rxCount++;
+			}
+		}
+		_rxPending = false;
+	}
+#endif
+
+#if defined(MY_RF24_CHANNEL_SCAN)
+	void transportSetChannel(uint8_t channel) {
+		RF24_ce(LOW);
+		RF24_setChannel(channel);
+		RF24_ce(HIGH);
+	}
+
+	uint8_t transportGetChannel() {
+		return RF24_getChannel();
+	}
+
+	// Surveys the scan range and returns the channel with the least carrier on it and its
+	// neighbours (counted half), frames in flight are lost meanwhile
+	uint8_t transportScanChannels() {
+		uint8_t current = RF24_getChannel();
+		uint8_t best = current;
+		uint16_t bestScore = 0xFFFF;
+		uint8_t previous = 0;
+		uint8_t hits = RF24_scanChannel(MY_RF24_SCAN_FIRST, MY_RF24_SCAN_SAMPLES);
+		for (uint8_t channel = MY_RF24_SCAN_FIRST; channel <= MY_RF24_SCAN_LAST; channel++) {
+			uint8_t next = channel < MY_RF24_SCAN_LAST ? RF24_scanChannel(channel + 1, MY_RF24_SCAN_SAMPLES) : 0;
+			uint16_t score = 2 * hits + previous + next;
+			debug(PSTR("scan ch=%d, hits=%d\n"), channel, hits);
+			if (score < bestScore) {
+				bestScore = score;
+				best = channel;
+			}
+			previous = hits;
+			hits = next;
+		}
+		RF24_setChannel(current);
+		// drop what was picked up on the other channels
+		RF24_flushRX();
+		RF24_writeByteRegister(RF24_STATUS, _BV(RX_DR));
+		RF24_startListening();
+		return best;
+	}
 #endif
 
 bool transportInit() {
@@ -41,7 +162,23 @@ bool transportInit() {
 		memset(_psk, 0, 16);
 	#endif
 	
-	return RF24_initialize();
+	if (!RF24_initialize()) {
+		return false;
+	}
+	#if defined(MY_RF24_CHANNEL_SCAN)
+		// the channel the network moved to
+		uint8_t channel = hwReadConfig(EEPROM_RF24_CHANNEL_ADDRESS);
+		if (channel <= 125) {
+			RF24_setChannel(channel);
+		}
+	#endif
+	#if defined(MY_RF24_IRQ_PIN)
+		pinMode(MY_RF24_IRQ_PIN, INPUT);
+		// Block the radio interrupt during SPI transactions of other drivers and this one
+		_SPI.usingInterrupt(digitalPinToInterrupt(MY_RF24_IRQ_PIN));
+		attachInterrupt(digitalPinToInterrupt(MY_RF24_IRQ_PIN), transportRxDrain, FALLING);
+	#endif
+	return true;
 }
 
 void transportSetAddress(uint8_t address) {
@@ -57,35 +194,96 @@ bool transportSend(uint8_t recipient, const void* data, uint8_t len) {
 	#if defined(MY_RF24_ENABLE_ENCRYPTION)
 		// copy input data because it is read-only
 		memcpy(_dataenc,data,len); 
-		// has to be adjusted, WIP!
-		_aes.set_IV(0);
-		len = len > 16 ? 32 : 16;
-		//encrypt data
-		_aes.cbc_encrypt(_dataenc, _dataenc, len/16); 
-		bool status = RF24_sendMessage( recipient, _dataenc, len );
-	#else
-		bool status = RF24_sendMessage( recipient, data, len );
+		len = transportEncrypt(_dataenc, len);
+		data = _dataenc;
+	#endif
+	#if defined(MY_RF24_ATC)
+		transport_power_t *power = NULL;
+		if (recipient != BROADCAST_ADDRESS) {
+			power = transportGetPower(recipient);
+			if (power->reduction) {
+				RF24_setPALevel(MY_RF24_PA_LEVEL - power->reduction);
+			}
+		}
+	#endif
+	bool status = RF24_sendMessage( recipient, data, len );
+	#if defined(MY_RF24_ATC) || defined(MY_STATS_FEATURE)
+		// Retransmissions of this frame, reset by the next payload
+		uint8_t retries = recipient != BROADCAST_ADDRESS ? RF24_readByteRegister(OBSERVE_TX) & 0x0F : 0;
+	#endif
+	#if defined(MY_RF24_ATC)
+		if (power) {
+			if (power->reduction) {
+				// Auto ACKs for frames we receive go out at the current level
+				RF24_setPALevel(MY_RF24_PA_LEVEL);
+			}
+			if (!status && power->reduction) {
+				// Lost at a lowered level, one more try at full power
+				power->reduction = 0;
+				power->quiet = 0;
+				status = RF24_sendMessage( recipient, data, len );
+				retries += RF24_readByteRegister(OBSERVE_TX) & 0x0F;
+			} else if (!status || retries > MY_RF24_ATC_RETRIES) {
+				if (power->reduction) {
+					power->reduction--;
+				}
+				power->quiet = 0;
+			} else if (!retries && power->reduction < MY_RF24_PA_LEVEL - RF24_PA_MIN &&
+				++power->quiet >= MY_RF24_ATC_QUIET) {
+				power->reduction++;
+				power->quiet = 0;
+			}
+		}
+	#endif
+	#if defined(MY_STATS_FEATURE)
+		_statsCount(_stats.retries, retries);
 	#endif
 	
 	return status;
 }
 
 bool transportAvailable(uint8_t *to) {
-	bool avail = RF24_isDataAvailable(to);
-	return avail;
+	#if defined(MY_RF24_IRQ_PIN)
+		if (_rxCount == 0) {
+			return false;
+		}
+		*to = _rxBuffer[_rxTail].to;
+		return true;
+	#else
+		bool avail = RF24_isDataAvailable(to);
+		return avail;
+	#endif
 }
 
 uint8_t transportReceive(void* data) {
-	uint8_t len = RF24_readMessage(data);
+	#if defined(MY_RF24_IRQ_PIN)
+		if (_rxCount == 0) {
+			return 0;
+		}
+		uint8_t len = _rxBuffer[_rxTail].len;
+		memcpy(data, _rxBuffer[_rxTail].data, len);
+		noInterrupts();
+		_rxTail = (_rxTail + 1) % MY_RF24_RX_BUFFER_SIZE;
+		_rxCount--;
+		if (_rxPending) {
+			// The IRQ line stays asserted until the FIFO is read, fetch the frames left behind
+			transportRxDrain();
+		}
+		interrupts();
+	#else
+		uint8_t len = RF24_readMessage(data);
+	#endif
 	#if defined(MY_RF24_ENABLE_ENCRYPTION)
-		// has to be adjusted, WIP!
-		_aes.set_IV(0);
-		// decrypt data
-		_aes.cbc_decrypt((byte*)(data), (byte*)(data), len>16?2:1);
+		transportDecrypt((uint8_t*)data, len);
 	#endif
 	return len;
 }
 
+int16_t transportGetReceivingRSSI() {
+	// nRF24 only reports a received power above -64dBm (RPD), no usable RSSI
+	return 0;
+}
+
 void transportPowerDown() {
 	RF24_powerDown();
 }
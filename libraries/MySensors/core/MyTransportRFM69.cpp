@@ -24,6 +24,90 @@
 
 RFM69 _radio(MY_RF69_SPI_CS, MY_RF69_IRQ_PIN, MY_RFM69HW, MY_RF69_IRQ_NUM);
 uint8_t _address;
+int16_t _receivingRSSI = 0;
+
+#if defined(MY_RFM69_ATC)
+	// Power levels of RFM69::setPowerLevel(), the HW model takes two levels per dB
+	#define RFM69_ATC_MAX_LEVEL 31
+	#define RFM69_ATC_LEVELS_PER_DB (MY_RFM69HW ? 2 : 1)
+	// Raise the power below the target, lower it only above target + hysteresis
+	#define RFM69_ATC_HYSTERESIS 3
+#endif
+
+// Retries per frame, like the default of RFM69::sendWithRetry()
+#define RFM69_RETRIES 2
+
+#if defined(MY_RFM69_DUTY_CYCLE)
+	// The window is covered by slices, the oldest one is dropped as a whole
+	#define RFM69_AIRTIME_SLICES 8
+	#define RFM69_AIRTIME_SLICE_MS (MY_RFM69_DUTY_CYCLE_WINDOW_MS / RFM69_AIRTIME_SLICES)
+	#define RFM69_AIRTIME_BUDGET_US ((uint32_t)MY_RFM69_DUTY_CYCLE_WINDOW_MS * MY_RFM69_DUTY_CYCLE_PERMILLE)
+	// Bytes on air besides the payload: preamble 3, sync 2, length, target, sender, control, CRC 2
+	#define RFM69_FRAME_OVERHEAD 11
+
+	uint32_t _airtime[RFM69_AIRTIME_SLICES]; // us per slice
+	uint8_t _airtimeSlice = 0;
+	unsigned long _airtimeSliceStart = 0;
+	uint16_t _airtimeUsPerByte; // from the bit rate register, set by transportInit()
+
+	static void rfm69AirtimeAdvance() {
+		// Sleep time counts, the window is real time
+		unsigned long now = nodeMillis();
+		while (now - _airtimeSliceStart >= RFM69_AIRTIME_SLICE_MS) {
+			_airtimeSliceStart += RFM69_AIRTIME_SLICE_MS;
+			_airtimeSlice = (_airtimeSlice + 1) % RFM69_AIRTIME_SLICES;
+			_airtime[_airtimeSlice] = 0;
+		}
+	}
+
+	static inline uint32_t rfm69Airtime(uint8_t len) {
+		return (uint32_t)(len + RFM69_FRAME_OVERHEAD) * _airtimeUsPerByte;
+	}
+
+	uint32_t transportGetAirtime() {
+		rfm69AirtimeAdvance();
+		uint32_t used = 0;
+		for (uint8_t i = 0; i < RFM69_AIRTIME_SLICES; i++) {
+			used += _airtime[i];
+		}
+		return used;
+	}
+
+	// Whether the frame, with all retries, still fits into the share of the budget its class may use
+	static bool rfm69AirtimeAllowed(const MyMessage &message, uint8_t len) {
+		uint8_t percent;
+		if (mGetCommand(message) == C_STREAM) {
+			percent = MY_RFM69_DUTY_CYCLE_BULK;
+		} else if (mGetCommand(message) == C_INTERNAL || mGetAck(message) || mGetRequestAck(message)) {
+			percent = 100;
+		} else {
+			percent = MY_RFM69_DUTY_CYCLE_NORMAL;
+		}
+		return transportGetAirtime() + (RFM69_RETRIES + 1) * rfm69Airtime(len) <= RFM69_AIRTIME_BUDGET_US / 100 * percent;
+	}
+
+	static void rfm69AirtimeCharge(uint8_t len) {
+		rfm69AirtimeAdvance();
+		_airtime[_airtimeSlice] += rfm69Airtime(len);
+	}
+#else
+	#define rfm69AirtimeCharge(__len)
+#endif
+
+// Sends with retries, every attempt is accounted for
+static bool rfm69Send(uint8_t to, const void* data, uint8_t len) {
+	#if defined(MY_RFM69_DUTY_CYCLE)
+		for (uint8_t i = 0; i <= RFM69_RETRIES; i++) {
+			rfm69AirtimeCharge(len);
+			if (_radio.sendWithRetry(to, data, len, 0)) {
+				return true;
+			}
+		}
+		return false;
+	#else
+		return _radio.sendWithRetry(to, data, len, RFM69_RETRIES);
+	#endif
+}
 
 
 bool transportInit() {
@@ -35,6 +119,11 @@ bool transportInit() {
 			_radio.encrypt((const char*)_psk);
 			memset(_psk, 0, 16); // Make sure it is purged from memory when set
 		#endif
+		#if defined(MY_RFM69_DUTY_CYCLE)
+			// 8 bits of FXOSC (32MHz) / bit rate register each
+			_airtimeUsPerByte = (((uint16_t)_radio.readReg(REG_BITRATEMSB) << 8) | _radio.readReg(REG_BITRATELSB)) / 4;
+			_airtimeSliceStart = nodeMillis();
+		#endif
 		return true;
 	}
 	return false;
@@ -50,7 +139,46 @@ uint8_t transportGetAddress() {
 }
 
 bool transportSend(uint8_t to, const void* data, uint8_t len) {
-	return _radio.sendWithRetry(to,data,len);
+	#if defined(MY_RFM69_DUTY_CYCLE)
+		if (!rfm69AirtimeAllowed(*(const MyMessage*)data, len)) {
+			// out of airtime for this kind of message, the caller sees a failed send
+			return false;
+		}
+	#endif
+	#if defined(MY_RFM69_ATC)
+		if (to == BROADCAST_ADDRESS) {
+			return rfm69Send(to,data,len);
+		}
+		transport_power_t *power = transportGetPower(to);
+		if (power->reduction) {
+			_radio.setPowerLevel(RFM69_ATC_MAX_LEVEL - power->reduction);
+		}
+		bool ok = rfm69Send(to,data,len);
+		if (power->reduction) {
+			// ACKs and broadcasts go out at full power
+			_radio.setPowerLevel(RFM69_ATC_MAX_LEVEL);
+		}
+		if (!ok) {
+			if (power->reduction) {
+				// Lost at a lowered level, one more try at full power
+				power->reduction = 0;
+				ok = rfm69Send(to,data,len);
+			}
+			return ok;
+		}
+		// The ACK came at full power, the destination heard our frame weaker by the reduction
+		int16_t rssi = _radio.RSSI - power->reduction / RFM69_ATC_LEVELS_PER_DB;
+		if (rssi < MY_RFM69_ATC_TARGET_RSSI) {
+			if (power->reduction) {
+				power->reduction--;
+			}
+		} else if (rssi > MY_RFM69_ATC_TARGET_RSSI + RFM69_ATC_HYSTERESIS && power->reduction < RFM69_ATC_MAX_LEVEL) {
+			power->reduction++;
+		}
+		return true;
+	#else
+		return rfm69Send(to,data,len);
+	#endif
 }
 
 bool transportAvailable(uint8_t *to) {
@@ -63,13 +191,19 @@ bool transportAvailable(uint8_t *to) {
 
 uint8_t transportReceive(void* data) {
 	memcpy(data,(const void *)_radio.DATA, _radio.DATALEN);
+	_receivingRSSI = _radio.RSSI;
 	// Send ack back if this message wasn't a broadcast
 	if (_radio.TARGETID != RF69_BROADCAST_ADDR)
 		_radio.ACKRequested();
     _radio.sendACK();
+	rfm69AirtimeCharge(0);
 	return _radio.DATALEN;
 }	
 
+int16_t transportGetReceivingRSSI() {
+	return _receivingRSSI;
+}
+
 void transportPowerDown() {
 	_radio.sleep();
 }
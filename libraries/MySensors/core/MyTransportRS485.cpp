@@ -67,30 +67,42 @@
 #include "MyTransport.h"
 
 
-#if defined(MY_RS485_DE_PIN)
-	#define assertDE() digitalWrite(MY_RS485_DE_PIN, HIGH); delayMicroseconds(5)
-	#define deassertDE() digitalWrite(MY_RS485_DE_PIN, LOW)
-
-#else
-	#define assertDE()
-	#define deassertDE()
-#endif
-
-// We only use SYS_PACK in this application
-#define	ICSC_SYS_PACK	0x58
+/*
+ * Frame format:
+ *
+ *   SOH | length | to | from | data (length bytes) | CRC16 low | CRC16 high
+ *
+ * The CRC-16/MODBUS covers length, addresses and data. A receiver syncs on SOH, then takes the
+ * frame by its length byte, data bytes are never scanned for control characters. A frame with
+ * a bad length or CRC sends it back to hunting for SOH.
+ */
 
-// Receiving header information
-char _header[6];
+// Start of a frame
+#define SOH 1
+// SOH and length, addresses and CRC
+#define RS485_OVERHEAD 6
+
+// Reception state machine
+#define RS485_REC_SOH 0
+#define RS485_REC_LEN 1
+#define RS485_REC_TO 2
+#define RS485_REC_FROM 3
+#define RS485_REC_DATA 4
+#define RS485_REC_CRC_LOW 5
+#define RS485_REC_CRC_HIGH 6
 
 // Reception state machine control and storage variables
-unsigned char _recPhase;
-unsigned char _recPos;
-unsigned char _recCommand;
-unsigned char _recLen;
-unsigned char _recStation;
-unsigned char _recSender;
-unsigned char _recCS;
-unsigned char _recCalcCS;
+uint8_t _recPhase;
+uint8_t _recPos;
+uint8_t _recLen;
+uint8_t _recStation;
+uint8_t _recSender;
+uint16_t _recCS;
+uint16_t _recCalcCS;
+// Frame goes to _data, false while the last one was not picked up yet
+bool _recKeep;
+// Time of the last byte seen on the bus (us)
+unsigned long _recLastByte;
 
 AltSoftSerial _dev;
 
@@ -99,215 +111,155 @@ unsigned char _nodeId;
 char _data[MY_RS485_MAX_MESSAGE_LENGTH];
 uint8_t _packet_len;
 unsigned char _packet_from;
+unsigned char _packet_to;
 bool _packet_received;
 
-// Packet wrapping characters, defined in standard ASCII table
-#define SOH 1
-#define STX 2
-#define ETX 3
-#define EOT 4
-
+// Time on the wire of one character (start bit, 8 data bits, stop bit) in us
+#define RS485_CHAR_US (10000000UL / MY_RS485_BAUD_RATE)
+// Random extra wait before sending, in character times, spreads nodes that wait for the same frame to end
+#define RS485_BACKOFF_SLOTS 8
+// Give up sending when the bus did not become free within this time (ms)
+#define RS485_SEND_TIMEOUT 200
+// A frame the bus went quiet in for this long (us) is dropped, the sender sends it in one go
+#define RS485_FRAME_GAP_US (20 * RS485_CHAR_US)
+
+// CRC-16/MODBUS, start with 0xFFFF
+static uint16_t _serialCrc(uint16_t crc, uint8_t data) {
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++) {
+		if (crc & 1)
+			crc = (crc >> 1) ^ 0xA001;
+		else
+			crc = (crc >> 1);
+	}
+	return crc;
+}
 
 
-//Reset the state machine and release the data pointer
+// Reset the state machine, wait for the next SOH
 void _serialReset(){
-  _recPhase = 0;
-  _recPos = 0;
-  _recLen = 0;
-  _recCommand = 0;
-  _recCS = 0;
-  _recCalcCS = 0;
+	_recPhase = RS485_REC_SOH;
+	_recPos = 0;
+	_recLen = 0;
+	_recCS = 0;
+	_recCalcCS = 0xFFFF;
 }
 
-// This is the main reception state machine.  Progress through the states
-// is keyed on either special control characters, or counted number of bytes
-// received.  If all the data is in the right format, and the calculated
-// checksum matches the received checksum, AND the destination station is
-// our station ID, then look for a registered command that matches the
-// command code.  If all the above is true, execute the command's
-// function.
+// Reception state machine, takes all bytes waiting in the serial buffer. Returns true if
+// anything was seen on the bus. Polled with nothing to read it drops a frame that stalled
+// for RS485_FRAME_GAP_US. A complete frame for this node (or broadcast) with a good CRC
+// is handed over through _data and _packet_received. Frames for other nodes, from ourselves
+// or arriving while the last one was not picked up yet are dropped without a trace.
 boolean _serialProcess()
 {
-    char inch;
-    unsigned char i;
-    if (!_dev.available()) return false;
-
-    while(_dev.available()) {
-        inch = _dev.read();
-
-        switch(_recPhase) {
-
-            // Case 0 looks for the header.  Bytes arrive in the serial interface and get
-            // shifted through a header buffer.  When the start and end characters in
-            // the buffer match the SOH/STX pair, and the destination station ID matches
-            // our ID, save the header information and progress to the next state.
-            case 0:
-                memcpy(&_header[0],&_header[1],5);
-                _header[5] = inch;
-                if ((_header[0] == SOH) && (_header[5] == STX) && (_header[1] != _header[2])) {
-                    _recCalcCS = 0;
-                    _recStation = _header[1];
-                    _recSender = _header[2];
-                    _recCommand = _header[3];
-                    _recLen = _header[4];
-
-                    for (i=1; i<=4; i++) {
-                        _recCalcCS += _header[i];
-                    }
-                    _recPhase = 1;
-                    _recPos = 0;
-
-                    //Check if we should process this message
-                    //We reject the message if we are the sender
-                    //We reject if we are not the receiver and message is not a broadcast
-                    if ((_recSender == _nodeId) ||
-                        (_recStation != _nodeId &&
-                         _recStation != BROADCAST_ADDRESS)) {
-						_dev.print(" wrongid: ");
-						_dev.print(_recStation);
-						_dev.print(" - ");
-						_dev.println(_nodeId);
-                        _serialReset();
-                        break;
-                    }
-
-                    if (_recLen == 0) {
-                        _recPhase = 2;
-                    }
-
-                }
-                break;
-
-            // Case 1 receives the data portion of the packet.  Read in "_recLen" number
-            // of bytes and store them in the _data array.
-            case 1:
-                _data[_recPos++] = inch;
-                _recCalcCS += inch;
-                if (_recPos == _recLen) {
-                    _recPhase = 2;
-                }
-                break;
-
-            // After the data comes a single ETX character.  Do we have it?  If not,
-            // reset the state machine to default and start looking for a new header.
-            case 2:
-                // Packet properly terminated?
-                if (inch == ETX) {
-                    _recPhase = 3;
-                } else {
-                    _serialReset();
-                }
-                break;
-
-            // Next comes the checksum.  We have already calculated it from the incoming
-            // data, so just store the incoming checksum byte for later.
-            case 3:
-                _recCS = inch;
-                _recPhase = 4;
-                break;
-
-            // The final state - check the last character is EOT and that the checksum matches.
-            // If that test passes, then look for a valid command callback to execute.
-            // Execute it if found.
-            case 4:
-                if (inch == EOT) {
-                    if (_recCS == _recCalcCS) {
-                        // First, check for system level commands.  It is possible
-                        // to register your own callback as well for system level
-                        // commands which will be called after the system default
-                        // hook.
-
-                        switch (_recCommand) {
-						    case ICSC_SYS_PACK:
-						    	_packet_from = _recSender;
-						    	_packet_len = _recLen;
-						    	_packet_received = true;
-                                break;
-                        }
-                    }
-                }
-                //Clear the data
-                _serialReset();
-                //Return true, we have processed one command
-                return true;
-                break;
-        }
-    }
-    return true;
+	if (!_dev.available()) {
+		if (_recPhase != RS485_REC_SOH && micros() - _recLastByte > RS485_FRAME_GAP_US) {
+			// Truncated frame, hunt for the next SOH instead of taking its bytes as the rest
+			_serialReset();
+		}
+		return false;
+	}
+
+	while(_dev.available()) {
+		uint8_t inch = _dev.read();
+		_recLastByte = micros();
+
+		if (_recPhase != RS485_REC_SOH && _recPhase < RS485_REC_CRC_LOW) {
+			_recCalcCS = _serialCrc(_recCalcCS, inch);
+		}
+		switch(_recPhase) {
+			case RS485_REC_SOH:
+				if (inch == SOH) {
+					_serialReset();
+					_recPhase = RS485_REC_LEN;
+				}
+				break;
+			case RS485_REC_LEN:
+				if (inch > MY_RS485_MAX_MESSAGE_LENGTH) {
+					_serialReset();
+					break;
+				}
+				_recLen = inch;
+				_recPhase = RS485_REC_TO;
+				break;
+			case RS485_REC_TO:
+				_recStation = inch;
+				_recPhase = RS485_REC_FROM;
+				break;
+			case RS485_REC_FROM:
+				_recSender = inch;
+				_recKeep = !_packet_received;
+				_recPhase = _recLen ? RS485_REC_DATA : RS485_REC_CRC_LOW;
+				break;
+			case RS485_REC_DATA:
+				if (_recKeep) {
+					_data[_recPos] = inch;
+				}
+				if (++_recPos == _recLen) {
+					_recPhase = RS485_REC_CRC_LOW;
+				}
+				break;
+			case RS485_REC_CRC_LOW:
+				_recCS = inch;
+				_recPhase = RS485_REC_CRC_HIGH;
+				break;
+			case RS485_REC_CRC_HIGH:
+				_recCS |= (uint16_t)inch << 8;
+				if (_recCS == _recCalcCS && _recKeep && !_packet_received && _recSender != _nodeId &&
+					(_recStation == _nodeId || _recStation == BROADCAST_ADDRESS)) {
+					_packet_from = _recSender;
+					_packet_to = _recStation;
+					_packet_len = _recLen;
+					_packet_received = true;
+				}
+				_serialReset();
+				break;
+		}
+	}
+	return true;
 }
 
 bool transportSend(uint8_t to, const void* data, uint8_t len)
 {
-	const char *datap = static_cast<char const *>(data);
-    unsigned char i;
-    unsigned char cs = 0;
-    unsigned char del;
-
-	// This is how many times to try and transmit before failing.
-	unsigned char timeout = 10;
-
-	// Let's start out by looking for a collision.  If there has been anything seen in
-	// the last millisecond, then wait for a random time and check again.
-
-	while (_serialProcess()) {
-		del = rand() % 20;
-		for (i = 0; i < del; i++) {
-			delay(1);
-			_serialProcess();
-		}
-		timeout--;
-		if (timeout == 0) {
+	const uint8_t *datap = static_cast<const uint8_t *>(data);
+	uint8_t header[4] = { SOH, len, to, _nodeId };
+	uint16_t crc = 0xFFFF;
+
+	if (len > MY_RS485_MAX_MESSAGE_LENGTH) {
+		return false;
+	}
+
+	// Collision avoidance: only start when nothing was seen on the bus for a few characters
+	// plus a random number of character times, so nodes waiting for the same frame to end
+	// do not all start at once.
+	unsigned long quiet = (MY_RS485_IDLE_CHARS + transportRandom(RS485_BACKOFF_SLOTS)) * RS485_CHAR_US;
+	unsigned long start = hwMillis();
+	_serialProcess();
+	while (micros() - _recLastByte < quiet) {
+		if (hwMillis() - start > RS485_SEND_TIMEOUT) {
 			// Failed to transmit!!!
 			return false;
 		}
+		if (_dev.isTransmitting()) {
+			// our previous frame is still going out
+			_recLastByte = micros();
+		}
+		_serialProcess();
 	}
 
-	#if defined(MY_RS485_DE_PIN)
-		digitalWrite(MY_RS485_DE_PIN, HIGH);
-		delayMicroseconds(5);
-	#endif
-
-		// Start of header by writing multiple SOH
-    for(byte w=0;w<1;w++)  _dev.write(SOH);
-    _dev.write(to);  // Destination address
-    cs += to;
-    _dev.write(_nodeId); // Source address
-    cs += _nodeId;
-    _dev.write(ICSC_SYS_PACK);  // Command code
-    cs += ICSC_SYS_PACK;
-    _dev.write(len);      // Length of text
-    cs += len;
-    _dev.write(STX);      // Start of text
-    for(i=0; i<len; i++) {
-        _dev.write(datap[i]);      // Text bytes
-        cs += datap[i];
-    }
-    _dev.write(ETX);      // End of text
-    _dev.write(cs);
-    _dev.write(EOT);
-
-	#if defined(MY_RS485_DE_PIN)
-		#ifdef __PIC32MX__
-			// MPIDE has nothing yet for this.  It uses the hardware buffer, which
-			// could be up to 8 levels deep.  For now, let's just delay for 8
-			// characters worth.
-			delayMicroseconds((F_CPU/9600)+1);
-		#else
-		#if defined(ARDUINO) && ARDUINO >= 100
-			#if ARDUINO >= 104
-				// Arduino 1.0.4 and upwards does it right
-				_dev.flush();
-			#else
-				// Between 1.0.0 and 1.0.3 it almost does it - need to compensate
-				// for the hardware buffer. Delay for 2 bytes worth of transmission.
-				_dev.flush();
-				delayMicroseconds((20000000UL/9600)+1);
-			#endif
-			#endif
-		#endif
-		digitalWrite(MY_RS485_DE_PIN, LOW);
-	#endif
-    return true;
+	// The frame is buffered and sent from the timer interrupt, which also switches the
+	// driver enable pin on before the first and off after the last byte.
+	for (uint8_t i = 1; i < sizeof(header); i++) {
+		crc = _serialCrc(crc, header[i]);
+	}
+	for (uint8_t i = 0; i < len; i++) {
+		crc = _serialCrc(crc, datap[i]);
+	}
+	_dev.write(header, sizeof(header));
+	_dev.write(datap, len);
+	_dev.write(crc & 0xFF);
+	_dev.write(crc >> 8);
+	return true;
 }
 
 
@@ -317,8 +269,7 @@ bool transportInit() {
 	_dev.begin(MY_RS485_BAUD_RATE);
     _serialReset();
 	#if defined(MY_RS485_DE_PIN)
-    	pinMode(MY_RS485_DE_PIN, OUTPUT);
-        digitalWrite(MY_RS485_DE_PIN, LOW);
+		_dev.setTransmitEnablePin(MY_RS485_DE_PIN);
 	#endif
     return true;
 }
@@ -335,7 +286,7 @@ uint8_t transportGetAddress() {
 bool transportAvailable(uint8_t *to) {
 	_serialProcess();
 	if (_packet_received == true) {
-		if (_recStation==BROADCAST_ADDRESS) {
+		if (_packet_to==BROADCAST_ADDRESS) {
 			*to = BROADCAST_ADDRESS;
 		}
 		else { *to = _nodeId; }
@@ -354,6 +305,11 @@ uint8_t transportReceive(void* data) {
 	}
 }
 
+int16_t transportGetReceivingRSSI() {
+	// Wired bus, no signal strength
+	return 0;
+}
+
 void transportPowerDown() {
 	// Nothing to shut down here
 }
@@ -22,7 +22,7 @@ ATSHA204Class::ATSHA204Class(uint8_t pin)
 #endif
 }
 
-void ATSHA204Class::getSerialNumber(uint8_t * response)
+uint8_t ATSHA204Class::getSerialNumber(uint8_t * response)
 {
   uint8_t readCommand[READ_COUNT];
   uint8_t readResponse[READ_4_RSP_SIZE];
@@ -47,9 +47,120 @@ void ATSHA204Class::getSerialNumber(uint8_t * response)
     }
   }
 
-  return;
+  return returnCode;
 }
 
+/* SWI UART functions */
+
+#if defined(MY_SIGNING_ATSHA204_SERIAL)
+// Single-wire interface driven by a UART (TX and RX joined on SDA, see the ATSHA204 datasheet).
+// Every single-wire bit is one 7N1 UART character at 230400 baud, sent by the peripheral with
+// interrupts enabled instead of cycle counted pulses with interrupts disabled.
+#define SWI_UART_BAUD        230400
+#define SWI_UART_BIT_ONE     ((uint8_t) 0x7F)  //!< start pulse only
+#define SWI_UART_BIT_ZERO    ((uint8_t) 0x7D)  //!< start pulse and zero pulse
+// 0x00 at 115200 baud holds the line low for 8 bit times (69us), long enough for a wake pulse
+#define SWI_UART_WAKE_BAUD   115200
+#define SWI_UART_CHAR_US     (10 * 1000000UL / SWI_UART_BAUD + 1)
+
+// The port is begun on first use, the first operation may be a sleep command sent before
+// any wake pulse. Writing to a port that was never begun never completes on AVR.
+static bool swi_uart_begun = false;
+
+static void swi_uart_begin()
+{
+  if (!swi_uart_begun)
+  {
+    MY_SIGNING_ATSHA204_SERIAL.begin(SWI_UART_BAUD, SERIAL_7N1);
+    swi_uart_begun = true;
+  }
+}
+
+// TX and RX share the line, everything sent comes back as echo
+static void swi_uart_drop_echo()
+{
+  // the last echo character is complete shortly after its stop bit went out
+  delayMicroseconds(SWI_UART_CHAR_US / 4);
+  while (MY_SIGNING_ATSHA204_SERIAL.available())
+    (void)MY_SIGNING_ATSHA204_SERIAL.read();
+}
+
+void ATSHA204Class::swi_set_signal_pin(uint8_t is_high)
+{
+  // Only used for the wake pulse: low goes out as a slow 0x00 character, high restores the bit rate
+  swi_uart_begun = true;
+  if (is_high)
+  {
+    MY_SIGNING_ATSHA204_SERIAL.begin(SWI_UART_BAUD, SERIAL_7N1);
+  }
+  else
+  {
+    MY_SIGNING_ATSHA204_SERIAL.begin(SWI_UART_WAKE_BAUD, SERIAL_7N1);
+    MY_SIGNING_ATSHA204_SERIAL.write((uint8_t)0x00);
+    MY_SIGNING_ATSHA204_SERIAL.flush();
+    swi_uart_drop_echo();
+  }
+}
+
+uint8_t ATSHA204Class::swi_send_bytes(uint8_t count, uint8_t *buffer)
+{
+  uint8_t i, bit_mask;
+
+  swi_uart_begin();
+  for (i = 0; i < count; i++)
+  {
+    for (bit_mask = 1; bit_mask > 0; bit_mask <<= 1)
+      MY_SIGNING_ATSHA204_SERIAL.write((bit_mask & buffer[i]) ? SWI_UART_BIT_ONE : SWI_UART_BIT_ZERO);
+  }
+  MY_SIGNING_ATSHA204_SERIAL.flush();
+  swi_uart_drop_echo();
+  return SWI_FUNCTION_RETCODE_SUCCESS;
+}
+
+uint8_t ATSHA204Class::swi_receive_bytes(uint8_t count, uint8_t *buffer)
+{
+  uint8_t status = SWI_FUNCTION_RETCODE_SUCCESS;
+  uint8_t i;
+  uint8_t bit_mask;
+  unsigned long start;
+
+  swi_uart_begin();
+  for (i = 0; i < count; i++)
+  {
+    buffer[i] = 0;
+    for (bit_mask = 1; bit_mask > 0; bit_mask <<= 1)
+    {
+      start = micros();
+      while (!MY_SIGNING_ATSHA204_SERIAL.available())
+      {
+        if (micros() - start > SWI_RECEIVE_TIME_OUT)
+        {
+          status = SWI_FUNCTION_RETCODE_TIMEOUT;
+          break;
+        }
+      }
+      if (status != SWI_FUNCTION_RETCODE_SUCCESS)
+        break;
+
+      // A one bit reads as 0x7F, sometimes 0x7E, anything with a zero pulse is lower
+      if ((MY_SIGNING_ATSHA204_SERIAL.read() ^ SWI_UART_BIT_ONE) < 2)
+        buffer[i] |= bit_mask;  // received "one" bit
+    }
+
+    if (status != SWI_FUNCTION_RETCODE_SUCCESS)
+      break;
+  }
+
+  if (status == SWI_FUNCTION_RETCODE_TIMEOUT)
+  {
+    if (i > 0)
+    // Indicate that we timed out after having received at least one byte.
+    status = SWI_FUNCTION_RETCODE_RX_FAIL;
+  }
+  return status;
+}
+
+#else
 /* SWI bit bang functions */
 
 void ATSHA204Class::swi_set_signal_pin(uint8_t is_high)
@@ -106,11 +217,6 @@ uint8_t ATSHA204Class::swi_send_bytes(uint8_t count, uint8_t *buffer)
   return SWI_FUNCTION_RETCODE_SUCCESS;
 }
 
-uint8_t ATSHA204Class::swi_send_byte(uint8_t value)
-{
-  return swi_send_bytes(1, &value);
-}
-
 uint8_t ATSHA204Class::swi_receive_bytes(uint8_t count, uint8_t *buffer)
 {
   uint8_t status = SWI_FUNCTION_RETCODE_SUCCESS;
@@ -215,6 +321,13 @@ uint8_t ATSHA204Class::swi_receive_bytes(uint8_t count, uint8_t *buffer)
   return status;
 }
 
+#endif
+
+uint8_t ATSHA204Class::swi_send_byte(uint8_t value)
+{
+  return swi_send_bytes(1, &value);
+}
+
 /* Physical functions */
 
 void ATSHA204Class::sha204c_sleep()
@@ -282,6 +395,15 @@ uint8_t ATSHA204Class::sha204c_wakeup(uint8_t *response)
   return ret_code;
 }
 
+uint8_t ATSHA204Class::sha204c_session_begin()
+{
+  // Start from a known state: a sleeping device ignores the sleep flag, an awake one
+  // would ignore the wake pulse and not answer with the wakeup status.
+  uint8_t response[SHA204_RSP_SIZE_MIN];
+  sha204c_sleep();
+  return sha204c_wakeup(response);
+}
+
 uint8_t ATSHA204Class::sha204c_resync(uint8_t size, uint8_t *response)
 {
   // Try to re-synchronize without sending a Wake token
@@ -260,9 +260,10 @@ private:
 public:
 	ATSHA204Class(uint8_t pin);	// Constructor
 	void sha204c_sleep();
+	uint8_t sha204c_session_begin(); // wake up for a sequence of commands, TempKey survives until sha204c_sleep()
 	uint8_t sha204m_execute(uint8_t op_code, uint8_t param1, uint16_t param2,
 			uint8_t datalen1, uint8_t *data1, uint8_t tx_size, uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer);
-	void getSerialNumber(uint8_t *response);
+	uint8_t getSerialNumber(uint8_t *response);
 };
 
 #endif
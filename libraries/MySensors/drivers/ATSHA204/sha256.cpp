@@ -38,13 +38,33 @@ void Sha256Class::init(void) {
   bufferOffset = 0;
 }
 
-uint32_t Sha256Class::ror32(uint32_t number, uint8_t bits) {
+static inline uint32_t ror32(uint32_t number, uint8_t bits) {
   return ((number << (32-bits)) | (number >> bits));
 }
 
+// One round with the working variables passed in rotated order instead of shifting them all
+#define SHA256_ROUND(a,b,c,d,e,f,g,h,i) \
+  do { \
+    uint32_t w; \
+    if ((i)>=16) { \
+      uint32_t s0 = buffer.w[((i)-15)&15]; \
+      uint32_t s1 = buffer.w[((i)-2)&15]; \
+      w = buffer.w[(i)&15] + buffer.w[((i)-7)&15]; \
+      w += ror32(s1,17) ^ ror32(s1,19) ^ (s1>>10); \
+      w += ror32(s0,7) ^ ror32(s0,18) ^ (s0>>3); \
+      buffer.w[(i)&15] = w; \
+    } else { \
+      w = buffer.w[i]; \
+    } \
+    uint32_t t1 = h + (ror32(e,6) ^ ror32(e,11) ^ ror32(e,25)) + (g ^ (e & (g ^ f))) + pgm_read_dword(sha256K+(i)) + w; \
+    uint32_t t2 = (ror32(a,2) ^ ror32(a,13) ^ ror32(a,22)) + ((b & c) | (a & (b | c))); \
+    d += t1; \
+    h = t1 + t2; \
+  } while (0)
+
 void Sha256Class::hashBlock() {
   uint8_t i;
-  uint32_t a,b,c,d,e,f,g,h,t1,t2;
+  uint32_t a,b,c,d,e,f,g,h;
 
   a=state.w[0];
   b=state.w[1];
@@ -54,24 +74,17 @@ void Sha256Class::hashBlock() {
   f=state.w[5];
   g=state.w[6];
   h=state.w[7];
-  
-  for (i=0; i<64; i++) {
-    if (i>=16) {
-      t1 = buffer.w[i&15] + buffer.w[(i-7)&15];
-      t2 = buffer.w[(i-2)&15];
-      t1 += ror32(t2,17) ^ ror32(t2,19) ^ (t2>>10);
-      t2 = buffer.w[(i-15)&15];
-      t1 += ror32(t2,7) ^ ror32(t2,18) ^ (t2>>3);
-      buffer.w[i&15] = t1;
-    }
-    t1 = h;
-    t1 += ror32(e,6) ^ ror32(e,11) ^ ror32(e,25); // ∑1(e)
-    t1 += g ^ (e & (g ^ f)); // Ch(e,f,g)
-    t1 += pgm_read_dword(sha256K+i); // Ki
-    t1 += buffer.w[i&15]; // Wi
-    t2 = ror32(a,2) ^ ror32(a,13) ^ ror32(a,22); // ∑0(a)
-    t2 += ((b & c) | (a & (b | c))); // Maj(a,b,c)
-    h=g; g=f; f=e; e=d+t1; d=c; c=b; b=a; a=t1+t2;
+
+  // 8 rounds per iteration, after which the variables are back in their original roles
+  for (i=0; i<64; i+=8) {
+    SHA256_ROUND(a,b,c,d,e,f,g,h,i);
+    SHA256_ROUND(h,a,b,c,d,e,f,g,i+1);
+    SHA256_ROUND(g,h,a,b,c,d,e,f,i+2);
+    SHA256_ROUND(f,g,h,a,b,c,d,e,i+3);
+    SHA256_ROUND(e,f,g,h,a,b,c,d,i+4);
+    SHA256_ROUND(d,e,f,g,h,a,b,c,i+5);
+    SHA256_ROUND(c,d,e,f,g,h,a,b,i+6);
+    SHA256_ROUND(b,c,d,e,f,g,h,a,i+7);
   }
   state.w[0] += a;
   state.w[1] += b;
@@ -97,6 +110,17 @@ void Sha256Class::write(uint8_t data) {
   addUncounted(data);
 }
 
+void Sha256Class::write(const uint8_t* data, size_t length) {
+  byteCount += length;
+  while (length--) {
+    buffer.b[bufferOffset ^ 3] = *data++;
+    if (++bufferOffset == BUFFER_SIZE) {
+      hashBlock();
+      bufferOffset = 0;
+    }
+  }
+}
+
 void Sha256Class::pad() {
   // Implement SHA-256 padding (fips180-2 §5.1.1)
 
@@ -138,35 +162,52 @@ uint8_t* Sha256Class::result(void) {
 #define HMAC_IPAD 0x36
 #define HMAC_OPAD 0x5c
 
-uint8_t keyBuffer[BLOCK_LENGTH]; // K0 in FIPS-198a
-uint8_t innerHash[HASH_LENGTH];
-
-void Sha256Class::initHmac(const uint8_t* key, int keyLength) {
+// Hash one block of key ^ padByte from the initial state, the key is zero padded to the block length
+void Sha256Class::hashPad(const uint8_t* key, int keyLength, uint8_t padByte, _state &padState) {
   uint8_t i;
-  memset(keyBuffer,0,BLOCK_LENGTH);
+  init();
+  for (i=0; i<BLOCK_LENGTH; i++) {
+    buffer.b[i ^ 3] = (i < keyLength ? key[i] : 0) ^ padByte;
+  }
+  hashBlock();
+  memcpy(padState.b,state.b,HASH_LENGTH);
+}
+
+void Sha256Class::prepareHmacKey(Sha256HmacKey &hmacKey, const uint8_t* key, int keyLength) {
   if (keyLength > BLOCK_LENGTH) {
     // Hash long keys
     init();
-    for (;keyLength--;) write(*key++);
-    memcpy(keyBuffer,result(),HASH_LENGTH);
-  } else {
-    // Block length keys are used as is
-    memcpy(keyBuffer,key,keyLength);
+    write(key, keyLength);
+    memcpy(innerHash,result(),HASH_LENGTH);
+    key = innerHash;
+    keyLength = HASH_LENGTH;
   }
+  hashPad(key, keyLength, HMAC_OPAD, hmacKey.outer);
+  hashPad(key, keyLength, HMAC_IPAD, hmacKey.inner);
+  // Do not leave key material behind in the block buffer
+  memset(buffer.b,0,BLOCK_LENGTH);
+}
+
+void Sha256Class::initHmac(const Sha256HmacKey &hmacKey) {
+  hmac = &hmacKey;
   // Start inner hash
-  init();
-  for (i=0; i<BLOCK_LENGTH; i++) {
-    write(keyBuffer[i] ^ HMAC_IPAD);
-  }
+  memcpy(state.b,hmacKey.inner.b,HASH_LENGTH);
+  byteCount = BLOCK_LENGTH;
+  bufferOffset = 0;
+}
+
+void Sha256Class::initHmac(const uint8_t* key, int keyLength) {
+  prepareHmacKey(hmacOwnKey, key, keyLength);
+  initHmac(hmacOwnKey);
 }
 
 uint8_t* Sha256Class::resultHmac(void) {
-  uint8_t i;
   // Complete inner hash
   memcpy(innerHash,result(),HASH_LENGTH);
   // Calculate outer hash
-  init();
-  for (i=0; i<BLOCK_LENGTH; i++) write(keyBuffer[i] ^ HMAC_OPAD);
-  for (i=0; i<HASH_LENGTH; i++) write(innerHash[i]);
+  memcpy(state.b,hmac->outer.b,HASH_LENGTH);
+  byteCount = BLOCK_LENGTH;
+  bufferOffset = 0;
+  write(innerHash, HASH_LENGTH);
   return result();
 }
@@ -3,6 +3,7 @@
 #define Sha256_h
 #if !DOXYGEN
 #include <inttypes.h>
+#include <stddef.h>
 
 #define HASH_LENGTH 32
 #define BLOCK_LENGTH 64
@@ -16,25 +17,37 @@ union _state {
   uint32_t w[HASH_LENGTH/4];
 };
 
+// HMAC key prepared for reuse: hash states after the inner and outer key pad blocks
+struct Sha256HmacKey {
+  _state inner;
+  _state outer;
+};
+
 class Sha256Class
 {
   public:
+    Sha256Class() : hmac(&hmacOwnKey) {}
     void init(void);
+    // Hashes the key pads once, hmacKey can then be passed to initHmac() for any number of messages
+    void prepareHmacKey(Sha256HmacKey &hmacKey, const uint8_t* secret, int secretLength);
+    void initHmac(const Sha256HmacKey &hmacKey);
     void initHmac(const uint8_t* secret, int secretLength);
     uint8_t* result(void);
     uint8_t* resultHmac(void);
     void write(uint8_t);
+    void write(const uint8_t* data, size_t length);
   private:
     void pad();
     void addUncounted(uint8_t data);
     void hashBlock();
-    uint32_t ror32(uint32_t number, uint8_t bits);
+    void hashPad(const uint8_t* key, int keyLength, uint8_t padByte, _state &padState);
     _buffer buffer;
     uint8_t bufferOffset;
     _state state;
     uint32_t byteCount;
-    uint8_t keyBuffer[BLOCK_LENGTH];
     uint8_t innerHash[HASH_LENGTH];
+    const Sha256HmacKey *hmac; // key of the HMAC in progress
+    Sha256HmacKey hmacOwnKey; // used by initHmac(secret, secretLength)
 };
 
 #endif
@@ -58,6 +58,9 @@ const uint8_t STATE_RX_ADDR_NACK = 4;
 const uint8_t STATE_TX_ADDR_NACK = 5;
 /** Data byte transmitted, NACK received. */
 const uint8_t STATE_TX_DATA_NACK = 6;
+
+/** Slave held SCL low for longer than the clock stretch timeout. */
+const uint8_t STATE_SCL_TIMEOUT = 7;
 //==============================================================================
 /**
  * @class I2cMasterBase
@@ -140,7 +143,8 @@ class I2cMasterBase {
    * @return true for ACK or false for NACK */
   virtual bool write(uint8_t data) = 0;
 
- private:
+ protected:
+  /** Transfer state, one of the STATE_* codes. */
   uint8_t _state;
 };
 //==============================================================================
@@ -212,15 +216,28 @@ class SoftI2cMaster : public I2cMasterBase {
 //==============================================================================
 // Template based fast software I2C
 //------------------------------------------------------------------------------
+/** Number of _delay_loop_1() counts, three cycles each, covering at least ns. */
+#define FAST_I2C_DELAY_LOOPS(ns) \
+  ((uint8_t)(((F_CPU / 1000000UL) * (ns) + 2999) / 3000))
+
+#ifndef FAST_I2C_STRETCH_LOOPS
+/** Polls of SCL before a stretched clock is given up, about 25 ms at 16 MHz. */
+#define FAST_I2C_STRETCH_LOOPS 0XFFFF
+#endif  // FAST_I2C_STRETCH_LOOPS
+//------------------------------------------------------------------------------
 /**
  * @class FastI2cMaster
  * @brief Fast software I2C master class.
+ *
+ * Pins are compile time constants so every bus access is a single
+ * instruction. Timing follows the 400 kHz limits for the CPU clock,
+ * slaves may stretch the clock up to FAST_I2C_STRETCH_LOOPS polls.
  */
 template<uint8_t sclPin, uint8_t sdaPin>
 class FastI2cMaster : public I2cMasterBase {
  public:
   //----------------------------------------------------------------------------
-  FastI2cMaster() {
+  FastI2cMaster() : _sclTimeout(false) {
     begin();
   }
   //----------------------------------------------------------------------------
@@ -234,49 +251,39 @@ class FastI2cMaster : public I2cMasterBase {
   }
   //----------------------------------------------------------------------------
   uint8_t read(uint8_t last) {
-    uint8_t data = 0;
     sdaWrite(HIGH);
-
-    readBit(7, &data);
-    readBit(6, &data);
-    readBit(5, &data);
-    readBit(4, &data);
-    readBit(3, &data);
-    readBit(2, &data);
-    readBit(1, &data);
-    readBit(0, &data);
-
+    uint8_t data = readByte();
     // send ACK or NACK
     sdaWrite(last);
-    sclDelay(4);
-    sclWrite(HIGH);
-    sclDelay(6);
+    sclDelay(T_LOW);
+    sclRelease();
+    sclDelay(T_HIGH);
     sclWrite(LOW);
     sdaWrite(LOW);
     return data;
   }
   //----------------------------------------------------------------------------
   void start() {
+    _sclTimeout = false;
     if (!fastDigitalRead(sdaPin)) {
       // It's a repeat start.
       sdaWrite(HIGH);
-      sclDelay(8);
-      sclWrite(HIGH);
-      sclDelay(8);
+      sclDelay(T_LOW);
+      sclRelease();
+      sclDelay(T_SETUP);
     }
     sdaWrite(LOW);
-    sclDelay(8);
+    sclDelay(T_SETUP);
     sclWrite(LOW);
-    sclDelay(8);
   }
   //----------------------------------------------------------------------------
   void stop(void) {
     sdaWrite(LOW);
-    sclDelay(8);
-    sclWrite(HIGH);
-    sclDelay(8);
+    sclDelay(T_LOW);
+    sclRelease();
+    sclDelay(T_SETUP);
     sdaWrite(HIGH);
-    sclDelay(8);
+    sclDelay(T_LOW);
   }
   //----------------------------------------------------------------------------
   bool write(uint8_t data) {
@@ -292,16 +299,91 @@ class FastI2cMaster : public I2cMasterBase {
 
     // get ACK or NACK
     sdaWrite(HIGH);
-
-    sclWrite(HIGH);
-    sclDelay(5);
+    sclDelay(T_LOW);
+    sclRelease();
+    sclDelay(T_HIGH);
     bool rtn = fastDigitalRead(sdaPin);
     sclWrite(LOW);
     sdaWrite(LOW);
-    return rtn == 0;
+    return rtn == 0 && !_sclTimeout;
+  }
+  //----------------------------------------------------------------------------
+  /**
+   * Start an I2C transfer with possible continuation.
+   *
+   * Same as I2cMasterBase::transfer() but bytes are moved without a
+   * virtual call per byte and a stretch timeout ends the transfer.
+   *
+   * @param[in] addressRW I2C slave address plus R/W bit.
+   * @param[in,out] buf   Source or destination for transfer.
+   * @param[in] nbyte     Number of bytes to transfer (may be zero).
+   * @param[in] option    I2C_STOP, I2C_REP_START or I2C_CONTINUE.
+   * @return true for success else false.
+   */
+  bool transfer(uint8_t addressRW, void *buf,
+                size_t nbyte, uint8_t option = I2C_STOP) {
+    if (_state != STATE_REP_START) {
+      start();
+    }
+    if (!write(addressRW)) {
+      if (_sclTimeout) {
+        _state = STATE_SCL_TIMEOUT;
+      } else {
+        _state = addressRW & I2C_READ ? STATE_RX_ADDR_NACK : STATE_TX_ADDR_NACK;
+      }
+      return false;
+    }
+    _state = addressRW & I2C_READ ? STATE_RX_DATA : STATE_TX_DATA;
+    return transferContinue(buf, nbyte, option);
+  }
+  //----------------------------------------------------------------------------
+  /**
+   * Continue an I2C transfer.
+   *
+   * @param[in,out] buf   Source or destination for transfer.
+   * @param[in] nbyte     Number of bytes to transfer (may be zero).
+   * @param[in] option    I2C_STOP, I2C_REP_START or I2C_CONTINUE.
+   * @return true for success else false.
+   */
+  bool transferContinue(void *buf, size_t nbyte, uint8_t option = I2C_STOP) {
+    uint8_t* p = reinterpret_cast<uint8_t*>(buf);
+    if (_state == STATE_RX_DATA) {
+      readBurst(p, nbyte, option != I2C_CONTINUE);
+    } else if (_state == STATE_TX_DATA) {
+      for (size_t i = 0; i < nbyte; i++) {
+        if (!write(p[i])) {
+          _state = _sclTimeout ? STATE_SCL_TIMEOUT : STATE_TX_DATA_NACK;
+          return false;
+        }
+      }
+    } else {
+      return false;
+    }
+    if (_sclTimeout) {
+      _state = STATE_SCL_TIMEOUT;
+      return false;
+    }
+    if (option == I2C_STOP) {
+      stop();
+      _state = STATE_STOP;
+    } else if (option == I2C_REP_START) {
+      start();
+      _state = STATE_REP_START;
+    }
+    return true;
   }
+  //----------------------------------------------------------------------------
+  /** @return true if a slave stretched the clock past the timeout since
+   *          the last start condition.
+   */
+  bool sclTimeout() const {return _sclTimeout;}
 
  private:
+  // Minimum times of a 400 kHz bus in _delay_loop_1() counts.
+  static const uint8_t T_LOW = FAST_I2C_DELAY_LOOPS(1300);
+  static const uint8_t T_HIGH = FAST_I2C_DELAY_LOOPS(600);
+  static const uint8_t T_SETUP = FAST_I2C_DELAY_LOOPS(600);
+  bool _sclTimeout;
   //----------------------------------------------------------------------------
   inline __attribute__((always_inline))
   void sclWrite(bool value) {fastPinMode(sclPin, !value);}
@@ -309,27 +391,74 @@ class FastI2cMaster : public I2cMasterBase {
   inline __attribute__((always_inline))
   void sdaWrite(bool value) {fastPinMode(sdaPin, !value);}
   //----------------------------------------------------------------------------
+  // Release SCL and wait while a slave holds it low.
   inline __attribute__((always_inline))
-  void readBit(uint8_t bit, uint8_t* data) {
+  void sclRelease() {
     sclWrite(HIGH);
-    sclDelay(5);
+    if (!fastDigitalRead(sclPin) && !_sclTimeout) sclWait();
+  }
+  //----------------------------------------------------------------------------
+  __attribute__((noinline))
+  void sclWait() {
+    uint16_t n = FAST_I2C_STRETCH_LOOPS;
+    while (!fastDigitalRead(sclPin)) {
+      if (--n == 0) {
+        _sclTimeout = true;
+        return;
+      }
+    }
+  }
+  //----------------------------------------------------------------------------
+  inline __attribute__((always_inline))
+  void readBit(uint8_t bit, uint8_t* data) {
+    sclDelay(T_LOW);
+    sclRelease();
+    sclDelay(T_HIGH);
     if (fastDigitalRead(sdaPin)) *data |= 1 << bit;
     sclWrite(LOW);
-    if (bit) sclDelay(6);
   }
   //----------------------------------------------------------------------------
-  void sclDelay(uint8_t n) {_delay_loop_1(n);}
+  inline __attribute__((always_inline))
+  uint8_t readByte() {
+    uint8_t data = 0;
+    readBit(7, &data);
+    readBit(6, &data);
+    readBit(5, &data);
+    readBit(4, &data);
+    readBit(3, &data);
+    readBit(2, &data);
+    readBit(1, &data);
+    readBit(0, &data);
+    return data;
+  }
+  //----------------------------------------------------------------------------
+  // Read nbyte bytes, ACK all but the last one if last is true.
+  void readBurst(uint8_t* buf, size_t nbyte, bool last) {
+    for (size_t i = 0; i < nbyte && !_sclTimeout; i++) {
+      sdaWrite(HIGH);
+      buf[i] = readByte();
+      // ACK pulls SDA low, NACK leaves it released
+      sdaWrite(last && i == (nbyte - 1));
+      sclDelay(T_LOW);
+      sclRelease();
+      sclDelay(T_HIGH);
+      sclWrite(LOW);
+    }
+    sdaWrite(LOW);
+  }
+  //----------------------------------------------------------------------------
+  inline __attribute__((always_inline))
+  void sclDelay(uint8_t n) {if (n) _delay_loop_1(n);}
   //----------------------------------------------------------------------------
   inline __attribute__((always_inline))
   void writeBit(uint8_t bit, uint8_t data) {
     uint8_t mask = 1 << bit;
     sdaWrite(data & mask);
-    sclWrite(HIGH);
-    sclDelay(5);
+    sclDelay(T_LOW);
+    sclRelease();
+    sclDelay(T_HIGH);
     sclWrite(LOW);
-    sclDelay(5);
   }
 };
 #endif  // SOFT_I2C_MASTER_H
 /** @} */
-
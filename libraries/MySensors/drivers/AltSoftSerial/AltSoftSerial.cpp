@@ -46,16 +46,23 @@ static uint16_t rx_target;
 static uint16_t rx_stop_ticks=0;
 static volatile uint8_t rx_buffer_head;
 static volatile uint8_t rx_buffer_tail;
-#define RX_BUFFER_SIZE 80
+#define RX_BUFFER_SIZE ALTSS_RX_BUFFER_SIZE
 static volatile uint8_t rx_buffer[RX_BUFFER_SIZE];
+// bytes dropped because the receive buffer was full
+static volatile uint16_t rx_overflow_count = 0;
+static volatile bool rx_overflow = false;
 
 static volatile uint8_t tx_state=0;
 static uint8_t tx_byte;
 static uint8_t tx_bit;
 static volatile uint8_t tx_buffer_head;
 static volatile uint8_t tx_buffer_tail;
-#define TX_BUFFER_SIZE 68
-static volatile uint8_t tx_buffer[RX_BUFFER_SIZE];
+#define TX_BUFFER_SIZE ALTSS_TX_BUFFER_SIZE
+static volatile uint8_t tx_buffer[TX_BUFFER_SIZE];
+// RS485 driver enable, HIGH while sending, -1 if none
+static int8_t tx_enable_pin = -1;
+// called from the interrupt after the stop bit of the last buffered byte
+static void (*tx_complete_callback)(void) = NULL;
 
 
 #ifndef INPUT_PULLUP
@@ -82,6 +89,8 @@ void AltSoftSerial::init(uint32_t cycles_per_bit)
 	rx_state = 0;
 	rx_buffer_head = 0;
 	rx_buffer_tail = 0;
+	rx_overflow_count = 0;
+	rx_overflow = false;
 	tx_state = 0;
 	tx_buffer_head = 0;
 	tx_buffer_tail = 0;
@@ -98,6 +107,15 @@ void AltSoftSerial::end(void)
 	// TODO: restore timer to original settings?
 }
 
+void AltSoftSerial::setTransmitEnablePin(int8_t pin)
+{
+	tx_enable_pin = pin;
+	if (pin >= 0) {
+		digitalWrite(pin, LOW);
+		pinMode(pin, OUTPUT);
+	}
+}
+
 
 /****************************************/
 /**           Transmission             **/
@@ -121,7 +139,13 @@ void AltSoftSerial::writeByte(uint8_t b)
 		tx_bit = 0;
 		ENABLE_INT_COMPARE_A();
 		CONFIG_MATCH_CLEAR();
-		SET_COMPARE_A(GET_TIMER_COUNT() + 16);
+		if (tx_enable_pin >= 0) {
+			// give the line driver one bit time to switch on before the start bit
+			digitalWrite(tx_enable_pin, HIGH);
+			SET_COMPARE_A(GET_TIMER_COUNT() + ticks_per_bit);
+		} else {
+			SET_COMPARE_A(GET_TIMER_COUNT() + 16);
+		}
 	}
 	SREG = intr_state;
 }
@@ -166,6 +190,9 @@ ISR(COMPARE_A_INTERRUPT)
 		tx_state = 0;
 		CONFIG_MATCH_NORMAL();
 		DISABLE_INT_COMPARE_A();
+		// stop bit of the last byte is out, release the bus
+		if (tx_enable_pin >= 0) digitalWrite(tx_enable_pin, LOW);
+		if (tx_complete_callback) tx_complete_callback();
 	} else {
 		tx_state = 1;
 		if (++tail >= TX_BUFFER_SIZE) tail = 0;
@@ -183,6 +210,29 @@ void AltSoftSerial::flushOutput(void)
 	while (tx_state) /* wait */ ;
 }
 
+int AltSoftSerial::availableForWrite(void)
+{
+	uint8_t head, tail;
+
+	head = tx_buffer_head;
+	tail = tx_buffer_tail;
+	if (tail > head) return tail - head - 1;
+	return TX_BUFFER_SIZE + tail - head - 1;
+}
+
+bool AltSoftSerial::isTransmitting(void)
+{
+	return tx_state;
+}
+
+void AltSoftSerial::setWriteCompleteCallback(void (*callback)(void))
+{
+	uint8_t intr_state = SREG;
+	cli();
+	tx_complete_callback = callback;
+	SREG = intr_state;
+}
+
 
 /****************************************/
 /**            Reception               **/
@@ -227,6 +277,9 @@ ISR(CAPTURE_INTERRUPT)
 				if (head != rx_buffer_tail) {
 					rx_buffer[head] = rx_byte;
 					rx_buffer_head = head;
+				} else {
+					rx_overflow_count++;
+					rx_overflow = true;
 				}
 				CONFIG_CAPTURE_FALLING_EDGE();
 				rx_bit = 0;
@@ -257,6 +310,9 @@ ISR(COMPARE_B_INTERRUPT)
 	if (head != rx_buffer_tail) {
 		rx_buffer[head] = rx_byte;
 		rx_buffer_head = head;
+	} else {
+		rx_overflow_count++;
+		rx_overflow = true;
 	}
 	rx_state = 0;
 	CONFIG_CAPTURE_FALLING_EDGE();
@@ -303,6 +359,23 @@ void AltSoftSerial::flushInput(void)
 	rx_buffer_head = rx_buffer_tail;
 }
 
+bool AltSoftSerial::overflow(void)
+{
+	bool r = rx_overflow || timing_error;
+	rx_overflow = false;
+	timing_error = false;
+	return r;
+}
+
+uint16_t AltSoftSerial::overflowCount(void)
+{
+	uint8_t intr_state = SREG;
+	cli();
+	uint16_t count = rx_overflow_count;
+	SREG = intr_state;
+	return count;
+}
+
 
 #ifdef ALTSS_USE_FTM0
 void ftm0_isr(void)
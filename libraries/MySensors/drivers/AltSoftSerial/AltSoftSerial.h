@@ -39,6 +39,13 @@
 #define ALTSS_BASE_FREQ F_CPU
 #endif
 
+#ifndef ALTSS_RX_BUFFER_SIZE
+#define ALTSS_RX_BUFFER_SIZE 80 //!< Receive ring size in bytes (one slot stays free, max 255)
+#endif
+#ifndef ALTSS_TX_BUFFER_SIZE
+#define ALTSS_TX_BUFFER_SIZE 68 //!< Transmit ring size in bytes (one slot stays free, max 255)
+#endif
+
 /** AltSoftSerial class */
 class AltSoftSerial : public Stream
 {
@@ -60,11 +67,16 @@ public:
 	using Print::write;
 	static void flushInput(); //!< flushInput
 	static void flushOutput(); //!< flushOutput
+	static void setTransmitEnablePin(int8_t pin); //!< setTransmitEnablePin (RS485 driver enable, HIGH from the first start bit to the last stop bit)
+	virtual int availableForWrite(); //!< availableForWrite (bytes that can be written without blocking, overrides Print on cores that declare it)
+	static bool isTransmitting(); //!< isTransmitting (true until the stop bit of the last written byte is out)
+	static void setWriteCompleteCallback(void (*callback)(void)); //!< setWriteCompleteCallback (called from the interrupt once all written bytes are out)
 	// for drop-in compatibility with NewSoftSerial, rxPin & txPin ignored
 	//AltSoftSerial(uint8_t rxPin, uint8_t txPin, bool inverse = false) { }
 	bool listen() { return false; } //!< listen
 	bool isListening() { return true; } //!< isListening
-	bool overflow() { bool r = timing_error; timing_error = false; return r; } //!< overflow
+	static bool overflow(); //!< overflow (receive buffer overflow or timing error since the last call)
+	static uint16_t overflowCount(); //!< overflowCount (received bytes dropped on a full buffer since begin)
 	static int library_version() { return 1; } //!< library_version
 	static void enable_timer0(bool) { } //!< enable_timer0
 	static bool timing_error; //!< timing_error
@@ -202,6 +202,36 @@ LOCAL uint8_t RF24_getNodeID(void) {
 	return MY_RF24_NODE_ADDRESS;
 }
 
+LOCAL void RF24_setPALevel(uint8_t level) {
+	// Keep data rate and Si24R1 bit of MY_RF24_RF_SETUP, replace the PA bits
+	RF24_writeByteRegister(RF_SETUP, ((MY_RF24_RF_SETUP) & ~(RF24_PA_MAX << 1)) | (level << 1));
+}
+
+LOCAL void RF24_setChannel(uint8_t channel) {
+	RF24_writeByteRegister(RF_CH, channel);
+}
+
+LOCAL uint8_t RF24_getChannel(void) {
+	return RF24_readByteRegister(RF_CH);
+}
+
+// Counts the samples with a carrier above -64dBm on channel, the radio has to be listening
+LOCAL uint8_t RF24_scanChannel(uint8_t channel, uint8_t samples) {
+	uint8_t hits = 0;
+	RF24_ce(LOW);
+	RF24_setChannel(channel);
+	while (samples--) {
+		RF24_ce(HIGH);
+		// RPD needs 170us in RX mode
+		delayMicroseconds(170);
+		RF24_ce(LOW);
+		if (RF24_readByteRegister(RPD) & 0x01) {
+			hits++;
+		}
+	}
+	return hits;
+}
+
 LOCAL bool RF24_initialize(void) {
 	// Initialize pins
 	pinMode(MY_RF24_CE_PIN,OUTPUT);
@@ -216,7 +246,7 @@ LOCAL bool RF24_initialize(void) {
 	delay(5);
 	// set address width
 	RF24_writeByteRegister(SETUP_AW, MY_RF24_ADDR_WIDTH - 2 );
-	// auto retransmit delay 1500us, auto retransmit count 15
+	// auto retransmit delay by data rate, auto retransmit count 15
 	RF24_writeByteRegister(SETUP_RETR, RF24_ARD << ARD | RF24_ARC << ARC);
 	// set channel
 	RF24_writeByteRegister(RF_CH, MY_RF24_CHANNEL);
@@ -62,7 +62,12 @@
 #endif
 
 // RF24 settings
-#define MY_RF24_CONFIGURATION (uint8_t) (RF24_CRC_16 << 2)
+#if defined(MY_RF24_IRQ_PIN)
+	// only RX_DR asserts the IRQ line, TX status is still polled
+	#define MY_RF24_CONFIGURATION (uint8_t) ((RF24_CRC_16 << 2) | _BV(MASK_TX_DS) | _BV(MASK_MAX_RT))
+#else
+	#define MY_RF24_CONFIGURATION (uint8_t) (RF24_CRC_16 << 2)
+#endif
 #define MY_RF24_FEATURE (uint8_t)( _BV(EN_DPL) | _BV(EN_ACK_PAY) )
 #define MY_RF24_RF_SETUP (uint8_t)( ((MY_RF24_DATARATE & 0b10 ) << 4) | ((MY_RF24_DATARATE & 0b01 ) << 3) | (MY_RF24_PA_LEVEL << 1) ) + 1 // +1 for Si24R1
 
@@ -93,8 +98,13 @@
 #define RF24_CRC_8 			2 
 #define RF24_CRC_16 		3
 
-// ARD, auto retry delay
-#define RF24_ARD 5 //=1500us
+// ARD, auto retry delay in steps of 250us. Only has to cover an empty ACK (no ACK payloads are used),
+// 250kbps needs 500us or more, 1 and 2Mbps are fine with 500us
+#if MY_RF24_DATARATE == RF24_250KBPS
+	#define RF24_ARD 2 //=750us
+#else
+	#define RF24_ARD 1 //=500us
+#endif
 
 // ARD, auto retry count
 #define RF24_ARC 15
@@ -232,6 +242,10 @@ LOCAL bool RF24_isDataAvailable(uint8_t* to);
 LOCAL uint8_t RF24_readMessage(void* buf); 
 LOCAL void RF24_setNodeAddress(uint8_t address);
 LOCAL uint8_t RF24_getNodeID(void);
+LOCAL void RF24_setPALevel(uint8_t level);
+LOCAL void RF24_setChannel(uint8_t channel);
+LOCAL uint8_t RF24_getChannel(void);
+LOCAL uint8_t RF24_scanChannel(uint8_t channel, uint8_t samples);
 LOCAL bool RF24_initialize(void);
 
 #endif // __RF24_H__
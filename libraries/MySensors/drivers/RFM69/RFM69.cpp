@@ -90,6 +90,18 @@ bool RFM69::initialize(uint8_t freqBand, uint8_t nodeID, uint8_t networkID)
   digitalWrite(_slaveSelectPin, HIGH);
   pinMode(_slaveSelectPin, OUTPUT);
   SPI.begin();
+#if defined (SPCR) && defined (SPSR)
+  // work out the RFM69 SPI settings once, select() just loads them
+  uint8_t spcr = SPCR;
+  uint8_t spsr = SPSR;
+  SPI.setDataMode(SPI_MODE0);
+  SPI.setBitOrder(MSBFIRST);
+  SPI.setClockDivider(SPI_CLOCK_DIV4); // decided to slow down from DIV2 after SPI stalling in some instances, especially visible on mega1284p when RFM69 and FLASH chip both present
+  _SPCR_RFM69 = SPCR;
+  _SPSR_RFM69 = SPSR;
+  SPCR = spcr;
+  SPSR = spsr;
+#endif
   unsigned long start = millis();
   uint8_t timeout = 50;
   do {
@@ -304,15 +316,10 @@ void RFM69::sendFrame(uint8_t toAddress, const void* buffer, uint8_t bufferSize,
     CTLbyte = RFM69_CTL_REQACK;
 
   // write to FIFO
+  uint8_t header[5] = { REG_FIFO | 0x80, (uint8_t)(bufferSize + 3), toAddress, _address, CTLbyte };
   select();
-  SPI.transfer(REG_FIFO | 0x80);
-  SPI.transfer(bufferSize + 3);
-  SPI.transfer(toAddress);
-  SPI.transfer(_address);
-  SPI.transfer(CTLbyte);
-
-  for (uint8_t i = 0; i < bufferSize; i++)
-    SPI.transfer(((uint8_t*) buffer)[i]);
+  spiWrite(header, sizeof(header));
+  spiWrite((const uint8_t*) buffer, bufferSize);
   unselect();
 
   // no need to wait for transmit mode to be ready since its handled by the radio
@@ -355,10 +362,7 @@ void RFM69::interruptHandler() {
     
     interruptHook(CTLbyte);     // TWS: hook to derived class interrupt function
 
-    for (uint8_t i = 0; i < DATALEN; i++)
-    {
-      DATA[i] = SPI.transfer(0);
-    }
+    spiRead((uint8_t*) DATA, DATALEN);
     if (DATALEN < RF69_MAX_DATA_LEN) DATA[DATALEN] = 0; // add null at end of string
     unselect();
     setMode(RF69_MODE_RX);
@@ -456,14 +460,17 @@ void RFM69::writeReg(uint8_t addr, uint8_t value)
 void RFM69::select() {
   noInterrupts();
 #if defined (SPCR) && defined (SPSR)
-  // save current SPI settings
+  // save current SPI settings, set RFM69 SPI settings
   _SPCR = SPCR;
   _SPSR = SPSR;
-#endif
+  SPCR = _SPCR_RFM69;
+  SPSR = _SPSR_RFM69;
+#else
   // set RFM69 SPI settings
   SPI.setDataMode(SPI_MODE0);
   SPI.setBitOrder(MSBFIRST);
   SPI.setClockDivider(SPI_CLOCK_DIV4); // decided to slow down from DIV2 after SPI stalling in some instances, especially visible on mega1284p when RFM69 and FLASH chip both present
+#endif
   digitalWrite(_slaveSelectPin, LOW);
 }
 
@@ -478,6 +485,38 @@ void RFM69::unselect() {
   interrupts();
 }
 
+// write len bytes to the selected RFM69 in one burst
+void RFM69::spiWrite(const uint8_t* buffer, uint8_t len) {
+#if defined (SPDR) && defined (SPSR)
+  // drive the SPI registers directly, no call per byte
+  while (len--) {
+    SPDR = *buffer++;
+    while (!(SPSR & _BV(SPIF)));
+  }
+#elif defined (ARDUINO_ARCH_ESP8266)
+  // goes through the 64 byte hardware FIFO
+  SPI.writeBytes((uint8_t*) buffer, len);
+#else
+  while (len--)
+    SPI.transfer(*buffer++);
+#endif
+}
+
+// read len bytes from the selected RFM69 in one burst
+void RFM69::spiRead(uint8_t* buffer, uint8_t len) {
+#if defined (SPDR) && defined (SPSR)
+  while (len--) {
+    SPDR = 0;
+    while (!(SPSR & _BV(SPIF)));
+    *buffer++ = SPDR;
+  }
+#else
+  // block transfer, sends out the buffer and replaces it with the bytes read
+  memset(buffer, 0, len);
+  SPI.transfer(buffer, len);
+#endif
+}
+
 // true  = disable filtering to capture all frames on network
 // false = enable node/broadcast filtering to capture only frames sent to this/broadcast address
 void RFM69::promiscuous(bool onOff) {
@@ -145,6 +145,8 @@ class RFM69 {
 #if defined (SPCR) && defined (SPSR)
     uint8_t _SPCR; //!< _SPCR
     uint8_t _SPSR; //!< _SPSR
+    uint8_t _SPCR_RFM69; //!< SPCR with the RFM69 settings, set up once in initialize()
+    uint8_t _SPSR_RFM69; //!< SPSR with the RFM69 settings, set up once in initialize()
 #endif
 
     virtual void receiveBegin(); //!< receiveBegin
@@ -152,6 +154,8 @@ class RFM69 {
     virtual void setHighPowerRegs(bool onOff); //!< setHighPowerRegs
     virtual void select(); //!< select
     virtual void unselect(); //!< unselect
+    void spiWrite(const uint8_t* buffer, uint8_t len); //!< spiWrite (burst write between select() and unselect())
+    void spiRead(uint8_t* buffer, uint8_t len); //!< spiRead (burst read between select() and unselect())
 };
 
 #endif
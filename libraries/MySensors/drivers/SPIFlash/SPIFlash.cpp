@@ -50,6 +50,7 @@ uint8_t SPIFlash::UNIQUEID[8];
 SPIFlash::SPIFlash(uint8_t slaveSelectPin, uint16_t jedecID) {
   _slaveSelectPin = slaveSelectPin;
   _jedecID = jedecID;
+  _readyCallback = NULL;
 }
 
 /// Select the flash chip
@@ -326,6 +327,52 @@ void SPIFlash::blockErase32K(uint32_t addr) {
   unselect();
 }
 
+/// start programming without waiting for a previous write/erase to finish
+/// only the bytes up to the end of the page are programmed, the return value
+/// tells how many (0 if the chip is still busy), continue with the rest later
+uint16_t SPIFlash::startWriteBytes(uint32_t addr, const void* buf, uint16_t len) {
+  if (busy()) return 0;
+#ifdef MY_SPIFLASH_SST25TYPE
+  //AAI Word Programming has to wait between words anyway
+  writeBytes(addr, buf, len);
+  return len;
+#else
+  uint16_t n = 256-(addr%256);
+  if (len < n) n = len;
+  command(SPIFLASH_BYTEPAGEPROGRAM, true);  // Byte/Page Program
+  SPI.transfer(addr >> 16);
+  SPI.transfer(addr >> 8);
+  SPI.transfer(addr);
+  for (uint16_t i = 0; i < n; i++)
+    SPI.transfer(((uint8_t*) buf)[i]);
+  unselect();
+  return n;
+#endif
+}
+
+/// start erasing a 4Kbyte block without waiting for a previous write/erase to finish
+/// returns false if the chip is still busy
+boolean SPIFlash::startBlockErase4K(uint32_t addr) {
+  if (busy()) return false;
+  blockErase4K(addr);
+  return true;
+}
+
+/// have poll() call callback once the current write/erase has finished
+/// (right away on the next poll() if the chip is idle)
+void SPIFlash::onReady(SPIFlashCallback callback) {
+  _readyCallback = callback;
+}
+
+/// check for completion of a write/erase, one status read while a callback is pending
+void SPIFlash::poll() {
+  if (_readyCallback && !busy()) {
+    SPIFlashCallback callback = _readyCallback;
+    _readyCallback = NULL;
+    callback();
+  }
+}
+
 void SPIFlash::sleep() {
   command(SPIFLASH_SLEEP);
   unselect();
@@ -111,6 +111,9 @@
 	#define MY_SPIFLASH_SST25TYPE
  #endif
 											  
+/// Called from SPIFlash::poll() when a write/erase has finished, see SPIFlash::onReady()
+typedef void (*SPIFlashCallback)(void);
+
 /** SPIFlash class */
 class SPIFlash {
 public:
@@ -127,6 +130,10 @@ public:
   void chipErase(); //!< erase entire flash memory array
   void blockErase4K(uint32_t address); //!< erase a 4Kbyte block
   void blockErase32K(uint32_t address); //!< erase a 32Kbyte block
+  uint16_t startWriteBytes(uint32_t addr, const void* buf, uint16_t len); //!< start programming up to the end of the page without waiting, returns bytes started (0 if busy)
+  boolean startBlockErase4K(uint32_t address); //!< start erasing a 4Kbyte block without waiting, false if busy
+  void onReady(SPIFlashCallback callback); //!< have poll() call callback once the chip is no longer busy
+  void poll(); //!< cheap completion check, calls the onReady() callback when the chip is done
   uint16_t readDeviceId(); //!< Get the manufacturer and device ID bytes (as a short word)
   uint8_t* readUniqueId(); //!< Get the 64 bit unique identifier, stores it in @ref UNIQUEID[8]
   
@@ -140,6 +147,7 @@ protected:
   uint16_t _jedecID; //!< JEDEC ID
   uint8_t _SPCR; //!< SPCR
   uint8_t _SPSR; //!< SPSR
+  SPIFlashCallback _readyCallback; //!< pending onReady() callback
 #ifdef SPI_HAS_TRANSACTION
   SPISettings _settings;
 #endif
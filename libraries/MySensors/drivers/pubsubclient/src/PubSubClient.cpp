@@ -9,6 +9,8 @@
 
 PubSubClient::PubSubClient() {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     this->_client = NULL;
     this->stream = NULL;
     setCallback(NULL);
@@ -16,24 +18,32 @@ PubSubClient::PubSubClient() {
 
 PubSubClient::PubSubClient(Client& client) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setClient(client);
     this->stream = NULL;
 }
 
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(addr, port);
     setClient(client);
     this->stream = NULL;
 }
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(addr,port);
     setClient(client);
     setStream(stream);
 }
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(addr, port);
     setCallback(callback);
     setClient(client);
@@ -41,6 +51,8 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATUR
 }
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(addr,port);
     setCallback(callback);
     setClient(client);
@@ -49,18 +61,24 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATUR
 
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(ip, port);
     setClient(client);
     this->stream = NULL;
 }
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(ip,port);
     setClient(client);
     setStream(stream);
 }
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(ip, port);
     setCallback(callback);
     setClient(client);
@@ -68,6 +86,8 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE,
 }
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(ip,port);
     setCallback(callback);
     setClient(client);
@@ -76,18 +96,24 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE,
 
 PubSubClient::PubSubClient(const char* domain, uint16_t port, Client& client) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(domain,port);
     setClient(client);
     this->stream = NULL;
 }
 PubSubClient::PubSubClient(const char* domain, uint16_t port, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(domain,port);
     setClient(client);
     setStream(stream);
 }
 PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(domain,port);
     setCallback(callback);
     setClient(client);
@@ -95,6 +121,8 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGN
 }
 PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client, Stream& stream) {
     this->_state = MQTT_DISCONNECTED;
+    this->streamCallback = NULL;
+    this->inflightLen = 0;
     setServer(domain,port);
     setCallback(callback);
     setClient(client);
@@ -123,7 +151,10 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
             result = _client->connect(this->ip, this->port);
         }
         if (result) {
-            nextMsgId = 1;
+            if (inflightLen == 0) {
+                // Otherwise keep counting, the in-flight ids must stay unique
+                nextMsgId = 1;
+            }
             // Leave room in the buffer for header and variable length field
             uint16_t length = 5;
             unsigned int j;
@@ -171,11 +202,14 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
                 }
             }
 
+            readState = MQTT_READ_HEADER;
             write(MQTTCONNECT,buffer,length-5);
 
             lastInActivity = lastOutActivity = millis();
 
-            while (!_client->available()) {
+            uint8_t llen;
+            uint16_t len;
+            while ((len = readPacket(&llen)) == 0) {
                 unsigned long t = millis();
                 if (t-lastInActivity > MQTT_KEEPALIVE*1000UL) {
                     _state = MQTT_CONNECTION_TIMEOUT;
@@ -183,14 +217,18 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
                     return false;
                 }
             }
-            uint8_t llen;
-            uint16_t len = readPacket(&llen);
 
             if (len == 4) {
                 if (buffer[3] == 0) {
                     lastInActivity = millis();
                     pingOutstanding = false;
                     _state = MQTT_CONNECTED;
+#if MQTT_MAX_INFLIGHT > 0
+                    // Publishes the last connection left unacknowledged go out again
+                    for (uint8_t i=0;i<inflightLen;i++) {
+                        sendInflight(i);
+                    }
+#endif
                     return true;
                 } else {
                     _state = buffer[3];
@@ -205,59 +243,89 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
     return true;
 }
 
-uint8_t PubSubClient::readByte() {
-    while(!_client->available()) {}
-    return _client->read();
-}
-
 uint16_t PubSubClient::readPacket(uint8_t* lengthLength) {
-    uint16_t len = 0;
-    buffer[len++] = readByte();
-    bool isPublish = (buffer[0]&0xF0) == MQTTPUBLISH;
-    uint32_t multiplier = 1;
-    uint16_t length = 0;
-    uint8_t digit = 0;
-    uint16_t skip = 0;
-    uint8_t start = 0;
-
-    do {
-        digit = readByte();
-        buffer[len++] = digit;
-        length += (digit & 127) * multiplier;
-        multiplier *= 128;
-    } while ((digit & 128) != 0);
-    *lengthLength = len-1;
-
-    if (isPublish) {
-        // Read in topic length to calculate bytes to skip over for Stream writing
-        buffer[len++] = readByte();
-        buffer[len++] = readByte();
-        skip = (buffer[*lengthLength+1]<<8)+buffer[*lengthLength+2];
-        start = 2;
-        if (buffer[0]&MQTTQOS1) {
-            // skip message id
-            skip += 2;
+    // Only takes what the client already has, a partly received packet is
+    // kept in buffer and finished on a later call
+    while (_client->available()) {
+        uint8_t digit = _client->read();
+        if (readState == MQTT_READ_HEADER) {
+            readLen = 0;
+            buffer[readLen++] = digit;
+            readLength = 0;
+            readMultiplier = 1;
+            readCount = 0;
+            readSkip = 0;
+            readOffset = 0;
+            readState = MQTT_READ_LENGTH;
+            continue;
         }
-    }
-
-    for (uint16_t i = start;i<length;i++) {
-        digit = readByte();
-        if (this->stream) {
-            if (isPublish && len-*lengthLength-2>skip) {
-                this->stream->write(digit);
+        bool isPublish = (buffer[0]&0xF0) == MQTTPUBLISH;
+        if (readState == MQTT_READ_LENGTH) {
+            buffer[readLen++] = digit;
+            readLength += (digit & 127) * readMultiplier;
+            readMultiplier *= 128;
+            if ((digit & 128) != 0) {
+                continue;
+            }
+            readLengthLength = readLen-1;
+            readState = MQTT_READ_BODY;
+        } else {
+            if (this->stream) {
+                if (isPublish && readCount >= readSkip+2) {
+                    this->stream->write(digit);
+                }
+            }
+            if (readLen < MQTT_MAX_PACKET_SIZE) {
+                buffer[readLen] = digit;
+            }
+            readLen++;
+            readCount++;
+            if (isPublish && readCount == 2) {
+                // Topic length read, calculate bytes to skip over for Stream writing
+                readSkip = (buffer[readLengthLength+1]<<8)+buffer[readLengthLength+2];
+                if (buffer[0]&MQTTQOS1) {
+                    // skip message id
+                    readSkip += 2;
+                }
+            }
+            if (isPublish && streamCallback && readLen == MQTT_MAX_PACKET_SIZE && readCount < readLength) {
+                streamSlice(false);
             }
         }
-        if (len < MQTT_MAX_PACKET_SIZE) {
-            buffer[len] = digit;
+        if (readCount == readLength) {
+            readState = MQTT_READ_HEADER;
+            *lengthLength = readLengthLength;
+            if (isPublish && streamCallback) {
+                streamSlice(true);
+            }
+            if (!this->stream && readLen > MQTT_MAX_PACKET_SIZE) {
+                return 0; // This will cause the packet to be ignored.
+            }
+            return readLen;
         }
-        len++;
     }
-
-    if (!this->stream && len > MQTT_MAX_PACKET_SIZE) {
-        len = 0; // This will cause the packet to be ignored.
+    return 0;
+}
+
+void PubSubClient::streamSlice(boolean last) {
+    // Hands the payload bytes read since the previous slice to streamCallback
+    // and frees their room in buffer; header, topic and msgId stay in place
+    uint16_t start = readLengthLength+3+readSkip;
+    // readLen goes on counting past the end of buffer when topic and header
+    // alone do not fit, those bytes were not stored
+    uint16_t end = readLen < MQTT_MAX_PACKET_SIZE ? readLen : MQTT_MAX_PACKET_SIZE;
+    if (readCount < 2 || start > end || (start == end && !last)) {
+        return;
     }
-
-    return len;
+    uint16_t tl = (buffer[readLengthLength+1]<<8)+buffer[readLengthLength+2];
+    char topic[tl+1];
+    for (uint16_t i=0;i<tl;i++) {
+        topic[i] = buffer[readLengthLength+3+i];
+    }
+    topic[tl] = 0;
+    streamCallback(topic,buffer+start,end-start,readOffset,readLength-readSkip-2);
+    readOffset += end-start;
+    readLen = start;
 }
 
 boolean PubSubClient::loop() {
@@ -277,6 +345,13 @@ boolean PubSubClient::loop() {
                 pingOutstanding = true;
             }
         }
+#if MQTT_MAX_INFLIGHT > 0
+        for (uint8_t i=0;i<inflightLen;i++) {
+            if (t - inflightQueue[i].sent > MQTT_INFLIGHT_TIMEOUT*1000UL) {
+                sendInflight(i);
+            }
+        }
+#endif
         if (_client->available()) {
             uint8_t llen;
             uint16_t len = readPacket(&llen);
@@ -286,7 +361,7 @@ boolean PubSubClient::loop() {
                 lastInActivity = t;
                 uint8_t type = buffer[0]&0xF0;
                 if (type == MQTTPUBLISH) {
-                    if (callback) {
+                    if (callback || streamCallback) {
                         uint16_t tl = (buffer[llen+1]<<8)+buffer[llen+2];
                         char topic[tl+1];
                         for (uint16_t i=0;i<tl;i++) {
@@ -296,8 +371,10 @@ boolean PubSubClient::loop() {
                         // msgId only present for QOS>0
                         if ((buffer[0]&0x06) == MQTTQOS1) {
                             msgId = (buffer[llen+3+tl]<<8)+buffer[llen+3+tl+1];
-                            payload = buffer+llen+3+tl+2;
-                            callback(topic,payload,len-llen-3-tl-2);
+                            if (!streamCallback) {
+                                payload = buffer+llen+3+tl+2;
+                                callback(topic,payload,len-llen-3-tl-2);
+                            }
 
                             buffer[0] = MQTTPUBACK;
                             buffer[1] = 2;
@@ -306,7 +383,7 @@ boolean PubSubClient::loop() {
                             _client->write(buffer,4);
                             lastOutActivity = t;
 
-                        } else {
+                        } else if (!streamCallback) {
                             payload = buffer+llen+3+tl;
                             callback(topic,payload,len-llen-3-tl);
                         }
@@ -317,6 +394,17 @@ boolean PubSubClient::loop() {
                     _client->write(buffer,2);
                 } else if (type == MQTTPINGRESP) {
                     pingOutstanding = false;
+#if MQTT_MAX_INFLIGHT > 0
+                } else if (type == MQTTPUBACK) {
+                    msgId = (buffer[llen+1]<<8)+buffer[llen+2];
+                    for (uint8_t i=0;i<inflightLen;i++) {
+                        if (inflightQueue[i].msgId == msgId) {
+                            inflightLen--;
+                            memmove(&inflightQueue[i],&inflightQueue[i+1],(inflightLen-i)*sizeof(InflightPublish));
+                            break;
+                        }
+                    }
+#endif
                 }
             }
         }
@@ -359,6 +447,72 @@ boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigne
     return false;
 }
 
+boolean PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained, uint8_t qos) {
+    if (qos == 0) {
+        return publish(topic,payload,plength,retained);
+    }
+#if MQTT_MAX_INFLIGHT > 0
+    if (qos == 1 && connected() && inflightLen < MQTT_MAX_INFLIGHT) {
+        if (MQTT_MAX_PACKET_SIZE < 5 + 2+strlen(topic) + 2 + plength) {
+            // Too long
+            return false;
+        }
+        // Leave room in the buffer for header and variable length field
+        uint16_t length = 5;
+        length = writeString(topic,buffer,length);
+        nextId();
+        buffer[length++] = (nextMsgId >> 8);
+        buffer[length++] = (nextMsgId & 0xFF);
+        uint16_t i;
+        for (i=0;i<plength;i++) {
+            buffer[length++] = payload[i];
+        }
+        uint8_t header = MQTTPUBLISH|MQTTQOS1;
+        if (retained) {
+            header |= 1;
+        }
+        uint8_t hlen = buildHeader(header,buffer,length-5);
+        InflightPublish* p = &inflightQueue[inflightLen];
+        p->msgId = nextMsgId;
+        p->length = length-(5-hlen);
+        memcpy(p->packet,buffer+(5-hlen),p->length);
+        // Kept until its PUBACK arrives, loop() sends it again if that takes too long
+        sendInflight(inflightLen++);
+        return true;
+    }
+#endif
+    return false;
+}
+
+#if MQTT_MAX_INFLIGHT > 0
+void PubSubClient::sendInflight(uint8_t i) {
+    writePacket(inflightQueue[i].packet,inflightQueue[i].length);
+    inflightQueue[i].sent = millis();
+    // Any later copy is a duplicate, flag it for the server
+    inflightQueue[i].packet[0] |= 0x08;
+}
+#endif
+
+// Moves nextMsgId on to the next valid id: MQTT does not allow 0, and an id
+// the server has not acknowledged yet must not be used twice
+uint16_t PubSubClient::nextId() {
+    boolean used;
+    do {
+        nextMsgId++;
+        used = (nextMsgId == 0);
+#if MQTT_MAX_INFLIGHT > 0
+        for (uint8_t i=0;i<inflightLen && !used;i++) {
+            used = (inflightQueue[i].msgId == nextMsgId);
+        }
+#endif
+    } while (used);
+    return nextMsgId;
+}
+
+uint8_t PubSubClient::inflight() {
+    return inflightLen;
+}
+
 boolean PubSubClient::publish_P(const char* topic, const uint8_t* payload, unsigned int plength, boolean retained) {
     uint8_t llen = 0;
     uint8_t digit;
@@ -404,13 +558,71 @@ boolean PubSubClient::publish_P(const char* topic, const uint8_t* payload, unsig
     return rc == tlen + 4 + plength;
 }
 
-boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length) {
+boolean PubSubClient::beginPublish(const char* topic, unsigned int plength, boolean retained) {
+    if (connected()) {
+        if (MQTT_MAX_PACKET_SIZE < 5 + 2+strlen(topic)) {
+            // Too long
+            return false;
+        }
+        // Send header and topic now, the payload follows in write() calls
+        uint16_t length = 5;
+        length = writeString(topic,buffer,length);
+        uint8_t header = MQTTPUBLISH;
+        if (retained) {
+            header |= 1;
+        }
+        uint8_t hlen = buildHeader(header,buffer,(uint32_t)plength+length-5);
+        uint16_t rc = _client->write(buffer+(5-hlen),length-(5-hlen));
+        lastOutActivity = millis();
+        return (rc == length-(5-hlen));
+    }
+    return false;
+}
+
+size_t PubSubClient::write(uint8_t data) {
+    lastOutActivity = millis();
+    return _client->write(data);
+}
+
+size_t PubSubClient::write(const uint8_t* buf, size_t size) {
+    lastOutActivity = millis();
+    return _client->write(buf,size);
+}
+
+boolean PubSubClient::publish(const char* topic, Stream& source, unsigned int plength, boolean retained) {
+    if (!beginPublish(topic,plength,retained)) {
+        return false;
+    }
+    // Copied through buffer in chunks, so the payload can be any size
+    while (plength > 0) {
+        size_t n = plength;
+#ifdef MQTT_MAX_TRANSFER_SIZE
+        if (n > MQTT_MAX_TRANSFER_SIZE) {
+            n = MQTT_MAX_TRANSFER_SIZE;
+        }
+#else
+        if (n > MQTT_MAX_PACKET_SIZE) {
+            n = MQTT_MAX_PACKET_SIZE;
+        }
+#endif
+        n = source.readBytes((char*)buffer,n);
+        if (n == 0 || write(buffer,n) != n) {
+            // The packet can't be completed, the connection is unusable
+            _state = MQTT_CONNECTION_LOST;
+            _client->stop();
+            return false;
+        }
+        plength -= n;
+    }
+    return true;
+}
+
+uint8_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint32_t length) {
     uint8_t lenBuf[4];
     uint8_t llen = 0;
     uint8_t digit;
     uint8_t pos = 0;
-    uint8_t rc;
-    uint16_t len = length;
+    uint32_t len = length;
     do {
         digit = len % 128;
         len = len / 128;
@@ -425,10 +637,19 @@ boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length) {
     for (int i=0;i<llen;i++) {
         buf[5-llen+i] = lenBuf[i];
     }
+    return llen+1;
+}
 
+boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length) {
+    uint8_t llen = buildHeader(header,buf,length)-1;
+    return writePacket(buf+(4-llen),length+1+llen);
+}
+
+boolean PubSubClient::writePacket(const uint8_t* buf, uint16_t length) {
+    uint16_t rc;
 #ifdef MQTT_MAX_TRANSFER_SIZE
-    uint8_t* writeBuf = buf+(4-llen);
-    uint8_t bytesRemaining = length+1+llen;
+    const uint8_t* writeBuf = buf;
+    uint16_t bytesRemaining = length;
     uint8_t bytesToWrite;
     boolean result = true;
     while((bytesRemaining > 0) && result) {
@@ -440,9 +661,9 @@ boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length) {
     }
     return result;
 #else
-    rc = _client->write(buf+(4-llen),length+1+llen);
+    rc = _client->write(buf,length);
     lastOutActivity = millis();
-    return (rc == 1+llen+length);
+    return (rc == length);
 #endif
 }
 
@@ -461,10 +682,7 @@ boolean PubSubClient::subscribe(const char* topic, uint8_t qos) {
     if (connected()) {
         // Leave room in the buffer for header and variable length field
         uint16_t length = 5;
-        nextMsgId++;
-        if (nextMsgId == 0) {
-            nextMsgId = 1;
-        }
+        nextId();
         buffer[length++] = (nextMsgId >> 8);
         buffer[length++] = (nextMsgId & 0xFF);
         length = writeString((char*)topic, buffer,length);
@@ -481,10 +699,7 @@ boolean PubSubClient::unsubscribe(const char* topic) {
     }
     if (connected()) {
         uint16_t length = 5;
-        nextMsgId++;
-        if (nextMsgId == 0) {
-            nextMsgId = 1;
-        }
+        nextId();
         buffer[length++] = (nextMsgId >> 8);
         buffer[length++] = (nextMsgId & 0xFF);
         length = writeString(topic, buffer,length);
@@ -556,6 +771,11 @@ PubSubClient& PubSubClient::setCallback(void(*callback)(char*,uint8_t*,unsigned
     return *this;
 }
 
+PubSubClient& PubSubClient::setStreamCallback(MQTT_STREAM_CALLBACK_SIGNATURE){
+    this->streamCallback = streamCallback;
+    return *this;
+}
+
 PubSubClient& PubSubClient::setClient(Client& client){
     this->_client = &client;
     return *this;
@@ -25,6 +25,16 @@
 // MQTT_KEEPALIVE : keepAlive interval in Seconds
 #define MQTT_KEEPALIVE 15
 
+// MQTT_MAX_INFLIGHT : QoS 1 publishes that can wait for their PUBACK at the same
+//  time. Each keeps a copy of its packet, MQTT_MAX_PACKET_SIZE bytes of RAM.
+//  0 leaves QoS 1 publishing out.
+#ifndef MQTT_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT 2
+#endif
+
+// MQTT_INFLIGHT_TIMEOUT : seconds before an unacknowledged QoS 1 publish is sent again
+#define MQTT_INFLIGHT_TIMEOUT 10
+
 // MQTT_MAX_TRANSFER_SIZE : limit how much data is passed to the network client
 //  in each write call. Needed for the Arduino Wifi Shield. Leave undefined to
 //  pass the entire MQTT packet in each write call.
@@ -42,6 +52,12 @@
 #define MQTT_CONNECT_BAD_CREDENTIALS 4
 #define MQTT_CONNECT_UNAUTHORIZED    5
 
+// readPacket() states, a packet is read over as many loop() calls as its
+// bytes take to arrive
+#define MQTT_READ_HEADER 0
+#define MQTT_READ_LENGTH 1
+#define MQTT_READ_BODY   2
+
 #define MQTTCONNECT     1 << 4  // Client request to connect to Server
 #define MQTTCONNACK     2 << 4  // Connect Acknowledgment
 #define MQTTPUBLISH     3 << 4  // Publish message
@@ -63,6 +79,9 @@
 #define MQTTQOS2        (2 << 1)
 
 #define MQTT_CALLBACK_SIGNATURE void (*callback)(char*,uint8_t*,unsigned int)
+// Receives a large payload in slices of up to the free room in buffer:
+// topic, slice, slice length, offset of the slice in the payload, payload length
+#define MQTT_STREAM_CALLBACK_SIGNATURE void (*streamCallback)(char*,uint8_t*,unsigned int,unsigned int,unsigned int)
 
 /** PubSubClient class */
 class PubSubClient {
@@ -74,9 +93,32 @@ private:
    unsigned long lastInActivity;
    bool pingOutstanding;
    MQTT_CALLBACK_SIGNATURE;
+   MQTT_STREAM_CALLBACK_SIGNATURE;
    uint16_t readPacket(uint8_t*);
-   uint8_t readByte();
+   uint8_t readState;
+   uint8_t readLengthLength;
+   uint16_t readLen;
+   uint16_t readLength;
+   uint16_t readCount;
+   uint16_t readSkip;
+   uint32_t readMultiplier;
+   uint16_t readOffset;
+   void streamSlice(boolean last);
+   uint8_t buildHeader(uint8_t header, uint8_t* buf, uint32_t length);
    boolean write(uint8_t header, uint8_t* buf, uint16_t length);
+   boolean writePacket(const uint8_t* buf, uint16_t length);
+#if MQTT_MAX_INFLIGHT > 0
+   struct InflightPublish {
+      uint16_t msgId;
+      unsigned long sent;
+      uint16_t length;
+      uint8_t packet[MQTT_MAX_PACKET_SIZE];
+   };
+   InflightPublish inflightQueue[MQTT_MAX_INFLIGHT];
+   void sendInflight(uint8_t i);
+#endif
+   uint8_t inflightLen;
+   uint16_t nextId();
    uint16_t writeString(const char* string, uint8_t* buf, uint16_t pos);
    IPAddress ip;
    const char* domain;
@@ -103,6 +145,7 @@ public:
    PubSubClient& setServer(uint8_t * ip, uint16_t port); //!< setServer
    PubSubClient& setServer(const char * domain, uint16_t port); //!< setServer
    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE); //!< setCallback
+   PubSubClient& setStreamCallback(MQTT_STREAM_CALLBACK_SIGNATURE); //!< setStreamCallback, takes incoming payloads instead of the callback
    PubSubClient& setClient(Client& client); //!< setClient
    PubSubClient& setStream(Stream& stream); //!< setStream
 
@@ -115,13 +158,19 @@ public:
    boolean publish(const char* topic, const char* payload, boolean retained); //!< publish
    boolean publish(const char* topic, const uint8_t * payload, unsigned int plength); //!< publish
    boolean publish(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained); //!< publish
+   boolean publish(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained, uint8_t qos); //!< publish at QoS 0 or 1, false if the in-flight window is full
    boolean publish_P(const char* topic, const uint8_t * payload, unsigned int plength, boolean retained); //!< publish_P
+   boolean publish(const char* topic, Stream& source, unsigned int plength, boolean retained); //!< publish plength bytes read from source
+   boolean beginPublish(const char* topic, unsigned int plength, boolean retained); //!< beginPublish, send the plength payload bytes with write()
+   size_t write(uint8_t); //!< write payload of beginPublish
+   size_t write(const uint8_t *buf, size_t size); //!< write payload of beginPublish
    boolean subscribe(const char* topic); //!< subscribe
    boolean subscribe(const char* topic, uint8_t qos); //!< subscribe
    boolean unsubscribe(const char* topic); //!< unsubscribe
    boolean loop(); //!< loop
    boolean connected(); //!< connected
    int state(); //!< state
+   uint8_t inflight(); //!< number of QoS 1 publishes waiting for their PUBACK
 };
 
 
@@ -0,0 +1,324 @@
+// Host benchmark and soak run for PubSubClient.
+//
+// Unlike the specs this runs against a simulated broker with a simulated
+// clock, so long runs take seconds:
+//  - QoS 0 and QoS 1 publish throughput
+//  - receive throughput and worst-case loop() time with packets arriving
+//    in random fragments
+//  - heap allocations made by the library
+//  - keepalive over a simulated day, with a healthy and a silent broker
+//
+// Numbers are printed for comparison between versions; the run fails
+// (exit code 1) only on functional errors.
+
+#include "PubSubClient.h"
+#include "Client.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static uint32_t simMillis = 0;
+
+extern "C" {
+    uint32_t millis(void) {
+        return simMillis;
+    }
+}
+
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** Broker side of the connection: answers CONNECT, PINGREQ and QoS 1 PUBLISH,
+ *  and hands queued inbound bytes out in fragments of at most `fragment` bytes */
+class BenchClient : public Client {
+private:
+    uint8_t rx[1 << 16];
+    uint32_t rxHead;
+    uint32_t rxTail;
+    uint8_t frame[MQTT_MAX_PACKET_SIZE + 8];
+    uint16_t frameLen;
+    uint32_t frameRemaining;
+    uint8_t frameLengthBytes;
+    bool frameLengthDone;
+    uint32_t fragmentLeft;
+
+    void push(uint8_t b) {
+        rx[rxTail++ & 0xFFFF] = b;
+    }
+
+    void handleFrame() {
+        uint8_t type = frame[0] & 0xF0;
+        if (type == MQTTCONNECT) {
+            uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+            respond(connack, 4);
+        } else if (type == MQTTPINGREQ) {
+            pings++;
+            if (answerPings) {
+                uint8_t pingresp[] = { 0xD0, 0x00 };
+                respond(pingresp, 2);
+            }
+        } else if (type == MQTTPUBLISH) {
+            published++;
+            if ((frame[0] & 0x06) == MQTTQOS1 && ackPublishes) {
+                uint16_t tl = (frame[1 + frameLengthBytes] << 8) + frame[2 + frameLengthBytes];
+                uint16_t id = 3 + frameLengthBytes + tl;
+                uint8_t puback[] = { 0x40, 0x02, frame[id], frame[id + 1] };
+                respond(puback, 4);
+            }
+        }
+    }
+
+public:
+    bool open;
+    bool answerPings;
+    bool ackPublishes;
+    uint32_t fragment;
+    unsigned long written;
+    unsigned long published;
+    unsigned long pings;
+
+    BenchClient() {
+        rxHead = rxTail = 0;
+        frameLen = 0;
+        frameLengthBytes = 0;
+        frameLengthDone = false;
+        frameRemaining = 0;
+        fragmentLeft = 0;
+        open = false;
+        answerPings = true;
+        ackPublishes = true;
+        fragment = 0;
+        written = published = pings = 0;
+    }
+
+    void respond(const uint8_t* buf, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            push(buf[i]);
+        }
+    }
+
+    // The next TCP segment arrives, up to `fragment` bytes
+    void segment() {
+        fragmentLeft = 1 + rand() % fragment;
+    }
+
+    uint32_t pending() {
+        return rxTail - rxHead;
+    }
+
+    virtual int connect(IPAddress ip, uint16_t port) { open = true; return 1; }
+    virtual int connect(const char* host, uint16_t port) { open = true; return 1; }
+
+    virtual size_t write(uint8_t b) {
+        written++;
+        if (frameLen < sizeof(frame)) {
+            frame[frameLen] = b;
+        }
+        frameLen++;
+        if (frameLen == 1) {
+            frameRemaining = 0;
+            frameLengthBytes = 0;
+            frameLengthDone = false;
+            return 1;
+        }
+        if (!frameLengthDone) {
+            frameRemaining += (b & 127) << (7 * frameLengthBytes++);
+            frameLengthDone = (b & 128) == 0;
+        } else {
+            frameRemaining--;
+        }
+        if (frameLengthDone && frameRemaining == 0) {
+            handleFrame();
+            frameLen = 0;
+        }
+        return 1;
+    }
+    virtual size_t write(const uint8_t* buf, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            write(buf[i]);
+        }
+        return size;
+    }
+
+    virtual int available() {
+        if (pending() == 0) {
+            return 0;
+        }
+        if (fragment == 0) {
+            return pending();
+        }
+        return fragmentLeft < pending() ? fragmentLeft : pending();
+    }
+    virtual int read() {
+        if (pending() == 0) {
+            return -1;
+        }
+        if (fragmentLeft > 0) {
+            fragmentLeft--;
+        }
+        return rx[rxHead++ & 0xFFFF];
+    }
+    virtual int read(uint8_t* buf, size_t size) {
+        size_t i = 0;
+        while (i < size && pending()) {
+            buf[i++] = read();
+        }
+        return i;
+    }
+    virtual int peek() { return pending() ? rx[rxHead & 0xFFFF] : -1; }
+    virtual void flush() {}
+    virtual void stop() { open = false; }
+    virtual uint8_t connected() { return open; }
+    virtual operator bool() { return open; }
+};
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static unsigned long received = 0;
+
+static void callback(char* topic, uint8_t* payload, unsigned int length) {
+    received++;
+}
+
+static byte server[] = { 172, 16, 0, 2 };
+
+static void benchPublish(uint8_t qos, unsigned long count) {
+    BenchClient net;
+    PubSubClient client(server, 1883, callback, net);
+    check(client.connect("bench"), "connect");
+    const uint8_t payload[] = "21.5";
+    unsigned long before = allocations;
+    uint64_t start = nowNs();
+    unsigned long refused = 0;
+    for (unsigned long i = 0; i < count; i++) {
+        if (!client.publish("mygateway1-out/12/1/1/0/0", payload, 4, false, qos)) {
+            // QoS 1 window full, let loop() take the PUBACKs
+            refused++;
+            client.loop();
+            i--;
+        }
+    }
+    while (client.inflight()) {
+        client.loop();
+    }
+    uint64_t ns = nowNs() - start;
+    printf("publish qos%u: %.0f msg/s, %.1f bytes/msg, %lu window stalls, %lu allocations\n",
+           qos, count * 1e9 / ns, (double)net.written / count, refused, allocations - before);
+    check(net.published == count, "all publishes reach the broker");
+}
+
+static void benchReceive(uint32_t fragment, unsigned long count) {
+    BenchClient net;
+    PubSubClient client(server, 1883, callback, net);
+    check(client.connect("bench"), "connect");
+    net.fragment = fragment;
+    received = 0;
+    const uint8_t publish[] = { 0x30, 0x1c, 0x00, 0x16, 'm', 'y', 'g', 'a', 't', 'e', 'w', 'a', 'y', '1', '-', 'i', 'n',
+                                '/', '1', '2', '/', '1', '/', '1', '/', '0', '2', '1', '.', '5' };
+    unsigned long before = allocations;
+    uint64_t worst = 0;
+    uint64_t total = 0;
+    unsigned long loops = 0;
+    for (unsigned long i = 0; i < count; i++) {
+        net.respond(publish, sizeof(publish));
+        while (net.pending()) {
+            if (fragment) {
+                net.segment();
+            }
+            uint64_t start = nowNs();
+            client.loop();
+            uint64_t ns = nowNs() - start;
+            total += ns;
+            loops++;
+            if (ns > worst) {
+                worst = ns;
+            }
+        }
+    }
+    if (fragment) {
+        printf("receive, segments of 1..%u bytes: ", fragment);
+    } else {
+        printf("receive, whole packets: ");
+    }
+    printf("%.0f msg/s, %.2f loops/msg, worst loop() %.1f us, %lu allocations\n",
+           count * 1e9 / total, (double)loops / count, worst / 1e3, allocations - before);
+    check(received == count, "all messages received");
+}
+
+static void soakKeepalive(bool brokerAnswers, uint32_t hours) {
+    BenchClient net;
+    PubSubClient client(server, 1883, callback, net);
+    simMillis = 0;
+    check(client.connect("bench"), "connect");
+    net.answerPings = brokerAnswers;
+    unsigned long lastPings = 0;
+    uint32_t lastPing = 0;
+    uint32_t longestGap = 0;
+    uint32_t lostAt = 0;
+    const uint32_t end = hours * 3600000UL;
+    for (simMillis = 0; simMillis < end; simMillis += 100) {
+        if (!client.loop()) {
+            lostAt = simMillis;
+            break;
+        }
+        if (net.pings != lastPings) {
+            lastPings = net.pings;
+            if (simMillis - lastPing > longestGap) {
+                longestGap = simMillis - lastPing;
+            }
+            lastPing = simMillis;
+        }
+    }
+    if (brokerAnswers) {
+        printf("keepalive soak %uh: %lu pings, longest gap %.1f s\n", hours, net.pings, longestGap / 1e3);
+        check(lostAt == 0, "connection kept with answering broker");
+        check(longestGap <= (MQTT_KEEPALIVE + 1) * 1000UL, "pings within keepalive");
+    } else {
+        printf("silent broker: connection dropped after %.1f s, state %d\n", lostAt / 1e3, client.state());
+        check(lostAt > 0 && lostAt <= 2 * (MQTT_KEEPALIVE + 1) * 1000UL, "silent broker detected within two keepalives");
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 0) : 200000;
+    srand(1);
+    printf("sizeof(PubSubClient) = %u bytes\n", (unsigned)sizeof(PubSubClient));
+    benchPublish(0, count);
+    benchPublish(1, count);
+    benchReceive(0, count);
+    benchReceive(4, count);
+    benchReceive(1, count / 10);
+    soakKeepalive(true, 24);
+    soakKeepalive(false, 1);
+    return failures ? 1 : 0;
+}
@@ -8,15 +8,18 @@
 class Stream {
 private:
     Buffer* expectBuffer;
+    Buffer* responseBuffer;
     bool _error;
     uint16_t _written;
 
 public:
     Stream();
     virtual size_t write(uint8_t); //!< write
+    virtual size_t readBytes(char *buf, size_t size); //!< readBytes
     
     virtual bool error(); //!< error
     virtual void expect(uint8_t *buf, size_t size); //!< expect
+    virtual void respond(uint8_t *buf, size_t size); //!< respond
     virtual uint16_t length(); //!< length
 };
 
@@ -175,6 +175,75 @@ int test_publish_P() {
 
 
 
+int test_publish_stream() {
+    IT("publishes a payload larger than the buffer from a stream");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    int length = 300;
+    byte payload[300];
+    for (int i=0;i<length;i++) {
+        payload[i] = i;
+    }
+    Stream source;
+    source.respond(payload,length);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte publish[] = {0x30,0xb3,0x2,0x0,0x5,0x74,0x6f,0x70,0x69,0x63};
+    shimClient.expect(publish,10);
+    shimClient.expect(payload,length);
+
+    rc = client.publish((char*)"topic",source,length,false);
+    IS_TRUE(rc);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_publish_qos1() {
+    IT("publishes qos1 within the in-flight window");
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte publish1[] = {0x32,0x10,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x2,0x70,0x61,0x79,0x6c,0x6f,0x61,0x64};
+    byte publish2[] = {0x32,0x10,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x0,0x3,0x70,0x61,0x79,0x6c,0x6f,0x61,0x64};
+    shimClient.expect(publish1,18);
+    shimClient.expect(publish2,18);
+
+    rc = client.publish((char*)"topic",(const uint8_t*)"payload",7,false,1);
+    IS_TRUE(rc);
+    rc = client.publish((char*)"topic",(const uint8_t*)"payload",7,false,1);
+    IS_TRUE(rc);
+    IS_TRUE(client.inflight() == MQTT_MAX_INFLIGHT);
+
+    rc = client.publish((char*)"topic",(const uint8_t*)"payload",7,false,1);
+    IS_FALSE(rc);
+
+    byte puback[] = {0x40,0x2,0x0,0x2};
+    shimClient.respond(puback,4);
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_TRUE(client.inflight() == MQTT_MAX_INFLIGHT-1);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
 int main()
 {
     SUITE("Publish");
@@ -185,6 +254,8 @@ int main()
     test_publish_not_connected();
     test_publish_too_long();
     test_publish_P();
+    test_publish_stream();
+    test_publish_qos1();
 
     FINISH
 }
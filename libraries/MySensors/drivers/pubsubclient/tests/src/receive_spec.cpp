@@ -11,12 +11,14 @@ bool callback_called = false;
 char lastTopic[1024];
 char lastPayload[1024];
 unsigned int lastLength;
+unsigned int sliceCount;
 
 void reset_callback() {
     callback_called = false;
     lastTopic[0] = '\0';
     lastPayload[0] = '\0';
     lastLength = 0;
+    sliceCount = 0;
 }
 
 void callback(char* topic, byte* payload, unsigned int length) {
@@ -26,6 +28,14 @@ void callback(char* topic, byte* payload, unsigned int length) {
     lastLength = length;
 }
 
+void stream_callback(char* topic, byte* slice, unsigned int length, unsigned int offset, unsigned int total) {
+    callback_called = true;
+    strcpy(lastTopic,topic);
+    memcpy(lastPayload+offset,slice,length);
+    lastLength = total;
+    sliceCount++;
+}
+
 int test_receive_callback() {
     IT("receives a callback message");
     reset_callback();
@@ -235,6 +245,86 @@ int test_receive_qos1() {
     END_IT
 }
 
+int test_receive_split_message() {
+    IT("receives a message split over several loops");
+    reset_callback();
+
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, callback, shimClient);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    byte publish[] = {0x30,0xe,0x0,0x5,0x74,0x6f,0x70,0x69,0x63,0x70,0x61,0x79,0x6c,0x6f,0x61,0x64};
+    shimClient.respond(publish,1);
+
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_FALSE(callback_called);
+
+    shimClient.respond(publish+1,6);
+
+    rc = client.loop();
+    IS_TRUE(rc);
+    IS_FALSE(callback_called);
+
+    shimClient.respond(publish+7,9);
+
+    rc = client.loop();
+    IS_TRUE(rc);
+
+    IS_TRUE(callback_called);
+    IS_TRUE(strcmp(lastTopic,"topic")==0);
+    IS_TRUE(memcmp(lastPayload,"payload",7)==0);
+    IS_TRUE(lastLength == 7);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
+int test_receive_stream_callback() {
+    IT("receives a payload larger than the buffer in slices");
+    reset_callback();
+
+    ShimClient shimClient;
+    shimClient.setAllowConnect(true);
+
+    byte connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    shimClient.respond(connack,4);
+
+    PubSubClient client(server, 1883, shimClient);
+    client.setStreamCallback(stream_callback);
+    int rc = client.connect((char*)"client_test1");
+    IS_TRUE(rc);
+
+    int length = 300;
+    byte payload[300];
+    for (int i=0;i<length;i++) {
+        payload[i] = i;
+    }
+    byte publish[] = {0x30,0xb3,0x2,0x0,0x5,0x74,0x6f,0x70,0x69,0x63};
+    shimClient.respond(publish,10);
+    shimClient.respond(payload,length);
+
+    rc = client.loop();
+    IS_TRUE(rc);
+
+    IS_TRUE(callback_called);
+    IS_TRUE(sliceCount == 3);
+    IS_TRUE(strcmp(lastTopic,"topic")==0);
+    IS_TRUE(lastLength == 300);
+    IS_TRUE(memcmp(lastPayload,payload,300)==0);
+
+    IS_FALSE(shimClient.error());
+
+    END_IT
+}
+
 int main()
 {
     SUITE("Receive");
@@ -244,6 +334,8 @@ int main()
     test_receive_oversized_message();
     test_receive_oversized_stream_message();
     test_receive_qos1();
+    test_receive_split_message();
+    test_receive_stream_callback();
 
     FINISH
 }
@@ -41,6 +41,7 @@
 
 #define ONE_WIRE_BUS 3 // Pin where dallase sensor is connected 
 #define MAX_ATTACHED_DS18B20 16
+#define DEVICE_TABLE_STATE 0 // saveState() position of the sensors found at the last start (count, then addresses)
 unsigned long SLEEP_TIME = 30000; // Sleep time between reads (in milliseconds)
 OneWire oneWire(ONE_WIRE_BUS); // Setup a oneWire instance to communicate with any OneWire devices (not just Maxim/Dallas temperature ICs)
 DallasTemperature sensors(&oneWire); // Pass the oneWire reference to Dallas Temperature. 
@@ -53,8 +54,18 @@ MyMessage msg(0,V_TEMP);
 
 void setup()  
 { 
-  // Startup up the OneWire library
-  sensors.begin();
+  // Startup up the OneWire library, with the sensors found at the last start if they all
+  // still answer, so the bus need not be searched
+  DeviceAddress deviceTable[MAX_ATTACHED_DS18B20];
+  uint8_t stored = loadState(DEVICE_TABLE_STATE);
+  if (stored > MAX_ATTACHED_DS18B20) stored = 0;
+  loadStateBlock(DEVICE_TABLE_STATE + 1, deviceTable, stored * sizeof(DeviceAddress));
+  if (!sensors.begin(deviceTable, stored)) {
+    // The bus was searched, remember what was found for the next start
+    stored = sensors.getDeviceTable(deviceTable, MAX_ATTACHED_DS18B20);
+    saveState(DEVICE_TABLE_STATE, stored);
+    saveStateBlock(DEVICE_TABLE_STATE + 1, deviceTable, stored * sizeof(DeviceAddress));
+  }
   // requestTemperatures() will not block current thread
   sensors.setWaitForConversion(false);
 }
@@ -103,6 +103,9 @@
 // How many clients should be able to connect to this gateway (default 1)
 #define MY_GATEWAY_MAX_CLIENTS 2
 
+// Serve the clients from the lwIP TCP callbacks instead of polling them (server mode only)
+//#define MY_GATEWAY_ESP8266_ASYNC
+
 // Controller ip address. Enables client mode (default is "server" mode). 
 // Also enable this if MY_USE_UDP is used and you want sensor data sent somewhere. 
 //#define MY_CONTROLLER_IP_ADDRESS 192, 168, 178, 68
@@ -20,7 +20,6 @@
 #define CS_PIN 8
 #define SI_PIN 7
 #define IRQ_PIN 3
-volatile int8_t AS3935_ISR_Trig = 0;
 
 // #defines
 #define AS3935_INDOORS       1
@@ -28,8 +27,6 @@ volatile int8_t AS3935_ISR_Trig = 0;
 #define AS3935_DIST_DIS      0
 #define AS3935_DIST_EN       1
 #define AS3935_CAPACITANCE   96      // <-- SET THIS VALUE TO THE NUMBER LISTED ON YOUR BOARD 
-// prototypes
-void AS3935_ISR();
 
 PWF_AS3935  lightning0(CS_PIN, IRQ_PIN, SI_PIN);
 
@@ -59,8 +56,9 @@ void setup()
                   //   --> disturbers (AS3935_DIST_EN:1 / AS3935_DIST_DIS:2)
                   // function also powers up the chip
                   
-  // enable interrupt (hook IRQ pin to Arduino Uno/Mega interrupt input: 1 -> pin 3 )
-  attachInterrupt(digitalPinToInterrupt(IRQ_PIN), AS3935_ISR, RISING);
+  // enable interrupt (hook IRQ pin to Arduino Uno/Mega interrupt input: 1 -> pin 3 ),
+  // events are queued by the library
+  lightning0.AS3935_AttachIRQ(digitalPinToInterrupt(IRQ_PIN));
   // dump the registry data to the serial port for troubleshooting purposes
   lightning0.AS3935_PrintAllRegs();
   
@@ -80,46 +78,29 @@ void presentation()  {
 
 void loop()      
 {     
+  AS3935_Event event;
 
-  // This program only handles an AS3935 lightning sensor. It does nothing until 
-  // an interrupt is detected on the IRQ pin.
-  while(0 == AS3935_ISR_Trig){}
- 
-  // reset interrupt flag
-  AS3935_ISR_Trig = 0;
-  
-  // now get interrupt source
-  uint8_t int_src = lightning0.AS3935_GetInterruptSrc();
-  if(0 == int_src)
-  {
-    Serial.println("Unknown interrupt source");
-  }
-  else if(1 == int_src)
-  {
-    uint8_t lightning_dist_km = lightning0.AS3935_GetLightningDistKm();
-    uint32_t lightning_intensity = lightning0.AS3935_GetStrikeEnergyRaw();
-
-    Serial.print("Lightning detected! Distance to strike: ");
-    Serial.print(lightning_dist_km);
-    Serial.println(" kilometers");
-    Serial.print("Lightning detected! Lightning Intensity: ");
-    Serial.println(lightning_intensity);
-    send(msgDist.set(lightning_dist_km));
-    send(msgInt.set(lightning_intensity));
-  }
-  else if(2 == int_src)
-  {
-    Serial.println("Disturber detected");
-  }
-  else if(3 == int_src)
+  // This program only handles an AS3935 lightning sensor. Events of the IRQ pin are queued,
+  // so strikes during a send are reported in the next loop.
+  while(lightning0.AS3935_GetEvent(event))
   {
-    Serial.println("Noise level too high");
+    if(1 == event.type)
+    {
+      Serial.print("Lightning detected! Distance to strike: ");
+      Serial.print(event.distance_km);
+      Serial.println(" kilometers");
+      Serial.print("Lightning detected! Lightning Intensity: ");
+      Serial.println(event.energy_raw);
+      send(msgDist.set(event.distance_km));
+      send(msgInt.set(event.energy_raw));
+    }
+    else if(2 == event.type)
+    {
+      Serial.println("Disturber detected");
+    }
+    else if(3 == event.type)
+    {
+      Serial.println("Noise level too high");
+    }
   }
 }
-
-// this is irq handler for AS3935 interrupts, has to return void and take no arguments
-// always make code in interrupt handlers fast and short
-void AS3935_ISR()
-{
-  AS3935_ISR_Trig = 1;
-}
@@ -71,7 +71,7 @@ void presentation()  {
 
 void loop()
 {
-  temperature = temp0.read_temp(); // Read the temp
+  temperature = temp0.read_temp(true); // Read the temp, forced as millis() stops while sleeping
 
   if (temperature < 0) { // If there is an error with the TC, temperature will be < 0
     Serial.println("Thermocouple Error!!"); // There is a thermocouple error
@@ -20,6 +20,7 @@
  *
  * REVISION HISTORY
  * Version 1.0 - Henrik Ekblad
+ * Version 1.1 - Waits for tags without blocking the node
  * 
  * DESCRIPTION
  * RFID Lock sensor/actuator
@@ -36,6 +37,7 @@
  * VCC   ->   +5V
  * SCL   ->   A5
  * SDA   ->   A4
+ * IRQ   ->   3 (optional, see irqPin)
  * 
  * Use normal wiring for NRF24L01 radio
  * 
@@ -71,9 +73,12 @@ int keyCount = sizeof validKeys / maxKeyLength;
  
 // Pin definition
 const int lockPin = 4;         // (Digital 4) The pin that activates the relay/solenoid lock.
+const int8_t irqPin = 3;       // (Digital 3) IRQ of the reader. -1 to poll the reader over I2C instead.
 bool lockStatus;
+bool tagPresent = false;       // A tag was in the field at the last detection
+bool detecting = false;        // A tag detection is running in the reader
 MyMessage lockMsg(CHILD_ID, V_LOCK_STATUS);
-PN532_I2C pn532i2c(Wire);
+PN532_I2C pn532i2c(Wire, irqPin);
 PN532 nfc(pn532i2c);
  
 void setup() {
@@ -91,7 +96,8 @@ void setup() {
   Serial.print('.'); Serial.println((versiondata>>8) & 0xFF, DEC);
   // Set the max number of retry attempts to read from a card
   // This prevents us from waiting forever for a card, which is
-  // the default behaviour of the PN532.
+  // the default behaviour of the PN532. A detection without tag
+  // then tells us that a tag has left the reader.
   nfc.setPassiveActivationRetries(0x3);
   
   // configure board to read RFID tags
@@ -107,17 +113,25 @@ void presentation()  {
 }
  
 void loop() {
-  boolean success;
   uint8_t key[] = { 0, 0, 0, 0, 0, 0, 0 };  // Buffer to store the returned UID
   uint8_t currentKeyLength;                        // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
 
-  
-  // Wait for an ISO14443A type cards (Mifare, etc.).  When one is found
-  // 'uid' will be populated with the UID, and uidLength will indicate
+  // Look for ISO14443A type cards (Mifare, etc.) in the background, so the node keeps
+  // routing messages while the reader waits for a card.
+  if (!detecting) {
+    detecting = nfc.startPassiveTargetIDDetection(PN532_MIFARE_ISO14443A);
+    return;
+  }
+  if (!nfc.isReady()) {
+    return;
+  }
+  detecting = false;
+
+  // When a card is found 'uid' will be populated with the UID, and uidLength will indicate
   // if the uid is 4 bytes (Mifare Classic) or 7 bytes (Mifare Ultralight)
-  success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, &key[0], &currentKeyLength);
-  
-  if (success) {
+  boolean success = nfc.readDetectedPassiveTargetID(&key[0], &currentKeyLength);
+
+  if (success && !tagPresent) {
     Serial.print("Found tag id: ");
     for (uint8_t i=0; i < currentKeyLength; i++) 
     {
@@ -148,10 +162,10 @@ void loop() {
       // Switch lock status
       setLockState(!lockStatus, true);       
     }
-    
-    // Wait for card/tag to leave reader    
-    while(nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, &key[0], &currentKeyLength));
-  } 
+  }
+
+  // A tag is handled once, until it has left the reader
+  tagPresent = success;
 } 
  
  
@@ -0,0 +1,100 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2015 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ *******************************
+ *
+ * REVISION HISTORY
+ * Version 1.0 - Henrik Ekblad
+ * 
+ * DESCRIPTION
+ * Example sketch of a battery node woken up by the alarms of a DS3231/DS3232 RTC.
+ * The temperature of the RTC is reported every 15 minutes and the battery level
+ * once a day. Between the two the node sleeps in power-down until the RTC pulls
+ * its INT pin low, there are no watchdog wake-ups. The RTC is set from the
+ * controller time on start-up.
+ *
+ * Wiring (radio wiring on www.mysensors.org)
+ * ------------------------------------
+ * Arduino   RTC-Module
+ * ------------------------------------
+ * GND       GND
+ * +5V       VCC
+ * A4        SDA
+ * A5        SCL
+ * D3        INT/SQW
+ *
+ */
+
+// Enable debug prints to serial monitor
+#define MY_DEBUG 
+
+// Enable and select radio type attached
+#define MY_RADIO_NRF24
+//#define MY_RADIO_RFM69
+ 
+#include <SPI.h>
+#include <MySensor.h>  
+#include <Time.h>  
+#include <DS3232RTC.h>  // A  DS3231/DS3232 library
+#include <Wire.h>
+
+#define RTC_INT_PIN 3   // Arduino pin connected to the INT/SQW pin of the RTC (open drain)
+#define CHILD_ID_TEMP 0
+
+DS3232AlarmQueue queue;
+MyMessage msgTemp(CHILD_ID_TEMP, V_TEMP);
+
+void sendTemperature(byte id) {
+  send(msgTemp.set(RTC.temperature() / 4.0, 2));
+}
+
+void sendBattery(byte id) {
+  sendBatteryLevel(100); // Replace with a real measurement
+}
+
+void setup()  
+{  
+  pinMode(RTC_INT_PIN, INPUT_PULLUP);
+  // Wait for the controller time, the alarms need a running clock
+  requestTime();
+  wait(2000);
+  time_t t = RTC.get();
+  queue.add(t + 10, 15 * SECS_PER_MIN, sendTemperature);
+  queue.add(t + 20, SECS_PER_DAY, sendBattery);
+}
+
+void presentation()  {
+  // Send the sketch version information to the gateway and Controller
+  sendSketchInfo("RTC Alarm Sensor", "1.0");
+  present(CHILD_ID_TEMP, S_TEMP);
+}
+
+// This is called when a new time value was received
+void receiveTime(unsigned long controllerTime) {
+  RTC.set(controllerTime);
+}
+
+void loop()     
+{     
+  // Run what is due and arm the RTC for the next event
+  queue.service();
+  // Power down until the RTC alarm, however far away. INT/SQW is a level
+  // shared by both alarms, it may already be low again (an alarm that
+  // matched during service()), so wake on LOW: there may be no falling edge
+  sleep(digitalPinToInterrupt(RTC_INT_PIN), LOW, 0);
+}
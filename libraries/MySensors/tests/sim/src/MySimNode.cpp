@@ -0,0 +1,67 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2015 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Sketch of a simulated node. Built with MY_SIM_GATEWAY as serial gateway, otherwise as a
+// repeater sending a counter value to the gateway every reportInterval ms (+-50%),
+// starting right after start-up.
+
+#define MY_CORE_ONLY
+#define MY_RADIO_SIM
+
+#ifdef MY_SIM_GATEWAY
+	#define MY_GATEWAY_SERIAL
+#else
+	#define MY_REPEATER_FEATURE
+	#define MY_NODE_ID (_simApi->nodeId)
+#endif
+
+#include "MyHwSim.cpp"
+#include "MyTransportSim.cpp"
+#include <MySensor.h>
+
+#ifndef MY_SIM_GATEWAY
+MyMessage msg(0, V_VAR1);
+uint32_t seq = 0;
+
+void presentation() {
+	present(0, S_CUSTOM);
+}
+
+void loop() {
+	// the first message right after start-up, so the time to reach the gateway is the route set-up
+	_simApi->offered(seq);
+	send(msg.set(seq));
+	seq++;
+	wait(_simApi->reportInterval / 2 + _simApi->random(_simApi->reportInterval + 1));
+}
+#endif
+
+extern "C" __attribute__((visibility("default"))) void mySimMain(const MySimApi *api) {
+	_simApi = api;
+	_begin();
+	for (;;) {
+		_process();
+		#ifndef MY_SIM_GATEWAY
+			// the gateway sketch has no loop()
+			loop();
+		#endif
+		// like yield() between two loop() calls on ESP8266, a pass may not read the clock
+		yield();
+	}
+}
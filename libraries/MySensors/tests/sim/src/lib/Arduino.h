@@ -0,0 +1,114 @@
+// Host stand-in for the Arduino core, just what the MySensors core uses.
+// Time and randomness come from the simulator, see MyHwSim.cpp.
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define PROGMEM
+#define PSTR(x) (x)
+#define F(x) (x)
+#define pgm_read_byte(x) (*(const uint8_t*)(x))
+#define pgm_read_word(x) (*(const uint16_t*)(x))
+#define pgm_read_dword(x) (*(const uint32_t*)(x))
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+
+#ifndef min
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#endif
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define lowByte(w) ((uint8_t) ((w) & 0xff))
+#define highByte(w) ((uint8_t) ((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define _BV(x) (1<<(x))
+
+#define noInterrupts()
+#define interrupts()
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
+
+// avr-libc conversions
+inline char *itoa(int value, char *s, int radix) {
+	sprintf(s, radix == 16 ? "%x" : "%d", value);
+	return s;
+}
+inline char *utoa(unsigned int value, char *s, int radix) {
+	sprintf(s, radix == 16 ? "%x" : "%u", value);
+	return s;
+}
+inline char *ltoa(long value, char *s, int radix) {
+	sprintf(s, radix == 16 ? "%lx" : "%ld", value);
+	return s;
+}
+inline char *ultoa(unsigned long value, char *s, int radix) {
+	sprintf(s, radix == 16 ? "%lx" : "%lu", value);
+	return s;
+}
+inline char *dtostrf(double value, signed char width, unsigned char prec, char *s) {
+	sprintf(s, "%*.*f", width, prec, value);
+	return s;
+}
+
+class Print {
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size) {
+		size_t n = 0;
+		while (size--) {
+			n += write(*buffer++);
+		}
+		return n;
+	}
+	size_t write(const char *str) {
+		return str ? write((const uint8_t *)str, strlen(str)) : 0;
+	}
+	size_t write(const char *buffer, size_t size) {
+		return write((const uint8_t *)buffer, size);
+	}
+	virtual void flush() {}
+	size_t print(const char s[]) { return write(s); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t println(const char s[]) { return print(s) + write('\n'); }
+};
+
+#endif // Arduino_h
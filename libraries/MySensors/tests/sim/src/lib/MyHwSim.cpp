@@ -0,0 +1,163 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2015 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Hardware layer of a simulated node: clock, sleep and random numbers come from the
+// simulator, EEPROM is RAM private to the node, the serial port is the controller link.
+
+#include "MyHw.h"
+#include "MySim.h"
+
+const MySimApi *_simApi;
+
+// Fresh (erased) EEPROM on every run
+static uint8_t _simEeprom[1024];
+static bool _simEepromErased = false;
+
+static uint8_t *hwSimEeprom(int adr) {
+	if (!_simEepromErased) {
+		memset(_simEeprom, 0xFF, sizeof(_simEeprom));
+		_simEepromErased = true;
+	}
+	return &_simEeprom[adr & (sizeof(_simEeprom) - 1)];
+}
+
+class SimSerial : public Print {
+public:
+	void begin(unsigned long) {}
+	int available() { return 0; }
+	int read() { return -1; }
+	// The controller link never backs up
+	int availableForWrite() { return 64; }
+	size_t write(uint8_t c) {
+		_simApi->serialWrite(c);
+		return 1;
+	}
+	using Print::write;
+};
+
+SimSerial Serial;
+
+#define MY_SERIALDEVICE Serial
+
+#define hwDigitalWrite(__pin, __value)
+#define hwInit() MY_SERIALDEVICE.begin(MY_BAUD_RATE)
+#define hwWatchdogReset()
+#define hwReboot() abort()
+#define hwMillis() millis()
+#define hwMicros() micros()
+#define hwConfigFlush(__force)
+// wait() reads the clock on every round, that is where the other nodes get to run
+#define hwIdle()
+
+unsigned long millis() {
+	// Every clock read is a point where the node may be preempted
+	_simApi->yield();
+	return _simApi->millis();
+}
+
+unsigned long micros() {
+	return _simApi->micros();
+}
+
+void delay(unsigned long ms) {
+	unsigned long start = _simApi->millis();
+	while (_simApi->millis() - start < ms) {
+		_simApi->yield();
+	}
+}
+
+void yield() {
+	_simApi->yield();
+}
+
+long random(long howbig) {
+	return howbig > 0 ? _simApi->random(howbig) : 0;
+}
+
+long random(long howsmall, long howbig) {
+	return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+uint8_t hwReadConfig(int adr) {
+	return *hwSimEeprom(adr);
+}
+
+void hwWriteConfig(int adr, uint8_t value) {
+	*hwSimEeprom(adr) = value;
+}
+
+void hwReadConfigBlock(void* buf, void* adr, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		((uint8_t*)buf)[i] = *hwSimEeprom((intptr_t)adr + i);
+	}
+}
+
+void hwWriteConfigBlock(void* buf, void* adr, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		*hwSimEeprom((intptr_t)adr + i) = ((uint8_t*)buf)[i];
+	}
+}
+
+// The simulated clock keeps running while asleep, so hwMillis() already includes it
+unsigned long hwSleepTime() {
+	return 0;
+}
+
+int8_t hwSleep(unsigned long ms) {
+	delay(ms);
+	return -1;
+}
+
+int8_t hwSleep(uint8_t interrupt, uint8_t mode, unsigned long ms) {
+	return hwSleep(interrupt, mode, 0xFF, 0x00, ms);
+}
+
+int8_t hwSleep(uint8_t interrupt1, uint8_t mode1, uint8_t interrupt2, uint8_t mode2, unsigned long ms) {
+	(void)interrupt1;
+	(void)mode1;
+	(void)interrupt2;
+	(void)mode2;
+	// No pin interrupts in the simulation, sleeping forever means until the end of the run
+	delay(ms ? ms : 0xFFFFFFFFUL);
+	return -1;
+}
+
+uint16_t hwCPUVoltage() {
+	return 3300;
+}
+
+uint16_t hwCPUFrequency() {
+	// 1/10MHz
+	return 160;
+}
+
+uint16_t hwFreeMem() {
+	return 2048;
+}
+
+#ifdef MY_DEBUG
+void hwDebugPrint(const char *fmt, ... ) {
+	char fmtBuffer[300];
+	va_list args;
+	va_start (args, fmt );
+	vsnprintf(fmtBuffer, sizeof(fmtBuffer), fmt, args);
+	va_end (args);
+	_simApi->debug(fmtBuffer);
+}
+#endif
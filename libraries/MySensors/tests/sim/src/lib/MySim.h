@@ -0,0 +1,56 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2015 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef MySim_h
+#define MySim_h
+
+#include <stdint.h>
+
+/**
+ * @brief Simulator services for one virtual node
+ *
+ * Every node is a private copy of a shared library built from MySimNode.cpp, so each has its
+ * own core state (routing table, queues, EEPROM). The simulator runs the nodes as coroutines
+ * on one shared clock and passes this table to mySimMain().
+ */
+struct MySimApi {
+	uint8_t nodeId; //!< Static node id, used as MY_NODE_ID (0 for the gateway)
+	unsigned long reportInterval; //!< Mean time between two data messages of a sensor node (ms)
+	unsigned long (*millis)(); //!< Simulated time in ms
+	unsigned long (*micros)(); //!< Simulated time in us
+	void (*yield)(); //!< Lets the other nodes run, simulated time moves on by one quantum
+	long (*random)(long howbig); //!< Deterministic random number in [0, howbig)
+	void (*setAddress)(uint8_t address); //!< Radio listens on address (and broadcast)
+	bool (*send)(uint8_t to, const void* data, uint8_t len); //!< Transmits a frame, true if acked (always true for broadcasts)
+	bool (*available)(uint8_t *to); //!< True if a received frame is waiting, to is its destination
+	uint8_t (*receive)(void* data); //!< Takes the oldest received frame, returns its length
+	void (*powerDown)(); //!< Radio off until the next send(), available() or setAddress()
+	void (*serialWrite)(uint8_t c); //!< Gateway serial output towards the controller
+	void (*debug)(const char *text); //!< Debug output of the node (MY_DEBUG)
+	void (*offered)(uint32_t seq); //!< Sketch is about to send data message seq to the gateway
+};
+
+/**
+ * Entry point of a node, runs setup and loop forever.
+ *
+ * @param api Services of the simulator, valid for the lifetime of the node.
+ */
+extern "C" void mySimMain(const MySimApi *api);
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2015 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Forward link of a simulated node (MY_RADIO_SIM), the radio medium is part of the simulator
+
+#include "MyConfig.h"
+#include "MyTransport.h"
+#include "MySim.h"
+
+static uint8_t _simAddress = AUTO;
+
+bool transportInit() {
+	return true;
+}
+
+void transportSetAddress(uint8_t address) {
+	_simAddress = address;
+	_simApi->setAddress(address);
+}
+
+uint8_t transportGetAddress() {
+	return _simAddress;
+}
+
+bool transportSend(uint8_t recipient, const void* data, uint8_t len) {
+	return _simApi->send(recipient, data, len);
+}
+
+bool transportAvailable(uint8_t *to) {
+	return _simApi->available(to);
+}
+
+uint8_t transportReceive(void* data) {
+	return _simApi->receive(data);
+}
+
+int16_t transportGetReceivingRSSI() {
+	// Like nRF24, no usable RSSI
+	return 0;
+}
+
+void transportPowerDown() {
+	_simApi->powerDown();
+}
@@ -0,0 +1,542 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2015 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Runs a network of virtual MySensors nodes on the host.
+//
+// Node 0 is a serial gateway, all others are repeaters sending a counter to the gateway.
+// Each node is a private copy of bin/node.so (bin/gateway.so), loaded with its own globals
+// and run as a coroutine. A node runs until it reads the clock (hwMillis(), wait(), ...),
+// then the next node gets its turn; the clock moves on one quantum per round.
+//
+// The radio is modelled after nRF24 with auto-ack: nodes within range hear each frame,
+// every frame and every ack is lost with the given probability, unacked frames are repeated
+// by "hardware" up to the attempt limit and duplicates are filtered like the chip does.
+// There are no collisions, the send duration is the airtime of all attempts.
+
+#include "MySim.h"
+
+#include <dlfcn.h>
+#include <getopt.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#define SIM_BROADCAST 255
+#define SIM_MAX_FRAME 32
+#define SIM_STACK_SIZE (256 * 1024)
+
+enum topology_t { TOPOLOGY_LINE, TOPOLOGY_GRID, TOPOLOGY_STAR, TOPOLOGY_RANDOM };
+
+struct SimFrame {
+	unsigned long long at; // us, when it has arrived
+	uint8_t to;
+	uint8_t len;
+	uint8_t data[SIM_MAX_FRAME];
+};
+
+struct SimNode {
+	MySimApi api;
+	void (*main)(const MySimApi *api);
+	ucontext_t ctx; // initial context only
+	jmp_buf jmp;
+	bool started;
+	std::vector<char> stack;
+	double x, y;
+	uint8_t address;
+	bool listening;
+	std::deque<SimFrame> rx;
+	std::string serialLine;
+	// data messages of this node: time offered (us) and whether it reached the gateway
+	std::vector<unsigned long long> offeredAt;
+	std::vector<bool> delivered;
+	unsigned long long firstDelivery;
+};
+
+// Options
+static int optNodes = 10;
+static topology_t optTopology = TOPOLOGY_LINE;
+static double optRange = 0;
+static double optLoss = 0;
+static unsigned long optLatency = 1000; // us
+static unsigned long optJitter = 500; // us
+static unsigned long optAirtime = 500; // us per attempt, including the wait for the ack
+static int optAttempts = 16;
+static unsigned int optRxSize = 3;
+static unsigned long optQuantum = 250; // us
+static unsigned long optSeconds = 600;
+static unsigned long optInterval = 10000; // ms
+static unsigned long long optSeed = 1;
+static bool optVerbose = false;
+static const char *optLibDir = "bin";
+
+// Simulator state
+static std::vector<SimNode*> nodes;
+static SimNode *current;
+static jmp_buf scheduler;
+static unsigned long long now; // us
+static unsigned long long rng;
+
+// Counters
+static unsigned long frames; // every transmission attempt, broadcasts included
+static unsigned long broadcasts;
+static unsigned long retries; // unicast attempts after the first
+static unsigned long sendFailures; // unicast sends not acked after all attempts
+static unsigned long rxOverflows;
+static unsigned long offered;
+static unsigned long deliveredCount;
+static unsigned long duplicates;
+static unsigned long long latencySum;
+static unsigned long long latencyMax;
+
+static unsigned long long nextRandom() {
+	// xorshift64*
+	rng ^= rng >> 12;
+	rng ^= rng << 25;
+	rng ^= rng >> 27;
+	return rng * 2685821657736338717ULL;
+}
+
+static bool lost() {
+	return optLoss > 0 && (nextRandom() >> 11) * (1.0 / 9007199254740992.0) < optLoss;
+}
+
+static bool inRange(SimNode *a, SimNode *b) {
+	double dx = a->x - b->x;
+	double dy = a->y - b->y;
+	return dx * dx + dy * dy <= optRange * optRange;
+}
+
+// Frame arrives at node after the link latency, false if its receive buffer is full
+static bool deliver(SimNode *node, uint8_t to, const void* data, uint8_t len) {
+	if (node->rx.size() >= optRxSize) {
+		rxOverflows++;
+		return false;
+	}
+	SimFrame frame;
+	frame.at = now + optLatency + (optJitter ? nextRandom() % (optJitter + 1) : 0);
+	frame.to = to;
+	frame.len = len;
+	memcpy(frame.data, data, len);
+	// keep the queue sorted by arrival, jitter may reorder frames
+	std::deque<SimFrame>::iterator it = node->rx.end();
+	while (it != node->rx.begin() && (it - 1)->at > frame.at) {
+		--it;
+	}
+	node->rx.insert(it, frame);
+	return true;
+}
+
+// Node API, always called by the current node
+
+static unsigned long apiMillis() {
+	return (unsigned long)(now / 1000);
+}
+
+static unsigned long apiMicros() {
+	return (unsigned long)now;
+}
+
+// The node coroutines switch with _setjmp()/_longjmp(), swapcontext() saves and restores the
+// signal mask with a system call each time
+static void apiYield() {
+	if (!_setjmp(current->jmp)) {
+		_longjmp(scheduler, 1);
+	}
+}
+
+static void resume(SimNode *node) {
+	current = node;
+	if (!_setjmp(scheduler)) {
+		if (node->started) {
+			_longjmp(node->jmp, 1);
+		}
+		node->started = true;
+		setcontext(&node->ctx);
+	}
+}
+
+static long apiRandom(long howbig) {
+	return (long)(nextRandom() % (unsigned long long)howbig);
+}
+
+static void apiSetAddress(uint8_t address) {
+	current->address = address;
+	current->listening = true;
+}
+
+static bool apiSend(uint8_t to, const void* data, uint8_t len) {
+	SimNode *self = current;
+	self->listening = true;
+	if (len > SIM_MAX_FRAME) {
+		len = SIM_MAX_FRAME;
+	}
+	int attempts = 0;
+	bool ok = false;
+	if (to == SIM_BROADCAST) {
+		frames++;
+		broadcasts++;
+		attempts = 1;
+		for (size_t i = 0; i < nodes.size(); i++) {
+			SimNode *node = nodes[i];
+			if (node != self && node->listening && inRange(self, node) && !lost()) {
+				deliver(node, to, data, len);
+			}
+		}
+		ok = true;
+	} else {
+		SimNode *peer = NULL;
+		for (size_t i = 0; i < nodes.size(); i++) {
+			if (nodes[i] != self && nodes[i]->address == to && inRange(self, nodes[i])) {
+				peer = nodes[i];
+				break;
+			}
+		}
+		bool received = false;
+		while (!ok && attempts < optAttempts) {
+			frames++;
+			if (attempts++) {
+				retries++;
+			}
+			if (peer == NULL || !peer->listening || lost()) {
+				continue;
+			}
+			// a repeated frame is dropped by the receiver but acked again
+			if (!received) {
+				received = deliver(peer, to, data, len);
+				if (!received) {
+					// no ack with a full receive buffer
+					continue;
+				}
+			}
+			ok = !lost();
+		}
+		if (!ok) {
+			sendFailures++;
+		}
+	}
+	// the sender is busy for the airtime of all attempts
+	unsigned long long done = now + (unsigned long long)attempts * optAirtime;
+	while (now < done) {
+		apiYield();
+	}
+	return ok;
+}
+
+static bool apiAvailable(uint8_t *to) {
+	current->listening = true;
+	if (current->rx.empty() || current->rx.front().at > now) {
+		return false;
+	}
+	*to = current->rx.front().to;
+	return true;
+}
+
+static uint8_t apiReceive(void* data) {
+	if (current->rx.empty() || current->rx.front().at > now) {
+		return 0;
+	}
+	SimFrame &frame = current->rx.front();
+	uint8_t len = frame.len;
+	memcpy(data, frame.data, len);
+	current->rx.pop_front();
+	return len;
+}
+
+static void apiPowerDown() {
+	// frames in flight are lost like in a real radio
+	current->listening = false;
+	current->rx.clear();
+}
+
+// Gateway output: node;child;command;ack;type;payload
+static void gatewayLine(const std::string &line) {
+	unsigned int node, child, command, ack, type;
+	unsigned long seq;
+	if (sscanf(line.c_str(), "%u;%u;%u;%u;%u;%lu", &node, &child, &command, &ack, &type, &seq) != 6) {
+		return;
+	}
+	// C_SET of V_VAR1 on child 0, see MySimNode.cpp
+	if (command != 1 || type != 24 || child != 0 || node == 0 || node >= nodes.size()) {
+		return;
+	}
+	SimNode *sender = nodes[node];
+	if (seq >= sender->offeredAt.size()) {
+		return;
+	}
+	if (sender->delivered[seq]) {
+		duplicates++;
+		return;
+	}
+	sender->delivered[seq] = true;
+	deliveredCount++;
+	if (!sender->firstDelivery) {
+		sender->firstDelivery = now ? now : 1;
+	}
+	unsigned long long latency = now - sender->offeredAt[seq];
+	latencySum += latency;
+	if (latency > latencyMax) {
+		latencyMax = latency;
+	}
+}
+
+static void apiSerialWrite(uint8_t c) {
+	if (c == '\n') {
+		if (optVerbose) {
+			printf("%8.3f gw> %s\n", now / 1e6, current->serialLine.c_str());
+		}
+		gatewayLine(current->serialLine);
+		current->serialLine.clear();
+	} else {
+		current->serialLine += (char)c;
+	}
+}
+
+static void apiDebug(const char *text) {
+	if (optVerbose) {
+		printf("%8.3f %3u: %s", now / 1e6, current->api.nodeId, text);
+		size_t len = strlen(text);
+		if (len == 0 || text[len - 1] != '\n') {
+			putchar('\n');
+		}
+	}
+}
+
+static void apiOffered(uint32_t seq) {
+	if (seq == current->offeredAt.size()) {
+		current->offeredAt.push_back(now);
+		current->delivered.push_back(false);
+	}
+	offered++;
+}
+
+static void nodeEntry() {
+	current->main(&current->api);
+}
+
+// Loads a private copy of the library, so the node gets its own globals
+static void *loadCopy(const char *path, const char *dir, int index) {
+	char copy[512];
+	snprintf(copy, sizeof(copy), "%s/node%d.so", dir, index);
+	FILE *in = fopen(path, "rb");
+	FILE *out = fopen(copy, "wb");
+	if (!in || !out) {
+		fprintf(stderr, "cannot copy %s to %s\n", path, copy);
+		exit(2);
+	}
+	char buf[65536];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+		fwrite(buf, 1, n, out);
+	}
+	fclose(in);
+	fclose(out);
+	void *lib = dlopen(copy, RTLD_NOW | RTLD_LOCAL);
+	unlink(copy);
+	if (!lib) {
+		fprintf(stderr, "%s\n", dlerror());
+		exit(2);
+	}
+	return lib;
+}
+
+static void place(SimNode *node, int i) {
+	int side = (int)ceil(sqrt((double)optNodes));
+	switch (optTopology) {
+	case TOPOLOGY_LINE:
+		node->x = i;
+		node->y = 0;
+		break;
+	case TOPOLOGY_GRID:
+		node->x = i % side;
+		node->y = i / side;
+		break;
+	case TOPOLOGY_STAR:
+		node->x = node->y = 0;
+		break;
+	case TOPOLOGY_RANDOM:
+		// gateway in the middle, the others anywhere in a square of the grid size
+		node->x = i ? (nextRandom() % 1000) * side / 1000.0 : side / 2.0;
+		node->y = i ? (nextRandom() % 1000) * side / 1000.0 : side / 2.0;
+		break;
+	}
+}
+
+static SimNode *createNode(int i, const char *dir) {
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s.so", optLibDir, i ? "node" : "gateway");
+	void *lib = loadCopy(path, dir, i);
+	SimNode *node = new SimNode();
+	node->main = (void (*)(const MySimApi*))dlsym(lib, "mySimMain");
+	if (!node->main) {
+		fprintf(stderr, "%s: no mySimMain\n", path);
+		exit(2);
+	}
+	node->api.nodeId = (uint8_t)i;
+	node->api.reportInterval = optInterval;
+	node->api.millis = apiMillis;
+	node->api.micros = apiMicros;
+	node->api.yield = apiYield;
+	node->api.random = apiRandom;
+	node->api.setAddress = apiSetAddress;
+	node->api.send = apiSend;
+	node->api.available = apiAvailable;
+	node->api.receive = apiReceive;
+	node->api.powerDown = apiPowerDown;
+	node->api.serialWrite = apiSerialWrite;
+	node->api.debug = apiDebug;
+	node->api.offered = apiOffered;
+	node->address = SIM_BROADCAST; // AUTO until the core sets it
+	node->listening = false;
+	node->firstDelivery = 0;
+	node->started = false;
+	place(node, i);
+	node->stack.resize(SIM_STACK_SIZE);
+	getcontext(&node->ctx);
+	node->ctx.uc_stack.ss_sp = &node->stack[0];
+	node->ctx.uc_stack.ss_size = node->stack.size();
+	node->ctx.uc_link = NULL;
+	makecontext(&node->ctx, nodeEntry, 0);
+	return node;
+}
+
+static void usage() {
+	fprintf(stderr,
+	        "usage: mysim [options]\n"
+	        "  -n nodes      number of nodes including the gateway (10)\n"
+	        "  -t topology   line, grid, star or random (line)\n"
+	        "  -r range      radio range, nodes are 1 apart (1.2 line, 1.5 grid/random)\n"
+	        "  -l loss       probability of losing a frame or an ack, 0..1 (0)\n"
+	        "  -d latency    link latency in us (1000)\n"
+	        "  -j jitter     additional random latency up to jitter us (500)\n"
+	        "  -a attempts   transmissions per unicast frame, nRF24 auto-retry (16)\n"
+	        "  -A airtime    duration of one attempt in us (500)\n"
+	        "  -b frames     receive buffer of a node (3)\n"
+	        "  -p interval   mean ms between two data messages of a node (10000)\n"
+	        "  -s seconds    simulated time (600)\n"
+	        "  -q quantum    us the clock moves on per scheduling round (250)\n"
+	        "  -S seed       random seed (1)\n"
+	        "  -L dir        directory of node.so and gateway.so (bin)\n"
+	        "  -v            print debug output of all nodes\n");
+	exit(2);
+}
+
+int main(int argc, char** argv) {
+	int opt;
+	while ((opt = getopt(argc, argv, "n:t:r:l:d:j:a:A:b:p:s:q:S:L:v")) != -1) {
+		switch (opt) {
+		case 'n': optNodes = atoi(optarg); break;
+		case 't':
+			if (!strcmp(optarg, "line")) optTopology = TOPOLOGY_LINE;
+			else if (!strcmp(optarg, "grid")) optTopology = TOPOLOGY_GRID;
+			else if (!strcmp(optarg, "star")) optTopology = TOPOLOGY_STAR;
+			else if (!strcmp(optarg, "random")) optTopology = TOPOLOGY_RANDOM;
+			else usage();
+			break;
+		case 'r': optRange = atof(optarg); break;
+		case 'l': optLoss = atof(optarg); break;
+		case 'd': optLatency = strtoul(optarg, NULL, 0); break;
+		case 'j': optJitter = strtoul(optarg, NULL, 0); break;
+		case 'a': optAttempts = atoi(optarg); break;
+		case 'A': optAirtime = strtoul(optarg, NULL, 0); break;
+		case 'b': optRxSize = (unsigned int)atoi(optarg); break;
+		case 'p': optInterval = strtoul(optarg, NULL, 0); break;
+		case 's': optSeconds = strtoul(optarg, NULL, 0); break;
+		case 'q': optQuantum = strtoul(optarg, NULL, 0); break;
+		case 'S': optSeed = strtoull(optarg, NULL, 0); break;
+		case 'L': optLibDir = optarg; break;
+		case 'v': optVerbose = true; break;
+		default: usage();
+		}
+	}
+	if (optNodes < 2 || optNodes > 254 || optAttempts < 1 || optRxSize < 1 || optQuantum < 1 || optInterval < 1) {
+		usage();
+	}
+	if (optRange <= 0) {
+		optRange = optTopology == TOPOLOGY_LINE ? 1.2 : 1.5;
+	}
+	rng = optSeed ? optSeed : 1;
+
+	char dir[] = "/tmp/mysim.XXXXXX";
+	if (!mkdtemp(dir)) {
+		perror("mkdtemp");
+		return 2;
+	}
+	for (int i = 0; i < optNodes; i++) {
+		nodes.push_back(createNode(i, dir));
+	}
+	rmdir(dir);
+
+	struct timespec wallStart, wallEnd;
+	clock_gettime(CLOCK_MONOTONIC, &wallStart);
+	const unsigned long long end = optSeconds * 1000000ULL;
+	unsigned long long converged = 0;
+	for (now = 0; now < end; now += optQuantum) {
+		for (size_t i = 0; i < nodes.size(); i++) {
+			resume(nodes[i]);
+		}
+		if (!converged) {
+			converged = now;
+			for (size_t i = 1; i < nodes.size(); i++) {
+				if (!nodes[i]->firstDelivery) {
+					converged = 0;
+					break;
+				}
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+	double wall = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+
+	static const char *topologies[] = { "line", "grid", "star", "random" };
+	printf("%d nodes, %s, range %.2f, loss %.1f%%, latency %lu+%lu us, %d attempts, %lu s simulated\n",
+	       optNodes, topologies[optTopology], optRange, optLoss * 100, optLatency, optJitter, optAttempts, optSeconds);
+	printf("delivered:   %lu of %lu messages (%.1f%%), %lu duplicates\n",
+	       deliveredCount, offered, offered ? 100.0 * deliveredCount / offered : 0.0, duplicates);
+	printf("throughput:  %.2f msg/s at the gateway\n", deliveredCount / (double)optSeconds);
+	printf("latency:     %.1f ms mean, %.1f ms max\n",
+	       deliveredCount ? latencySum / 1e3 / deliveredCount : 0.0, latencyMax / 1e3);
+	if (converged) {
+		printf("convergence: every node reached the gateway after %.2f s\n", converged / 1e6);
+	} else {
+		int missing = 0;
+		for (size_t i = 1; i < nodes.size(); i++) {
+			if (!nodes[i]->firstDelivery) {
+				missing++;
+			}
+		}
+		printf("convergence: not reached, %d nodes never got a message through\n", missing);
+	}
+	printf("radio:       %lu frames (%lu broadcasts), %.2f frames and %.2f retries per delivered message, "
+	       "%lu failed sends, %lu receive overflows\n",
+	       frames, broadcasts, deliveredCount ? (double)frames / deliveredCount : 0.0,
+	       deliveredCount ? (double)retries / deliveredCount : 0.0, sendFailures, rxOverflows);
+	printf("simulation:  %.2f s wall clock, %.0fx real time\n", wall, wall > 0 ? optSeconds / wall : 0.0);
+	// the node coroutines are never finished, exit without unloading them
+	fflush(stdout);
+	_exit(0);
+}
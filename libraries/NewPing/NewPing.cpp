@@ -217,6 +217,106 @@ ISR(TIMER2_COMPA_vect) {
 }
 
 
+// ---------------------------------------------------------------------------
+// Multiple sensor scheduler, one sensor pings at a time so echoes don't
+// cross. The next ping waits for the end of the current sensor's echo window
+// instead of a fixed PING_MEDIAN_DELAY, short range sensors sweep faster.
+// ---------------------------------------------------------------------------
+
+NewPingScheduler *NewPingScheduler::_active = 0;
+
+
+NewPingScheduler::NewPingScheduler(NewPing *sensors, uint8_t count, unsigned int *samples, uint8_t depth) {
+	_sensors = sensors;
+	_count = count;
+	_samples = samples;
+	_depth = depth;
+	_current = _slot = _rounds = 0;
+	_pinging = false;
+	_echoed = false;
+	_next = micros();
+	_quiet = PING_QUIET_TIME;
+	for (unsigned int i = 0; i < (unsigned int)count * depth; i++) samples[i] = NO_ECHO;
+}
+
+
+void NewPingScheduler::update() {
+	NewPing &sonar = _sensors[_current];
+
+	if (_pinging) {
+		if (_echoed) { // check_timer() already stopped the timer.
+			store(_echo);
+		} else if ((long)(micros() - sonar._max_time) > 0) { // Echo window over, nothing came back.
+			NewPing::timer_stop();
+			store(NO_ECHO);
+		}
+	} else if ((long)(micros() - _next) >= 0) {
+		_active = this;
+		_echoed = false;
+		if (sonar.ping_trigger()) {
+			_pinging = true;
+			NewPing::timer_us(ECHO_TIMER_FREQ, echo_check); // Echo is picked up by the timer interrupt.
+		} else {
+			sonar._max_time = micros();
+			store(NO_ECHO);
+		}
+	}
+}
+
+
+boolean NewPingScheduler::sweep_done() {
+	return _rounds >= _depth;
+}
+
+
+void NewPingScheduler::sweep_clear() {
+	_rounds = 0;
+}
+
+
+unsigned int NewPingScheduler::median(uint8_t sensor) {
+	unsigned int uS[_depth], last;
+	uint8_t i, j, n = 0;
+	for (i = 0; i < _depth; i++) {
+		last = _samples[sensor * _depth + i];
+		if (last == NO_ECHO) continue; // Out of range, not part of the median.
+		for (j = n; j > 0 && uS[j - 1] < last; j--) // Insertion sort loop.
+			uS[j] = uS[j - 1];
+		uS[j] = last;
+		n++;
+	}
+	return n ? uS[n >> 1] : NO_ECHO;
+}
+
+
+void NewPingScheduler::set_quiet_time(unsigned int us) {
+	_quiet = us;
+}
+
+
+void NewPingScheduler::echo_check() {
+	NewPingScheduler *self = _active;
+	NewPing &sonar = self->_sensors[self->_current];
+	if (sonar.check_timer()) {
+		self->_echo = sonar.ping_result;
+		self->_echoed = true;
+	}
+}
+
+
+void NewPingScheduler::store(unsigned int echoTime) {
+	NewPing &sonar = _sensors[_current];
+	_samples[_current * _depth + _slot] = echoTime;
+	_pinging = false;
+	_next = sonar._max_time + _quiet; // Wait out the whole echo window of this sensor, a late echo would reach the next one.
+	if (++_current >= _count) {
+		_current = 0;
+		if (++_slot >= _depth) _slot = 0;
+		if (_rounds < _depth) _rounds++;
+	}
+}
+
+
 // ---------------------------------------------------------------------------
 // Conversion methods (rounds result to nearest inch or cm).
 // ---------------------------------------------------------------------------
@@ -53,6 +53,14 @@
 //   NewPing::timer_ms(frequency, function) - Call function every frequency milliseconds.
 //   NewPing::timer_stop() - Stop the timer.
 //
+// MULTIPLE SENSORS:
+//   NewPingScheduler sweep(sonar, count, samples, depth) - Round-robin count sensors
+//     from the sonar array, keeping depth echoes per sensor in samples[count * depth].
+//   sweep.update() - Call from loop(), starts the next ping when it's due, never waits.
+//   sweep.sweep_done() - True when every sensor has depth new echoes, sweep.sweep_clear() starts over.
+//   sweep.median(sensor) - Median of the collected echoes in microseconds (NO_ECHO if none).
+//   sweep.set_quiet_time(us) - Silence between the end of one echo window and the next ping.
+//
 // HISTORY:
 // 08/15/2012 v1.5 - Added ping_median() method which does a user specified
 //   number of pings (default=5) and returns the median ping in microseconds
@@ -124,6 +132,7 @@
 #define MAX_SENSOR_DELAY 18000  // Maximum uS it takes for sensor to start the ping (SRF06 is the highest measured, just under 18ms).
 #define ECHO_TIMER_FREQ 24      // Frequency to check for a ping echo (every 24uS is about 0.4cm accuracy).
 #define PING_MEDIAN_DELAY 29    // Millisecond delay between pings in the ping_median method.
+#define PING_QUIET_TIME 2000    // Microseconds of silence after an echo window before NewPingScheduler pings the next sensor.
 
 // Conversion from uS to distance (round result to nearest cm or inch).
 #define NewPingConvert(echoTime, conversionFactor) (max((echoTime + conversionFactor / 2) / conversionFactor, (echoTime ? 1 : 0)))
@@ -156,6 +165,34 @@ class NewPing {
 		unsigned long _max_time;
 		static void timer_setup();
 		static void timer_ms_cntdwn();
+		friend class NewPingScheduler;
+};
+
+
+class NewPingScheduler {
+	public:
+		NewPingScheduler(NewPing *sensors, uint8_t count, unsigned int *samples, uint8_t depth = 5);
+		void update();
+		boolean sweep_done();
+		void sweep_clear();
+		unsigned int median(uint8_t sensor);
+		void set_quiet_time(unsigned int us);
+	private:
+		static void echo_check();
+		static NewPingScheduler *_active;
+		NewPing *_sensors;
+		unsigned int *_samples;
+		uint8_t _count;
+		uint8_t _depth;
+		uint8_t _current;
+		uint8_t _slot;
+		uint8_t _rounds;
+		boolean _pinging;
+		volatile boolean _echoed;
+		volatile unsigned int _echo;
+		unsigned long _next;
+		unsigned int _quiet;
+		void store(unsigned int echoTime);
 };
 
 
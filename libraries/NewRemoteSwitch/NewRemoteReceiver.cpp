@@ -41,6 +41,8 @@ byte NewRemoteReceiver::_minRepeats;
 NewRemoteReceiverCallBack NewRemoteReceiver::_callback;
 boolean NewRemoteReceiver::_inCallback = false;
 boolean NewRemoteReceiver::_enabled = false;
+unsigned long NewRemoteReceiver::_dedupWindow = 0;
+NewRemoteReceiver::DedupEntry NewRemoteReceiver::_dedup[NEW_REMOTE_RECEIVER_DEDUP_SIZE];
 
 void NewRemoteReceiver::init(int8_t interrupt, byte minRepeats, NewRemoteReceiverCallBack callback) {
 	_interrupt = interrupt;
@@ -69,7 +71,44 @@ void NewRemoteReceiver::deinit() {
 	}
 }
 
+void NewRemoteReceiver::setDedupWindow(unsigned int window) {
+	_dedupWindow = window * 1000UL;
+	memset(_dedup, 0, sizeof(_dedup));
+}
+
+boolean NewRemoteReceiver::_isDuplicate(const NewRemoteCode &code, unsigned long edgeTime) {
+	if (_dedupWindow == 0) {
+		return false;
+	}
+
+	unsigned int command = code.unit | (code.dimLevel << 4) | (code.switchType << 8) | (code.groupBit << 10);
+
+	// Find code, or else an unused or the least recently received entry to replace
+	byte oldest = 0;
+	unsigned long oldestAge = 0;
+	for (byte i = 0; i < NEW_REMOTE_RECEIVER_DEDUP_SIZE; i++) {
+		unsigned long age = _dedup[i].time != 0 ? edgeTime - _dedup[i].time : 0xFFFFFFFFUL;
+		if (_dedup[i].time != 0 && _dedup[i].address == code.address && _dedup[i].command == command) {
+			_dedup[i].time = edgeTime | 1; // 0 marks an unused entry
+			return age < _dedupWindow;
+		}
+		if (age >= oldestAge) {
+			oldest = i;
+			oldestAge = age;
+		}
+	}
+
+	_dedup[oldest].address = code.address;
+	_dedup[oldest].command = command;
+	_dedup[oldest].time = edgeTime | 1;
+	return false;
+}
+
 void NewRemoteReceiver::interruptHandler() {
+	handleEdge(micros());
+}
+
+void NewRemoteReceiver::handleEdge(unsigned long edgeTime) {
 	// This method is written as compact code to keep it fast. While breaking up this method into more
 	// methods would certainly increase the readability, it would also be much slower to execute.
 	// Making calls to other methods is quite expensive on AVR. As These interrupt handlers are called
@@ -89,7 +128,7 @@ void NewRemoteReceiver::interruptHandler() {
 
 	// Filter out too short pulses. This method works as a low pass filter.
 	edgeTimeStamp[1] = edgeTimeStamp[2];
-	edgeTimeStamp[2] = micros();
+	edgeTimeStamp[2] = edgeTime;
 
 	if (skip) {
 		skip = false;
@@ -185,7 +224,7 @@ void NewRemoteReceiver::interruptHandler() {
 				repeats++;
 				
 				if (repeats>=_minRepeats) {
-					if (!_inCallback) {
+					if (!_inCallback && !_isDuplicate(receivedCode, edgeTime)) {
 						_inCallback = true;
 						(_callback)(receivedCode);
 						_inCallback = false;
@@ -27,6 +27,11 @@ struct NewRemoteCode {
 
 typedef void (*NewRemoteReceiverCallBack)(NewRemoteCode);
 
+// Number of different codes remembered for setDedupWindow()
+#ifndef NEW_REMOTE_RECEIVER_DEDUP_SIZE
+#define NEW_REMOTE_RECEIVER_DEDUP_SIZE 4
+#endif
+
 /**
 * See RemoteSwitch for introduction.
 *
@@ -93,6 +98,25 @@ class NewRemoteReceiver {
 		 */
 		static void interruptHandler();
 
+		/**
+		 * Same as interruptHandler(), for an edge that happened at edgeTime (micros()). Use this
+		 * when edges are queued and handled later, e.g. with InterruptChain::setDeferred().
+		 */
+		static void handleEdge(unsigned long edgeTime);
+
+		/**
+		 * Suppresses the callback for a code that was already reported less than window milliseconds
+		 * ago. A code is the same if address, group bit, switch type, unit and dim level are. A
+		 * remote repeats its code for as long as a button is held, which would otherwise call the
+		 * callback every few repeats. Each received copy restarts the window of its code, so a code
+		 * is reported again once it has been quiet for window milliseconds. The last
+		 * NEW_REMOTE_RECEIVER_DEDUP_SIZE different codes are remembered. Call before init() or while
+		 * disabled.
+		 *
+		 * @param window Window in milliseconds, 0 (default) calls the callback for every repeat group
+		 */
+		static void setDedupWindow(unsigned int window);
+
 	private:
 
 		static int8_t _interrupt;					// Radio input interrupt
@@ -102,6 +126,21 @@ class NewRemoteReceiver {
 		static boolean _inCallback;					// When true, the callback function is being executed; prevents re-entrance.
 		static boolean _enabled;					// If true, monitoring and decoding is enabled. If false, interruptHandler will return immediately.
 
+		struct DedupEntry {
+			unsigned long address;
+			unsigned int command;					// Unit, dim level, switch type and group bit
+			unsigned long time;						// edgeTime of the last copy received
+		};
+		static unsigned long _dedupWindow;			// In microseconds, 0 if off
+		static DedupEntry _dedup[NEW_REMOTE_RECEIVER_DEDUP_SIZE];
+
+		/**
+		 * Remembers code as received at edgeTime.
+		 *
+		 * @return true if the callback is to be suppressed for code
+		 */
+		static boolean _isDuplicate(const NewRemoteCode &code, unsigned long edgeTime);
+
 };
 
 #endif
@@ -14,6 +14,10 @@ NewRemoteTransmitter::NewRemoteTransmitter(unsigned long address, byte pin, unsi
 	_periodusec = periodusec;
 	_repeats = (1 << repeats) - 1; // I.e. _repeats = 2^repeats - 1
 
+#if defined(__AVR__)
+	_pinOutput = portOutputRegister(digitalPinToPort(_pin));
+	_pinBit = digitalPinToBitMask(_pin);
+#endif
 	pinMode(_pin, OUTPUT);
 }
 
@@ -64,13 +68,13 @@ void NewRemoteTransmitter::sendDim(byte unit, byte dimLevel) {
 		_sendBit(false);
 
 		// Switch type 'dim'
-		digitalWrite(_pin, HIGH);
+		_writePin(HIGH);
 		delayMicroseconds(_periodusec);
-		digitalWrite(_pin, LOW);
+		_writePin(LOW);
 		delayMicroseconds(_periodusec);
-		digitalWrite(_pin, HIGH);
+		_writePin(HIGH);
 		delayMicroseconds(_periodusec);
-		digitalWrite(_pin, LOW);
+		_writePin(LOW);
 		delayMicroseconds(_periodusec);
 
 		_sendUnit(unit);
@@ -84,9 +88,9 @@ void NewRemoteTransmitter::sendDim(byte unit, byte dimLevel) {
 }
 
 void NewRemoteTransmitter::_sendStartPulse(){
-	digitalWrite(_pin, HIGH);
+	_writePin(HIGH);
 	delayMicroseconds(_periodusec);
-	digitalWrite(_pin, LOW);
+	_writePin(LOW);
 	delayMicroseconds(_periodusec * 10 + (_periodusec >> 1)); // Actually 10.5T insteat of 10.44T. Close enough.
 }
 
@@ -103,32 +107,100 @@ void NewRemoteTransmitter::_sendUnit(byte unit) {
 }
 
 void NewRemoteTransmitter::_sendStopPulse() {
-	digitalWrite(_pin, HIGH);
+	_writePin(HIGH);
 	delayMicroseconds(_periodusec);
-	digitalWrite(_pin, LOW);
+	_writePin(LOW);
 	delayMicroseconds(_periodusec * 40);
 }
 
 void NewRemoteTransmitter::_sendBit(boolean isBitOne) {
 	if (isBitOne) {
 		// Send '1'
-		digitalWrite(_pin, HIGH);
+		_writePin(HIGH);
 		delayMicroseconds(_periodusec);
-		digitalWrite(_pin, LOW);
+		_writePin(LOW);
 		delayMicroseconds(_periodusec * 5);
-		digitalWrite(_pin, HIGH);
+		_writePin(HIGH);
 		delayMicroseconds(_periodusec);
-		digitalWrite(_pin, LOW);
+		_writePin(LOW);
 		delayMicroseconds(_periodusec);
 	} else {
 		// Send '0'
-		digitalWrite(_pin, HIGH);
+		_writePin(HIGH);
 		delayMicroseconds(_periodusec);
-		digitalWrite(_pin, LOW);
+		_writePin(LOW);
 		delayMicroseconds(_periodusec);
-		digitalWrite(_pin, HIGH);
+		_writePin(HIGH);
 		delayMicroseconds(_periodusec);
-		digitalWrite(_pin, LOW);
+		_writePin(LOW);
 		delayMicroseconds(_periodusec * 5);
 	}
 }
+
+// Pulse symbols: short (T) and long (5T) bit parts, start pulse low part (10.5T) and stop pulse low part (40T)
+#define SYMBOL_T 0
+#define SYMBOL_5T 1
+#define SYMBOL_START 2
+#define SYMBOL_STOP 3
+
+static byte addSymbol(byte *symbols, byte count, byte symbol) {
+	if ((count & 3) == 0) {
+		symbols[count >> 2] = 0;
+	}
+	symbols[count >> 2] |= symbol << ((count & 3) << 1);
+	return count + 1;
+}
+
+// Adds the 4 pulses of a bit: '0' is T,T,T,5T; '1' is T,5T,T,T; dim is T,T,T,T
+static byte addBit(byte *symbols, byte count, byte bit) {
+	count = addSymbol(symbols, count, SYMBOL_T);
+	count = addSymbol(symbols, count, bit == 1 ? SYMBOL_5T : SYMBOL_T);
+	count = addSymbol(symbols, count, SYMBOL_T);
+	return addSymbol(symbols, count, bit == 0 ? SYMBOL_5T : SYMBOL_T);
+}
+
+byte NewRemoteTransmitter::_encodeHeader(boolean groupBit, byte switchType, byte *symbols, unsigned int *durations) {
+	durations[SYMBOL_T] = _periodusec;
+	durations[SYMBOL_5T] = _periodusec * 5;
+	durations[SYMBOL_START] = _periodusec * 10 + (_periodusec >> 1);
+	durations[SYMBOL_STOP] = _periodusec * 40;
+
+	byte count = addSymbol(symbols, 0, SYMBOL_T);
+	count = addSymbol(symbols, count, SYMBOL_START);
+	count = _encodeBits(_address, 26, symbols, count);
+	count = addBit(symbols, count, groupBit);
+	return addBit(symbols, count, switchType);
+}
+
+byte NewRemoteTransmitter::_encodeBits(unsigned long value, byte bits, byte *symbols, byte count) {
+	for (int8_t i = bits - 1; i >= 0; i--) {
+		count = addBit(symbols, count, (value >> i) & 1);
+	}
+	return count;
+}
+
+byte NewRemoteTransmitter::encodeGroup(boolean switchOn, byte *symbols, unsigned int *durations) {
+	byte count = _encodeHeader(true, switchOn, symbols, durations);
+	count = _encodeBits(0, 4, symbols, count);
+	count = addSymbol(symbols, count, SYMBOL_T);
+	return addSymbol(symbols, count, SYMBOL_STOP);
+}
+
+byte NewRemoteTransmitter::encodeUnit(byte unit, boolean switchOn, byte *symbols, unsigned int *durations) {
+	byte count = _encodeHeader(false, switchOn, symbols, durations);
+	count = _encodeBits(unit, 4, symbols, count);
+	count = addSymbol(symbols, count, SYMBOL_T);
+	return addSymbol(symbols, count, SYMBOL_STOP);
+}
+
+byte NewRemoteTransmitter::encodeDim(byte unit, byte dimLevel, byte *symbols, unsigned int *durations) {
+	byte count = _encodeHeader(false, 2, symbols, durations);
+	count = _encodeBits(unit, 4, symbols, count);
+	count = _encodeBits(dimLevel, 4, symbols, count);
+	count = addSymbol(symbols, count, SYMBOL_T);
+	return addSymbol(symbols, count, SYMBOL_STOP);
+}
+
+byte NewRemoteTransmitter::getRepeats() {
+	return _repeats;
+}
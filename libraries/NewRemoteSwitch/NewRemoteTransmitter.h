@@ -9,6 +9,9 @@
 
 #include <Arduino.h>
 
+// Bytes needed for the pulse symbols of the longest telegram (dim), see NewRemoteTransmitter::encodeDim()
+#define NEW_REMOTE_PULSE_BYTES 37
+
 /**
 * NewRemoteTransmitter provides a generic class for simulation of common RF remote controls, like the A-series
 * 'Klik aan Klik uit'-system (http://www.klikaanklikuit.nl/), used to remotely switch lights etc.
@@ -65,11 +68,61 @@ class NewRemoteTransmitter {
 		 */
 		void sendDim(byte unit, byte dimLevel);
 
+		/**
+		 * Encodes the telegram of sendGroup() as pulse symbols instead of sending it, for
+		 * sending from an interrupt with PulseTrain. Pulses alternate between HIGH and LOW,
+		 * starting HIGH, 2 bits per pulse and 4 pulses per byte, first pulse in the lowest bits.
+		 * Symbol n lasts durations[n] microseconds. A telegram is sent getRepeats() + 1 times.
+		 *
+		 * @param switchOn  True to send "on" signal, false to send "off" signal.
+		 * @param symbols	Buffer of NEW_REMOTE_PULSE_BYTES bytes for the symbols
+		 * @param durations	Buffer of 4 durations
+		 * @return The number of pulses
+		 */
+		byte encodeGroup(boolean switchOn, byte *symbols, unsigned int *durations);
+
+		/**
+		 * Encodes the telegram of sendUnit() as pulse symbols, see encodeGroup().
+		 */
+		byte encodeUnit(byte unit, boolean switchOn, byte *symbols, unsigned int *durations);
+
+		/**
+		 * Encodes the telegram of sendDim() as pulse symbols, see encodeGroup().
+		 */
+		byte encodeDim(byte unit, byte dimLevel, byte *symbols, unsigned int *durations);
+
+		/**
+		 * @return The number of times a telegram is repeated after the first one.
+		 */
+		byte getRepeats();
+
 	protected:
 		unsigned long _address;		// Address of this transmitter.
 		byte _pin;					// Transmitter output pin
 		unsigned int _periodusec;	// Oscillator period in microseconds
 		byte _repeats;				// Number over repetitions of one telegram
+#if defined(__AVR__)
+		volatile uint8_t *_pinOutput;	// Output register of _pin
+		uint8_t _pinBit;			// Bit of _pin in _pinOutput
+#endif
+
+		/**
+		 * Sets the transmitter pin, without the lookups of digitalWrite()
+		 */
+		inline void _writePin(uint8_t level) {
+#if defined(__AVR__)
+			uint8_t oldSREG = SREG;
+			cli();
+			if (level) {
+				*_pinOutput |= _pinBit;
+			} else {
+				*_pinOutput &= ~_pinBit;
+			}
+			SREG = oldSREG;
+#else
+			digitalWrite(_pin, level);
+#endif
+		}
 
 		/**
 		 * Transmits start-pulse
@@ -99,5 +152,16 @@ class NewRemoteTransmitter {
 		 * @param isBitOne	True, to send '1', false to send '0'.
 		 */
 		void _sendBit(boolean isBitOne);
+
+		/**
+		 * Encodes start pulse, address, group bit and switch type (0, 1 or 2 for dim) as pulse
+		 * symbols, returns the number of pulses.
+		 */
+		byte _encodeHeader(boolean groupBit, byte switchType, byte *symbols, unsigned int *durations);
+
+		/**
+		 * Encodes the lowest bits bits of value, most significant first, starting at pulse count.
+		 */
+		byte _encodeBits(unsigned long value, byte bits, byte *symbols, byte count);
 };
 #endif
@@ -116,12 +116,22 @@ sample code bearing this copyright.
 
 #include "OneWire.h"
 
+// Slot timing in microseconds for standard and overdrive speed
+#if ONEWIRE_OVERDRIVE
+#define TIMING(standard, fast) (overdrive ? (fast) : (standard))
+#else
+#define TIMING(standard, fast) (standard)
+#endif
+
 
 OneWire::OneWire(uint8_t pin)
 {
 	pinMode(pin, INPUT);
 	bitmask = PIN_TO_BITMASK(pin);
 	baseReg = PIN_TO_BASEREG(pin);
+#if ONEWIRE_OVERDRIVE
+	overdrive = 0;
+#endif
 #if ONEWIRE_SEARCH
 	reset_search();
 #endif
@@ -154,13 +164,13 @@ uint8_t OneWire::reset(void)
 	DIRECT_WRITE_LOW(reg, mask);
 	DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
 	interrupts();
-	delayMicroseconds(480);
+	delayMicroseconds(TIMING(480, 70));
 	noInterrupts();
 	DIRECT_MODE_INPUT(reg, mask);	// allow it to float
-	delayMicroseconds(70);
+	delayMicroseconds(TIMING(70, 9));
 	r = !DIRECT_READ(reg, mask);
 	interrupts();
-	delayMicroseconds(410);
+	delayMicroseconds(TIMING(410, 40));
 	return r;
 }
 
@@ -177,18 +187,18 @@ void OneWire::write_bit(uint8_t v)
 		noInterrupts();
 		DIRECT_WRITE_LOW(reg, mask);
 		DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
-		delayMicroseconds(10);
+		delayMicroseconds(TIMING(10, 1));
 		DIRECT_WRITE_HIGH(reg, mask);	// drive output high
 		interrupts();
-		delayMicroseconds(55);
+		delayMicroseconds(TIMING(55, 8));
 	} else {
 		noInterrupts();
 		DIRECT_WRITE_LOW(reg, mask);
 		DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
-		delayMicroseconds(65);
+		delayMicroseconds(TIMING(65, 8));
 		DIRECT_WRITE_HIGH(reg, mask);	// drive output high
 		interrupts();
-		delayMicroseconds(5);
+		delayMicroseconds(TIMING(5, 3));
 	}
 }
 
@@ -205,12 +215,12 @@ uint8_t OneWire::read_bit(void)
 	noInterrupts();
 	DIRECT_MODE_OUTPUT(reg, mask);
 	DIRECT_WRITE_LOW(reg, mask);
-	delayMicroseconds(3);
+	delayMicroseconds(TIMING(3, 1));
 	DIRECT_MODE_INPUT(reg, mask);	// let pin float, pull up will raise
-	delayMicroseconds(10);
+	delayMicroseconds(TIMING(10, 1));
 	r = DIRECT_READ(reg, mask);
 	interrupts();
-	delayMicroseconds(53);
+	delayMicroseconds(TIMING(53, 7));
 	return r;
 }
 
@@ -291,6 +301,40 @@ void OneWire::depower()
 	interrupts();
 }
 
+#if ONEWIRE_OVERDRIVE
+
+//
+// Switch to overdrive speed. The ROM command is sent at standard speed,
+// everything after it at overdrive speed.
+//
+uint8_t OneWire::overdrive_skip()
+{
+    overdrive = 0;
+    if (!reset()) return 0;
+    write(0x3C);           // Overdrive Skip ROM
+    overdrive = 1;
+    return 1;
+}
+
+uint8_t OneWire::overdrive_select(const uint8_t rom[8])
+{
+    uint8_t i;
+
+    overdrive = 0;
+    if (!reset()) return 0;
+    write(0x69);           // Overdrive Match ROM
+    overdrive = 1;
+    for (i = 0; i < 8; i++) write(rom[i]);
+    return 1;
+}
+
+void OneWire::standard_speed()
+{
+    overdrive = 0;
+}
+
+#endif
+
 #if ONEWIRE_SEARCH
 
 //
@@ -464,7 +508,21 @@ uint8_t OneWire::search(uint8_t *newAddr)
 // "Understanding and Using Cyclic Redundancy Checks with Maxim iButton Products"
 //
 
-#if ONEWIRE_CRC8_TABLE
+#if ONEWIRE_CRC8_TABLE == 2
+// Nibble table: the CRC of the 16 possible low nibbles. Each byte takes
+// two lookups, which is about half the speed of the full table for 16
+// instead of 256 bytes of flash.
+static const uint8_t PROGMEM dscrc_nibble_table[] = {
+      0,157, 35,190, 70,219,101,248,140, 17,175, 50,202, 87,233,116};
+
+static inline uint8_t crc8_byte(uint8_t crc, uint8_t data)
+{
+	crc ^= data;
+	crc = (crc >> 4) ^ pgm_read_byte(dscrc_nibble_table + (crc & 0x0F));
+	crc = (crc >> 4) ^ pgm_read_byte(dscrc_nibble_table + (crc & 0x0F));
+	return crc;
+}
+#elif ONEWIRE_CRC8_TABLE
 // This table comes from Dallas sample code where it is freely reusable,
 // though Copyright (C) 2000 Dallas Semiconductor Corporation
 static const uint8_t PROGMEM dscrc_table[] = {
@@ -492,36 +550,51 @@ static const uint8_t PROGMEM dscrc_table[] = {
 // compared to all those delayMicrosecond() calls.  But I got
 // confused, so I use this table from the examples.)
 //
-uint8_t OneWire::crc8(const uint8_t *addr, uint8_t len)
+static inline uint8_t crc8_byte(uint8_t crc, uint8_t data)
 {
-	uint8_t crc = 0;
-
-	while (len--) {
-		crc = pgm_read_byte(dscrc_table + (crc ^ *addr++));
-	}
-	return crc;
+	return pgm_read_byte(dscrc_table + (crc ^ data));
 }
 #else
 //
 // Compute a Dallas Semiconductor 8 bit CRC directly.
 // this is much slower, but much smaller, than the lookup table.
 //
+static inline uint8_t crc8_byte(uint8_t crc, uint8_t inbyte)
+{
+	for (uint8_t i = 8; i; i--) {
+		uint8_t mix = (crc ^ inbyte) & 0x01;
+		crc >>= 1;
+		if (mix) crc ^= 0x8C;
+		inbyte >>= 1;
+	}
+	return crc;
+}
+#endif
+
 uint8_t OneWire::crc8(const uint8_t *addr, uint8_t len)
 {
 	uint8_t crc = 0;
-	
+
 	while (len--) {
-		uint8_t inbyte = *addr++;
-		for (uint8_t i = 8; i; i--) {
-			uint8_t mix = (crc ^ inbyte) & 0x01;
-			crc >>= 1;
-			if (mix) crc ^= 0x8C;
-			inbyte >>= 1;
-		}
+		crc = crc8_byte(crc, *addr++);
 	}
 	return crc;
 }
-#endif
+
+uint8_t OneWire::crc8_update(uint8_t crc, uint8_t data)
+{
+	return crc8_byte(crc, data);
+}
+
+//
+// Read bytes and compute their CRC8 while they arrive
+//
+uint8_t OneWire::read_bytes_crc8(uint8_t *buf, uint16_t count, uint8_t crc)
+{
+  for (uint16_t i = 0 ; i < count ; i++)
+    crc = crc8_byte(crc, buf[i] = read());
+  return crc;
+}
 
 #if ONEWIRE_CRC16
 bool OneWire::check_crc16(const uint8_t* input, uint16_t len, const uint8_t* inverted_crc, uint16_t crc)
@@ -530,28 +603,91 @@ bool OneWire::check_crc16(const uint8_t* input, uint16_t len, const uint8_t* inv
     return (crc & 0xFF) == inverted_crc[0] && (crc >> 8) == inverted_crc[1];
 }
 
-uint16_t OneWire::crc16(const uint8_t* input, uint16_t len, uint16_t crc)
+#if ONEWIRE_CRC16_TABLE
+// CRC16 (polynomial 0xA001, reflected) of every possible byte
+static const uint16_t PROGMEM crc16_table[] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040};
+
+static inline uint16_t crc16_byte(uint16_t crc, uint8_t data)
 {
-    static const uint8_t oddparity[16] =
-        { 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0 };
+    return (crc >> 8) ^ pgm_read_word(crc16_table + ((crc ^ data) & 0xff));
+}
+#else
+static const uint8_t oddparity[16] =
+    { 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0 };
 
+static inline uint16_t crc16_byte(uint16_t crc, uint8_t data)
+{
+    // Even though we're just copying a byte from the input,
+    // we'll be doing 16-bit computation with it.
+    uint16_t cdata = data;
+    cdata = (cdata ^ crc) & 0xff;
+    crc >>= 8;
+
+    if (oddparity[cdata & 0x0F] ^ oddparity[cdata >> 4])
+        crc ^= 0xC001;
+
+    cdata <<= 6;
+    crc ^= cdata;
+    cdata <<= 1;
+    crc ^= cdata;
+    return crc;
+}
+#endif
+
+uint16_t OneWire::crc16(const uint8_t* input, uint16_t len, uint16_t crc)
+{
     for (uint16_t i = 0 ; i < len ; i++) {
-      // Even though we're just copying a byte from the input,
-      // we'll be doing 16-bit computation with it.
-      uint16_t cdata = input[i];
-      cdata = (cdata ^ crc) & 0xff;
-      crc >>= 8;
-
-      if (oddparity[cdata & 0x0F] ^ oddparity[cdata >> 4])
-          crc ^= 0xC001;
-
-      cdata <<= 6;
-      crc ^= cdata;
-      cdata <<= 1;
-      crc ^= cdata;
+      crc = crc16_byte(crc, input[i]);
     }
     return crc;
 }
+
+uint16_t OneWire::crc16_update(uint16_t crc, uint8_t data)
+{
+    return crc16_byte(crc, data);
+}
+
+//
+// Read bytes and compute their CRC16 while they arrive
+//
+uint16_t OneWire::read_bytes_crc16(uint8_t *buf, uint16_t count, uint16_t crc)
+{
+  for (uint16_t i = 0 ; i < count ; i++)
+    crc = crc16_byte(crc, buf[i] = read());
+  return crc;
+}
 #endif
 
 #endif
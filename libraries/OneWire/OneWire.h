@@ -34,7 +34,8 @@
 // by setting this to 1.  The lookup table enlarges code size by
 // about 250 bytes.  It does NOT consume RAM (but did in very
 // old versions of OneWire).  If you disable this, a slower
-// but very compact algorithm is used.
+// but very compact algorithm is used.  Setting this to 2 selects
+// a 16 byte nibble table, which sits between the two.
 #ifndef ONEWIRE_CRC8_TABLE
 #define ONEWIRE_CRC8_TABLE 1
 #endif
@@ -45,6 +46,20 @@
 #define ONEWIRE_CRC16 1
 #endif
 
+// Select the table-lookup method of computing the 16-bit CRC
+// by setting this to 1.  The lookup table enlarges code size by
+// about 500 bytes of flash.
+#ifndef ONEWIRE_CRC16_TABLE
+#define ONEWIRE_CRC16_TABLE 0
+#endif
+
+// You can exclude overdrive speed support by defining this to 0.
+// Overdrive timing is about 10 times faster and needs a CPU clock of
+// at least 16 MHz to be met.
+#ifndef ONEWIRE_OVERDRIVE
+#define ONEWIRE_OVERDRIVE 1
+#endif
+
 #define FALSE 0
 #define TRUE  1
 
@@ -115,6 +130,11 @@ class OneWire
     IO_REG_TYPE bitmask;
     volatile IO_REG_TYPE *baseReg;
 
+#if ONEWIRE_OVERDRIVE
+    // nonzero while the bus is talked to at overdrive speed
+    uint8_t overdrive;
+#endif
+
 #if ONEWIRE_SEARCH
     // global search state
     unsigned char ROM_NO[8];
@@ -164,6 +184,23 @@ class OneWire
     // someone shorts your bus.
     void depower(void);
 
+#if ONEWIRE_OVERDRIVE
+    // Switch all overdrive capable devices to overdrive speed.  This
+    // sends a standard speed reset and the Overdrive Skip ROM command,
+    // after which all devices are addressed and you can go on with a
+    // function command. All further resets, reads and writes use
+    // overdrive timing.  Returns 0 if no device responds.
+    uint8_t overdrive_skip(void);
+
+    // Like overdrive_skip() but only the device with the given rom is
+    // switched to overdrive speed and selected.
+    uint8_t overdrive_select(const uint8_t rom[8]);
+
+    // Go back to standard speed timing.  The next reset() is a standard
+    // speed reset, which also returns all devices to standard speed.
+    void standard_speed(void);
+#endif
+
 #if ONEWIRE_SEARCH
     // Clear the search state so that if will start from the beginning again.
     void reset_search();
@@ -186,6 +223,14 @@ class OneWire
     // ROM and scratchpad registers.
     static uint8_t crc8(const uint8_t *addr, uint8_t len);
 
+    // Add one byte to a running 8 bit CRC.
+    static uint8_t crc8_update(uint8_t crc, uint8_t data);
+
+    // Read bytes like read_bytes() and compute their 8 bit CRC as they
+    // are received, starting from 'crc'.  When the last byte read is the
+    // CRC sent by the device, the result is 0 if the data is valid.
+    uint8_t read_bytes_crc8(uint8_t *buf, uint16_t count, uint8_t crc = 0);
+
 #if ONEWIRE_CRC16
     // Compute the 1-Wire CRC16 and compare it against the received CRC.
     // Example usage (reading a DS2408):
@@ -222,6 +267,14 @@ class OneWire
     // @param crc - The crc starting value (optional)
     // @return The CRC16, as defined by Dallas Semiconductor.
     static uint16_t crc16(const uint8_t* input, uint16_t len, uint16_t crc = 0);
+
+    // Add one byte to a running 16 bit CRC.
+    static uint16_t crc16_update(uint16_t crc, uint8_t data);
+
+    // Read bytes like read_bytes() and compute their 16 bit CRC as they
+    // are received, starting from 'crc'.  The result can be checked
+    // against the inverted CRC as in check_crc16().
+    uint16_t read_bytes_crc16(uint8_t *buf, uint16_t count, uint16_t crc = 0);
 #endif
 #endif
 };
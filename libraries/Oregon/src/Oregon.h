@@ -16,6 +16,7 @@ class DecodeOOK
 {
 protected:
     byte total_bits, bits, flip, state, pos, data[25];
+    unsigned long lastEdge;
 
     virtual char decode (word width) =0;
 
@@ -23,7 +24,7 @@ public:
 
     enum { UNKNOWN, T0, T1, T2, T3, OK, DONE };
 
-    DecodeOOK () { resetDecoder(); }
+    DecodeOOK () : lastEdge(0) { resetDecoder(); }
 
     bool nextPulse (word width) {
         if (state != DONE)
@@ -35,6 +36,14 @@ public:
         return isDone();
     }
 
+    // Same as nextPulse(), from the time (micros()) of an edge instead of the pulse width.
+    // For edges queued by an interrupt and handled later, e.g. with InterruptChain::setDeferred().
+    bool nextEdge (unsigned long edgeTime) {
+        unsigned long width = edgeTime - lastEdge;
+        lastEdge = edgeTime;
+        return nextPulse(width > 0xFFFF ? 0xFFFF : width);
+    }
+
     bool isDone () const { return state == DONE; }
 
     const byte* getData (byte& count) const {
@@ -181,6 +190,70 @@ class OregonDecoderV2 : public DecodeOOK {
     }
 };
 
+/*--------------------------
+Class OregonDecoderV3
+--------------------------*/
+class OregonDecoderV3 : public DecodeOOK {
+  public:
+
+    OregonDecoderV3() {}
+
+    // add one bit to the packet data buffer
+    virtual void gotBit (char value) {
+        data[pos] = (data[pos] >> 1) | (value ? 0x80 : 00);
+        total_bits++;
+        pos = total_bits >> 3;
+        if (pos >= sizeof data) {
+            resetDecoder();
+            return;
+        }
+        state = OK;
+    }
+
+    virtual char decode (word width) {
+        if (200 <= width && width < 1200) {
+            byte w = width >= 700;
+
+            switch (state) {
+                case UNKNOWN:
+                    if (w == 0) {
+                        // Short pulse, preamble
+                        ++flip;
+                    } else if (32 <= flip) {
+                        // Long pulse after the preamble, first bit
+                        flip = 1;
+                        manchester(1);
+                    } else {
+                        // Reset decoder
+                        return -1;
+                    }
+                    break;
+                case OK:
+                    if (w == 0) {
+                        // Short pulse
+                        state = T0;
+                    } else {
+                        // Long pulse
+                        manchester(1);
+                    }
+                    break;
+                case T0:
+                    if (w == 0) {
+                        // Second short pulse
+                        manchester(0);
+                    } else {
+                        // Reset decoder
+                        return -1;
+                    }
+                    break;
+            }
+        } else {
+            return -1;
+        }
+        return total_bits == 80 ? 1 : 0;
+    }
+};
+
 /*--------------------------
 Manipulation functions
 --------------------------*/
@@ -38,6 +38,7 @@
 PN532::PN532(PN532Interface &interface)
 {
     _interface = &interface;
+    memset(_sectorKey, 0, sizeof(_sectorKey));
 }
 
 /**************************************************************************/
@@ -276,15 +277,54 @@ bool PN532::setPassiveActivationRetries(uint8_t maxRetries)
 */
 /**************************************************************************/
 bool PN532::readPassiveTargetID(uint8_t cardbaudrate, uint8_t *uid, uint8_t *uidLength, uint16_t timeout)
+{
+    if (!startPassiveTargetIDDetection(cardbaudrate)) {
+        return 0x0;
+    }
+
+    return readDetectedPassiveTargetID(uid, uidLength, timeout);
+}
+
+/**************************************************************************/
+/*!
+    Starts waiting for an ISO14443A target to enter the field, and returns
+    as soon as the PN532 acknowledged the command. Poll isReady(), or wait
+    for the IRQ pin to go low, then get the result with
+    readDetectedPassiveTargetID(). No other command may be sent meanwhile.
+
+    By default the PN532 waits forever for a card, see
+    setPassiveActivationRetries().
+
+    @param  cardBaudRate  Baud rate of the card
+
+    @returns 1 if the command was accepted, 0 for an error
+*/
+/**************************************************************************/
+bool PN532::startPassiveTargetIDDetection(uint8_t cardbaudrate)
 {
     pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
     pn532_packetbuffer[1] = 1;  // max 1 cards at once (we can set this to 2 later)
     pn532_packetbuffer[2] = cardbaudrate;
 
-    if (HAL(writeCommand)(pn532_packetbuffer, 3)) {
-        return 0x0;  // command failed
-    }
+    return 0 == HAL(writeCommand)(pn532_packetbuffer, 3);
+}
+
+/**************************************************************************/
+/*!
+    Reads the result of startPassiveTargetIDDetection()
+
+    @param  uid           Pointer to the array that will be populated
+                          with the card's UID (up to 7 bytes)
+    @param  uidLength     Pointer to the variable that will hold the
+                          length of the card's UID.
+    @param  timeout       Max time to wait for the result in ms, 0 means
+                          no timeout
 
+    @returns 1 if a card was found, 0 for an error or no card
+*/
+/**************************************************************************/
+bool PN532::readDetectedPassiveTargetID(uint8_t *uid, uint8_t *uidLength, uint16_t timeout)
+{
     // read data packet
     if (HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer), timeout) < 0) {
         return 0x0;
@@ -593,6 +633,129 @@ uint8_t PN532::mifareclassic_WriteNDEFURI (uint8_t sectorNumber, uint8_t uriIden
     return 1;
 }
 
+/**************************************************************************/
+/*!
+    Number of blocks in a sector, including the sector trailer
+
+    @param  sectorNumber  The sector (0..15 for 1K cards, 0..39 for 4K
+                          cards)
+
+    @returns 4 for sectors 0..31, 16 for sectors 32..39
+*/
+/**************************************************************************/
+uint8_t PN532::mifareclassic_SectorBlockCount (uint8_t sectorNumber)
+{
+    return (sectorNumber < 32) ? 4 : 16;
+}
+
+/**************************************************************************/
+/*!
+    Authenticates a sector with the first key of keys that works, trying
+    the key that worked last time for this sector first. After a failed
+    attempt the card is halted, so it is selected again before the next
+    key is tried.
+
+    @returns 1 if authenticated, 0 if no key worked or the card is gone
+*/
+/**************************************************************************/
+uint8_t PN532::mifareclassic_AuthenticateSector (uint8_t *uid, uint8_t uidLen, uint8_t sectorNumber, uint8_t keyNumber, const uint8_t (*keys)[6], uint8_t keyCount)
+{
+    uint8_t firstBlock = (sectorNumber < 32) ? sectorNumber * 4 : 128 + (sectorNumber - 32) * 16;
+    uint8_t cached = (sectorNumber < MIFARE_KEY_CACHE_SECTORS) ? _sectorKey[sectorNumber] : 0;
+    if (cached >= keyCount) {
+        cached = 0;
+    }
+
+    for (uint8_t i = 0; i < keyCount; i++) {
+        // Cached key first, then the others in order
+        uint8_t k = (i == 0) ? cached : ((i <= cached) ? i - 1 : i);
+
+        if (i > 0) {
+            uint8_t selectedUid[7];
+            uint8_t selectedUidLen;
+            if (!readPassiveTargetID(PN532_MIFARE_ISO14443A, selectedUid, &selectedUidLen, 100) ||
+                    selectedUidLen != uidLen || memcmp(selectedUid, uid, uidLen)) {
+                DMSG("Card lost\n");
+                return 0;
+            }
+        }
+
+        if (mifareclassic_AuthenticateBlock(uid, uidLen, firstBlock, keyNumber, (uint8_t *)keys[k])) {
+            if (sectorNumber < MIFARE_KEY_CACHE_SECTORS) {
+                _sectorKey[sectorNumber] = k;
+            }
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**************************************************************************/
+/*!
+    Reads all data blocks of a sector (not the sector trailer), with one
+    authentication for the whole sector.
+
+    @param  uid           Pointer to a byte array containing the card UID
+    @param  uidLen        The length (in bytes) of the card's UID
+    @param  sectorNumber  The sector (0..15 for 1K cards, 0..39 for 4K
+                          cards)
+    @param  data          Pointer to the byte array that will hold the
+                          data, 16 bytes per data block, so 48 bytes
+                          (240 for sectors 32..39)
+    @param  keyNumber     Which key type to use during authentication
+                          (0 = MIFARE_CMD_AUTH_A, 1 = MIFARE_CMD_AUTH_B)
+    @param  keys          Candidate keys of 6 bytes. The one that worked
+                          last time for this sector is tried first.
+    @param  keyCount      Number of keys
+
+    @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+uint8_t PN532::mifareclassic_ReadSector (uint8_t *uid, uint8_t uidLen, uint8_t sectorNumber, uint8_t *data, uint8_t keyNumber, const uint8_t (*keys)[6], uint8_t keyCount)
+{
+    if (!mifareclassic_AuthenticateSector(uid, uidLen, sectorNumber, keyNumber, keys, keyCount)) {
+        return 0;
+    }
+
+    uint8_t firstBlock = (sectorNumber < 32) ? sectorNumber * 4 : 128 + (sectorNumber - 32) * 16;
+    uint8_t dataBlocks = mifareclassic_SectorBlockCount(sectorNumber) - 1;
+    for (uint8_t i = 0; i < dataBlocks; i++) {
+        if (!mifareclassic_ReadDataBlock(firstBlock + i, data + 16 * i)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**************************************************************************/
+/*!
+    Writes all data blocks of a sector (not the sector trailer), with one
+    authentication for the whole sector. Parameters as for
+    mifareclassic_ReadSector(). Block 0 (manufacturer data) is read only,
+    its 16 bytes in data are skipped.
+
+    @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+uint8_t PN532::mifareclassic_WriteSector (uint8_t *uid, uint8_t uidLen, uint8_t sectorNumber, const uint8_t *data, uint8_t keyNumber, const uint8_t (*keys)[6], uint8_t keyCount)
+{
+    if (!mifareclassic_AuthenticateSector(uid, uidLen, sectorNumber, keyNumber, keys, keyCount)) {
+        return 0;
+    }
+
+    uint8_t firstBlock = (sectorNumber < 32) ? sectorNumber * 4 : 128 + (sectorNumber - 32) * 16;
+    uint8_t dataBlocks = mifareclassic_SectorBlockCount(sectorNumber) - 1;
+    for (uint8_t i = (sectorNumber == 0) ? 1 : 0; i < dataBlocks; i++) {
+        if (!mifareclassic_WriteDataBlock(firstBlock + i, (uint8_t *)data + 16 * i)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 /***** Mifare Ultralight Functions ******/
 
 /**************************************************************************/
@@ -79,6 +79,9 @@
 #define MIFARE_CMD_INCREMENT                (0xC1)
 #define MIFARE_CMD_STORE                    (0xC2)
 
+// Sectors for which mifareclassic_ReadSector() and mifareclassic_WriteSector() remember the key
+#define MIFARE_KEY_CACHE_SECTORS            (16)
+
 // Prefixes for NDEF Records (to identify record type)
 #define NDEF_URIPREFIX_NONE                 (0x00)
 #define NDEF_URIPREFIX_HTTP_WWWDOT          (0x01)
@@ -139,6 +142,14 @@ public:
     uint8_t readGPIO(void);
     bool setPassiveActivationRetries(uint8_t maxRetries);
 
+    /**
+    * @brief    check if the response of a started command is ready, without waiting
+    * @return   true    the response can be read right away
+    */
+    bool isReady() {
+        return _interface->isReady();
+    };
+
     /**
     * @brief    Init PN532 as a target
     * @param    timeout max time to wait, 0 means no timeout
@@ -153,6 +164,8 @@ public:
     // ISO14443A functions
     bool inListPassiveTarget();
     bool readPassiveTargetID(uint8_t cardbaudrate, uint8_t *uid, uint8_t *uidLength, uint16_t timeout = 1000);
+    bool startPassiveTargetIDDetection(uint8_t cardbaudrate);
+    bool readDetectedPassiveTargetID(uint8_t *uid, uint8_t *uidLength, uint16_t timeout = 30);
     bool inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint8_t *responseLength);
 
     // Mifare Classic functions
@@ -163,6 +176,9 @@ public:
     uint8_t mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t *data);
     uint8_t mifareclassic_FormatNDEF (void);
     uint8_t mifareclassic_WriteNDEFURI (uint8_t sectorNumber, uint8_t uriIdentifier, const char *url);
+    uint8_t mifareclassic_SectorBlockCount (uint8_t sectorNumber);
+    uint8_t mifareclassic_ReadSector (uint8_t *uid, uint8_t uidLen, uint8_t sectorNumber, uint8_t *data, uint8_t keyNumber, const uint8_t (*keys)[6], uint8_t keyCount);
+    uint8_t mifareclassic_WriteSector (uint8_t *uid, uint8_t uidLen, uint8_t sectorNumber, const uint8_t *data, uint8_t keyNumber, const uint8_t (*keys)[6], uint8_t keyCount);
 
     // Mifare Ultralight functions
     uint8_t mifareultralight_ReadPage (uint8_t page, uint8_t *buffer);
@@ -181,6 +197,9 @@ private:
     uint8_t _uidLen;  // uid len
     uint8_t _key[6];  // Mifare Classic key
     uint8_t inListedTag; // Tg number of inlisted tag.
+    uint8_t _sectorKey[MIFARE_KEY_CACHE_SECTORS];  // Index of the key that last worked for each sector
+
+    uint8_t mifareclassic_AuthenticateSector (uint8_t *uid, uint8_t uidLen, uint8_t sectorNumber, uint8_t keyNumber, const uint8_t (*keys)[6], uint8_t keyCount);
 
     uint8_t pn532_packetbuffer[64];
 
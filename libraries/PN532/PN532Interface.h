@@ -50,6 +50,15 @@ public:
     *           <0      failed to read response
     */
     virtual int16_t readResponse(uint8_t buf[], uint8_t len, uint16_t timeout = 1000) = 0;
+
+    /**
+    * @brief    check if the PN532 has a response ready, without waiting
+    * @return   true    readResponse() will not have to wait. Interfaces that can't tell
+    *                   always return true, readResponse() then waits as before.
+    */
+    virtual bool isReady() {
+        return true;
+    }
 };
 
 #endif
@@ -39,7 +39,8 @@ int8_t LLCP::waitForConnection(uint16_t timeout)
 	uint8_t type;
 	(void)timeout;
 
-	sequence = 0;
+	sendSequence = 0;
+	receiveSequence = 0;
 
 	// Get CONNECT PDU
 	DMSG("wait for a CONNECT PDU\n");
@@ -117,7 +118,8 @@ int8_t LLCP::connect(uint16_t timeout)
 	uint8_t type;
 	(void)timeout;
 
-	sequence = 0;
+	sendSequence = 0;
+	receiveSequence = 0;
 
 	// try to get a SYMM PDU
 	if (2 > link.read(headerBuf, headerBufLen)) {
@@ -211,9 +213,15 @@ int8_t LLCP::disconnect(uint16_t timeout)
 
 bool LLCP::write(const uint8_t *header, uint8_t hlen, const uint8_t *body, uint8_t blen)
 {
-	uint8_t buf[3];
+	uint8_t buf[4];		// status of TgGetData and a RR PDU
+	uint8_t type;
 
-	if (2 != link.read(buf, sizeof(buf))) {
+	// The peer sends a SYMM PDU, or a RR PDU for our last I PDU
+	if (2 > link.read(buf, sizeof(buf))) {
+		return false;
+	}
+	type = getPType(buf);
+	if (PDU_SYMM != type && PDU_RR != type) {
 		return false;
 	}
 
@@ -227,12 +235,12 @@ bool LLCP::write(const uint8_t *header, uint8_t hlen, const uint8_t *body, uint8
 
 	headerBuf[0] = (dsap << 2) + (PDU_I >> 2);
 	headerBuf[1] = ((PDU_I & 0x3) << 6) + ssap;
-	headerBuf[2] = sequence;		// sequence
+	headerBuf[2] = (sendSequence << 4) + receiveSequence;	// N(S), N(R)
 	if (!link.write(headerBuf, 3 + hlen, body, blen)) {
 		return false;
 	}
 
-	sequence++;
+	sendSequence = (sendSequence + 1) & 0x0F;
 
 	return true;
 }
@@ -252,7 +260,7 @@ int16_t LLCP::read(uint8_t *buf, uint8_t length)
 		type = getPType(buf);
 		if (PDU_I == type) {
 			break;
-		} else if (PDU_SYMM == type) {
+		} else if (PDU_SYMM == type || PDU_RR == type) {
 			if (!link.write(SYMM_PDU, sizeof(SYMM_PDU))) {
 				return -2;
 			}
@@ -262,21 +270,25 @@ int16_t LLCP::read(uint8_t *buf, uint8_t length)
 
 	} while (1);
 
+	if (3 > status) {
+		return -3;
+	}
+
 	uint8_t len = status - 3;
+	receiveSequence = ((buf[2] >> 4) + 1) & 0x0F;
 	ssap = getDSAP(buf);
 	dsap = getSSAP(buf);
-	buf[0] = (dsap << 2) + (PDU_RR >> 2);
-	buf[1] = ((PDU_RR & 0x3) << 6) + ssap;
-	buf[2] = 0x01;		// sequence
-	if (!link.write(buf, 3)) {
-		return -2;
-	}
 
-	for (uint8_t i = 0; i < len; i++) {
-		buf[i] = buf[i + 3];
-	}
+	memmove(buf, buf + 3, len);
 
-	sequence++;
+	// buf may be the packet buffer of the PN532, which link.write() uses
+	uint8_t rr[3];
+	rr[0] = (dsap << 2) + (PDU_RR >> 2);
+	rr[1] = ((PDU_RR & 0x3) << 6) + ssap;
+	rr[2] = receiveSequence;		// N(R)
+	if (!link.write(rr, sizeof(rr))) {
+		return -2;
+	}
 
 	return len;
 }
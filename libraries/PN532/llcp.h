@@ -7,12 +7,14 @@
 #define LLCP_DEFAULT_TIMEOUT  20000
 #define LLCP_DEFAULT_DSAP     0x04
 #define LLCP_DEFAULT_SSAP     0x20
+#define LLCP_DEFAULT_MIU      128     // Maximum information unit, the largest I PDU body without MIUX
 
 class LLCP {
 public:
 	LLCP(PN532Interface &interface) : link(interface) {
         headerBuf = link.getHeaderBuffer(&headerBufLen);
-        sequence = 0;
+        sendSequence = 0;
+        receiveSequence = 0;
 	};
 
 	/**
@@ -33,7 +35,9 @@ public:
     int8_t disconnect(uint16_t timeout = LLCP_DEFAULT_TIMEOUT);
 
 	/**
-    * @brief    write a packet, the packet should be less than (255 - 2) bytes
+    * @brief    write a packet as I PDU, after the PDU of the peer (SYMM or RR) is received.
+    *           The packet should be less than (255 - 2) bytes and hlen + blen at most
+    *           LLCP_DEFAULT_MIU. The body is sent from its own buffer, it is not copied.
     * @param    header  packet header
     * @param    hlen    length of header
     * @param    body    packet body
@@ -44,8 +48,10 @@ public:
     bool write(const uint8_t *header, uint8_t hlen, const uint8_t *body = 0, uint8_t blen = 0);
 
     /**
-    * @brief    read a  packet, the packet will be less than (255 - 2) bytes
-    * @param    buf     the buffer to contain the packet
+    * @brief    read a  packet, the packet will be less than (255 - 2) bytes. The I PDU is
+    *           acknowledged with a RR PDU.
+    * @param    buf     the buffer to contain the packet, it needs 4 bytes more than the packet
+    *                   for the PDU header
     * @param    len     lenght of the buffer
     * @return   >=0     length of the packet 
     *           <0      failed
@@ -64,7 +70,8 @@ private:
 	uint8_t dsap;
     uint8_t *headerBuf;
     uint8_t headerBufLen;
-    uint8_t sequence;
+    uint8_t sendSequence;       // N(S) of the next I PDU sent
+    uint8_t receiveSequence;    // N(R), N(S) of the next I PDU expected
 
 	static uint8_t SYMM_PDU[2];
 };
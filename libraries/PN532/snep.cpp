@@ -2,7 +2,7 @@
 #include "snep.h"
 #include "PN532_debug.h"
 
-int8_t SNEP::write(const uint8_t *buf, uint8_t len, uint16_t timeout)
+int8_t SNEP::write(const uint8_t *buf, uint16_t len, uint16_t timeout)
 {
 	if (0 >= llcp.activate(timeout)) {
 		DMSG("failed to activate PN532 as a target\n");
@@ -14,30 +14,53 @@ int8_t SNEP::write(const uint8_t *buf, uint8_t len, uint16_t timeout)
 		return -2;
 	}
 
-	// response a success SNEP message
+	// responses are read into their own buffer, the header buffer is also the PN532's packet buffer
+	uint8_t response[16];
+
+	// put request, with as much of the message as fits in the first fragment
 	headerBuf[0] = SNEP_DEFAULT_VERSION;
 	headerBuf[1] = SNEP_REQUEST_PUT;
 	headerBuf[2] = 0;
 	headerBuf[3] = 0;
-	headerBuf[4] = 0;
+	headerBuf[4] = len >> 8;
 	headerBuf[5] = len;
-	if (0 >= llcp.write(headerBuf, 6, buf, len)) {
+	uint16_t sent = min(len, (uint16_t)(LLCP_DEFAULT_MIU - SNEP_HEADER_SIZE));
+	if (0 >= llcp.write(headerBuf, SNEP_HEADER_SIZE, buf, sent)) {
 		return -3;
 	}
+
+	if (sent < len) {
+		// the peer has to accept a fragmented message first
+		if (SNEP_HEADER_SIZE > llcp.read(response, sizeof(response))) {
+			return -4;
+		}
+		if (SNEP_DEFAULT_VERSION != response[0] || SNEP_RESPONSE_CONTINUE != response[1]) {
+			DMSG("Expect a continue response\n");
+			return -4;
+		}
+
+		while (sent < len) {
+			uint8_t fragment = min(len - sent, LLCP_DEFAULT_MIU);
+			if (0 >= llcp.write(0, 0, buf + sent, fragment)) {
+				return -3;
+			}
+			sent += fragment;
+		}
+	}
 	
-	if (6 > llcp.read(headerBuf, headerBufLen)) {
+	if (SNEP_HEADER_SIZE > llcp.read(response, sizeof(response))) {
 		return -4;
 	}
 
 	// check SNEP version
-	if (SNEP_DEFAULT_VERSION != headerBuf[0]) {
+	if (SNEP_DEFAULT_VERSION != response[0]) {
 		DMSG("The received SNEP message's major version is different\n");
 		// To-do: send Unsupported Version response
 		return -4;
 	}
 
-	// expect a put request
-	if (SNEP_RESPONSE_SUCCESS != headerBuf[1]) {
+	// expect a success response
+	if (SNEP_RESPONSE_SUCCESS != response[1]) {
 		DMSG("Expect a success response\n");
 		return -4;
 	}
@@ -47,7 +70,7 @@ int8_t SNEP::write(const uint8_t *buf, uint8_t len, uint16_t timeout)
 	return 1;
 }
 
-int16_t SNEP::read(uint8_t *buf, uint8_t len, uint16_t timeout)
+int16_t SNEP::read(uint8_t *buf, uint16_t len, uint16_t timeout)
 {
 	if (0 >= llcp.activate(timeout)) {
 		DMSG("failed to activate PN532 as a target\n");
@@ -59,8 +82,8 @@ int16_t SNEP::read(uint8_t *buf, uint8_t len, uint16_t timeout)
 		return -2;
 	}
 
-	uint16_t status = llcp.read(buf, len);
-	if (6 > status) {
+	int16_t status = llcp.read(buf, min(len, (uint16_t)255));
+	if (SNEP_HEADER_SIZE > status) {
 		return -3;
 	}
 
@@ -78,25 +101,43 @@ int16_t SNEP::read(uint8_t *buf, uint8_t len, uint16_t timeout)
 		return -4;
 	}
 
-	// check message's length
+	// check message's length, the last fragment needs room for its PDU header too
 	uint32_t length = ((uint32_t)buf[2] << 24) + ((uint32_t)buf[3] << 16) + (buf[4] << 8) + buf[5];
-	// length should not be more than 244 (header + body < 255, header = 6 + 3 + 2)
-	if (length > (status - 6)) {
+	uint16_t received = status - SNEP_HEADER_SIZE;
+	if (length + 10 > len || length < received) {
 		DMSG("The SNEP message is too large\n"); 
+		writeResponse(SNEP_RESPONSE_EXCESS_DATA);
 		return -4;
 	}
-	for (uint8_t i = 0; i < length; i++) {
-		buf[i] = buf[i + 6];
+	memmove(buf, buf + SNEP_HEADER_SIZE, received);
+
+	if (received < length) {
+		// accept the fragmented message, then each fragment is read right behind the previous one
+		if (!writeResponse(SNEP_RESPONSE_CONTINUE)) {
+			return -3;
+		}
+		while (received < length) {
+			status = llcp.read(buf + received, min(len - received, 255));
+			if (0 >= status || received + status > length) {
+				return -3;
+			}
+			received += status;
+		}
 	}
 
 	// response a success SNEP message
+	writeResponse(SNEP_RESPONSE_SUCCESS);
+
+	return length;
+}
+
+bool SNEP::writeResponse(uint8_t response)
+{
 	headerBuf[0] = SNEP_DEFAULT_VERSION;
-	headerBuf[1] = SNEP_RESPONSE_SUCCESS;
+	headerBuf[1] = response;
 	headerBuf[2] = 0;
 	headerBuf[3] = 0;
 	headerBuf[4] = 0;
 	headerBuf[5] = 0;
-	llcp.write(headerBuf, 6);
-
-	return length;
+	return llcp.write(headerBuf, SNEP_HEADER_SIZE);
 }
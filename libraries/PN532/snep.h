@@ -10,9 +10,13 @@
 #define SNEP_REQUEST_PUT		0x02
 #define SNEP_REQUEST_GET		0x01
 
+#define SNEP_RESPONSE_CONTINUE	0x80
 #define SNEP_RESPONSE_SUCCESS	0x81
+#define SNEP_RESPONSE_EXCESS_DATA	0xC1
 #define SNEP_RESPONSE_REJECT	0xFF
 
+#define SNEP_HEADER_SIZE		6
+
 class SNEP {
 public:
 	SNEP(PN532Interface &interface) : llcp(interface) {
@@ -20,7 +24,9 @@ public:
 	};
 
 	/**
-    * @brief    write a SNEP packet, the packet should be less than (255 - 2 - 3) bytes
+    * @brief    write a SNEP packet. A packet larger than one LLCP information field
+    *           (LLCP_DEFAULT_MIU - 6 bytes) is fragmented, the fragments are sent straight
+    *           from buf.
     * @param    buf     the buffer to contain the packet
     * @param    len     lenght of the buffer
     * @param    timeout max time to wait, 0 means no timeout
@@ -28,22 +34,25 @@ public:
     *			=0      timeout
     *           <0      failed
     */
-    int8_t write(const uint8_t *buf, uint8_t len, uint16_t timeout = 0);
+    int8_t write(const uint8_t *buf, uint16_t len, uint16_t timeout = 0);
 
     /**
-    * @brief    read a SNEP packet, the packet will be less than (255 - 2 - 3) bytes
-    * @param    buf     the buffer to contain the packet
-    * @param    len     lenght of the buffer
+    * @brief    read a SNEP packet. Fragments are received straight into buf.
+    * @param    buf     the buffer to contain the packet, it needs 10 bytes more than the
+    *                   packet for the SNEP and PDU headers
+    * @param    len     lenght of the buffer, at most 32767
     * @param    timeout max time to wait, 0 means no timeout
     * @return   >=0     length of the packet 
     *           <0      failed
     */
-    int16_t read(uint8_t *buf, uint8_t len, uint16_t timeout = 0);
+    int16_t read(uint8_t *buf, uint16_t len, uint16_t timeout = 0);
 
 private:
 	LLCP llcp;
 	uint8_t *headerBuf;
 	uint8_t headerBufLen;
+
+	bool writeResponse(uint8_t response);
 };
 
 #endif // __SNEP_H__
@@ -5,15 +5,19 @@
 #define PN532_I2C_ADDRESS       (0x48 >> 1)
 
 
-PN532_I2C::PN532_I2C(TwoWire &wire)
+PN532_I2C::PN532_I2C(TwoWire &wire, int8_t irqPin)
 {
     _wire = &wire;
     command = 0;
+    _irqPin = irqPin;
 }
 
 void PN532_I2C::begin()
 {
     _wire->begin();
+    if (_irqPin >= 0) {
+        pinMode(_irqPin, INPUT);
+    }
 }
 
 void PN532_I2C::wakeup()
@@ -76,21 +80,17 @@ int8_t PN532_I2C::writeCommand(const uint8_t *header, uint8_t hlen, const uint8_
 
 int16_t PN532_I2C::readResponse(uint8_t buf[], uint8_t len, uint16_t timeout)
 {
-    uint16_t time = 0;
-
-    do {
-        if (_wire->requestFrom(PN532_I2C_ADDRESS, len + 2)) {
-            if (read() & 1) {  // check first byte --- status
-                break;         // PN532 is ready
-            }
-        }
-
-        delay(1);
-        time++;
-        if ((0 != timeout) && (time > timeout)) {
+    // Poll just the status byte (or the IRQ pin), a full read takes a few ms on the I2C bus
+    unsigned long start = millis();
+    while (!isReady()) {
+        if ((0 != timeout) && (millis() - start > timeout)) {
             return -1;
         }
-    } while (1); 
+    }
+
+    if (!_wire->requestFrom(PN532_I2C_ADDRESS, len + 2) || !(read() & 1)) {  // status, PN532 is ready
+        return PN532_INVALID_FRAME;
+    }
     
     if (0x00 != read()      ||       // PREAMBLE
             0x00 != read()  ||       // STARTCODE1
@@ -137,6 +137,15 @@ int16_t PN532_I2C::readResponse(uint8_t buf[], uint8_t len, uint16_t timeout)
     return length;
 }
 
+bool PN532_I2C::isReady()
+{
+    if (_irqPin >= 0) {
+        return LOW == digitalRead(_irqPin);     // IRQ is active low
+    }
+
+    return _wire->requestFrom(PN532_I2C_ADDRESS, 1) && (read() & 1);
+}
+
 int8_t PN532_I2C::readAckFrame()
 {
     const uint8_t PN532_ACK[] = {0, 0, 0xFF, 0, 0xFF, 0};
@@ -146,21 +155,18 @@ int8_t PN532_I2C::readAckFrame()
     DMSG(millis());
     DMSG('\n');
     
-    uint16_t time = 0;
-    do {
-        if (_wire->requestFrom(PN532_I2C_ADDRESS,  sizeof(PN532_ACK) + 1)) {
-            if (read() & 1) {  // check first byte --- status
-                break;         // PN532 is ready
-            }
-        }
-
-        delay(1);
-        time++;
-        if (time > PN532_ACK_WAIT_TIME) {
+    unsigned long start = millis();
+    while (!isReady()) {
+        if (millis() - start > PN532_ACK_WAIT_TIME) {
             DMSG("Time out when waiting for ACK\n");
             return PN532_TIMEOUT;
         }
-    } while (1); 
+    }
+
+    if (!_wire->requestFrom(PN532_I2C_ADDRESS,  sizeof(PN532_ACK) + 1) || !(read() & 1)) {  // status, PN532 is ready
+        DMSG("Invalid ACK\n");
+        return PN532_INVALID_ACK;
+    }
     
     DMSG("ready at : ");
     DMSG(millis());
@@ -7,16 +7,23 @@
 
 class PN532_I2C : public PN532Interface {
 public:
-    PN532_I2C(TwoWire &wire);
+    /**
+    * @param    wire    I2C bus of the PN532
+    * @param    irqPin  pin connected to the IRQ output of the PN532, or -1 to poll the
+    *                   status byte over I2C in isReady()
+    */
+    PN532_I2C(TwoWire &wire, int8_t irqPin = -1);
     
     void begin();
     void wakeup();
     virtual int8_t writeCommand(const uint8_t *header, uint8_t hlen, const uint8_t *body = 0, uint8_t blen = 0);
     int16_t readResponse(uint8_t buf[], uint8_t len, uint16_t timeout);
+    bool isReady();
     
 private:
     TwoWire* _wire;
     uint8_t command;
+    int8_t _irqPin;
     
     int8_t readAckFrame();
     
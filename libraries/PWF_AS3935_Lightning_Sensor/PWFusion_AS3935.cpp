@@ -46,11 +46,17 @@
 **************************************************************************/
 #include "PWFusion_AS3935.h"
 
+PWF_AS3935 *PWF_AS3935::_instance = NULL;
+
 PWF_AS3935::PWF_AS3935(int8_t CSx, int8_t IRQx, int8_t SIx)
 {
 	_cs  = CSx;
 	_si  = SIx;
 	_irq = IRQx;
+	_irq_pending = false;
+	_event_head = 0;
+	_event_count = 0;
+	_tune_cap = -1;
 	
 	// initalize the chip select pins
 	pinMode(_cs, OUTPUT);
@@ -62,6 +68,18 @@ PWF_AS3935::PWF_AS3935(int8_t CSx, int8_t IRQx, int8_t SIx)
 
 }
 
+void PWF_AS3935::_burst_read(uint8_t RegAdd, uint8_t *buf, uint8_t len)
+{
+	// the address increments after each byte read, as long as CS stays low
+	digitalWrite(_cs, LOW);
+	SPI.transfer((RegAdd & 0x3F) | 0x40);		// read command
+	for(uint8_t i = 0; i < len; i++)
+	{
+		buf[i] = SPI.transfer(0x00);
+	}
+	digitalWrite(_cs, HIGH);
+}
+
 uint8_t PWF_AS3935::_sing_reg_read(uint8_t RegAdd)
 {
 	digitalWrite(_cs, LOW);						// set pin low to start talking to IC
@@ -412,3 +430,152 @@ void PWF_AS3935::AS3935_ManualCal(uint8_t capacitance, uint8_t location, uint8_t
 }
 // a nice function would be to read the last 'x' strike data values.... 
 
+void PWF_AS3935::AS3935_AttachIRQ(uint8_t interrupt)
+{
+	_instance = this;
+	attachInterrupt(interrupt, _ISR, RISING);
+}
+
+void PWF_AS3935::_ISR(void)
+{
+	// no SPI here, the bus may be in use by the radio
+	if(0 <= _instance->_tune_cap)
+	{
+		_instance->_lco_count++;
+	}
+	else
+	{
+		_instance->_irq_time = millis();
+		_instance->_irq_pending = true;
+	}
+}
+
+void PWF_AS3935::AS3935_Poll(void)
+{
+	if(!_irq_pending)
+	{
+		return;
+	}
+	noInterrupts();
+	unsigned long irq_time = _irq_time;
+	interrupts();
+	if(millis() - irq_time < 2)
+	{
+		return;						// wait 2ms before reading (pg 22 of datasheet)
+	}
+	_irq_pending = false;
+
+	// registers 0x03 (interrupt), 0x04-0x06 (energy LSB, MSB, MMSB) and 0x07 (distance)
+	uint8_t regs[5];
+	_burst_read(0x03, regs, sizeof(regs));
+
+	AS3935_Event event;
+	uint8_t int_src = regs[0] & 0x0F;
+	if(0x08 == int_src)
+	{
+		event.type = 1;
+	}
+	else if(0x04 == int_src)
+	{
+		event.type = 2;
+	}
+	else if(0x01 == int_src)
+	{
+		event.type = 3;
+	}
+	else
+	{
+		return;						// interrupt result not expected
+	}
+	event.energy_raw = ((uint32_t)(regs[3] & 0x1F) << 16) | ((uint32_t)regs[2] << 8) | regs[1];
+	event.distance_km = regs[4] & 0x3F;
+	event.time = irq_time;
+
+	// a full queue drops the oldest event
+	if(AS3935_EVENT_QUEUE_SIZE == _event_count)
+	{
+		_event_head = (_event_head + 1) % AS3935_EVENT_QUEUE_SIZE;
+		_event_count--;
+	}
+	_events[(_event_head + _event_count) % AS3935_EVENT_QUEUE_SIZE] = event;
+	_event_count++;
+}
+
+uint8_t PWF_AS3935::AS3935_EventAvailable(void)
+{
+	AS3935_Poll();
+	return _event_count;
+}
+
+bool PWF_AS3935::AS3935_GetEvent(AS3935_Event &event)
+{
+	AS3935_Poll();
+	if(0 == _event_count)
+	{
+		return false;
+	}
+	event = _events[_event_head];
+	_event_head = (_event_head + 1) % AS3935_EVENT_QUEUE_SIZE;
+	_event_count--;
+	return true;
+}
+
+void PWF_AS3935::_tune_select(uint8_t cap)
+{
+	// reg 0x08: LCO on the IRQ pin (bit 7) and tuning capacitor (bits 3:0)
+	_sing_reg_write(0x08, 0x8F, 0x80 | cap);
+	noInterrupts();
+	_lco_count = 0;
+	_tune_cap = cap;
+	interrupts();
+	_tune_start = micros();
+}
+
+void PWF_AS3935::AS3935_TuneAntennaStart(void)
+{
+	// LCO_FDIV = 16 (reg 0x03, bits 7:6), keep the disturber mask (bit 5)
+	_sing_reg_write(0x03, 0xE0, _sing_reg_read(0x03) & 0x20);
+	_tune_best = 0;
+	_tune_best_err = 0xFFFFFFFFUL;
+	_tune_select(0);
+}
+
+int16_t PWF_AS3935::AS3935_TuneAntennaUpdate(void)
+{
+	if(0 > _tune_cap)
+	{
+		return (_tune_best << 3);
+	}
+	unsigned long elapsed = micros() - _tune_start;
+	if(elapsed < AS3935_TUNE_WINDOW)
+	{
+		return -1;
+	}
+
+	noInterrupts();
+	unsigned int count = _lco_count;
+	interrupts();
+
+	// LCO frequency = count * 16 / elapsed, error against 500kHz in Hz
+	unsigned long freq = (unsigned long)(count * 16.0 * 1000000.0 / elapsed);
+	unsigned long err = (freq > 500000UL) ? (freq - 500000UL) : (500000UL - freq);
+	if(err < _tune_best_err)
+	{
+		_tune_best_err = err;
+		_tune_best = _tune_cap;
+	}
+
+	if(15 > _tune_cap)
+	{
+		_tune_select(_tune_cap + 1);
+		return -1;
+	}
+
+	// done, stop showing the LCO and set the best capacitor
+	_tune_cap = -1;
+	_sing_reg_write(0x08, 0x8F, _tune_best);
+	Serial.print("antenna tuned to 8x");
+	Serial.println(_tune_best);
+	return (_tune_best << 3);
+}
+
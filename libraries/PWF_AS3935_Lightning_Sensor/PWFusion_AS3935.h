@@ -53,6 +53,22 @@
 #include "stdlib.h"
 #include <SPI.h>
 
+// Number of events AS3935_Poll() can queue until the sketch takes them
+#ifndef AS3935_EVENT_QUEUE_SIZE
+#define AS3935_EVENT_QUEUE_SIZE 4
+#endif
+
+// Measuring window per tuning capacitor of AS3935_TuneAntennaStart(), us
+#define AS3935_TUNE_WINDOW 100000UL
+
+struct AS3935_Event
+{
+	uint8_t type;				// as AS3935_GetInterruptSrc(): 1 = lightning, 2 = disturber, 3 = noise level too high
+	uint8_t distance_km;		// as AS3935_GetLightningDistKm(), lightning only
+	uint32_t energy_raw;		// as AS3935_GetStrikeEnergyRaw(), lightning only
+	unsigned long time;			// millis() of the interrupt
+};
+
 class PWF_AS3935
 {
  public:
@@ -80,9 +96,37 @@ class PWF_AS3935
 	void AS3935_SetSpikeRejection(uint8_t srej);
 	void AS3935_SetLCO_FDIV(uint8_t fdiv);
 	void AS3935_PrintAllRegs(void);
+
+	// Event queue. AS3935_AttachIRQ() attaches the IRQ pin (one sensor per sketch), then call
+	// AS3935_Poll() from loop(): 2ms after an interrupt it reads the interrupt, energy and
+	// distance registers in one SPI transfer and queues the event.
+	void AS3935_AttachIRQ(uint8_t interrupt);
+	void AS3935_Poll(void);
+	uint8_t AS3935_EventAvailable(void);
+	bool AS3935_GetEvent(AS3935_Event &event);
+
+	// Non-blocking antenna tuning, needs AS3935_AttachIRQ(). Measures the LCO for each of the 16
+	// tuning capacitors, AS3935_TuneAntennaUpdate() returns -1 while measuring, then the
+	// capacitance (pF) closest to 500kHz, which is set. Takes 16 * AS3935_TUNE_WINDOW.
+	void AS3935_TuneAntennaStart(void);
+	int16_t AS3935_TuneAntennaUpdate(void);
 	
  private:
 	int8_t _cs, _irq, _si;
+
+	static PWF_AS3935 *_instance;		// sensor of the attached IRQ
+	volatile bool _irq_pending;
+	volatile unsigned long _irq_time;
+	volatile unsigned int _lco_count;	// LCO edges while tuning
+	AS3935_Event _events[AS3935_EVENT_QUEUE_SIZE];
+	uint8_t _event_head, _event_count;
+	int8_t _tune_cap;					// capacitor being measured, -1 if not tuning
+	uint8_t _tune_best;
+	unsigned long _tune_best_err, _tune_start;
+
+	static void _ISR(void);
+	void _burst_read(uint8_t RegAdd, uint8_t *buf, uint8_t len);
+	void _tune_select(uint8_t cap);
 	uint8_t _sing_reg_read(uint8_t RegAdd);
 	void _sing_reg_write(uint8_t RegAdd, uint8_t DataMask, uint8_t RegData);
 	void _AS3935_Reset(void);
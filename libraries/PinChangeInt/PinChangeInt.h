@@ -56,6 +56,9 @@
 // #define NO_PIN_NUMBER       // to indicate that you don't need the arduinoPin
 // #define DISABLE_PCINT_MULTI_SERVICE // to limit the handler to servicing a single interrupt per invocation.
 // #define GET_PCINT_VERSION   // to enable the uint16_t getPCIintVersion () function.
+// #define PCINT_EVENT_QUEUE   // to only queue (pin, level, micros) in the interrupt; call PCintPort::dispatch()
+//                             // from loop() to run your functions, with PCintPort::eventTime holding micros().
+// #define PCINT_QUEUE_SIZE 16 // number of queued events, a power of 2 (PCINT_EVENT_QUEUE only).
 // The following is intended for testing purposes.  If defined, then a whole host of static variables can be read
 // in your interrupt subroutine.  It is not defined by default, and you DO NOT want to define this in
 // Production code!:
@@ -65,6 +68,7 @@
 /*
 	PinChangeInt.h
 	---- VERSIONS --- (NOTE TO SELF: Update the PCINT_VERSION define, below) -----------------
+Version 2.20 (beta) Wed Oct 14 09:12:40 CDT 2026
 Version 2.19 (beta) Tue Nov 20 07:33:37 CST 2012
 Version 2.17 (beta) Sat Nov 17 09:46:50 CST 2012
 Version 2.11 (beta) Mon Nov 12 09:33:06 CST 2012
@@ -93,7 +97,7 @@ Version 2.11 (beta) Mon Nov 12 09:33:06 CST 2012
 #ifndef PinChangeInt_h
 #define	PinChangeInt_h
 
-#define PCINT_VERSION 2190 // This number MUST agree with the version number, above.
+#define PCINT_VERSION 2200 // This number MUST agree with the version number, above.
 
 #include "stddef.h"
 
@@ -166,6 +170,19 @@ Version 2.11 (beta) Mon Nov 12 09:33:06 CST 2012
 
 typedef void (*PCIntvoidFuncPtr)(void);
 
+#ifdef PCINT_EVENT_QUEUE
+#ifndef PCINT_QUEUE_SIZE
+#define PCINT_QUEUE_SIZE 16
+#endif
+class PCintPort;
+typedef struct {
+	PCintPort*	port;
+	uint8_t		bit;
+	uint8_t		level;
+	unsigned long	time;
+} PCintEvent;
+#endif
+
 class PCintPort {
 public:
 	PCintPort(int index,int pcindex, volatile uint8_t& maskReg) :
@@ -173,8 +190,7 @@ public:
 	portPCMask(maskReg),
 	PCICRbit(1 << pcindex),
 	portRisingPins(0),
-	portFallingPins(0),
-	firstPin(NULL)
+	portFallingPins(0)
 #ifdef PINMODE
 	,intrCount(0)
 #endif
@@ -182,6 +198,7 @@ public:
 		#ifdef FLASH
 		ledsetup();
 		#endif
+		for (uint8_t i=0; i < 8; i++) pinFunc[i]=NULL;
 	}
 	volatile	uint8_t&		portInputReg;
 	static		int8_t attachInterrupt(uint8_t pin, PCIntvoidFuncPtr userFunc, int mode);
@@ -194,6 +211,11 @@ public:
 	#ifndef NO_PIN_STATE
 	static volatile	uint8_t	pinState;
 	#endif
+	#ifdef PCINT_EVENT_QUEUE
+	static		boolean	dispatch();
+	static		unsigned long	eventTime;
+	static volatile	uint8_t	overruns; // events lost to a full queue, saturates at 255
+	#endif
 	#ifdef PINMODE
 	static volatile uint8_t pinmode;
 	static volatile uint8_t s_portRisingPins;
@@ -215,26 +237,24 @@ public:
 	#endif
 
 protected:
-	class PCintPin {
-	public:
-		PCintPin() :
-		PCintFunc((PCIntvoidFuncPtr)NULL),
-		mode(0) {}
-		PCIntvoidFuncPtr PCintFunc;
-		uint8_t 	mode;
-		uint8_t		mask;
-		uint8_t arduinoPin;
-		PCintPin* next;
-	};
-	void 		enable(PCintPin* pin, PCIntvoidFuncPtr userFunc, uint8_t mode);
 	int8_t		addPin(uint8_t arduinoPin,PCIntvoidFuncPtr userFunc, uint8_t mode);
 	volatile	uint8_t&		portPCMask;
 	const		uint8_t			PCICRbit;
 	volatile	uint8_t			portRisingPins;
 	volatile	uint8_t			portFallingPins;
 	volatile uint8_t		lastPinView;
-	PCintPin*	firstPin;
-	PCintPin	thePin;
+	// Dispatch table indexed by the bit number of the pin in the port, so the
+	// interrupt goes straight from the changed bits to the user functions.
+	PCIntvoidFuncPtr	pinFunc[8];
+	#ifndef NO_PIN_NUMBER
+	uint8_t		pinNumber[8];
+	#endif
+	#ifdef PCINT_EVENT_QUEUE
+	// single producer (the interrupts), single consumer (dispatch()) ring
+	static volatile PCintEvent	s_queue[PCINT_QUEUE_SIZE];
+	static volatile uint8_t		s_queueHead;
+	static volatile uint8_t		s_queueTail;
+	#endif
 };
 
 #ifndef LIBCALL_PINCHANGEINT // LIBCALL_PINCHANGEINT ***********************************************
@@ -245,6 +265,13 @@ volatile uint8_t PCintPort::arduinoPin=0;
 #ifndef NO_PIN_STATE
 volatile uint8_t PCintPort::pinState=0;
 #endif
+#ifdef PCINT_EVENT_QUEUE
+unsigned long PCintPort::eventTime=0;
+volatile uint8_t PCintPort::overruns=0;
+volatile PCintEvent PCintPort::s_queue[PCINT_QUEUE_SIZE];
+volatile uint8_t PCintPort::s_queueHead=0;
+volatile uint8_t PCintPort::s_queueTail=0;
+#endif
 #ifdef PINMODE
 volatile uint8_t PCintPort::pinmode=0;
 volatile uint8_t PCintPort::s_portRisingPins=0;
@@ -364,57 +391,34 @@ static PCintPort *lookupPortNumToPort( int portNum ) {
 }
 
 
-void PCintPort::enable(PCintPin* p, PCIntvoidFuncPtr userFunc, uint8_t mode) {
-	// Enable the pin for interrupts by adding to the PCMSKx register.
-	// ...The final steps; at this point the interrupt is enabled on this pin.
-	p->mode=mode;
-	p->PCintFunc=userFunc;
-	portPCMask |= p->mask;
-	if ((p->mode == RISING) || (p->mode == CHANGE)) portRisingPins |= p->mask;
-	if ((p->mode == FALLING) || (p->mode == CHANGE)) portFallingPins |= p->mask;
-	PCICR |= PCICRbit;
-}
-
 int8_t PCintPort::addPin(uint8_t arduinoPin, PCIntvoidFuncPtr userFunc, uint8_t mode)
 {
-	PCintPin* tmp;
-
-	// Add to linked list, starting with firstPin. If pin already exists, just enable.
-	if (firstPin != NULL) {
-		tmp=firstPin;
-		do {
-			if (tmp->arduinoPin == arduinoPin) { enable(tmp, userFunc, mode); return(0); }
-			if (tmp->next == NULL) break;
-			tmp=tmp->next;
-		} while (true);
-	}
-
-	// Create pin p:  fill in the data. NOTE: MySensors only support one pin due to size constraints
-	// TODO: Figure out a better way to solve this without relying on new/malloc
-	PCintPin* p = &thePin; //PCintPin* p=new PCintPin;
-	if (p == NULL) return(-1);
-	p->arduinoPin=arduinoPin;
-	p->mode = mode;
-	p->next=NULL;
-	p->mask = digitalPinToBitMask(arduinoPin); // the mask
-
-	if (firstPin == NULL) firstPin=p;
-	else tmp->next=p;
+	uint8_t mask = digitalPinToBitMask(arduinoPin);
+	uint8_t bit = 0;
+	while (!(mask & (1 << bit))) bit++;
+	int8_t added = (pinFunc[bit] == NULL) ? 1 : 0;
 
 #ifdef DEBUG
 	Serial.print("addPin. pin given: "); Serial.print(arduinoPin, DEC);
-	int addr = (int) p;
-	Serial.print(" instance addr: "); Serial.println(addr, HEX);
-	Serial.print("userFunc addr: "); Serial.println((int)p->PCintFunc, HEX);
+	Serial.print(" bit: "); Serial.println(bit, DEC);
+	Serial.print("userFunc addr: "); Serial.println((int)userFunc, HEX);
 #endif
 
-	enable(p, userFunc, mode);
-#ifdef DEBUG
-	Serial.print("addPin. pin given: "); Serial.print(arduinoPin, DEC), Serial.print (" pin stored: ");
-	int addr = (int) p;
-	Serial.print(" instance addr: "); Serial.println(addr, HEX);
-#endif
-	return(1);
+	// Enable the pin for interrupts by adding to the PCMSKx register.
+	// ...The final steps; at this point the interrupt is enabled on this pin.
+	uint8_t oldSREG = SREG;
+	cli();
+	pinFunc[bit]=userFunc;
+	#ifndef NO_PIN_NUMBER
+	pinNumber[bit]=arduinoPin;
+	#endif
+	portRisingPins &= ~mask; portFallingPins &= ~mask;
+	if ((mode == RISING) || (mode == CHANGE)) portRisingPins |= mask;
+	if ((mode == FALLING) || (mode == CHANGE)) portFallingPins |= mask;
+	portPCMask |= mask;
+	PCICR |= PCICRbit;
+	SREG = oldSREG;
+	return(added);
 }
 
 /*
@@ -427,6 +431,7 @@ int8_t PCintPort::attachInterrupt(uint8_t arduinoPin, PCIntvoidFuncPtr userFunc,
 	if ((portNum == NOT_A_PORT) || (userFunc == NULL)) return(-1);
 
 	port=lookupPortNumToPort(portNum);
+	if (port == NULL) return(-1);
 	// Added by GreyGnome... must set the initial value of lastPinView for it to be correct on the 1st interrupt.
 	// ...but even then, how do you define "correct"?  Ultimately, the user must specify (not provisioned for yet).
 	port->lastPinView=port->portInputReg;
@@ -441,7 +446,6 @@ int8_t PCintPort::attachInterrupt(uint8_t arduinoPin, PCIntvoidFuncPtr userFunc,
 void PCintPort::detachInterrupt(uint8_t arduinoPin)
 {
 	PCintPort *port;
-	PCintPin* current;
 	uint8_t mask;
 #ifdef DEBUG
 	Serial.print("detachInterrupt: "); Serial.println(arduinoPin, DEC);
@@ -449,33 +453,19 @@ void PCintPort::detachInterrupt(uint8_t arduinoPin)
 	uint8_t portNum = digitalPinToPort(arduinoPin);
 	if (portNum == NOT_A_PORT) return;
 	port=lookupPortNumToPort(portNum);
+	if (port == NULL) return;
 	mask=digitalPinToBitMask(arduinoPin);
-	current=port->firstPin;
-	//PCintPin* prev=NULL;
-	while (current) {
-		if (current->mask == mask) { // found the target
-			uint8_t oldSREG = SREG;
-			cli(); // disable interrupts
-			port->portPCMask &= ~mask; // disable the mask entry.
-			if (port->portPCMask == 0) PCICR &= ~(port->PCICRbit);
-			port->portRisingPins &= ~current->mask; port->portFallingPins &= ~current->mask;
-			// Link the previous' next to the found next. Then remove the found.
-			//if (prev != NULL) prev->next=current->next; // linked list skips over current.
-			//else firstPin=current->next; // at the first pin; save the new first pin
-			SREG = oldSREG; // Restore register; reenables interrupts
-			return;
-		}
-		//prev=current;
-		current=current->next;
-	}
+	uint8_t oldSREG = SREG;
+	cli(); // disable interrupts
+	port->portPCMask &= ~mask; // disable the mask entry.
+	if (port->portPCMask == 0) PCICR &= ~(port->PCICRbit);
+	port->portRisingPins &= ~mask; port->portFallingPins &= ~mask;
+	SREG = oldSREG; // Restore register; reenables interrupts
 }
 
 // common code for isr handler. "port" is the PCINT number.
 // there isn't really a good way to back-map ports and masks to pins.
 void PCintPort::PCint() {
-	uint8_t thisChangedPin; //MIKE
-	(void)thisChangedPin;
-	
 	#ifdef FLASH
 	if (*led_port & led_mask) *led_port&=not_led_mask;
 	else *led_port|=led_mask;
@@ -484,6 +474,9 @@ void PCintPort::PCint() {
 	uint8_t pcifr;
 	while (true) {
 	#endif
+		#ifdef PCINT_EVENT_QUEUE
+		unsigned long now=micros();
+		#endif
 		// get the pin states for the indicated port.
 		#ifdef PINMODE
 		PCintPort::s_lastPinView=lastPinView;
@@ -509,28 +502,47 @@ void PCintPort::PCint() {
 		#endif
 		lastPinView = PCintPort::curr;
 
-		PCintPin* p = firstPin;
-		while (p) {
-			// Trigger interrupt if the bit is high and it's set to trigger on mode RISING or CHANGE
-			// Trigger interrupt if the bit is low and it's set to trigger on mode FALLING or CHANGE
-			thisChangedPin=p->mask & changedPins; // PinChangeIntSpeedTest makes this 3673... weird.  But GOOD!!!
-			if (p->mask & changedPins) {
+		// Walk the changed bits from bit 0 up; at most 8 steps however many
+		// pins are attached, and none for pins that did not trigger.
+		uint8_t bit=0;
+		uint8_t mask=1;
+		while (changedPins) {
+			// changedPins only holds pins that rose with mode RISING or CHANGE,
+			// or fell with mode FALLING or CHANGE
+			if (changedPins & mask) {
+				changedPins &= ~mask;
+				#ifdef PCINT_EVENT_QUEUE
+				uint8_t next=(s_queueHead + 1) & (PCINT_QUEUE_SIZE - 1);
+				if (next == s_queueTail) {
+					if (overruns < 255) overruns++;
+				} else {
+					volatile PCintEvent* e=&s_queue[s_queueHead];
+					e->port=this;
+					e->bit=bit;
+					e->level=PCintPort::curr & mask ? HIGH : LOW;
+					e->time=now;
+					s_queueHead=next; // publish the event only once it is complete
+				}
+				#else
 				#ifndef NO_PIN_STATE
-				PCintPort::pinState=PCintPort::curr & p->mask ? HIGH : LOW;
+				PCintPort::pinState=PCintPort::curr & mask ? HIGH : LOW;
 				#endif
 				#ifndef NO_PIN_NUMBER
-				PCintPort::arduinoPin=p->arduinoPin;
+				PCintPort::arduinoPin=pinNumber[bit];
 				#endif
 				#ifdef PINMODE
-				PCintPort::pinmode=p->mode;
+				PCintPort::pinmode=(portRisingPins & portFallingPins & mask) ? CHANGE :
+								   ((portRisingPins & mask) ? RISING : FALLING);
 				PCintPort::s_portRisingPins=portRisingPins;
 				PCintPort::s_portFallingPins=portFallingPins;
-				PCintPort::s_pmask=p->mask;
-				PCintPort::s_changedPins=changedPins;
+				PCintPort::s_pmask=mask;
+				PCintPort::s_changedPins=changedPins | mask;
+				#endif
+				pinFunc[bit]();
 				#endif
-				p->PCintFunc();
 			}
-			p=p->next;
+			bit++;
+			mask <<= 1;
 		}
 	#ifndef DISABLE_PCINT_MULTI_SERVICE
 		pcifr = PCIFR & PCICRbit;
@@ -545,6 +557,30 @@ void PCintPort::PCint() {
 	#endif
 }
 
+#ifdef PCINT_EVENT_QUEUE
+// Run the user functions for the queued events, oldest first.  Returns true if there were any.
+boolean PCintPort::dispatch() {
+	boolean dispatched=false;
+	while (s_queueTail != s_queueHead) {
+		volatile PCintEvent* e=&s_queue[s_queueTail];
+		PCintPort* port=e->port;
+		uint8_t bit=e->bit;
+		#ifndef NO_PIN_STATE
+		PCintPort::pinState=e->level;
+		#endif
+		#ifndef NO_PIN_NUMBER
+		PCintPort::arduinoPin=port->pinNumber[bit];
+		#endif
+		PCintPort::eventTime=e->time;
+		s_queueTail=(s_queueTail + 1) & (PCINT_QUEUE_SIZE - 1);
+		// the pin may have been detached since, its function is still valid
+		port->pinFunc[bit]();
+		dispatched=true;
+	}
+	return dispatched;
+}
+#endif
+
 #ifndef NO_PORTA_PINCHANGES
 ISR(PCINT0_vect) {
 	#ifdef PINMODE
@@ -111,19 +111,20 @@ boolean PubSubClient::connect(char *id, char *user, char *pass, char* willTopic,
             }
          }
          
+         readState = MQTT_READ_HEADER;
          write(MQTTCONNECT,buffer,length-5);
          
          lastInActivity = lastOutActivity = millis();
          
-         while (!_client->available()) {
+         uint8_t llen;
+         uint16_t len;
+         while ((len = readPacket(&llen)) == 0) {
             unsigned long t = millis();
             if (t-lastInActivity > MQTT_KEEPALIVE*1000UL) {
                _client->stop();
                return false;
             }
          }
-         uint8_t llen;
-         uint16_t len = readPacket(&llen);
          
          if (len == 4 && buffer[3] == 0) {
             lastInActivity = millis();
@@ -136,59 +137,61 @@ boolean PubSubClient::connect(char *id, char *user, char *pass, char* willTopic,
    return false;
 }
 
-uint8_t PubSubClient::readByte() {
-   while(!_client->available()) {}
-   return _client->read();
-}
-
 uint16_t PubSubClient::readPacket(uint8_t* lengthLength) {
-   uint16_t len = 0;
-   buffer[len++] = readByte();
-   bool isPublish = (buffer[0]&0xF0) == MQTTPUBLISH;
-   uint32_t multiplier = 1;
-   uint16_t length = 0;
-   uint8_t digit = 0;
-   uint16_t skip = 0;
-   uint8_t start = 0;
-   
-   do {
-      digit = readByte();
-      buffer[len++] = digit;
-      length += (digit & 127) * multiplier;
-      multiplier *= 128;
-   } while ((digit & 128) != 0);
-   *lengthLength = len-1;
-
-   if (isPublish) {
-      // Read in topic length to calculate bytes to skip over for Stream writing
-      buffer[len++] = readByte();
-      buffer[len++] = readByte();
-      skip = (buffer[*lengthLength+1]<<8)+buffer[*lengthLength+2];
-      start = 2;
-      if (buffer[0]&MQTTQOS1) {
-         // skip message id
-         skip += 2;
+   // Only takes what the client already has, a partly received packet is
+   // kept in buffer and finished on a later call
+   while (_client->available()) {
+      uint8_t digit = _client->read();
+      if (readState == MQTT_READ_HEADER) {
+         readLen = 0;
+         buffer[readLen++] = digit;
+         readLength = 0;
+         readMultiplier = 1;
+         readCount = 0;
+         readSkip = 0;
+         readState = MQTT_READ_LENGTH;
+         continue;
       }
-   }
-
-   for (uint16_t i = start;i<length;i++) {
-      digit = readByte();
-      if (this->stream) {
-         if (isPublish && len-*lengthLength-2>skip) {
-             this->stream->write(digit);
+      bool isPublish = (buffer[0]&0xF0) == MQTTPUBLISH;
+      if (readState == MQTT_READ_LENGTH) {
+         buffer[readLen++] = digit;
+         readLength += (digit & 127) * readMultiplier;
+         readMultiplier *= 128;
+         if ((digit & 128) != 0) {
+            continue;
+         }
+         readLengthLength = readLen-1;
+         readState = MQTT_READ_BODY;
+      } else {
+         if (this->stream) {
+            if (isPublish && readCount >= 2 && readLen-readLengthLength-2>readSkip) {
+               this->stream->write(digit);
+            }
+         }
+         if (readLen < MQTT_MAX_PACKET_SIZE) {
+            buffer[readLen] = digit;
+         }
+         readLen++;
+         readCount++;
+         if (isPublish && readCount == 2) {
+            // Topic length read, calculate bytes to skip over for Stream writing
+            readSkip = (buffer[readLengthLength+1]<<8)+buffer[readLengthLength+2];
+            if (buffer[0]&MQTTQOS1) {
+               // skip message id
+               readSkip += 2;
+            }
          }
       }
-      if (len < MQTT_MAX_PACKET_SIZE) {
-         buffer[len] = digit;
+      if (readCount == readLength) {
+         readState = MQTT_READ_HEADER;
+         *lengthLength = readLengthLength;
+         if (!this->stream && readLen > MQTT_MAX_PACKET_SIZE) {
+            return 0; // This will cause the packet to be ignored.
+         }
+         return readLen;
       }
-      len++;
-   }
-   
-   if (!this->stream && len > MQTT_MAX_PACKET_SIZE) {
-       len = 0; // This will cause the packet to be ignored.
    }
-
-   return len;
+   return 0;
 }
 
 boolean PubSubClient::loop() {
@@ -18,6 +18,13 @@
 #define MQTT_KEEPALIVE 15
 
 #define MQTTPROTOCOLVERSION 3
+
+// readPacket() states, a packet is read over as many loop() calls as its
+// bytes take to arrive
+#define MQTT_READ_HEADER 0
+#define MQTT_READ_LENGTH 1
+#define MQTT_READ_BODY   2
+
 #define MQTTCONNECT     1 << 4  // Client request to connect to Server
 #define MQTTCONNACK     2 << 4  // Connect Acknowledgment
 #define MQTTPUBLISH     3 << 4  // Publish message
@@ -48,7 +55,13 @@ private:
    bool pingOutstanding;
    void (*callback)(char*,uint8_t*,unsigned int);
    uint16_t readPacket(uint8_t*);
-   uint8_t readByte();
+   uint8_t readState;
+   uint8_t readLengthLength;
+   uint16_t readLen;
+   uint16_t readLength;
+   uint16_t readCount;
+   uint16_t readSkip;
+   uint32_t readMultiplier;
    boolean write(uint8_t header, uint8_t* buf, uint16_t length);
    uint16_t writeString(char* string, uint8_t* buf, uint16_t pos);
    uint8_t *ip;
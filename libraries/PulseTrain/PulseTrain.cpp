@@ -0,0 +1,128 @@
+/*
+ * PulseTrain library, interrupt driven transmission of pulse trains for 433MHz transmitters.
+ * See PulseTrain.h for details.
+ *
+ * License: GPLv3.
+ */
+
+#include "PulseTrain.h"
+
+#if defined(__AVR__) && defined(OCR1A)
+	#define PULSETRAIN_TIMER1
+	// Timer1 runs at F_CPU / 8
+	#define PULSETRAIN_TICKS(us) ((unsigned long)(us) * (F_CPU / 1000000UL) / 8)
+#else
+	#define PULSETRAIN_TICKS(us) (us)
+#endif
+
+byte PulseTrain::_pin;
+#if defined(__AVR__)
+volatile uint8_t *PulseTrain::_pinOutput;
+uint8_t PulseTrain::_pinBit;
+#endif
+const byte *PulseTrain::_symbols;
+unsigned int PulseTrain::_count;
+volatile unsigned int PulseTrain::_position;
+volatile byte PulseTrain::_repeats;
+volatile boolean PulseTrain::_busy = false;
+unsigned int PulseTrain::_ticks[4];
+
+void PulseTrain::begin(byte pin) {
+	_pin = pin;
+#if defined(__AVR__)
+	_pinOutput = portOutputRegister(digitalPinToPort(_pin));
+	_pinBit = digitalPinToBitMask(_pin);
+#endif
+	pinMode(_pin, OUTPUT);
+	digitalWrite(_pin, LOW);
+}
+
+void PulseTrain::_writePin(uint8_t level) {
+#if defined(__AVR__)
+	// Only called with interrupts disabled (timer interrupt, or before it is enabled)
+	if (level) {
+		*_pinOutput |= _pinBit;
+	} else {
+		*_pinOutput &= ~_pinBit;
+	}
+#else
+	digitalWrite(_pin, level);
+#endif
+}
+
+boolean PulseTrain::send(const byte *symbols, unsigned int count, const unsigned int *durations, byte repeats) {
+	if (_busy) {
+		return false;
+	}
+	for (byte i = 0; i < 4; i++) {
+		unsigned long ticks = PULSETRAIN_TICKS(durations[i]);
+		_ticks[i] = ticks > 0xFFFF ? 0xFFFF : ticks;
+	}
+	_symbols = symbols;
+	_count = count;
+	_position = 0;
+	_repeats = repeats;
+	_busy = true;
+
+#if defined(PULSETRAIN_TIMER1)
+	uint8_t oldSREG = SREG;
+	cli();
+	// Normal mode, prescaler 8. Each pulse moves the compare point on, so interrupt latency
+	// doesn't add up over the train.
+	TCCR1A = 0;
+	TCCR1B = _BV(CS11);
+	OCR1A = TCNT1 + 16;
+	TIFR1 = _BV(OCF1A);
+	TIMSK1 |= _BV(OCIE1A);
+	SREG = oldSREG;
+#else
+	unsigned int ticks;
+	while ((ticks = nextPulse()) != 0) {
+		delayMicroseconds(ticks);
+	}
+#endif
+	return true;
+}
+
+boolean PulseTrain::isBusy() {
+	return _busy;
+}
+
+void PulseTrain::cancel() {
+	noInterrupts();
+	_position = _count;
+	_repeats = 0;
+	interrupts();
+}
+
+unsigned int PulseTrain::nextPulse() {
+	for (;;) {
+		if (_position >= _count) {
+			if (_repeats == 0) {
+				_writePin(LOW);
+#if defined(PULSETRAIN_TIMER1)
+				TIMSK1 &= ~_BV(OCIE1A);
+#endif
+				_busy = false;
+				return 0;
+			}
+			_repeats--;
+			_position = 0;
+		}
+		unsigned int position = _position++;
+		unsigned int ticks = _ticks[_symbolAt(position)];
+		if (ticks) {
+			_writePin(position & 1 ? LOW : HIGH);
+#if defined(PULSETRAIN_TIMER1)
+			OCR1A += ticks;
+#endif
+			return ticks;
+		}
+	}
+}
+
+#if defined(PULSETRAIN_TIMER1)
+ISR(TIMER1_COMPA_vect) {
+	(void)PulseTrain::nextPulse();
+}
+#endif
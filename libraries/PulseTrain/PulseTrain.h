@@ -0,0 +1,93 @@
+/*
+ * PulseTrain library, interrupt driven transmission of pulse trains for 433MHz transmitters.
+ *
+ * License: GPLv3.
+ */
+
+#ifndef PulseTrain_h
+#define PulseTrain_h
+
+#include <Arduino.h>
+
+/**
+ * Number of bytes needed for the symbols of count pulses.
+ */
+#define PULSETRAIN_BYTES(count) (((count) + 3) / 4)
+
+/**
+ * PulseTrain sends a pulse train on a transmitter pin from a timer interrupt, so send() returns
+ * right away and the sketch keeps running while e.g. a KaKu command is repeated for 300ms.
+ *
+ * A pulse train is a list of 2-bit symbols, four per byte with the first pulse in the lowest two
+ * bits. Pulses alternate between HIGH and LOW, starting with HIGH; a pulse with symbol n lasts
+ * durations[n] microseconds. A duration of 0 skips the pulse, so two pulses of the same level can
+ * follow each other. The transmitters of RemoteSwitch, NewRemoteSwitch and RemoteSensor encode
+ * their telegrams in this form, see their encode...() methods.
+ *
+ * On AVR, Timer1 is used (output compare A; the timer runs with prescaler 8 during a
+ * transmission). This conflicts with Servo and PWM on the Timer1 pins, and limits a pulse to
+ * 65535 timer ticks, i.e. 32ms at 16MHz. On other architectures send() transmits before it
+ * returns.
+ *
+ * This is a pure static class; one transmission at a time.
+ */
+class PulseTrain {
+	public:
+		/**
+		 * Sets up the transmitter pin (OUTPUT, LOW).
+		 *
+		 * @param pin Output pin on Arduino to which the transmitter is connected
+		 */
+		static void begin(byte pin);
+
+		/**
+		 * Starts sending a pulse train. The symbols are read while sending, so they must not
+		 * change until isBusy() returns false; the durations are copied. The pin is LOW when done.
+		 *
+		 * @param symbols	Pulse symbols, see class description
+		 * @param count		Number of pulses. Must be even if repeats > 0, so each repeat starts HIGH.
+		 * @param durations	Duration in microseconds of the 4 symbols
+		 * @param repeats	Number of times the train is sent again after the first time
+		 * @return false if a transmission is still running, nothing is sent then
+		 */
+		static boolean send(const byte *symbols, unsigned int count, const unsigned int *durations, byte repeats = 0);
+
+		/**
+		 * @return true while a pulse train is being sent
+		 */
+		static boolean isBusy();
+
+		/**
+		 * Stops the current transmission at the next pulse, the pin goes LOW.
+		 */
+		static void cancel();
+
+		/**
+		 * For internal use: ends the current pulse and starts the next one. Called by the timer
+		 * interrupt.
+		 *
+		 * @return Duration of the started pulse in timer ticks, 0 when the train is done
+		 */
+		static unsigned int nextPulse();
+
+	private:
+		static byte _pin;
+#if defined(__AVR__)
+		static volatile uint8_t *_pinOutput;	// Output register of _pin
+		static uint8_t _pinBit;					// Bit of _pin in _pinOutput
+#endif
+		static const byte *_symbols;
+		static unsigned int _count;
+		static volatile unsigned int _position;	// Index of the next pulse
+		static volatile byte _repeats;			// Repeats still to be sent
+		static volatile boolean _busy;
+		static unsigned int _ticks[4];			// Symbol durations in timer ticks (us on non AVR)
+
+		static inline byte _symbolAt(unsigned int i) {
+			return (_symbols[i >> 2] >> ((i & 3) << 1)) & 3;
+		}
+
+		static void _writePin(uint8_t level);
+};
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * Demo for PulseTrain, switching a "new style" remote switch without blocking the sketch.
+ *
+ * Connect the transmitter to digital pin 11, and a led to pin 13.
+ *
+ * Every 5 seconds unit 2 is toggled. PulseTrain repeats the telegram from the timer
+ * interrupt, meanwhile loop() keeps blinking the led.
+ *
+ * NOTE: to use this example, "learn" address 123 in the receiver first, see the
+ * NewRemoteSwitch examples.
+ */
+
+#include <NewRemoteTransmitter.h>
+#include <PulseTrain.h>
+
+// Create a transmitter on address 123, using digital pin 11 to transmit,
+// with a period duration of 260ms (default), repeating the transmitted
+// code 2^3=8 times.
+NewRemoteTransmitter transmitter(123, 11, 260, 3);
+
+// Symbols are read while sending, so they must stay valid until PulseTrain is done
+byte symbols[NEW_REMOTE_PULSE_BYTES];
+unsigned int durations[4];
+
+boolean unitOn = false;
+unsigned long lastSwitch = 0;
+
+void setup() {
+  PulseTrain::begin(11);
+  pinMode(13, OUTPUT);
+}
+
+void loop() {
+  if (millis() - lastSwitch >= 5000 && !PulseTrain::isBusy()) {
+    lastSwitch = millis();
+    unitOn = !unitOn;
+
+    byte count = transmitter.encodeUnit(2, unitOn, symbols, durations);
+    PulseTrain::send(symbols, count, durations, transmitter.getRepeats());
+  }
+
+  // Not delayed by the transmission
+  digitalWrite(13, (millis() / 250) & 1);
+}
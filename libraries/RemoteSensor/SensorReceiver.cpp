@@ -34,7 +34,11 @@ void SensorReceiver::init(int8_t interrupt, SensorReceiverCallback callbackIn) {
   }  
 }
 
-void SensorReceiver::interruptHandler() {	
+void SensorReceiver::interruptHandler() {
+	handleEdge(micros());
+}
+
+void SensorReceiver::handleEdge(unsigned long currentTime) {
 	if (!enabled) {
 		return;
 	}
@@ -54,7 +58,6 @@ void SensorReceiver::interruptHandler() {
 	*/
 	
 	static byte halfBitCounter = 255;
-	unsigned long currentTime=micros();
 	duration=currentTime-lastChange; // Duration = Time between edges
 
 	lastChange=currentTime;
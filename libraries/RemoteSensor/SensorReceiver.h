@@ -78,6 +78,12 @@ class SensorReceiver {
 		 * with interrupt <0, you have to call interruptHandler() yourself. (Or use InterruptChain)
 		 */
 		static void interruptHandler();
+
+		/**
+		 * Same as interruptHandler(), for an edge that happened at edgeTime (micros()). Use this
+		 * when edges are queued and handled later, e.g. with InterruptChain::setDeferred().
+		 */
+		static void handleEdge(unsigned long edgeTime);
      
 	private:
 		/**
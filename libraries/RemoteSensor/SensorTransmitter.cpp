@@ -127,6 +127,87 @@ void SensorTransmitter::sendPackage(byte transmitterPin, byte *data) {
 	}
 }
 
+// Pulse symbols: half a bit, a whole bit (two halves of the same level), the pause between
+// packages and nothing (to continue the same level)
+#define SYMBOL_HALF 0
+#define SYMBOL_WHOLE 1
+#define SYMBOL_PAUSE 2
+#define SYMBOL_NONE 3
+
+// Collects Manchester half bits into pulses of alternating level
+struct PulseEncoder {
+	byte *symbols;
+	unsigned int count;
+	byte level;		// Level of the half bits collected
+	byte halves;	// Number of half bits collected
+
+	void add(byte symbol) {
+		if ((count & 3) == 0) {
+			symbols[count >> 2] = 0;
+		}
+		symbols[count >> 2] |= symbol << ((count & 3) << 1);
+		count++;
+	}
+
+	// Starts a pulse of given level, pulses with an even index are HIGH
+	void startPulse(byte pulseLevel) {
+		if ((count & 1 ? LOW : HIGH) != pulseLevel) {
+			add(SYMBOL_NONE);
+		}
+	}
+
+	void flush() {
+		if (halves) {
+			startPulse(level);
+			add(halves == 1 ? SYMBOL_HALF : SYMBOL_WHOLE);
+			halves = 0;
+		}
+	}
+
+	void halfBit(byte halfLevel) {
+		if (halves && halfLevel != level) {
+			flush();
+		}
+		level = halfLevel;
+		halves++;
+	}
+
+	void pause() {
+		flush();
+		startPulse(LOW);
+		add(SYMBOL_PAUSE);
+	}
+};
+
+unsigned int SensorTransmitter::encodePackage(byte *data, byte *symbols, unsigned int *durations) {
+	durations[SYMBOL_HALF] = 500;
+	durations[SYMBOL_WHOLE] = 1000;
+	durations[SYMBOL_PAUSE] = 30000;
+	durations[SYMBOL_NONE] = 0;
+
+	PulseEncoder encoder = { symbols, 0, LOW, 0 };
+	byte buffer[14], temp, count;
+	for (temp=0x5e; temp>0x40; temp+=0x40) { // Same 3 packages as sendPackage()
+		memcpy(buffer, data,  ((data[2] >> 1) & 0x1f) + 1);
+		buffer[3] = temp;
+		count = encryptAndAddCheck(buffer);
+
+		for (byte i = 0; i < count; i++) {
+			// Start-bit 0, then 8 bits LSB first, each as the bit followed by its complement
+			encoder.halfBit(LOW);
+			encoder.halfBit(HIGH);
+			byte b = buffer[i];
+			for (byte j = 0; j < 8; j++) {
+				encoder.halfBit(b & 1 ? HIGH : LOW);
+				encoder.halfBit(b & 1 ? LOW : HIGH);
+				b >>= 1;
+			}
+		}
+		encoder.pause();
+	}
+	return encoder.count;
+}
+
 
 /************************************
  * Thermo / Hygro sensor transmitter
@@ -138,7 +219,17 @@ ThermoHygroTransmitter::ThermoHygroTransmitter(byte transmitterPin,  byte random
 
 void ThermoHygroTransmitter::sendTempHumi(int temperature, byte humidity) {
 	byte buffer[10];
-	
+	_fillTempHumi(buffer, temperature, humidity);
+	sendPackage(_transmitterPin, buffer);
+}
+
+unsigned int ThermoHygroTransmitter::encodeTempHumi(int temperature, byte humidity, byte *symbols, unsigned int *durations) {
+	byte buffer[10];
+	_fillTempHumi(buffer, temperature, humidity);
+	return encodePackage(buffer, symbols, durations);
+}
+
+void ThermoHygroTransmitter::_fillTempHumi(byte *buffer, int temperature, byte humidity) {
 	// Note: temperature is 10x the actual temperature! So, 23.5 degrees is passed as 235.
 	
 	buffer[0] = 0x75; 		/* Header byte */
@@ -160,7 +251,5 @@ void ThermoHygroTransmitter::sendTempHumi(int temperature, byte humidity) {
 	buffer[6] = ((humidity / 10) << 4) | (humidity % 10); // BCD encoded
 	
 	buffer[7]=0xff; 		/* Comfort flag */
-	
-	sendPackage(_transmitterPin, buffer);
 }
 
@@ -17,6 +17,11 @@
 
 #include <Arduino.h>
 
+// Bytes needed for the pulse symbols of the largest (14 byte) package sent 3 times, see SensorTransmitter::encodePackage()
+#define SENSOR_PULSE_BYTES 192
+// Bytes needed for the pulse symbols of ThermoHygroTransmitter::encodeTempHumi()
+#define THERMO_HYGRO_PULSE_BYTES 138
+
 /**
  * SensorTransmitter provides a generic class to simulate Cresta weather sensors, for use
  * with Cresta weather stations.
@@ -57,6 +62,22 @@ class SensorTransmitter {
 		 * @param data Pointer to data to transmit
 		 */
 		static void sendPackage(byte transmitterPin, byte *data);
+
+		/**
+		 * Encodes what sendPackage() sends (all 3 transmissions) as pulse symbols, for sending
+		 * from an interrupt with PulseTrain. Pulses alternate between HIGH and LOW, starting HIGH,
+		 * 2 bits per pulse and 4 pulses per byte, first pulse in the lowest bits. Symbol n lasts
+		 * durations[n] microseconds; a pulse of 0 microseconds lets two pulses of the same level
+		 * follow each other.
+		 *
+		 * Note that this is a static method.
+		 *
+		 * @param data Pointer to data to transmit
+		 * @param symbols Buffer of SENSOR_PULSE_BYTES bytes for the symbols (less for smaller packages)
+		 * @param durations Buffer of 4 durations
+		 * @return The number of pulses
+		 */
+		static unsigned int encodePackage(byte *data, byte *symbols, unsigned int *durations);
 	
 	protected:
 		byte _transmitterPin;
@@ -102,8 +123,22 @@ class ThermoHygroTransmitter : public SensorTransmitter {
 		 * @param humidty Humidity in percentage-points REL. Thus, for 34% REH humidity should be 34.
 		 */
 		void sendTempHumi(int temperature, byte humidity);
+
+		/**
+		 * Encodes what sendTempHumi() sends as pulse symbols, see SensorTransmitter::encodePackage().
+		 *
+		 * @param symbols Buffer of THERMO_HYGRO_PULSE_BYTES bytes for the symbols
+		 * @param durations Buffer of 4 durations
+		 * @return The number of pulses
+		 */
+		unsigned int encodeTempHumi(int temperature, byte humidity, byte *symbols, unsigned int *durations);
 	
 	private:
+		/**
+		 * Fills the 8 data bytes of a thermo / hygro package
+		 */
+		void _fillTempHumi(byte *buffer, int temperature, byte humidity);
+
 		byte _channel; // Note: internally, the channels for the thermo/hygro-sensor are mapped as follow:
 							// 1=>1, 2=>2, 3=>3, 4=>5, 5=>6.
 							// This because interally the rain sensor, UV sensor and anemometer are on channel 4.
@@ -18,6 +18,8 @@ byte RemoteReceiver::_minRepeats;
 RemoteReceiverCallBack RemoteReceiver::_callback;
 boolean RemoteReceiver::_inCallback = false;
 boolean RemoteReceiver::_enabled = false;
+unsigned long RemoteReceiver::_dedupWindow = 0;
+RemoteReceiver::DedupEntry RemoteReceiver::_dedup[REMOTE_RECEIVER_DEDUP_SIZE];
 
 void RemoteReceiver::init(int8_t interrupt, byte minRepeats, RemoteReceiverCallBack callback) {
 	_interrupt = interrupt;
@@ -46,7 +48,41 @@ void RemoteReceiver::deinit() {
 	}
 }
 
+void RemoteReceiver::setDedupWindow(unsigned int window) {
+	_dedupWindow = window * 1000UL;
+	memset(_dedup, 0, sizeof(_dedup));
+}
+
+boolean RemoteReceiver::_isDuplicate(unsigned long code, unsigned long edgeTime) {
+	if (_dedupWindow == 0) {
+		return false;
+	}
+
+	// Find code, or else an unused or the least recently received entry to replace
+	byte oldest = 0;
+	unsigned long oldestAge = 0;
+	for (byte i = 0; i < REMOTE_RECEIVER_DEDUP_SIZE; i++) {
+		unsigned long age = _dedup[i].time != 0 ? edgeTime - _dedup[i].time : 0xFFFFFFFFUL;
+		if (_dedup[i].time != 0 && _dedup[i].code == code) {
+			_dedup[i].time = edgeTime | 1; // 0 marks an unused entry
+			return age < _dedupWindow;
+		}
+		if (age >= oldestAge) {
+			oldest = i;
+			oldestAge = age;
+		}
+	}
+
+	_dedup[oldest].code = code;
+	_dedup[oldest].time = edgeTime | 1;
+	return false;
+}
+
 void RemoteReceiver::interruptHandler() {
+	handleEdge(micros());
+}
+
+void RemoteReceiver::handleEdge(unsigned long edgeTime) {
 	if (!_enabled) {
 		return;
 	}
@@ -62,7 +98,7 @@ void RemoteReceiver::interruptHandler() {
 
 	// Filter out too short pulses. This method works as a low pass filter.
 	edgeTimeStamp[1] = edgeTimeStamp[2];
-	edgeTimeStamp[2] = micros();
+	edgeTimeStamp[2] = edgeTime;
 
 	if (skip) {
 		skip = false;
@@ -158,7 +194,7 @@ void RemoteReceiver::interruptHandler() {
 		repeats++;
 
 		if (repeats>=_minRepeats) {
-			if (!_inCallback) {
+			if (!_inCallback && !_isDuplicate(receivedCode, edgeTime)) {
 				_inCallback = true;
 				(_callback)(receivedCode, period);
 				_inCallback = false;
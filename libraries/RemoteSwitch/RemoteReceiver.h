@@ -11,6 +11,11 @@
 
 typedef void (*RemoteReceiverCallBack)(unsigned long, unsigned int);
 
+// Number of different codes remembered for setDedupWindow()
+#ifndef REMOTE_RECEIVER_DEDUP_SIZE
+#define REMOTE_RECEIVER_DEDUP_SIZE 4
+#endif
+
 /**
 * See RemoteSwitch for introduction.
 *
@@ -72,8 +77,30 @@ class RemoteReceiver {
 		*/
 		static boolean isReceiving(int waitMillis = 150);
 
+		/**
+		 * Called every time the signal level changes (high to low or vice versa). Usually called by interrupt.
+		 */
 		static void interruptHandler();
 
+		/**
+		 * Same as interruptHandler(), for an edge that happened at edgeTime (micros()). Use this
+		 * when edges are queued and handled later, e.g. with InterruptChain::setDeferred().
+		 * The callback is then called from there, with interrupts enabled.
+		 */
+		static void handleEdge(unsigned long edgeTime);
+
+		/**
+		 * Suppresses the callback for a code that was already reported less than window milliseconds
+		 * ago. A remote repeats its code for as long as a button is held, which would otherwise call
+		 * the callback every few repeats. Each received copy restarts the window of its code, so a
+		 * code is reported again once it has been quiet for window milliseconds. The last
+		 * REMOTE_RECEIVER_DEDUP_SIZE different codes are remembered. Call before init() or while
+		 * disabled.
+		 *
+		 * @param window Window in milliseconds, 0 (default) calls the callback for every repeat group
+		 */
+		static void setDedupWindow(unsigned int window);
+
 	private:
 
 		static int8_t _interrupt;					// Radio input interrupt
@@ -83,6 +110,20 @@ class RemoteReceiver {
 		static boolean _inCallback;					// When true, the callback function is being executed; prevents re-entrance.
 		static boolean _enabled;					// If true, monitoring and decoding is enabled. If false, interruptHandler will return immediately.
 
+		struct DedupEntry {
+			unsigned long code;
+			unsigned long time;						// edgeTime of the last copy received
+		};
+		static unsigned long _dedupWindow;			// In microseconds, 0 if off
+		static DedupEntry _dedup[REMOTE_RECEIVER_DEDUP_SIZE];
+
+		/**
+		 * Remembers code as received at edgeTime.
+		 *
+		 * @return true if the callback is to be suppressed for code
+		 */
+		static boolean _isDuplicate(unsigned long code, unsigned long edgeTime);
+
 };
 
 #endif
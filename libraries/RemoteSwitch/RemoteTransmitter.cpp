@@ -7,6 +7,23 @@
 
 #include "RemoteTransmitter.h"
 
+// Port register and mask of a pin looked up once per telegram. A digitalWrite()
+// costs a few microseconds, a 190us short pulse would come out noticeably longer.
+#if defined(__AVR__)
+	#define DECLARE_TX_PIN(pin) \
+		volatile uint8_t *txOut = portOutputRegister(digitalPinToPort(pin)); \
+		uint8_t txBit = digitalPinToBitMask(pin)
+	#define TX_PIN_WRITE(level) do { \
+		uint8_t oldSREG = SREG; \
+		cli(); \
+		if (level) *txOut |= txBit; else *txOut &= ~txBit; \
+		SREG = oldSREG; \
+	} while (0)
+#else
+	#define DECLARE_TX_PIN(pin)
+	#define TX_PIN_WRITE(level) digitalWrite(pin, level)
+#endif
+
 
 /************
 * RemoteTransmitter
@@ -71,6 +88,8 @@ void RemoteTransmitter::sendCode(byte pin, unsigned long code, unsigned int peri
 
 	repeats = 1 << (repeats & B111); // repeats := 2^repeats;
 
+	DECLARE_TX_PIN(pin);
+
 	for (byte j=0;j<repeats;j++) {
 		// Sent one telegram
 
@@ -79,33 +98,33 @@ void RemoteTransmitter::sendCode(byte pin, unsigned long code, unsigned int peri
 		for (byte i=0; i<12; i++) {
 			switch (code & B11) {
 				case 0:
-					digitalWrite(pin, HIGH);
+					TX_PIN_WRITE(HIGH);
 					delayMicroseconds(periodusec);
-					digitalWrite(pin, LOW);
+					TX_PIN_WRITE(LOW);
 					delayMicroseconds(periodusec*3);
-					digitalWrite(pin, HIGH);
+					TX_PIN_WRITE(HIGH);
 					delayMicroseconds(periodusec);
-					digitalWrite(pin, LOW);
+					TX_PIN_WRITE(LOW);
 					delayMicroseconds(periodusec*3);
 					break;
 				case 1:
-					digitalWrite(pin, HIGH);
+					TX_PIN_WRITE(HIGH);
 					delayMicroseconds(periodusec*3);
-					digitalWrite(pin, LOW);
+					TX_PIN_WRITE(LOW);
 					delayMicroseconds(periodusec);
-					digitalWrite(pin, HIGH);
+					TX_PIN_WRITE(HIGH);
 					delayMicroseconds(periodusec*3);
-					digitalWrite(pin, LOW);
+					TX_PIN_WRITE(LOW);
 					delayMicroseconds(periodusec);
 					break;
 				case 2: // KA: X or float
-					digitalWrite(pin, HIGH);
+					TX_PIN_WRITE(HIGH);
 					delayMicroseconds(periodusec);
-					digitalWrite(pin, LOW);
+					TX_PIN_WRITE(LOW);
 					delayMicroseconds(periodusec*3);
-					digitalWrite(pin, HIGH);
+					TX_PIN_WRITE(HIGH);
 					delayMicroseconds(periodusec*3);
-					digitalWrite(pin, LOW);
+					TX_PIN_WRITE(LOW);
 					delayMicroseconds(periodusec);
 					break;
 			}
@@ -114,9 +133,9 @@ void RemoteTransmitter::sendCode(byte pin, unsigned long code, unsigned int peri
 		}
 
 		// Send termination/synchronization-signal. Total length: 32 periods
-		digitalWrite(pin, HIGH);
+		TX_PIN_WRITE(HIGH);
 		delayMicroseconds(periodusec);
-		digitalWrite(pin, LOW);
+		TX_PIN_WRITE(LOW);
 		delayMicroseconds(periodusec*31);
 	}
 }
@@ -125,6 +144,48 @@ boolean RemoteTransmitter::isSameCode(unsigned long encodedTelegram, unsigned lo
 	return (receivedData==(encodedTelegram & 0xFFFFF)); // compare the 20 LSB's
 }
 
+// Pulse symbols: 1 period, 3 periods and the low part of the synchronization signal (31 periods)
+#define SYMBOL_1P 0
+#define SYMBOL_3P 1
+#define SYMBOL_SYNC 2
+
+static byte addSymbol(byte *symbols, byte count, byte symbol) {
+	if ((count & 3) == 0) {
+		symbols[count >> 2] = 0;
+	}
+	symbols[count >> 2] |= symbol << ((count & 3) << 1);
+	return count + 1;
+}
+
+byte RemoteTransmitter::encodePulses(unsigned long data, byte *symbols, unsigned int *durations, byte &repeats) {
+	unsigned int periodusec = data >> 23;
+	repeats = (1 << ((data >> 20) & B111)) - 1;
+	durations[SYMBOL_1P] = periodusec;
+	durations[SYMBOL_3P] = periodusec * 3;
+	durations[SYMBOL_SYNC] = periodusec * 31;
+	durations[3] = 0;
+
+	// Pulses of the trits 0, 1 and 2 (float), in the same bit order as symbols
+	static const byte tritPulses[3] = {
+		SYMBOL_1P | SYMBOL_3P << 2 | SYMBOL_1P << 4 | SYMBOL_3P << 6,
+		SYMBOL_3P | SYMBOL_1P << 2 | SYMBOL_3P << 4 | SYMBOL_1P << 6,
+		SYMBOL_1P | SYMBOL_3P << 2 | SYMBOL_3P << 4 | SYMBOL_1P << 6
+	};
+
+	// Most significant trit first
+	unsigned long code = data & 0xfffff;
+	byte trits[12];
+	for (int8_t i = 11; i >= 0; i--) {
+		trits[i] = code % 3;
+		code /= 3;
+	}
+	for (byte i = 0; i < 12; i++) {
+		symbols[i] = tritPulses[trits[i]];
+	}
+	byte count = addSymbol(symbols, 48, SYMBOL_1P);
+	return addSymbol(symbols, count, SYMBOL_SYNC);
+}
+
 
 /************
 * ActionTransmitter
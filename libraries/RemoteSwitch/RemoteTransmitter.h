@@ -9,6 +9,9 @@
 
 #include <Arduino.h>
 
+// Bytes needed for the pulse symbols of a telegram, see RemoteTransmitter::encodePulses()
+#define REMOTE_PULSE_BYTES 13
+
 /**
 * RemoteTransmitter provides a generic class for simulation of common RF remote controls, like the 'Klik aan Klik uit'-system
 * (http://www.klikaanklikuit.nl/), used to remotely switch lights etc.
@@ -91,6 +94,19 @@ class RemoteTransmitter {
 		*/
 		static boolean isSameCode(unsigned long encodedTelegram, unsigned long receivedData);
 
+		/**
+		* Encodes a telegram as pulse symbols instead of sending it, for sending from an interrupt with
+		* PulseTrain. Pulses alternate between HIGH and LOW, starting HIGH, 2 bits per pulse and 4 pulses
+		* per byte, first pulse in the lowest bits. Symbol n lasts durations[n] microseconds.
+		*
+		* @param data		Telegram as for sendTelegram(), including period and repeats.
+		* @param symbols	Buffer of REMOTE_PULSE_BYTES bytes for the symbols
+		* @param durations	Buffer of 4 durations
+		* @param repeats	Set to the number of times the telegram is to be repeated after the first one
+		* @return The number of pulses
+		*/
+		static byte encodePulses(unsigned long data, byte *symbols, unsigned int *durations, byte &repeats);
+
 	protected:
 		byte _pin;		// Transmitter output pin
 		unsigned int _periodusec;	// Oscillator period in microseconds
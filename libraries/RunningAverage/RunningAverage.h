@@ -1,8 +1,8 @@
 //
 //    FILE: RunningAverage.h
 //  AUTHOR: Rob dot Tillaart at gmail dot com
-// VERSION: 0.2.08
-//    DATE: 2015-apr-10
+// VERSION: 0.2.09
+//    DATE: 2016-oct-14
 // PURPOSE: RunningAverage library for Arduino
 //     URL: http://arduino.cc/playground/Main/RunningAverage
 // HISTORY: See RunningAverage.cpp
@@ -17,39 +17,30 @@
 #ifndef RunningAverage_h
 #define RunningAverage_h
 
-#define RUNNINGAVERAGE_LIB_VERSION "0.2.08"
+#define RUNNINGAVERAGE_LIB_VERSION "0.2.09"
 
 #include "Arduino.h"
+#include "RunningAverageT.h"
 
-class RunningAverage
+// doubles, NAN where there is no value yet
+// see RunningAverageT.h for other storage types
+class RunningAverage : public RunningAverageT<double>
 {
 public:
     RunningAverage(void);
-    RunningAverage(uint8_t);
-    ~RunningAverage();
+    RunningAverage(uint8_t size) : RunningAverageT<double>(size) {};
 
-    void clear();
-    void addValue(double);
-    void fillValue(double, uint8_t);
-
-    double getAverage();
     // returns lowest value added to the data-set since last clear
-    double getMin() { return _min; };
+    double getMin() { return _cnt ? _min : NAN; };
     // returns highest value added to the data-set since last clear
-    double getMax() { return _max; };
-
-    double getElement(uint8_t idx);
-    uint8_t getSize() { return _size; }
-    uint8_t getCount() { return _cnt; }
-
-protected:
-    uint8_t _size;
-    uint8_t _cnt;
-    uint8_t _idx;
-    double _sum;
-    double * _ar;
-    double _min;
-    double _max;
+    double getMax() { return _cnt ? _max : NAN; };
+
+    // returns lowest value in the current window
+    double getMinInBuffer() { return _cnt ? RunningAverageT<double>::getMinInBuffer() : NAN; };
+    // returns highest value in the current window
+    double getMaxInBuffer() { return _cnt ? RunningAverageT<double>::getMaxInBuffer() : NAN; };
+
+    double getElement(uint8_t idx) { return idx < _cnt ? _ar[idx] : NAN; };
 };
 
 #endif
@@ -0,0 +1,237 @@
+//
+//    FILE: RunningAverageT.h
+//  AUTHOR: Rob Tillaart
+// VERSION: 0.2.09
+//    DATE: 2016-oct-14
+// PURPOSE: RunningAverage with selectable storage type
+//     URL: http://arduino.cc/playground/Main/RunningAverage
+// HISTORY: See RunningAverage.cpp
+//
+// Released to the public domain
+//
+// T is the type of the stored values, S the type the sum is kept in.
+// S must hold size * the largest value, e.g.
+//   RunningAverageT<int16_t, int32_t> ra(100);   // 200 bytes of samples
+//   RunningAverageT<float> ra(100);
+//
+// addValue() and getAverage() are O(1). getMinInBuffer() and getMaxInBuffer()
+// use monotonic queues of buffer indexes, O(1) amortized per addValue();
+// the queues (2 bytes per element) are only allocated and kept up to date
+// once one of them has been called.
+
+#ifndef RunningAverageT_h
+#define RunningAverageT_h
+
+#include "Arduino.h"
+#include <stdlib.h>
+
+template <typename T, typename S = T>
+class RunningAverageT
+{
+public:
+    RunningAverageT(uint8_t size)
+    {
+        _size = size;
+        _ar = (T*) malloc(_size * sizeof(T));
+        if (_ar == NULL) _size = 0;
+        _minQ = _maxQ = NULL;
+        clear();
+    }
+
+    ~RunningAverageT()
+    {
+        if (_ar != NULL) free(_ar);
+        if (_minQ != NULL) free(_minQ);
+        if (_maxQ != NULL) free(_maxQ);
+    }
+
+    // resets all counters
+    void clear()
+    {
+        _cnt = 0;
+        _idx = 0;
+        _sum = 0;
+        _sumSq = 0;
+        _min = _max = T();
+        _minHead = _minLen = 0;
+        _maxHead = _maxLen = 0;
+    }
+
+    // adds a new value to the data-set
+    void addValue(T value)
+    {
+        if (_ar == NULL) return;  // allocation error
+        if (_cnt == _size)
+        {
+            // the oldest value leaves the window
+            T old = _ar[_idx];
+            _sum -= old;
+            _sumSq -= (double)old * old;
+            if (_minLen && _minQ[_minHead] == _idx) popFront(_minHead, _minLen);
+            if (_maxLen && _maxQ[_maxHead] == _idx) popFront(_maxHead, _maxLen);
+        }
+        _ar[_idx] = value;
+        _sum += value;
+        _sumSq += (double)value * value;
+        if (_minQ != NULL)
+        {
+            while (_minLen && _ar[back(_minQ, _minHead, _minLen)] >= value) _minLen--;
+            pushBack(_minQ, _minHead, _minLen, _idx);
+            while (_maxLen && _ar[back(_maxQ, _maxHead, _maxLen)] <= value) _maxLen--;
+            pushBack(_maxQ, _maxHead, _maxLen, _idx);
+        }
+        // handle min max
+        if (_cnt == 0) _min = _max = value;
+        else if (value < _min) _min = value;
+        else if (value > _max) _max = value;
+        // update count as last otherwise if( _cnt == 0) above will fail
+        if (_cnt < _size) _cnt++;
+        _idx++;
+        if (_idx == _size)
+        {
+            _idx = 0;  // faster than %
+            // once per round trip, so rounding errors of add/subtract
+            // can't pile up in floating point sums
+            resum();
+        }
+    }
+
+    // fill the average with a value
+    // the param number determines how often value is added (weight)
+    // number should preferably be between 1 and size
+    void fillValue(T value, uint8_t number)
+    {
+        clear();
+        for (uint8_t i = 0; i < number; i++)
+        {
+            addValue(value);
+        }
+    }
+
+    // returns the average of the data-set added sofar, NAN if empty
+    double getAverage()
+    {
+        if (_cnt == 0) return NAN;
+        return (double)_sum / _cnt;
+    }
+
+    // returns the sample variance of the data-set, NAN for less than 2 values
+    double getVariance()
+    {
+        if (_cnt < 2) return NAN;
+        double var = (_sumSq - (double)_sum * _sum / _cnt) / (_cnt - 1);
+        return var < 0 ? 0 : var;  // rounding
+    }
+
+    double getStandardDeviation()
+    {
+        return sqrt(getVariance());
+    }
+
+    // returns lowest value added to the data-set since last clear
+    T getMin() { return _min; };
+    // returns highest value added to the data-set since last clear
+    T getMax() { return _max; };
+
+    // returns lowest value in the current window
+    T getMinInBuffer()
+    {
+        if (_cnt == 0 || !startQueues()) return T();
+        return _ar[_minQ[_minHead]];
+    }
+
+    // returns highest value in the current window
+    T getMaxInBuffer()
+    {
+        if (_cnt == 0 || !startQueues()) return T();
+        return _ar[_maxQ[_maxHead]];
+    }
+
+    T getElement(uint8_t idx)
+    {
+        if (idx >= _cnt) return T();
+        return _ar[idx];
+    }
+    uint8_t getSize() { return _size; }
+    uint8_t getCount() { return _cnt; }
+
+protected:
+    uint8_t _size;
+    uint8_t _cnt;
+    uint8_t _idx;
+    S _sum;
+    double _sumSq;
+    T * _ar;
+    T _min;
+    T _max;
+
+    // monotonic queues of _ar indexes, oldest first: values increase
+    // along _minQ and decrease along _maxQ
+    uint8_t * _minQ;
+    uint8_t * _maxQ;
+    uint8_t _minHead, _minLen;
+    uint8_t _maxHead, _maxLen;
+
+    void resum()
+    {
+        _sum = 0;
+        _sumSq = 0;
+        for (uint8_t i = 0; i < _cnt; i++)
+        {
+            _sum += _ar[i];
+            _sumSq += (double)_ar[i] * _ar[i];
+        }
+    }
+
+    uint8_t back(uint8_t * q, uint8_t head, uint8_t len)
+    {
+        uint16_t i = head + len - 1;
+        return q[i < _size ? i : i - _size];
+    }
+
+    void pushBack(uint8_t * q, uint8_t head, uint8_t & len, uint8_t value)
+    {
+        uint16_t i = head + len;
+        q[i < _size ? i : i - _size] = value;
+        len++;
+    }
+
+    void popFront(uint8_t & head, uint8_t & len)
+    {
+        head++;
+        if (head == _size) head = 0;
+        len--;
+    }
+
+    // allocates the queues and fills them from the current window
+    bool startQueues()
+    {
+        if (_minQ != NULL) return true;
+        _minQ = (uint8_t*) malloc(_size);
+        _maxQ = (uint8_t*) malloc(_size);
+        if (_minQ == NULL || _maxQ == NULL)
+        {
+            if (_minQ != NULL) free(_minQ);
+            if (_maxQ != NULL) free(_maxQ);
+            _minQ = _maxQ = NULL;
+            return false;
+        }
+        _minHead = _minLen = 0;
+        _maxHead = _maxLen = 0;
+        uint8_t i = (_cnt == _size) ? _idx : 0;  // oldest value
+        for (uint8_t n = 0; n < _cnt; n++)
+        {
+            T value = _ar[i];
+            while (_minLen && _ar[back(_minQ, _minHead, _minLen)] >= value) _minLen--;
+            pushBack(_minQ, _minHead, _minLen, i);
+            while (_maxLen && _ar[back(_maxQ, _maxHead, _maxLen)] <= value) _maxLen--;
+            pushBack(_maxQ, _maxHead, _maxLen, i);
+            i++;
+            if (i == _size) i = 0;
+        }
+        return true;
+    }
+};
+
+#endif
+// END OF FILE
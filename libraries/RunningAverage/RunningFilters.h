@@ -0,0 +1,363 @@
+//
+//    FILE: RunningFilters.h
+//  AUTHOR: Rob Tillaart
+// VERSION: 0.2.09
+//    DATE: 2016-oct-14
+// PURPOSE: median, outlier rejection and exponential average filters,
+//          companions of RunningAverage
+//     URL: http://arduino.cc/playground/Main/RunningAverage
+// HISTORY: See RunningAverage.cpp
+//
+// Released to the public domain
+//
+// RunningMedianT<T>        median of the last size values, O(log size)
+//                          per addValue(), no sorting on read
+// HampelFilterT<T>         replaces values that lie more than k scaled
+//                          median absolute deviations from the median
+// ExponentialAverageT<T,S> integer exponential moving average,
+//                          alpha = 1 / 2^shift
+// ExponentialAverage       double exponential moving average, any alpha
+//
+// e.g. for NewPing distances in cm:
+//   HampelFilterT<uint16_t> spikes(7);
+//   uint16_t cm = spikes.filter(sonar.ping_cm());
+
+#ifndef RunningFilters_h
+#define RunningFilters_h
+
+#include "Arduino.h"
+#include <stdlib.h>
+
+// The window is a circular buffer like RunningAverage. Its slots are kept
+// in two heaps: _lo, a max-heap of the lower half, and _hi, a min-heap of
+// the upper half, with _lo holding the extra value for an odd count.
+// The median is at the top of the heaps. _where records the heap position
+// of every slot, so the value leaving the window is replaced in place.
+template <typename T>
+class RunningMedianT
+{
+public:
+    RunningMedianT(uint8_t size)
+    {
+        _size = size;
+        _ar = (T*) malloc(_size * sizeof(T));
+        _lo = (uint8_t*) malloc(_size);
+        _hi = (uint8_t*) malloc(_size);
+        _where = (int16_t*) malloc(_size * sizeof(int16_t));
+        if (_ar == NULL || _lo == NULL || _hi == NULL || _where == NULL) _size = 0;
+        clear();
+    }
+
+    ~RunningMedianT()
+    {
+        if (_ar != NULL) free(_ar);
+        if (_lo != NULL) free(_lo);
+        if (_hi != NULL) free(_hi);
+        if (_where != NULL) free(_where);
+    }
+
+    // resets all counters
+    void clear()
+    {
+        _cnt = 0;
+        _idx = 0;
+        _loCnt = 0;
+        _hiCnt = 0;
+    }
+
+    // adds a new value to the data-set
+    void addValue(T value)
+    {
+        if (_size == 0) return;  // allocation error
+        uint8_t slot = _idx;
+        _ar[slot] = value;
+        if (_cnt == _size)
+        {
+            // the slot of the oldest value gets the new one, restore its heap
+            int16_t w = _where[slot];
+            if (w < 0)
+            {
+                uint8_t p = siftUp(_lo, -w - 1, false);
+                siftDown(_lo, _loCnt, p, false);
+            }
+            else
+            {
+                uint8_t p = siftUp(_hi, w, true);
+                siftDown(_hi, _hiCnt, p, true);
+            }
+            // and the one condition between the heaps
+            if (_hiCnt && _ar[_lo[0]] > _ar[_hi[0]])
+            {
+                uint8_t s = _lo[0];
+                place(_lo, 0, _hi[0], false);
+                place(_hi, 0, s, true);
+                siftDown(_lo, _loCnt, 0, false);
+                siftDown(_hi, _hiCnt, 0, true);
+            }
+        }
+        else
+        {
+            if (_loCnt == 0 || value <= _ar[_lo[0]]) push(_lo, _loCnt, slot, false);
+            else push(_hi, _hiCnt, slot, true);
+            if (_loCnt > _hiCnt + 1) push(_hi, _hiCnt, pop(_lo, _loCnt, false), true);
+            else if (_hiCnt > _loCnt) push(_lo, _loCnt, pop(_hi, _hiCnt, true), false);
+            _cnt++;
+        }
+        _idx++;
+        if (_idx == _size) _idx = 0;  // faster than %
+    }
+
+    // returns the median of the data-set, for an even count the mean
+    // of the middle two; T() if empty
+    T getMedian()
+    {
+        if (_cnt == 0) return T();
+        T low = _ar[_lo[0]];
+        if (_cnt & 1) return low;
+        return low + (_ar[_hi[0]] - low) / 2;
+    }
+
+    // the values on both sides of the (even count) median
+    T getLowMedian() { return _cnt ? _ar[_lo[0]] : T(); }
+    T getHighMedian() { return _cnt ? _ar[_hiCnt ? _hi[0] : _lo[0]] : T(); }
+
+    // returns the value of an element if exist, T() otherwise
+    T getElement(uint8_t idx) { return idx < _cnt ? _ar[idx] : T(); }
+    uint8_t getSize() { return _size; }
+    uint8_t getCount() { return _cnt; }
+
+protected:
+    uint8_t _size;
+    uint8_t _cnt;
+    uint8_t _idx;
+    T * _ar;
+    uint8_t * _lo;
+    uint8_t * _hi;
+    uint8_t _loCnt;
+    uint8_t _hiCnt;
+    int16_t * _where;  // >= 0: position in _hi, < 0: -1 - position in _lo
+
+    // true if slot a belongs above slot b in its heap
+    bool above(uint8_t a, uint8_t b, bool isMin)
+    {
+        return isMin ? _ar[a] < _ar[b] : _ar[a] > _ar[b];
+    }
+
+    void place(uint8_t * heap, uint8_t pos, uint8_t slot, bool isMin)
+    {
+        heap[pos] = slot;
+        _where[slot] = isMin ? pos : -1 - pos;
+    }
+
+    uint8_t siftUp(uint8_t * heap, uint8_t pos, bool isMin)
+    {
+        uint8_t slot = heap[pos];
+        while (pos > 0)
+        {
+            uint8_t parent = (pos - 1) / 2;
+            if (!above(slot, heap[parent], isMin)) break;
+            place(heap, pos, heap[parent], isMin);
+            pos = parent;
+        }
+        place(heap, pos, slot, isMin);
+        return pos;
+    }
+
+    void siftDown(uint8_t * heap, uint8_t cnt, uint8_t pos, bool isMin)
+    {
+        uint8_t slot = heap[pos];
+        while (true)
+        {
+            uint16_t child = 2 * pos + 1;
+            if (child >= cnt) break;
+            if (child + 1 < cnt && above(heap[child + 1], heap[child], isMin)) child++;
+            if (!above(heap[child], slot, isMin)) break;
+            place(heap, pos, heap[child], isMin);
+            pos = child;
+        }
+        place(heap, pos, slot, isMin);
+    }
+
+    void push(uint8_t * heap, uint8_t & cnt, uint8_t slot, bool isMin)
+    {
+        place(heap, cnt, slot, isMin);
+        siftUp(heap, cnt++, isMin);
+    }
+
+    uint8_t pop(uint8_t * heap, uint8_t & cnt, bool isMin)
+    {
+        uint8_t slot = heap[0];
+        cnt--;
+        if (cnt > 0)
+        {
+            place(heap, 0, heap[cnt], isMin);
+            siftDown(heap, cnt, 0, isMin);
+        }
+        return slot;
+    }
+};
+
+
+// Hampel identifier: a value further than k * 1.4826 * MAD from the median
+// of the window is an outlier, filter() then returns the median instead.
+// MAD is the median of the absolute deviations from the median, found by
+// quickselect on a scratch copy: O(size) per value, meant for the small
+// windows (5..15) that are usual for spike removal.
+template <typename T>
+class HampelFilterT : public RunningMedianT<T>
+{
+public:
+    // k in tenths, 30 = 3.0 deviations (the usual choice)
+    HampelFilterT(uint8_t size, uint8_t k = 30) : RunningMedianT<T>(size)
+    {
+        _k = k;
+        _dev = (T*) malloc(size * sizeof(T));
+        if (_dev == NULL) this->_size = 0;
+        _outliers = 0;
+    }
+
+    ~HampelFilterT()
+    {
+        if (_dev != NULL) free(_dev);
+    }
+
+    // adds value to the window and returns it, or the median when it is
+    // an outlier
+    T filter(T value)
+    {
+        this->addValue(value);
+        if (this->_cnt < 3) return value;
+
+        T median = this->getMedian();
+        T deviation = value > median ? value - median : median - value;
+        if (!isOutlier(deviation, getMAD(median))) return value;
+        _outliers++;
+        return median;
+    }
+
+    // median absolute deviation of the current window
+    T getMAD()
+    {
+        if (this->_cnt == 0) return T();
+        return getMAD(this->getMedian());
+    }
+
+    // number of values replaced since start
+    uint32_t getOutliers() { return _outliers; }
+
+protected:
+    uint8_t _k;
+    T * _dev;
+    uint32_t _outliers;
+
+    // k/10 * 1.4826 * mad, as 1.4826 ~ 1483/1000; a MAD of 0 (more than half
+    // the window equal) flags any deviation
+    bool isOutlier(T deviation, T mad)
+    {
+        return (double)deviation * 10000.0 > (double)mad * _k * 1483.0;
+    }
+
+    T getMAD(T median)
+    {
+        uint8_t n = this->_cnt;
+        for (uint8_t i = 0; i < n; i++)
+        {
+            T v = this->_ar[i];
+            _dev[i] = v > median ? v - median : median - v;
+        }
+        // upper median of the deviations, which is what getMedian() gives for
+        // odd counts and, within rounding, for even ones
+        return select(_dev, n, n / 2);
+    }
+
+    // k-th smallest of a[0..n-1], rearranges a
+    static T select(T * a, uint8_t n, uint8_t k)
+    {
+        uint8_t left = 0, right = n - 1;
+        while (left < right)
+        {
+            T pivot = a[(left + right) / 2];
+            uint8_t i = left, j = right;
+            while (i <= j)
+            {
+                while (a[i] < pivot) i++;
+                while (a[j] > pivot) j--;
+                if (i <= j)
+                {
+                    T t = a[i]; a[i] = a[j]; a[j] = t;
+                    i++;
+                    if (j == 0) break;
+                    j--;
+                }
+            }
+            if (k <= j) right = j;
+            else if (k >= i) left = i;
+            else break;
+        }
+        return a[k];
+    }
+};
+
+
+// Exponential moving average with alpha = 1 / 2^shift, no multiplications.
+// The average is kept scaled by 2^shift in S, which needs shift bits more
+// than T, e.g. ExponentialAverageT<int16_t, int32_t> ema(4);
+template <typename T, typename S = int32_t>
+class ExponentialAverageT
+{
+public:
+    ExponentialAverageT(uint8_t shift)
+    {
+        _shift = shift;
+        clear();
+    }
+
+    void clear() { _cnt = 0; _acc = 0; }
+
+    // adds a new value, the first one sets the average
+    void addValue(T value)
+    {
+        if (_cnt == 0)
+        {
+            _acc = (S)value << _shift;
+            _cnt = 1;
+            return;
+        }
+        // rounded, so the average can settle on the input exactly
+        _acc += (S)value - ((_acc + ((S)1 << _shift >> 1)) >> _shift);
+    }
+
+    T getAverage() { return (T)((_acc + ((S)1 << _shift >> 1)) >> _shift); }
+    uint8_t getCount() { return _cnt; }
+
+protected:
+    uint8_t _shift;
+    uint8_t _cnt;
+    S _acc;
+};
+
+
+// Exponential moving average of doubles, 0 < alpha <= 1
+class ExponentialAverage
+{
+public:
+    ExponentialAverage(double alpha) { _alpha = alpha; clear(); }
+
+    void clear() { _avg = NAN; }
+
+    void addValue(double value)
+    {
+        if (isnan(_avg)) _avg = value;
+        else _avg += _alpha * (value - _avg);
+    }
+
+    // returns NAN until a value has been added
+    double getAverage() { return _avg; }
+
+protected:
+    double _alpha;
+    double _avg;
+};
+
+#endif
+// END OF FILE
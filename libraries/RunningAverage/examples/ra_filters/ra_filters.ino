@@ -0,0 +1,59 @@
+//
+//    FILE: ra_filters.ino
+//  AUTHOR: Rob Tillaart
+// VERSION: 0.1.00
+//    DATE: 2016-oct-14
+//
+// PUPROSE: demo of the median, Hampel and exponential average filters
+//          on a noisy signal with spikes
+//
+
+#include "RunningAverage.h"
+#include "RunningFilters.h"
+
+RunningAverage myRA(7);
+RunningMedianT<int> myMedian(7);
+HampelFilterT<int> myHampel(7);
+ExponentialAverageT<int> myEMA(3);  // alpha = 1/8
+int samples = 0;
+
+void setup(void)
+{
+  Serial.begin(115200);
+  Serial.println("\nDemo ra_filters");
+  Serial.print("Version: ");
+  Serial.println(RUNNINGAVERAGE_LIB_VERSION);
+
+  Serial.println("\nRAW\tAVG\tMEDIAN\tHAMPEL\tEMA");
+}
+
+void loop(void)
+{
+  int raw = 500 + random(-10, 10);
+  if (random(0, 10) == 0) raw = random(0, 1000);  // spike
+  samples++;
+
+  myRA.addValue(raw);
+  myMedian.addValue(raw);
+  int clean = myHampel.filter(raw);
+  myEMA.addValue(clean);
+
+  Serial.print(raw);
+  Serial.print("\t");
+  Serial.print(myRA.getAverage(), 1);
+  Serial.print("\t");
+  Serial.print(myMedian.getMedian());
+  Serial.print("\t");
+  Serial.print(clean);
+  Serial.print("\t");
+  Serial.println(myEMA.getAverage());
+
+  if (samples == 100)
+  {
+    samples = 0;
+    Serial.print("\nOutliers replaced: ");
+    Serial.println(myHampel.getOutliers());
+    Serial.println("\nRAW\tAVG\tMEDIAN\tHAMPEL\tEMA");
+  }
+  delay(10);
+}
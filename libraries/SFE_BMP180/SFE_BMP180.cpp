@@ -25,6 +25,9 @@
 SFE_BMP180::SFE_BMP180()
 // Base library type
 {
+	_b5 = 0;
+	_wait = 0;
+	_oss = 0;
 }
 
 
@@ -221,6 +224,8 @@ char SFE_BMP180::startTemperature(void)
 	data[0] = BMP180_REG_CONTROL;
 	data[1] = BMP180_COMMAND_TEMPERATURE;
 	result = writeBytes(data, 2);
+	_start = millis();
+	_wait = 5;
 	if (result) // good write?
 		return(5); // return the delay in ms (rounded up) to wait before retrieving data
 	else
@@ -296,9 +301,13 @@ char SFE_BMP180::startPressure(char oversampling)
 		default:
 			data[1] = BMP180_COMMAND_PRESSURE0;
 			delay = 5;
+			oversampling = 0;
 		break;
 	}
 	result = writeBytes(data, 2);
+	_start = millis();
+	_wait = delay;
+	_oss = oversampling;
 	if (result) // good write?
 		return(delay); // return the delay in ms (rounded up) to wait before retrieving data
 	else
@@ -356,12 +365,125 @@ char SFE_BMP180::getPressure(double &P, double &T)
 }
 
 
+char SFE_BMP180::isReady(void)
+// Check whether a previously started measurement can be retrieved.
+// Lets you do other work (or sleep) instead of waiting out the returned delay.
+// Returns 1 if the conversion time has passed, 0 otherwise.
+{
+	return((unsigned long)(millis() - _start) >= _wait);
+}
+
+
+char SFE_BMP180::getTemperature(int &T)
+// Retrieve a previously-started temperature reading using the integer
+// equations from the Bosch datasheet.
+// T: external variable to hold result (0.1 deg C).
+// Returns 1 if successful, 0 if I2C error.
+{
+	unsigned char data[2];
+	char result;
+	long ut, x1, x2;
+
+	data[0] = BMP180_REG_RESULT;
+
+	result = readBytes(data, 2);
+	if (result) // good read, calculate temperature
+	{
+		ut = ((long)data[0] << 8) | data[1];
+
+		x1 = ((ut - AC6) * AC5) >> 15;
+		x2 = ((long)(int16_t)MC << 11) / (x1 + (int16_t)MD);
+		_b5 = x1 + x2;
+		T = (_b5 + 8) >> 4;
+	}
+	return(result);
+}
+
+
+char SFE_BMP180::getPressure(long &P)
+// Retrieve a previously started pressure reading using the integer
+// equations from the Bosch datasheet.
+// Requires getTemperature(int &T) to have been called prior.
+// P: external variable to hold pressure (Pa).
+// Returns 1 for success, 0 for I2C error.
+{
+	unsigned char data[3];
+	char result;
+	long up, b3, b6, x1, x2, x3;
+	unsigned long b4, b7;
+
+	data[0] = BMP180_REG_RESULT;
+
+	result = readBytes(data, 3);
+	if (result) // good read, calculate pressure
+	{
+		up = (((long)data[0] << 16) | ((long)data[1] << 8) | data[2]) >> (8 - _oss);
+
+		b6 = _b5 - 4000;
+		x1 = ((long)(int16_t)VB2 * ((b6 * b6) >> 12)) >> 11;
+		x2 = ((long)(int16_t)AC2 * b6) >> 11;
+		x3 = x1 + x2;
+		b3 = ((((long)(int16_t)AC1 * 4 + x3) << _oss) + 2) / 4;
+		x1 = ((long)(int16_t)AC3 * b6) >> 13;
+		x2 = ((long)(int16_t)VB1 * ((b6 * b6) >> 12)) >> 16;
+		x3 = ((x1 + x2) + 2) >> 2;
+		b4 = ((unsigned long)AC4 * (unsigned long)(x3 + 32768)) >> 15;
+		b7 = ((unsigned long)up - b3) * (50000UL >> _oss);
+		if (b7 < 0x80000000)
+			P = (b7 * 2) / b4;
+		else
+			P = (b7 / b4) * 2;
+		x1 = (P >> 8) * (P >> 8);
+		x1 = (x1 * 3038) >> 16;
+		x2 = (-7357 * P) >> 16;
+		P = P + ((x1 + x2 + 3791) >> 4);
+	}
+	return(result);
+}
+
+
+// The barometric formula without pow(): altitude in 0.5m for pressure
+// ratios P/P0 from 0.25 to 1.25 in steps of 1/64, interpolated linearly.
+// The error is below 1m around sea level and about 3m at 10km.
+
+#define ALTITUDE_RATIO_MIN 4096 // 0.25 in 1/16384
+#define ALTITUDE_RATIO_MAX 20480 // 1.25 in 1/16384
+#define ALTITUDE_RATIO_STEP 256 // 1/64 in 1/16384
+
+static const int16_t altitudeTable[65] PROGMEM = {
+	 20558,  19768,  19015,  18294,  17604,  16941,  16304,  15689,
+	 15096,  14522,  13966,  13428,  12906,  12398,  11904,  11424,
+	 10956,  10500,  10054,   9620,   9195,   8779,   8373,   7975,
+	  7585,   7204,   6829,   6462,   6102,   5748,   5400,   5059,
+	  4723,   4393,   4069,   3749,   3435,   3125,   2821,   2520,
+	  2224,   1933,   1645,   1362,   1082,    806,    534,    265,
+	     0,   -262,   -521,   -776,  -1029,  -1278,  -1525,  -1769,
+	 -2010,  -2248,  -2484,  -2717,  -2947,  -3175,  -3401,  -3625,
+	 -3846
+};
+
+static long altitudeAt(unsigned char i)
+// Table entry i in cm
+{
+	return((int16_t)pgm_read_word(&altitudeTable[i]) * 50L);
+}
+
+
 double SFE_BMP180::sealevel(double P, double A)
 // Given a pressure P (mb) taken at a specific altitude (meters),
 // return the equivalent pressure (mb) at sea level.
 // This produces pressure readings that can be used for weather measurements.
 {
-	return(P/pow(1-(A/44330.0),5.255));
+	long a, a0, a1, ratio;
+	unsigned char i = 0;
+
+	// the table falls with the ratio, find the step containing A
+	a = constrain((long)(A * 100.0), altitudeAt(64) + 1, altitudeAt(0));
+	while (altitudeAt(i+1) >= a) i++;
+	a0 = altitudeAt(i);
+	a1 = altitudeAt(i+1);
+	ratio = ALTITUDE_RATIO_MIN + i * ALTITUDE_RATIO_STEP + (a0 - a) * ALTITUDE_RATIO_STEP / (a0 - a1);
+	return(P * 16384.0 / ratio);
 }
 
 
@@ -369,7 +491,14 @@ double SFE_BMP180::altitude(double P, double P0)
 // Given a pressure measurement P (mb) and the pressure at a baseline P0 (mb),
 // return altitude (meters) above baseline.
 {
-	return(44330.0*(1-pow(P/P0,1/5.255)));
+	long ratio, a0, a1;
+	unsigned char i;
+
+	ratio = constrain((long)(P * 16384.0 / P0), ALTITUDE_RATIO_MIN, ALTITUDE_RATIO_MAX - 1) - ALTITUDE_RATIO_MIN;
+	i = ratio / ALTITUDE_RATIO_STEP;
+	a0 = altitudeAt(i);
+	a1 = altitudeAt(i+1);
+	return((a0 + (a1 - a0) * (ratio % ALTITUDE_RATIO_STEP) / ALTITUDE_RATIO_STEP) / 100.0);
 }
 
 
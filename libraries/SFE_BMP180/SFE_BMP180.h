@@ -54,6 +54,21 @@ class SFE_BMP180
 			// places returned value in P variable (mbar)
 			// returns 1 for success, 0 for fail
 
+		char isReady(void);
+			// returns 1 once the time needed by the previous startTemperature
+			// or startPressure command has passed, 0 while still converting
+
+		char getTemperature(int &T);
+			// integer version of getTemperature(double &T)
+			// places returned value in T variable (0.1 deg C)
+			// returns 1 for success, 0 for fail
+
+		char getPressure(long &P);
+			// integer version of getPressure(double &P, double &T)
+			// note: requires previous getTemperature(int &T) call
+			// places returned value in P variable (Pa)
+			// returns 1 for success, 0 for fail
+
 		double sealevel(double P, double A);
 			// convert absolute pressure to sea-level pressure (as used in weather data)
 			// P: absolute pressure (mbar)
@@ -104,6 +119,9 @@ class SFE_BMP180
 		int AC1,AC2,AC3,VB1,VB2,MB,MC,MD;
 		unsigned int AC4,AC5,AC6; 
 		double c5,c6,mc,md,x0,x1,x2,y0,y1,y2,p0,p1,p2;
+		long _b5;
+		unsigned long _start;
+		unsigned char _wait, _oss;
 		char _error;
 };
 
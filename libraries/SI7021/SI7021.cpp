@@ -12,6 +12,7 @@ This program is licensed under the GNU GPL v2
 // I2C commands
 byte RH_READ[]           = { 0xE5 };
 byte TEMP_READ[]         = { 0xE3 };
+byte RH_READ_NOHOLD[]    = { 0xF5 };
 byte POST_RH_TEMP_READ[] = { 0xE0 };
 byte RESET[]             = { 0xFE };
 byte USER1_READ[]        = { 0xE7 };
@@ -22,6 +23,7 @@ byte SERIAL2_READ[]      = { 0xFC, 0xC9 };
 bool _si_exists = false;
 
 SI7021::SI7021() {
+    _resultReady = false;
 }
 
 bool SI7021::begin() {
@@ -44,14 +46,14 @@ int SI7021::getFahrenheitHundredths() {
 
 int SI7021::getCelsiusHundredths() {
     byte tempbytes[2];
-    _command(TEMP_READ, tempbytes);
+    _command(TEMP_READ, sizeof TEMP_READ, tempbytes, sizeof tempbytes);
     long tempraw = (long)tempbytes[0] << 8 | tempbytes[1];
     return ((17572 * tempraw) >> 16) - 4685;
 }
 
 int SI7021::_getCelsiusPostHumidity() {
     byte tempbytes[2];
-    _command(POST_RH_TEMP_READ, tempbytes);
+    _command(POST_RH_TEMP_READ, sizeof POST_RH_TEMP_READ, tempbytes, sizeof tempbytes);
     long tempraw = (long)tempbytes[0] << 8 | tempbytes[1];
     return ((17572 * tempraw) >> 16) - 4685;
 }
@@ -59,28 +61,27 @@ int SI7021::_getCelsiusPostHumidity() {
 
 unsigned int SI7021::getHumidityPercent() {
     byte humbytes[2];
-    _command(RH_READ, humbytes);
+    _command(RH_READ, sizeof RH_READ, humbytes, sizeof humbytes);
     long humraw = (long)humbytes[0] << 8 | humbytes[1];
     return ((125 * humraw) >> 16) - 6;
 }
 
 unsigned int SI7021::getHumidityBasisPoints() {
     byte humbytes[2];
-    _command(RH_READ, humbytes);
+    _command(RH_READ, sizeof RH_READ, humbytes, sizeof humbytes);
     long humraw = (long)humbytes[0] << 8 | humbytes[1];
     return ((12500 * humraw) >> 16) - 600;
 }
 
-void SI7021::_command(byte * cmd, byte * buf ) {
-    _writeReg(cmd, sizeof cmd);
-    _readReg(buf, sizeof buf);
+void SI7021::_command(byte * cmd, int cmdlen, byte * buf, int buflen) {
+    _writeReg(cmd, cmdlen);
+    _readReg(buf, buflen);
 }
 
 void SI7021::_writeReg(byte * reg, int reglen) {
     Wire.beginTransmission(I2C_ADDR);
     for(int i = 0; i < reglen; i++) {
-        reg += i;
-        Wire.write(*reg); 
+        Wire.write(reg[i]); 
     }
     Wire.endTransmission();
 }
@@ -126,10 +127,57 @@ void SI7021::setHeater(bool on) {
 }
 
 // get humidity, then get temperature reading from humidity measurement
+// the sensor does not hold the bus while it measures, so other devices
+// can use it meanwhile
 struct si7021_env SI7021::getHumidityAndTemperature() {
+    startHumidityAndTemperature();
+    unsigned long start = millis();
+    while (!isReady()) {
+        if (millis() - start > SI7021_MEASURE_MS * 2) {
+            si7021_env ret = {0, 0, 0};
+            return ret;
+        }
+        delay(1);
+    }
+    return getResult();
+}
+
+// start a humidity measurement without holding the bus, the temperature
+// measured along with it is read back by getResult()
+void SI7021::startHumidityAndTemperature() {
+    _resultReady = false;
+    _writeReg(RH_READ_NOHOLD, sizeof RH_READ_NOHOLD);
+}
+
+// the sensor NACKs its address until the measurement is done
+bool SI7021::isReady() {
+    if (_resultReady) {
+        return true;
+    }
+#ifdef __AVR_ATtiny85__
+    if (Wire.requestFrom(I2C_ADDR, 2) != 0) {
+        return false;
+    }
+#else
+    if (Wire.requestFrom(I2C_ADDR, 2) < 2) {
+        return false;
+    }
+#endif
+    _result[0] = Wire.read();
+    _result[1] = Wire.read();
+    _resultReady = true;
+    return true;
+}
+
+struct si7021_env SI7021::getResult() {
     si7021_env ret = {0, 0, 0};
-    ret.humidityPercent          = getHumidityPercent();
+    if (!isReady()) {
+        return ret;
+    }
+    long humraw = (long)_result[0] << 8 | _result[1];
+    ret.humidityPercent          = ((125 * humraw) >> 16) - 6;
     ret.celsiusHundredths        = _getCelsiusPostHumidity();
     ret.fahrenheitHundredths     = (1.8 * ret.celsiusHundredths) + 3200;
+    _resultReady = false;
     return ret;
 }
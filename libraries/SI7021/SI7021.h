@@ -20,6 +20,10 @@ This program is licensed under the GNU GPL v2
  #include <Wire.h>
 #endif
 
+// longest time of a humidity measurement including the temperature
+// measured along with it (12 bit RH and 14 bit temperature)
+#define SI7021_MEASURE_MS 23
+
 typedef struct si7021_env {
     int celsiusHundredths;
     int fahrenheitHundredths;
@@ -40,8 +44,16 @@ class SI7021
     int getSerialBytes(byte * buf);
     int getDeviceId();
     void setHeater(bool on);
+    // non-blocking humidity and temperature: start the measurement, poll
+    // isReady() (ready after at most SI7021_MEASURE_MS) and fetch the values
+    // with getResult(), one conversion gives both
+    void startHumidityAndTemperature();
+    bool isReady();
+    struct si7021_env getResult();
   private:
-    void _command(byte * cmd, byte * buf );
+    byte _result[2];
+    bool _resultReady;
+    void _command(byte * cmd, int cmdlen, byte * buf, int buflen);
     void _writeReg(byte * reg, int reglen);
     int _readReg(byte * reg, int reglen);
     int _getCelsiusPostHumidity();
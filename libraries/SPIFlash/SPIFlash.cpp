@@ -8,6 +8,8 @@
  *
  * Updated Jan. 5, 2015, TomWS1, modified writeBytes to allow blocks > 256 bytes and handle page misalignment.
  * Updated Feb. 26, 2015 TomWS1, added support for SPI Transactions (Arduino 1.5.8 and above)
+ * Added streaming reads (readStart/readNext/readEnd), page writes in the background (writeBytesStart/writePending)
+ * and block transfers of the data bytes.
  *
  * This file is free software; you can redistribute it and/or modify
  * it under the terms of either the GNU General Public License version 2
@@ -31,6 +33,7 @@ byte SPIFlash::UNIQUEID[8];
 SPIFlash::SPIFlash(uint8_t slaveSelectPin, uint16_t jedecID) {
   _slaveSelectPin = slaveSelectPin;
   _jedecID = jedecID;
+  _writeLen = 0;
 }
 
 /// Select the flash chip
@@ -140,8 +143,29 @@ void SPIFlash::readBytes(long addr, void* buf, word len) {
   SPI.transfer(addr >> 8);
   SPI.transfer(addr);
   SPI.transfer(0); //"dont care"
-  for (word i = 0; i < len; ++i)
-    ((byte*) buf)[i] = SPI.transfer(0);
+  SPI.transfer(buf, len); // the chip ignores what is shifted out while it sends the data
+  unselect();
+}
+
+/// start a sequential read at addr, the chip stays selected until readEnd()
+/// the address counter of the chip moves on by itself, so readNext() just clocks in the data
+/// IMPORTANT: the SPI bus is held (and on cores without SPI transactions interrupts are off)
+///            until readEnd(), so don't talk to other SPI devices (radio!) in between
+void SPIFlash::readStart(long addr) {
+  command(SPIFLASH_ARRAYREAD);
+  SPI.transfer(addr >> 16);
+  SPI.transfer(addr >> 8);
+  SPI.transfer(addr);
+  SPI.transfer(0); //"dont care"
+}
+
+/// read the next len bytes of a sequential read started with readStart()
+void SPIFlash::readNext(void* buf, word len) {
+  SPI.transfer(buf, len);
+}
+
+/// end a sequential read, releases the chip and the SPI bus
+void SPIFlash::readEnd() {
   unselect();
 }
 
@@ -209,25 +233,68 @@ void SPIFlash::writeByte(long addr, uint8_t byt) {
 ///
 void SPIFlash::writeBytes(long addr, const void* buf, uint16_t len) {
   uint16_t n;
-  uint16_t maxBytes = 256-(addr%256); // force the first set of bytes to stay within the first page
-  uint16_t offset = 0;
   while (len>0)
   {
-    n = (len<=maxBytes) ? len : maxBytes;
-    command(SPIFLASH_BYTEPAGEPROGRAM, true); // Byte/Page Program
-    SPI.transfer(addr >> 16);
-    SPI.transfer(addr >> 8);
-    SPI.transfer(addr);
-    for (uint16_t i = 0; i < n; i++)
-      SPI.transfer(((byte*) buf)[offset + i]);
-    unselect();
+    n = programPage(addr, (const byte*) buf, len);
     addr+=n; // adjust the addresses and remaining bytes by what we've just transferred.
-    offset +=n;
+    buf = (const byte*) buf + n;
     len -= n;
-    maxBytes = 256; // now we can do up to 256 bytes per loop
   }
 }
 
+/// start writing multiple bytes to flash memory (up to 64K) without waiting for the chip
+/// the pages are programmed one by one by writePending(), buf must stay valid (and unchanged)
+/// until writePending() returns false
+/// WARNING: you can only write to previously erased memory locations (see datasheet)
+void SPIFlash::writeBytesStart(long addr, const void* buf, uint16_t len) {
+  _writeAddr = addr;
+  _writeBuf = (const byte*) buf;
+  _writeLen = len;
+  writePending();
+}
+
+/// call this regularly after writeBytesStart(), sends the next page when the chip is done with the last one
+/// returns true while the write is in progress, never waits for the chip
+boolean SPIFlash::writePending() {
+  if (busy())
+    return true;
+  if (_writeLen == 0)
+    return false;
+  uint16_t n = programPage(_writeAddr, _writeBuf, _writeLen);
+  _writeAddr += n;
+  _writeBuf += n;
+  _writeLen -= n;
+  return true;
+}
+
+/// program as much of buf as fits into the page of addr, returns the number of bytes written
+uint16_t SPIFlash::programPage(long addr, const byte* buf, uint16_t len) {
+  uint16_t n = 256-(addr%256); // force the bytes to stay within the page
+  if (len < n)
+    n = len;
+  command(SPIFLASH_BYTEPAGEPROGRAM, true); // Byte/Page Program
+  SPI.transfer(addr >> 16);
+  SPI.transfer(addr >> 8);
+  SPI.transfer(addr);
+#if defined(SPDR) && defined(SPIF)
+  // load the next byte while the last one is shifted out, keeps the bus busy at DIV2/DIV4
+  const byte* p = buf;
+  SPDR = *p++;
+  for (uint16_t i = 1; i < n; i++)
+  {
+    byte b = *p++;
+    while (!(SPSR & _BV(SPIF)));
+    SPDR = b;
+  }
+  while (!(SPSR & _BV(SPIF)));
+#else
+  for (uint16_t i = 0; i < n; i++)
+    SPI.transfer(buf[i]);
+#endif
+  unselect();
+  return n;
+}
+
 
 /// erase entire flash memory array
 /// may take several seconds depending on size, but is non blocking
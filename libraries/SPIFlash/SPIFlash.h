@@ -80,6 +80,11 @@ public:
   void readBytes(long addr, void* buf, word len);
   void writeByte(long addr, uint8_t byt);
   void writeBytes(long addr, const void* buf, uint16_t len);
+  void writeBytesStart(long addr, const void* buf, uint16_t len);
+  boolean writePending();
+  void readStart(long addr);
+  void readNext(void* buf, word len);
+  void readEnd();
   boolean busy();
   void chipErase();
   void blockErase4K(long address);
@@ -93,11 +98,15 @@ public:
 protected:
   void select();
   void unselect();
+  uint16_t programPage(long addr, const uint8_t* buf, uint16_t len);
   uint8_t _slaveSelectPin;
   uint16_t _jedecID;
   uint8_t _SPCR;
   uint8_t _SPSR;
   uint8_t _SREG;
+  const uint8_t* _writeBuf; // source of writeBytesStart(), must stay valid while writePending()
+  long _writeAddr;
+  uint16_t _writeLen;
   
 #ifdef SPI_HAS_TRANSACTION
   SPISettings _settings;
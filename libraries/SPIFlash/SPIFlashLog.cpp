@@ -0,0 +1,225 @@
+/*
+ * Circular data log on top of the SPIFlash library.
+ *
+ * Layout of each 4K sector:
+ *   sector header: magic (2), seq of the first record (4), drained flag (1), reserved (1)
+ *   records:       length (1), drained flag (1), seq (4), data (length) ... up to the first 0xFF length
+ * Flags are 0xFF when written and programmed to 0x00 once drain() delivered the record (or every record
+ * of the sector), no erase needed for that.
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#include <SPIFlashLog.h>
+
+/// Constructor. start must be 4K aligned, the log uses sectors*4K bytes from there (at least 2 sectors)
+SPIFlashLog::SPIFlashLog(SPIFlash& flash, long start, uint16_t sectors) : _flash(flash) {
+  _start = start;
+  _sectors = sectors;
+  _empty = true;
+  _nextSeq = 1;
+}
+
+/// sequence number of the first record in sector, 0 when the sector isn't used by the log (erased)
+uint32_t SPIFlashLog::sectorSeq(uint16_t sector) {
+  uint8_t hdr[SPIFLASHLOG_SECTOR_HEADER];
+  _flash.readBytes(sectorAddr(sector), hdr, SPIFLASHLOG_SECTOR_HEADER);
+  if (hdr[0] != (SPIFLASHLOG_SECTOR_MAGIC & 0xFF) || hdr[1] != (SPIFLASHLOG_SECTOR_MAGIC >> 8))
+    return 0;
+  uint32_t seq;
+  memcpy(&seq, hdr + 2, sizeof(seq));
+  return seq;
+}
+
+/// walk the records of sector, returns the offset behind the last one
+/// with pendingOnly it stops at the first record that wasn't drained yet
+uint16_t SPIFlashLog::scanSector(uint16_t sector, boolean pendingOnly, uint32_t* lastSeq) {
+  uint8_t hdr[SPIFLASHLOG_RECORD_HEADER];
+  uint16_t offset = SPIFLASHLOG_SECTOR_HEADER;
+  while (offset + SPIFLASHLOG_RECORD_HEADER <= SPIFLASHLOG_SECTOR_SIZE)
+  {
+    _flash.readBytes(sectorAddr(sector) + offset, hdr, SPIFLASHLOG_RECORD_HEADER);
+    if (hdr[0] == 0xFF || offset + SPIFLASHLOG_RECORD_HEADER + hdr[0] > SPIFLASHLOG_SECTOR_SIZE)
+      break;
+    if (pendingOnly && hdr[1] == 0xFF)
+      break;
+    if (lastSeq)
+      memcpy(lastSeq, hdr + 2, sizeof(*lastSeq));
+    offset += SPIFLASHLOG_RECORD_HEADER + hdr[0];
+  }
+  return offset;
+}
+
+/// find the newest and oldest record and the drain position after a reset
+/// reads O(log n) sector headers plus the records of the head sector and the first sector not drained
+/// returns false if the log doesn't fit the flash chip (less than 2 sectors)
+boolean SPIFlashLog::begin() {
+  if (_sectors < 2)
+    return false;
+  _empty = true;
+  _head = _sectors - 1;
+  _headOffset = SPIFLASHLOG_SECTOR_SIZE;
+  _tail = 0;
+  _readSector = 0;
+  _readOffset = SPIFLASHLOG_SECTOR_HEADER;
+  _nextSeq = 1;
+
+  uint16_t head;
+  uint32_t first = sectorSeq(0);
+  if (first == 0)
+  {
+    if (sectorSeq(_sectors - 1) == 0)
+      return true; // nothing logged yet
+    head = _sectors - 1; // wrapped, sector 0 was being erased for the next record
+  }
+  else
+  {
+    // the sequence numbers increase from sector 0 up to the head, the sectors behind it are older or erased
+    uint16_t lo = 1;
+    uint16_t hi = _sectors;
+    while (lo < hi)
+    {
+      uint16_t mid = (lo + hi) / 2;
+      if (sectorSeq(mid) < first)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    head = lo - 1;
+  }
+
+  // the oldest sector follows the head, at most one erased sector in between (power lost while opening it)
+  _tail = head;
+  for (uint8_t i = 1; i <= 2; i++)
+  {
+    uint16_t sector = (head + i) % _sectors;
+    if (sectorSeq(sector))
+    {
+      _tail = sector;
+      break;
+    }
+  }
+  if (_tail == head && first)
+    _tail = 0; // never wrapped
+
+  _head = head;
+  _nextSeq = sectorSeq(head);
+  uint32_t lastSeq = _nextSeq - 1;
+  _headOffset = scanSector(head, false, &lastSeq);
+  _nextSeq = lastSeq + 1;
+  _empty = false;
+
+  // sectors are marked drained oldest first, so the first one that isn't can be found the same way
+  uint16_t lo = 0;
+  uint16_t hi = (head + _sectors - _tail) % _sectors; // the head sector itself is never marked
+  while (lo < hi)
+  {
+    uint16_t mid = (lo + hi) / 2;
+    if (_flash.readByte(sectorAddr((_tail + mid) % _sectors) + 6) != 0x00)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  _readSector = (_tail + lo) % _sectors;
+  _readOffset = scanSector(_readSector, true, NULL);
+  return true;
+}
+
+/// erase the whole log
+void SPIFlashLog::format() {
+  for (uint16_t i = 0; i < _sectors; i++)
+    _flash.blockErase4K(sectorAddr(i));
+  begin();
+}
+
+/// start the next sector, erases the oldest one when the ring is full
+void SPIFlashLog::openSector() {
+  uint16_t next = (_head + 1) % _sectors;
+  if (!_empty && next == _tail)
+  {
+    _tail = (_tail + 1) % _sectors;
+    if (_readSector == next)
+    {
+      // records not drained yet are lost
+      _readSector = _tail;
+      _readOffset = scanSector(_tail, true, NULL);
+    }
+  }
+  _flash.blockErase4K(sectorAddr(next));
+  uint8_t hdr[SPIFLASHLOG_SECTOR_HEADER];
+  hdr[0] = SPIFLASHLOG_SECTOR_MAGIC & 0xFF;
+  hdr[1] = SPIFLASHLOG_SECTOR_MAGIC >> 8;
+  memcpy(hdr + 2, &_nextSeq, sizeof(_nextSeq));
+  hdr[6] = 0xFF;
+  hdr[7] = 0xFF;
+  _flash.writeBytes(sectorAddr(next), hdr, SPIFLASHLOG_SECTOR_HEADER);
+  _head = next;
+  _headOffset = SPIFLASHLOG_SECTOR_HEADER;
+  _empty = false;
+}
+
+/// add a record of up to SPIFLASHLOG_MAX_RECORD bytes, returns false if it is too long
+/// takes two page programs, plus a sector erase every 4K
+boolean SPIFlashLog::append(const void* data, uint8_t len) {
+  if (len > SPIFLASHLOG_MAX_RECORD)
+    return false;
+  if (_empty || _headOffset + SPIFLASHLOG_RECORD_HEADER + len > SPIFLASHLOG_SECTOR_SIZE)
+    openSector();
+  uint8_t hdr[SPIFLASHLOG_RECORD_HEADER];
+  hdr[0] = len;
+  hdr[1] = 0xFF;
+  memcpy(hdr + 2, &_nextSeq, sizeof(_nextSeq));
+  long addr = sectorAddr(_head) + _headOffset;
+  _flash.writeBytes(addr, hdr, SPIFLASHLOG_RECORD_HEADER);
+  _flash.writeBytes(addr + SPIFLASHLOG_RECORD_HEADER, data, len);
+  _headOffset += SPIFLASHLOG_RECORD_HEADER + len;
+  _nextSeq++;
+  return true;
+}
+
+/// true if there may be records drain() didn't deliver yet
+boolean SPIFlashLog::available() {
+  return !_empty && !(_readSector == _head && _readOffset >= _headOffset);
+}
+
+/// pass up to maxRecords records to callback, oldest first, returns the number delivered
+/// delivered records are marked on the flash, so they are not sent again after a reset
+uint16_t SPIFlashLog::drain(SPIFlashLogDrain callback, uint16_t maxRecords) {
+  uint8_t data[SPIFLASHLOG_MAX_RECORD];
+  uint8_t hdr[SPIFLASHLOG_RECORD_HEADER];
+  uint16_t count = 0;
+  while (count < maxRecords && available())
+  {
+    long addr = sectorAddr(_readSector) + _readOffset;
+    boolean end = _readOffset + SPIFLASHLOG_RECORD_HEADER > SPIFLASHLOG_SECTOR_SIZE;
+    if (!end)
+    {
+      _flash.readBytes(addr, hdr, SPIFLASHLOG_RECORD_HEADER);
+      end = hdr[0] == 0xFF || _readOffset + SPIFLASHLOG_RECORD_HEADER + hdr[0] > SPIFLASHLOG_SECTOR_SIZE;
+    }
+    if (end)
+    {
+      // sector done (it can't be the head, available() stops there)
+      _flash.writeByte(sectorAddr(_readSector) + 6, 0x00);
+      _readSector = (_readSector + 1) % _sectors;
+      _readOffset = SPIFLASHLOG_SECTOR_HEADER;
+      continue;
+    }
+    uint8_t len = hdr[0];
+    if (len <= SPIFLASHLOG_MAX_RECORD) // longer ones were written with another SPIFLASHLOG_MAX_RECORD, skipped
+    {
+      uint32_t seq;
+      memcpy(&seq, hdr + 2, sizeof(seq));
+      _flash.readBytes(addr + SPIFLASHLOG_RECORD_HEADER, data, len);
+      if (!callback(seq, data, len))
+        break;
+      count++;
+    }
+    _flash.writeByte(addr + 1, 0x00);
+    _readOffset += SPIFLASHLOG_RECORD_HEADER + len;
+  }
+  return count;
+}
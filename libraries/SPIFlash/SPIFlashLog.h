@@ -0,0 +1,57 @@
+/*
+ * Circular data log on top of the SPIFlash library.
+ * Records are appended to a ring of 4K sectors, when the ring is full the oldest sector is erased.
+ * Every sector starts with a header holding the sequence number of its first record, these are
+ * increasing around the ring, so begin() finds the newest and oldest sector with a binary search.
+ * DEPENDS ON: SPIFlash library
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _SPIFLASHLOG_H_
+#define _SPIFLASHLOG_H_
+
+#include <SPIFlash.h>
+
+#define SPIFLASHLOG_SECTOR_SIZE   4096        // erase unit, one blockErase4K()
+#define SPIFLASHLOG_SECTOR_MAGIC  0x4C47      // "LG", marks a sector in use by the log
+#define SPIFLASHLOG_SECTOR_HEADER 8           // magic, seq of the first record, drained flag, reserved
+#define SPIFLASHLOG_RECORD_HEADER 6           // length, drained flag, seq
+#ifndef SPIFLASHLOG_MAX_RECORD
+#define SPIFLASHLOG_MAX_RECORD    64          // longest record, drain() keeps one on the stack
+#endif
+
+/// Called by drain() for each record, oldest first. Return false to stop, the record is
+/// then delivered again by the next drain() (ie when the radio didn't get an ack)
+typedef boolean (*SPIFlashLogDrain)(uint32_t seq, const uint8_t* data, uint8_t len);
+
+class SPIFlashLog {
+public:
+  SPIFlashLog(SPIFlash& flash, long start, uint16_t sectors);
+  boolean begin();
+  void format();
+  boolean append(const void* data, uint8_t len);
+  boolean available();
+  uint16_t drain(SPIFlashLogDrain callback, uint16_t maxRecords=0xFFFF);
+  uint32_t nextSeq() { return _nextSeq; }
+protected:
+  long sectorAddr(uint16_t sector) { return _start + (long)sector * SPIFLASHLOG_SECTOR_SIZE; }
+  uint32_t sectorSeq(uint16_t sector);
+  uint16_t scanSector(uint16_t sector, boolean pendingOnly, uint32_t* lastSeq);
+  void openSector();
+  SPIFlash& _flash;
+  long _start;
+  uint16_t _sectors;
+  uint16_t _head;                             // sector appended to
+  uint16_t _headOffset;                       // free space in the head sector starts here
+  uint16_t _tail;                             // oldest sector
+  uint16_t _readSector;                       // oldest record not drained yet
+  uint16_t _readOffset;
+  uint32_t _nextSeq;
+  boolean _empty;
+};
+
+#endif
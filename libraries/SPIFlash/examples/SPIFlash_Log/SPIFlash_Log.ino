@@ -0,0 +1,74 @@
+// **********************************************************************************
+// This sketch is an example of using the SPIFlashLog ring buffer with a Moteino
+// that has an onboard SPI Flash chip. A sample is logged every second, every
+// minute all samples not sent yet are printed (stand-in for sending them by radio).
+// The log survives a reset, samples printed before are not printed again.
+// - 'e' erases the log
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+// **********************************************************************************
+
+#include <SPIFlash.h>
+#include <SPIFlashLog.h>
+#include <SPI.h>
+
+#define SERIAL_BAUD      115200
+
+#ifdef __AVR_ATmega1284P__
+  #define FLASH_SS      23 // Moteino MEGAs have FLASH SS on D23
+#else
+  #define FLASH_SS      8 // Moteinos have FLASH SS on D8
+#endif
+
+#define LOG_START       0x10000 // keep the first 64K free (ie for wireless programming images)
+#define LOG_SECTORS     16      // 64K of samples
+
+SPIFlash flash(FLASH_SS, 0xEF30);
+SPIFlashLog flashLog(flash, LOG_START, LOG_SECTORS);
+unsigned long lastSample = 0;
+unsigned long lastUpload = 0;
+
+boolean upload(uint32_t seq, const uint8_t* data, uint8_t len) {
+  int sample;
+  memcpy(&sample, data, sizeof(sample));
+  Serial.print(seq);
+  Serial.print(": ");
+  Serial.println(sample);
+  return true; // false when the gateway didn't ack, the sample is sent again next time
+}
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  if (!flash.initialize() || !flashLog.begin())
+    Serial.println("Flash init FAIL!");
+  Serial.print("Next sample: ");
+  Serial.println(flashLog.nextSeq());
+}
+
+void loop() {
+  if (Serial.available() > 0 && Serial.read() == 'e')
+  {
+    Serial.print("Erasing log... ");
+    flashLog.format();
+    Serial.println("DONE");
+  }
+
+  if (millis() - lastSample >= 1000)
+  {
+    lastSample = millis();
+    int sample = analogRead(A0);
+    flashLog.append(&sample, sizeof(sample));
+  }
+
+  if (millis() - lastUpload >= 60000)
+  {
+    lastUpload = millis();
+    flashLog.drain(upload);
+  }
+}
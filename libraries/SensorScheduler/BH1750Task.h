@@ -0,0 +1,25 @@
+// SensorTask adapter for the BH1750 light sensor
+
+#ifndef BH1750Task_h
+#define BH1750Task_h
+
+#include <SensorScheduler.h>
+#include <BH1750.h>
+
+class BH1750Task : public SensorTask {
+ public:
+  BH1750Task(BH1750 &sensor, uint8_t mode = BH1750_ONE_TIME_HIGH_RES_MODE)
+    : lux(0), _sensor(sensor), _mode(mode) {}
+
+  bool start(void) { _sensor.start(_mode); return true; }
+  bool ready(void) { return _sensor.isReady(); }
+  bool read(void) { lux = _sensor.readLightLevel(); return true; }
+
+  uint16_t lux;
+
+ private:
+  BH1750 &_sensor;
+  uint8_t _mode;
+};
+
+#endif
@@ -0,0 +1,36 @@
+// SensorTask adapter for the Adafruit_BMP085 library, reads the
+// temperature and then the pressure
+
+#ifndef BMP085Task_h
+#define BMP085Task_h
+
+#include <SensorScheduler.h>
+#include <Adafruit_BMP085.h>
+
+class BMP085Task : public SensorTask {
+ public:
+  BMP085Task(Adafruit_BMP085 &sensor)
+    : temperature(0), pressure(0), _sensor(sensor), _phase(0) {}
+
+  bool start(void) { _phase = 0; _sensor.startTemperature(); return true; }
+  bool ready(void) { return _sensor.isReady(); }
+  bool read(void) {
+    if (_phase == 0) {
+      temperature = _sensor.getTemperature();
+      _sensor.startPressure();
+      _phase = 1;
+      return false;
+    }
+    pressure = _sensor.getPressure();
+    return true;
+  }
+
+  int16_t temperature;  // in 0.1 *C
+  int32_t pressure;     // in Pa
+
+ private:
+  Adafruit_BMP085 &_sensor;
+  uint8_t _phase;
+};
+
+#endif
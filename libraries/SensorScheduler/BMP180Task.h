@@ -0,0 +1,39 @@
+// SensorTask adapter for the SFE_BMP180 library, reads the temperature
+// and then the pressure with the integer equations
+
+#ifndef BMP180Task_h
+#define BMP180Task_h
+
+#include <SensorScheduler.h>
+#include <SFE_BMP180.h>
+
+class BMP180Task : public SensorTask {
+ public:
+  BMP180Task(SFE_BMP180 &sensor, char oversampling = 3)
+    : temperature(0), pressure(0), _sensor(sensor), _oss(oversampling),
+      _phase(0) {}
+
+  bool start(void) { _phase = 0; return _sensor.startTemperature() != 0; }
+  bool ready(void) { return _sensor.isReady(); }
+  // a failed transfer ends the task with the previous values
+  bool read(void) {
+    if (_phase == 0) {
+      _phase = 1;
+      if (_sensor.getTemperature(temperature) &&
+          _sensor.startPressure(_oss)) return false;
+      return true;
+    }
+    _sensor.getPressure(pressure);
+    return true;
+  }
+
+  int temperature;  // in 0.1 deg C
+  long pressure;    // in Pa
+
+ private:
+  SFE_BMP180 &_sensor;
+  char _oss;
+  uint8_t _phase;
+};
+
+#endif
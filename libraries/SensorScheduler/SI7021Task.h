@@ -0,0 +1,27 @@
+// SensorTask adapter for the SI7020/SI7021 humidity sensor
+
+#ifndef SI7021Task_h
+#define SI7021Task_h
+
+#include <SensorScheduler.h>
+#include <SI7021.h>
+
+class SI7021Task : public SensorTask {
+ public:
+  SI7021Task(SI7021 &sensor) : _sensor(sensor) {
+    env.celsiusHundredths = 0;
+    env.fahrenheitHundredths = 0;
+    env.humidityPercent = 0;
+  }
+
+  bool start(void) { _sensor.startHumidityAndTemperature(); return true; }
+  bool ready(void) { return _sensor.isReady(); }
+  bool read(void) { env = _sensor.getResult(); return true; }
+
+  si7021_env env;
+
+ private:
+  SI7021 &_sensor;
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*
+
+Non-blocking scheduler for I2C sensors with a measurement time.
+
+*/
+
+#include "SensorScheduler.h"
+
+
+SensorScheduler::SensorScheduler() {
+  _count = 0;
+  _pending = 0;
+}
+
+bool SensorScheduler::add(SensorTask *task) {
+
+  if (_count >= SENSOR_SCHEDULER_MAX_TASKS) return false;
+  _busy[_count] = false;
+  _tasks[_count++] = task;
+  return true;
+}
+
+uint8_t SensorScheduler::start(void) {
+
+  _pending = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    _busy[i] = _tasks[i]->start();
+    if (_busy[i]) _pending++;
+  }
+  return _pending;
+}
+
+bool SensorScheduler::poll(void) {
+
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_busy[i] && _tasks[i]->ready() && _tasks[i]->read()) {
+      _busy[i] = false;
+      _pending--;
+    }
+  }
+  return _pending == 0;
+}
+
+bool SensorScheduler::run(uint16_t timeout) {
+
+  unsigned long started = millis();
+
+  start();
+  while (!poll()) {
+    if (millis() - started >= timeout) return false;
+  }
+  return true;
+}
@@ -0,0 +1,61 @@
+/*
+
+Non-blocking scheduler for I2C sensors with a measurement time.
+
+The conversions of all added sensors are started at once and each result
+is read as soon as its sensor is ready, so a full set of readings takes
+as long as the slowest sensor instead of the sum of all of them.
+
+Drivers plug in through a SensorTask, adapters for the BH1750, SI7021,
+Adafruit_BMP085 and SFE_BMP180 libraries are in BH1750Task.h, SI7021Task.h,
+BMP085Task.h and BMP180Task.h.
+
+*/
+
+#ifndef SensorScheduler_h
+#define SensorScheduler_h
+
+#if (ARDUINO >= 100)
+#include <Arduino.h>
+#else
+#include <WProgram.h>
+#endif
+
+#ifndef SENSOR_SCHEDULER_MAX_TASKS
+#define SENSOR_SCHEDULER_MAX_TASKS 8
+#endif
+
+class SensorTask {
+ public:
+  // start a conversion, false if the sensor did not respond
+  virtual bool start(void) = 0;
+  // true once the result of the last conversion can be read
+  virtual bool ready(void) = 0;
+  // fetch the result, false if another conversion was started instead
+  // (e.g. the pressure after the temperature of a BMP sensor)
+  virtual bool read(void) = 0;
+};
+
+class SensorScheduler {
+ public:
+  SensorScheduler();
+  bool add(SensorTask *task);
+
+  // start all sensors, returns how many of them responded
+  uint8_t start(void);
+  // read the sensors that became ready, true when none is left
+  bool poll(void);
+  // start() and poll() until done or timeout ms have passed,
+  // false on timeout
+  bool run(uint16_t timeout = 1000);
+
+  bool isDone(void) { return _pending == 0; }
+
+ private:
+  SensorTask *_tasks[SENSOR_SCHEDULER_MAX_TASKS];
+  bool _busy[SENSOR_SCHEDULER_MAX_TASKS];
+  uint8_t _count;
+  uint8_t _pending;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/*
+  Reads a BH1750, a SI7021 and a BMP180 in one go. All conversions
+  run at the same time, the set is complete after the ~180ms of the
+  BH1750 instead of the ~230ms of reading them one after the other.
+*/
+
+#include <Wire.h>
+#include <BH1750.h>
+#include <SI7021.h>
+#include <SFE_BMP180.h>
+#include <SensorScheduler.h>
+#include <BH1750Task.h>
+#include <SI7021Task.h>
+#include <BMP180Task.h>
+
+BH1750 lightMeter;
+SI7021 humiditySensor;
+SFE_BMP180 pressureSensor;
+
+BH1750Task light(lightMeter);
+SI7021Task humidity(humiditySensor);
+BMP180Task pressure(pressureSensor);
+
+SensorScheduler sensors;
+
+void setup() {
+  Serial.begin(9600);
+  lightMeter.begin(BH1750_ONE_TIME_HIGH_RES_MODE);
+  humiditySensor.begin();
+  pressureSensor.begin();
+
+  sensors.add(&light);
+  sensors.add(&humidity);
+  sensors.add(&pressure);
+}
+
+void loop() {
+  sensors.start();
+  while (!sensors.poll()) {
+    // free for other work until the last sensor is read
+  }
+
+  Serial.print("Light: ");
+  Serial.print(light.lux);
+  Serial.print(" lx  Humidity: ");
+  Serial.print(humidity.env.humidityPercent);
+  Serial.print(" %  Temperature: ");
+  Serial.print(pressure.temperature / 10.0);
+  Serial.print(" C  Pressure: ");
+  Serial.print(pressure.pressure);
+  Serial.println(" Pa");
+
+  delay(5000);
+}
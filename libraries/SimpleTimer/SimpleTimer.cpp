@@ -30,60 +30,81 @@
 SimpleTimer::SimpleTimer() {
     unsigned long current_millis = millis();
 
+    timeSource = millis;
+
     for (int i = 0; i < MAX_TIMERS; i++) {
         enabled[i] = false;
         callbacks[i] = 0;                   // if the callback pointer is zero, the slot is free, i.e. doesn't "contain" any timer
         prev_millis[i] = current_millis;
         numRuns[i] = 0;
+        queuePos[i] = -1;
     }
 
     numTimers = 0;
+    queueSize = 0;
 }
 
 
 void SimpleTimer::run() {
-    int i;
+    int i, n;
+    int due[MAX_TIMERS];
+    int numDue = 0;
     unsigned long current_millis;
 
     // get current time
-    current_millis = millis();
+    current_millis = timeSource();
 
-    for (i = 0; i < MAX_TIMERS; i++) {
+    // take the timers that are due off the queue: only the head of
+    // the queue has to be compared against the current time
+    while (queueSize > 0) {
+        i = queue[0];
 
-        toBeCalled[i] = DEFCALL_DONTRUN;
+        // is it time to process this timer ?
+        if (current_millis - prev_millis[i] < (unsigned long)delays[i]) {
+            break;
+        }
+
+        queueRemove(i);
 
-        // no callback == no timer, i.e. jump over empty slots
-        if (callbacks[i]) {
+        // keep the due timers sorted by number, the order they're called in
+        for (n = numDue++; n > 0 && due[n - 1] > i; n--) {
+            due[n] = due[n - 1];
+        }
+        due[n] = i;
+    }
 
-            // is it time to process this timer ?
-            if (current_millis - prev_millis[i] >= delays[i]) {
+    for (n = 0; n < numDue; n++) {
+        i = due[n];
 
-                // update time
-                prev_millis[i] = current_millis;
+        toBeCalled[i] = DEFCALL_DONTRUN;
 
-                // check if the timer callback has to be executed
-                if (enabled[i]) {
+        // update time
+        prev_millis[i] = current_millis;
+        queueInsert(i);
 
-                    // "run forever" timers must always be executed
-                    if (maxNumRuns[i] == RUN_FOREVER) {
-                        toBeCalled[i] = DEFCALL_RUNONLY;
-                    }
-                    // other timers get executed the specified number of times
-                    else if (numRuns[i] < maxNumRuns[i]) {
-                        toBeCalled[i] = DEFCALL_RUNONLY;
-                        numRuns[i]++;
+        // check if the timer callback has to be executed
+        if (enabled[i]) {
 
-                        // after the last run, delete the timer
-                        if (numRuns[i] >= maxNumRuns[i]) {
-                            toBeCalled[i] = DEFCALL_RUNANDDEL;
-                        }
-                    }
+            // "run forever" timers must always be executed
+            if (maxNumRuns[i] == RUN_FOREVER) {
+                toBeCalled[i] = DEFCALL_RUNONLY;
+            }
+            // other timers get executed the specified number of times
+            else if (numRuns[i] < maxNumRuns[i]) {
+                toBeCalled[i] = DEFCALL_RUNONLY;
+                numRuns[i]++;
+
+                // after the last run, delete the timer
+                if (numRuns[i] >= maxNumRuns[i]) {
+                    toBeCalled[i] = DEFCALL_RUNANDDEL;
                 }
             }
         }
     }
 
-    for (i = 0; i < MAX_TIMERS; i++) {
+    for (n = 0; n < numDue; n++) {
+        i = due[n];
+
         switch(toBeCalled[i]) {
             case DEFCALL_DONTRUN:
                 break;
@@ -101,6 +122,29 @@ void SimpleTimer::run() {
 }
 
 
+unsigned long SimpleTimer::timeToNextTimer() {
+    unsigned long elapsed;
+    int i;
+
+    if (queueSize == 0) {
+        return NO_TIMER_PENDING;
+    }
+
+    i = queue[0];
+    elapsed = timeSource() - prev_millis[i];
+    if (elapsed >= (unsigned long)delays[i]) {
+        return 0;
+    }
+
+    return delays[i] - elapsed;
+}
+
+
+void SimpleTimer::setTimeSource(unsigned long (*source)(void)) {
+    timeSource = source;
+}
+
+
 // find the first available slot
 // return -1 if none found
 int SimpleTimer::findFirstFreeSlot() {
@@ -135,7 +179,8 @@ int SimpleTimer::setTimer(long d, timer_callback f, int n) {
     callbacks[freeTimer] = f;
     maxNumRuns[freeTimer] = n;
     enabled[freeTimer] = true;
-    prev_millis[freeTimer] = millis();
+    prev_millis[freeTimer] = timeSource();
+    queueInsert(freeTimer);
 
     numTimers++;
 
@@ -163,6 +208,7 @@ void SimpleTimer::deleteTimer(int numTimer) {
         return;
     }
 
+    queueRemove(numTimer);
     callbacks[numTimer] = 0;
     enabled[numTimer] = false;
     delays[numTimer] = 0;
@@ -179,7 +225,12 @@ void SimpleTimer::restartTimer(int numTimer) {
         return;
     }
 
-    prev_millis[numTimer] = millis();
+    prev_millis[numTimer] = timeSource();
+
+    // the deadline moved, put the timer back in its place
+    if (queuePos[numTimer] >= 0) {
+        queueInsert(numTimer);
+    }
 }
 
 
@@ -222,3 +273,88 @@ void SimpleTimer::toggle(int numTimer) {
 int SimpleTimer::getNumTimers() {
     return numTimers;
 }
+
+
+// deadlines are compared as a signed difference, so the queue
+// order survives the clock rollover
+boolean SimpleTimer::isBefore(int a, int b) {
+    unsigned long da = prev_millis[a] + delays[a];
+    unsigned long db = prev_millis[b] + delays[b];
+
+    return (long)(da - db) < 0;
+}
+
+
+void SimpleTimer::queuePlace(int pos, int t) {
+    queue[pos] = t;
+    queuePos[t] = pos;
+}
+
+
+void SimpleTimer::queueSiftUp(int pos) {
+    int t = queue[pos];
+    int parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (!isBefore(t, queue[parent])) {
+            break;
+        }
+        queuePlace(pos, queue[parent]);
+        pos = parent;
+    }
+    queuePlace(pos, t);
+}
+
+
+void SimpleTimer::queueSiftDown(int pos) {
+    int t = queue[pos];
+    int child;
+
+    for (;;) {
+        child = 2 * pos + 1;
+        if (child >= queueSize) {
+            break;
+        }
+        if (child + 1 < queueSize && isBefore(queue[child + 1], queue[child])) {
+            child++;
+        }
+        if (!isBefore(queue[child], t)) {
+            break;
+        }
+        queuePlace(pos, queue[child]);
+        pos = child;
+    }
+    queuePlace(pos, t);
+}
+
+
+void SimpleTimer::queueInsert(int t) {
+    if (queuePos[t] >= 0) {
+        queueRemove(t);
+    }
+
+    queuePlace(queueSize, t);
+    queueSiftUp(queueSize++);
+}
+
+
+void SimpleTimer::queueRemove(int t) {
+    int pos = queuePos[t];
+    int moved;
+
+    if (pos < 0) {
+        return;
+    }
+
+    queuePos[t] = -1;
+    if (--queueSize == pos) {
+        return;
+    }
+
+    // move the last timer into the hole and restore the heap around it
+    moved = queue[queueSize];
+    queuePlace(pos, moved);
+    queueSiftUp(pos);
+    queueSiftDown(queuePos[moved]);
+}
@@ -46,6 +46,9 @@ public:
     const static int RUN_FOREVER = 0;
     const static int RUN_ONCE = 1;
 
+    // timeToNextTimer() value when no timer is in use
+    const static unsigned long NO_TIMER_PENDING = 0xFFFFFFFFUL;
+
     // constructor
     SimpleTimer();
 
@@ -86,6 +89,16 @@ public:
     // returns the number of available timers
     int getNumAvailableTimers() { return MAX_TIMERS - numTimers; };
 
+    // returns the milliseconds until the next timer is due, 0 if one
+    // is due already or NO_TIMER_PENDING if no timer is in use.
+    // Disabled timers count too, as run() still restarts their period.
+    unsigned long timeToNextTimer();
+
+    // use another clock than millis(), e.g. MySensors nodeMillis()
+    // which keeps counting while the node sleeps.
+    // Set it before creating any timer.
+    void setTimeSource(unsigned long (*source)(void));
+
 private:
     // deferred call constants
     const static int DEFCALL_DONTRUN = 0;       // don't call the callback function
@@ -95,6 +108,17 @@ private:
     // find the first available slot
     int findFirstFreeSlot();
 
+    // clock used for all timers, millis() by default
+    unsigned long (*timeSource)(void);
+
+    // deadline queue helpers, see below
+    boolean isBefore(int a, int b);
+    void queuePlace(int pos, int t);
+    void queueSiftUp(int pos);
+    void queueSiftDown(int pos);
+    void queueInsert(int t);
+    void queueRemove(int t);
+
     // value returned by the millis() function
     // in the previous run() call
     unsigned long prev_millis[MAX_TIMERS];
@@ -117,6 +141,17 @@ private:
     // deferred function call (sort of) - N.B.: this array is only used in run()
     int toBeCalled[MAX_TIMERS];
 
+    // timers in use ordered by deadline (prev_millis + delays), soonest
+    // first, as a binary min-heap of timer numbers, so run() only has to
+    // look at the timers that are due
+    int queue[MAX_TIMERS];
+
+    // position of each timer in queue, -1 if it isn't queued
+    int queuePos[MAX_TIMERS];
+
+    // number of queued timers
+    int queueSize;
+
     // actual number of timers in use
     int numTimers;
 };
@@ -31,13 +31,15 @@
 
 static tmElements_t tm;          // a cache of time elements
 static time_t       cacheTime;   // the time the cache was updated
+static boolean      cacheValid;  // false until the cache holds a broken down time
 static time_t       syncInterval = 300;  // time sync will be attempted after this many seconds
 
 void refreshCache( time_t t){
-  if( t != cacheTime)
+  if( t != cacheTime || !cacheValid)
   {
     breakTime(t, tm); 
     cacheTime = t; 
+    cacheValid = true;
   }
 }
 
@@ -138,60 +140,38 @@ int year(time_t t) { // the year for the given time
 /* functions to convert to and from system time */
 /* These are for interfacing with time serivces and are not normally needed in a sketch */
 
-// leap year calulator expects year argument as years offset from 1970
-#define LEAP_YEAR(Y)     ( ((1970+Y)>0) && !((1970+Y)%4) && ( ((1970+Y)%100) || !((1970+Y)%400) ) )
-
-static  const uint8_t monthDays[]={31,28,31,30,31,30,31,31,30,31,30,31}; // API starts months from 1, this array starts from 0
+// Calendar conversions work on days since 1 Mar 0000, so the leap day is the last day of
+// the (shifted) year and every 400 year era has the same 146097 days. This takes a few
+// divisions instead of walking the years and months one by one.
+#define DAYS_0000_TO_1970  719468UL  // days from 1 Mar 0000 to 1 Jan 1970
+#define DAYS_PER_ERA       146097UL  // days in 400 years
  
 void breakTime(time_t time, tmElements_t &tm){
 // break the given time_t into time components
 // this is a more compact version of the C library localtime function
 // note that year is offset from 1970 !!!
 
-  uint8_t year;
-  uint8_t month, monthLength;
-  unsigned long days;
+  unsigned long days, era, doe, yoe, doy, mp, year;
   
   tm.Second = time % 60;
   time /= 60; // now it is minutes
   tm.Minute = time % 60;
   time /= 60; // now it is hours
   tm.Hour = time % 24;
-  time /= 24; // now it is days
-  tm.Wday = ((time + 4) % 7) + 1;  // Sunday is day 1 
-  
-  year = 0;  
-  days = 0;
-  while((unsigned)(days += (LEAP_YEAR(year) ? 366 : 365)) <= time) {
-    year++;
-  }
-  tm.Year = year; // year is offset from 1970 
+  days = time / 24; // now it is days
+  tm.Wday = ((days + 4) % 7) + 1;  // Sunday is day 1 
   
-  days -= LEAP_YEAR(year) ? 366 : 365;
-  time  -= days; // now it is days in this year, starting at 0
+  days += DAYS_0000_TO_1970;
+  era = days / DAYS_PER_ERA;
+  doe = days - era * DAYS_PER_ERA;                                      // day of era [0, 146096]
+  yoe = (doe - doe / 1460 + doe / 36524 - doe / (DAYS_PER_ERA - 1)) / 365; // year of era [0, 399]
+  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                        // day of year from 1 Mar [0, 365]
+  mp = (5 * doy + 2) / 153;                                             // month from March [0, 11]
+  year = era * 400 + yoe + (mp >= 10);                                  // Jan and Feb belong to the next year
   
-  days=0;
-  month=0;
-  monthLength=0;
-  for (month=0; month<12; month++) {
-    if (month==1) { // february
-      if (LEAP_YEAR(year)) {
-        monthLength=29;
-      } else {
-        monthLength=28;
-      }
-    } else {
-      monthLength = monthDays[month];
-    }
-    
-    if (time >= monthLength) {
-      time -= monthLength;
-    } else {
-        break;
-    }
-  }
-  tm.Month = month + 1;  // jan is month 1  
-  tm.Day = time + 1;     // day of month
+  tm.Year = year - 1970; // year is offset from 1970 
+  tm.Month = mp < 10 ? mp + 3 : mp - 9;  // jan is month 1  
+  tm.Day = doy - (153 * mp + 2) / 5 + 1; // day of month
 }
 
 time_t makeTime(tmElements_t &tm){   
@@ -199,26 +179,16 @@ time_t makeTime(tmElements_t &tm){
 // note year argument is offset from 1970 (see macros in time.h to convert to other formats)
 // previous version used full four digit year (or digits since 2000),i.e. 2009 was 2009 or 9
   
-  int i;
+  unsigned long year, era, yoe, doy, days;
   time_t seconds;
 
-  // seconds from 1970 till 1 jan 00:00:00 of the given year
-  seconds= tm.Year*(SECS_PER_DAY * 365);
-  for (i = 0; i < tm.Year; i++) {
-    if (LEAP_YEAR(i)) {
-      seconds +=  SECS_PER_DAY;   // add extra days for leap years
-    }
-  }
-  
-  // add days for this year, months start from 1
-  for (i = 1; i < tm.Month; i++) {
-    if ( (i == 2) && LEAP_YEAR(tm.Year)) { 
-      seconds += SECS_PER_DAY * 29;
-    } else {
-      seconds += SECS_PER_DAY * monthDays[i-1];  //monthDay array starts from 0
-    }
-  }
-  seconds+= (tm.Day-1) * SECS_PER_DAY;
+  year = tmYearToCalendar(tm.Year) - (tm.Month <= 2); // Jan and Feb count as the end of the previous year
+  era = year / 400;
+  yoe = year - era * 400;
+  doy = (153 * (tm.Month > 2 ? tm.Month - 3 : tm.Month + 9) + 2) / 5 + tm.Day - 1;
+  days = era * DAYS_PER_ERA + yoe * 365 + yoe / 4 - yoe / 100 + doy - DAYS_0000_TO_1970;
+
+  seconds = days * SECS_PER_DAY;
   seconds+= tm.Hour * SECS_PER_HOUR;
   seconds+= tm.Minute * SECS_PER_MIN;
   seconds+= tm.Second;
@@ -253,8 +223,10 @@ time_t now(){
 	  time_t t = getTimePtr();
       if( t != 0)
         setTime(t);
-      else
+      else {
+        nextSyncTime = sysTime + syncInterval; // don't retry a failed sync on every call
         Status = (Status == timeNotSet) ?  timeNotSet : timeNeedsSync;        
+      }
     }
   }  
   return sysTime;
@@ -285,6 +257,7 @@ void  setTime(int hr,int min,int sec,int dy, int mnth, int yr){
   tm.Hour = hr;
   tm.Minute = min;
   tm.Second = sec;
+  cacheValid = false; // tm no longer matches cacheTime
   setTime(makeTime(tm));
 }
 
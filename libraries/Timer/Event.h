@@ -28,6 +28,7 @@
 #define EVENT_NONE 0
 #define EVENT_EVERY 1
 #define EVENT_OSCILLATE 2
+#define EVENT_WAVEFORM 3 // oscillate on the hardware timer, see TimerWaveform.h
 
 class Event
 {
@@ -28,9 +28,17 @@
 #endif
 
 #include "Timer.h"
+#include "TimerWaveform.h"
 
 Timer::Timer(void)
 {
+	_timeSource = millis;
+	_hardware = false;
+	_queueSize = 0;
+	for (int8_t i = 0; i < MAX_NUMBER_OF_EVENTS; i++)
+	{
+		_queuePos[i] = -1;
+	}
 }
 
 int8_t Timer::every(unsigned long period, void (*callback)(), int repeatCount)
@@ -42,8 +50,9 @@ int8_t Timer::every(unsigned long period, void (*callback)(), int repeatCount)
 	_events[i].period = period;
 	_events[i].repeatCount = repeatCount;
 	_events[i].callback = callback;
-	_events[i].lastEventTime = millis();
+	_events[i].lastEventTime = _timeSource();
 	_events[i].count = 0;
+	queueInsert(i);
 	return i;
 }
 
@@ -58,6 +67,11 @@ int8_t Timer::after(unsigned long period, void (*callback)())
 }
 
 int8_t Timer::oscillate(uint8_t pin, unsigned long period, uint8_t startingValue, int repeatCount)
+{
+	return startOscillate(pin, period, startingValue, repeatCount * 2); // full cycles not transitions
+}
+
+int8_t Timer::startOscillate(uint8_t pin, unsigned long period, uint8_t startingValue, int transitions)
 {
 	int8_t i = findFreeEventIndex();
 	if (i == NO_TIMER_AVAILABLE) return NO_TIMER_AVAILABLE;
@@ -67,9 +81,19 @@ int8_t Timer::oscillate(uint8_t pin, unsigned long period, uint8_t startingValue
 	_events[i].period = period;
 	_events[i].pinState = startingValue;
 	digitalWrite(pin, startingValue);
-	_events[i].repeatCount = repeatCount * 2; // full cycles not transitions
-	_events[i].lastEventTime = millis();
+	_events[i].repeatCount = transitions;
+	_events[i].lastEventTime = _timeSource();
 	_events[i].count = 0;
+#ifdef TIMER_HAS_WAVEFORM
+	if (_hardware)
+	{
+		// Not queued, the interrupt toggles the pin
+		_events[i].eventType = EVENT_WAVEFORM;
+		TimerWaveform::start(i, pin, period * TIMER_WAVEFORM_TICKS_PER_MS, transitions);
+		return i;
+	}
+#endif
+	queueInsert(i);
 	return i;
 }
 
@@ -93,38 +117,85 @@ int8_t Timer::pulse(uint8_t pin, unsigned long period, uint8_t startingValue)
  */
 int8_t Timer::pulseImmediate(uint8_t pin, unsigned long period, uint8_t pulseValue)
 {
-	int8_t id(oscillate(pin, period, pulseValue, 1));
-	// now fix the repeat count
-	if (id >= 0 && id < MAX_NUMBER_OF_EVENTS) {
-		_events[id].repeatCount = 1;
-	}
-	return id;
+	return startOscillate(pin, period, pulseValue, 1);
 }
 
 
 void Timer::stop(int8_t id)
 {
 	if (id >= 0 && id < MAX_NUMBER_OF_EVENTS) {
+#ifdef TIMER_HAS_WAVEFORM
+		if (_events[id].eventType == EVENT_WAVEFORM) TimerWaveform::stop(id);
+#endif
 		_events[id].eventType = EVENT_NONE;
+		queueRemove(id);
 	}
 }
 
 void Timer::update(void)
 {
-	unsigned long now = millis();
+	unsigned long now = _timeSource();
 	update(now);
 }
 
 void Timer::update(unsigned long now)
 {
-	for (int8_t i = 0; i < MAX_NUMBER_OF_EVENTS; i++)
+	// Take every due event off the queue before running any of them, so a
+	// callback can stop or start events and an event runs once per update
+	int8_t due[MAX_NUMBER_OF_EVENTS];
+	int8_t numDue = 0;
+
+	while (_queueSize > 0)
+	{
+		Event &e = _events[_queue[0]];
+		if (now - e.lastEventTime < e.period) break;
+		int8_t id = _queue[0];
+		queueRemove(id);
+
+		// Keep the due events in index order, the order they always ran in
+		int8_t n = numDue++;
+		for (; n > 0 && due[n - 1] > id; n--) due[n] = due[n - 1];
+		due[n] = id;
+	}
+
+	for (int8_t n = 0; n < numDue; n++)
 	{
-		if (_events[i].eventType != EVENT_NONE)
+		int8_t i = due[n];
+		if (_events[i].eventType != EVENT_NONE && _queuePos[i] < 0)
 		{
 			_events[i].update(now);
+			if (_events[i].eventType != EVENT_NONE && _queuePos[i] < 0)
+			{
+				queueInsert(i);
+			}
 		}
 	}
 }
+
+unsigned long Timer::timeToNextEvent(void)
+{
+	return timeToNextEvent(_timeSource());
+}
+
+void Timer::setTimeSource(unsigned long (*source)(void))
+{
+	_timeSource = source;
+}
+
+void Timer::useHardwareTimer(bool enable)
+{
+	_hardware = enable;
+}
+
+unsigned long Timer::timeToNextEvent(unsigned long now)
+{
+	if (_queueSize == 0) return NO_EVENT_PENDING;
+
+	Event &e = _events[_queue[0]];
+	unsigned long elapsed = now - e.lastEventTime;
+	return elapsed >= e.period ? 0 : e.period - elapsed;
+}
+
 int8_t Timer::findFreeEventIndex(void)
 {
 	for (int8_t i = 0; i < MAX_NUMBER_OF_EVENTS; i++)
@@ -133,6 +204,79 @@ int8_t Timer::findFreeEventIndex(void)
 		{
 			return i;
 		}
+#ifdef TIMER_HAS_WAVEFORM
+		// A hardware waveform that ran its repeat count is done as well
+		if (_events[i].eventType == EVENT_WAVEFORM && !TimerWaveform::active(i))
+		{
+			_events[i].eventType = EVENT_NONE;
+			return i;
+		}
+#endif
 	}
 	return NO_TIMER_AVAILABLE;
 }
+
+// Deadlines are compared as a signed difference so the order survives the
+// clock rollover
+bool Timer::isBefore(int8_t a, int8_t b)
+{
+	unsigned long da = _events[a].lastEventTime + _events[a].period;
+	unsigned long db = _events[b].lastEventTime + _events[b].period;
+	return (long)(da - db) < 0;
+}
+
+void Timer::queuePlace(int8_t pos, int8_t id)
+{
+	_queue[pos] = id;
+	_queuePos[id] = pos;
+}
+
+void Timer::queueSiftUp(int8_t pos)
+{
+	int8_t id = _queue[pos];
+	while (pos > 0)
+	{
+		int8_t parent = (pos - 1) / 2;
+		if (!isBefore(id, _queue[parent])) break;
+		queuePlace(pos, _queue[parent]);
+		pos = parent;
+	}
+	queuePlace(pos, id);
+}
+
+void Timer::queueSiftDown(int8_t pos)
+{
+	int8_t id = _queue[pos];
+	for (;;)
+	{
+		int8_t child = 2 * pos + 1;
+		if (child >= _queueSize) break;
+		if (child + 1 < _queueSize && isBefore(_queue[child + 1], _queue[child])) child++;
+		if (!isBefore(_queue[child], id)) break;
+		queuePlace(pos, _queue[child]);
+		pos = child;
+	}
+	queuePlace(pos, id);
+}
+
+void Timer::queueInsert(int8_t id)
+{
+	if (_queuePos[id] >= 0) queueRemove(id);
+	queuePlace(_queueSize, id);
+	queueSiftUp(_queueSize++);
+}
+
+void Timer::queueRemove(int8_t id)
+{
+	int8_t pos = _queuePos[id];
+	if (pos < 0) return;
+
+	_queuePos[id] = -1;
+	if (--_queueSize == pos) return;
+
+	// Move the last entry into the hole and restore the heap around it
+	int8_t moved = _queue[_queueSize];
+	queuePlace(pos, moved);
+	queueSiftUp(pos);
+	queueSiftDown(_queuePos[moved]);
+}
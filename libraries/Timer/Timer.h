@@ -31,6 +31,9 @@
 #define TIMER_NOT_AN_EVENT (-2)
 #define NO_TIMER_AVAILABLE (-1)
 
+// Returned by timeToNextEvent() when no event is running
+#define NO_EVENT_PENDING (0xFFFFFFFFUL)
+
 class Timer
 {
 
@@ -58,9 +61,48 @@ public:
   void update(void);
   void update(unsigned long now);
 
+  /**
+   * Milliseconds until the next event is due, 0 if one is due already and
+   * NO_EVENT_PENDING if no event is running. This only looks at the head of
+   * the event queue, so it is cheap enough to call before every sleep.
+   */
+  unsigned long timeToNextEvent(void);
+  unsigned long timeToNextEvent(unsigned long now);
+
+  /**
+   * Use another clock than millis(), e.g. MySensors nodeMillis() which keeps
+   * counting while the node sleeps. Set it before starting any event.
+   */
+  void setTimeSource(unsigned long (*source)(void));
+
+  /**
+   * Hand oscillate(), pulse() and pulseImmediate() started from now on to
+   * Timer2 (AVR only, see TimerWaveform.h), so the pins toggle on time no
+   * matter how late update() gets called. Periods are then milliseconds of
+   * real time whatever the time source, and stop during power-down sleep.
+   * Takes Timer2 from MsTimer2 and tone(). Ignored where there is no Timer2.
+   */
+  void useHardwareTimer(bool enable);
+
 protected:
   Event _events[MAX_NUMBER_OF_EVENTS];
   int8_t findFreeEventIndex(void);
+  unsigned long (*_timeSource)(void);
+  bool _hardware;
+  int8_t startOscillate(uint8_t pin, unsigned long period, uint8_t startingValue, int transitions);
+
+  // Running events ordered by deadline (lastEventTime + period), soonest
+  // first, as a binary min-heap of _events indexes. _queuePos holds the heap
+  // position of every event or -1 when it is not queued.
+  int8_t _queue[MAX_NUMBER_OF_EVENTS];
+  int8_t _queuePos[MAX_NUMBER_OF_EVENTS];
+  int8_t _queueSize;
+  bool isBefore(int8_t a, int8_t b);
+  void queuePlace(int8_t pos, int8_t id);
+  void queueSiftUp(int8_t pos);
+  void queueSiftDown(int8_t pos);
+  void queueInsert(int8_t id);
+  void queueRemove(int8_t id);
 
 };
 
@@ -0,0 +1,152 @@
+/*
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+// For Arduino 1.0 and earlier
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include "Timer.h"
+#include "TimerWaveform.h"
+
+#ifdef TIMER_HAS_WAVEFORM
+
+#include <avr/interrupt.h>
+
+#define TIMER_WAVEFORM_MAX_STEP 128 // ticks, leaves 128 ticks (512us) for interrupt latency
+
+namespace TimerWaveform {
+	struct Channel {
+		volatile uint8_t *out;
+		uint8_t mask;
+		int transitions;
+		unsigned long halfPeriod;
+		long remaining; // ticks from _last to the next toggle
+	};
+	static Channel _channels[MAX_NUMBER_OF_EVENTS];
+	static volatile uint16_t _active; // bit per channel
+	static uint8_t _last; // TCNT2 at the last compare interrupt
+	static bool _running;
+}
+
+void TimerWaveform::start(uint8_t channel, uint8_t pin, unsigned long halfPeriod, int transitions)
+{
+	if (channel >= MAX_NUMBER_OF_EVENTS) return;
+	uint8_t port = digitalPinToPort(pin);
+	if (port == NOT_A_PIN) return;
+
+	uint8_t oldSREG = SREG;
+	cli();
+	if (!_running)
+	{
+		// Normal mode, free running, only the compare B interrupt
+		TCCR2A = 0;
+#if TIMER_WAVEFORM_PRESCALER == 64
+		TCCR2B = (1<<CS22);
+#elif TIMER_WAVEFORM_PRESCALER == 32
+		TCCR2B = (1<<CS21) | (1<<CS20);
+#else
+		TCCR2B = (1<<CS21);
+#endif
+		ASSR &= ~(1<<AS2);
+		_last = TCNT2;
+		_running = true;
+	}
+	Channel &c = _channels[channel];
+	c.out = portOutputRegister(port);
+	c.mask = digitalPinToBitMask(pin);
+	c.transitions = transitions == 0 ? 1 : transitions; // like Event, at least one toggle
+	c.halfPeriod = halfPeriod ? halfPeriod : 1;
+	// Count from now, _compare() takes the ticks since _last off again
+	c.remaining = c.halfPeriod + (uint8_t)(TCNT2 - _last);
+	_active |= (1 << channel);
+	TIMSK2 |= (1<<OCIE2B);
+	_compare(); // reschedule, the new pin may be the next one due
+	SREG = oldSREG;
+}
+
+void TimerWaveform::stop(uint8_t channel)
+{
+	if (channel >= MAX_NUMBER_OF_EVENTS) return;
+	uint8_t oldSREG = SREG;
+	cli();
+	_active &= ~(1 << channel);
+	if (!_active) TIMSK2 &= ~(1<<OCIE2B);
+	SREG = oldSREG;
+}
+
+bool TimerWaveform::active(uint8_t channel)
+{
+	if (channel >= MAX_NUMBER_OF_EVENTS) return false;
+	uint8_t oldSREG = SREG;
+	cli();
+	bool result = _active & (1 << channel);
+	SREG = oldSREG;
+	return result;
+}
+
+// Runs with interrupts off. The compare match comes at least every
+// TIMER_WAVEFORM_MAX_STEP ticks, so as long as the interrupt isn't held off
+// for the rest of the 256 ticks the 8 bit difference to _last is the elapsed time.
+void TimerWaveform::_compare()
+{
+	uint8_t next;
+	do
+	{
+		uint8_t now = TCNT2;
+		uint8_t elapsed = now - _last;
+		_last = now;
+
+		long soonest = TIMER_WAVEFORM_MAX_STEP;
+		for (uint8_t i = 0; i < MAX_NUMBER_OF_EVENTS; i++)
+		{
+			if (!(_active & (1 << i))) continue;
+			Channel &c = _channels[i];
+			c.remaining -= elapsed;
+			if (c.remaining <= 0)
+			{
+				*c.out ^= c.mask;
+				if (c.transitions > 0 && --c.transitions == 0)
+				{
+					_active &= ~(1 << i);
+					continue;
+				}
+				// Keep the phase, unless a whole half period was missed
+				c.remaining += c.halfPeriod;
+				if (c.remaining <= 0) c.remaining = 1;
+			}
+			if (c.remaining < soonest) soonest = c.remaining;
+		}
+		if (!_active)
+		{
+			TIMSK2 &= ~(1<<OCIE2B);
+			return;
+		}
+		next = soonest;
+		OCR2B = _last + next;
+		// Missed the match while working? Then run again instead of a full round late
+	} while ((uint8_t)(TCNT2 - _last) >= next);
+}
+
+ISR(TIMER2_COMPB_vect)
+{
+	TimerWaveform::_compare();
+}
+
+#endif
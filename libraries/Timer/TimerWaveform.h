@@ -0,0 +1,53 @@
+/*
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+/*
+ * Pin waveforms in the Timer2 compare match B interrupt, used by
+ * Timer::useHardwareTimer(). Timer2 runs free with a 4us tick (8us below
+ * 8MHz), the interrupt toggles every due pin through its port register and
+ * sets the compare register to the next transition of any pin. Owns Timer2
+ * like MsTimer2 and tone(), don't use them together.
+ */
+
+#ifndef TimerWaveform_h
+#define TimerWaveform_h
+
+#include <inttypes.h>
+
+#if defined(__AVR__) && defined(TIMSK2) && defined(OCIE2B)
+#define TIMER_HAS_WAVEFORM
+
+#if F_CPU >= 16000000UL
+#define TIMER_WAVEFORM_PRESCALER 64
+#elif F_CPU >= 8000000UL
+#define TIMER_WAVEFORM_PRESCALER 32
+#else
+#define TIMER_WAVEFORM_PRESCALER 8
+#endif
+#define TIMER_WAVEFORM_TICKS_PER_MS (F_CPU / TIMER_WAVEFORM_PRESCALER / 1000UL)
+
+namespace TimerWaveform {
+	// Toggle pin every halfPeriod ticks, transitions times (negative: forever)
+	void start(uint8_t channel, uint8_t pin, unsigned long halfPeriod, int transitions);
+	void stop(uint8_t channel);
+	bool active(uint8_t channel);
+	void _compare();
+}
+
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+//Flash two LEDs like the blink2 example, but let the processor sleep
+//instead of calling update() as fast as loop() can spin.
+//
+//timeToNextEvent() only looks at the event that is due first, so it is
+//cheap to ask before every nap. Idle mode keeps Timer0 running, so millis()
+//stays right and its 1ms tick wakes us up again; the loop goes back to
+//sleep until the next event is actually due.
+//Uses the LowPower library (ATmega328P/168 idle() signature).
+
+#include "Timer.h"
+#include "LowPower.h"
+
+const int LED1 = 8;
+const int LED2 = 9;
+const unsigned long PERIOD1 = 1000;    //one second
+const unsigned long PERIOD2 = 10000;   //ten seconds
+Timer t;
+
+void setup(void)
+{
+    pinMode(LED1, OUTPUT);
+    pinMode(LED2, OUTPUT);
+    t.oscillate(LED1, PERIOD1, HIGH);
+    t.oscillate(LED2, PERIOD2, HIGH);
+}
+
+void loop(void)
+{
+    if (t.timeToNextEvent() > 0)
+    {
+        LowPower.idle(SLEEP_FOREVER, ADC_OFF, TIMER2_OFF, TIMER1_OFF, TIMER0_ON,
+                      SPI_OFF, USART0_OFF, TWI_OFF);
+    }
+    else
+    {
+        t.update();
+    }
+}
@@ -27,18 +27,19 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <ctype.h>
 #include <stdlib.h>
 
-#define _GPRMCterm   "GPRMC"
-#define _GPGGAterm   "GPGGA"
-
 TinyGPSPlus::TinyGPSPlus()
   :  parity(0)
   ,  isChecksumTerm(false)
   ,  curSentenceType(GPS_SENTENCE_OTHER)
   ,  curTermNumber(0)
   ,  curTermOffset(0)
+  ,  curSentenceHash(_GPS_HASH_INIT)
   ,  sentenceHasFix(false)
   ,  customElts(0)
   ,  customCandidates(0)
+  ,  customCursor(0)
+  ,  ubxState(UBX_IDLE)
+  ,  ubxFrameCount(0)
   ,  encodedCharCount(0)
   ,  sentencesWithFixCount(0)
   ,  failedChecksumCount(0)
@@ -55,6 +56,12 @@ bool TinyGPSPlus::encode(char c)
 {
   ++encodedCharCount;
 
+  // 0xB5 never shows up in NMEA text, with 0x62 it starts a UBX frame
+  if (ubxState == UBX_SYNC2 && (uint8_t)c != 0x62)
+    ubxState = UBX_IDLE;
+  if (ubxState != UBX_IDLE || (uint8_t)c == 0xB5)
+    return ubxEncode((uint8_t)c);
+
   switch(c)
   {
   case ',': // term terminators
@@ -80,13 +87,18 @@ bool TinyGPSPlus::encode(char c)
     curTermNumber = curTermOffset = 0;
     parity = 0;
     curSentenceType = GPS_SENTENCE_OTHER;
+    curSentenceHash = _GPS_HASH_INIT;
     isChecksumTerm = false;
     sentenceHasFix = false;
     return false;
 
   default: // ordinary characters
     if (curTermOffset < sizeof(term) - 1)
+    {
+      if (curTermNumber == 0)
+        curSentenceHash = _GPS_HASH_STEP(curSentenceHash, c);
       term[curTermOffset++] = c;
+    }
     if (!isChecksumTerm)
       parity ^= c;
     return false;
@@ -150,6 +162,16 @@ void TinyGPSPlus::parseDegrees(const char *term, RawDegrees &deg)
   deg.negative = false;
 }
 
+// static
+// The hash encode() builds up for a sentence ID, e.g. "GPRMC"
+uint16_t TinyGPSPlus::sentenceHash(const char *name)
+{
+  uint16_t hash = _GPS_HASH_INIT;
+  for (uint8_t i = 0; name[i] && i < _GPS_MAX_FIELD_SIZE - 1; ++i)
+    hash = _GPS_HASH_STEP(hash, name[i]);
+  return hash;
+}
+
 #define COMBINE(sentence_type, term_number) (((unsigned)(sentence_type) << 5) | term_number)
 
 // Processes a just-completed term
@@ -191,8 +213,9 @@ bool TinyGPSPlus::endOfTermHandler()
       }
 
       // Commit all custom listeners of this sentence type
-      for (TinyGPSCustom *p = customCandidates; p != NULL && strcmp(p->sentenceName, customCandidates->sentenceName) == 0; p = p->next)
-         p->commit();
+      if (customCandidates != NULL)
+        for (TinyGPSCustom *p = customCandidates; isCandidate(p); p = p->next)
+          p->commit();
       return true;
     }
 
@@ -207,17 +230,44 @@ bool TinyGPSPlus::endOfTermHandler()
   // the first term determines the sentence type
   if (curTermNumber == 0)
   {
-    if (!strcmp(term, _GPRMCterm))
-      curSentenceType = GPS_SENTENCE_GPRMC;
-    else if (!strcmp(term, _GPGGAterm))
-      curSentenceType = GPS_SENTENCE_GPGGA;
-    else
-      curSentenceType = GPS_SENTENCE_OTHER;
+    // Sentences parsed into the standard objects, from GPS only (GP) or
+    // combined multi-constellation (GN) talkers
+    static const struct
+    {
+      uint16_t hash;
+      char name[6];
+      uint8_t type;
+    } sentenceTable[] =
+    {
+      { _GPS_SENTENCE_HASH('G', 'P', 'R', 'M', 'C'), "GPRMC", GPS_SENTENCE_GPRMC },
+      { _GPS_SENTENCE_HASH('G', 'N', 'R', 'M', 'C'), "GNRMC", GPS_SENTENCE_GPRMC },
+      { _GPS_SENTENCE_HASH('G', 'P', 'G', 'G', 'A'), "GPGGA", GPS_SENTENCE_GPGGA },
+      { _GPS_SENTENCE_HASH('G', 'N', 'G', 'G', 'A'), "GNGGA", GPS_SENTENCE_GPGGA },
+    };
+
+    curSentenceType = GPS_SENTENCE_OTHER;
+    for (uint8_t i = 0; i < sizeof(sentenceTable) / sizeof(sentenceTable[0]); ++i)
+      if (sentenceTable[i].hash == curSentenceHash && !strcmp(term, sentenceTable[i].name))
+      {
+        curSentenceType = sentenceTable[i].type;
+        break;
+      }
 
-    // Any custom candidates of this sentence type?
-    for (customCandidates = customElts; customCandidates != NULL && strcmp(customCandidates->sentenceName, term) < 0; customCandidates = customCandidates->next);
-    if (customCandidates != NULL && strcmp(customCandidates->sentenceName, term) > 0)
-       customCandidates = NULL;
+    // Any custom candidates of this sentence type? Only the first element of
+    // each sentence with a matching hash needs its name checked.
+    customCandidates = NULL;
+    const char *checked = NULL;
+    for (TinyGPSCustom *p = customElts; p != NULL && p->sentenceHash <= curSentenceHash; p = p->next)
+      if (p->sentenceHash == curSentenceHash && p->sentenceName != checked)
+      {
+        if (!strcmp(p->sentenceName, term))
+        {
+          customCandidates = p;
+          break;
+        }
+        checked = p->sentenceName;
+      }
+    customCursor = customCandidates;
 
     return false;
   }
@@ -271,14 +321,170 @@ bool TinyGPSPlus::endOfTermHandler()
       break;
   }
 
-  // Set custom values as needed
-  for (TinyGPSCustom *p = customCandidates; p != NULL && strcmp(p->sentenceName, customCandidates->sentenceName) == 0 && p->termNumber <= curTermNumber; p = p->next)
-    if (p->termNumber == curTermNumber)
-         p->set(term);
+  // Set custom values as needed, the cursor only ever moves forward
+  if (customCandidates != NULL)
+  {
+    while (isCandidate(customCursor) && customCursor->termNumber < curTermNumber)
+      customCursor = customCursor->next;
+    for (TinyGPSCustom *p = customCursor; isCandidate(p) && p->termNumber == curTermNumber; p = p->next)
+      p->set(term);
+  }
+
+  return false;
+}
+
+#define _UBX_CLASS_NAV 0x01
+#define _UBX_ID_NAV_PVT 0x07
+#define _UBX_NAV_PVT_LENGTH 92
+#define _UBX_MAX_LENGTH 1024 // anything longer is taken as a corrupt frame
+
+// Processes one byte of a UBX frame: B5 62 class id length(2) payload ck_a ck_b
+// Returns true if a NAV-PVT frame has just passed its checksum
+bool TinyGPSPlus::ubxEncode(uint8_t c)
+{
+  switch(ubxState)
+  {
+  case UBX_IDLE: // 0xB5
+    ubxState = UBX_SYNC2;
+    return false;
+
+  case UBX_SYNC2: // 0x62
+    ubxCkA = ubxCkB = 0;
+    ubxState = UBX_CLASS;
+    return false;
+
+  case UBX_CK_A:
+    ubxState = c == ubxCkA ? UBX_CK_B : UBX_IDLE;
+    if (ubxState == UBX_IDLE)
+      ++failedChecksumCount;
+    return false;
+
+  case UBX_CK_B:
+    ubxState = UBX_IDLE;
+    if (c != ubxCkB)
+    {
+      ++failedChecksumCount;
+      return false;
+    }
+    ++passedChecksumCount;
+    ++ubxFrameCount;
+    if (ubxClass == _UBX_CLASS_NAV && ubxId == _UBX_ID_NAV_PVT && ubxLength >= _UBX_NAV_PVT_LENGTH)
+      return ubxPvtCommit();
+    return false;
+  }
+
+  // 8 bit Fletcher checksum over class, id, length and payload
+  ubxCkA += c;
+  ubxCkB += ubxCkA;
+
+  switch(ubxState)
+  {
+  case UBX_CLASS:
+    ubxClass = c;
+    ubxState = UBX_ID;
+    break;
+
+  case UBX_ID:
+    ubxId = c;
+    ubxState = UBX_LENGTH1;
+    break;
+
+  case UBX_LENGTH1:
+    ubxLength = c;
+    ubxState = UBX_LENGTH2;
+    break;
+
+  case UBX_LENGTH2:
+    ubxLength |= (uint16_t)c << 8;
+    ubxOffset = 0;
+    if (ubxLength > _UBX_MAX_LENGTH)
+    {
+      ++failedChecksumCount;
+      ubxState = UBX_IDLE;
+    }
+    else
+      ubxState = ubxLength ? UBX_PAYLOAD : UBX_CK_A;
+    break;
+
+  case UBX_PAYLOAD:
+    ubxValue = (ubxValue >> 8) | ((uint32_t)c << 24);
+    if ((ubxOffset & 3) == 3 && ubxClass == _UBX_CLASS_NAV && ubxId == _UBX_ID_NAV_PVT)
+      ubxPvtField();
+    if (++ubxOffset == ubxLength)
+      ubxState = UBX_CK_A;
+    break;
+  }
 
   return false;
 }
 
+// Called at the end of each 4 byte group of a NAV-PVT payload, with ubxValue
+// holding the group. Values are staged like NMEA terms, ubxPvtCommit() takes
+// them over once the checksum passed.
+void TinyGPSPlus::ubxPvtField()
+{
+  uint32_t v = ubxValue;
+
+  switch(ubxOffset >> 2)
+  {
+  case 1: // year(2) month day
+    date.newDate = (v >> 24) * 10000UL + ((v >> 16) & 0xFF) * 100UL + (v & 0xFFFF) % 100;
+    break;
+  case 2: // hour min sec valid
+    time.newTime = (v & 0xFF) * 1000000UL + ((v >> 8) & 0xFF) * 10000UL + ((v >> 16) & 0xFF) * 100UL;
+    ubxValidity = v >> 24;
+    break;
+  case 4: // nano, negative while the second is still rounded up
+    if ((int32_t)v > 0)
+      time.newTime += v / 10000000UL;
+    break;
+  case 5: // fixType flags flags2 numSV
+    ubxFixType = v & 0xFF;
+    ubxFlags = (v >> 8) & 0xFF;
+    satellites.newval = v >> 24;
+    break;
+  case 6: // lon, 1e-7 degrees
+  case 7: // lat
+    {
+      RawDegrees &deg = ubxOffset >> 2 == 6 ? location.rawNewLngData : location.rawNewLatData;
+      deg.negative = (int32_t)v < 0;
+      if (deg.negative)
+        v = -v;
+      deg.deg = v / 10000000UL;
+      deg.billionths = (v % 10000000UL) * 100;
+    }
+    break;
+  case 9: // hMSL, mm
+    altitude.newval = ((int32_t)v + ((int32_t)v < 0 ? -5 : 5)) / 10;
+    break;
+  case 15: // gSpeed, mm/s to 1/100 knots
+    speed.newval = ((int32_t)v * 1000 + 2572) / 5144;
+    break;
+  case 16: // headMot, 1e-5 degrees
+    course.newval = ((int32_t)v + 500) / 1000;
+    break;
+  }
+}
+
+bool TinyGPSPlus::ubxPvtCommit()
+{
+  // gnssFixOK and a 2D, 3D or GNSS + dead reckoning fix
+  if ((ubxFlags & 0x01) && ubxFixType >= 2 && ubxFixType <= 4)
+  {
+    ++sentencesWithFixCount;
+    location.commit();
+    speed.commit();
+    course.commit();
+    altitude.commit();
+  }
+  if (ubxValidity & 0x01) // validDate
+    date.commit();
+  if (ubxValidity & 0x02) // validTime
+    time.commit();
+  satellites.commit();
+  return true;
+}
+
 /* static */
 double TinyGPSPlus::distanceBetween(double lat1, double long1, double lat2, double long2)
 {
@@ -332,6 +538,125 @@ const char *TinyGPSPlus::cardinal(double course)
   return directions[direction % 16];
 }
 
+// Distances are worked out in 1/16 meters. A 10^-7 degree of latitude on the
+// 6372795m sphere of distanceBetween() is 0.17796 of those, as 16 bit
+// fraction 11663.
+#define _GPS_E7_TO_SIXTEENTHS(d, shift) ((((d) >> (shift)) * 11663UL) >> (16 - (shift)))
+
+static uint32_t e7ToSixteenths(uint32_t d)
+{
+  // Drop low bits first where needed so the product fits 32 bits
+  if (d < 368000UL)
+    return _GPS_E7_TO_SIXTEENTHS(d, 0);
+  if (d < 5890000UL)
+    return _GPS_E7_TO_SIXTEENTHS(d, 4);
+  if (d < 94200000UL)
+    return _GPS_E7_TO_SIXTEENTHS(d, 8);
+  return _GPS_E7_TO_SIXTEENTHS(d, 14);
+}
+
+static uint16_t isqrt32(uint32_t n)
+{
+  uint32_t root = 0;
+  for (uint32_t bit = 1UL << 30; bit != 0; bit >>= 2)
+  {
+    if (n >= root + bit)
+    {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+      root >>= 1;
+  }
+  return (uint16_t)root;
+}
+
+/* static */
+// Offsets of position 2 from position 1 in 1/16 meters, north and east
+void TinyGPSPlus::projectE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2, int32_t &north, int32_t &east)
+{
+  // cos() in steps of 5 degrees, 15 bit fraction
+  static const uint16_t cosTable[] PROGMEM =
+  {
+    32767, 32642, 32269, 31650, 30791, 29697, 28377, 26841, 25101, 23170,
+    21062, 18794, 16384, 13848, 11207, 8481, 5690, 2856, 0
+  };
+
+  uint32_t meanLat = (uint32_t)abs(lat1 / 2 + lat2 / 2);
+  uint8_t step = meanLat / 50000000UL;
+  uint32_t frac = (meanLat % 50000000UL) >> 10;
+  uint16_t c = pgm_read_word(&cosTable[step]);
+  if (step < 18)
+    c -= (uint32_t)(c - pgm_read_word(&cosTable[step + 1])) * frac / (50000000UL >> 10);
+
+  // Longitudes differ by at most 180 degrees the short way round
+  uint32_t dLng = long2 > long1 ? (uint32_t)long2 - (uint32_t)long1 : (uint32_t)long1 - (uint32_t)long2;
+  bool eastward = long2 > long1;
+  if (dLng > 1800000000UL)
+  {
+    dLng = 3600000000UL - dLng;
+    eastward = !eastward;
+  }
+  dLng = (dLng >> 15) * c + (((dLng & 0x7FFF) * c) >> 15);
+
+  uint32_t dLat = lat2 > lat1 ? (uint32_t)lat2 - (uint32_t)lat1 : (uint32_t)lat1 - (uint32_t)lat2;
+  north = lat2 > lat1 ? (int32_t)e7ToSixteenths(dLat) : -(int32_t)e7ToSixteenths(dLat);
+  east = eastward ? (int32_t)e7ToSixteenths(dLng) : -(int32_t)e7ToSixteenths(dLng);
+}
+
+/* static */
+uint32_t TinyGPSPlus::distanceBetweenE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2)
+{
+  // returns distance in meters, see projectE7()
+  int32_t north, east;
+  projectE7(lat1, long1, lat2, long2, north, east);
+
+  uint32_t x = (uint32_t)abs(east);
+  uint32_t y = (uint32_t)abs(north);
+  uint8_t shift = 0;
+  while (x > 46340UL || y > 46340UL) // keep x*x + y*y within 32 bits
+  {
+    x >>= 1;
+    y >>= 1;
+    ++shift;
+  }
+  return (((uint32_t)isqrt32(x * x + y * y) << shift) + 8) >> 4;
+}
+
+/* static */
+uint16_t TinyGPSPlus::courseToE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2)
+{
+  // returns course in whole degrees (North=0, West=270), see projectE7()
+  int32_t north, east;
+  projectE7(lat1, long1, lat2, long2, north, east);
+
+  uint32_t x = (uint32_t)abs(east);
+  uint32_t y = (uint32_t)abs(north);
+  if (x == 0 && y == 0)
+    return 0;
+
+  // atan(z) for z = min / max in [0, 1], in hundredths of a degree:
+  // 45z + 15.66z(1 - z), z with a 15 bit fraction
+  uint32_t hi = x > y ? x : y;
+  uint32_t lo = x > y ? y : x;
+  while (hi > 131071UL) // lo << 15 must fit 32 bits
+  {
+    hi >>= 1;
+    lo >>= 1;
+  }
+  uint32_t z = (lo << 15) / hi;
+  uint32_t angle = (4500UL * z + ((1566UL * z >> 15) * (32768UL - z))) >> 15;
+
+  // angle from the north/south axis, then into the right quadrant
+  if (x > y)
+    angle = 9000 - angle;
+  if (north < 0)
+    angle = 18000 - angle;
+  if (east < 0)
+    angle = 36000 - angle;
+  return (uint16_t)(((angle + 50) / 100) % 360);
+}
+
 void TinyGPSLocation::commit()
 {
    rawLatData = rawNewLatData;
@@ -357,6 +682,20 @@ double TinyGPSLocation::lat()
    return rawLatData.negative ? -ret : ret;
 }
 
+int32_t TinyGPSLocation::latE7()
+{
+   updated = false;
+   int32_t ret = rawLatData.deg * 10000000L + (rawLatData.billionths + 50) / 100;
+   return rawLatData.negative ? -ret : ret;
+}
+
+int32_t TinyGPSLocation::lngE7()
+{
+   updated = false;
+   int32_t ret = rawLngData.deg * 10000000L + (rawLngData.billionths + 50) / 100;
+   return rawLngData.negative ? -ret : ret;
+}
+
 double TinyGPSLocation::lng()
 {
    updated = false;
@@ -488,9 +827,27 @@ void TinyGPSCustom::set(const char *term)
 void TinyGPSPlus::insertCustom(TinyGPSCustom *pElt, const char *sentenceName, int termNumber)
 {
    TinyGPSCustom **ppelt;
+   uint16_t hash = sentenceHash(sentenceName);
+
+   // Elements of the same sentence share one name pointer, which then marks
+   // their run in the list
+   for (TinyGPSCustom *p = customElts; p != NULL; p = p->next)
+      if (p->sentenceHash == hash && !strcmp(p->sentenceName, sentenceName))
+      {
+         sentenceName = p->sentenceName;
+         break;
+      }
+   pElt->sentenceName = sentenceName;
+   pElt->sentenceHash = hash;
 
    for (ppelt = &this->customElts; *ppelt != NULL; ppelt = &(*ppelt)->next)
    {
+      if (hash != (*ppelt)->sentenceHash)
+      {
+         if (hash < (*ppelt)->sentenceHash)
+            break;
+         continue;
+      }
       int cmp = strcmp(sentenceName, (*ppelt)->sentenceName);
       if (cmp < 0 || (cmp == 0 && termNumber < (*ppelt)->termNumber))
          break;
@@ -40,6 +40,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define _GPS_FEET_PER_METER 3.2808399
 #define _GPS_MAX_FIELD_SIZE 15
 
+// Sentence IDs are hashed while they arrive, so finding the sentence (and the
+// custom elements listening to it) costs integer compares instead of strcmp()s
+#define _GPS_HASH_INIT 5381
+#define _GPS_HASH_STEP(h, c) ((uint16_t)(((uint16_t)(h) * 33) ^ (uint8_t)(c)))
+#define _GPS_SENTENCE_HASH(a, b, c, d, e) \
+  _GPS_HASH_STEP(_GPS_HASH_STEP(_GPS_HASH_STEP(_GPS_HASH_STEP(_GPS_HASH_STEP(_GPS_HASH_INIT, a), b), c), d), e)
+
 struct RawDegrees
 {
    uint16_t deg;
@@ -61,6 +68,8 @@ public:
    const RawDegrees &rawLng()     { updated = false; return rawLngData; }
    double lat();
    double lng();
+   int32_t latE7();   // degrees * 10^7, no floating point
+   int32_t lngE7();
 
    TinyGPSLocation() : valid(false), updated(false)
    {}
@@ -206,6 +215,7 @@ private:
    unsigned long lastCommitTime;
    bool valid, updated;
    const char *sentenceName;
+   uint16_t sentenceHash;
    int termNumber;
    friend class TinyGPSPlus;
    TinyGPSCustom *next;
@@ -215,7 +225,7 @@ class TinyGPSPlus
 {
 public:
   TinyGPSPlus();
-  bool encode(char c); // process one character received from GPS
+  bool encode(char c); // process one character received from GPS (NMEA or UBX)
   TinyGPSPlus &operator << (char c) {encode(c); return *this;}
 
   TinyGPSLocation location;
@@ -233,13 +243,23 @@ public:
   static double courseTo(double lat1, double long1, double lat2, double long2);
   static const char *cardinal(double course);
 
+  // Integer only versions of distanceBetween() and courseTo(), positions in
+  // degrees * 10^7 as returned by latE7()/lngE7(). They treat the earth as
+  // flat around the two points (equirectangular projection). Distances
+  // come out within a meter or 0.2% of distanceBetween(), courses within
+  // a degree of courseTo() over a few tens of km, plenty for geofences.
+  static uint32_t distanceBetweenE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2);
+  static uint16_t courseToE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2);
+
   static int32_t parseDecimal(const char *term);
   static void parseDegrees(const char *term, RawDegrees &deg);
+  static uint16_t sentenceHash(const char *name);
 
   uint32_t charsProcessed()   const { return encodedCharCount; }
   uint32_t sentencesWithFix() const { return sentencesWithFixCount; }
   uint32_t failedChecksum()   const { return failedChecksumCount; }
   uint32_t passedChecksum()   const { return passedChecksumCount; }
+  uint32_t ubxFrames()        const { return ubxFrameCount; }
 
 private:
   enum {GPS_SENTENCE_GPGGA, GPS_SENTENCE_GPRMC, GPS_SENTENCE_OTHER};
@@ -251,14 +271,31 @@ private:
   uint8_t curSentenceType;
   uint8_t curTermNumber;
   uint8_t curTermOffset;
+  uint16_t curSentenceHash;
   bool sentenceHasFix;
 
   // custom element support
+  // customElts is sorted by sentence hash, then sentence, then term number,
+  // so the elements of one sentence form a run starting at customCandidates.
+  // customCursor walks that run along with the terms.
   friend class TinyGPSCustom;
   TinyGPSCustom *customElts;
   TinyGPSCustom *customCandidates;
+  TinyGPSCustom *customCursor;
+  bool isCandidate(const TinyGPSCustom *p) const
+    { return p != NULL && p->sentenceName == customCandidates->sentenceName; }
   void insertCustom(TinyGPSCustom *pElt, const char *sentenceName, int index);
 
+  // ublox binary (UBX) parsing state, only NAV-PVT frames are decoded
+  enum {UBX_IDLE, UBX_SYNC2, UBX_CLASS, UBX_ID, UBX_LENGTH1, UBX_LENGTH2, UBX_PAYLOAD, UBX_CK_A, UBX_CK_B};
+  uint8_t ubxState;
+  uint8_t ubxClass, ubxId;
+  uint16_t ubxLength, ubxOffset;
+  uint8_t ubxCkA, ubxCkB;
+  uint32_t ubxValue; // last four payload bytes, little endian
+  uint8_t ubxValidity, ubxFixType, ubxFlags;
+  uint32_t ubxFrameCount;
+
   // statistics
   uint32_t encodedCharCount;
   uint32_t sentencesWithFixCount;
@@ -268,6 +305,10 @@ private:
   // internal utilities
   int fromHex(char a);
   bool endOfTermHandler();
+  bool ubxEncode(uint8_t c);
+  void ubxPvtField();
+  bool ubxPvtCommit();
+  static void projectE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2, int32_t &north, int32_t &east);
 };
 
 #endif // def(__TinyGPSPlus_h)
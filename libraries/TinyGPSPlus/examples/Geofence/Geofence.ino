@@ -0,0 +1,67 @@
+#include <TinyGPS++.h>
+#include <SoftwareSerial.h>
+/*
+   This sample sketch checks every new fix against a list of circular
+   geofences using the integer-only latE7()/lngE7() and distanceBetweenE7(),
+   which is much quicker on AVR than lat()/lng() and distanceBetween().
+   It requires the use of SoftwareSerial, and assumes that you have a
+   4800-baud serial GPS device hooked up on pins 4(rx) and 3(tx).
+*/
+static const int RXPin = 4, TXPin = 3;
+static const uint32_t GPSBaud = 4800;
+
+struct Fence
+{
+  const char *name;
+  int32_t latE7, lngE7; // center, degrees * 10^7
+  uint32_t radius;      // meters
+};
+
+static const Fence fences[] =
+{
+  { "Home",    481173000L,  115166667L, 150 },
+  { "Office",  481351000L,  115820000L, 300 },
+  { "Airport", 483538000L,  117861000L, 3000 },
+};
+static const int numFences = sizeof(fences) / sizeof(fences[0]);
+
+// The TinyGPS++ object
+TinyGPSPlus gps;
+
+// The serial connection to the GPS device
+SoftwareSerial ss(RXPin, TXPin);
+
+void setup()
+{
+  Serial.begin(115200);
+  ss.begin(GPSBaud);
+
+  Serial.println(F("Geofence.ino"));
+  Serial.println(F("Checking fixes against a list of geofences"));
+  Serial.println();
+}
+
+void loop()
+{
+  while (ss.available() > 0)
+    gps.encode(ss.read());
+
+  if (gps.location.isUpdated())
+  {
+    int32_t lat = gps.location.latE7();
+    int32_t lng = gps.location.lngE7();
+
+    for (int i = 0; i < numFences; ++i)
+    {
+      uint32_t distance = TinyGPSPlus::distanceBetweenE7(lat, lng, fences[i].latE7, fences[i].lngE7);
+      if (distance <= fences[i].radius)
+      {
+        Serial.print(F("Inside "));
+        Serial.print(fences[i].name);
+        Serial.print(F(", "));
+        Serial.print(distance);
+        Serial.println(F("m from the center"));
+      }
+    }
+  }
+}
@@ -0,0 +1,54 @@
+#include <TinyGPS++.h>
+#include <SoftwareSerial.h>
+/*
+   This sample sketch switches a ublox receiver (protocol 15 or later, e.g. NEO-M8)
+   to the binary UBX-NAV-PVT message. TinyGPS++ decodes it into the same objects
+   as NMEA, from about a third of the bytes. Note that NAV-PVT has no HDOP.
+   It requires the use of SoftwareSerial, and assumes that you have a
+   9600-baud ublox device hooked up on pins 4(rx) and 3(tx).
+*/
+static const int RXPin = 4, TXPin = 3;
+static const uint32_t GPSBaud = 9600;
+
+// UBX-CFG-MSG: output NAV-PVT once per navigation solution on the current port
+static const uint8_t enableNavPvt[] PROGMEM =
+  { 0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x07, 0x01, 0x13, 0x51 };
+
+// The TinyGPS++ object
+TinyGPSPlus gps;
+
+// The serial connection to the GPS device
+SoftwareSerial ss(RXPin, TXPin);
+
+void setup()
+{
+  Serial.begin(115200);
+  ss.begin(GPSBaud);
+
+  Serial.println(F("UbxExample.ino"));
+  Serial.println(F("Decoding ublox NAV-PVT frames with TinyGPS++"));
+  Serial.println();
+
+  for (uint8_t i = 0; i < sizeof(enableNavPvt); ++i)
+    ss.write(pgm_read_byte(&enableNavPvt[i]));
+}
+
+void loop()
+{
+  // encode() takes NMEA and UBX bytes alike, it returns true after each
+  // good sentence or frame
+  while (ss.available() > 0)
+    if (gps.encode(ss.read()) && gps.location.isUpdated())
+    {
+      Serial.print(F("Location: "));
+      Serial.print(gps.location.lat(), 7);
+      Serial.print(F(","));
+      Serial.print(gps.location.lng(), 7);
+      Serial.print(F("  Speed: "));
+      Serial.print(gps.speed.kmph());
+      Serial.print(F(" km/h  Satellites: "));
+      Serial.print(gps.satellites.value());
+      Serial.print(F("  UBX frames: "));
+      Serial.println(gps.ubxFrames());
+    }
+}
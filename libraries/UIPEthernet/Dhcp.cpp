@@ -7,12 +7,16 @@
 #include "Arduino.h"
 #include "utility/util.h"
 
+// returned by poll_DHCP_lease() while the exchange with the server goes on
+#define DHCP_LEASE_PENDING (-1)
+
 int DhcpClass::beginWithDHCP(uint8_t *mac, unsigned long timeout, unsigned long responseTimeout)
 {
     _dhcpLeaseTime=0;
     _dhcpT1=0;
     _dhcpT2=0;
     _lastCheck=0;
+    _dhcpCheck=0;
     _timeout = timeout;
     _responseTimeout = responseTimeout;
 
@@ -33,10 +37,19 @@ void DhcpClass::reset_DHCP_lease(){
 //return:0 on error, 1 if request is sent and response is received
 int DhcpClass::request_DHCP_lease(){
     
-    uint8_t messageType = 0;
-  
-    
-  
+    int result = start_DHCP_lease();
+
+    while (result == DHCP_LEASE_PENDING)
+    {
+        result = poll_DHCP_lease();
+    }
+
+    return result;
+}
+
+//return:0 if there is no socket, else DHCP_LEASE_PENDING
+int DhcpClass::start_DHCP_lease(){
+
     // Pick an initial transaction ID
     _dhcpTransactionId = random(1UL, 2000UL);
     _dhcpInitialTransactionId = _dhcpTransactionId;
@@ -50,78 +63,96 @@ int DhcpClass::request_DHCP_lease(){
     
     presend_DHCP();
     
-    int result = 0;
-    
-    unsigned long startTime = millis();
-    
-    while(_dhcp_state != STATE_DHCP_LEASED)
+    _requestStart = millis();
+
+    return DHCP_LEASE_PENDING;
+}
+
+//one step of the exchange started by start_DHCP_lease(), does not wait for a response
+//return:0 on error (timeout), 1 if the lease is acquired, DHCP_LEASE_PENDING else
+int DhcpClass::poll_DHCP_lease(){
+
+    uint8_t messageType = 0;
+
+    int result = DHCP_LEASE_PENDING;
+
+    unsigned long startTime = _requestStart;
+
+    if(_dhcp_state == STATE_DHCP_START)
     {
-        if(_dhcp_state == STATE_DHCP_START)
+        _dhcpTransactionId++;
+        
+        send_DHCP_MESSAGE(DHCP_DISCOVER, ((millis() - startTime) / 1000));
+        _dhcp_state = STATE_DHCP_DISCOVER;
+        _responseStart = millis();
+    }
+    else if(_dhcp_state == STATE_DHCP_REREQUEST){
+        _dhcpTransactionId++;
+        send_DHCP_MESSAGE(DHCP_REQUEST, ((millis() - startTime)/1000));
+        _dhcp_state = STATE_DHCP_REQUEST;
+        _responseStart = millis();
+    }
+    else if(_dhcp_state == STATE_DHCP_DISCOVER)
+    {
+        uint32_t respId;
+        messageType = parseDHCPResponse(_responseTimeout, respId);
+        if(messageType == DHCP_OFFER)
         {
-            _dhcpTransactionId++;
-            
-            send_DHCP_MESSAGE(DHCP_DISCOVER, ((millis() - startTime) / 1000));
-            _dhcp_state = STATE_DHCP_DISCOVER;
-        }
-        else if(_dhcp_state == STATE_DHCP_REREQUEST){
-            _dhcpTransactionId++;
-            send_DHCP_MESSAGE(DHCP_REQUEST, ((millis() - startTime)/1000));
+            // We'll use the transaction ID that the offer came with,
+            // rather than the one we were up to
+            _dhcpTransactionId = respId;
+            send_DHCP_MESSAGE(DHCP_REQUEST, ((millis() - startTime) / 1000));
             _dhcp_state = STATE_DHCP_REQUEST;
+            _responseStart = millis();
         }
-        else if(_dhcp_state == STATE_DHCP_DISCOVER)
+    }
+    else if(_dhcp_state == STATE_DHCP_REQUEST)
+    {
+        uint32_t respId;
+        messageType = parseDHCPResponse(_responseTimeout, respId);
+        if(messageType == DHCP_ACK)
         {
-            uint32_t respId;
-            messageType = parseDHCPResponse(_responseTimeout, respId);
-            if(messageType == DHCP_OFFER)
-            {
-                // We'll use the transaction ID that the offer came with,
-                // rather than the one we were up to
-                _dhcpTransactionId = respId;
-                send_DHCP_MESSAGE(DHCP_REQUEST, ((millis() - startTime) / 1000));
-                _dhcp_state = STATE_DHCP_REQUEST;
+            _dhcp_state = STATE_DHCP_LEASED;
+            result = 1;
+            //use default lease time if we didn't get it
+            if(_dhcpLeaseTime == 0){
+                _dhcpLeaseTime = DEFAULT_LEASE;
             }
-        }
-        else if(_dhcp_state == STATE_DHCP_REQUEST)
-        {
-            uint32_t respId;
-            messageType = parseDHCPResponse(_responseTimeout, respId);
-            if(messageType == DHCP_ACK)
-            {
-                _dhcp_state = STATE_DHCP_LEASED;
-                result = 1;
-                //use default lease time if we didn't get it
-                if(_dhcpLeaseTime == 0){
-                    _dhcpLeaseTime = DEFAULT_LEASE;
-                }
-                //calculate T1 & T2 if we didn't get it
-                if(_dhcpT1 == 0){
-                    //T1 should be 50% of _dhcpLeaseTime
-                    _dhcpT1 = _dhcpLeaseTime >> 1;
-                }
-                if(_dhcpT2 == 0){
-                    //T2 should be 87.5% (7/8ths) of _dhcpLeaseTime
-                    _dhcpT2 = _dhcpT1 << 1;
-                }
-                _renewInSec = _dhcpT1;
-                _rebindInSec = _dhcpT2;
+            //calculate T1 & T2 if we didn't get it
+            if(_dhcpT1 == 0){
+                //T1 should be 50% of _dhcpLeaseTime
+                _dhcpT1 = _dhcpLeaseTime >> 1;
             }
-            else if(messageType == DHCP_NAK)
-                _dhcp_state = STATE_DHCP_START;
+            if(_dhcpT2 == 0){
+                //T2 should be 87.5% (7/8ths) of _dhcpLeaseTime
+                _dhcpT2 = _dhcpT1 << 1;
+            }
+            _renewInSec = _dhcpT1;
+            _rebindInSec = _dhcpT2;
         }
-        
-        if(messageType == 255)
-        {
-            messageType = 0;
+        else if(messageType == DHCP_NAK)
             _dhcp_state = STATE_DHCP_START;
-        }
-        
-        if(result != 1 && ((millis() - startTime) > _timeout))
-            break;
     }
     
-    // We're done with the socket now
-    _dhcpUdpSocket.stop();
-    _dhcpTransactionId++;
+    if(messageType == 255)
+    {
+        messageType = 0;
+        _dhcp_state = STATE_DHCP_START;
+    }
+    
+    if(result != 1 && ((millis() - startTime) > _timeout))
+    {
+        result = 0;
+        //start over, also allows a rebind after a renew that failed
+        _dhcp_state = STATE_DHCP_START;
+    }
+    
+    if (result != DHCP_LEASE_PENDING)
+    {
+        // We're done with the socket now
+        _dhcpUdpSocket.stop();
+        _dhcpTransactionId++;
+    }
 
     return result;
 }
@@ -253,15 +284,14 @@ uint8_t DhcpClass::parseDHCPResponse(unsigned long responseTimeout, uint32_t& tr
     uint8_t type = 0;
     uint8_t opt_len = 0;
      
-    unsigned long startTime = millis();
-
-    while(_dhcpUdpSocket.parsePacket() <= 0)
+    // the response is waited for since the message was sent, without blocking
+    if(_dhcpUdpSocket.parsePacket() <= 0)
     {
-        if((millis() - startTime) > responseTimeout)
+        if((millis() - _responseStart) > responseTimeout)
         {
             return 255;
         }
-        delay(50);
+        return 0;
     }
     // start reading in the packet
     RIP_MSG_FIXED fixedMsg;
@@ -419,18 +449,34 @@ int DhcpClass::checkLease(){
                 _rebindInSec -= factor;
         }
 
-        //if we have a lease but should renew, do it
-        if (_dhcp_state == STATE_DHCP_LEASED && _renewInSec <=0){
-            _dhcp_state = STATE_DHCP_REREQUEST;
-            rc = 1 + request_DHCP_lease();
+        //a renew or rebind is going on, advance it by one step
+        if (_dhcpCheck != DHCP_CHECK_NONE){
+            int result = poll_DHCP_lease();
+            if (result != DHCP_LEASE_PENDING){
+                rc = _dhcpCheck + result;
+                _dhcpCheck = DHCP_CHECK_NONE;
+            }
         }
+        else{
+            //if we have a lease but should renew, do it
+            if (_dhcp_state == STATE_DHCP_LEASED && _renewInSec <=0){
+                _dhcp_state = STATE_DHCP_REREQUEST;
+                _dhcpCheck = DHCP_CHECK_RENEW_FAIL;
+            }
 
-        //if we have a lease or is renewing but should bind, do it
-        if( (_dhcp_state == STATE_DHCP_LEASED || _dhcp_state == STATE_DHCP_START) && _rebindInSec <=0){
-            //this should basically restart completely
-            _dhcp_state = STATE_DHCP_START;
-            reset_DHCP_lease();
-            rc = 3 + request_DHCP_lease();
+            //if we have a lease or is renewing but should bind, do it
+            if( (_dhcp_state == STATE_DHCP_LEASED || _dhcp_state == STATE_DHCP_START) && _rebindInSec <=0){
+                //this should basically restart completely
+                _dhcp_state = STATE_DHCP_START;
+                reset_DHCP_lease();
+                _dhcpCheck = DHCP_CHECK_REBIND_FAIL;
+            }
+
+            //the exchange runs in the following calls, rc is reported when it is done
+            if (_dhcpCheck != DHCP_CHECK_NONE && start_DHCP_lease() != DHCP_LEASE_PENDING){
+                rc = _dhcpCheck;
+                _dhcpCheck = DHCP_CHECK_NONE;
+            }
         }
     }
     else{
@@ -154,10 +154,15 @@ private:
   unsigned long _timeout;
   unsigned long _responseTimeout;
   unsigned long _secTimeout;
+  unsigned long _requestStart;
+  unsigned long _responseStart;
   uint8_t _dhcp_state;
+  uint8_t _dhcpCheck;
   UIPUDP _dhcpUdpSocket;
   
   int request_DHCP_lease();
+  int start_DHCP_lease();
+  int poll_DHCP_lease();
   void reset_DHCP_lease();
   void presend_DHCP();
   void send_DHCP_MESSAGE(uint8_t, uint16_t);
@@ -173,6 +178,8 @@ public:
   
   int beginWithDHCP(uint8_t *, unsigned long timeout = 60000, unsigned long responseTimeout = 4000);
   int checkLease();
+  // a renew or rebind is in progress
+  bool pending() { return _dhcpCheck != DHCP_CHECK_NONE; }
 };
 
 #endif
@@ -47,8 +47,103 @@
 #define TRUNCATED        -3
 #define INVALID_RESPONSE -4
 
+// Wait this long for an answer before the request is sent again
+#define DNS_TIMEOUT 5000
+#define DNS_RETRIES 3
+
+#if UIP_DNS_CACHE_SIZE > 0
+// Answers shared by all DNSClient instances, kept until their TTL (at most
+// UIP_DNS_MAX_TTL seconds) runs out. The hash finds the entry, the stored
+// name rules out a collision. Longer names are not cached
+static struct
+{
+    uint32_t name;
+    unsigned long expires;
+    uint8_t address[4];
+    char host[UIP_DNS_CACHE_NAME_LEN+1];
+} dns_cache[UIP_DNS_CACHE_SIZE];
+
+static bool cacheLookup(uint32_t aHash, const char* aName, IPAddress& aResult)
+{
+    for (uint8_t i = 0; i < UIP_DNS_CACHE_SIZE; i++)
+    {
+        if (dns_cache[i].name == aHash && strcasecmp(dns_cache[i].host, aName) == 0)
+        {
+            if ((long)(dns_cache[i].expires - millis()) > 0)
+            {
+                aResult = IPAddress(dns_cache[i].address);
+                return true;
+            }
+            dns_cache[i].name = 0;
+        }
+    }
+    return false;
+}
+
+static void cacheStore(uint32_t aHash, const char* aName, IPAddress& aAddress, uint32_t aTTL)
+{
+    if (aTTL == 0 || !aName || strlen(aName) > UIP_DNS_CACHE_NAME_LEN)
+    {
+        return;
+    }
+    if (aTTL > UIP_DNS_MAX_TTL)
+    {
+        aTTL = UIP_DNS_MAX_TTL;
+    }
+    // replace the entry for the name, a free one or the one expiring first
+    uint8_t slot = 0;
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < UIP_DNS_CACHE_SIZE; i++)
+    {
+        if ((dns_cache[i].name == aHash && strcasecmp(dns_cache[i].host, aName) == 0) ||
+            dns_cache[i].name == 0 ||
+            (long)(dns_cache[i].expires - now) <= 0)
+        {
+            slot = i;
+            break;
+        }
+        if ((long)(dns_cache[i].expires - dns_cache[slot].expires) < 0)
+        {
+            slot = i;
+        }
+    }
+    dns_cache[slot].name = aHash;
+    dns_cache[slot].expires = now + aTTL * 1000;
+    memcpy(dns_cache[slot].address, aAddress.raw_address(), 4);
+    strcpy(dns_cache[slot].host, aName);
+}
+#endif
+
+// FNV-1a, names are compared case insensitive
+static uint32_t hostHash(const char* aName)
+{
+    uint32_t hash = 2166136261UL;
+    while (*aName)
+    {
+        char c = *aName++;
+        if (c >= 'A' && c <= 'Z')
+        {
+            c += 'a' - 'A';
+        }
+        hash = (hash ^ (uint8_t)c) * 16777619UL;
+    }
+    // 0 marks a free cache entry
+    return hash ? hash : 1;
+}
+
+DNSClient::DNSClient() :
+    iHostname(NULL)
+{
+}
+
 void DNSClient::begin(const IPAddress& aDNSServer)
 {
+    if (iHostname)
+    {
+        // drop a lookup sent to the old server
+        iUdp.stop();
+        iHostname = NULL;
+    }
     iDNSServer = aDNSServer;
     iRequestId = 0;
 }
@@ -116,7 +211,18 @@ int DNSClient::inet_aton(const char* aIPAddrString, IPAddress& aResult)
 
 int DNSClient::getHostByName(const char* aHostname, IPAddress& aResult)
 {
-    int ret =0;
+    int ret;
+
+    // parsePacket() in poll() keeps the stack running while we wait
+    while ((ret = resolve(aHostname, aResult)) == DNS_PENDING)
+        ;
+
+    return ret;
+}
+
+int DNSClient::resolve(const char* aHostname, IPAddress& aResult)
+{
+    int ret;
 
     // See if it's a numeric IP address
     if (inet_aton(aHostname, aResult))
@@ -125,52 +231,136 @@ int DNSClient::getHostByName(const char* aHostname, IPAddress& aResult)
         return 1;
     }
 
+    uint32_t hash = hostHash(aHostname);
+#if UIP_DNS_CACHE_SIZE > 0
+    if (cacheLookup(hash, aHostname, aResult))
+    {
+        return 1;
+    }
+#endif
+
+    if (iHostname)
+    {
+        poll();
+        if (iHostHash == hash && strcasecmp(iHostname, aHostname) == 0)
+        {
+            if (iResult == DNS_PENDING)
+            {
+                return DNS_PENDING;
+            }
+            // Our lookup is done, hand out the result
+            iHostname = NULL;
+            if (iResult == SUCCESS)
+            {
+                aResult = iAddress;
+            }
+            return iResult;
+        }
+        if (iResult == DNS_PENDING)
+        {
+            // Wait for the lookup of the other name to finish
+            return DNS_PENDING;
+        }
+    }
+
     // Check we've got a valid DNS server to use
     if (iDNSServer == INADDR_NONE)
     {
         return INVALID_SERVER;
     }
-	
+
     // Find a socket to use
-    if (iUdp.begin(1024+(millis() & 0xF)) == 1)
+    if (iUdp.begin(1024+(millis() & 0xF)) != 1)
     {
-        // Try up to three times
-        int retries = 0;
-//        while ((retries < 3) && (ret <= 0))
-        {
-            // Send DNS request
-            ret = iUdp.beginPacket(iDNSServer, DNS_PORT);
-            if (ret != 0)
+        return 0;
+    }
+    iHostname = aHostname;
+    iHostHash = hash;
+    iRetries = 0;
+    iRequestId = millis(); // generate a random ID
+    ret = SendRequest();
+    if (ret != DNS_PENDING)
+    {
+        iUdp.stop();
+        iHostname = NULL;
+    }
+    return ret;
+}
+
+void DNSClient::poll()
+{
+    if (!iHostname || iResult != DNS_PENDING)
+    {
+        return;
+    }
+    int ret = ProcessResponse(0, iAddress);
+    switch (ret)
+    {
+        case INVALID_SERVER:
+        case INVALID_RESPONSE:
+            // not the answer to our request (or a late one to an earlier try),
+            // keep waiting
+        case TIMED_OUT:
+            if (millis() - iTimer < DNS_TIMEOUT)
+            {
+                return;
+            }
+            if (++iRetries < DNS_RETRIES)
             {
-                // Now output the request data
-                ret = BuildRequest(aHostname);
-                if (ret != 0)
+                ret = SendRequest();
+                if (ret == DNS_PENDING)
                 {
-                    // And finally send the request
-                    ret = iUdp.endPacket();
-                    if (ret != 0)
-                    {
-                        // Now wait for a response
-                        int wait_retries = 0;
-                        ret = TIMED_OUT;
-                        while ((wait_retries < 3) && (ret == TIMED_OUT))
-                        {
-                            ret = ProcessResponse(5000, aResult);
-                            wait_retries++;
-                        }
-                    }
+                    return;
                 }
             }
-            retries++;
-        }
-
-        // We're done with the socket now
-        iUdp.stop();
+            else
+            {
+                ret = TIMED_OUT;
+            }
+            break;
     }
+    Finish(ret);
+}
 
+int DNSClient::SendRequest()
+{
+    int ret;
+
+    // Send DNS request
+    ret = iUdp.beginPacket(iDNSServer, DNS_PORT);
+    if (ret != 0)
+    {
+        // Now output the request data
+        ret = BuildRequest(iHostname);
+        if (ret != 0)
+        {
+            // And finally send the request
+            ret = iUdp.endPacket();
+            if (ret != 0)
+            {
+                // Now wait for a response
+                iTimer = millis();
+                iResult = DNS_PENDING;
+                return DNS_PENDING;
+            }
+        }
+    }
     return ret;
 }
 
+void DNSClient::Finish(int aResult)
+{
+    // We're done with the socket now
+    iUdp.stop();
+    iResult = aResult;
+#if UIP_DNS_CACHE_SIZE > 0
+    if (aResult == SUCCESS)
+    {
+        cacheStore(iHostHash, iHostname, iAddress, iTTL);
+    }
+#endif
+}
+
 uint16_t DNSClient::BuildRequest(const char* aName)
 {
     // Build header
@@ -190,8 +380,7 @@ uint16_t DNSClient::BuildRequest(const char* aName)
     //    |                    ARCOUNT                    |
     //    +--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+
     // As we only support one request at a time at present, we can simplify
-    // some of this header
-    iRequestId = millis(); // generate a random ID
+    // some of this header. The ID stays the same when the request is resent
     uint16_t twoByteBuffer;
 
     // FIXME We should also check that there's enough space available to write to, rather
@@ -251,14 +440,14 @@ uint16_t DNSClient::BuildRequest(const char* aName)
 }
 
 
-uint16_t DNSClient::ProcessResponse(uint16_t aTimeout, IPAddress& aAddress)
+int DNSClient::ProcessResponse(uint16_t aTimeout, IPAddress& aAddress)
 {
     uint32_t startTime = millis();
 
-    // Wait for a response packet
+    // Wait for a response packet (just check for one if aTimeout is 0)
     while(iUdp.parsePacket() <= 0)
     {
-        if((millis() - startTime) > aTimeout)
+        if((millis() - startTime) >= aTimeout)
             return TIMED_OUT;
         delay(50);
     }
@@ -381,11 +570,9 @@ uint16_t DNSClient::ProcessResponse(uint16_t aTimeout, IPAddress& aAddress)
         iUdp.read((uint8_t*)&answerType, sizeof(answerType));
         iUdp.read((uint8_t*)&answerClass, sizeof(answerClass));
 
-        // Ignore the Time-To-Live as we don't do any caching
-        for (int i =0; i < TTL_SIZE; i++)
-        {
-            iUdp.read(); // we don't care about the returned byte
-        }
+        // Time-To-Live, for the cache
+        uint32_t ttl;
+        iUdp.read((uint8_t*)&ttl, TTL_SIZE);
 
         // And read out the length of this answer
         // Don't need header_flags anymore, so we can reuse it here
@@ -401,6 +588,7 @@ uint16_t DNSClient::ProcessResponse(uint16_t aTimeout, IPAddress& aAddress)
                 return -9;//INVALID_RESPONSE;
             }
             iUdp.read(aAddress.raw_address(), 4);
+            iTTL = ntohl(ttl);
             return SUCCESS;
         }
         else
@@ -7,9 +7,14 @@
 
 #include <UIPUdp.h>
 
+// Returned by resolve() while the answer has not arrived yet
+#define DNS_PENDING 2
+
 class DNSClient
 {
 public:
+    DNSClient();
+
     // ctor
     void begin(const IPAddress& aDNSServer);
 
@@ -29,13 +34,39 @@ public:
     */
     int getHostByName(const char* aHostname, IPAddress& aResult);
 
+    /** Resolve the given hostname without waiting for the answer.
+        Numeric addresses and names in the cache are returned right away,
+        otherwise a request is sent. Call again (or poll()) until the
+        result is not DNS_PENDING. Only one name is looked up at a time,
+        aHostname has to stay valid until the lookup is done.
+        @param aHostname Name to be resolved
+        @param aResult IPAddress structure to store the returned IP address
+        @result 1 if aResult holds the address, DNS_PENDING while waiting
+                for the answer, else error code
+    */
+    int resolve(const char* aHostname, IPAddress& aResult);
+
+    // Process the answer to a pending request, resend it on timeout
+    void poll();
+
 protected:
     uint16_t BuildRequest(const char* aName);
-    uint16_t ProcessResponse(uint16_t aTimeout, IPAddress& aAddress);
+    int ProcessResponse(uint16_t aTimeout, IPAddress& aAddress);
+    int SendRequest();
+    void Finish(int aResult);
 
     IPAddress iDNSServer;
     uint16_t iRequestId;
     UIPUDP iUdp;
+
+    // lookup in progress
+    const char* iHostname;
+    uint32_t iHostHash;
+    uint32_t iTTL;
+    unsigned long iTimer;
+    uint8_t iRetries;
+    int iResult;
+    IPAddress iAddress;
 };
 
 #endif
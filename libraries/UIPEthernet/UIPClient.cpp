@@ -90,11 +90,20 @@ UIPClient::connect(const char *host, uint16_t port)
   // Look up the host first
   int ret = 0;
 #if UIP_UDP
-  DNSClient dns;
   IPAddress remote_addr;
 
+#if UIP_DNS_NONBLOCKING
+  ret = UIPEthernet.hostByName(host, remote_addr);
+  if (ret == DNS_PENDING) {
+    // not resolved yet, try again later
+    return 0;
+  }
+#else
+  DNSClient dns;
+
   dns.begin(UIPEthernetClass::_dnsServerAddress);
   ret = dns.getHostByName(host, remote_addr);
+#endif
   if (ret == 1) {
     return connect(remote_addr, port);
   }
@@ -119,6 +128,11 @@ UIPClient::stop()
       else
         {
           data->state |= UIP_CLIENT_CLOSE;
+#if UIP_CLIENT_TIMER >= 0
+          // close on the next tick rather than the next periodic timer
+          data->timer = millis();
+#endif
+          UIPEthernetClass::schedule(millis());
         }
 #ifdef UIPETHERNET_DEBUG_CLIENT
       Serial.println(F("after stop()"));
@@ -166,8 +180,10 @@ UIPClient::write(const uint8_t *buf, size_t size)
 }
 
 size_t
-UIPClient::_write(uip_userdata_t* u, const uint8_t *buf, size_t size)
+UIPClient::_write(uip_userdata_t* u, const uint8_t *buf, size_t size, memhandle src)
 {
+  // With src the data is taken from that chip memory block (from its start)
+  // by DMA instead of from buf over SPI
   int remain = size;
   uint16_t written;
 #if UIP_ATTEMPTS_ON_WRITE > 0
@@ -193,6 +209,9 @@ newpacket:
               goto ready;
             }
           u->out_pos = 0;
+#if UIP_CLIENT_COALESCE > 0
+          u->out_time = millis()+UIP_CLIENT_COALESCE;
+#endif
         }
 #ifdef UIPETHERNET_DEBUG_CLIENT
       Serial.print(F("UIPClient.write: writePacket("));
@@ -204,10 +223,20 @@ newpacket:
       Serial.print(F("-"));
       Serial.print(remain);
       Serial.print(F("]: '"));
-      Serial.write((uint8_t*)buf+size-remain,remain);
+      if (src == NOBLOCK)
+        Serial.write((uint8_t*)buf+size-remain,remain);
       Serial.println(F("'"));
 #endif
-      written = Enc28J60Network::writePacket(u->packets_out[p],u->out_pos,(uint8_t*)buf+size-remain,remain);
+      if (src != NOBLOCK)
+        {
+          written = Enc28J60Network::blockSize(u->packets_out[p])-u->out_pos;
+          if (written > remain)
+            written = remain;
+          if (written)
+            Enc28J60Network::copyPacket(u->packets_out[p],u->out_pos,src,size-remain,written);
+        }
+      else
+        written = Enc28J60Network::writePacket(u->packets_out[p],u->out_pos,(uint8_t*)buf+size-remain,remain);
       remain -= written;
       u->out_pos+=written;
       if (remain > 0)
@@ -227,7 +256,19 @@ newpacket:
         }
 ready:
 #if UIP_CLIENT_TIMER >= 0
+#if UIP_CLIENT_COALESCE > 0
+      // poll when the last packet is due, or right away if a full packet is waiting
+      if (p > 0 || u->out_pos >= UIP_SOCKET_DATALEN)
+        u->timer = millis()+UIP_CLIENT_TIMER;
+      else
+        u->timer = u->out_time;
+#else
       u->timer = millis()+UIP_CLIENT_TIMER;
+#endif
+      UIPEthernetClass::schedule(u->timer);
+#else
+      // the next tick sees the connection busy and runs the periodic timer for it
+      UIPEthernetClass::schedule(millis());
 #endif
       return size-remain;
     }
@@ -269,8 +310,6 @@ UIPClient::read(uint8_t *buf, size_t size)
             {
               remain -= read;
               _eatBlock(&data->packets_in[0]);
-              if (uip_stopped(&uip_conns[data->state & UIP_CLIENT_SOCKETS]) && !(data->state & (UIP_CLIENT_CLOSE | UIP_CLIENT_REMOTECLOSED)))
-                data->state |= UIP_CLIENT_RESTART;
               if (data->packets_in[0] == NOBLOCK)
                 {
                   if (data->state & UIP_CLIENT_REMOTECLOSED)
@@ -293,11 +332,54 @@ UIPClient::read(uint8_t *buf, size_t size)
   return -1;
 }
 
+// Pass received data straight from the ENC28J60 to sink (e.g. a parser) until it returns false
+// or size bytes are read. Every received packet is read in one go.
+// The sink is called while SPI is busy - it must not use SPI itself.
+int
+UIPClient::readTo(uip_read_sink sink, void *arg, size_t size)
+{
+  if (*this)
+    {
+      uint16_t remain = size;
+      if (data->packets_in[0] == NOBLOCK)
+        return 0;
+      uint16_t read;
+      do
+        {
+          read = Enc28J60Network::readPacket(data->packets_in[0],0,sink,arg,remain);
+          remain -= read;
+          if (read == Enc28J60Network::blockSize(data->packets_in[0]))
+            {
+              _eatBlock(&data->packets_in[0]);
+              if (data->packets_in[0] == NOBLOCK)
+                {
+                  if (data->state & UIP_CLIENT_REMOTECLOSED)
+                    {
+                      data->state = 0;
+                      data = NULL;
+                    }
+                  return size-remain;
+                }
+            }
+          else
+            {
+              // sink stopped or size reached within this packet
+              Enc28J60Network::resizeBlock(data->packets_in[0],read);
+              break;
+            }
+        }
+      while(remain > 0);
+      return size-remain;
+    }
+  return -1;
+}
+
 int
 UIPClient::read()
 {
   uint8_t c;
-  if (read(&c,1) < 0)
+  // nothing buffered (0) is -1 as well, like for any other Client
+  if (read(&c,1) < 1)
     return -1;
   return c;
 }
@@ -323,6 +405,11 @@ UIPClient::flush()
   if (*this)
     {
       _flushBlocks(&data->packets_in[0]);
+#if UIP_CLIENT_COALESCE > 0
+      // send what is held back for coalescing right away
+      data->out_time = data->timer = millis();
+      UIPEthernetClass::schedule(data->timer);
+#endif
     }
 }
 
@@ -414,8 +501,82 @@ finish_newdata:
 #ifdef UIPETHERNET_DEBUG_CLIENT
           Serial.println(F("UIPClient uip_acked"));
 #endif
+#if UIP_SEND_WINDOW > 1
+          // drop what has been acknowledged, possibly only the start of a packet
+          uint16_t acked = uip_ackedlen;
+          u->out_sent -= acked;
+          while (acked > 0 && u->packets_out[0] != NOBLOCK)
+            {
+              memaddress size = Enc28J60Network::blockSize(u->packets_out[0]);
+              if (acked < size)
+                {
+                  Enc28J60Network::resizeBlock(u->packets_out[0],acked);
+                  if (u->packets_out[1] == NOBLOCK)
+                    u->out_pos -= acked;
+                  break;
+                }
+              acked -= size;
+              UIPClient::_eatBlock(&u->packets_out[0]);
+            }
+#else
           UIPClient::_eatBlock(&u->packets_out[0]);
+#endif
+        }
+#if UIP_SEND_WINDOW > 1
+      if (uip_poll() || uip_rexmit() || uip_acked())
+        {
+          // send the data following what is in flight, or on retransmit from the oldest
+          // unacknowledged byte on (what is sent now is all that is outstanding afterwards)
+          uint16_t in_flight = u->out_sent;
+          uint16_t limit = uip_sendwnd();
+          if (uip_rexmit())
+            {
+              limit = in_flight < uip_mss() ? in_flight : uip_mss();
+              u->out_sent = 0;
+            }
+          memaddress pos = u->out_sent;
+          for (uint8_t p = 0; p < UIP_SOCKET_NUMPACKETS && u->packets_out[p] != NOBLOCK; p++)
+            {
+              bool last = p == UIP_SOCKET_NUMPACKETS-1 || u->packets_out[p+1] == NOBLOCK;
+              memaddress size = last ? u->out_pos : Enc28J60Network::blockSize(u->packets_out[p]);
+              if (pos >= size)
+                {
+                  pos -= size;
+                  continue;
+                }
+              // no more writes into a packet once it goes out
+              if (last)
+                {
+#if UIP_CLIENT_COALESCE > 0
+                  if (UIPClient::_holdBack(u,u->packets_out[p]))
+                    break;
+#endif
+                  Enc28J60Network::resizeBlock(u->packets_out[p],0,size);
+                }
+              send_len = size - pos;
+              if (send_len > limit)
+                send_len = limit;
+              if (send_len > 0)
+                {
+                  UIPEthernetClass::uip_hdrlen = ((uint8_t*)uip_appdata)-uip_buf;
+                  UIPEthernetClass::uip_packet = Enc28J60Network::allocBlock(UIPEthernetClass::uip_hdrlen+send_len);
+                  if (UIPEthernetClass::uip_packet != NOBLOCK)
+                    {
+                      Enc28J60Network::copyPacket(UIPEthernetClass::uip_packet,UIPEthernetClass::uip_hdrlen,u->packets_out[p],pos,send_len);
+                      UIPEthernetClass::packetstate |= UIPETHERNET_SENDPACKET;
+                      u->out_sent += send_len;
+                    }
+                  else
+                    send_len = 0;
+                }
+              break;
+            }
+          if (uip_rexmit() && send_len == 0)
+            u->out_sent = in_flight;
+          if (u->packets_out[0] != NOBLOCK)
+            goto finish;
         }
+#else
       if (uip_poll() || uip_rexmit())
         {
 #ifdef UIPETHERNET_DEBUG_CLIENT
@@ -425,6 +586,10 @@ finish_newdata:
             {
               if (u->packets_out[1] == NOBLOCK)
                 {
+#if UIP_CLIENT_COALESCE > 0
+                  if (UIPClient::_holdBack(u,u->packets_out[0]))
+                    goto finish;
+#endif
                   send_len = u->out_pos;
                   if (send_len > 0)
                     {
@@ -446,6 +611,7 @@ finish_newdata:
               goto finish;
             }
         }
+#endif
       // don't close connection unless all outgoing packets are sent
       if (u->state & UIP_CLIENT_CLOSE)
         {
@@ -533,6 +699,7 @@ UIPClient::_eatBlock(memhandle* block)
     }
   Serial.println();
 #endif
+  _restartStopped();
 }
 
 void
@@ -543,8 +710,46 @@ UIPClient::_flushBlocks(memhandle* block)
       Enc28J60Network::freeBlock(block[i]);
       block[i] = NOBLOCK;
     }
+  _restartStopped();
 }
 
+// The blocks are shared by all sockets, so a socket stopped because the pool was empty
+// may hold no block of its own to free. Any freed block restarts every stopped socket
+// that has room for another packet.
+void
+UIPClient::_restartStopped()
+{
+  for (uint8_t sock = 0; sock < UIP_CONNS; sock++)
+    {
+      uip_userdata_t* data = &all_data[sock];
+      if ((data->state & UIP_CLIENT_CONNECTED)
+          && !(data->state & (UIP_CLIENT_CLOSE | UIP_CLIENT_REMOTECLOSED | UIP_CLIENT_RESTART))
+          && data->packets_in[UIP_SOCKET_NUMPACKETS-1] == NOBLOCK
+          && uip_stopped(&uip_conns[data->state & UIP_CLIENT_SOCKETS]))
+        {
+          data->state |= UIP_CLIENT_RESTART;
+          // reopen the window on the next tick, an idle connection isn't polled otherwise
+#if UIP_CLIENT_TIMER >= 0
+          data->timer = millis();
+#endif
+          UIPEthernetClass::schedule(millis());
+        }
+    }
+}
+
+#if UIP_CLIENT_COALESCE > 0
+// The last of packets_out is held back while it is still open for writes, shorter than
+// a segment and younger than UIP_CLIENT_COALESCE, unless the connection is being closed
+bool
+UIPClient::_holdBack(uip_userdata_t *u, memhandle block)
+{
+  return u->out_pos < uip_mss()
+      && Enc28J60Network::blockSize(block) > u->out_pos
+      && !(u->state & UIP_CLIENT_CLOSE)
+      && (long)( u->out_time - millis() ) > 0;
+}
+#endif
+
 #ifdef UIPETHERNET_DEBUG_CLIENT
 void
 UIPClient::_dumpAllData() {
@@ -42,8 +42,15 @@ extern "C" {
 #define UIP_CLIENT_STATEFLAGS (UIP_CLIENT_CONNECTED | UIP_CLIENT_CLOSE | UIP_CLIENT_REMOTECLOSED | UIP_CLIENT_RESTART)
 #define UIP_CLIENT_SOCKETS ~UIP_CLIENT_STATEFLAGS
 
+#if UIP_CLIENT_COALESCE > 0 && UIP_CLIENT_TIMER < 0
+#error "UIP_CLIENT_COALESCE needs UIP_CLIENT_TIMER"
+#endif
+
 typedef uint8_t uip_socket_ptr;
 
+// Receives data for UIPClient::readTo() byte by byte, return false to stop
+typedef bool (*uip_read_sink)(uint8_t c, void *arg);
+
 typedef struct {
   uint8_t state;
   memhandle packets_in[UIP_SOCKET_NUMPACKETS];
@@ -55,9 +62,15 @@ typedef struct {
   memhandle packets_in[UIP_SOCKET_NUMPACKETS];
   memhandle packets_out[UIP_SOCKET_NUMPACKETS];
   memaddress out_pos;
+#if UIP_SEND_WINDOW > 1
+  uint16_t out_sent;     /**< Bytes from the start of packets_out[0] sent but not acknowledged. */
+#endif
 #if UIP_CLIENT_TIMER >= 0
   unsigned long timer;
 #endif
+#if UIP_CLIENT_COALESCE > 0
+  unsigned long out_time; /**< The last of packets_out is held back until then unless it is full. */
+#endif
 } uip_userdata_t;
 
 class UIPClient : public Client {
@@ -67,6 +80,7 @@ public:
   int connect(IPAddress ip, uint16_t port);
   int connect(const char *host, uint16_t port);
   int read(uint8_t *buf, size_t size);
+  int readTo(uip_read_sink sink, void *arg, size_t size = 0xffff);
   void stop();
   uint8_t connected();
   operator bool();
@@ -91,12 +105,16 @@ private:
   static uip_userdata_t all_data[UIP_CONNS];
   static uip_userdata_t* _allocateData();
 
-  static size_t _write(uip_userdata_t *,const uint8_t *buf, size_t size);
+  static size_t _write(uip_userdata_t *,const uint8_t *buf, size_t size, memhandle src = NOBLOCK);
   static int _available(uip_userdata_t *);
 
   static uint8_t _currentBlock(memhandle* blocks);
   static void _eatBlock(memhandle* blocks);
   static void _flushBlocks(memhandle* blocks);
+  static void _restartStopped();
+#if UIP_CLIENT_COALESCE > 0
+  static bool _holdBack(uip_userdata_t *u, memhandle block);
+#endif
 
 #ifdef UIPETHERNET_DEBUG_CLIENT
   static void _dumpAllData();
@@ -44,8 +44,21 @@ uint8_t UIPEthernetClass::packetstate(0);
 
 IPAddress UIPEthernetClass::_dnsServerAddress;
 DhcpClass* UIPEthernetClass::_dhcp(NULL);
+#if UIP_UDP && UIP_BROADCAST
+boolean UIPEthernetClass::broadcast_filter(false);
+#else
+boolean UIPEthernetClass::broadcast_filter(true);
+#endif
+boolean UIPEthernetClass::broadcast_open(true);
+#if UIP_UDP
+DNSClient UIPEthernetClass::_dns;
+#endif
 
 unsigned long UIPEthernetClass::periodic_timer;
+unsigned long UIPEthernetClass::next_timer;
+unsigned long UIPEthernetClass::arp_timer;
+unsigned long UIPEthernetClass::arp_retry_timer;
+boolean UIPEthernetClass::arp_pending(false);
 
 // Because uIP isn't encapsulated within a class we have to use global
 // variables, so we can only have one TCP/IP stack per program.
@@ -110,6 +123,7 @@ int UIPEthernetClass::maintain(){
   tick();
   int rc = DHCP_CHECK_NONE;
 #if UIP_UDP
+  _dns.poll();
   if(_dhcp != NULL){
     //we have a pointer to dhcp, use it
     rc = _dhcp->checkLease();
@@ -126,9 +140,18 @@ int UIPEthernetClass::maintain(){
         //this is actually a error, it will retry though
         break;
     }
+    // open the filter for the DHCP replies while a renew or rebind runs
+    updateFilter(false);
   }
-  return rc;
 #endif
+  return rc;
+}
+
+void
+UIPEthernetClass::filterBroadcasts(bool on)
+{
+  broadcast_filter = on;
+  updateFilter(false);
 }
 
 IPAddress UIPEthernetClass::localIP()
@@ -160,22 +183,44 @@ IPAddress UIPEthernetClass::dnsServerIP()
   return _dnsServerAddress;
 }
 
+#if UIP_UDP
+int UIPEthernetClass::hostByName(const char* hostname, IPAddress& result)
+{
+  return _dns.resolve(hostname, result);
+}
+#endif
+
 void
 UIPEthernetClass::tick()
 {
-  if (in_packet == NOBLOCK)
+  unsigned long now = millis();
+  // periodic timer or a client timer expired
+  boolean due = (long)( now - next_timer ) >= 0;
+
+  // handle the packets waiting in the receive buffer, up to UIP_RX_BURST in one go
+  for (uint8_t burst = 0; burst < UIP_RX_BURST; burst++)
     {
-      in_packet = Enc28J60Network::receivePacket();
-#ifdef UIPETHERNET_DEBUG
-      if (in_packet != NOBLOCK)
+#ifdef UIPETHERNET_INT_PIN
+      // INT is held low while packets wait in the receive buffer. It is driven by
+      // EIR.PKTIF which is not reliable (Rev. B4 Silicon Errata point 6), so the
+      // packet counter is checked on every timer deadline too
+      if (in_packet == NOBLOCK && (due || digitalRead(UIPETHERNET_INT_PIN) == LOW))
+#else
+      if (in_packet == NOBLOCK)
+#endif
         {
-          Serial.print(F("--------------\nreceivePacket: "));
-          Serial.println(in_packet);
-        }
+          in_packet = Enc28J60Network::receivePacket();
+#ifdef UIPETHERNET_DEBUG
+          if (in_packet != NOBLOCK)
+            {
+              Serial.print(F("--------------\nreceivePacket: "));
+              Serial.println(in_packet);
+            }
 #endif
-    }
-  if (in_packet != NOBLOCK)
-    {
+        }
+      // the receive buffer is empty
+      if (in_packet == NOBLOCK)
+        break;
       packetstate = UIPETHERNET_FREEPACKET;
       uip_len = Enc28J60Network::blockSize(in_packet);
       if (uip_len > 0)
@@ -192,8 +237,15 @@ UIPEthernetClass::tick()
               uip_input();
               if (uip_len > 0)
                 {
+#if UIP_SEND_WINDOW > 1
+                  boolean tcp = BUF->proto == UIP_PROTO_TCP;
+#endif
                   uip_arp_out();
                   network_send();
+#if UIP_SEND_WINDOW > 1
+                  if (tcp && uip_conn)
+                    send_window();
+#endif
                 }
             }
           else if (ETH_HDR ->type == HTONS(UIP_ETHTYPE_ARP))
@@ -218,9 +270,13 @@ UIPEthernetClass::tick()
           Enc28J60Network::freePacket();
           in_packet = NOBLOCK;
         }
-    }
 
-  unsigned long now = millis();
+      // the last packet is still held because a socket had no buffer for it
+      if (in_packet != NOBLOCK || !(packetstate & UIPETHERNET_FREEPACKET))
+        break;
+    }
+  if (!due)
+    return;
 
 #if UIP_CLIENT_TIMER >= 0
   boolean periodic = (long)( now - periodic_timer ) >= 0;
@@ -235,6 +291,9 @@ UIPEthernetClass::tick()
         {
 #endif
       uip_conn = &uip_conns[i];
+      // no uIP timer is running on an idle connection and polling it would not send anything
+      if (!conn_busy(uip_conn))
+        continue;
 #if UIP_CLIENT_TIMER >= 0
       if (periodic)
         {
@@ -244,7 +303,8 @@ UIPEthernetClass::tick()
         }
       else
         {
-          if ((long)( now - ((uip_userdata_t*)uip_conn->appstate)->timer) >= 0)
+          uip_userdata_t *u = (uip_userdata_t*)uip_conn->appstate;
+          if (u && (long)( now - u->timer) >= 0)
             uip_process(UIP_POLL_REQUEST);
           else
             continue;
@@ -257,6 +317,9 @@ UIPEthernetClass::tick()
         {
           uip_arp_out();
           network_send();
+#if UIP_SEND_WINDOW > 1
+          send_window();
+#endif
         }
     }
 #if UIP_CLIENT_TIMER >= 0
@@ -267,21 +330,120 @@ UIPEthernetClass::tick()
 #if UIP_UDP
       for (int i = 0; i < UIP_UDP_CONNS; i++)
         {
+          uip_udp_userdata_t *data = (uip_udp_userdata_t *)(uip_udp_conns[i].appstate);
+          // only a packet waiting for ARP has to be sent again
+          if (!data || !data->send)
+            continue;
           uip_udp_periodic(i);
           // If the above function invocation resulted in data that
           // should be sent out on the Enc28J60Network, the global variable
           // uip_len is set to a value > 0. */
           if (uip_len > 0)
             {
-              UIPUDP::_send((uip_udp_userdata_t *)(uip_udp_conns[i].appstate));
+              UIPUDP::_send(data);
             }
         }
 #endif /* UIP_UDP */
     }
+
+  // uip_arp_timer() wants to be called every 10 seconds
+  if ((long)( now - arp_timer ) >= 0)
+    {
+      arp_timer = now + 10000;
+      uip_arp_timer();
+    }
+
+  // an address that has not answered may be asked for again every
+  // UIP_ARP_RETRY_INTERVAL ms. A request sent since the last check gets a
+  // full interval before it can be repeated
+  if (!arp_pending || (long)( now - arp_retry_timer ) >= 0)
+    {
+      if (arp_pending)
+        arp_pending = uip_arp_retry();
+      else
+        arp_pending = uip_arp_pending();
+      arp_retry_timer = now + UIP_ARP_RETRY_INTERVAL;
+    }
+
+  // nothing to do before the earliest timer that has not expired yet,
+  // expired client timers have just been served. The periodic timer only
+  // counts while a connection has a uIP timer running or data to send
+  next_timer = arp_timer;
+  if (arp_pending && (long)( arp_retry_timer - next_timer ) < 0)
+    next_timer = arp_retry_timer;
+  boolean busy = false;
+  for (int i = 0; i < UIP_CONNS; i++)
+    {
+      if (!conn_busy(&uip_conns[i]))
+        continue;
+      busy = true;
+#if UIP_CLIENT_TIMER >= 0
+      uip_userdata_t *u = (uip_userdata_t*)uip_conns[i].appstate;
+      if (!u)
+        continue;
+      if ((long)( now - u->timer ) >= 0)
+        u->timer = now + UIP_PERIODIC_TIMER;
+      else if ((long)( u->timer - next_timer ) < 0)
+        next_timer = u->timer;
+#endif
+    }
+#if UIP_UDP
+  for (int i = 0; i < UIP_UDP_CONNS; i++)
+    {
+      uip_udp_userdata_t *data = (uip_udp_userdata_t *)(uip_udp_conns[i].appstate);
+      if (data && data->send)
+        busy = true;
+    }
+#endif
+  if (busy && (long)( periodic_timer - next_timer ) < 0)
+    next_timer = periodic_timer;
+}
+
+// true if uIP has to see the connection on the periodic timer: handshake,
+// closing, unacknowledged data, or the sketch has data or a close pending
+boolean
+UIPEthernetClass::conn_busy(struct uip_conn *conn)
+{
+  uint8_t state = conn->tcpstateflags & UIP_TS_MASK;
+  if (state == UIP_CLOSED)
+    return false;
+  if (state != UIP_ESTABLISHED || uip_outstanding(conn))
+    return true;
+  uip_userdata_t *u = (uip_userdata_t*)conn->appstate;
+  return !u || u->packets_out[0] != NOBLOCK || (u->state & (UIP_CLIENT_CLOSE | UIP_CLIENT_RESTART));
+}
+
+unsigned long
+UIPEthernetClass::timeToNextTimer()
+{
+  long left = (long)( next_timer - millis() );
+  return left > 0 ? left : 0;
+}
+
+void
+UIPEthernetClass::schedule(unsigned long deadline)
+{
+  if ((long)( deadline - next_timer ) < 0)
+    next_timer = deadline;
 }
 
 boolean UIPEthernetClass::network_send()
 {
+#if UIP_ARP_HOLD
+  if (uip_arp_held)
+    return network_hold();
+#endif
+  if (uip_len == 0)
+    {
+      // uip_arp_out() did not send an ARP request again, drop the packet
+      if (packetstate & UIPETHERNET_SENDPACKET)
+        {
+          Enc28J60Network::freeBlock(uip_packet);
+          uip_packet = NOBLOCK;
+          packetstate &= ~ UIPETHERNET_SENDPACKET;
+        }
+      return false;
+    }
   if (packetstate & UIPETHERNET_SENDPACKET)
     {
 #ifdef UIPETHERNET_DEBUG
@@ -314,10 +476,74 @@ sendandfree:
   return true;
 }
 
+#if UIP_ARP_HOLD
+// Store the frame uip_arp_out() could not address yet and send the ARP request instead
+boolean UIPEthernetClass::network_hold()
+{
+  memhandle packet = uip_packet;
+  if (packetstate & UIPETHERNET_SENDPACKET)
+    {
+      Enc28J60Network::writePacket(packet,0,uip_buf,uip_hdrlen);
+      packetstate &= ~ UIPETHERNET_SENDPACKET;
+    }
+  else
+    {
+      packet = Enc28J60Network::allocBlock(uip_len);
+      if (packet != NOBLOCK)
+        Enc28J60Network::writePacket(packet,0,uip_buf,uip_len);
+    }
+  uip_packet = NOBLOCK;
+#ifdef UIPETHERNET_DEBUG
+  Serial.print(F("network_hold packet: "));
+  Serial.println(packet);
+#endif
+  uip_arp_hold(packet);
+  return network_send();
+}
+
+// The address of a held frame is resolved (or given up if ethaddr is NULL)
+void
+uipethernet_arp_release(u8_t packet, const u8_t *ethaddr)
+{
+#ifdef UIPETHERNET_DEBUG
+  Serial.print(F("arp_release packet: "));
+  Serial.println(packet);
+#endif
+  if (ethaddr)
+    {
+      Enc28J60Network::writePacket(packet,0,(uint8_t*)ethaddr,6);
+      Enc28J60Network::sendPacket(packet);
+    }
+  Enc28J60Network::freeBlock(packet);
+}
+#endif
+
+#if UIP_SEND_WINDOW > 1
+// After a segment went out on uip_conn, let the connection fill its send window
+void
+UIPEthernetClass::send_window()
+{
+  for (uint8_t i = 1; i < UIP_SEND_WINDOW; i++)
+    {
+      uip_process(UIP_POLL_REQUEST);
+      if (uip_len == 0)
+        return;
+      uip_arp_out();
+      network_send();
+    }
+}
+#endif
+
 void UIPEthernetClass::init(const uint8_t* mac) {
   periodic_timer = millis() + UIP_PERIODIC_TIMER;
+  arp_timer = millis() + 10000;
+  next_timer = periodic_timer;
 
+#ifdef UIPETHERNET_INT_PIN
+  pinMode(UIPETHERNET_INT_PIN, INPUT);
+#endif
   Enc28J60Network::init((uint8_t*)mac);
+  broadcast_open = true;
   uip_seteth_addr(mac);
 
   uip_init();
@@ -337,6 +563,28 @@ void UIPEthernetClass::configure(IPAddress ip, IPAddress dns, IPAddress gateway,
   uip_setnetmask(ipaddr);
 
   _dnsServerAddress = dns;
+#if UIP_UDP
+  _dns.begin(dns);
+#endif
+  updateFilter(true);
+}
+
+void
+UIPEthernetClass::updateFilter(boolean force)
+{
+  boolean open = !broadcast_filter;
+#if UIP_UDP
+  if (_dhcp && _dhcp->pending())
+    open = true;
+#endif
+  if (open == broadcast_open && !force)
+    return;
+  broadcast_open = open;
+  // ARP requests for any address pass until we have one
+  const uint8_t *ip = (const uint8_t*)uip_hostaddr;
+  if (!(uip_hostaddr[0] | uip_hostaddr[1]))
+    ip = NULL;
+  Enc28J60Network::setReceiveFilter(ip,open);
 }
 
 UIPEthernetClass UIPEthernet;
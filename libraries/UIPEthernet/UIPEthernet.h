@@ -28,6 +28,7 @@
 #include "ethernet_comp.h"
 #include <Arduino.h>
 #include "Dhcp.h"
+#include "Dns.h"
 #include "IPAddress.h"
 #include "utility/Enc28J60Network.h"
 #include "UIPClient.h"
@@ -76,11 +77,28 @@ public:
   // events have been processed. Renews dhcp-lease if required.
   int maintain();
 
+  // Milliseconds until the stack has timer work to do (retransmission, ARP
+  // aging, ...). Until then only a received packet needs maintain(), so a
+  // sketch may sleep that long.
+  static unsigned long timeToNextTimer();
+
+  // Let the ENC28J60 drop broadcasts other than ARP requests for our address, so they
+  // don't take up the receive buffer and SPI time. On by default unless UDP broadcasts
+  // are received (UIP_UDP and UIP_BROADCAST). Broadcasts still pass during a DHCP exchange.
+  static void filterBroadcasts(bool on);
+
   IPAddress localIP();
   IPAddress subnetMask();
   IPAddress gatewayIP();
   IPAddress dnsServerIP();
 
+#if UIP_UDP
+  // Resolve a host name without blocking, returns 1 if result holds the address,
+  // DNS_PENDING while the lookup is in progress (call again later), else an error.
+  // The lookup is advanced by maintain() and further calls.
+  int hostByName(const char* hostname, IPAddress& result);
+#endif
+
 private:
   static memhandle in_packet;
   static memhandle uip_packet;
@@ -89,15 +107,35 @@ private:
   
   static IPAddress _dnsServerAddress;
   static DhcpClass* _dhcp;
+#if UIP_UDP
+  static DNSClient _dns;
+#endif
+
+  static boolean broadcast_filter;
+  static boolean broadcast_open;
 
   static unsigned long periodic_timer;
+  static unsigned long next_timer;
+  static unsigned long arp_timer;
+  static unsigned long arp_retry_timer;
+  static boolean arp_pending;
 
   static void init(const uint8_t* mac);
   static void configure(IPAddress ip, IPAddress dns, IPAddress gateway, IPAddress subnet);
+  static void updateFilter(boolean force);
 
   static void tick();
+  static void schedule(unsigned long deadline);
+  static boolean conn_busy(struct uip_conn *conn);
 
   static boolean network_send();
+#if UIP_ARP_HOLD
+  static boolean network_hold();
+  friend void uipethernet_arp_release(u8_t packet, const u8_t *ethaddr);
+#endif
+#if UIP_SEND_WINDOW > 1
+  static void send_window();
+#endif
 
   friend class UIPServer;
 
@@ -0,0 +1,303 @@
+/*
+ UIPHttpServer.cpp - HTTP/1.1 server for static content on top of UIPServer.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+  */
+#include "UIPEthernet.h"
+#include "UIPHttpServer.h"
+#include <avr/pgmspace.h>
+
+// Collects a response and writes it to the client in UIP_HTTP_CHUNK sized pieces,
+// which UIPClient appends to its packets in the ENC28J60
+typedef struct {
+  UIPClient *client;
+  uint8_t len;
+  uint8_t buf[UIP_HTTP_CHUNK];
+} uip_http_out_t;
+
+static void
+out_flush(uip_http_out_t &out)
+{
+  if (out.len)
+    out.client->write(out.buf,out.len);
+  out.len = 0;
+}
+
+static void
+out_P(uip_http_out_t &out, PGM_P s)
+{
+  char c;
+  while ((c = pgm_read_byte(s++)))
+    {
+      if (out.len == UIP_HTTP_CHUNK)
+        out_flush(out);
+      out.buf[out.len++] = c;
+    }
+}
+
+static void
+out_P(uip_http_out_t &out, const __FlashStringHelper *s)
+{
+  out_P(out,(PGM_P)s);
+}
+
+static void
+out_num(uip_http_out_t &out, uint32_t n)
+{
+  char num[11];
+  ultoa(n,num,10);
+  for (char *c = num; *c; c++)
+    {
+      if (out.len == UIP_HTTP_CHUNK)
+        out_flush(out);
+      out.buf[out.len++] = *c;
+    }
+}
+
+static void
+out_status(uip_http_out_t &out, PGM_P status, bool keep)
+{
+  out_P(out,PSTR("HTTP/1.1 "));
+  out_P(out,status);
+  out_P(out,keep ? PSTR("\r\nConnection: keep-alive\r\n") : PSTR("\r\nConnection: close\r\n"));
+}
+
+UIPHttpServer::UIPHttpServer(uint16_t port) : _server(port), _count(0), _source(NULL), _source_arg(NULL)
+{
+}
+
+void
+UIPHttpServer::begin()
+{
+  _server.begin();
+}
+
+bool
+UIPHttpServer::on(const __FlashStringHelper *path, const __FlashStringHelper *type, const uint8_t *data, uint32_t length, uint8_t flags)
+{
+  return _add(path,type,(uint32_t)(uintptr_t)data,length,flags & ~UIP_HTTP_SOURCE);
+}
+
+bool
+UIPHttpServer::onSource(const __FlashStringHelper *path, const __FlashStringHelper *type, uint32_t addr, uint32_t length, uint8_t flags)
+{
+  return _add(path,type,addr,length,flags | UIP_HTTP_SOURCE);
+}
+
+bool
+UIPHttpServer::_add(const __FlashStringHelper *path, const __FlashStringHelper *type, uint32_t addr, uint32_t length, uint8_t flags)
+{
+  if (_count == UIP_HTTP_RESOURCES)
+    return false;
+  uip_http_resource_t *r = &_resources[_count++];
+  r->path = path;
+  r->type = type;
+  r->addr = addr;
+  r->length = length;
+  r->flags = flags;
+  return true;
+}
+
+void
+UIPHttpServer::setSource(uip_http_source source, void *arg)
+{
+  _source = source;
+  _source_arg = arg;
+}
+
+void
+UIPHttpServer::handle()
+{
+  // close kept connections that are gone or idle for too long
+  for (uint8_t i = 0; i < UIP_CONNS; i++)
+    {
+      if (!_clients[i])
+        continue;
+      if (!_clients[i].connected())
+        _clients[i] = UIPClient();
+      else if (millis() - _last[i] > UIP_HTTP_KEEPALIVE)
+        {
+          _clients[i].stop();
+          _clients[i] = UIPClient();
+        }
+    }
+
+  UIPClient client = _server.available();
+  if (!client)
+    return;
+
+  // the slot of a kept connection, or a free one to keep this one in
+  uint8_t slot = UIP_CONNS;
+  for (uint8_t i = 0; i < UIP_CONNS; i++)
+    {
+      if (_clients[i] == client)
+        {
+          slot = i;
+          break;
+        }
+      if (slot == UIP_CONNS && !_clients[i])
+        slot = i;
+    }
+
+  if (_serve(client,slot < UIP_CONNS))
+    {
+      _clients[slot] = client;
+      _last[slot] = millis();
+    }
+  else
+    {
+      if (slot < UIP_CONNS && _clients[slot] == client)
+        _clients[slot] = UIPClient();
+      client.stop();
+    }
+}
+
+// Answers one request, returns true if the connection stays open for the next one
+bool
+UIPHttpServer::_serve(UIPClient &client, bool can_keep)
+{
+  char line[UIP_HTTP_LINE];
+  uip_http_out_t out;
+  out.client = &client;
+  out.len = 0;
+
+  if (!_readLine(client,line,sizeof(line)))
+    return false;
+
+  // request line: method, path (without the query), version
+  bool head = !strncmp_P(line,PSTR("HEAD "),5);
+  bool get = !strncmp_P(line,PSTR("GET "),4);
+  char *version = strrchr(line,' ');
+  bool keep = can_keep && version && !strcmp_P(version+1,PSTR("HTTP/1.1"));
+  char *path = strchr(line,' ');
+  uip_http_resource_t *r = NULL;
+  if (path && path != version)
+    {
+      path++;
+      path[strcspn(path," ?")] = 0;
+      for (uint8_t i = 0; i < _count; i++)
+        {
+          if (!strcmp_P(path,(PGM_P)_resources[i].path))
+            {
+              r = &_resources[i];
+              break;
+            }
+        }
+    }
+
+  // headers up to the empty line
+  bool gzip = false;
+  for (;;)
+    {
+      if (!_readLine(client,line,sizeof(line)))
+        return false;
+      if (!line[0])
+        break;
+      if (!strncasecmp_P(line,PSTR("Connection:"),11))
+        {
+          if (strcasestr_P(line,PSTR("close")))
+            keep = false;
+          else if (can_keep && strcasestr_P(line,PSTR("keep-alive")))
+            keep = true;
+        }
+      else if (!strncasecmp_P(line,PSTR("Accept-Encoding:"),16) && strcasestr_P(line,PSTR("gzip")))
+        gzip = true;
+    }
+
+  if (!get && !head)
+    {
+      out_status(out,PSTR("501 Not Implemented"),false);
+      out_P(out,PSTR("Content-Length: 0\r\n\r\n"));
+      out_flush(out);
+      return false;
+    }
+  if (!r)
+    {
+      out_status(out,PSTR("404 Not Found"),keep);
+      out_P(out,PSTR("Content-Length: 0\r\n\r\n"));
+      out_flush(out);
+      return keep;
+    }
+  if ((r->flags & UIP_HTTP_GZIP) && !gzip)
+    {
+      out_status(out,PSTR("406 Not Acceptable"),keep);
+      out_P(out,PSTR("Content-Length: 0\r\n\r\n"));
+      out_flush(out);
+      return keep;
+    }
+
+  out_status(out,PSTR("200 OK"),keep);
+  out_P(out,PSTR("Content-Type: "));
+  out_P(out,r->type);
+  out_P(out,PSTR("\r\nContent-Length: "));
+  out_num(out,r->length);
+  if (r->flags & UIP_HTTP_GZIP)
+    out_P(out,PSTR("\r\nContent-Encoding: gzip\r\nVary: Accept-Encoding"));
+  if (r->flags & UIP_HTTP_CACHE)
+    {
+      out_P(out,PSTR("\r\nCache-Control: max-age="));
+      out_num(out,UIP_HTTP_MAX_AGE);
+    }
+  out_P(out,PSTR("\r\n\r\n"));
+
+  // the body follows the headers in the same buffer, one chunk at a time
+  uint32_t pos = 0;
+  while (!head && pos < r->length)
+    {
+      uint16_t len = UIP_HTTP_CHUNK - out.len;
+      if (len > r->length - pos)
+        len = r->length - pos;
+      if (r->flags & UIP_HTTP_SOURCE)
+        {
+          if (!_source)
+            return false;
+          _source(r->addr+pos,out.buf+out.len,len,_source_arg);
+        }
+      else
+        memcpy_P(out.buf+out.len,(PGM_VOID_P)(uintptr_t)(r->addr+pos),len);
+      out.len += len;
+      pos += len;
+      out_flush(out);
+      if (!client.connected())
+        return false;
+    }
+  out_flush(out);
+  return keep;
+}
+
+// Reads a line of the request without the line end, cut to size-1 characters.
+// Returns false if the connection is closed or the line does not arrive within UIP_HTTP_TIMEOUT ms
+bool
+UIPHttpServer::_readLine(UIPClient &client, char *buf, uint8_t size)
+{
+  uint8_t len = 0;
+  unsigned long start = millis();
+  for (;;)
+    {
+      // available() ticks the stack, so the next segment can arrive while we wait
+      if (!client.available())
+        {
+          if (!client.connected() || millis() - start > UIP_HTTP_TIMEOUT)
+            return false;
+          continue;
+        }
+      int c = client.read();
+      if (c == '\n')
+        break;
+      if (c != '\r' && len < size-1)
+        buf[len++] = c;
+    }
+  buf[len] = 0;
+  return true;
+}
@@ -0,0 +1,69 @@
+/*
+ UIPHttpServer.h - HTTP/1.1 server for static content on top of UIPServer.
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+  */
+#ifndef UIPHTTPSERVER_H
+#define UIPHTTPSERVER_H
+
+#include "UIPServer.h"
+#include "UIPClient.h"
+
+// flags of a resource
+#define UIP_HTTP_GZIP   0x01 // body is gzip compressed, sent with Content-Encoding: gzip
+#define UIP_HTTP_CACHE  0x02 // browser may cache it for UIP_HTTP_MAX_AGE seconds
+#define UIP_HTTP_SOURCE 0x04 // body is read through the source callback instead of from PROGMEM
+
+// Reads len bytes of the body of a UIP_HTTP_SOURCE resource at addr into buf (e.g. from SPIFlash).
+// It is not called while the ENC28J60 is selected, so it may use SPI.
+typedef void (*uip_http_source)(uint32_t addr, uint8_t *buf, uint16_t len, void *arg);
+
+typedef struct {
+  const __FlashStringHelper *path;  /**< e.g. F("/index.html") */
+  const __FlashStringHelper *type;  /**< Content-Type, e.g. F("text/html") */
+  uint32_t addr;                    /**< PROGMEM address of the body or address passed to the source */
+  uint32_t length;
+  uint8_t flags;
+} uip_http_resource_t;
+
+// Serves a fixed set of resources to GET and HEAD requests. Bodies are streamed from PROGMEM or
+// the source callback into the packet memory of the ENC28J60 through a UIP_HTTP_CHUNK buffer on
+// the stack, so RAM use does not depend on their size. Connections are kept open for further
+// requests (HTTP/1.1 keep-alive) until idle for UIP_HTTP_KEEPALIVE ms. Call handle() from loop().
+class UIPHttpServer {
+
+public:
+  UIPHttpServer(uint16_t port = 80);
+  void begin();
+  bool on(const __FlashStringHelper *path, const __FlashStringHelper *type, const uint8_t *data, uint32_t length, uint8_t flags = 0);
+  bool onSource(const __FlashStringHelper *path, const __FlashStringHelper *type, uint32_t addr, uint32_t length, uint8_t flags = 0);
+  void setSource(uip_http_source source, void *arg = NULL);
+  void handle();
+
+private:
+  UIPServer _server;
+  uip_http_resource_t _resources[UIP_HTTP_RESOURCES];
+  uint8_t _count;
+  uip_http_source _source;
+  void *_source_arg;
+  // connections kept open after a response and the time of their last request
+  UIPClient _clients[UIP_CONNS];
+  unsigned long _last[UIP_CONNS];
+
+  bool _serve(UIPClient &client, bool can_keep);
+  bool _add(const __FlashStringHelper *path, const __FlashStringHelper *type, uint32_t addr, uint32_t length, uint8_t flags);
+  static bool _readLine(UIPClient &client, char *buf, uint8_t size);
+};
+
+#endif
@@ -53,10 +53,53 @@ size_t UIPServer::write(uint8_t c)
 size_t UIPServer::write(const uint8_t *buf, size_t size)
 {
   size_t ret = 0;
-  for ( uip_userdata_t* data = &UIPClient::all_data[0]; data < &UIPClient::all_data[UIP_CONNS]; data++ )
+  bool receiving[UIP_CONNS];
+  uint8_t clients = 0;
+  for (uint8_t i = 0; i < UIP_CONNS; i++)
+    {
+      uip_userdata_t* data = &UIPClient::all_data[i];
+      receiving[i] = (data->state & UIP_CLIENT_CONNECTED) && uip_conns[data->state & UIP_CLIENT_SOCKETS].lport ==_port;
+      if (receiving[i])
+        clients++;
+    }
+
+  // With several clients the data goes over SPI once into a staging block,
+  // the chip's DMA copies it into the send buffers of every client
+  size_t pos = 0;
+  if (clients > 1)
+    {
+      while (pos < size)
+        {
+          uint16_t len = size - pos > UIP_SOCKET_DATALEN ? UIP_SOCKET_DATALEN : size - pos;
+          memhandle stage = Enc28J60Network::allocBlock(len);
+          if (stage == NOBLOCK)
+            break;
+          Enc28J60Network::writePacket(stage,0,(uint8_t*)buf+pos,len);
+          for (uint8_t i = 0; i < UIP_CONNS; i++)
+            {
+              if (!receiving[i])
+                continue;
+              size_t written = UIPClient::_write(&UIPClient::all_data[i],NULL,len,stage);
+              if (written == (size_t)-1)
+                written = 0;
+              ret += written;
+              // a client that is out of buffers must not get the following chunks
+              if (written < len)
+                receiving[i] = false;
+            }
+          Enc28J60Network::freeBlock(stage);
+          pos += len;
+        }
+    }
+
+  // One client, or no memory for staging: write the rest to each client directly
+  if (pos < size)
     {
-      if ((data->state & UIP_CLIENT_CONNECTED) && uip_conns[data->state & UIP_CLIENT_SOCKETS].lport ==_port)
-        ret += UIPClient::_write(data,buf,size);
+      for (uint8_t i = 0; i < UIP_CONNS; i++)
+        {
+          if (receiving[i])
+            ret += UIPClient::_write(&UIPClient::all_data[i],buf+pos,size-pos);
+        }
     }
   return ret;
 }
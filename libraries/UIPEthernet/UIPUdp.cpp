@@ -42,6 +42,19 @@ UIPUDP::UIPUDP() :
   memset(&appdata,0,sizeof(appdata));
 }
 
+// Free the current and all queued received packets
+void
+UIPUDP::_freeReceived()
+{
+  Enc28J60Network::freeBlock(appdata.packet_in);
+  appdata.packet_in = NOBLOCK;
+  for (uint8_t i = 0; i < UIP_UDP_RXQUEUE; i++)
+    {
+      Enc28J60Network::freeBlock(appdata.packets_next[i].packet);
+      appdata.packets_next[i].packet = NOBLOCK;
+    }
+}
+
 // initialize, start listening on specified port. Returns 1 if successful, 0 if there are no sockets available to use
 uint8_t
 UIPUDP::begin(uint16_t port)
@@ -68,8 +81,7 @@ UIPUDP::stop()
       uip_udp_remove(_uip_udp_conn);
       _uip_udp_conn->appstate = NULL;
       _uip_udp_conn=NULL;
-      Enc28J60Network::freeBlock(appdata.packet_in);
-      Enc28J60Network::freeBlock(appdata.packet_next);
+      _freeReceived();
       Enc28J60Network::freeBlock(appdata.packet_out);
       memset(&appdata,0,sizeof(appdata));
     }
@@ -148,11 +160,20 @@ UIPUDP::beginPacket(const char *host, uint16_t port)
 {
   // Look up the host first
   int ret = 0;
-  DNSClient dns;
   IPAddress remote_addr;
 
+#if UIP_DNS_NONBLOCKING
+  ret = UIPEthernet.hostByName(host, remote_addr);
+  if (ret == DNS_PENDING) {
+    // not resolved yet, try again later
+    return 0;
+  }
+#else
+  DNSClient dns;
+
   dns.begin(UIPEthernet.dnsServerIP());
   ret = dns.getHostByName(host, remote_addr);
+#endif
   if (ret == 1) {
     return beginPacket(remote_addr, port);
   } else {
@@ -214,8 +235,17 @@ UIPUDP::parsePacket()
 #endif
   Enc28J60Network::freeBlock(appdata.packet_in);
 
-  appdata.packet_in = appdata.packet_next;
-  appdata.packet_next = NOBLOCK;
+  uip_udp_received_t *next = &appdata.packets_next[0];
+  appdata.packet_in = next->packet;
+  if (appdata.packet_in != NOBLOCK && _uip_udp_conn)
+    {
+      // remoteIP() and remotePort() of this packet, uipudp_appcall() may have seen later ones
+      _uip_udp_conn->rport = next->rport;
+      uip_ipaddr_copy(_uip_udp_conn->ripaddr,next->ripaddr);
+    }
+  for (uint8_t i = 1; i < UIP_UDP_RXQUEUE; i++)
+    appdata.packets_next[i-1] = appdata.packets_next[i];
+  appdata.packets_next[UIP_UDP_RXQUEUE-1].packet = NOBLOCK;
 
 #ifdef UIPETHERNET_DEBUG_UDP
   if (appdata.packet_in != NOBLOCK)
@@ -321,21 +351,28 @@ uipudp_appcall(void) {
     {
       if (uip_newdata())
         {
-          if (data->packet_next == NOBLOCK)
+          uint8_t i = 0;
+          while (i < UIP_UDP_RXQUEUE && data->packets_next[i].packet != NOBLOCK)
+            i++;
+          //if the queue is full the packet is dropped
+          if (i < UIP_UDP_RXQUEUE)
             {
+              uip_udp_received_t *next = &data->packets_next[i];
               uip_udp_conn->rport = UDPBUF->srcport;
               uip_ipaddr_copy(uip_udp_conn->ripaddr,UDPBUF->srcipaddr);
-              data->packet_next = Enc28J60Network::allocBlock(ntohs(UDPBUF->udplen)-UIP_UDPH_LEN);
+              next->rport = UDPBUF->srcport;
+              uip_ipaddr_copy(next->ripaddr,UDPBUF->srcipaddr);
+              next->packet = Enc28J60Network::allocBlock(ntohs(UDPBUF->udplen)-UIP_UDPH_LEN);
                   //if we are unable to allocate memory the packet is dropped. udp doesn't guarantee packet delivery
-              if (data->packet_next != NOBLOCK)
+              if (next->packet != NOBLOCK)
                 {
                   //discard Linklevel and IP and udp-header and any trailing bytes:
-                  Enc28J60Network::copyPacket(data->packet_next,0,UIPEthernetClass::in_packet,UIP_UDP_PHYH_LEN,Enc28J60Network::blockSize(data->packet_next));
+                  Enc28J60Network::copyPacket(next->packet,0,UIPEthernetClass::in_packet,UIP_UDP_PHYH_LEN,Enc28J60Network::blockSize(next->packet));
     #ifdef UIPETHERNET_DEBUG_UDP
                   Serial.print(F("udp, uip_newdata received packet: "));
-                  Serial.print(data->packet_next);
+                  Serial.print(next->packet);
                   Serial.print(F(", size: "));
-                  Serial.println(Enc28J60Network::blockSize(data->packet_next));
+                  Serial.println(Enc28J60Network::blockSize(next->packet));
     #endif
                 }
             }
@@ -359,13 +396,19 @@ uipudp_appcall(void) {
 void
 UIPUDP::_send(uip_udp_userdata_t *data) {
   uip_arp_out(); //add arp
-  if (uip_len == UIP_ARPHDRSIZE)
+#if UIP_ARP_HOLD
+  if (!uip_arp_held && (uip_len == UIP_ARPHDRSIZE || uip_len == 0))
+#else
+  if (uip_len == UIP_ARPHDRSIZE || uip_len == 0)
+#endif
     {
       UIPEthernetClass::uip_packet = NOBLOCK;
       UIPEthernetClass::packetstate &= ~UIPETHERNET_SENDPACKET;
 #ifdef UIPETHERNET_DEBUG_UDP
       Serial.println(F("udp, uip_poll results in ARP-packet"));
 #endif
+      // try again on the periodic timer, when the ARP reply should be in
+      UIPEthernetClass::schedule(millis() + UIP_PERIODIC_TIMER);
     }
   else
   //arp found ethaddr for ip (otherwise packet is replaced by arp-request)
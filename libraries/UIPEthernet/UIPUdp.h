@@ -32,9 +32,15 @@ extern "C" {
 #define UIP_UDP_PHYH_LEN UIP_LLH_LEN+UIP_IPUDPH_LEN
 #define UIP_UDP_MAXPACKETSIZE UIP_UDP_MAXDATALEN+UIP_UDP_PHYH_LEN
 
+typedef struct {
+  memhandle packet;
+  uip_ipaddr_t ripaddr;
+  u16_t rport;
+} uip_udp_received_t;
+
 typedef struct {
   memaddress out_pos;
-  memhandle packet_next;
+  uip_udp_received_t packets_next[UIP_UDP_RXQUEUE]; // oldest first, NOBLOCK after the last one
   memhandle packet_in;
   memhandle packet_out;
   boolean send;
@@ -120,6 +126,7 @@ private:
 
   friend class UIPEthernetClass;
   static void _send(uip_udp_userdata_t *data);
+  void _freeReceived();
 
 };
 
@@ -0,0 +1,72 @@
+/*
+ * UIPEthernet HttpServer example.
+ *
+ * UIPEthernet is a TCP/IP stack that can be used with a enc28j60 based
+ * Ethernet-shield.
+ *
+ * UIPEthernet uses the fine uIP stack by Adam Dunkels <adam@sics.se>
+ *
+ *      -----------------
+ *
+ * This example serves a static page at http://192.168.0.6/ with UIPHttpServer.
+ * The page and its pre-compressed style sheet are kept in PROGMEM. Remove the
+ * comment in front of USE_SPIFLASH to also serve a file stored in a SPI flash
+ * chip (e.g. written there by the Moteino programmer) at /log.txt.
+ *
+ * A compressed asset is made with
+ *   gzip -9 -n -c style.css | xxd -i
+ */
+
+#include <UIPEthernet.h>
+#include <UIPHttpServer.h>
+
+//#define USE_SPIFLASH
+
+#ifdef USE_SPIFLASH
+#include <SPI.h>
+#include <SPIFlash.h>
+SPIFlash flash(8, 0xEF30);
+
+void readFlash(uint32_t addr, uint8_t *buf, uint16_t len, void *arg)
+{
+  flash.readBytes(addr, buf, len);
+}
+#endif
+
+const char index_html[] PROGMEM =
+  "<!DOCTYPE html><html><head><title>Node</title>"
+  "<link rel=\"stylesheet\" href=\"/style.css\"></head>"
+  "<body><h1>Hello from UIPEthernet</h1></body></html>";
+
+// body{font-family:sans-serif;margin:2em}h1{color:#369}
+const uint8_t style_css_gz[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x4b, 0xca, 0x4f, 0xa9, 0xac, 0x4e,
+  0xcb, 0xcf, 0x2b, 0xd1, 0x4d, 0x4b, 0xcc, 0xcd, 0xcc, 0xa9, 0xb4, 0x2a, 0x4e, 0xcc, 0x2b, 0xd6,
+  0x2d, 0x4e, 0x2d, 0xca, 0x4c, 0xb3, 0xce, 0x4d, 0x2c, 0x4a, 0xcf, 0xcc, 0xb3, 0x32, 0x4a, 0xcd,
+  0xad, 0xcd, 0x30, 0xac, 0x4e, 0xce, 0xcf, 0xc9, 0x2f, 0xb2, 0x52, 0x36, 0x36, 0xb3, 0xac, 0xe5,
+  0x02, 0x00, 0x1c, 0x96, 0x2b, 0x34, 0x36, 0x00, 0x00, 0x00
+};
+
+UIPHttpServer http(80);
+
+void setup()
+{
+  uint8_t mac[6] = {0x00,0x01,0x02,0x03,0x04,0x05};
+  IPAddress myIP(192,168,0,6);
+
+  Ethernet.begin(mac,myIP);
+
+  http.on(F("/"), F("text/html"), (const uint8_t*)index_html, sizeof(index_html)-1);
+  http.on(F("/style.css"), F("text/css"), style_css_gz, sizeof(style_css_gz), UIP_HTTP_GZIP | UIP_HTTP_CACHE);
+#ifdef USE_SPIFLASH
+  flash.initialize();
+  http.setSource(readFlash);
+  http.onSource(F("/log.txt"), F("text/plain"), 0, 4096);
+#endif
+  http.begin();
+}
+
+void loop()
+{
+  http.handle();
+}
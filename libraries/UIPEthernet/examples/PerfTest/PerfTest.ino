@@ -0,0 +1,171 @@
+/*
+ * UIPEthernet PerfTest example.
+ *
+ * UIPEthernet is a TCP/IP stack that can be used with a enc28j60 based
+ * Ethernet-shield.
+ *
+ * UIPEthernet uses the fine uIP stack by Adam Dunkels <adam@sics.se>
+ *
+ *      -----------------
+ *
+ * Firmware side of the benchmark in tests/perl/perftest.pl. Sets up a
+ * server at 192.168.0.6, TCP port 5001 takes one command line per connection:
+ *
+ *   INFO       answers the stack configuration, ie "UIP_SOCKET_NUMPACKETS=5 ..."
+ *   RECV <n>   reads and drops n bytes, then answers "OK <bytes>" (uIP has no
+ *              half close, so the length comes up front)
+ *   SEND <n>   sends n bytes and closes
+ *   ECHO       echoes everything back (round trip times)
+ *   PING       answers "PONG" and closes (connection setup rate)
+ *
+ * UDP port 5002 echoes every datagram (packet rate and loss), this needs
+ * UIP_CONF_UDP set to 1 in utility/uipethernet-conf.h.
+ *
+ * Build it once per configuration (UIP_SOCKET_NUMPACKETS, UIP_CONF_MAX_CONNECTIONS,
+ * UIP_CONF_MEMBLOCKS, UIP_UDP_RXQUEUE in utility/uipethernet-conf.h) and run
+ * perftest.pl against each.
+ */
+
+#include <UIPEthernet.h>
+#include <UIPServer.h>
+#include <UIPClient.h>
+
+#define PERF_TCP_PORT 5001
+#define PERF_UDP_PORT 5002
+
+EthernetServer server = EthernetServer(PERF_TCP_PORT);
+#if UIP_UDP
+EthernetUDP udp;
+#endif
+uint8_t buf[128];
+
+void setup()
+{
+  Serial.begin(115200);
+
+  uint8_t mac[6] = {0x00,0x01,0x02,0x03,0x04,0x05};
+  IPAddress myIP(192,168,0,6);
+
+  Ethernet.begin(mac,myIP);
+
+  server.begin();
+#if UIP_UDP
+  udp.begin(PERF_UDP_PORT);
+#endif
+  Serial.println(F("PerfTest ready"));
+}
+
+// read the command line, false if the host closed before sending one
+bool readLine(EthernetClient &client, char *line, uint8_t size)
+{
+  uint8_t len = 0;
+  while (client.connected() || client.available())
+    {
+      int c = client.read();
+      if (c < 0)
+        continue;
+      if (c == '\n')
+        {
+          if (len && line[len-1] == '\r')
+            len--;
+          line[len] = 0;
+          return true;
+        }
+      if (len < size-1)
+        line[len++] = c;
+    }
+  return false;
+}
+
+void sendInfo(EthernetClient &client)
+{
+  client.print(F("UIP_SOCKET_NUMPACKETS="));
+  client.print(UIP_SOCKET_NUMPACKETS);
+  client.print(F(" UIP_CONF_MAX_CONNECTIONS="));
+  client.print(UIP_CONF_MAX_CONNECTIONS);
+  client.print(F(" MEMPOOL_NUM_MEMBLOCKS="));
+  client.print(MEMPOOL_NUM_MEMBLOCKS);
+#if UIP_UDP
+  client.print(F(" UIP_UDP_RXQUEUE="));
+  client.print(UIP_UDP_RXQUEUE);
+#endif
+  client.print(F(" UIP_SEND_WINDOW="));
+  client.print(UIP_SEND_WINDOW);
+  client.print(F("\n"));
+}
+
+void receive(EthernetClient &client, unsigned long expected)
+{
+  unsigned long count = 0;
+  int size;
+  while (count < expected && (client.connected() || client.available()))
+    {
+      if ((size = client.read(buf,sizeof(buf))) > 0)
+        count += size;
+    }
+  client.print(F("OK "));
+  client.print(count);
+  client.print(F("\n"));
+}
+
+void send(EthernetClient &client, unsigned long count)
+{
+  for (uint8_t i = 0; i < sizeof(buf); i++)
+    buf[i] = 'a' + i % 26;
+  while (count > 0 && client.connected())
+    {
+      size_t len = count > sizeof(buf) ? sizeof(buf) : count;
+      size_t written = client.write(buf,len);
+      if (written == (size_t)-1)
+        break;
+      count -= written;
+    }
+}
+
+void echo(EthernetClient &client)
+{
+  int size;
+  while (client.connected() || client.available())
+    {
+      if ((size = client.read(buf,sizeof(buf))) > 0)
+        client.write(buf,size);
+    }
+}
+
+void loop()
+{
+  if (EthernetClient client = server.available())
+    {
+      char line[24];
+      if (readLine(client,line,sizeof(line)))
+        {
+          if (!strcmp(line,"INFO"))
+            sendInfo(client);
+          else if (!strncmp(line,"RECV ",5))
+            receive(client,strtoul(line+5,NULL,10));
+          else if (!strncmp(line,"SEND ",5))
+            send(client,strtoul(line+5,NULL,10));
+          else if (!strcmp(line,"ECHO"))
+            echo(client);
+          else if (!strcmp(line,"PING"))
+            client.print(F("PONG\n"));
+        }
+      client.stop();
+    }
+
+#if UIP_UDP
+  int size;
+  while ((size = udp.parsePacket()) > 0)
+    {
+      if (size > (int)sizeof(buf))
+        size = sizeof(buf);
+      size = udp.read(buf,size);
+      udp.flush();
+      if (udp.beginPacket(udp.remoteIP(),udp.remotePort()))
+        {
+          udp.write(buf,size);
+          udp.endPacket();
+        }
+    }
+#endif
+}
@@ -0,0 +1,169 @@
+#!/usr/bin/perl
+#perftest.pl
+#
+# Host side of the benchmark, runs against examples/PerfTest on the board:
+#   perl perftest.pl [host] [label]
+# Prints one line per measurement, prefixed with the label (default: the stack
+# configuration the firmware reports), so runs of different builds can be
+# put next to each other:
+#   tcp_rx, tcp_tx    bulk throughput host->board and board->host in bytes/s
+#   connect           connections (connect, PING, PONG, close) per second
+#   rtt               round trip of 32 bytes over TCP, percentiles in ms
+#   udp               echoed packets/s and loss for each offered packet rate
+
+use strict;
+use IO::Socket::INET;
+use IO::Select;
+use Time::HiRes qw(time sleep);
+
+# flush after every write
+$| = 1;
+
+my $host = shift || '192.168.0.6';
+my $label = shift;
+my $tcp_port = 5001;
+my $udp_port = 5002;
+
+my $bulk_bytes = 100000;
+my $connects = 50;
+my $rtt_samples = 200;
+my @udp_rates = (10, 50, 100, 200, 500, 1000, 2000);
+my $udp_seconds = 2;
+
+sub tcp_connect {
+	return new IO::Socket::INET (
+	PeerAddr => $host,
+	PeerPort => $tcp_port,
+	Proto => 'tcp',
+	Timeout => 5
+	) or die "ERROR in Socket Creation : $!\n";
+}
+
+sub command {
+	my ($cmd) = @_;
+	my $socket = tcp_connect();
+	print $socket "$cmd\n";
+	return $socket;
+}
+
+sub result {
+	printf "%s: %s\n", $label, join(' ', @_);
+}
+
+sub percentile {
+	my ($p, @sorted) = @_;
+	return $sorted[int($p / 100 * $#sorted + 0.5)];
+}
+
+# configuration of the firmware under test
+my $socket = command("INFO");
+my $info = <$socket>;
+$socket->close();
+chomp $info;
+$label = $info unless defined $label;
+print "Config: $info\n";
+
+# host -> board
+{
+	my $chunk = 'x' x 1024;
+	my $start = time;
+	my $socket = command("RECV $bulk_bytes");
+	my $left = $bulk_bytes;
+	while ($left > 0) {
+		my $n = $left > length($chunk) ? length($chunk) : $left;
+		print $socket substr($chunk, 0, $n);
+		$left -= $n;
+	}
+	my $answer = <$socket>;
+	my $elapsed = time - $start;
+	$socket->close();
+	chomp $answer;
+	result(sprintf("tcp_rx %.0f bytes/s (%s)", $bulk_bytes / $elapsed, $answer));
+}
+
+# board -> host
+{
+	my $start = time;
+	my $socket = command("SEND $bulk_bytes");
+	my ($data, $received) = ('', 0);
+	while ($socket->sysread($data, 4096) > 0) {
+		$received += length($data);
+	}
+	my $elapsed = time - $start;
+	$socket->close();
+	result(sprintf("tcp_tx %.0f bytes/s (%d of %d bytes)", $received / $elapsed, $received, $bulk_bytes));
+}
+
+# connection setup rate
+{
+	my $ok = 0;
+	my $start = time;
+	for (1..$connects) {
+		my $socket = command("PING");
+		my $answer = <$socket>;
+		$ok++ if defined $answer && $answer =~ /^PONG/;
+		$socket->close();
+	}
+	my $elapsed = time - $start;
+	result(sprintf("connect %.1f/s (%d of %d answered)", $ok / $elapsed, $ok, $connects));
+}
+
+# round trip times
+{
+	my $socket = command("ECHO");
+	$socket->autoflush(1);
+	my $message = '0123456789abcdef0123456789abcdef';
+	my @rtt;
+	for (1..$rtt_samples) {
+		my $start = time;
+		$socket->syswrite($message);
+		my ($data, $received) = ('', '');
+		while (length($received) < length($message) && $socket->sysread($data, 64) > 0) {
+			$received .= $data;
+		}
+		push @rtt, (time - $start) * 1000;
+	}
+	$socket->close();
+	my @sorted = sort { $a <=> $b } @rtt;
+	result(sprintf("rtt ms p50 %.2f p90 %.2f p99 %.2f max %.2f",
+		percentile(50, @sorted), percentile(90, @sorted), percentile(99, @sorted), $sorted[-1]));
+}
+
+# UDP echo, loss curve over the offered packet rate
+{
+	my $socket = new IO::Socket::INET (
+	PeerAddr => "$host:$udp_port",
+	Proto => 'udp'
+	) or die "ERROR in Socket Creation : $!\n";
+	my $select = new IO::Select($socket);
+	my $seq = 0;
+	for my $rate (@udp_rates) {
+		my $count = $rate * $udp_seconds;
+		my ($sent, $echoed) = (0, 0);
+		my $first = $seq;
+		my $start = time;
+		while ($sent < $count) {
+			# send on schedule, pick up echoes in between
+			my $due = $start + $sent / $rate;
+			while ((my $wait = $due - time) > 0 || $select->can_read(0)) {
+				if ($select->can_read($wait > 0 ? $wait : 0)) {
+					my $data;
+					$socket->recv($data, 128);
+					$echoed++ if unpack('N', $data) >= $first;
+				}
+			}
+			$socket->send(pack('N', $seq++) . ('u' x 28));
+			$sent++;
+		}
+		# late echoes
+		while ($select->can_read(0.5)) {
+			my $data;
+			$socket->recv($data, 128);
+			$echoed++ if unpack('N', $data) >= $first;
+		}
+		my $elapsed = time - $start - 0.5;
+		result(sprintf("udp offered %d/s echoed %.0f/s loss %.1f%%",
+			$rate, $echoed / $elapsed, 100 * (1 - $echoed / $sent)));
+	}
+	$socket->close();
+}
@@ -96,20 +96,8 @@ void Enc28J60Network::init(uint8_t* macaddr)
   // TX end
   //writeRegPair(ETXNDL, TXSTOP_INIT);
   // do bank 1 stuff, packet filter:
-  // For broadcast packets we allow only ARP packtets
-  // All other packets should be unicast only for our mac (MAADR)
-  //
-  // The pattern to match on is therefore
-  // Type     ETH.DST
-  // ARP      BROADCAST
-  // 06 08 -- ff ff ff ff ff ff -> ip checksum for theses bytes=f7f9
-  // in binary these poitions are:11 0000 0011 1111
-  // This is hex 303F->EPMM0=0x3f,EPMM1=0x30
-  //TODO define specific pattern to receive dhcp-broadcast packages instead of setting ERFCON_BCEN!
-  writeReg(ERXFCON, ERXFCON_UCEN|ERXFCON_CRCEN|ERXFCON_PMEN|ERXFCON_BCEN);
-  writeRegPair(EPMM0, 0x303f);
-  writeRegPair(EPMCSL, 0xf7f9);
-  //
+  // until an address is configured any ARP and all other broadcasts pass
+  setReceiveFilter(NULL,true);
   //
   // do bank 2 stuff
   // enable MAC receive
@@ -200,6 +188,42 @@ Enc28J60Network::receivePacket()
   return (NOBLOCK);
 }
 
+void
+Enc28J60Network::setReceiveFilter(const uint8_t *ip, bool broadcast)
+{
+  // For broadcast packets we allow only ARP packets, for the target address ip
+  // All other packets should be unicast only for our mac (MAADR), unless broadcast is set
+  //
+  // The pattern to match on is therefore
+  // Type     ETH.DST               ARP target IP
+  // ARP      BROADCAST             (bytes 38-41)
+  // 06 08 -- ff ff ff ff ff ff -- ip[0..3]
+  // in binary these positions are: 11 1100 0000 0000 0000 0000 0000 0011 0000 0011 1111
+  // This is hex 3C00000303F->EPMM0=0x3f,EPMM1=0x30,EPMM4=0xc0,EPMM5=0x03
+  // The checksum is the ip checksum of the selected bytes (f7f9 without the ip)
+  uint32_t sum = 3*0xffffUL + 0x0806;
+  if (ip)
+    sum += ((uint16_t)ip[0] << 8 | ip[1]) + ((uint16_t)ip[2] << 8 | ip[3]);
+  while (sum >> 16)
+    sum = (sum & 0xffff) + (sum >> 16);
+  // don't change the filter while a packet comes in
+  bool rx = readReg(ECON1) & ECON1_RXEN;
+  if (rx)
+    {
+      writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, ECON1_RXEN);
+      while (readReg(ESTAT) & ESTAT_RXBUSY);
+    }
+  writeRegPair(EPMOL, 0);
+  writeRegPair(EPMM0, 0x303f);
+  writeRegPair(EPMM2, 0);
+  writeRegPair(EPMM4, ip ? 0x03c0 : 0);
+  writeRegPair(EPMM6, 0);
+  writeRegPair(EPMCSL, (uint16_t)~sum);
+  writeReg(ERXFCON, ERXFCON_UCEN|ERXFCON_CRCEN|ERXFCON_PMEN|(broadcast ? ERXFCON_BCEN : 0));
+  if (rx)
+    writeOp(ENC28J60_BIT_FIELD_SET, ECON1, ECON1_RXEN);
+}
+
 void
 Enc28J60Network::setERXRDPT()
 {
@@ -241,6 +265,13 @@ Enc28J60Network::sendPacket(memhandle handle)
   Serial.println();
 #endif
 
+  // wait for the previous packet to go out, packets may be sent back to back
+  while (readReg(ECON1) & ECON1_TXRTS)
+    {
+      if (readReg(EIR) & EIR_TXERIF)
+        writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, ECON1_TXRTS);
+    }
+
   // TX start
   writeRegPair(ETXSTL, start);
   // Set the TXND pointer to correspond to the packet size given
@@ -279,6 +310,15 @@ Enc28J60Network::readPacket(memhandle handle, memaddress position, uint8_t* buff
   return len;
 }
 
+// stream packet data to sink in one SPI transaction, returns the number of bytes
+// the sink accepted. The sink is called with the chip selected, it must not use SPI.
+uint16_t
+Enc28J60Network::readPacket(memhandle handle, memaddress position, enc28j60_sink sink, void* arg, uint16_t len)
+{
+  len = setReadPtr(handle, position, len);
+  return readBuffer(len, sink, arg);
+}
+
 uint16_t
 Enc28J60Network::writePacket(memhandle handle, memaddress position, uint8_t* buffer, uint16_t len)
 {
@@ -433,34 +473,63 @@ Enc28J60Network::readBuffer(uint16_t len, uint8_t* data)
   // issue read command
   SPDR = ENC28J60_READ_BUF_MEM;
   waitspi();
-  while(len)
+  if (len)
   {
-    len--;
-    // read data
+    // start clocking in the first byte
     SPDR = 0x00;
+    while(--len)
+    {
+      waitspi();
+      // fetch the received byte and start the next transfer right away,
+      // storing it overlaps with the transfer
+      uint8_t c = SPDR;
+      SPDR = 0x00;
+      *data++ = c;
+    }
     waitspi();
     *data = SPDR;
-    data++;
   }
   //*data='\0';
   CSPASSIVE;
 }
 
+uint16_t
+Enc28J60Network::readBuffer(uint16_t len, enc28j60_sink sink, void* arg)
+{
+  uint16_t count = 0;
+  CSACTIVE;
+  // issue read command
+  SPDR = ENC28J60_READ_BUF_MEM;
+  waitspi();
+  while(count < len)
+  {
+    // read data
+    SPDR = 0x00;
+    waitspi();
+    count++;
+    if (!sink(SPDR,arg))
+      break;
+  }
+  CSPASSIVE;
+  return count;
+}
+
 void
 Enc28J60Network::writeBuffer(uint16_t len, uint8_t* data)
 {
   CSACTIVE;
   // issue write command
   SPDR = ENC28J60_WRITE_BUF_MEM;
-  waitspi();
   while(len)
   {
     len--;
-    // write data
-    SPDR = *data;
-    data++;
+    // load the next byte while the previous one is still shifting out
+    uint8_t c = *data++;
     waitspi();
+    // write data
+    SPDR = c;
   }
+  waitspi();
   CSPASSIVE;
 }
 
@@ -545,6 +614,40 @@ Enc28J60Network::getrev(void)
   return(readReg(EREVID));
 }
 
+#ifdef ENC28J60_DMA_CHECKSUM
+uint16_t
+Enc28J60Network::chksum(uint16_t sum, memhandle handle, memaddress pos, uint16_t len)
+{
+  memblock *packet = handle == UIP_RECEIVEBUFFERHANDLE ? &receivePkt : &blocks[handle];
+  memaddress start = handle == UIP_RECEIVEBUFFERHANDLE && packet->begin + pos > RXSTOP_INIT ? packet->begin + pos-RXSTOP_INIT+RXSTART_INIT : packet->begin + pos;
+  if (len > packet->size - pos)
+    len = packet->size - pos;
+  if (!len)
+    return sum;
+  // calculate address of last byte, the DMA wraps around at the end of the receive buffer
+  memaddress end = start + len - 1;
+  if ((start <= RXSTOP_INIT) && (end > RXSTOP_INIT)) end -= (RXSTOP_INIT-RXSTART_INIT);
+
+  writeRegPair(EDMASTL, start);
+  writeRegPair(EDMANDL, end);
+  // checksum mode (odd length is padded with 0 like the software version does)
+  writeOp(ENC28J60_BIT_FIELD_SET, ECON1, ECON1_CSUMEN);
+  writeOp(ENC28J60_BIT_FIELD_SET, ECON1, ECON1_DMAST);
+  // wait until runnig DMA is completed
+  while (readOp(ENC28J60_READ_CTRL_REG, ECON1) & ECON1_DMAST);
+  writeOp(ENC28J60_BIT_FIELD_CLR, ECON1, ECON1_CSUMEN);
+
+  // the chip returns the complemented sum, undo that and add it to the running sum
+  uint16_t t = ~((readReg(EDMACSH) << 8) | readReg(EDMACSL));
+  sum += t;
+  if(sum < t) {
+    sum++;            /* carry */
+  }
+
+  /* Return sum in host byte order. */
+  return sum;
+}
+#else
 uint16_t
 Enc28J60Network::chksum(uint16_t sum, memhandle handle, memaddress pos, uint16_t len)
 {
@@ -583,6 +686,7 @@ Enc28J60Network::chksum(uint16_t sum, memhandle handle, memaddress pos, uint16_t
   /* Return sum in host byte order. */
   return sum;
 }
+#endif
 
 void
 Enc28J60Network::powerOff()
@@ -37,6 +37,17 @@
 
 //#define ENC28J60DEBUG
 
+/*
+ * Let the ENC28J60 DMA engine sum up packet data that sits in the chip's buffer
+ * (TCP/UDP payload of received and sent packets) instead of reading it over SPI.
+ * Silicon errata: packets received while a DMA checksum runs may be lost on some
+ * revisions, uIP retransmits them (TCP) - leave it off if that is not acceptable.
+ */
+//#define ENC28J60_DMA_CHECKSUM
+
+// Receives packet data byte by byte, return false to stop reading
+typedef bool (*enc28j60_sink)(uint8_t c, void* arg);
+
 /*
  * Empfangen von ip-header, arp etc...
  * wenn tcp/udp -> tcp/udp-callback -> assign new packet to connection
@@ -56,6 +67,7 @@ private:
   static uint16_t setReadPtr(memhandle handle, memaddress position, uint16_t len);
   static void setERXRDPT();
   static void readBuffer(uint16_t len, uint8_t* data);
+  static uint16_t readBuffer(uint16_t len, enc28j60_sink sink, void* arg);
   static void writeBuffer(uint16_t len, uint8_t* data);
   static uint8_t readByte(uint16_t addr);
   static void writeByte(uint16_t addr, uint8_t data);
@@ -78,10 +90,14 @@ public:
 
   static void init(uint8_t* macaddr);
   static memhandle receivePacket();
+  // Receive unicast to our MAC and ARP requests for ip (any ARP if ip is NULL),
+  // all other broadcasts only if broadcast is set. Others are dropped by the chip
+  static void setReceiveFilter(const uint8_t *ip, bool broadcast);
   static void freePacket();
   static memaddress blockSize(memhandle handle);
   static void sendPacket(memhandle handle);
   static uint16_t readPacket(memhandle handle, memaddress position, uint8_t* buffer, uint16_t len);
+  static uint16_t readPacket(memhandle handle, memaddress position, enc28j60_sink sink, void* arg, uint16_t len);
   static uint16_t writePacket(memhandle handle, memaddress position, uint8_t* buffer, uint16_t len);
   static void copyPacket(memhandle dest, memaddress dest_pos, memhandle src, memaddress src_pos, uint16_t len);
   static uint16_t chksum(uint16_t sum, memhandle handle, memaddress pos, uint16_t len);
@@ -23,6 +23,10 @@
 #define POOLOFFSET 1
 
 struct memblock MemoryPool::blocks[MEMPOOL_NUM_MEMBLOCKS+1];
+#ifdef MEMPOOL_STATS
+uint16_t MemoryPool::compactions;
+uint32_t MemoryPool::movedBytes;
+#endif
 
 void
 MemoryPool::init()
@@ -69,7 +73,11 @@ MemoryPool::allocBlock(memaddress size)
 
   collect:
     {
-      cur = POOLSTART;
+      // no gap is large enough (best fit failed). Move blocks down one by one, but only
+      // until the free space collected behind the last moved block is enough.
+#ifdef MEMPOOL_STATS
+      compactions++;
+#endif
       block = &blocks[POOLSTART];
       memhandle next;
       while ((next = block->nextblock) != NOBLOCK)
@@ -81,15 +89,21 @@ MemoryPool::allocBlock(memaddress size)
             {
 #ifdef MEMPOOL_MEMBLOCK_MV
               MEMPOOL_MEMBLOCK_MV(dest,*src,nextblock->size);
+#endif
+#ifdef MEMPOOL_STATS
+              movedBytes += nextblock->size;
 #endif
               *src = dest;
             }
           block = nextblock;
+          next = block->nextblock;
+          if (( next == NOBLOCK ? blocks[POOLSTART].begin + MEMPOOL_SIZE : blocks[next].begin) - block->begin - block->size >= size)
+            {
+              best = block;
+              goto found;
+            }
         }
-      if (blocks[POOLSTART].begin + MEMPOOL_SIZE - block->begin - block->size >= size)
-        best = block;
-      else
-        goto notfound;
+      goto notfound;
     }
 
   found:
@@ -166,3 +180,32 @@ MemoryPool::blockSize(memhandle handle)
 {
   return blocks[handle].size;
 }
+
+memaddress
+MemoryPool::freeSize()
+{
+  memaddress used = 0;
+  for (memhandle cur = blocks[POOLSTART].nextblock; cur != NOBLOCK; cur = blocks[cur].nextblock)
+    used += blocks[cur].size;
+  return MEMPOOL_SIZE - used;
+}
+
+// size of the largest block that can be allocated without moving blocks,
+// fragmentation is 1 - largestFree()/freeSize()
+memaddress
+MemoryPool::largestFree()
+{
+  memaddress largest = 0;
+  memblock* block = &blocks[POOLSTART];
+  do
+    {
+      memhandle next = block->nextblock;
+      memaddress freesize = ( next == NOBLOCK ? blocks[POOLSTART].begin + MEMPOOL_SIZE : blocks[next].begin) - block->begin - block->size;
+      if (freesize > largest)
+        largest = freesize;
+      if (next == NOBLOCK)
+        return largest;
+      block = &blocks[next];
+    }
+  while (true);
+}
@@ -50,5 +50,12 @@ public:
   static void resizeBlock(memhandle handle, memaddress position);
   static void resizeBlock(memhandle handle, memaddress position, memaddress size);
   static memaddress blockSize(memhandle);
+  static memaddress freeSize();
+  static memaddress largestFree();
+#ifdef MEMPOOL_STATS
+  // allocations that had to move blocks, and the number of bytes moved for them
+  static uint16_t compactions;
+  static uint32_t movedBytes;
+#endif
 };
 #endif
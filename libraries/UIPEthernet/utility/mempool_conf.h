@@ -17,12 +17,16 @@ typedef uint8_t memhandle;
 #endif
 
 #if UIP_UDP and UIP_UDP_CONNS
-#define NUM_UDP_MEMBLOCKS 3*UIP_UDP_CONNS
+#define NUM_UDP_MEMBLOCKS (UIP_UDP_RXQUEUE+2)*UIP_UDP_CONNS
 #else
 #define NUM_UDP_MEMBLOCKS 0
 #endif
 
+#ifdef UIP_CONF_MEMBLOCKS
+#define MEMPOOL_NUM_MEMBLOCKS UIP_CONF_MEMBLOCKS
+#else
 #define MEMPOOL_NUM_MEMBLOCKS (NUM_TCP_MEMBLOCKS+NUM_UDP_MEMBLOCKS)
+#endif
 
 #define MEMPOOL_STARTADDRESS TXSTART_INIT+1
 #define MEMPOOL_SIZE TXSTOP_INIT-TXSTART_INIT
@@ -31,4 +35,7 @@ void enc28J60_mempool_block_move_callback(memaddress,memaddress,memaddress);
 
 #define MEMPOOL_MEMBLOCK_MV(dest,src,size) enc28J60_mempool_block_move_callback(dest,src,size)
 
+// count compactions and moved bytes in MemoryPool::compactions/movedBytes
+//#define MEMPOOL_STATS
+
 #endif
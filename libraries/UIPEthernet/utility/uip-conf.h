@@ -178,6 +178,10 @@ void uipudp_appcall(void);
 
 #define UIP_UDP_APPCALL uipudp_appcall
 
+void uipethernet_arp_release(u8_t packet, const u8_t *ethaddr);
+
+#define UIP_ARP_RELEASE uipethernet_arp_release
+
 #define CC_REGISTER_ARG register
 
 #define UIP_ARCH_CHKSUM 1
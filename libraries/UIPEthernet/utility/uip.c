@@ -157,6 +157,12 @@ u16_t uip_len, uip_slen;
 				depending on the maximum packet
 				size. */
 
+#if UIP_SEND_WINDOW > 1
+u16_t uip_ackedlen;          /* Bytes acknowledged by the current packet. */
+static u16_t uip_sndoff;     /* Offset of the segment being sent from
+				snd_nxt (the oldest unacknowledged byte). */
+#endif /* UIP_SEND_WINDOW > 1 */
+
 u8_t uip_flags;     /* The uip_flags variable is used for
 				communication between the TCP/IP stack
 				and the application program. */
@@ -678,6 +684,33 @@ uip_add_rcv_nxt(u16_t n)
   uip_conn->rcv_nxt[3] = uip_acc32[3];
 }
 /*---------------------------------------------------------------------------*/
+#if UIP_SEND_WINDOW > 1
+static u16_t
+sendwnd(struct uip_conn *conn)
+{
+  u16_t wnd = UIP_SEND_WINDOW * conn->mss;
+  if(conn->snd_wnd < wnd) {
+    wnd = conn->snd_wnd;
+  }
+  if(conn->len == 0) {
+    /* Nothing in flight, an entire MSS may be sent (as without a send
+       window, this also probes a zero window). */
+    return conn->mss;
+  }
+  if(conn->len >= wnd) {
+    return 0;
+  }
+  wnd -= conn->len;
+  return wnd > conn->mss ? conn->mss : wnd;
+}
+
+u16_t
+uip_sendwnd(void)
+{
+  return sendwnd(uip_conn);
+}
+#endif /* UIP_SEND_WINDOW > 1 */
+/*---------------------------------------------------------------------------*/
 void
 uip_process(u8_t flag)
 {
@@ -695,7 +728,11 @@ uip_process(u8_t flag)
      particular connection. */
   if(flag == UIP_POLL_REQUEST) {
     if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+#if UIP_SEND_WINDOW > 1
+       sendwnd(uip_connr) > 0) {
+#else /* UIP_SEND_WINDOW > 1 */
        !uip_outstanding(uip_connr)) {
+#endif /* UIP_SEND_WINDOW > 1 */
 	uip_flags = UIP_POLL;
 	UIP_APPCALL();
 	goto appsend;
@@ -788,6 +825,20 @@ uip_process(u8_t flag)
                label). */
 	    uip_flags = UIP_REXMIT;
 	    UIP_APPCALL();
+#if UIP_SEND_WINDOW > 1
+	    /* Go back to the oldest unacknowledged byte: what the
+	       application resends now is all that is outstanding
+	       afterwards, later data goes out again as new segments. */
+	    if(uip_slen > uip_connr->len) {
+	      uip_slen = uip_connr->len;
+	    }
+	    if(uip_slen > uip_connr->mss) {
+	      uip_slen = uip_connr->mss;
+	    }
+	    if(uip_slen > 0) {
+	      uip_connr->len = uip_slen;
+	    }
+#endif /* UIP_SEND_WINDOW > 1 */
 	    goto apprexmit;
 	    
 	  case UIP_FIN_WAIT_1:
@@ -1420,12 +1471,30 @@ uip_process(u8_t flag)
      the outstanding data, calculate RTT estimations, and reset the
      retransmission timer. */
   if((BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
+#if UIP_SEND_WINDOW > 1
+    /* With several segments in flight, an ACK may cover only the
+       first ones. */
+    {
+      uint32_t acked = (((uint32_t)BUF->ackno[0] << 24) | ((uint32_t)BUF->ackno[1] << 16) |
+		     ((u16_t)BUF->ackno[2] << 8) | BUF->ackno[3]) -
+	(((uint32_t)uip_connr->snd_nxt[0] << 24) | ((uint32_t)uip_connr->snd_nxt[1] << 16) |
+	 ((u16_t)uip_connr->snd_nxt[2] << 8) | uip_connr->snd_nxt[3]);
+      if(acked > 0 && acked <= uip_connr->len) {
+	uip_ackedlen = acked;
+	uip_add32(uip_connr->snd_nxt, uip_ackedlen);
+      } else {
+	uip_ackedlen = 0;
+      }
+    }
+    if(uip_ackedlen > 0) {
+#else /* UIP_SEND_WINDOW > 1 */
     uip_add32(uip_connr->snd_nxt, uip_connr->len);
 
     if(BUF->ackno[0] == uip_acc32[0] &&
        BUF->ackno[1] == uip_acc32[1] &&
        BUF->ackno[2] == uip_acc32[2] &&
        BUF->ackno[3] == uip_acc32[3]) {
+#endif /* UIP_SEND_WINDOW > 1 */
       /* Update sequence number. */
       uip_connr->snd_nxt[0] = uip_acc32[0];
       uip_connr->snd_nxt[1] = uip_acc32[1];
@@ -1434,7 +1503,13 @@ uip_process(u8_t flag)
 	
 
       /* Do RTT estimation, unless we have done retransmissions. */
+#if UIP_SEND_WINDOW > 1
+      /* The timer runs from the last segment sent, so only an ACK for
+	 everything gives an RTT sample. */
+      if(uip_connr->nrtx == 0 && uip_connr->len == uip_ackedlen) {
+#else /* UIP_SEND_WINDOW > 1 */
       if(uip_connr->nrtx == 0) {
+#endif /* UIP_SEND_WINDOW > 1 */
 	signed char m;
 	m = uip_connr->rto - uip_connr->timer;
 	/* This is taken directly from VJs original code in his paper */
@@ -1454,7 +1529,11 @@ uip_process(u8_t flag)
       uip_connr->timer = uip_connr->rto;
 
       /* Reset length of outstanding data. */
+#if UIP_SEND_WINDOW > 1
+      uip_connr->len -= uip_ackedlen;
+#else /* UIP_SEND_WINDOW > 1 */
       uip_connr->len = 0;
+#endif /* UIP_SEND_WINDOW > 1 */
     }
     
   }
@@ -1619,6 +1698,9 @@ uip_process(u8_t flag)
        "persistent timer" and uses the retransmission mechanim.
     */
     tmp16 = ((u16_t)BUF->wnd[0] << 8) + (u16_t)BUF->wnd[1];
+#if UIP_SEND_WINDOW > 1
+    uip_connr->snd_wnd = tmp16;
+#endif /* UIP_SEND_WINDOW > 1 */
     if(tmp16 > uip_connr->initialmss ||
        tmp16 == 0) {
       tmp16 = uip_connr->initialmss;
@@ -1664,6 +1746,24 @@ uip_process(u8_t flag)
       }
 
       /* If uip_slen > 0, the application has data to be sent. */
+#if UIP_SEND_WINDOW > 1
+      if(uip_slen > 0) {
+	/* New data goes out behind what is already in flight. A segment
+	   that does not fit into the window is not sent (the application
+	   asks uip_sendwnd() first). */
+	tmp16 = sendwnd(uip_connr);
+	if(uip_slen > tmp16) {
+	  uip_slen = uip_connr->len == 0 ? tmp16 : 0;
+	}
+	if(uip_slen > 0) {
+	  if(uip_connr->len == 0) {
+	    uip_connr->timer = uip_connr->rto;
+	  }
+	  uip_sndoff = uip_connr->len;
+	  uip_connr->len += uip_slen;
+	}
+      }
+#else /* UIP_SEND_WINDOW > 1 */
       if(uip_slen > 0) {
 
 	/* If the connection has acknowledged data, the contents of
@@ -1695,6 +1795,7 @@ uip_process(u8_t flag)
 	  uip_slen = uip_connr->len;
 	}
       }
+#endif /* UIP_SEND_WINDOW > 1 */
       uip_connr->nrtx = 0;
     apprexmit:
       uip_appdata = uip_sappdata;
@@ -1703,7 +1804,11 @@ uip_process(u8_t flag)
          packet had new data in it, we must send out a packet. */
       if(uip_slen > 0 && uip_connr->len > 0) {
 	/* Add the length of the IP and TCP headers. */
+#if UIP_SEND_WINDOW > 1
+	uip_len = uip_slen + UIP_TCPIP_HLEN;
+#else /* UIP_SEND_WINDOW > 1 */
 	uip_len = uip_connr->len + UIP_TCPIP_HLEN;
+#endif /* UIP_SEND_WINDOW > 1 */
 	/* We always set the ACK flag in response packets. */
 	BUF->flags = TCP_ACK | TCP_PSH;
 	/* Send the packet. */
@@ -1804,10 +1909,19 @@ uip_process(u8_t flag)
   BUF->ackno[2] = uip_connr->rcv_nxt[2];
   BUF->ackno[3] = uip_connr->rcv_nxt[3];
   
+#if UIP_SEND_WINDOW > 1
+  uip_add32(uip_connr->snd_nxt, uip_sndoff);
+  uip_sndoff = 0;
+  BUF->seqno[0] = uip_acc32[0];
+  BUF->seqno[1] = uip_acc32[1];
+  BUF->seqno[2] = uip_acc32[2];
+  BUF->seqno[3] = uip_acc32[3];
+#else /* UIP_SEND_WINDOW > 1 */
   BUF->seqno[0] = uip_connr->snd_nxt[0];
   BUF->seqno[1] = uip_connr->snd_nxt[1];
   BUF->seqno[2] = uip_connr->snd_nxt[2];
   BUF->seqno[3] = uip_connr->snd_nxt[3];
+#endif /* UIP_SEND_WINDOW > 1 */
 
   BUF->proto = UIP_PROTO_TCP;
   
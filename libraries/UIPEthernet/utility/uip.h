@@ -510,6 +510,20 @@ struct uip_conn *uip_connect(uip_ipaddr_t *ripaddr, u16_t port);
  */
 #define uip_outstanding(conn) ((conn)->len)
 
+#if UIP_SEND_WINDOW > 1
+/**
+ * The number of bytes acknowledged by the current packet (valid if
+ * uip_acked() is true). All outstanding data if UIP_SEND_WINDOW is 1.
+ */
+extern u16_t uip_ackedlen;
+
+/**
+ * The number of bytes that may be sent as a new segment on the
+ * current connection without exceeding the send window.
+ */
+u16_t uip_sendwnd(void);
+#endif /* UIP_SEND_WINDOW > 1 */
+
 /**
  * Send data on the current connection.
  *
@@ -1175,6 +1189,10 @@ struct uip_conn {
   u8_t timer;         /**< The retransmission timer. */
   u8_t nrtx;          /**< The number of retransmissions for the last
 			 segment sent. */
+#if UIP_SEND_WINDOW > 1
+  u16_t snd_wnd;      /**< The window last advertised by the remote
+			 host. */
+#endif /* UIP_SEND_WINDOW > 1 */
 
   /** The application state. */
   uip_tcp_appstate_t appstate;
@@ -96,10 +96,20 @@ struct ethip_hdr {
 
 #define ARP_HWTYPE_ETH 1
 
+#define ARP_FREE       0
+#define ARP_RESOLVED   1
+#define ARP_INCOMPLETE 2 /* request sent in this timer period */
+#define ARP_RETRY      3 /* unresolved, another request may be sent */
+
 struct arp_entry {
   u16_t ipaddr[2];
   struct uip_eth_addr ethaddr;
   u8_t time;
+  u8_t lru;
+  u8_t state;
+#if UIP_ARP_HOLD
+  u8_t hold;
+#endif /* UIP_ARP_HOLD */
 };
 
 static const struct uip_eth_addr broadcast_ethaddr =
@@ -111,8 +121,13 @@ static u16_t ipaddr[2];
 static u8_t i, c;
 
 static u8_t arptime;
+static u8_t arplru;
 static u8_t tmpage;
 
+#if UIP_ARP_HOLD
+u8_t uip_arp_held;
+#endif /* UIP_ARP_HOLD */
+
 #define BUF   ((struct arp_hdr *)&uip_buf[0])
 #define IPBUF ((struct ethip_hdr *)&uip_buf[0])
 /*-----------------------------------------------------------------------------------*/
@@ -124,9 +139,107 @@ static u8_t tmpage;
 void
 uip_arp_init(void)
 {
+  memset(arp_table, 0, sizeof(arp_table));
+}
+/*-----------------------------------------------------------------------------------*/
+/* Entries are looked up starting at the slot given by the last octet
+   of the IP address, so a lookup usually hits on the first probe. */
+#define arp_hash(addr) (((u8_t *)(addr))[3] % UIP_ARPTAB_SIZE)
+
+static struct arp_entry *
+arp_find(u16_t *ipaddr)
+{
+  register struct arp_entry *tabptr;
+
+  c = arp_hash(ipaddr);
   for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
-    memset(arp_table[i].ipaddr, 0, 4);
+    tabptr = &arp_table[c];
+    if(tabptr->state != ARP_FREE &&
+       uip_ipaddr_cmp(ipaddr, tabptr->ipaddr)) {
+      return tabptr;
+    }
+    if(++c == UIP_ARPTAB_SIZE) {
+      c = 0;
+    }
+  }
+  return NULL;
+}
+/*-----------------------------------------------------------------------------------*/
+static void
+arp_free(struct arp_entry *tabptr)
+{
+#if UIP_ARP_HOLD
+  if(tabptr->hold) {
+    /* Nobody answered, drop the frame. */
+    UIP_ARP_RELEASE(tabptr->hold, NULL);
+    tabptr->hold = 0;
+  }
+#endif /* UIP_ARP_HOLD */
+  tabptr->state = ARP_FREE;
+  memset(tabptr->ipaddr, 0, 4);
+}
+/*-----------------------------------------------------------------------------------*/
+/* Take a free slot for ipaddr, preferably the one it hashes to. If
+   the table is full the least recently used entry is thrown away. */
+static struct arp_entry *
+arp_alloc(u16_t *ipaddr)
+{
+  register struct arp_entry *tabptr;
+
+  c = arp_hash(ipaddr);
+  tmpage = 0;
+  tabptr = &arp_table[c];
+  for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
+    if(arp_table[c].state == ARP_FREE) {
+      tabptr = &arp_table[c];
+      break;
+    }
+    if((u8_t)(arplru - arp_table[c].lru) > tmpage) {
+      tmpage = arplru - arp_table[c].lru;
+      tabptr = &arp_table[c];
+    }
+    if(++c == UIP_ARPTAB_SIZE) {
+      c = 0;
+    }
+  }
+  if(tabptr->state != ARP_FREE) {
+    arp_free(tabptr);
   }
+  uip_ipaddr_copy(tabptr->ipaddr, ipaddr);
+  tabptr->time = arptime;
+  tabptr->state = ARP_RETRY;
+  return tabptr;
+}
+/*-----------------------------------------------------------------------------------*/
+/* Replace whatever is in uip_buf[] with an ARP request for the
+   entry, unless one has been sent for it in this timer period
+   already (uip_len is 0 then). */
+static void
+arp_request(struct arp_entry *tabptr)
+{
+  if(tabptr->state != ARP_RETRY) {
+    uip_len = 0;
+    return;
+  }
+  tabptr->state = ARP_INCOMPLETE;
+
+  memset(BUF->ethhdr.dest.addr, 0xff, 6);
+  memset(BUF->dhwaddr.addr, 0x00, 6);
+  memcpy(BUF->ethhdr.src.addr, uip_ethaddr.addr, 6);
+  memcpy(BUF->shwaddr.addr, uip_ethaddr.addr, 6);
+
+  uip_ipaddr_copy(BUF->dipaddr, tabptr->ipaddr);
+  uip_ipaddr_copy(BUF->sipaddr, uip_hostaddr);
+  BUF->opcode = HTONS(ARP_REQUEST); /* ARP request. */
+  BUF->hwtype = HTONS(ARP_HWTYPE_ETH);
+  BUF->protocol = HTONS(UIP_ETHTYPE_IP);
+  BUF->hwlen = 6;
+  BUF->protolen = 4;
+  BUF->ethhdr.type = HTONS(UIP_ETHTYPE_ARP);
+
+  uip_appdata = &uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN];
+
+  uip_len = sizeof(struct arp_hdr);
 }
 /*-----------------------------------------------------------------------------------*/
 /**
@@ -144,77 +257,96 @@ uip_arp_timer(void)
   struct arp_entry *tabptr;
   
   ++arptime;
-  for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
-    tabptr = &arp_table[i];
-    if((tabptr->ipaddr[0] | tabptr->ipaddr[1]) != 0 &&
-       arptime - tabptr->time >= UIP_ARP_MAXAGE) {
-      memset(tabptr->ipaddr, 0, 4);
+  for(tabptr = arp_table; tabptr < &arp_table[UIP_ARPTAB_SIZE]; ++tabptr) {
+    switch(tabptr->state) {
+    case ARP_RESOLVED:
+      if((u8_t)(arptime - tabptr->time) >= UIP_ARP_MAXAGE) {
+	arp_free(tabptr);
+      }
+      break;
+    case ARP_INCOMPLETE:
+    case ARP_RETRY:
+      /* Remember an address that does not answer for a while, so
+	 every packet to it does not cause another request. */
+      if((u8_t)(arptime - tabptr->time) >= UIP_ARP_MAXPENDING) {
+	arp_free(tabptr);
+      } else {
+	tabptr->state = ARP_RETRY;
+      }
+      break;
     }
   }
 
 }
 /*-----------------------------------------------------------------------------------*/
-static void
-uip_arp_update(u16_t *ipaddr, struct uip_eth_addr *ethaddr)
+/**
+ * Allow another ARP request for addresses that have not answered yet.
+ *
+ * Without it an unresolved address is asked for once per
+ * uip_arp_timer() period, so the first packets to a new host can wait
+ * up to 10 seconds when the first request or its reply is lost. Call
+ * it at a shorter interval while it returns a non-zero value.
+ *
+ * \return The number of unresolved addresses in the table.
+ */
+/*-----------------------------------------------------------------------------------*/
+static u8_t
+arp_unresolved(u8_t retry)
 {
-  register struct arp_entry *tabptr;
-  /* Walk through the ARP mapping table and try to find an entry to
-     update. If none is found, the IP -> MAC address mapping is
-     inserted in the ARP table. */
-  for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
-
-    tabptr = &arp_table[i];
-    /* Only check those entries that are actually in use. */
-    if(tabptr->ipaddr[0] != 0 &&
-       tabptr->ipaddr[1] != 0) {
-
-      /* Check if the source IP address of the incoming packet matches
-         the IP address in this ARP table entry. */
-      if(ipaddr[0] == tabptr->ipaddr[0] &&
-	 ipaddr[1] == tabptr->ipaddr[1]) {
-	 
-	/* An old entry found, update this and return. */
-	memcpy(tabptr->ethaddr.addr, ethaddr->addr, 6);
-	tabptr->time = arptime;
+  struct arp_entry *tabptr;
+  u8_t pending = 0;
 
-	return;
+  for(tabptr = arp_table; tabptr < &arp_table[UIP_ARPTAB_SIZE]; ++tabptr) {
+    if(tabptr->state == ARP_INCOMPLETE || tabptr->state == ARP_RETRY) {
+      if(retry) {
+	tabptr->state = ARP_RETRY;
       }
+      ++pending;
     }
   }
+  return pending;
+}
 
-  /* If we get here, no existing ARP table entry was found, so we
-     create one. */
-
-  /* First, we try to find an unused entry in the ARP table. */
-  for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
-    tabptr = &arp_table[i];
-    if(tabptr->ipaddr[0] == 0 &&
-       tabptr->ipaddr[1] == 0) {
-      break;
-    }
-  }
-
-  /* If no unused entry is found, we try to find the oldest entry and
-     throw it away. */
-  if(i == UIP_ARPTAB_SIZE) {
-    tmpage = 0;
-    c = 0;
-    for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
-      tabptr = &arp_table[i];
-      if(arptime - tabptr->time > tmpage) {
-	tmpage = arptime - tabptr->time;
-	c = i;
-      }
-    }
-    i = c;
-    tabptr = &arp_table[i];
+u8_t
+uip_arp_retry(void)
+{
+  return arp_unresolved(1);
+}
+/*-----------------------------------------------------------------------------------*/
+/**
+ * The number of unresolved addresses in the table, without allowing
+ * new requests for them.
+ */
+/*-----------------------------------------------------------------------------------*/
+u8_t
+uip_arp_pending(void)
+{
+  return arp_unresolved(0);
+}
+/*-----------------------------------------------------------------------------------*/
+static void
+uip_arp_update(u16_t *ipaddr, struct uip_eth_addr *ethaddr)
+{
+  register struct arp_entry *tabptr;
+  /* Look up the IP -> MAC address mapping and update it. If none is
+     found, it is inserted in the ARP table. */
+  tabptr = arp_find(ipaddr);
+  if(tabptr == NULL) {
+    tabptr = arp_alloc(ipaddr);
   }
 
-  /* Now, i is the ARP table entry which we will fill with the new
-     information. */
-  memcpy(tabptr->ipaddr, ipaddr, 4);
   memcpy(tabptr->ethaddr.addr, ethaddr->addr, 6);
   tabptr->time = arptime;
+  tabptr->lru = ++arplru;
+  tabptr->state = ARP_RESOLVED;
+
+#if UIP_ARP_HOLD
+  if(tabptr->hold) {
+    /* The frame that has been waiting for this address can go out. */
+    UIP_ARP_RELEASE(tabptr->hold, tabptr->ethaddr.addr);
+    tabptr->hold = 0;
+  }
+#endif /* UIP_ARP_HOLD */
 }
 /*-----------------------------------------------------------------------------------*/
 /**
@@ -377,34 +509,28 @@ uip_arp_out(void)
       uip_ipaddr_copy(ipaddr, IPBUF->destipaddr);
     }
       
-    for(i = 0; i < UIP_ARPTAB_SIZE; ++i) {
-      tabptr = &arp_table[i];
-      if(uip_ipaddr_cmp(ipaddr, tabptr->ipaddr)) {
-	break;
-      }
+    tabptr = arp_find(ipaddr);
+    if(tabptr == NULL) {
+      tabptr = arp_alloc(ipaddr);
     }
-
-    if(i == UIP_ARPTAB_SIZE) {
+    tabptr->lru = ++arplru;
+
+    if(tabptr->state != ARP_RESOLVED) {
+#if UIP_ARP_HOLD
+      if(!tabptr->hold) {
+	/* Complete the frame and let the driver keep it until the
+	   reply arrives (uip_arp_hold()). */
+	memset(IPBUF->ethhdr.dest.addr, 0, 6);
+	memcpy(IPBUF->ethhdr.src.addr, uip_ethaddr.addr, 6);
+	IPBUF->ethhdr.type = HTONS(UIP_ETHTYPE_IP);
+	uip_len += sizeof(struct uip_eth_hdr);
+	uip_arp_held = tabptr - arp_table + 1;
+	return;
+      }
+#endif /* UIP_ARP_HOLD */
       /* The destination address was not in our ARP table, so we
 	 overwrite the IP packet with an ARP request. */
-
-      memset(BUF->ethhdr.dest.addr, 0xff, 6);
-      memset(BUF->dhwaddr.addr, 0x00, 6);
-      memcpy(BUF->ethhdr.src.addr, uip_ethaddr.addr, 6);
-      memcpy(BUF->shwaddr.addr, uip_ethaddr.addr, 6);
-    
-      uip_ipaddr_copy(BUF->dipaddr, ipaddr);
-      uip_ipaddr_copy(BUF->sipaddr, uip_hostaddr);
-      BUF->opcode = HTONS(ARP_REQUEST); /* ARP request. */
-      BUF->hwtype = HTONS(ARP_HWTYPE_ETH);
-      BUF->protocol = HTONS(UIP_ETHTYPE_IP);
-      BUF->hwlen = 6;
-      BUF->protolen = 4;
-      BUF->ethhdr.type = HTONS(UIP_ETHTYPE_ARP);
-
-      uip_appdata = &uip_buf[UIP_TCPIP_HLEN + UIP_LLH_LEN];
-    
-      uip_len = sizeof(struct arp_hdr);
+      arp_request(tabptr);
       return;
     }
 
@@ -418,6 +544,31 @@ uip_arp_out(void)
   uip_len += sizeof(struct uip_eth_hdr);
 }
 /*-----------------------------------------------------------------------------------*/
+#if UIP_ARP_HOLD
+/**
+ * Hand over the frame uip_arp_out() completed for an unresolved
+ * address.
+ *
+ * The driver calls this after it has stored the frame, with a handle
+ * that is passed to UIP_ARP_RELEASE() once the address is resolved
+ * (or the entry is given up, the ethaddr is NULL then). A handle of 0
+ * means the frame could not be stored.
+ *
+ * When the function returns, uip_buf[] contains the ARP request to
+ * send, if uip_len is non-zero.
+ */
+/*-----------------------------------------------------------------------------------*/
+void
+uip_arp_hold(u8_t handle)
+{
+  struct arp_entry *tabptr = &arp_table[uip_arp_held - 1];
+
+  uip_arp_held = 0;
+  tabptr->hold = handle;
+  arp_request(tabptr);
+}
+#endif /* UIP_ARP_HOLD */
+/*-----------------------------------------------------------------------------------*/
 
 /** @} */
 /** @} */
@@ -103,10 +103,28 @@ void uip_arp_arpin(void);
    the Ethernet frame that should be transmitted. */
 void uip_arp_out(void);
 
+#if UIP_ARP_HOLD
+/* If uip_arp_out() has no mapping for the destination yet and the
+   ARP table entry has no frame waiting, it only prepends the Ethernet
+   header and sets uip_arp_held. The driver then stores the frame and
+   calls uip_arp_hold(), which puts the ARP request into uip_buf. The
+   stored frame is handed back through UIP_ARP_RELEASE() when the
+   reply arrives. */
+extern u8_t uip_arp_held;
+void uip_arp_hold(u8_t handle);
+#endif /* UIP_ARP_HOLD */
+
 /* The uip_arp_timer() function should be called every ten seconds. It
    is responsible for flushing old entries in the ARP table. */
 void uip_arp_timer(void);
 
+/* The uip_arp_retry() function lets unresolved addresses be asked for
+   again before the next uip_arp_timer() call. It returns the number of
+   unresolved addresses, while that is non-zero it should be called
+   about once a second. uip_arp_pending() only counts them. */
+u8_t uip_arp_retry(void);
+u8_t uip_arp_pending(void);
+
 /** @} */
 
 /**
@@ -1,9 +1,25 @@
 #ifndef UIPETHERNET_CONF_H
 #define UIPETHERNET_CONF_H
 
+/* server profile: 4 TCP connections with 3 packet slots each, sharing 16 packet
+ * buffers. Needs about as much RAM as the default with UIP_CONF_MAX_CONNECTIONS 2 */
+//#define UIPETHERNET_SERVER_PROFILE
+
 /* for TCP */
+#ifdef UIPETHERNET_SERVER_PROFILE
+#define UIP_SOCKET_NUMPACKETS    3
+#define UIP_CONF_MAX_CONNECTIONS 4
+#define UIP_CONF_MEMBLOCKS       16
+#else
 #define UIP_SOCKET_NUMPACKETS    5
 #define UIP_CONF_MAX_CONNECTIONS 1
+#endif
+
+/* number of packet buffers shared by all TCP and UDP sockets (5 bytes RAM each).
+ * Sockets take buffers from this pool as data comes in and return them when it is read.
+ * If not set every socket can fill all its packet slots at the same time, which costs
+ * (2*UIP_SOCKET_NUMPACKETS*UIP_CONF_MAX_CONNECTIONS + (UIP_UDP_RXQUEUE+2)*UIP_CONF_UDP_CONNS) buffers */
+//#define UIP_CONF_MEMBLOCKS       16
 
 /* for UDP
  * set UIP_CONF_UDP to 0 to disable UDP (saves aprox. 5kb flash) */
@@ -11,6 +27,39 @@
 #define UIP_CONF_BROADCAST       1
 #define UIP_CONF_UDP_CONNS       4
 
+/* number of received datagrams a UDP socket keeps until parsePacket() takes them
+ * (1: the original behaviour, a datagram arriving before parsePacket() is dropped).
+ * Every queued datagram holds a packet buffer */
+#define UIP_UDP_RXQUEUE          3
+
+/* DNS: number of resolved host names kept until their TTL (max. UIP_DNS_MAX_TTL seconds)
+ * runs out (UIP_DNS_CACHE_NAME_LEN+13 bytes RAM each), so reconnecting does not look them up every time */
+#define UIP_DNS_CACHE_SIZE       2
+#define UIP_DNS_MAX_TTL          86400
+
+/* longest host name the DNS cache keeps (one byte RAM per character and entry), longer
+ * names are looked up every time */
+#define UIP_DNS_CACHE_NAME_LEN   31
+
+/* set to 1 to let connect(host) and beginPacket(host) return 0 while the host name is
+ * looked up (call them again later) instead of waiting up to 15 seconds for the answer */
+#define UIP_DNS_NONBLOCKING      0
+
+/* number of TCP segments a connection may have in flight before it waits for an ACK
+ * (1: stop-and-wait, the original uIP behaviour). Should be below UIP_SOCKET_NUMPACKETS */
+//#define UIP_CONF_SEND_WINDOW     3
+
+/* ARP table entries (12 bytes RAM each) */
+//#define UIP_CONF_ARPTAB_SIZE     8
+
+/* hold the first packet to an unresolved address in a packet buffer until the ARP reply
+ * arrives instead of dropping it (set to 0 to rely on TCP retransmission) */
+#define UIP_CONF_ARP_HOLD        1
+
+/* interval (in ms) at which an address that has not answered yet may be asked for again.
+ * Without it a lost ARP request or reply is only repeated after 10 seconds */
+#define UIP_ARP_RETRY_INTERVAL   1000
+
 /* number of attempts on write before returning number of bytes sent so far
  * set to -1 to block until connection is closed by timeout */
 #define UIP_ATTEMPTS_ON_WRITE    -1
@@ -19,6 +68,15 @@
  * if set to a number <= 0 connect will timeout when uIP does (which might be longer than you expect...) */
 #define UIP_CONNECT_TIMEOUT      -1
 
+/* pin the ENC28J60 INT output is connected to. If set, the receive buffer is only
+ * read out when INT is asserted (and on every timer deadline) instead of polling
+ * the chip on each call into the library */
+//#define UIPETHERNET_INT_PIN      2
+
+/* number of received packets tick() (maintain(), read(), available(), ...) handles in one call
+ * when several wait in the receive buffer (1: one packet per call as before) */
+#define UIP_RX_BURST             8
+
 /* periodic timer for uip (in ms) */
 #define UIP_PERIODIC_TIMER       250
 
@@ -26,4 +84,21 @@
  * set to -1 to disable fast polling and rely on periodic only (saves 100 bytes flash) */
 #define UIP_CLIENT_TIMER         10
 
+/* time (in ms) a write that does not fill a packet is held back so that following writes
+ * (e.g. print() piece by piece) go out in the same packet. A full packet, flush() and stop()
+ * send at once. Set to 0 to send on the client timer after the last write as before.
+ * Needs UIP_CLIENT_TIMER >= 0 */
+#define UIP_CLIENT_COALESCE      0
+
+/* UIPHttpServer: number of resources it serves (13 bytes RAM each), size of the buffers on
+ * the stack a response is written from and a request line is read into (longer lines are cut),
+ * seconds a UIP_HTTP_CACHE resource may be cached by the browser, time (in ms) an idle
+ * keep-alive connection stays open and time (in ms) to wait for the rest of a request */
+#define UIP_HTTP_RESOURCES       8
+#define UIP_HTTP_CHUNK           64
+#define UIP_HTTP_LINE            48
+#define UIP_HTTP_MAX_AGE         86400
+#define UIP_HTTP_KEEPALIVE       5000
+#define UIP_HTTP_TIMEOUT         1000
+
 #endif
@@ -323,6 +323,22 @@
 #define UIP_RECEIVE_WINDOW UIP_CONF_RECEIVE_WINDOW
 #endif
 
+/**
+ * The number of segments a connection may have in flight.
+ *
+ * With 1 (the original uIP behaviour) the application can send the
+ * next segment only after the previous one has been acknowledged.
+ * Larger values require an application that can retransmit from the
+ * oldest unacknowledged byte (see uip_ackedlen and uip_sendwnd()).
+ *
+ * \hideinitializer
+ */
+#ifndef UIP_CONF_SEND_WINDOW
+#define UIP_SEND_WINDOW 1
+#else
+#define UIP_SEND_WINDOW UIP_CONF_SEND_WINDOW
+#endif
+
 /**
  * How long a connection should stay in the TIME_WAIT state.
  *
@@ -361,6 +377,34 @@
  */
 #define UIP_ARP_MAXAGE 120
 
+/**
+ * The number of ARP timer periods an address that does not answer
+ * ARP requests stays in the table.
+ *
+ * While it is there, at most one ARP request per period is sent for
+ * it.
+ */
+#ifdef UIP_CONF_ARP_MAXPENDING
+#define UIP_ARP_MAXPENDING UIP_CONF_ARP_MAXPENDING
+#else
+#define UIP_ARP_MAXPENDING 2
+#endif
+
+/**
+ * Keep one outgoing frame per ARP table entry until the address is
+ * resolved, instead of replacing it with the ARP request.
+ *
+ * Needs UIP_ARP_RELEASE(handle, ethaddr) to be defined by the driver,
+ * see uip_arp_hold().
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_ARP_HOLD
+#define UIP_ARP_HOLD UIP_CONF_ARP_HOLD
+#else
+#define UIP_ARP_HOLD 0
+#endif
+
 /** @} */
 
 /*------------------------------------------------------------------------------*/
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+# rle565.py - compress an ImageConverter 565 array for UTFT::drawBitmapRLE()
+#
+# Usage: rle565.py tux.c [tux_rle.c]
+#
+# Reads the .c file written by ImageConverter 565 and writes the same image
+# as a run-length encoded array. Each 16bit word with the top bit set is
+# followed by one color that is repeated (word & 0x7FFF) times, any other
+# word is followed by that many literal colors.
+
+import re
+import sys
+
+MAX_COUNT = 0x7FFF
+
+
+def encode(pixels):
+    out = []
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:MAX_COUNT]
+            del literal[:MAX_COUNT]
+            out.append(len(chunk))
+            out.extend(chunk)
+
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while (i + run < len(pixels) and run < MAX_COUNT and
+               pixels[i + run] == pixels[i]):
+            run += 1
+        # A run costs two words, so it only pays off from three pixels on
+        if run >= 3:
+            flush_literal()
+            out.extend((0x8000 | run, pixels[i]))
+        else:
+            literal.extend(pixels[i:i + run])
+        i += run
+    flush_literal()
+    return out
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("usage: rle565.py input.c [output.c]")
+    src = open(sys.argv[1]).read()
+    m = re.search(r"unsigned\s+short\s+(\w+)\s*\[", src)
+    if not m:
+        sys.exit("no 'unsigned short name[]' array found in " + sys.argv[1])
+    name = m.group(1)
+    body = src[src.index("{", m.end()):]
+    body = re.sub(r"//[^\n]*", "", body)
+    pixels = [int(v, 16) for v in re.findall(r"0x[0-9A-Fa-f]{1,4}", body)]
+    words = encode(pixels)
+
+    dst = sys.argv[2] if len(sys.argv) > 2 else name + "_rle.c"
+    with open(dst, "w") as f:
+        f.write("// Generated by  : rle565.py\n")
+        f.write("// Generated from: %s\n" % sys.argv[1])
+        f.write("// Pixels        : %d\n" % len(pixels))
+        f.write("// Size          : %d Bytes (was %d)\n\n"
+                % (len(words) * 2, len(pixels) * 2))
+        f.write("#if defined(__AVR__)\n\t#include <avr/pgmspace.h>\n"
+                "#elif !defined(PROGMEM)\n\t#define PROGMEM\n#endif\n\n")
+        f.write("const unsigned short %s_rle[0x%X] PROGMEM ={\n"
+                % (name, len(words)))
+        for i in range(0, len(words), 16):
+            f.write(", ".join("0x%04X" % w for w in words[i:i + 16]))
+            f.write(",\n" if i + 16 < len(words) else "\n")
+        f.write("};\n")
+    print("%s: %d -> %d bytes" % (dst, len(pixels) * 2, len(words) * 2))
+
+
+if __name__ == "__main__":
+    main()
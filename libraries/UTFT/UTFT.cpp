@@ -92,6 +92,10 @@
 
 UTFT::UTFT()
 {
+	_scroll_lines = 0;
+#if defined(UTFT_FRAMEBUFFER)
+	_fb_buf = NULL;
+#endif
 }
 
 UTFT::UTFT(byte model, int RS, int WR, int CS, int RST, int SER)
@@ -104,6 +108,10 @@ UTFT::UTFT(byte model, int RS, int WR, int CS, int RST, int SER)
 	disp_y_size =			dsy[model];
 	display_transfer_mode =	dtm[model];
 	display_model =			model;
+	_scroll_lines =			0;
+#if defined(UTFT_FRAMEBUFFER)
+	_fb_buf =				NULL;
+#endif
 
 	__p1 = RS;
 	__p2 = WR;
@@ -176,6 +184,13 @@ void UTFT::LCD_Write_COM(char VL)
 
 void UTFT::LCD_Write_DATA(char VH,char VL)
 {
+#if defined(UTFT_FRAMEBUFFER)
+	if (_fb_buf!=NULL)
+	{
+		_fb_write((byte(VH)<<8)|byte(VL), 1);
+		return;
+	}
+#endif
 	if (display_transfer_mode!=1)
 	{
 		sbi(P_RS, B_RS);
@@ -330,6 +345,15 @@ void UTFT::setXY(word x1, word y1, word x2, word y2)
 		swap(word, y1, y2)
 	}
 
+#if defined(UTFT_FRAMEBUFFER)
+	if (_fb_buf!=NULL)
+	{
+		_fb_wx1=x1; _fb_wy1=y1; _fb_wx2=x2; _fb_wy2=y2;
+		_fb_cx=x1; _fb_cy=y1;
+		return;
+	}
+#endif
+
 	switch(display_model)
 	{
 #ifndef DISABLE_HX8347A
@@ -450,14 +474,17 @@ void UTFT::drawRoundRect(int x1, int y1, int x2, int y2)
 	}
 	if ((x2-x1)>4 && (y2-y1)>4)
 	{
-		drawPixel(x1+1,y1+1);
-		drawPixel(x2-1,y1+1);
-		drawPixel(x1+1,y2-1);
-		drawPixel(x2-1,y2-1);
-		drawHLine(x1+2, y1, x2-x1-4);
-		drawHLine(x1+2, y2, x2-x1-4);
-		drawVLine(x1, y1+2, y2-y1-4);
-		drawVLine(x2, y1+2, y2-y1-4);
+		cbi(P_CS, B_CS);
+		_fill_xy(x1+1, y1+1, x1+1, y1+1);
+		_fill_xy(x2-1, y1+1, x2-1, y1+1);
+		_fill_xy(x1+1, y2-1, x1+1, y2-1);
+		_fill_xy(x2-1, y2-1, x2-1, y2-1);
+		_fill_xy(x1+2, y1, x2-2, y1);
+		_fill_xy(x1+2, y2, x2-2, y2);
+		_fill_xy(x1, y1+2, x1, y2-2);
+		_fill_xy(x2, y1+2, x2, y2-2);
+		sbi(P_CS, B_CS);
+		clrXY();
 	}
 }
 
@@ -471,41 +498,9 @@ void UTFT::fillRect(int x1, int y1, int x2, int y2)
 	{
 		swap(int, y1, y2);
 	}
-	if (display_transfer_mode==16)
-	{
-		cbi(P_CS, B_CS);
-		setXY(x1, y1, x2, y2);
-		sbi(P_RS, B_RS);
-		_fast_fill_16(fch,fcl,((long(x2-x1)+1)*(long(y2-y1)+1)));
-		sbi(P_CS, B_CS);
-	}
-	else if ((display_transfer_mode==8) and (fch==fcl))
-	{
-		cbi(P_CS, B_CS);
-		setXY(x1, y1, x2, y2);
-		sbi(P_RS, B_RS);
-		_fast_fill_8(fch,((long(x2-x1)+1)*(long(y2-y1)+1)));
-		sbi(P_CS, B_CS);
-	}
-	else
-	{
-		if (orient==PORTRAIT)
-		{
-			for (int i=0; i<((y2-y1)/2)+1; i++)
-			{
-				drawHLine(x1, y1+i, x2-x1);
-				drawHLine(x1, y2-i, x2-x1);
-			}
-		}
-		else
-		{
-			for (int i=0; i<((x2-x1)/2)+1; i++)
-			{
-				drawVLine(x1+i, y1, y2-y1);
-				drawVLine(x2-i, y1, y2-y1);
-			}
-		}
-	}
+	cbi(P_CS, B_CS);
+	_fill_xy(x1, y1, x2, y2);
+	sbi(P_CS, B_CS);
 }
 
 void UTFT::fillRoundRect(int x1, int y1, int x2, int y2)
@@ -521,23 +516,14 @@ void UTFT::fillRoundRect(int x1, int y1, int x2, int y2)
 
 	if ((x2-x1)>4 && (y2-y1)>4)
 	{
-		for (int i=0; i<((y2-y1)/2)+1; i++)
-		{
-			switch(i)
-			{
-			case 0:
-				drawHLine(x1+2, y1+i, x2-x1-4);
-				drawHLine(x1+2, y2-i, x2-x1-4);
-				break;
-			case 1:
-				drawHLine(x1+1, y1+i, x2-x1-2);
-				drawHLine(x1+1, y2-i, x2-x1-2);
-				break;
-			default:
-				drawHLine(x1, y1+i, x2-x1);
-				drawHLine(x1, y2-i, x2-x1);
-			}
-		}
+		cbi(P_CS, B_CS);
+		_fill_xy(x1+2, y1, x2-2, y1);
+		_fill_xy(x1+1, y1+1, x2-1, y1+1);
+		_fill_xy(x1, y1+2, x2, y2-2);
+		_fill_xy(x1+1, y2-1, x2-1, y2-1);
+		_fill_xy(x1+2, y2, x2-2, y2);
+		sbi(P_CS, B_CS);
+		clrXY();
 	}
 }
 
@@ -548,44 +534,34 @@ void UTFT::drawCircle(int x, int y, int radius)
 	int ddF_y = -2 * radius;
 	int x1 = 0;
 	int y1 = radius;
+	int xs = 0;
  
 	cbi(P_CS, B_CS);
-	setXY(x, y + radius, x, y + radius);
-	LCD_Write_DATA(fch,fcl);
-	setXY(x, y - radius, x, y - radius);
-	LCD_Write_DATA(fch,fcl);
-	setXY(x + radius, y, x + radius, y);
-	LCD_Write_DATA(fch,fcl);
-	setXY(x - radius, y, x - radius, y);
-	LCD_Write_DATA(fch,fcl);
- 
-	while(x1 < y1)
+	// Consecutive points of an octant that stay on the same row (column in the
+	// side octants) are sent as one run with a single address window
+	while(x1 <= y1)
 	{
-		if(f >= 0) 
+		x1++;
+		if ((f >= 0) || (x1 > y1))
 		{
-			y1--;
-			ddF_y += 2;
-			f += ddF_y;
+			_fill_xy(x + xs, y + y1, x + x1 - 1, y + y1);
+			_fill_xy(x - x1 + 1, y + y1, x - xs, y + y1);
+			_fill_xy(x + xs, y - y1, x + x1 - 1, y - y1);
+			_fill_xy(x - x1 + 1, y - y1, x - xs, y - y1);
+			_fill_xy(x + y1, y + xs, x + y1, y + x1 - 1);
+			_fill_xy(x - y1, y + xs, x - y1, y + x1 - 1);
+			_fill_xy(x + y1, y - x1 + 1, x + y1, y - xs);
+			_fill_xy(x - y1, y - x1 + 1, x - y1, y - xs);
+			xs = x1;
+			if (f >= 0)
+			{
+				y1--;
+				ddF_y += 2;
+				f += ddF_y;
+			}
 		}
-		x1++;
 		ddF_x += 2;
-		f += ddF_x;    
-		setXY(x + x1, y + y1, x + x1, y + y1);
-		LCD_Write_DATA(fch,fcl);
-		setXY(x - x1, y + y1, x - x1, y + y1);
-		LCD_Write_DATA(fch,fcl);
-		setXY(x + x1, y - y1, x + x1, y - y1);
-		LCD_Write_DATA(fch,fcl);
-		setXY(x - x1, y - y1, x - x1, y - y1);
-		LCD_Write_DATA(fch,fcl);
-		setXY(x + y1, y + x1, x + y1, y + x1);
-		LCD_Write_DATA(fch,fcl);
-		setXY(x - y1, y + x1, x - y1, y + x1);
-		LCD_Write_DATA(fch,fcl);
-		setXY(x + y1, y - x1, x + y1, y - x1);
-		LCD_Write_DATA(fch,fcl);
-		setXY(x - y1, y - x1, x - y1, y - x1);
-		LCD_Write_DATA(fch,fcl);
+		f += ddF_x;
 	}
 	sbi(P_CS, B_CS);
 	clrXY();
@@ -593,14 +569,20 @@ void UTFT::drawCircle(int x, int y, int radius)
 
 void UTFT::fillCircle(int x, int y, int radius)
 {
-	for(int y1=-radius; y1<=0; y1++) 
-		for(int x1=-radius; x1<=0; x1++)
-			if(x1*x1+y1*y1 <= radius*radius) 
-			{
-				drawHLine(x+x1, y+y1, 2*(-x1));
-				drawHLine(x+x1, y-y1, 2*(-x1));
-				break;
-			}
+	int x1 = radius;
+
+	cbi(P_CS, B_CS);
+	// One span per row pair, x1 is the widest offset with x1*x1+y1*y1 <= radius*radius
+	for(int y1=0; y1<=radius; y1++)
+	{
+		while(x1*x1+y1*y1 > radius*radius)
+			x1--;
+		_fill_xy(x-x1, y+y1, x+x1, y+y1);
+		if (y1 != 0)
+			_fill_xy(x-x1, y-y1, x+x1, y-y1);
+	}
+	sbi(P_CS, B_CS);
+	clrXY();
 }
 
 void UTFT::clrScr()
@@ -609,6 +591,14 @@ void UTFT::clrScr()
 	
 	cbi(P_CS, B_CS);
 	clrXY();
+#if defined(UTFT_FRAMEBUFFER)
+	if (_fb_buf!=NULL)
+	{
+		_fb_write(0,((disp_x_size+1)*(disp_y_size+1)));
+		sbi(P_CS, B_CS);
+		return;
+	}
+#endif
 	if (display_transfer_mode!=1)
 		sbi(P_RS, B_RS);
 	if (display_transfer_mode==16)
@@ -647,6 +637,14 @@ void UTFT::fillScr(word color)
 
 	cbi(P_CS, B_CS);
 	clrXY();
+#if defined(UTFT_FRAMEBUFFER)
+	if (_fb_buf!=NULL)
+	{
+		_fb_write(color,((disp_x_size+1)*(disp_y_size+1)));
+		sbi(P_CS, B_CS);
+		return;
+	}
+#endif
 	if (display_transfer_mode!=1)
 		sbi(P_RS, B_RS);
 	if (display_transfer_mode==16)
@@ -780,6 +778,38 @@ void UTFT::drawLine(int x1, int y1, int x2, int y2)
 	clrXY();
 }
 
+// Fill the window with the current color, CS has to be low already
+void UTFT::_fill_xy(int x1, int y1, int x2, int y2)
+{
+	long pix = (long(x2-x1)+1)*(long(y2-y1)+1);
+
+	if (pix <= 0)
+		return;
+	setXY(x1, y1, x2, y2);
+#if defined(UTFT_FRAMEBUFFER)
+	if (_fb_buf!=NULL)
+		_fb_write((fch<<8)|fcl, pix);
+	else
+#endif
+	if (display_transfer_mode == 16)
+	{
+		sbi(P_RS, B_RS);
+		_fast_fill_16(fch,fcl,pix);
+	}
+	else if ((display_transfer_mode==8) and (fch==fcl))
+	{
+		sbi(P_RS, B_RS);
+		_fast_fill_8(fch,pix);
+	}
+	else
+	{
+		for (long i=0; i<pix; i++)
+		{
+			LCD_Write_DATA(fch, fcl);
+		}
+	}
+}
+
 void UTFT::drawHLine(int x, int y, int l)
 {
 	if (l<0)
@@ -789,6 +819,11 @@ void UTFT::drawHLine(int x, int y, int l)
 	}
 	cbi(P_CS, B_CS);
 	setXY(x, y, x+l, y);
+#if defined(UTFT_FRAMEBUFFER)
+	if (_fb_buf!=NULL)
+		_fb_write((fch<<8)|fcl, l+1);
+	else
+#endif
 	if (display_transfer_mode == 16)
 	{
 		sbi(P_RS, B_RS);
@@ -819,6 +854,11 @@ void UTFT::drawVLine(int x, int y, int l)
 	}
 	cbi(P_CS, B_CS);
 	setXY(x, y, x, y+l);
+#if defined(UTFT_FRAMEBUFFER)
+	if (_fb_buf!=NULL)
+		_fb_write((fch<<8)|fcl, l+1);
+	else
+#endif
 	if (display_transfer_mode == 16)
 	{
 		sbi(P_RS, B_RS);
@@ -840,6 +880,171 @@ void UTFT::drawVLine(int x, int y, int l)
 	clrXY();
 }
 
+#if defined(UTFT_FRAMEBUFFER)
+// Store pixels at the emulated controller cursor, advancing it through the
+// window the same way the controller does. Pixels outside the buffer are
+// dropped.
+void UTFT::_fb_write(word color, long pix)
+{
+	word	px, py;
+
+	while (pix-- > 0)
+	{
+		if ((_fb_cx>=_fb_x1) && (_fb_cx<=_fb_x2) && (_fb_cy>=_fb_y1) && (_fb_cy<=_fb_y2))
+		{
+			px=_fb_cx-_fb_x1;
+			py=_fb_cy-_fb_y1;
+			_fb_buf[(long(py)*(_fb_x2-_fb_x1+1))+px]=color;
+			_fb_dirty[py>>4]|=(1UL<<(px>>4));
+		}
+		if (_fb_cx<_fb_wx2)
+			_fb_cx++;
+		else
+		{
+			_fb_cx=_fb_wx1;
+			_fb_cy=(_fb_cy<_fb_wy2) ? _fb_cy+1 : _fb_wy1;
+		}
+	}
+}
+
+// buf must hold (x2-x1+1)*(y2-y1+1) pixels and the area may be at most
+// 512x512. Pass NULL to go back to drawing directly on the display.
+void UTFT::setFrameBuffer(word *buf, int x1, int y1, int x2, int y2)
+{
+	_fb_buf=NULL;
+	if (buf==NULL)
+		return;
+	if (x1>x2)
+		swap(int, x1, x2);
+	if (y1>y2)
+		swap(int, y1, y2);
+	if (orient==LANDSCAPE)
+	{
+		swap(int, x1, y1);
+		swap(int, x2, y2);
+		y1=disp_y_size-y1;
+		y2=disp_y_size-y2;
+		swap(int, y1, y2);
+	}
+	if ((x1<0) || (y1<0) || (x2>disp_x_size) || (y2>disp_y_size) || ((x2-x1)>=512) || ((y2-y1)>=512))
+		return;
+
+	_fb_x1=x1; _fb_y1=y1; _fb_x2=x2; _fb_y2=y2;
+	for (int i=0; i<32; i++)
+		_fb_dirty[i]=0;
+	_fb_buf=buf;
+	clrXY();
+}
+
+// Send every run of dirty tiles in a tile row through one window
+void UTFT::flushFrameBuffer()
+{
+	word	*buf=_fb_buf;
+	byte	o=orient;
+	int		w=_fb_x2-_fb_x1+1;
+	int		ty, tx, ts, x1, y1, x2, y2, x, y;
+	word	c;
+
+	if (buf==NULL)
+		return;
+
+	_fb_buf=NULL;
+	orient=PORTRAIT;
+	cbi(P_CS, B_CS);
+	for (ty=0; ty<=((_fb_y2-_fb_y1)>>4); ty++)
+	{
+		tx=0;
+		while (_fb_dirty[ty]!=0)
+		{
+			while ((_fb_dirty[ty]&(1UL<<tx))==0)
+				tx++;
+			ts=tx;
+			while ((tx<32) && ((_fb_dirty[ty]&(1UL<<tx))!=0))
+			{
+				_fb_dirty[ty]&=~(1UL<<tx);
+				tx++;
+			}
+			x1=_fb_x1+(ts<<4);
+			x2=min(_fb_x1+(tx<<4)-1, int(_fb_x2));
+			y1=_fb_y1+(ty<<4);
+			y2=min(y1+15, int(_fb_y2));
+			setXY(x1, y1, x2, y2);
+			for (y=y1-_fb_y1; y<=y2-_fb_y1; y++)
+				for (x=x1-_fb_x1; x<=x2-_fb_x1; x++)
+				{
+					c=buf[(long(y)*w)+x];
+					LCD_Write_DATA(c>>8, c&0xFF);
+				}
+		}
+	}
+	sbi(P_CS, B_CS);
+	orient=o;
+	clrXY();
+	_fb_buf=buf;
+	clrXY();
+}
+#endif
+
+void UTFT::_print_string(char *st, int stl, int x, int y)
+{
+	// Opaque, unrotated text that fits on screen: stream whole glyph rows
+	// across the string instead of opening a window per character.
+	byte i,ch;
+	int j,k,zz;
+	int bw=cfont.x_size/8;
+	word temp;
+
+	cbi(P_CS, B_CS);
+	if (orient==PORTRAIT)
+	{
+		setXY(x,y,x+(stl*cfont.x_size)-1,y+cfont.y_size-1);
+		for(j=0;j<cfont.y_size;j++)
+		{
+			for(k=0;k<stl;k++)
+			{
+				temp=((st[k]-cfont.offset)*(bw*cfont.y_size))+4+(j*bw);
+				for(zz=0;zz<bw;zz++)
+				{
+					ch=pgm_read_byte(&cfont.font[temp+zz]);
+					for(i=0;i<8;i++)
+					{
+						if((ch&(1<<(7-i)))!=0)
+							LCD_Write_DATA(fch,fcl);
+						else
+							LCD_Write_DATA(bch,bcl);
+					}
+				}
+			}
+		}
+	}
+	else
+	{
+		// The landscape scan runs right to left along a row, so each row
+		// window is filled from the last character's last byte backwards.
+		for(j=0;j<cfont.y_size;j++)
+		{
+			setXY(x,y+j,x+(stl*cfont.x_size)-1,y+j);
+			for(k=stl-1;k>=0;k--)
+			{
+				temp=((st[k]-cfont.offset)*(bw*cfont.y_size))+4+(j*bw);
+				for(zz=bw-1;zz>=0;zz--)
+				{
+					ch=pgm_read_byte(&cfont.font[temp+zz]);
+					for(i=0;i<8;i++)
+					{
+						if((ch&(1<<i))!=0)
+							LCD_Write_DATA(fch,fcl);
+						else
+							LCD_Write_DATA(bch,bcl);
+					}
+				}
+			}
+		}
+	}
+	sbi(P_CS, B_CS);
+	clrXY();
+}
+
 void UTFT::printChar(byte c, int x, int y)
 {
 	byte i,ch;
@@ -985,6 +1190,14 @@ void UTFT::print(char *st, int x, int y, int deg)
 		x=((disp_y_size+1)-(stl*cfont.x_size))/2;
 	}
 
+	if ((deg==0) && (!_transparent) && (stl>0) && (x>=0) && (y>=0) &&
+		((x+(stl*cfont.x_size)-1)<=((orient==PORTRAIT) ? disp_x_size : disp_y_size)) &&
+		((y+cfont.y_size-1)<=((orient==PORTRAIT) ? disp_y_size : disp_x_size)))
+	{
+		_print_string(st, stl, x, y);
+		return;
+	}
+
 	for (i=0; i<stl; i++)
 		if (deg==0)
 			printChar(*st++, x + (i*(cfont.x_size)), y);
@@ -1167,9 +1380,9 @@ void UTFT::drawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int sca
 		if (orient==PORTRAIT)
 		{
 			cbi(P_CS, B_CS);
+			setXY(x, y, x+((sx*scale)-1), y+((sy*scale)-1));
 			for (ty=0; ty<sy; ty++)
 			{
-				setXY(x, y+(ty*scale), x+((sx*scale)-1), y+(ty*scale)+scale);
 				for (tsy=0; tsy<scale; tsy++)
 					for (tx=0; tx<sx; tx++)
 					{
@@ -1202,10 +1415,177 @@ void UTFT::drawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int sca
 	clrXY();
 }
 
+// Send pix pixels of one color into the current window, CS has to be low already
+void UTFT::_fill_run(byte ch, byte cl, long pix)
+{
+	long	blk = pix & ~15L;	// the fast fills are only exact for whole blocks
+
+#if defined(UTFT_FRAMEBUFFER)
+	if (_fb_buf!=NULL)
+	{
+		_fb_write((ch<<8)|cl, pix);
+		return;
+	}
+#endif
+	if ((blk>0) && (display_transfer_mode==16))
+	{
+		sbi(P_RS, B_RS);
+		_fast_fill_16(ch,cl,blk);
+		pix-=blk;
+	}
+	else if ((blk>0) && (display_transfer_mode==8) && (ch==cl))
+	{
+		sbi(P_RS, B_RS);
+		_fast_fill_8(ch,blk);
+		pix-=blk;
+	}
+	while (pix-- > 0)
+		LCD_Write_DATA(ch, cl);
+}
+
+// data is a stream of 16bit words as made by Tools/rle565.py. A word with
+// the top bit set repeats the following color (word & 0x7FFF) times, any
+// other word is followed by that many literal colors.
+void UTFT::drawBitmapRLE(int x, int y, int sx, int sy, bitmapdatatype data)
+{
+	unsigned int	hdr, col;
+	long			tc=0, dc=0, len, n, i;
+	long			pix=long(sx)*sy;
+	int				tx, ty;
+
+	cbi(P_CS, B_CS);
+	if (orient==PORTRAIT)
+	{
+		setXY(x, y, x+sx-1, y+sy-1);
+		while (tc<pix)
+		{
+			hdr=pgm_read_word(&data[dc++]);
+			len=hdr & 0x7FFF;
+			if (hdr & 0x8000)
+			{
+				col=pgm_read_word(&data[dc++]);
+				_fill_run(col>>8, col & 0xff, len);
+			}
+			else
+				for (i=0; i<len; i++)
+				{
+					col=pgm_read_word(&data[dc++]);
+					LCD_Write_DATA(col>>8,col & 0xff);
+				}
+			tc+=len;
+		}
+	}
+	else
+	{
+		// Landscape rows are filled right to left, so each piece of a run
+		// gets a window on its own row and literals are sent backwards
+		while (tc<pix)
+		{
+			hdr=pgm_read_word(&data[dc++]);
+			len=hdr & 0x7FFF;
+			if (hdr & 0x8000)
+				col=pgm_read_word(&data[dc++]);
+			while (len>0)
+			{
+				ty=tc/sx;
+				tx=tc%sx;
+				n=min(len, long(sx-tx));
+				setXY(x+tx, y+ty, x+tx+n-1, y+ty);
+				if (hdr & 0x8000)
+					_fill_run(col>>8, col & 0xff, n);
+				else
+				{
+					for (i=n-1; i>=0; i--)
+					{
+						col=pgm_read_word(&data[dc+i]);
+						LCD_Write_DATA(col>>8,col & 0xff);
+					}
+					dc+=n;
+				}
+				tc+=n;
+				len-=n;
+			}
+		}
+	}
+	sbi(P_CS, B_CS);
+	clrXY();
+}
+
+// Send pix pixels from buf (RGB565, high byte first) into the current window,
+// last pixel first if rev is set. CS has to be low already
+void UTFT::_write_pixels(byte *buf, int pix, boolean rev)
+{
+	int		step=2;
+	boolean	single=(display_transfer_mode==1);
+
+	if (rev)
+	{
+		buf+=(pix-1)*2;
+		step=-2;
+	}
+#if defined(UTFT_FRAMEBUFFER)
+	single|=(_fb_buf!=NULL);
+#endif
+	if (single)
+		for (; pix>0; pix--, buf+=step)
+			LCD_Write_DATA(buf[0], buf[1]);
+	else
+	{
+		// RS stays high for the whole run on the parallel busses
+		sbi(P_RS, B_RS);
+		for (; pix>0; pix--, buf+=step)
+			LCD_Writ_Bus(buf[0], buf[1], display_transfer_mode);
+	}
+}
+
+// Streams sx*sy pixels from next() (a sequential read already started on the
+// source) in blitbuffersize pieces
+void UTFT::_blit(int x, int y, int sx, int sy, void (*next)(void *src, byte *buf, word len), void *src)
+{
+	byte	buf[blitbuffersize];
+	long	tc=0, pix=long(sx)*sy, n;
+	int		tx, ty;
+
+	cbi(P_CS, B_CS);
+	if (orient==PORTRAIT)
+	{
+		// one window, the data goes out in the order it is read
+		setXY(x, y, x+sx-1, y+sy-1);
+		while (tc<pix)
+		{
+			n=min(pix-tc, long(blitbuffersize/2));
+			next(src, buf, n*2);
+			_write_pixels(buf, n, false);
+			tc+=n;
+		}
+	}
+	else
+	{
+		// Landscape rows are filled right to left, so each piece gets a
+		// window on its own row and is sent backwards
+		while (tc<pix)
+		{
+			ty=tc/sx;
+			tx=tc%sx;
+			n=min(long(sx-tx), long(blitbuffersize/2));
+			next(src, buf, n*2);
+			setXY(x+tx, y+ty, x+tx+n-1, y+ty);
+			_write_pixels(buf, n, true);
+			tc+=n;
+		}
+	}
+	sbi(P_CS, B_CS);
+	clrXY();
+}
+
 void UTFT::drawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int deg, int rox, int roy)
 {
 	unsigned int col;
-	int tx, ty, newx, newy;
+	int tx, ty, newx, newy, lastx=0, lasty=0;
+	int xmax = ((orient==PORTRAIT) ? disp_x_size : disp_y_size);
+	int step = ((orient==PORTRAIT) ? 1 : -1);
+	boolean run = false;
+	long fc, fs, fx, fy;
 	double radian;
 	radian=deg*0.0175;  
 
@@ -1213,18 +1593,45 @@ void UTFT::drawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int deg
 		drawBitmap(x, y, sx, sy, data);
 	else
 	{
+		// 16.16 fixed point, stepped along each source row. Pixels that land
+		// next to the previous one on the same row share its window, which
+		// is opened towards the screen edge in the direction the controller
+		// fills. Landscape fills right to left, so rows are walked backwards.
+		fc=long(cos(radian)*65536.0);
+		fs=long(sin(radian)*65536.0);
 		cbi(P_CS, B_CS);
 		for (ty=0; ty<sy; ty++)
-			for (tx=0; tx<sx; tx++)
+		{
+			tx=((orient==PORTRAIT) ? 0 : sx-1);
+			fx=(long(x+rox)<<16)+(long(tx-rox)*fc)-(long(ty-roy)*fs);
+			fy=(long(y+roy)<<16)+(long(ty-roy)*fc)+(long(tx-rox)*fs);
+			for (; (tx>=0) && (tx<sx); tx+=step)
 			{
 				col=pgm_read_word(&data[(ty*sx)+tx]);
 
-				newx=x+rox+(((tx-rox)*cos(radian))-((ty-roy)*sin(radian)));
-				newy=y+roy+(((ty-roy)*cos(radian))+((tx-rox)*sin(radian)));
+				newx=fx>>16;
+				newy=fy>>16;
+				fx+=fc*step;
+				fy+=fs*step;
 
-				setXY(newx, newy, newx, newy);
+				if ((newx<0) || (newx>xmax))
+				{
+					setXY(newx, newy, newx, newy);
+					run=false;
+				}
+				else if ((!run) || (newy!=lasty) || (newx!=lastx+step))
+				{
+					if (orient==PORTRAIT)
+						setXY(newx, newy, xmax, newy);
+					else
+						setXY(0, newy, newx, newy);
+					run=true;
+				}
 				LCD_Write_DATA(col>>8,col & 0xff);
+				lastx=newx;
+				lasty=newy;
 			}
+		}
 		sbi(P_CS, B_CS);
 	}
 	clrXY();
@@ -1333,3 +1740,76 @@ void UTFT::setWritePage(byte page)
 	}
 	sbi(P_CS, B_CS);
 }
+
+// Hardware scrolling moves frame memory lines of the controller, which are
+// screen rows in PORTRAIT and columns in LANDSCAPE on most modules (the
+// SSD1963 modules are the other way round). Returns false if the controller
+// has no scroll support, the caller then has to redraw instead.
+boolean UTFT::setScrollArea(int top, int lines)
+{
+	_scroll_top=top;
+	_scroll_lines=lines;
+	if (_hw_scroll(top, true))
+		return true;
+	_scroll_lines=0;
+	return false;
+}
+
+// Show the scroll area starting at its line, wrapping around at the end
+void UTFT::scrollTo(int line)
+{
+	if (_scroll_lines==0)
+		return;
+	line%=int(_scroll_lines);
+	if (line<0)
+		line+=_scroll_lines;
+	_hw_scroll(_scroll_top+line, false);
+}
+
+boolean UTFT::_hw_scroll(word vsp, boolean area)
+{
+	boolean ok=true;
+
+	cbi(P_CS, B_CS);
+	switch (display_model)
+	{
+#ifndef DISABLE_ILI9327
+	#include "tft_drivers/ili9327/scroll.h"
+#endif
+#ifndef DISABLE_ST7735
+	#include "tft_drivers/st7735/scroll.h"
+#endif
+#ifndef DISABLE_SSD1963_480
+	#include "tft_drivers/ssd1963/480/scroll.h"
+#endif
+#ifndef DISABLE_SSD1963_800
+	#include "tft_drivers/ssd1963/800/scroll.h"
+#endif
+#ifndef DISABLE_SSD1963_800_ALT
+	#include "tft_drivers/ssd1963/800alt/scroll.h"
+#endif
+#ifndef DISABLE_ILI9481
+	#include "tft_drivers/ili9481/scroll.h"
+#endif
+#ifndef DISABLE_ST7735S
+	#include "tft_drivers/st7735s/scroll.h"
+#endif
+#ifndef DISABLE_ILI9341_S4P
+	#include "tft_drivers/ili9341/s4p/scroll.h"
+#endif
+#ifndef DISABLE_ILI9341_S5P
+	#include "tft_drivers/ili9341/s5p/scroll.h"
+#endif
+#ifndef DISABLE_R61581
+	#include "tft_drivers/r61581/scroll.h"
+#endif
+#ifndef DISABLE_ILI9486
+	#include "tft_drivers/ili9486/scroll.h"
+#endif
+	default:
+		ok=false;
+		break;
+	}
+	sbi(P_CS, B_CS);
+	return ok;
+}
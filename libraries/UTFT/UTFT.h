@@ -226,6 +226,16 @@ class UTFT
 		uint8_t	getFontYsize();
 		void	drawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int scale=1);
 		void	drawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int deg, int rox, int roy);
+		void	drawBitmapRLE(int x, int y, int sx, int sy, bitmapdatatype data);
+		// flash is a SPIFlash (or anything with readStart/readNext/readEnd), addr
+		// the first byte of a .raw image (RGB565, high byte first)
+		template<class T>
+		void	drawBitmapFlash(int x, int y, int sx, int sy, T &flash, long addr)
+		{
+			flash.readStart(addr);
+			_blit(x, y, sx, sy, &_blit_next<T>, &flash);
+			flash.readEnd();
+		}
 		void	lcdOff();
 		void	lcdOn();
 		void	setContrast(char c);
@@ -234,6 +244,12 @@ class UTFT
 		void	setBrightness(byte br);
 		void	setDisplayPage(byte page);
 		void	setWritePage(byte page);
+		boolean	setScrollArea(int top, int lines);
+		void	scrollTo(int line);
+#if defined(UTFT_FRAMEBUFFER)
+		void	setFrameBuffer(word *buf, int x1, int y1, int x2, int y2);
+		void	flushFrameBuffer();
+#endif
 
 /*
 	The functions and variables below should not normally be used.
@@ -252,6 +268,13 @@ class UTFT
 		byte			__p1, __p2, __p3, __p4, __p5;
 		_current_font	cfont;
 		boolean			_transparent;
+		word			_scroll_top, _scroll_lines;
+#if defined(UTFT_FRAMEBUFFER)
+		word			*_fb_buf;
+		word			_fb_x1, _fb_y1, _fb_x2, _fb_y2;
+		word			_fb_wx1, _fb_wy1, _fb_wx2, _fb_wy2, _fb_cx, _fb_cy;
+		uint32_t		_fb_dirty[32];
+#endif
 
 		void LCD_Writ_Bus(char VH,char VL, byte mode);
 		void LCD_Write_COM(char VL);
@@ -263,12 +286,23 @@ class UTFT
 		void drawHLine(int x, int y, int l);
 		void drawVLine(int x, int y, int l);
 		void printChar(byte c, int x, int y);
+		void _print_string(char *st, int stl, int x, int y);
 		void setXY(word x1, word y1, word x2, word y2);
 		void clrXY();
 		void rotateChar(byte c, int x, int y, int pos, int deg);
 		void _set_direction_registers(byte mode);
 		void _fast_fill_16(int ch, int cl, long pix);
 		void _fast_fill_8(int ch, long pix);
+		void _fill_xy(int x1, int y1, int x2, int y2);
+		void _fill_run(byte ch, byte cl, long pix);
+		void _write_pixels(byte *buf, int pix, boolean rev);
+		void _blit(int x, int y, int sx, int sy, void (*next)(void *src, byte *buf, word len), void *src);
+		template<class T>
+		static void _blit_next(void *src, byte *buf, word len) { ((T*)src)->readNext(buf, len); }
+		boolean _hw_scroll(word vsp, boolean area);
+#if defined(UTFT_FRAMEBUFFER)
+		void _fb_write(word color, long pix);
+#endif
 		void _convert_float(char *buf, double num, int width, byte prec);
 };
 
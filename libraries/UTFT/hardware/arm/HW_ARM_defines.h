@@ -14,6 +14,14 @@
 // For this shield: RS=22, WR=23, CS=31, RST=33
 //********************************************************************
 
+// Off-screen framebuffer
+// -------------------------------------
+// Uncomment the following line to enable setFrameBuffer() and
+// flushFrameBuffer(). While a buffer is set all drawing goes to RAM
+// and only the 16x16 tiles that changed are sent on the next flush.
+//#define UTFT_FRAMEBUFFER 1
+//********************************************************************
+
 // *** Hardwarespecific defines ***
 #define cbi(reg, bitmask) *reg &= ~bitmask
 #define sbi(reg, bitmask) *reg |= bitmask
@@ -30,6 +38,7 @@
 #define pgm_read_word(data) *data
 #define pgm_read_byte(data) *data
 #define bitmapdatatype unsigned short*
+#define blitbuffersize 512	// bytes read from the source at a time by drawBitmapFlash()
 
 #if defined(TEENSYDUINO) && TEENSYDUINO >= 117
   #define regtype volatile uint8_t
@@ -12,6 +12,15 @@
  *
 **/
 
+// Strobe WR without a read-modify-write. Teensyduino 1.17 and later hands
+// out a bit-band alias for the pin, older versions the GPIO_PDOR register
+// with GPIO_PSOR and GPIO_PCOR one and two words above it.
+#if defined(TEENSYDUINO) && TEENSYDUINO >= 117
+	#define pulse_wr() *P_WR = 0; *P_WR = B_WR;
+#else
+	#define pulse_wr() *(P_WR+2) = B_WR; *(P_WR+1) = B_WR;
+#endif
+
 // *** Hardware specific functions ***
 void UTFT::_hw_special_init()
 {
@@ -81,15 +90,15 @@ void UTFT::LCD_Writ_Bus(char VH,char VL, byte mode)
 		break;
 	case 8:
 		*(volatile uint8_t *)(&GPIOD_PDOR) = VH;
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
 		*(volatile uint8_t *)(&GPIOD_PDOR) = VL;
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
 		break;
 	case 16:
 		*(volatile uint8_t *)(&GPIOD_PDOR) = VH;
   		GPIOB_PCOR = 0x000F000F;							// clear data lines B0-3,B16-19
         GPIOB_PSOR = (0x0F & VL) | ((VL >> 4) << 16);  		// set data lines 0-3,16-19 if set in cl
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
 		break;
 	}
 }
@@ -130,27 +139,27 @@ void UTFT::_fast_fill_16(int ch, int cl, long pix)
 	blocks = pix/16;
 	for (int i=0; i<blocks; i++)
 	{
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
 	}
 	if ((pix % 16) != 0)
 		for (int i=0; i<(pix % 16); i++)
 		{
-			pulse_low(P_WR, B_WR);
+			pulse_wr();
 		}
 }
 
@@ -163,26 +172,26 @@ void UTFT::_fast_fill_8(int ch, long pix)
 	blocks = pix/16;
 	for (int i=0; i<blocks; i++)
 	{
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
 	}
 	if ((pix % 16) != 0)
 		for (int i=0; i<(pix % 16); i++)
 		{
-			pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
+			pulse_wr();pulse_wr();
 		}
 }
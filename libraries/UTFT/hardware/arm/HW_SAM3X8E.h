@@ -1,4 +1,10 @@
 // *** Hardwarespecific functions ***
+
+// Strobe WR through the write-only PIO_CODR/PIO_SODR registers, which sit
+// one and two words below the PIO_ODSR register P_WR points at. This saves
+// the read-modify-write of pulse_low() on every pixel.
+#define pulse_wr() *(P_WR-1) = B_WR; *(P_WR-2) = B_WR;
+
 void UTFT::_hw_special_init()
 {
 #ifdef EHOUSE_DUE_SHIELD
@@ -72,24 +78,24 @@ void UTFT::LCD_Writ_Bus(char VH,char VL, byte mode)
 #if defined(CTE_DUE_SHIELD) || defined(EHOUSE_DUE_SHIELD)
 		REG_PIOC_CODR=0xFF000;
 		REG_PIOC_SODR=(VH<<12) & 0xFF000;
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
 		REG_PIOC_CODR=0xFF000;
 		REG_PIOC_SODR=(VL<<12) & 0xFF000;
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
 #else
 		REG_PIOA_CODR=0x0000C000;
 		REG_PIOD_CODR=0x0000064F;
 		REG_PIOA_SODR=(VH & 0x06)<<13;
 		(VH & 0x01) ? REG_PIOB_SODR = 0x4000000 : REG_PIOB_CODR = 0x4000000;
 		REG_PIOD_SODR=((VH & 0x78)>>3) | ((VH & 0x80)>>1);
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
 
 		REG_PIOA_CODR=0x0000C000;
 		REG_PIOD_CODR=0x0000064F;
 		REG_PIOA_SODR=(VL & 0x06)<<13;
 		(VL & 0x01) ? REG_PIOB_SODR = 0x4000000 : REG_PIOB_CODR = 0x4000000;
 		REG_PIOD_SODR=((VL & 0x78)>>3) | ((VL & 0x80)>>1);
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
 #endif
 		break;
 	case 16:
@@ -108,7 +114,7 @@ void UTFT::LCD_Writ_Bus(char VH,char VL, byte mode)
 		REG_PIOC_SODR=((VL & 0x01)<<5) | ((VL & 0x02)<<3) | ((VL & 0x04)<<1) | ((VL & 0x08)>>1) | ((VL & 0x10)>>3);
 		REG_PIOD_SODR=((VH & 0x78)>>3) | ((VH & 0x80)>>1) | ((VL & 0x20)<<5) | ((VL & 0x80)<<2);
 #endif
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
 		break;
 	case LATCHED_16:
 		asm("nop");		// Mode is unsupported
@@ -175,27 +181,27 @@ void UTFT::_fast_fill_16(int ch, int cl, long pix)
 	blocks = pix/16;
 	for (int i=0; i<blocks; i++)
 	{
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
+		pulse_wr();
 	}
 	if ((pix % 16) != 0)
 		for (int i=0; i<(pix % 16)+1; i++)
 		{
-			pulse_low(P_WR, B_WR);
+			pulse_wr();
 		}
 }
 
@@ -217,26 +223,26 @@ void UTFT::_fast_fill_8(int ch, long pix)
 	blocks = pix/16;
 	for (int i=0; i<blocks; i++)
 	{
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
-		pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
+		pulse_wr();pulse_wr();
 	}
 	if ((pix % 16) != 0)
 		for (int i=0; i<(pix % 16)+1; i++)
 		{
-			pulse_low(P_WR, B_WR);pulse_low(P_WR, B_WR);
+			pulse_wr();pulse_wr();
 		}
 }
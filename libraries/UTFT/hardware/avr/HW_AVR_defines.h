@@ -23,3 +23,4 @@
 #define regtype volatile uint8_t
 #define regsize uint8_t
 #define bitmapdatatype unsigned int*
+#define blitbuffersize 64	// bytes read from the source at a time by drawBitmapFlash()
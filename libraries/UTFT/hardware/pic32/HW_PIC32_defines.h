@@ -23,4 +23,5 @@
 #define regtype volatile uint32_t
 #define regsize uint16_t
 #define bitmapdatatype unsigned short*
+#define blitbuffersize 256	// bytes read from the source at a time by drawBitmapFlash()
 
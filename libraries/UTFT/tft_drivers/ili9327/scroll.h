@@ -0,0 +1,15 @@
+case ILI9327:
+	if (area)
+	{
+		LCD_Write_COM(0x33);
+		LCD_Write_DATA(0x00,_scroll_top>>8);
+		LCD_Write_DATA(0x00,_scroll_top);
+		LCD_Write_DATA(0x00,_scroll_lines>>8);
+		LCD_Write_DATA(0x00,_scroll_lines);
+		LCD_Write_DATA(0x00,((disp_y_size+1)-_scroll_top-_scroll_lines)>>8);
+		LCD_Write_DATA(0x00,(disp_y_size+1)-_scroll_top-_scroll_lines);
+	}
+	LCD_Write_COM(0x37);
+	LCD_Write_DATA(0x00,vsp>>8);
+	LCD_Write_DATA(0x00,vsp);
+	break;
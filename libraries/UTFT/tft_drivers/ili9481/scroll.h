@@ -0,0 +1,15 @@
+case ILI9481:
+	if (area)
+	{
+		LCD_Write_COM(0x33);
+		LCD_Write_DATA(_scroll_top>>8);
+		LCD_Write_DATA(_scroll_top);
+		LCD_Write_DATA(_scroll_lines>>8);
+		LCD_Write_DATA(_scroll_lines);
+		LCD_Write_DATA(((disp_y_size+1)-_scroll_top-_scroll_lines)>>8);
+		LCD_Write_DATA((disp_y_size+1)-_scroll_top-_scroll_lines);
+	}
+	LCD_Write_COM(0x37);
+	LCD_Write_DATA(vsp>>8);
+	LCD_Write_DATA(vsp);
+	break;
@@ -34,6 +34,7 @@ UTFT_Buttons::UTFT_Buttons(UTFT *ptrUTFT, UTouch *ptrUTouch)
 	_color_hilite			= VGA_RED;
 	_font_text				= NULL;
 	_font_symbol			= NULL;
+	_pressed				= -1;
 }
 
 int UTFT_Buttons::addButton(uint16_t x, uint16_t y, uint16_t width, uint16_t height, char *label, uint16_t flags)
@@ -51,7 +52,7 @@ int UTFT_Buttons::addButton(uint16_t x, uint16_t y, uint16_t width, uint16_t hei
 		buttons[btcnt].pos_y  = y;
 		buttons[btcnt].width  = width;
 		buttons[btcnt].height = height;
-		buttons[btcnt].flags  = flags;
+		buttons[btcnt].flags  = flags | BUTTON_DIRTY;
 		buttons[btcnt].label  = label;
 		buttons[btcnt].data   = NULL;
 		return btcnt;
@@ -73,7 +74,7 @@ int UTFT_Buttons::addButton(uint16_t x, uint16_t y, uint16_t width, uint16_t hei
 		buttons[btcnt].pos_y  = y;
 		buttons[btcnt].width  = width;
 		buttons[btcnt].height = height;
-		buttons[btcnt].flags  = flags | BUTTON_BITMAP;
+		buttons[btcnt].flags  = flags | BUTTON_BITMAP | BUTTON_DIRTY;
 		buttons[btcnt].label  = NULL;
 		buttons[btcnt].data   = data;
 		return btcnt;
@@ -90,6 +91,16 @@ void UTFT_Buttons::drawButtons()
 	}
 }
 
+// Only draws the buttons that changed since they were last drawn
+void UTFT_Buttons::redrawButtons()
+{
+	for (int i=0;i<MAX_BUTTONS;i++)
+	{
+		if ((buttons[i].flags & (BUTTON_UNUSED | BUTTON_DIRTY)) == BUTTON_DIRTY)
+			drawButton(i);
+	}
+}
+
 void UTFT_Buttons::drawButton(int buttonID)
 {
 	int		text_x, text_y;
@@ -97,6 +108,8 @@ void UTFT_Buttons::drawButton(int buttonID)
 	word	_current_color = _UTFT->getColor();
 	word	_current_back  = _UTFT->getBackColor();
 
+	buttons[buttonID].flags &= ~BUTTON_DIRTY;
+
 	if (buttons[buttonID].flags & BUTTON_BITMAP)
 	{
 		_UTFT->drawBitmap(buttons[buttonID].pos_x, buttons[buttonID].pos_y, buttons[buttonID].width, buttons[buttonID].height, buttons[buttonID].data);
@@ -146,9 +159,9 @@ void UTFT_Buttons::drawButton(int buttonID)
 
 void UTFT_Buttons::enableButton(int buttonID, boolean redraw)
 {
-	if (!(buttons[buttonID].flags & BUTTON_UNUSED))
+	if ((buttons[buttonID].flags & (BUTTON_UNUSED | BUTTON_DISABLED)) == BUTTON_DISABLED)
 	{
-		buttons[buttonID].flags = buttons[buttonID].flags & ~BUTTON_DISABLED;
+		buttons[buttonID].flags = (buttons[buttonID].flags & ~BUTTON_DISABLED) | BUTTON_DIRTY;
 		if (redraw)
 			drawButton(buttonID);
 	}
@@ -156,9 +169,9 @@ void UTFT_Buttons::enableButton(int buttonID, boolean redraw)
 
 void UTFT_Buttons::disableButton(int buttonID, boolean redraw)
 {
-	if (!(buttons[buttonID].flags & BUTTON_UNUSED))
+	if ((buttons[buttonID].flags & (BUTTON_UNUSED | BUTTON_DISABLED)) == 0)
 	{
-		buttons[buttonID].flags = buttons[buttonID].flags | BUTTON_DISABLED;
+		buttons[buttonID].flags = buttons[buttonID].flags | BUTTON_DISABLED | BUTTON_DIRTY;
 		if (redraw)
 			drawButton(buttonID);
 	}
@@ -169,6 +182,7 @@ void UTFT_Buttons::relabelButton(int buttonID, char *label, boolean redraw)
 	if (!(buttons[buttonID].flags & BUTTON_UNUSED))
 	{
 		buttons[buttonID].label = label;
+		buttons[buttonID].flags |= BUTTON_DIRTY;
 		if (redraw)
 			drawButton(buttonID);
 	}
@@ -203,52 +217,78 @@ int UTFT_Buttons::checkButtons()
     if (_UTouch->dataAvailable() == true)
     {
 		_UTouch->read();
-		int		result = -1;
-		int		touch_x = _UTouch->getX();
-		int		touch_y = _UTouch->getY();
-		word	_current_color = _UTFT->getColor();
-  
-		for (int i=0;i<MAX_BUTTONS;i++)
-		{
-			if (((buttons[i].flags & BUTTON_UNUSED) == 0) and ((buttons[i].flags & BUTTON_DISABLED) == 0) and (result == -1))
-			{
-				if ((touch_x >= (int)buttons[i].pos_x) and (touch_x <= (int)(buttons[i].pos_x + buttons[i].width)) and (touch_y >= (int)buttons[i].pos_y) and (touch_y <= (int)(buttons[i].pos_y + buttons[i].height)))
-					result = i;
-			}
-		}
+		int		result = _find_button(_UTouch->getX(), _UTouch->getY());
+
 		if (result != -1)
-		{
-			if (!(buttons[result].flags & BUTTON_NO_BORDER))
-			{
-				_UTFT->setColor(_color_hilite);
-				if (buttons[result].flags & BUTTON_BITMAP)
-					_UTFT->drawRect(buttons[result].pos_x, buttons[result].pos_y, buttons[result].pos_x+buttons[result].width, buttons[result].pos_y+buttons[result].height);
-				else
-					_UTFT->drawRoundRect(buttons[result].pos_x, buttons[result].pos_y, buttons[result].pos_x+buttons[result].width, buttons[result].pos_y+buttons[result].height);
-			}
-		}
+			_draw_border(result, _color_hilite);
 
 		while (_UTouch->dataAvailable() == true) {};
 
 		if (result != -1)
-		{
-			if (!(buttons[result].flags & BUTTON_NO_BORDER))
-			{
-				_UTFT->setColor(_color_border);
-				if (buttons[result].flags & BUTTON_BITMAP)
-					_UTFT->drawRect(buttons[result].pos_x, buttons[result].pos_y, buttons[result].pos_x+buttons[result].width, buttons[result].pos_y+buttons[result].height);
-				else
-					_UTFT->drawRoundRect(buttons[result].pos_x, buttons[result].pos_y, buttons[result].pos_x+buttons[result].width, buttons[result].pos_y+buttons[result].height);
-			}
-		}
+			_draw_border(result, _color_border);
 
-		_UTFT->setColor(_current_color);
 		return result;
 	}
 	else
 		return -1;
 }
 
+// Same result as checkButtons() without waiting: the touch is sampled a
+// little on every call and the button ID is returned on the call that
+// sees the button released. Returns -1 on every other call.
+int UTFT_Buttons::pollButtons()
+{
+	int		result;
+
+	if (_pressed != -1)
+	{
+		if (_UTouch->dataAvailable() == true)
+			return -1;
+		result = _pressed;
+		_pressed = -1;
+		if ((buttons[result].flags & BUTTON_UNUSED) != 0)
+			return -1;
+		_draw_border(result, _color_border);
+		return result;
+	}
+
+	if (_UTouch->sample() == true)
+	{
+		_pressed = _find_button(_UTouch->getX(), _UTouch->getY());
+		if (_pressed != -1)
+			_draw_border(_pressed, _color_hilite);
+	}
+	return -1;
+}
+
+int UTFT_Buttons::_find_button(int x, int y)
+{
+	for (int i=0;i<MAX_BUTTONS;i++)
+	{
+		if (((buttons[i].flags & BUTTON_UNUSED) == 0) and ((buttons[i].flags & BUTTON_DISABLED) == 0))
+		{
+			if ((x >= (int)buttons[i].pos_x) and (x <= (int)(buttons[i].pos_x + buttons[i].width)) and (y >= (int)buttons[i].pos_y) and (y <= (int)(buttons[i].pos_y + buttons[i].height)))
+				return i;
+		}
+	}
+	return -1;
+}
+
+void UTFT_Buttons::_draw_border(int buttonID, word color)
+{
+	word	_current_color = _UTFT->getColor();
+
+	if (!(buttons[buttonID].flags & BUTTON_NO_BORDER))
+	{
+		_UTFT->setColor(color);
+		if (buttons[buttonID].flags & BUTTON_BITMAP)
+			_UTFT->drawRect(buttons[buttonID].pos_x, buttons[buttonID].pos_y, buttons[buttonID].pos_x+buttons[buttonID].width, buttons[buttonID].pos_y+buttons[buttonID].height);
+		else
+			_UTFT->drawRoundRect(buttons[buttonID].pos_x, buttons[buttonID].pos_y, buttons[buttonID].pos_x+buttons[buttonID].width, buttons[buttonID].pos_y+buttons[buttonID].height);
+	}
+	_UTFT->setColor(_current_color);
+}
+
 void UTFT_Buttons::setTextFont(uint8_t* font)
 {
 	_font_text = font;
@@ -266,4 +306,6 @@ void UTFT_Buttons::setButtonColors(word atxt, word iatxt, word brd, word brdhi,
 	_color_background		= back;
 	_color_border			= brd;
 	_color_hilite			= brdhi;
+	for (int i=0;i<MAX_BUTTONS;i++)
+		buttons[i].flags |= BUTTON_DIRTY;
 }
@@ -43,6 +43,7 @@
 #define BUTTON_SYMBOL_REP_3X	0x0004
 #define BUTTON_BITMAP			0x0008	
 #define BUTTON_NO_BORDER		0x0010
+#define BUTTON_DIRTY			0x4000	// Set internally, cleared when the button is drawn
 #define BUTTON_UNUSED			0x8000
 
 typedef struct
@@ -62,6 +63,7 @@ class UTFT_Buttons
 		int		addButton(uint16_t x, uint16_t y, uint16_t width, uint16_t height, bitmapdatatype data, uint16_t flags=0);
 		void	drawButtons();
 		void	drawButton(int buttonID);
+		void	redrawButtons();
 		void	enableButton(int buttonID, boolean redraw=false);
 		void	disableButton(int buttonID, boolean redraw=false);
 		void	relabelButton(int buttonID, char *label, boolean redraw=false);
@@ -69,6 +71,7 @@ class UTFT_Buttons
 		void	deleteButton(int buttonID);
 		void	deleteAllButtons();
 		int		checkButtons();
+		int		pollButtons();
 		void	setTextFont(uint8_t* font);
 		void	setSymbolFont(uint8_t* font);
 		void	setButtonColors(word atxt, word iatxt, word brd, word brdhi, word back);
@@ -79,6 +82,10 @@ class UTFT_Buttons
 		button_type	buttons[MAX_BUTTONS];
 		word		_color_text, _color_text_inactive, _color_background, _color_border, _color_hilite;
 		uint8_t		*_font_text, *_font_symbol;
+		int			_pressed;
+
+		int		_find_button(int x, int y);
+		void	_draw_border(int buttonID, word color);
 };
 
 #endif
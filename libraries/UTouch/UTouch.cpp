@@ -40,6 +40,22 @@ UTouch::UTouch(byte tclk, byte tcs, byte din, byte dout, byte irq)
 	T_DIN	= din;
 	T_DOUT	= dout;
 	T_IRQ	= irq;
+	_pressure_threshold = 0;
+}
+
+// Turns the mapping of one axis, (raw - from) * size / (to - from), into
+// raw * k + o in 16.16 fixed point so getX()/getY() need no division
+static void calibrate_axis(long &k, long &o, long from, long to, long size, bool invert)
+{
+	long range = to - from;
+
+	k = range ? ((size<<16) + (range>>1)) / range : 0;
+	o = -from * k;
+	if (invert)
+	{
+		k = -k;
+		o = (size<<16) - o + 0xFFFF;	// rounds up like the division did
+	}
 }
 
 void UTouch::InitTouch(byte orientation)
@@ -53,6 +69,22 @@ void UTouch::InitTouch(byte orientation)
 	disp_x_size				= (CAL_S>>12) & 0x0FFF;
 	disp_y_size				= CAL_S & 0x0FFF;
 	prec					= 10;
+	_samples				= 0;
+
+	if (orient == _default_orientation)
+	{
+		calibrate_axis(_kx, _ox, touch_x_left, touch_x_right, disp_x_size, false);
+		calibrate_axis(_ky, _oy, touch_y_top, touch_y_bottom, disp_y_size, false);
+		_max_x = disp_x_size;
+		_max_y = disp_y_size;
+	}
+	else
+	{
+		calibrate_axis(_kx, _ox, touch_y_top, touch_y_bottom, disp_y_size, _default_orientation == PORTRAIT);
+		calibrate_axis(_ky, _oy, touch_x_left, touch_x_right, disp_x_size, _default_orientation != PORTRAIT);
+		_max_x = disp_y_size;
+		_max_y = disp_x_size;
+	}
 
 	P_CLK	= portOutputRegister(digitalPinToPort(T_CLK));
 	B_CLK	= digitalPinToBitMask(T_CLK);
@@ -79,70 +111,126 @@ void UTouch::InitTouch(byte orientation)
 
 void UTouch::read()
 {
-	unsigned long tx=0, temp_x=0;
-	unsigned long ty=0, temp_y=0;
-	unsigned long minx=99999, maxx=0;
-	unsigned long miny=99999, maxy=0;
-	int datacount=0;
+	_clear_samples();
 
 	cbi(P_CS, B_CS);                    
 
 	pinMode(T_IRQ,  INPUT);
 	for (int i=0; i<prec; i++)
+		if (!_take_sample() or _settled())
+			break;
+	pinMode(T_IRQ,  OUTPUT);
+
+	sbi(P_CS, B_CS);                    
+	_finish_read();
+}
+
+// Non-blocking read(): takes one of the prec samples per call and returns
+// true once TP_X/TP_Y hold a new result. Nothing is sampled until the
+// screen is touched, a lost sample ends the burst with TP_X/TP_Y at -1.
+bool UTouch::sample()
+{
+	if (_samples==0)
+	{
+		if (!dataAvailable())
+			return false;
+		_clear_samples();
+	}
+
+	cbi(P_CS, B_CS);                    
+	pinMode(T_IRQ,  INPUT);
+	bool ok = _take_sample();
+	pinMode(T_IRQ,  OUTPUT);
+	sbi(P_CS, B_CS);                    
+
+	if (ok and (++_samples<prec) and !_settled())
+		return false;
+	_samples=0;
+	_finish_read();
+	return true;
+}
+
+void UTouch::_clear_samples()
+{
+	_tx=0;
+	_ty=0;
+	_minx=99999;
+	_maxx=0;
+	_miny=99999;
+	_maxy=0;
+	_datacount=0;
+	_lost=false;
+}
+
+// CS has to be low and T_IRQ an input already. Returns false if the
+// sample was lost (pen lifted or out of range), the read is invalid then
+bool UTouch::_take_sample()
+{
+	unsigned long temp_x, temp_y;
+
+	if (!rbi(P_IRQ, B_IRQ))
 	{
+		touch_WriteData(0x90);        
+		pulse_high(P_CLK, B_CLK);
+		temp_x=touch_ReadData();
+
 		if (!rbi(P_IRQ, B_IRQ))
 		{
-			touch_WriteData(0x90);        
+			touch_WriteData(0xD0);      
 			pulse_high(P_CLK, B_CLK);
-			temp_x=touch_ReadData();
+			temp_y=touch_ReadData();
 
-			if (!rbi(P_IRQ, B_IRQ))
+			if ((temp_x>0) and (temp_x<4096) and (temp_y>0) and (temp_y<4096))
 			{
-				touch_WriteData(0xD0);      
-				pulse_high(P_CLK, B_CLK);
-				temp_y=touch_ReadData();
-
-				if ((temp_x>0) and (temp_x<4096) and (temp_y>0) and (temp_y<4096))
+				_tx+=temp_x;
+				_ty+=temp_y;
+				if (prec>5)
 				{
-					tx+=temp_x;
-					ty+=temp_y;
-					if (prec>5)
-					{
-						if (temp_x<minx)
-							minx=temp_x;
-						if (temp_x>maxx)
-							maxx=temp_x;
-						if (temp_y<miny)
-							miny=temp_y;
-						if (temp_y>maxy)
-							maxy=temp_y;
-					}
-					datacount++;
+					if (temp_x<_minx)
+						_minx=temp_x;
+					if (temp_x>_maxx)
+						_maxx=temp_x;
+					if (temp_y<_miny)
+						_miny=temp_y;
+					if (temp_y>_maxy)
+						_maxy=temp_y;
 				}
+				_datacount++;
+				return true;
 			}
 		}
 	}
-	pinMode(T_IRQ,  OUTPUT);
+	_lost=true;
+	return false;
+}
 
-	if (prec>5)
+// True once the samples so far agree, more would not change the average
+bool UTouch::_settled()
+{
+	return (prec>5) and (_datacount>=UTOUCH_SETTLE_SAMPLES)
+		and (_maxx-_minx<=UTOUCH_SETTLE_RANGE) and (_maxy-_miny<=UTOUCH_SETTLE_RANGE);
+}
+
+void UTouch::_finish_read()
+{
+	if ((prec>5) and (_datacount>2))
 	{
-		tx = tx-(minx+maxx);
-		ty = ty-(miny+maxy);
-		datacount -= 2;
+		_tx = _tx-(_minx+_maxx);
+		_ty = _ty-(_miny+_maxy);
+		_datacount -= 2;
 	}
 
-	sbi(P_CS, B_CS);                    
-	if ((datacount==(prec-2)) or (datacount==PREC_LOW))
+	if (!_lost and (_datacount>0))
 	{
 		if (orient == _default_orientation)
 		{
-			TP_X=ty/datacount;
-			TP_Y=tx/datacount;
+			TP_X=_ty/_datacount;
+			TP_Y=_tx/_datacount;
 		}
 		else
 		{
-			TP_X=tx/datacount;
-			TP_Y=ty/datacount;
+			TP_X=_tx/_datacount;
+			TP_Y=_ty/_datacount;
 		}
 	}
 	else
@@ -157,63 +245,63 @@ bool UTouch::dataAvailable()
 	bool avail;
 	pinMode(T_IRQ,  INPUT);
 	avail = !(rbi(P_IRQ, B_IRQ));
+	if (avail and _pressure_threshold)
+		avail = _pressure()>=_pressure_threshold;
 	pinMode(T_IRQ,  OUTPUT);
 	return avail;
 }
 
+// Touch pressure from the Z1/Z2 plate measurements, 0 when not touched.
+// Only controllers with a Z channel (XPT2046, ADS7846) support it
+word UTouch::_pressure()
+{
+	word z1, z2;
+
+	cbi(P_CS, B_CS);                    
+	touch_WriteData(0xB0);
+	pulse_high(P_CLK, B_CLK);
+	z1=touch_ReadData();
+	touch_WriteData(0xC0);
+	pulse_high(P_CLK, B_CLK);
+	z2=touch_ReadData();
+	sbi(P_CS, B_CS);                    
+
+	return z1+4095-z2;
+}
+
+// With a threshold > 0 dataAvailable() also checks the touch pressure, so
+// the IRQ line of a barely or no longer touched screen does not start a
+// sample burst. 0 (the default) only checks IRQ
+void UTouch::setPressureThreshold(word threshold)
+{
+	_pressure_threshold = threshold;
+}
+
 int16_t UTouch::getX()
 {
 	long c;
 
 	if ((TP_X==-1) or (TP_Y==-1))
 		return -1;
-	if (orient == _default_orientation)
-	{
-		c = long(long(TP_X - touch_x_left) * (disp_x_size)) / long(touch_x_right - touch_x_left);
-		if (c<0)
-			c = 0;
-		if (c>disp_x_size)
-			c = disp_x_size;
-	}
-	else
-	{
-		if (_default_orientation == PORTRAIT)
-			c = long(long(TP_X - touch_y_top) * (-disp_y_size)) / long(touch_y_bottom - touch_y_top) + long(disp_y_size);
-		else
-			c = long(long(TP_X - touch_y_top) * (disp_y_size)) / long(touch_y_bottom - touch_y_top);
-		if (c<0)
-			c = 0;
-		if (c>disp_y_size)
-			c = disp_y_size;
-	}
+	c = (TP_X * _kx + _ox) >> 16;
+	if (c<0)
+		c = 0;
+	if (c>_max_x)
+		c = _max_x;
 	return c;
 }
 
 int16_t UTouch::getY()
 {
-	int c;
+	long c;
 
 	if ((TP_X==-1) or (TP_Y==-1))
 		return -1;
-	if (orient == _default_orientation)
-	{
-		c = long(long(TP_Y - touch_y_top) * (disp_y_size)) / long(touch_y_bottom - touch_y_top);
-		if (c<0)
-			c = 0;
-		if (c>disp_y_size)
-			c = disp_y_size;
-	}
-	else
-	{
-		if (_default_orientation == PORTRAIT)
-			c = long(long(TP_Y - touch_x_left) * (disp_x_size)) / long(touch_x_right - touch_x_left);
-		else
-			c = long(long(TP_Y - touch_x_left) * (-disp_x_size)) / long(touch_x_right - touch_x_left) + long(disp_x_size);
-		if (c<0)
-			c = 0;
-		if (c>disp_x_size)
-			c = disp_x_size;
-	}
+	c = (TP_Y * _ky + _oy) >> 16;
+	if (c<0)
+		c = 0;
+	if (c>_max_y)
+		c = _max_y;
 	return c;
 }
 
@@ -237,6 +325,7 @@ void UTouch::setPrecision(byte precision)
 			prec=12;	// Iterations + 2
 			break;
 	}
+	_samples=0;
 }
 
 void UTouch::calibrateRead()
@@ -46,6 +46,11 @@
 #define PREC_HI				3
 #define PREC_EXTREME		4
 
+// read() and sample() stop before prec samples once UTOUCH_SETTLE_SAMPLES
+// samples lie within UTOUCH_SETTLE_RANGE raw units on both axes
+#define UTOUCH_SETTLE_SAMPLES	4
+#define UTOUCH_SETTLE_RANGE		16
+
 class UTouch
 {
 	public:
@@ -55,10 +60,12 @@ class UTouch
 
 		void	InitTouch(byte orientation = LANDSCAPE);
 		void	read();
+		bool	sample();
 		bool	dataAvailable();
 		int16_t	getX();
 		int16_t	getY();
 		void	setPrecision(byte precision);
+		void	setPressureThreshold(word threshold);
 
 		void	calibrateRead();
     
@@ -72,9 +79,20 @@ class UTouch
 		byte	display_model;
 		long	disp_x_size, disp_y_size, default_orientation;
 		long	touch_x_left, touch_x_right, touch_y_top, touch_y_bottom;
+		unsigned long	_tx, _ty, _minx, _maxx, _miny, _maxy;
+		int		_datacount;
+		bool	_lost;
+		byte	_samples;
+		word	_pressure_threshold;
+		long	_kx, _ox, _ky, _oy, _max_x, _max_y;
 
 		void	touch_WriteData(byte data);
 		word	touch_ReadData();
+		void	_clear_samples();
+		bool	_take_sample();
+		bool	_settled();
+		void	_finish_read();
+		word	_pressure();
 };
 
 #endif
\ No newline at end of file
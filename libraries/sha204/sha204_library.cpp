@@ -11,6 +11,7 @@
 
 atsha204Class::atsha204Class(uint8_t pin)
 {	
+	device_uart = NULL;
 #if defined(ARDUINO_ARCH_AVR)
 	device_pin = digitalPinToBitMask(pin);	// Find the bit value of the pin
 	uint8_t port = digitalPinToPort(pin);	// temoporarily used to get the next three registers
@@ -26,6 +27,18 @@ atsha204Class::atsha204Class(uint8_t pin)
 #endif
 }
 
+// atsha204Class Constructor for the UART mode of the single-wire interface
+// Feed this function a hardware serial port whose TX (through a schottky diode, cathode towards TX)
+// and RX pins are both connected to the ATSHA204's SDA pin, SDA pulled up.
+// Transfers are done by the UART with interrupts enabled, the port can not be used for anything else.
+// The MCU clock has to reach 230400 baud with little error (16MHz with U2X, 8MHz is too far off).
+
+atsha204Class::atsha204Class(HardwareSerial &uart)
+{
+	device_uart = &uart;
+	device_pin = 0;
+}
+
 /* 	Puts a the ATSHA204's unique, 4-byte serial number in the response array 
 	returns an SHA204 Return code */
 uint8_t atsha204Class::getSerialNumber(uint8_t * response)
@@ -87,6 +100,12 @@ uint16_t atsha204Class::calculateAndUpdateCrc(uint8_t length, uint8_t *data, uin
 
 void atsha204Class::swi_set_signal_pin(uint8_t is_high)
 {
+  if (device_uart)
+  {
+    swi_uart_set_signal_pin(is_high);
+    return;
+  }
+
   SHA204_SET_OUTPUT();
   if (is_high) {
     SHA204_POUT_HIGH();
@@ -101,8 +120,8 @@ uint8_t atsha204Class::swi_send_bytes(uint8_t count, uint8_t *buffer)
 {
   uint8_t i, bit_mask;
 
-  // Disable interrupts while sending.
-  noInterrupts();  //swi_disable_interrupts();
+  if (device_uart)
+    return swi_uart_send_bytes(count, buffer);
 
   // Set signal pin as output.
   SHA204_POUT_HIGH();
@@ -114,6 +133,10 @@ uint8_t atsha204Class::swi_send_bytes(uint8_t count, uint8_t *buffer)
   {
     for (bit_mask = 1; bit_mask > 0; bit_mask <<= 1) 
     {
+      // Only the pulses of a bit need exact timing, the device accepts any gap
+      // between bits up to its I/O timeout. So disable interrupts per bit and
+      // let pending interrupts run in between.
+      noInterrupts();  //swi_disable_interrupts();
       if (bit_mask & buffer[i]) 
       {
         SHA204_POUT_LOW();
@@ -133,9 +156,9 @@ uint8_t atsha204Class::swi_send_bytes(uint8_t count, uint8_t *buffer)
         SHA204_POUT_HIGH();
         delayMicroseconds(5*BIT_DELAY);  //BIT_DELAY_5;
       }
+      interrupts();  //swi_enable_interrupts();
     }
   }
-  interrupts();  //swi_enable_interrupts();
   return SWI_FUNCTION_RETCODE_SUCCESS;
 }
 
@@ -152,7 +175,11 @@ uint8_t atsha204Class::swi_receive_bytes(uint8_t count, uint8_t *buffer)
   uint8_t pulse_count;
   uint8_t timeout_count;
 
+  if (device_uart)
+    return swi_uart_receive_bytes(count, buffer);
+
   // Disable interrupts while receiving.
+  // The device does not wait for us, so this can not be split up like sending.
   noInterrupts(); //swi_disable_interrupts();
 
   // Configure signal pin as input
@@ -236,6 +263,11 @@ uint8_t atsha204Class::swi_receive_bytes(uint8_t count, uint8_t *buffer)
 
     if (status != SWI_FUNCTION_RETCODE_SUCCESS)
       break;
+
+    // The count byte tells how long the response is, stop there instead of
+    // running into the timeout when the buffer is larger than the response.
+    if (i == SHA204_BUFFER_POS_COUNT && buffer[i] >= SHA204_RSP_SIZE_MIN && buffer[i] < count)
+      count = buffer[i];
   }
   interrupts(); //swi_enable_interrupts();
 
@@ -248,6 +280,95 @@ uint8_t atsha204Class::swi_receive_bytes(uint8_t count, uint8_t *buffer)
   return status;
 }
 
+/* SWI UART functions */
+// Every single-wire bit is one 7N1 UART character, see the ATSHA204 datasheet
+
+// TX and RX share the line, everything sent comes back as echo
+void atsha204Class::swi_uart_drop_echo()
+{
+  // the last echo character is complete shortly after its stop bit went out
+  delayMicroseconds(SWI_UART_CHAR_US / 4);
+  while (device_uart->available())
+    (void) device_uart->read();
+}
+
+void atsha204Class::swi_uart_set_signal_pin(uint8_t is_high)
+{
+  // Only used for the wake pulse: low goes out as a slow 0x00 character, high restores the bit rate
+  if (is_high)
+  {
+    device_uart->begin(SWI_UART_BAUD, SERIAL_7N1);
+  }
+  else
+  {
+    device_uart->begin(SWI_UART_WAKE_BAUD, SERIAL_7N1);
+    device_uart->write((uint8_t) 0x00);
+    device_uart->flush();
+    swi_uart_drop_echo();
+  }
+}
+
+uint8_t atsha204Class::swi_uart_send_bytes(uint8_t count, uint8_t *buffer)
+{
+  uint8_t i, bit_mask;
+
+  for (i = 0; i < count; i++)
+  {
+    for (bit_mask = 1; bit_mask > 0; bit_mask <<= 1)
+      device_uart->write((bit_mask & buffer[i]) ? SWI_UART_BIT_ONE : SWI_UART_BIT_ZERO);
+  }
+  device_uart->flush();
+  swi_uart_drop_echo();
+  return SWI_FUNCTION_RETCODE_SUCCESS;
+}
+
+uint8_t atsha204Class::swi_uart_receive_bytes(uint8_t count, uint8_t *buffer)
+{
+  uint8_t status = SWI_FUNCTION_RETCODE_SUCCESS;
+  uint8_t i;
+  uint8_t bit_mask;
+  unsigned long start;
+
+  // The UART buffers the characters, so the whole response is received
+  // with interrupts enabled and without polling the pin.
+  for (i = 0; i < count; i++)
+  {
+    for (bit_mask = 1; bit_mask > 0; bit_mask <<= 1)
+    {
+      start = micros();
+      while (!device_uart->available())
+      {
+        if (micros() - start > SWI_RECEIVE_TIME_OUT)
+        {
+          status = SWI_FUNCTION_RETCODE_TIMEOUT;
+          break;
+        }
+      }
+      if (status != SWI_FUNCTION_RETCODE_SUCCESS)
+        break;
+
+      // A one bit reads as 0x7F, sometimes 0x7E, anything with a zero pulse is lower
+      if ((device_uart->read() ^ SWI_UART_BIT_ONE) < 2)
+        buffer[i] |= bit_mask;  // received "one" bit
+    }
+
+    if (status != SWI_FUNCTION_RETCODE_SUCCESS)
+      break;
+
+    // Stop at the end of the response, see swi_receive_bytes()
+    if (i == SHA204_BUFFER_POS_COUNT && buffer[i] >= SHA204_RSP_SIZE_MIN && buffer[i] < count)
+      count = buffer[i];
+  }
+
+  if (status == SWI_FUNCTION_RETCODE_TIMEOUT)
+  {
+    if (i > 0)
+    // Indicate that we timed out after having received at least one byte.
+    status = SWI_FUNCTION_RETCODE_RX_FAIL;
+  }
+  return status;
+}
+
 /* Physical functions */
 
 uint8_t atsha204Class::sha204p_wakeup()
@@ -12,6 +12,14 @@
 #define START_PULSE_TIME_OUT	(255)	//! This value is decremented while waiting for the falling edge of a start pulse.
 #define ZERO_PULSE_TIME_OUT		(26)	//! This value is decremented while waiting for the falling edge of a zero pulse.
 
+/* uart_config.h */
+
+#define SWI_UART_BAUD			(230400)	//! baud rate of the single-wire interface in UART mode, one UART character per single-wire bit
+#define SWI_UART_WAKE_BAUD		(115200)	//! a 0x00 character at this rate holds SDA low long enough for a Wakeup pulse
+#define SWI_UART_BIT_ONE		((uint8_t) 0x7F)	//! 7N1 character for a one bit (start pulse only)
+#define SWI_UART_BIT_ZERO		((uint8_t) 0x7D)	//! 7N1 character for a zero bit (start pulse and zero pulse)
+#define SWI_UART_CHAR_US		(10 * 1000000UL / SWI_UART_BAUD + 1)	//! time of one UART character in us
+
 /* swi_phys.h */
 
 #define SWI_FUNCTION_RETCODE_SUCCESS     ((uint8_t) 0x00) //!< Communication with device succeeded.
@@ -304,12 +312,17 @@ private:
 	#ifdef ARDUINO_ARCH_AVR
 	volatile uint8_t *device_port_DDR, *device_port_OUT, *device_port_IN;
 	#endif
+	HardwareSerial *device_uart;	// NULL when bit banging device_pin
 	void sha204c_calculate_crc(uint8_t length, uint8_t *data, uint8_t *crc);
 	uint8_t sha204c_check_crc(uint8_t *response);
 	void swi_set_signal_pin(uint8_t is_high);
 	uint8_t swi_receive_bytes(uint8_t count, uint8_t *buffer);
 	uint8_t swi_send_bytes(uint8_t count, uint8_t *buffer);
 	uint8_t swi_send_byte(uint8_t value);
+	void swi_uart_drop_echo();
+	void swi_uart_set_signal_pin(uint8_t is_high);
+	uint8_t swi_uart_receive_bytes(uint8_t count, uint8_t *buffer);
+	uint8_t swi_uart_send_bytes(uint8_t count, uint8_t *buffer);
 	uint8_t sha204p_receive_response(uint8_t size, uint8_t *response);
 	uint8_t sha204p_wakeup();
 	uint8_t sha204p_send_command(uint8_t count, uint8_t * command);
@@ -319,6 +332,7 @@ private:
 
 public:
 	atsha204Class(uint8_t pin);	// Constructor
+	atsha204Class(HardwareSerial &uart);	// Constructor for the UART mode, TX and RX both wired to SDA
 	uint8_t sha204c_wakeup(uint8_t *response);
 	uint8_t sha204c_send_and_receive(uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer, uint8_t execution_delay, uint8_t execution_timeout);
 	uint8_t sha204c_resync(uint8_t size, uint8_t *response);	